@@ -0,0 +1,54 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+/* ajsb_codegen schema.json name out.c [out.h]
+
+   Writes a C validator for schema.json defining
+   bool <name>_validate(ajson_t *instance), and optionally its header.
+   Used by the ajsb_add_validator CMake helper. */
+
+#include "a-json-schema-builder-library/ajsb_codegen.h"
+#include "a-json-library/ajson.h"
+#include "a-memory-library/aml_pool.h"
+
+#include <stdio.h>
+
+static char *read_file(aml_pool_t *p, const char *path) {
+  FILE *fp = fopen(path, "rb");
+  if (!fp) return NULL;
+  char *s = NULL;
+  if (!fseek(fp, 0, SEEK_END)) {
+    long n = ftell(fp);
+    if (n >= 0 && !fseek(fp, 0, SEEK_SET)) {
+      s = (char *)aml_pool_alloc(p, (size_t)n + 1);
+      if (fread(s, 1, (size_t)n, fp) != (size_t)n) s = NULL;
+      else s[n] = '\0';
+    }
+  }
+  fclose(fp);
+  return s;
+}
+
+int main(int argc, char **argv) {
+  if (argc != 4 && argc != 5) {
+    fprintf(stderr, "usage: %s schema.json name out.c [out.h]\n", argv[0]);
+    return 2;
+  }
+  aml_pool_t *p = aml_pool_init(65536);
+  char *text = read_file(p, argv[1]);
+  ajson_t *schema = text ? ajson_parse_string(p, text) : NULL;
+  int rc = 0;
+  if (!schema || ajson_is_error(schema)) {
+    fprintf(stderr, "%s: cannot read schema\n", argv[1]);
+    rc = 1;
+  } else if (!ajsb_codegen_file(argv[3], argc == 5 ? argv[4] : NULL, schema, argv[2])) {
+    fprintf(stderr, "%s: cannot generate %s (bad name, unresolved $ref or write error)\n",
+            argv[1], argv[3]);
+    rc = 1;
+  }
+  aml_pool_destroy(p);
+  return rc;
+}
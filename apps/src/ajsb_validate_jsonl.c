@@ -0,0 +1,99 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+/* ajsb_validate_jsonl [-j threads] [-c chunk_bytes] [-n max_listed] [-q] schema.json data.jsonl
+
+   Validates every line of data.jsonl against schema.json in parallel, lists
+   the first max_listed failing line numbers (default 20) and prints a
+   summary. Exit status: 0 all valid, 1 some line failed, 2 usage or I/O. */
+
+#include "a-json-schema-builder-library/ajsb_batch.h"
+#include "a-json-schema-builder-library/ajsb_validate.h"
+#include "a-json-library/ajson.h"
+#include "a-memory-library/aml_pool.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static char *read_file(aml_pool_t *p, const char *path) {
+  FILE *fp = fopen(path, "rb");
+  if (!fp) return NULL;
+  char *s = NULL;
+  if (!fseek(fp, 0, SEEK_END)) {
+    long n = ftell(fp);
+    if (n >= 0 && !fseek(fp, 0, SEEK_SET)) {
+      s = (char *)aml_pool_alloc(p, (size_t)n + 1);
+      if (fread(s, 1, (size_t)n, fp) != (size_t)n) s = NULL;
+      else s[n] = '\0';
+    }
+  }
+  fclose(fp);
+  return s;
+}
+
+static int usage(const char *argv0) {
+  fprintf(stderr, "usage: %s [-j threads] [-c chunk_bytes] [-n max_listed] [-q] schema.json data.jsonl\n",
+          argv0);
+  return 2;
+}
+
+int main(int argc, char **argv) {
+  ajsb_batch_options_t opts = {0};
+  long listed = 20;
+  bool quiet = false;
+  int c;
+  while ((c = getopt(argc, argv, "j:c:n:q")) != -1) {
+    switch (c) {
+      case 'j': opts.threads = atoi(optarg); break;
+      case 'c': opts.chunk_size = strtoul(optarg, NULL, 10); break;
+      case 'n': listed = atol(optarg); break;
+      case 'q': quiet = true; break;
+      default:  return usage(argv[0]);
+    }
+  }
+  if (argc - optind != 2) return usage(argv[0]);
+  const char *schema_path = argv[optind], *data_path = argv[optind + 1];
+  opts.statuses = !quiet && listed > 0;
+
+  aml_pool_t *p = aml_pool_init(65536);
+  char *text = read_file(p, schema_path);
+  ajson_t *schema = text ? ajson_parse_string(p, text) : NULL;
+  if (!schema || ajson_is_error(schema)) {
+    fprintf(stderr, "%s: cannot read schema\n", schema_path);
+    aml_pool_destroy(p);
+    return 2;
+  }
+  ajsb_program_t *prog = ajsb_compile(p, schema);
+  if (!prog) {
+    fprintf(stderr, "%s: cannot compile schema (unresolved or looping $ref?)\n", schema_path);
+    aml_pool_destroy(p);
+    return 2;
+  }
+
+  ajsb_batch_result_t r;
+  if (!ajsb_validate_batch_file(prog, data_path, &opts, &r)) {
+    fprintf(stderr, "%s: cannot read\n", data_path);
+    aml_pool_destroy(p);
+    return 2;
+  }
+
+  for (size_t i = 0; r.status && i < r.lines && listed > 0; i++) {
+    if (r.status[i] == AJSB_BATCH_INVALID)          printf("%zu: invalid\n", i + 1);
+    else if (r.status[i] == AJSB_BATCH_PARSE_ERROR) printf("%zu: parse error\n", i + 1);
+    else continue;
+    listed--;
+  }
+  if (!quiet)
+    printf("lines %zu  valid %zu  invalid %zu  parse errors %zu  blank %zu\n",
+           r.lines, r.valid, r.invalid, r.parse_errors, r.blank);
+
+  int rc = r.invalid || r.parse_errors ? 1 : 0;
+  ajsb_batch_result_destroy(&r);
+  aml_pool_destroy(p);
+  return rc;
+}
@@ -0,0 +1,385 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+/* ajsb_bench [-t min_ms] [-n max_n] [-f filter] [-o out.json]
+
+   Microbenchmarks for building, stringifying, compiling and validating
+   schemas across widths (properties per object) and depths (nesting and
+   $ref chains). Each case runs for at least min_ms (default 200) and reports
+   ns/op, nodes/sec, pool bytes allocated per op and the peak pool size. A
+   human-readable table goes to stderr and the results to out.json (stdout
+   by default) as JSON, so runs from different versions can be diffed.
+
+   Only cases whose name contains filter run, and sizes above max_n are
+   skipped. Built against the "memory" variant, the allocation tracking in
+   a-memory-library also checks that every case releases what it takes. */
+
+#include "a-json-schema-builder-library/ajsb.h"
+#include "a-json-schema-builder-library/ajsb_cbor.h"
+#include "a-json-schema-builder-library/ajsb_index.h"
+#include "a-json-schema-builder-library/ajsb_stream.h"
+#include "a-json-schema-builder-library/ajsb_validate.h"
+#include "a-json-library/ajson.h"
+#include "a-memory-library/aml_buffer.h"
+#include "a-memory-library/aml_pool.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifndef AJSB_BENCH_VERSION
+#define AJSB_BENCH_VERSION "unknown"
+#endif
+#ifndef AJSB_BENCH_VARIANT
+#define AJSB_BENCH_VARIANT "unknown"
+#endif
+
+/* Everything one case needs, built once outside the timed loop. */
+typedef struct {
+  size_t          n;
+  size_t          nodes;      /* JSON values one op builds or visits */
+  const char    **names;      /* p0 .. p(n-1), d0 .. d(n-1) for chains */
+  ajson_t        *schema;
+  ajsb_program_t *prog;
+  ajson_t        *doc;
+  const char     *text;
+  size_t          len;
+  ajsb_stream_t  *stream;
+  const void     *cbor;       /* s->schema as CBOR */
+  size_t          cbor_len;
+} state_t;
+
+typedef struct {
+  const char *name;
+  const char *axis;                                   /* "width" or "depth" */
+  size_t      max_n;                                  /* 0: every size */
+  void      (*prepare)(aml_pool_t *p, state_t *s);
+  void      (*op)(aml_pool_t *p, state_t *s);
+} bench_case_t;
+
+typedef struct {
+  size_t   iterations;
+  double   ns_per_op;
+  double   nodes_per_sec;
+  size_t   bytes_per_op;       /* pool bytes one op allocates */
+  size_t   peak_pool;          /* largest the op pool got, overhead included */
+} result_t;
+
+static size_t count_nodes(ajson_t *j) {
+  size_t n = 1;
+  if (ajson_is_object(j))
+    for (ajsono_t *m = ajsono_first(j); m; m = ajsono_next(m)) n += count_nodes(m->value);
+  else if (ajson_is_array(j))
+    for (ajsona_t *a = ajsona_first(j); a; a = ajsona_next(a)) n += count_nodes(a->value);
+  return n;
+}
+
+static const char **make_names(aml_pool_t *p, size_t n, char prefix) {
+  const char **v = (const char **)aml_pool_alloc(p, n * sizeof(*v));
+  for (size_t i = 0; i < n; i++) v[i] = aml_pool_strdupf(p, "%c%zu", prefix, i);
+  return v;
+}
+
+/* ── Schemas and documents ──────────────────────────────────────────────── */
+
+/* {"type":"object","properties":{"p0":{"type":"string"}, ...}}. ajsb_prop
+   looks for an existing name first, so without the index this is O(n^2). */
+static ajson_t *wide_schema(aml_pool_t *p, state_t *s, bool indexed) {
+  ajson_t *o = ajsb_object(p);
+  if (!indexed) {
+    for (size_t i = 0; i < s->n; i++) ajsb_prop(p, o, s->names[i], ajsb_string(p));
+    return o;
+  }
+  ajsb_index_t *ix = ajsb_index_init(p);
+  for (size_t i = 0; i < s->n; i++) ajsb_index_prop(ix, o, s->names[i], ajsb_string(p));
+  return o;
+}
+
+/* n objects, each the "child" of the one above */
+static ajson_t *nested_schema(aml_pool_t *p, state_t *s) {
+  ajson_t *root = ajsb_object(p), *o = root;
+  for (size_t i = 1; i < s->n; i++) {
+    ajson_t *child = ajsb_object(p);
+    ajsb_prop(p, o, "child", child);
+    o = child;
+  }
+  return root;
+}
+
+/* {"$ref":"#/$defs/d0"} with d0 → d1 → ... → d(n-1) = {"type":"string"} */
+static ajson_t *ref_chain_schema(aml_pool_t *p, state_t *s) {
+  ajson_t *root = ajsb_ref(p, "#/$defs/d0");
+  for (size_t i = 0; i + 1 < s->n; i++)
+    ajsb_defs_add(p, root, s->names[i], ajsb_ref(p, aml_pool_strdupf(p, "#/$defs/%s", s->names[i + 1])));
+  ajsb_defs_add(p, root, s->names[s->n - 1], ajsb_string(p));
+  return root;
+}
+
+static const char *wide_doc(aml_pool_t *p, size_t n) {
+  aml_buffer_t *bh = aml_buffer_init(n * 12 + 16);
+  aml_buffer_appends(bh, "{");
+  for (size_t i = 0; i < n; i++) aml_buffer_appendf(bh, "%s\"p%zu\":\"v%zu\"", i ? "," : "", i, i);
+  aml_buffer_appends(bh, "}");
+  char *r = aml_pool_strdup(p, aml_buffer_data(bh));
+  aml_buffer_destroy(bh);
+  return r;
+}
+
+static const char *nested_doc(aml_pool_t *p, size_t n) {
+  aml_buffer_t *bh = aml_buffer_init(n * 10 + 16);
+  for (size_t i = 1; i < n; i++) aml_buffer_appends(bh, "{\"child\":");
+  aml_buffer_appends(bh, "{}");
+  for (size_t i = 1; i < n; i++) aml_buffer_appends(bh, "}");
+  char *r = aml_pool_strdup(p, aml_buffer_data(bh));
+  aml_buffer_destroy(bh);
+  return r;
+}
+
+/* ── Cases ──────────────────────────────────────────────────────────────── */
+
+static void prep_build_wide(aml_pool_t *p, state_t *s) {
+  s->names = make_names(p, s->n, 'p');
+  s->nodes = count_nodes(wide_schema(p, s, true));
+}
+static void op_build_wide(aml_pool_t *p, state_t *s) { wide_schema(p, s, false); }
+static void op_build_indexed(aml_pool_t *p, state_t *s) { wide_schema(p, s, true); }
+
+static void prep_build_nested(aml_pool_t *p, state_t *s) { s->nodes = count_nodes(nested_schema(p, s)); }
+static void op_build_nested(aml_pool_t *p, state_t *s) { nested_schema(p, s); }
+
+static void prep_build_ref_chain(aml_pool_t *p, state_t *s) {
+  s->names = make_names(p, s->n, 'd');
+  s->nodes = count_nodes(ref_chain_schema(p, s));
+}
+static void op_build_ref_chain(aml_pool_t *p, state_t *s) { ref_chain_schema(p, s); }
+
+static void prep_stringify_wide(aml_pool_t *p, state_t *s) {
+  prep_build_wide(p, s);
+  s->schema = wide_schema(p, s, true);
+}
+static void op_stringify(aml_pool_t *p, state_t *s) { ajsb_stringify(p, s->schema); }
+
+static void prep_stringify_nested(aml_pool_t *p, state_t *s) {
+  s->schema = nested_schema(p, s);
+  s->nodes = count_nodes(s->schema);
+}
+
+/* the wide schema as JSON text and as CBOR, to compare reading them back */
+static void prep_serialized_wide(aml_pool_t *p, state_t *s) {
+  prep_stringify_wide(p, s);
+  s->text = ajsb_stringify(p, s->schema);
+  s->len = strlen(s->text);
+  aml_buffer_t *bh = aml_buffer_init(s->len);
+  if (!ajsb_encode_cbor(bh, s->schema)) abort();
+  s->cbor_len = aml_buffer_length(bh);
+  s->cbor = aml_pool_dup(p, aml_buffer_data(bh), s->cbor_len);
+  aml_buffer_destroy(bh);
+}
+
+static void op_parse_schema(aml_pool_t *p, state_t *s) {
+  if (!ajson_parse_string(p, aml_pool_dup(p, s->text, s->len + 1))) abort();
+}
+
+static void op_encode_cbor(aml_pool_t *p, state_t *s) {
+  (void)p;
+  aml_buffer_t *bh = aml_buffer_init(s->cbor_len);
+  if (!ajsb_encode_cbor(bh, s->schema)) abort();
+  aml_buffer_destroy(bh);
+}
+
+static void op_decode_cbor(aml_pool_t *p, state_t *s) {
+  if (!ajsb_decode_cbor(p, s->cbor, s->cbor_len)) abort();
+}
+
+static void op_compile(aml_pool_t *p, state_t *s) { ajsb_compile(p, s->schema); }
+
+static void prep_compile_ref_chain(aml_pool_t *p, state_t *s) {
+  prep_build_ref_chain(p, s);
+  s->schema = ref_chain_schema(p, s);
+}
+
+/* program, parsed document and stream for validating s->text */
+static void prep_validator(aml_pool_t *p, state_t *s, const char *text) {
+  s->prog = ajsb_compile(p, s->schema);
+  s->text = text;
+  s->len = strlen(text);
+  s->doc = ajson_parse_string(p, aml_pool_strdup(p, text));
+  s->nodes = count_nodes(s->doc);
+  s->stream = s->prog ? ajsb_stream_init(p, s->prog) : NULL;
+}
+
+static void prep_validate_wide(aml_pool_t *p, state_t *s) {
+  prep_stringify_wide(p, s);
+  prep_validator(p, s, wide_doc(p, s->n));
+}
+
+static void prep_validate_recursive(aml_pool_t *p, state_t *s) {
+  s->schema = ajsb_object(p);
+  ajsb_prop(p, s->schema, "child", ajsb_ref(p, "#"));
+  prep_validator(p, s, nested_doc(p, s->n));
+}
+
+static void prep_validate_ref_chain(aml_pool_t *p, state_t *s) {
+  prep_compile_ref_chain(p, s);
+  prep_validator(p, s, "\"x\"");
+  s->nodes = s->n;              /* every link is followed */
+}
+
+static void op_validate(aml_pool_t *p, state_t *s) {
+  (void)p;
+  if (!ajsb_validate(s->prog, s->doc)) abort();
+}
+
+static void op_stream(aml_pool_t *p, state_t *s) {
+  (void)p;
+  ajsb_stream_reset(s->stream);
+  ajsb_stream_status_t st = ajsb_stream_push(s->stream, s->text, s->len);
+  if (st == AJSB_STREAM_CONTINUE) st = ajsb_stream_finish(s->stream);
+  if (st != AJSB_STREAM_COMPLETE) abort();
+}
+
+static void op_parse_validate(aml_pool_t *p, state_t *s) {
+  char *copy = aml_pool_dup(p, s->text, s->len + 1);
+  if (!ajsb_validate(s->prog, ajson_parse_string(p, copy))) abort();
+}
+
+static const bench_case_t cases[] = {
+  {"build_object",        "width", 10000, prep_build_wide,         op_build_wide},
+  {"build_indexed",       "width", 0,     prep_build_wide,         op_build_indexed},
+  {"build_nested",        "depth", 0,     prep_build_nested,       op_build_nested},
+  {"build_ref_chain",     "depth", 0,     prep_build_ref_chain,    op_build_ref_chain},
+  {"stringify_object",    "width", 0,     prep_stringify_wide,     op_stringify},
+  {"stringify_nested",    "depth", 0,     prep_stringify_nested,   op_stringify},
+  {"parse_schema",        "width", 0,     prep_serialized_wide,    op_parse_schema},
+  {"encode_cbor",         "width", 0,     prep_serialized_wide,    op_encode_cbor},
+  {"decode_cbor",         "width", 0,     prep_serialized_wide,    op_decode_cbor},
+  {"compile_object",      "width", 0,     prep_stringify_wide,     op_compile},
+  {"compile_ref_chain",   "depth", 0,     prep_compile_ref_chain,  op_compile},
+  {"validate_object",     "width", 0,     prep_validate_wide,      op_validate},
+  {"parse_validate",      "width", 0,     prep_validate_wide,      op_parse_validate},
+  {"stream_object",       "width", 0,     prep_validate_wide,      op_stream},
+  {"validate_recursive",  "depth", 0,     prep_validate_recursive, op_validate},
+  {"stream_recursive",    "depth", AJSB_STREAM_MAX_DEPTH, prep_validate_recursive, op_stream},
+  {"validate_ref_chain",  "depth", 0,     prep_validate_ref_chain, op_validate},
+};
+
+static const size_t widths[] = {10, 100, 1000, 10000, 100000};
+static const size_t depths[] = {10, 100, 1000};
+
+/* ── Harness ────────────────────────────────────────────────────────────── */
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static bool measure(const bench_case_t *bc, size_t n, uint64_t min_ns, result_t *r) {
+  memset(r, 0, sizeof(*r));
+  aml_pool_t *keep = aml_pool_init(1 << 16);
+  aml_pool_t *p = aml_pool_init(1 << 16);
+  state_t s;
+  memset(&s, 0, sizeof(s));
+  s.n = n;
+  bc->prepare(keep, &s);
+  bool needs_prog = bc->op == op_validate || bc->op == op_stream || bc->op == op_parse_validate;
+  if (needs_prog && (!s.prog || !s.stream)) {
+    aml_pool_destroy(p);
+    aml_pool_destroy(keep);
+    return false;
+  }
+
+  /* one untimed op to warm caches and size the pool */
+  bc->op(p, &s);
+  r->bytes_per_op = aml_pool_size(p);
+  r->peak_pool = aml_pool_used(p);
+
+  uint64_t start = now_ns(), elapsed;
+  do {
+    aml_pool_clear(p);
+    bc->op(p, &s);
+    size_t used = aml_pool_used(p);
+    if (used > r->peak_pool) r->peak_pool = used;
+    r->iterations++;
+    elapsed = now_ns() - start;
+  } while (elapsed < min_ns);
+
+  r->ns_per_op = (double)elapsed / (double)r->iterations;
+  r->nodes_per_sec = (double)s.nodes * 1e9 / r->ns_per_op;
+  aml_pool_destroy(p);
+  aml_pool_destroy(keep);
+  return true;
+}
+
+static int usage(const char *argv0) {
+  fprintf(stderr, "usage: %s [-t min_ms] [-n max_n] [-f filter] [-o out.json]\n", argv0);
+  return 2;
+}
+
+int main(int argc, char **argv) {
+  long min_ms = 200;
+  size_t max_n = SIZE_MAX;
+  const char *filter = NULL, *out_path = NULL;
+  int c;
+  while ((c = getopt(argc, argv, "t:n:f:o:")) != -1) {
+    switch (c) {
+      case 't': min_ms = atol(optarg); break;
+      case 'n': max_n = strtoul(optarg, NULL, 10); break;
+      case 'f': filter = optarg; break;
+      case 'o': out_path = optarg; break;
+      default:  return usage(argv[0]);
+    }
+  }
+  if (optind != argc || min_ms < 0) return usage(argv[0]);
+  FILE *out = out_path ? fopen(out_path, "w") : stdout;
+  if (!out) {
+    fprintf(stderr, "%s: cannot write\n", out_path);
+    return 2;
+  }
+
+#ifdef _AML_DEBUG_
+  const bool memory_profile = true;
+#else
+  const bool memory_profile = false;
+#endif
+  fprintf(out, "{\"library\":\"a_json_schema_builder_library\",\"version\":\"%s\",\"variant\":\"%s\","
+               "\"memory_profile\":%s,\"min_ms\":%ld,\"results\":[",
+          AJSB_BENCH_VERSION, AJSB_BENCH_VARIANT, memory_profile ? "true" : "false", min_ms);
+  fprintf(stderr, "%-20s %7s %12s %10s %14s %12s %12s\n",
+          "case", "n", "iterations", "ns/op", "nodes/sec", "bytes/op", "peak pool");
+
+  int rc = 0;
+  bool first = true;
+  for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    const bench_case_t *bc = cases + i;
+    if (filter && !strstr(bc->name, filter)) continue;
+    bool wide = !strcmp(bc->axis, "width");
+    const size_t *sizes = wide ? widths : depths;
+    size_t num_sizes = wide ? sizeof(widths) / sizeof(widths[0]) : sizeof(depths) / sizeof(depths[0]);
+    for (size_t j = 0; j < num_sizes && sizes[j] <= max_n; j++) {
+      if (bc->max_n && sizes[j] > bc->max_n) break;
+      result_t r;
+      if (!measure(bc, sizes[j], (uint64_t)min_ms * 1000000u, &r)) {
+        fprintf(stderr, "%-20s %7zu  failed to prepare\n", bc->name, sizes[j]);
+        rc = 1;
+        continue;
+      }
+      fprintf(stderr, "%-20s %7zu %12zu %10.0f %14.0f %12zu %12zu\n", bc->name, sizes[j],
+              r.iterations, r.ns_per_op, r.nodes_per_sec, r.bytes_per_op, r.peak_pool);
+      fprintf(out, "%s\n{\"name\":\"%s\",\"%s\":%zu,\"iterations\":%zu,\"ns_per_op\":%.1f,"
+                   "\"nodes_per_sec\":%.0f,\"bytes_per_op\":%zu,\"peak_pool_bytes\":%zu}",
+              first ? "" : ",", bc->name, bc->axis, sizes[j], r.iterations, r.ns_per_op,
+              r.nodes_per_sec, r.bytes_per_op, r.peak_pool);
+      first = false;
+    }
+  }
+  fprintf(out, "\n]}\n");
+  if (out != stdout) fclose(out);
+  return rc;
+}
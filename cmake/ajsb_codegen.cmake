@@ -0,0 +1,46 @@
+# SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+# SPDX-FileCopyrightText: 2024–2025 Knode.ai
+# SPDX-License-Identifier: Apache-2.0
+#
+# Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+# ajsb_add_validator(<target> NAME <name> SCHEMA <schema.json> [OUTPUT_DIR <dir>])
+#
+# Generates <name>_validate.c / <name>_validate.h from a schema at build time
+# (regenerated when the schema changes) and adds them to <target>. The header
+# declares bool <name>_validate(ajson_t *instance). <target> must link
+# a_json_library, and must see this library's headers if the schema uses
+# format or pattern (the generated code includes the header-only
+# ajsb_format.h).
+function(ajsb_add_validator target)
+  cmake_parse_arguments(ARG "" "NAME;SCHEMA;OUTPUT_DIR" "" ${ARGN})
+  if(NOT ARG_NAME OR NOT ARG_SCHEMA)
+    message(FATAL_ERROR "ajsb_add_validator(${target}): NAME and SCHEMA are required")
+  endif()
+  if(NOT ARG_OUTPUT_DIR)
+    set(ARG_OUTPUT_DIR "${CMAKE_CURRENT_BINARY_DIR}/ajsb_generated")
+  endif()
+  get_filename_component(_schema "${ARG_SCHEMA}" ABSOLUTE)
+
+  if(TARGET ajsb_codegen)
+    set(_tool "$<TARGET_FILE:ajsb_codegen>")
+    set(_tool_dep ajsb_codegen)
+  else()
+    find_program(AJSB_CODEGEN_EXECUTABLE ajsb_codegen REQUIRED)
+    set(_tool "${AJSB_CODEGEN_EXECUTABLE}")
+    set(_tool_dep "${AJSB_CODEGEN_EXECUTABLE}")
+  endif()
+
+  set(_c "${ARG_OUTPUT_DIR}/${ARG_NAME}_validate.c")
+  set(_h "${ARG_OUTPUT_DIR}/${ARG_NAME}_validate.h")
+  add_custom_command(
+    OUTPUT "${_c}" "${_h}"
+    COMMAND ${CMAKE_COMMAND} -E make_directory "${ARG_OUTPUT_DIR}"
+    COMMAND ${_tool} "${_schema}" "${ARG_NAME}" "${_c}" "${_h}"
+    DEPENDS "${_schema}" ${_tool_dep}
+    COMMENT "Generating validator ${ARG_NAME} from ${ARG_SCHEMA}"
+    VERBATIM
+  )
+  target_sources(${target} PRIVATE "${_c}" "${_h}")
+  target_include_directories(${target} PRIVATE "${ARG_OUTPUT_DIR}")
+endfunction()
@@ -45,7 +45,7 @@ void ajsb_default_str(aml_pool_t *p, ajson_t *schema, const char *def_val);
 /* ── String helpers ─────────────────────────────────────────────────────── */
 void ajsb_string_format (aml_pool_t *p, ajson_t *str_schema, const char *format); /* "email","date","time",… */
 void ajsb_string_pattern(aml_pool_t *p, ajson_t *str_schema, const char *regex);
-void ajsb_string_enum   (aml_pool_t *p, ajson_t *str_schema, size_t n, const char *const *values);
+void ajsb_string_enum   (aml_pool_t *p, ajson_t *str_schema, size_t n, const char *const *values); /* deduplicated */
 
 /* ── Number / Integer helpers ───────────────────────────────────────────── */
 void ajsb_number_min(aml_pool_t *p, ajson_t *num_schema, double min, bool exclusive);
@@ -78,8 +78,29 @@ void ajsb_dynamic_anchor  (aml_pool_t *p, ajson_t *schema, const char *name);  /
 ajson_t *ajsb_ref         (aml_pool_t *p, const char *ref);             /* { "$ref": "<ref>" } */
 ajson_t *ajsb_dynamic_ref (aml_pool_t *p, const char *ref);             /* { "$dynamicRef": "<ref>" } */
 
+/* ── Shared leaves (opt-in) ─────────────────────────────────────────────── */
+/* Process-wide, read-only leaf schemas: no allocation, same text as the
+   pool-allocated versions. They may be placed anywhere in any tree (and in
+   trees on other threads) but never modified. Passing a shared node to a
+   helper that changes it is a bug: debug builds assert, release builds leave
+   the node unchanged. Call ajsb_cow first to get a private copy that can be
+   modified. */
+ajson_t *ajsb_shared_string (void);                           /* { "type": "string" } */
+ajson_t *ajsb_shared_number (void);                           /* { "type": "number" } */
+ajson_t *ajsb_shared_integer(void);                           /* { "type": "integer" } */
+ajson_t *ajsb_shared_boolean(void);                           /* { "type": "boolean" } */
+ajson_t *ajsb_shared_null   (void);                           /* { "type": "null" } */
+ajson_t *ajsb_shared_true   (void);                           /* true  */
+ajson_t *ajsb_shared_false  (void);                           /* false */
+
+bool ajsb_is_shared(const ajson_t *j);                        /* cheap; no locking */
+
+/* schema itself if it is not shared, else a copy allocated from p. */
+ajson_t *ajsb_cow(aml_pool_t *p, ajson_t *schema);
 
 /* ── Utility ────────────────────────────────────────────────────────────── */
+/* Serializes the whole tree; ajsb_cache_stringify (ajsb_cache.h) re-emits only
+   what changed since its last call. */
 static inline const char *ajsb_stringify(aml_pool_t *p, ajson_t *schema) {
   return ajson_stringify(p, schema);
 }
@@ -0,0 +1,70 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#ifndef A_JSON_SCHEMA_BUILDER_BATCH_H
+#define A_JSON_SCHEMA_BUILDER_BATCH_H
+
+#include "a-json-schema-builder-library/ajsb_validate.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Parallel validation of JSON Lines.
+
+   The input is cut into line-aligned chunks of roughly chunk_size bytes
+   (a line belongs to the chunk it starts in, so no pre-scan is needed). Worker
+   threads take the next unclaimed chunk until none are left; each parses its
+   records into a private pool that is cleared after every record, and all of
+   them run the same read-only program. Nothing is shared between workers
+   while they run, so throughput grows with the number of cores.
+
+     ajsb_batch_result_t r;
+     ajsb_validate_batch_file(prog, "dump.jsonl", NULL, &r);
+     printf("%zu of %zu invalid\n", r.invalid + r.parse_errors, r.lines);
+     ajsb_batch_result_destroy(&r); */
+
+typedef enum {
+  AJSB_BATCH_VALID = 0,
+  AJSB_BATCH_INVALID,         /* JSON, but does not satisfy the schema */
+  AJSB_BATCH_PARSE_ERROR,     /* not JSON */
+  AJSB_BATCH_BLANK            /* empty or whitespace-only line */
+} ajsb_batch_status_t;
+
+typedef struct {
+  int    threads;             /* workers; 0 = online CPUs */
+  size_t chunk_size;          /* bytes per unit of work; 0 = 1 MiB */
+  bool   statuses;            /* fill ajsb_batch_result_t.status */
+} ajsb_batch_options_t;
+
+typedef struct {
+  size_t   lines;             /* a last line without '\n' counts; a trailing '\n' does not start one */
+  size_t   valid;
+  size_t   invalid;
+  size_t   parse_errors;
+  size_t   blank;
+  uint8_t *status;            /* ajsb_batch_status_t per line (line n at n-1) if asked for */
+} ajsb_batch_result_t;
+
+/* Validate every line of data[0..len). opts may be NULL. Returns false (with
+   res zeroed) if prog is NULL or memory runs out. */
+bool ajsb_validate_batch(const ajsb_program_t *prog, const char *data, size_t len,
+                         const ajsb_batch_options_t *opts, ajsb_batch_result_t *res);
+
+/* ajsb_validate_batch over a file mapped read-only. */
+bool ajsb_validate_batch_file(const ajsb_program_t *prog, const char *path,
+                              const ajsb_batch_options_t *opts, ajsb_batch_result_t *res);
+
+/* Free res->status. */
+void ajsb_batch_result_destroy(ajsb_batch_result_t *res);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* A_JSON_SCHEMA_BUILDER_BATCH_H */
@@ -0,0 +1,73 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#ifndef A_JSON_SCHEMA_BUILDER_CACHE_H
+#define A_JSON_SCHEMA_BUILDER_CACHE_H
+
+#include "a-json-library/ajson.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Incremental stringify for long-lived schemas that change a little at a
+   time.
+
+     ajsb_cache_t *c = ajsb_cache_init();
+     const char *text = ajsb_cache_stringify(c, schema, &len);
+     ajsb_prop(p, schema, "extra", ajsb_string(p));
+     text = ajsb_cache_stringify(c, schema, &len);   // re-emits root and "properties"
+
+   The cache keeps the serialized bytes and a fingerprint of every object
+   and array it has emitted. The ajsb_* functions that modify a tree in place
+   (the builders, ajsb_index_*, ajsb_intern, ajsb_hoist_defs, ajsb_derive_at)
+   report each container they change with ajsb_touch. A touch on a node no
+   cache holds is ignored; otherwise it is logged without taking a lock. The
+   next stringify on a cache replays the log, dropping the touched nodes it
+   holds and their ancestors, then copies unchanged subtrees verbatim and
+   re-emits only the touched paths. The output is the same text
+   ajsb_stringify gives. Trees no cache has emitted (per-request schemas
+   built next to a cached one) cost nothing here. A cache that misses more
+   than 16384 logged touches between calls emits the whole tree once.
+
+   Nodes are remembered by address: after changing a tree by other means
+   (ajsono_set, editing a member's value directly), call ajsb_touch on the
+   container that changed; after freeing or clearing the pool a cached tree
+   lives in, call ajsb_cache_reset. */
+
+typedef struct ajsb_cache_s ajsb_cache_t;
+
+ajsb_cache_t *ajsb_cache_init(void);
+void ajsb_cache_destroy(ajsb_cache_t *c);
+
+/* Forget everything; the next stringify emits the whole tree. */
+void ajsb_cache_reset(ajsb_cache_t *c);
+
+/* Compact JSON for schema (NUL terminated, length in *len if len is not
+   NULL). Owned by c and valid until the next call on c. */
+const char *ajsb_cache_stringify(ajsb_cache_t *c, ajson_t *schema, size_t *len);
+
+/* Content fingerprint of node: equal serialized text gives an equal value,
+   in any process. Computed from the children's fingerprints, so after a
+   change only the touched path is rehashed. Cheap to use as a key for
+   compiled programs or grammars; 0 only for NULL. */
+uint64_t ajsb_cache_fingerprint(ajsb_cache_t *c, ajson_t *node);
+
+/* node (an object or array) was changed in place. Costs one atomic load
+   while no cache exists, two for a node no cache holds (rarely a node that
+   only shares a hash with a held one is logged too), and an atomic add on a
+   process-wide log for a node a cache holds; never blocks. The
+   change must happen before the stringify that should see it, as for any
+   other access to the tree. */
+void ajsb_touch(ajson_t *node);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* A_JSON_SCHEMA_BUILDER_CACHE_H */
@@ -0,0 +1,67 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#ifndef A_JSON_SCHEMA_BUILDER_CBOR_H
+#define A_JSON_SCHEMA_BUILDER_CBOR_H
+
+#include "a-json-library/ajson.h"
+#include "a-memory-library/aml_buffer.h"
+#include "a-memory-library/aml_pool.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Binary schemas (CBOR, RFC 8949).
+
+   ajsb_encode_cbor writes the schema tree straight to CBOR, no JSON text in
+   between, and ajsb_decode_cbor builds the tree back into a pool:
+
+     aml_buffer_t *bh = aml_buffer_init(1024);
+     ajsb_encode_cbor(bh, schema);
+     kv_put(key, aml_buffer_data(bh), aml_buffer_length(bh));
+     ...
+     ajson_t *schema = ajsb_decode_cbor(p, data, len);
+
+   Object keys that are JSON Schema keywords ("type", "properties",
+   "required", "$ref", ...) are written as small unsigned integers instead of
+   text; the 24 most common take one byte. The table only ever grows, so
+   older payloads stay readable. Every other key is a text string. Likewise
+   the standard values of "type" ("string", "object", ...) and "format"
+   ("email", "date-time", ...) are one-byte simple values.
+
+   The encoding is deterministic: shortest-form heads, definite lengths and
+   floats in the shortest of half/single/double precision that holds the
+   value exactly (RFC 8949, 4.2.1). Map members keep the order they have in
+   the tree rather than being sorted by key: property order is part of what
+   a schema says (grammars, generated code and prompts follow it), so
+   decoding gives back the same text that was encoded. Trees with the same
+   text therefore give identical bytes, and payloads can be hashed or
+   compared directly.
+
+   Numbers carry their value, not their text, and always exactly: integers
+   are CBOR integers (bignums, tags 2 and 3, past 64 bits) and everything
+   else (including "1.0") the shortest float that holds it, which decodes to
+   a decimal ("1.0"), so integers stay integers and decimals stay decimals.
+   A decimal no double holds (more digits than one keeps, or out of its
+   range) is a decimal fraction (tag 4) of its digits and power of ten.
+   Strings are decoded from their JSON escapes to UTF-8. */
+
+/* Appends the CBOR for schema to bh. False (bh unchanged) if a string holds
+   "\u0000" or a number's exponent does not fit in 62 bits. */
+bool ajsb_encode_cbor(aml_buffer_t *bh, ajson_t *schema);
+
+/* Tree for one CBOR item filling data[0..len), allocated from p. NULL if the
+   bytes are not one well-formed item of the kinds ajsb_encode_cbor writes
+   (a leading self-describe tag 55799 is accepted). */
+ajson_t *ajsb_decode_cbor(aml_pool_t *p, const void *data, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* A_JSON_SCHEMA_BUILDER_CBOR_H */
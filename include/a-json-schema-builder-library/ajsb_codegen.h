@@ -0,0 +1,51 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#ifndef A_JSON_SCHEMA_BUILDER_CODEGEN_H
+#define A_JSON_SCHEMA_BUILDER_CODEGEN_H
+
+#include "a-json-library/ajson.h"
+#include "a-memory-library/aml_buffer.h"
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Ahead-of-time validators.
+
+   ajsb_codegen_c compiles schema and writes a standalone C translation unit
+   that checks exactly what ajsb_validate checks, specialized to that schema:
+
+     bool <name>_validate(ajson_t *instance);
+
+   Every subschema (including $defs targets) becomes a static function, so
+   $ref is a direct call. Property names are dispatched with a switch on
+   length (and on a distinguishing byte when several names share a length)
+   and memcmp, enum members become the same switch or inline comparisons, and
+   bounds and counts are constants. Compiled "pattern" matchers become
+   constant tables. The generated file needs only a-json-library, plus the
+   header-only ajsb_format.h when the schema uses format or pattern.
+
+   The CMake helper ajsb_add_validator(<target> NAME <name> SCHEMA <file>)
+   runs the ajsb_codegen tool at build time and adds the result to a target.
+
+   name must be a C identifier. Returns false if it is not, or if the schema
+   does not compile (see ajsb_compile). */
+bool ajsb_codegen_c(aml_buffer_t *bh, ajson_t *schema, const char *name);
+
+/* The matching declaration: bool <name>_validate(ajson_t *instance); */
+bool ajsb_codegen_h(aml_buffer_t *bh, const char *name);
+
+/* ajsb_codegen_c / ajsb_codegen_h into a file (written to a temporary file,
+   then renamed). header_path may be NULL. */
+bool ajsb_codegen_file(const char *c_path, const char *header_path, ajson_t *schema,
+                       const char *name);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* A_JSON_SCHEMA_BUILDER_CODEGEN_H */
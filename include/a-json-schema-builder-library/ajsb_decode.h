@@ -0,0 +1,123 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#ifndef A_JSON_SCHEMA_BUILDER_DECODE_H
+#define A_JSON_SCHEMA_BUILDER_DECODE_H
+
+#include "a-json-library/ajson.h"
+#include "a-memory-library/aml_pool.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Schema-typed decoding into C structs.
+
+   Properties are bound to struct members (offsetof plus a C type) while the
+   schema is built. A decoder made from the schema then reads raw JSON text in
+   one pass, validates it exactly as ajsb_validate would, and writes the bound
+   members of the caller's struct without building a DOM:
+
+     typedef struct { ajsb_text_t city; double temp_c; ajsb_slice_t conditions; } weather_t;
+
+     ajsb_fields_t *f = ajsb_fields_init(p);
+     ajson_t *w = ajsb_object(p);
+     ajsb_fields_prop_required(f, w, "city",  ajsb_string(p), AJSB_FIELD_STRING, offsetof(weather_t, city));
+     ajsb_fields_prop_required(f, w, "tempC", ajsb_number(p), AJSB_FIELD_DOUBLE, offsetof(weather_t, temp_c));
+     ajsb_prop(p, w, "conditions", ajsb_array(p, ajsb_string(p)));
+     ajsb_fields_bind_array(f, w, "conditions", offsetof(weather_t, conditions),
+                            AJSB_FIELD_STRING, sizeof(ajsb_text_t));
+
+     ajsb_decoder_t *d = ajsb_decoder_init(p, f, w);
+     weather_t out = {0};
+     if (ajsb_decode(d, p, text, len, &out, NULL) == AJSB_DECODE_OK) ...
+
+   Strings point into the input when they contain no escapes and are copied
+   (unescaped) into the pool otherwise. Arrays and unescaped strings are
+   allocated from the pool passed to ajsb_decode.
+
+   null and absent properties leave their members untouched, so zero the
+   struct first. Members of objects that are not bound (AJSB_FIELD_STRUCT) are
+   not written. A value whose schema uses anyOf, oneOf, not, uniqueItems or
+   object/array enum members is checked on a small DOM of just that value and
+   then bound as usual; bindings declared inside anyOf/oneOf/not branches are
+   not used. out may be NULL to only validate. */
+
+typedef struct {
+  const char *s;
+  size_t      len;
+} ajsb_text_t;
+
+typedef struct {
+  void   *items;            /* count elements of the bound element size */
+  size_t  count;
+} ajsb_slice_t;
+
+typedef enum {
+  AJSB_FIELD_BOOL = 1,      /* bool */
+  AJSB_FIELD_INT,           /* int; the number must be integral and fit */
+  AJSB_FIELD_INT64,         /* int64_t; the number must be integral and fit */
+  AJSB_FIELD_DOUBLE,        /* double */
+  AJSB_FIELD_STRING,        /* ajsb_text_t, unescaped */
+  AJSB_FIELD_JSON,          /* ajsb_text_t, the raw text of any value */
+  AJSB_FIELD_STRUCT,        /* embedded struct; the object's own bindings are relative to it */
+  AJSB_FIELD_ARRAY          /* ajsb_slice_t; see ajsb_fields_bind_array */
+} ajsb_field_type_t;
+
+typedef struct ajsb_fields_s ajsb_fields_t;
+
+ajsb_fields_t *ajsb_fields_init(aml_pool_t *p);
+
+/* ajsb_prop / ajsb_prop_required, binding obj.properties[name] to the member
+   at offset. */
+void ajsb_fields_prop(ajsb_fields_t *f, ajson_t *obj, const char *name, ajson_t *schema,
+                      ajsb_field_type_t type, size_t offset);
+void ajsb_fields_prop_required(ajsb_fields_t *f, ajson_t *obj, const char *name, ajson_t *schema,
+                               ajsb_field_type_t type, size_t offset);
+
+/* Bind a property that is already in obj (e.g. a parsed schema). Rebinding
+   replaces the earlier binding. */
+void ajsb_fields_bind(ajsb_fields_t *f, ajson_t *obj, const char *name,
+                      ajsb_field_type_t type, size_t offset);
+
+/* Bind an array property to an ajsb_slice_t at offset. Each item is decoded
+   as elem_type into elem_size bytes; for AJSB_FIELD_STRUCT the items schema's
+   own bindings are relative to the element. */
+void ajsb_fields_bind_array(ajsb_fields_t *f, ajson_t *obj, const char *name, size_t offset,
+                            ajsb_field_type_t elem_type, size_t elem_size);
+
+typedef struct ajsb_decoder_s ajsb_decoder_t;
+
+/* Compile schema (see ajsb_compile) with the bindings in f. The root must
+   describe an object; its bindings are relative to the struct passed to
+   ajsb_decode. The decoder is read-only afterwards and may be shared between
+   threads. Returns NULL if the schema does not compile. */
+ajsb_decoder_t *ajsb_decoder_init(aml_pool_t *p, const ajsb_fields_t *f, ajson_t *schema);
+
+typedef enum {
+  AJSB_DECODE_OK = 0,
+  AJSB_DECODE_INVALID,      /* JSON, but not valid for the schema or the bound types */
+  AJSB_DECODE_SYNTAX_ERROR  /* not JSON */
+} ajsb_decode_status_t;
+
+typedef struct {
+  const char *why;          /* short description */
+  size_t      offset;       /* byte offset where it was detected */
+} ajsb_decode_error_t;
+
+#define AJSB_DECODE_MAX_DEPTH 64   /* deeper nesting is reported as invalid */
+
+/* Decode json[0..len) into out. Members may already be written when a later
+   failure is found. err may be NULL. */
+ajsb_decode_status_t ajsb_decode(const ajsb_decoder_t *d, aml_pool_t *p, const char *json,
+                                 size_t len, void *out, ajsb_decode_error_t *err);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* A_JSON_SCHEMA_BUILDER_DECODE_H */
@@ -0,0 +1,56 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#ifndef A_JSON_SCHEMA_BUILDER_DERIVE_H
+#define A_JSON_SCHEMA_BUILDER_DERIVE_H
+
+#include "a-json-library/ajson.h"
+#include "a-memory-library/aml_pool.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Copy-on-write variants of a base schema.
+
+   ajsb_derive starts a variant of base in a (short-lived) pool p. The variant
+   is an ordinary ajson_t tree, so stringify, compile and validate need nothing
+   special, but only the nodes on the paths you ask to change are copied into
+   p; everything else is the base's own nodes. base is never modified and must
+   outlive the variant.
+
+   Every node handed out is writable with the regular ajsb_* helpers: its
+   "properties", "required" and "$defs" members are private copies too, so
+   ajsb_prop, ajsb_prop_required and ajsb_defs_set do not reach into the base.
+
+     ajsb_derive_t *d = ajsb_derive(req_pool, base);
+     ajsb_prop(req_pool, ajsb_derive_root(d), "trace_id", ajsb_string(req_pool));
+     ajsb_array_max_items(req_pool, ajsb_derive_at(d, "/properties/tags"), 5);
+     send(ajsb_stringify(req_pool, ajsb_derive_root(d)));
+
+   Cost is proportional to the changed paths (and the width of the objects on
+   them), not to the size of the schema. */
+typedef struct ajsb_derive_s ajsb_derive_t;
+
+ajsb_derive_t *ajsb_derive(aml_pool_t *p, ajson_t *base);
+
+/* The variant's root (writable). */
+ajson_t *ajsb_derive_root(const ajsb_derive_t *d);
+
+/* Writable node at a JSON Pointer ("" or "#" is the root, "/properties/a",
+   "/anyOf/0"), copying the nodes along the path. NULL if the path does not
+   exist. */
+ajson_t *ajsb_derive_at(ajsb_derive_t *d, const char *pointer);
+
+/* Whether node belongs to the variant (was copied) rather than the base. */
+bool ajsb_derive_owns(const ajsb_derive_t *d, const ajson_t *node);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* A_JSON_SCHEMA_BUILDER_DERIVE_H */
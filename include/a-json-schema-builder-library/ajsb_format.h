@@ -0,0 +1,454 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#ifndef A_JSON_SCHEMA_BUILDER_FORMAT_H
+#define A_JSON_SCHEMA_BUILDER_FORMAT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* String checks behind the "format" and "pattern" keywords.
+
+   ajsb_compile lowers "format" to one of the ids below and "pattern" to a
+   compiled matcher, so nothing is parsed while validating. Everything here is
+   static inline and needs only libc, which lets the C written by
+   ajsb_codegen_c use the same checks without linking this library.
+
+   The fixed-layout formats (date, time, uuid) check their shape eight bytes
+   at a time with SWAR byte classification and then test the numeric fields.
+   All checks take the decoded string; the _json variants accept the text as
+   it appears between the quotes in a document and unescape it first when it
+   contains a backslash. */
+
+typedef enum {
+  AJSB_FORMAT_NONE = 0,     /* any other format name is an annotation */
+  AJSB_FORMAT_DATE,         /* RFC 3339 full-date: 2024-02-29 */
+  AJSB_FORMAT_TIME,         /* RFC 3339 full-time: 23:59:60.5+01:00 */
+  AJSB_FORMAT_DATE_TIME,    /* date "T" time */
+  AJSB_FORMAT_EMAIL,        /* RFC 5321 mailbox; dot-atom or quoted local part */
+  AJSB_FORMAT_UUID,         /* 8-4-4-4-12 hex digits, either case */
+  AJSB_FORMAT_IPV4          /* dotted quad, no leading zeros */
+} ajsb_format_t;
+
+static inline ajsb_format_t ajsb_format_id(const char *name) {
+  if (!name) return AJSB_FORMAT_NONE;
+  if (!strcmp(name, "date"))      return AJSB_FORMAT_DATE;
+  if (!strcmp(name, "time"))      return AJSB_FORMAT_TIME;
+  if (!strcmp(name, "date-time")) return AJSB_FORMAT_DATE_TIME;
+  if (!strcmp(name, "email"))     return AJSB_FORMAT_EMAIL;
+  if (!strcmp(name, "uuid"))      return AJSB_FORMAT_UUID;
+  if (!strcmp(name, "ipv4"))      return AJSB_FORMAT_IPV4;
+  return AJSB_FORMAT_NONE;
+}
+
+/* ── SWAR byte classification (8 bytes per uint64_t) ────────────────────── */
+
+#define AJSB__ONES 0x0101010101010101ULL
+#define AJSB__LOW7 0x7F7F7F7F7F7F7F7FULL
+#define AJSB__HIGH 0x8080808080808080ULL
+
+static inline uint64_t ajsb__load8(const char *s) {
+  uint64_t x;
+  memcpy(&x, s, 8);
+  return x;
+}
+
+/* 0x80 in every byte of x that is zero. */
+static inline uint64_t ajsb__zero(uint64_t x) {
+  return ~(((x & AJSB__LOW7) + AJSB__LOW7) | x | AJSB__LOW7);
+}
+
+/* 0x80 in every byte of x that is >= n (1 <= n <= 128); bytes >= 0x80 count. */
+static inline uint64_t ajsb__ge(uint64_t x, unsigned n) {
+  return (((x & AJSB__LOW7) + (0x80u - n) * AJSB__ONES) | x) & AJSB__HIGH;
+}
+
+/* 0x80 in every byte of x within [lo, hi] (hi < 127). */
+static inline uint64_t ajsb__in(uint64_t x, unsigned lo, unsigned hi) {
+  return ajsb__ge(x, lo) & ~ajsb__ge(x, hi + 1);
+}
+
+/* s[0..8) matches tmpl[0..8), where 'd' in tmpl is any digit, 'x' any hex
+   digit and every other byte must be equal. */
+static inline bool ajsb__shape8(const char *s, const char *tmpl) {
+  uint64_t x = ajsb__load8(s), t = ajsb__load8(tmpl);
+  uint64_t want_d = ajsb__zero(t ^ ((uint64_t)'d' * AJSB__ONES));
+  uint64_t want_x = ajsb__zero(t ^ ((uint64_t)'x' * AJSB__ONES));
+  uint64_t want_eq = ~(want_d | want_x) & AJSB__HIGH;
+  uint64_t digit = ajsb__in(x, '0', '9');
+  uint64_t hex = digit | ajsb__in(x | (0x20 * AJSB__ONES), 'a', 'f');
+  uint64_t eq = ajsb__zero(x ^ t);
+  return ((digit & want_d) | (hex & want_x) | (eq & want_eq)) == AJSB__HIGH;
+}
+
+static inline unsigned ajsb__num2(const char *s) {
+  return (unsigned)(s[0] - '0') * 10 + (unsigned)(s[1] - '0');
+}
+
+/* ── Formats ────────────────────────────────────────────────────────────── */
+
+/* Exactly 10 bytes. */
+static inline bool ajsb__date(const char *s) {
+  static const char tmpl[] = "dddd-dd-dd";
+  if (!ajsb__shape8(s, tmpl) || !ajsb__shape8(s + 2, tmpl + 2)) return false;
+  unsigned y = ajsb__num2(s) * 100 + ajsb__num2(s + 2);
+  unsigned m = ajsb__num2(s + 5), d = ajsb__num2(s + 8);
+  static const unsigned char days[12] = {31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+  if (m < 1 || m > 12 || d < 1 || d > days[m - 1]) return false;
+  return m != 2 || d < 29 || (y % 4 == 0 && (y % 100 != 0 || y % 400 == 0));
+}
+
+static inline bool ajsb__time(const char *s, size_t len) {
+  static const char tmpl[] = "dd:dd:dd";
+  if (len < 9 || !ajsb__shape8(s, tmpl)) return false;
+  unsigned h = ajsb__num2(s), m = ajsb__num2(s + 3), sec = ajsb__num2(s + 6);
+  if (h > 23 || m > 59 || sec > 60) return false;
+  size_t i = 8;
+  if (s[i] == '.') {
+    size_t start = ++i;
+    while (i < len && s[i] >= '0' && s[i] <= '9') i++;
+    if (i == start) return false;
+  }
+  int off = 0;
+  if (i + 6 == len && (s[i] == '+' || s[i] == '-') && s[i + 3] == ':' &&
+      s[i + 1] >= '0' && s[i + 1] <= '9' && s[i + 2] >= '0' && s[i + 2] <= '9' &&
+      s[i + 4] >= '0' && s[i + 4] <= '9' && s[i + 5] >= '0' && s[i + 5] <= '9') {
+    unsigned oh = ajsb__num2(s + i + 1), om = ajsb__num2(s + i + 4);
+    if (oh > 23 || om > 59) return false;
+    off = (s[i] == '-' ? -1 : 1) * (int)(oh * 60 + om);
+  }
+  else if (i + 1 != len || (s[i] != 'Z' && s[i] != 'z')) return false;
+  /* a leap second is only valid at 23:59:60 UTC */
+  if (sec == 60) {
+    int utc = (((int)(h * 60 + m) - off) % 1440 + 1440) % 1440;
+    if (utc != 23 * 60 + 59) return false;
+  }
+  return true;
+}
+
+static inline bool ajsb__uuid(const char *s) {
+  static const char tmpl[] = "xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx";
+  return ajsb__shape8(s, tmpl) && ajsb__shape8(s + 8, tmpl + 8) &&
+         ajsb__shape8(s + 16, tmpl + 16) && ajsb__shape8(s + 24, tmpl + 24) &&
+         ajsb__shape8(s + 28, tmpl + 28);
+}
+
+/* Advances *i past one dotted quad. */
+static inline bool ajsb__ipv4(const char *s, size_t len, size_t *i) {
+  for (int part = 0; part < 4; part++) {
+    if (part) {
+      if (*i >= len || s[*i] != '.') return false;
+      (*i)++;
+    }
+    size_t start = *i;
+    unsigned v = 0;
+    while (*i < len && *i - start < 3 && s[*i] >= '0' && s[*i] <= '9')
+      v = v * 10 + (unsigned)(s[(*i)++] - '0');
+    if (*i == start || v > 255 || (s[start] == '0' && *i - start > 1)) return false;
+  }
+  return true;
+}
+
+/* RFC 5322 atext */
+static inline bool ajsb__atext(unsigned char c) {
+  static const uint32_t bits[4] = {
+    0x00000000u, 0xA3FFACFAu, 0xC7FFFFFEu, 0x7FFFFFFFu   /* ! # $ % & ' * + - / 0-9 = ? A-Z ^ _ ` a-z { | } ~ */
+  };
+  return c < 128 && ((bits[c >> 5] >> (c & 31)) & 1);
+}
+
+static inline bool ajsb__hostname(const char *s, size_t len) {
+  if (!len || len > 253) return false;
+  size_t label = 0;
+  for (size_t i = 0; i < len; i++) {
+    char c = s[i];
+    if (c == '.') {
+      if (!label || s[i - 1] == '-') return false;
+      label = 0;
+      continue;
+    }
+    bool alnum = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+    if (!alnum && (c != '-' || !label)) return false;
+    if (++label > 63) return false;
+  }
+  return label && s[len - 1] != '-';
+}
+
+static inline bool ajsb__email(const char *s, size_t len) {
+  size_t i = 0;
+  if (len && s[0] == '"') {
+    for (i = 1; i < len && s[i] != '"'; i++) {
+      unsigned char c = (unsigned char)s[i];
+      if (c == '\\') {
+        if (++i >= len || (unsigned char)s[i] < 0x20 || (unsigned char)s[i] > 0x7E) return false;
+      }
+      else if (c < 0x20 || c > 0x7E) return false;
+    }
+    if (i >= len) return false;
+    i++;
+  }
+  else {
+    for (; i < len && s[i] != '@'; i++) {
+      if (s[i] == '.' ? (!i || s[i - 1] == '.') : !ajsb__atext((unsigned char)s[i])) return false;
+    }
+    if (!i || s[i - 1] == '.') return false;
+  }
+  if (i > 64 || i >= len || s[i] != '@') return false;
+  const char *at = s + i + 1;
+  size_t dlen = len - i - 1;
+  if (dlen >= 2 && at[0] == '[' && at[dlen - 1] == ']') {
+    size_t k = 1;
+    return ajsb__ipv4(at, dlen - 1, &k) && k == dlen - 1;
+  }
+  return ajsb__hostname(at, dlen);
+}
+
+/* true if s[0..len) (decoded) is valid for format; AJSB_FORMAT_NONE always is. */
+static inline bool ajsb_format_check(ajsb_format_t format, const char *s, size_t len) {
+  switch (format) {
+  case AJSB_FORMAT_DATE:      return len == 10 && ajsb__date(s);
+  case AJSB_FORMAT_TIME:      return ajsb__time(s, len);
+  case AJSB_FORMAT_DATE_TIME:
+    return len > 11 && (s[10] == 'T' || s[10] == 't') && ajsb__date(s) &&
+           ajsb__time(s + 11, len - 11);
+  case AJSB_FORMAT_EMAIL:     return ajsb__email(s, len);
+  case AJSB_FORMAT_UUID:      return len == 36 && ajsb__uuid(s);
+  case AJSB_FORMAT_IPV4: {
+    size_t i = 0;
+    return len <= 15 && ajsb__ipv4(s, len, &i) && i == len;
+  }
+  case AJSB_FORMAT_NONE:      break;
+  }
+  return true;
+}
+
+/* ── Compiled patterns ──────────────────────────────────────────────────── */
+
+/* Patterns are compiled once, by ajsb_compile, from the regular subset of
+   ECMA-262: literals, ".", classes, \d \w \s (ASCII) and their negations,
+   character escapes, groups (capturing, (?:) and named), alternation, * + ?
+   {n,m} (lazy or not) and ^ $. Back references, lookaround, \b and \p{}
+   are not compiled and leave the pattern unchecked. Matching is over UTF-8,
+   so "." and negated classes consume whole characters.
+
+   A compiled "pattern" is an array of uint32_t words:
+
+     AJSB_PATTERN_SPAN  min max bitmap[8]
+       ^C{min,max}$ for an ASCII class C: the length is in range and every
+       byte is in the 256-bit bitmap. max is UINT32_MAX when unbounded.
+
+     AJSB_PATTERN_DFA  states classes map[64] flags[states] next[states * classes]
+       byte b has class (map[b / 4] >> (b % 4 * 8)) & 0xFF; state 0 is dead
+       and state 1 is the start. The DFA searches (the pattern is not
+       anchored unless it says so), so a state flagged AJSB_DFA_MATCH accepts
+       whatever follows and AJSB_DFA_END_MATCH accepts only at the end. */
+enum { AJSB_PATTERN_SPAN = 1, AJSB_PATTERN_DFA = 2 };
+enum { AJSB_DFA_MATCH = 1u << 0, AJSB_DFA_END_MATCH = 1u << 1 };
+
+/* Number of words in a compiled pattern. */
+static inline size_t ajsb_pattern_words(const uint32_t *pat) {
+  return pat[0] == AJSB_PATTERN_SPAN ? 11 : 3 + 64 + (size_t)pat[1] * (1 + pat[2]);
+}
+
+static inline bool ajsb_pattern_match(const uint32_t *pat, const char *s, size_t len) {
+  const unsigned char *u = (const unsigned char *)s;
+  if (pat[0] == AJSB_PATTERN_SPAN) {
+    if (len < pat[1] || len > pat[2]) return false;
+    const uint32_t *bitmap = pat + 3;
+    for (size_t i = 0; i < len; i++)
+      if (!((bitmap[u[i] >> 5] >> (u[i] & 31)) & 1)) return false;
+    return true;
+  }
+  uint32_t classes = pat[2];
+  const uint32_t *map = pat + 3, *flags = map + 64, *next = flags + pat[1];
+  uint32_t st = 1;
+  for (size_t i = 0; i < len; i++) {
+    if (flags[st] & AJSB_DFA_MATCH) return true;
+    st = next[st * classes + ((map[u[i] >> 2] >> ((u[i] & 3) * 8)) & 0xFF)];
+    if (!st) return false;
+  }
+  return (flags[st] & (AJSB_DFA_MATCH | AJSB_DFA_END_MATCH)) != 0;
+}
+
+/* ── JSON string text ───────────────────────────────────────────────────── */
+
+static inline unsigned ajsb__hex4(const char *p) {
+  unsigned v = 0;
+  for (int i = 0; i < 4; i++) {
+    char c = p[i];
+    v = v << 4 | (unsigned)(c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10);
+  }
+  return v;
+}
+
+/* Decode the escapes in well-formed JSON string text src[0..len) into dst,
+   which needs len bytes (escapes never grow). Returns the decoded length;
+   \u escapes become UTF-8 and surrogate pairs are joined. */
+static inline size_t ajsb_json_unescape(char *dst, const char *src, size_t len) {
+  const char *s = src, *e = src + len;
+  char *w = dst;
+  while (s < e) {
+    if (*s != '\\') { *w++ = *s++; continue; }
+    s++;
+    switch (*s++) {
+    case 'b': *w++ = '\b'; break;
+    case 'f': *w++ = '\f'; break;
+    case 'n': *w++ = '\n'; break;
+    case 'r': *w++ = '\r'; break;
+    case 't': *w++ = '\t'; break;
+    case 'u': {
+      unsigned cp = ajsb__hex4(s);
+      s += 4;
+      if (cp >= 0xD800 && cp < 0xDC00 && e - s >= 6 && s[0] == '\\' && s[1] == 'u') {
+        unsigned lo = ajsb__hex4(s + 2);
+        if (lo >= 0xDC00 && lo < 0xE000) {
+          cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+          s += 6;
+        }
+      }
+      if (cp < 0x80) *w++ = (char)cp;
+      else if (cp < 0x800) {
+        *w++ = (char)(0xC0 | (cp >> 6));
+        *w++ = (char)(0x80 | (cp & 0x3F));
+      }
+      else if (cp < 0x10000) {
+        *w++ = (char)(0xE0 | (cp >> 12));
+        *w++ = (char)(0x80 | ((cp >> 6) & 0x3F));
+        *w++ = (char)(0x80 | (cp & 0x3F));
+      }
+      else {
+        *w++ = (char)(0xF0 | (cp >> 18));
+        *w++ = (char)(0x80 | ((cp >> 12) & 0x3F));
+        *w++ = (char)(0x80 | ((cp >> 6) & 0x3F));
+        *w++ = (char)(0x80 | (cp & 0x3F));
+      }
+      break;
+    }
+    default: *w++ = s[-1]; break;   /* " \ / */
+    }
+  }
+  return (size_t)(w - dst);
+}
+
+/* Decoded form of raw JSON string text: raw itself when it has no escapes,
+   else stack (when len fits in cap) or *heap, which the caller frees. */
+static inline const char *ajsb__decoded(const char *raw, size_t *len, char *stack, size_t cap,
+                                        char **heap) {
+  *heap = NULL;
+  if (!memchr(raw, '\\', *len)) return raw;
+  char *buf = *len <= cap ? stack : (*heap = (char *)malloc(*len));
+  if (!buf) return NULL;
+  *len = ajsb_json_unescape(buf, raw, *len);
+  return buf;
+}
+
+/* Rewrite well-formed JSON string text src[0..len) into its canonical form
+   at dst (which may be src; escapes never grow). Escaped characters that
+   need no escape become UTF-8, the rest become \" \\ \b \f \n \r \t or
+   lowercase \u00xx, and unpaired surrogates stay lowercase \udxxx.
+   Unescaped bytes are copied. Two texts are the same string exactly when
+   their canonical forms are equal, so compiled schemas store names and enum
+   strings this way and instance text is compared the same way. */
+static inline size_t ajsb_json_canonical(char *dst, const char *src, size_t len) {
+  static const char hex[] = "0123456789abcdef";
+  const char *s = src, *e = src + len;
+  char *w = dst;
+  while (s < e) {
+    if (*s != '\\') { *w++ = *s++; continue; }
+    char c = s[1];
+    s += 2;
+    if (c != 'u') {
+      if (c != '/') *w++ = '\\';
+      *w++ = c;
+      continue;
+    }
+    unsigned cp = ajsb__hex4(s);
+    s += 4;
+    if (cp >= 0xD800 && cp < 0xDC00 && e - s >= 6 && s[0] == '\\' && s[1] == 'u') {
+      unsigned lo = ajsb__hex4(s + 2);
+      if (lo >= 0xDC00 && lo < 0xE000) {
+        cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+        s += 6;
+      }
+    }
+    const char *shrt = cp == '"' ? "\"" : cp == '\\' ? "\\" : cp == '\b' ? "b" : cp == '\f' ? "f"
+                     : cp == '\n' ? "n" : cp == '\r' ? "r" : cp == '\t' ? "t" : NULL;
+    if (shrt) { *w++ = '\\'; *w++ = *shrt; }
+    else if (cp < 0x20 || (cp >= 0xD800 && cp < 0xE000)) {
+      *w++ = '\\'; *w++ = 'u';
+      for (int i = 12; i >= 0; i -= 4) *w++ = hex[(cp >> i) & 0xF];
+    }
+    else if (cp < 0x80) *w++ = (char)cp;
+    else if (cp < 0x800) {
+      *w++ = (char)(0xC0 | (cp >> 6));
+      *w++ = (char)(0x80 | (cp & 0x3F));
+    }
+    else if (cp < 0x10000) {
+      *w++ = (char)(0xE0 | (cp >> 12));
+      *w++ = (char)(0x80 | ((cp >> 6) & 0x3F));
+      *w++ = (char)(0x80 | (cp & 0x3F));
+    }
+    else {
+      *w++ = (char)(0xF0 | (cp >> 18));
+      *w++ = (char)(0x80 | ((cp >> 12) & 0x3F));
+      *w++ = (char)(0x80 | ((cp >> 6) & 0x3F));
+      *w++ = (char)(0x80 | (cp & 0x3F));
+    }
+  }
+  return (size_t)(w - dst);
+}
+
+/* ajsb__decoded for the canonical form. */
+static inline const char *ajsb__canonical(const char *raw, size_t *len, char *stack, size_t cap,
+                                          char **heap) {
+  *heap = NULL;
+  if (!memchr(raw, '\\', *len)) return raw;
+  char *buf = *len <= cap ? stack : (*heap = (char *)malloc(*len));
+  if (!buf) return NULL;
+  *len = ajsb_json_canonical(buf, raw, *len);
+  return buf;
+}
+
+/* Whether two raw JSON string texts are the same string. */
+static inline bool ajsb_json_text_eq(const char *a, size_t alen, const char *b, size_t blen) {
+  if (!memchr(a, '\\', alen) && !memchr(b, '\\', blen))
+    return alen == blen && !memcmp(a, b, alen);
+  char sa[128], sb[128], *ha, *hb;
+  const char *x = ajsb__canonical(a, &alen, sa, sizeof(sa), &ha);
+  const char *y = ajsb__canonical(b, &blen, sb, sizeof(sb), &hb);
+  bool eq = x && y && alen == blen && !memcmp(x, y, alen);
+  free(ha);
+  free(hb);
+  return eq;
+}
+
+static inline bool ajsb_format_check_json(ajsb_format_t format, const char *raw, size_t len) {
+  char stack[256], *heap;
+  const char *s = ajsb__decoded(raw, &len, stack, sizeof(stack), &heap);
+  bool ok = s && ajsb_format_check(format, s, len);
+  free(heap);
+  return ok;
+}
+
+static inline bool ajsb_pattern_match_json(const uint32_t *pat, const char *raw, size_t len) {
+  char stack[256], *heap;
+  const char *s = ajsb__decoded(raw, &len, stack, sizeof(stack), &heap);
+  bool ok = s && ajsb_pattern_match(pat, s, len);
+  free(heap);
+  return ok;
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* A_JSON_SCHEMA_BUILDER_FORMAT_H */
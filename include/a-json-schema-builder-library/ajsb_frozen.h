@@ -0,0 +1,101 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#ifndef A_JSON_SCHEMA_BUILDER_FROZEN_H
+#define A_JSON_SCHEMA_BUILDER_FROZEN_H
+
+#include "a-json-schema-builder-library/ajsb_validate.h"
+#include "a-json-library/ajson.h"
+#include "a-memory-library/aml_buffer.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Frozen schemas.
+
+   ajsb_freeze writes a set of named schemas into one position-independent
+   blob: every schema as a compact offset-based tree (shared subtrees stored
+   once) over an interned string table, plus its compiled validation program.
+   A blob can be written to a file and mapped read-only by any number of
+   processes, so services that build thousands of schemas at startup can do
+   it once at build time instead.
+
+   Opening a blob checks its header and nothing else: there is no parsing and
+   no per-schema allocation. Accessors, stringify and validation run directly
+   over the mapped bytes. The format is specific to the byte order and struct
+   layout of the machine that wrote it; a mismatching blob is refused. */
+typedef struct ajsb_frozen_s ajsb_frozen_t;
+
+/* Append a blob holding schemas[0..n) to bh. names may be NULL (unnamed
+   schemas are reached by index). Returns false if a schema cannot be compiled. */
+bool ajsb_freeze(aml_buffer_t *bh, size_t n, const char *const *names, ajson_t *const *schemas);
+
+/* ajsb_freeze into path (written to a temporary file, then renamed). */
+bool ajsb_freeze_file(const char *path, size_t n, const char *const *names, ajson_t *const *schemas);
+
+/* Map a blob file read-only. NULL if missing or not a valid blob. */
+ajsb_frozen_t *ajsb_frozen_open(const char *path);
+
+/* View a blob already in memory (8-byte aligned; must outlive the view). */
+ajsb_frozen_t *ajsb_frozen_load(const void *data, size_t len);
+
+void ajsb_frozen_close(ajsb_frozen_t *f);
+
+size_t      ajsb_frozen_count(const ajsb_frozen_t *f);
+const char *ajsb_frozen_name(const ajsb_frozen_t *f, size_t i);
+
+/* Index of the schema called name, or -1. Binary search over a sorted table. */
+int ajsb_frozen_find(const ajsb_frozen_t *f, const char *name);
+
+/* Program for schema i; shares the blob's memory. */
+const ajsb_program_t *ajsb_frozen_program(const ajsb_frozen_t *f, size_t i);
+
+static inline bool ajsb_frozen_validate(const ajsb_frozen_t *f, size_t i, ajson_t *instance) {
+  return ajsb_validate(ajsb_frozen_program(f, i), instance);
+}
+
+/* ── Read-only tree access ─────────────────────────────────────────────── */
+
+typedef enum {
+  AJSB_FROZEN_NONE = 0,       /* missing node */
+  AJSB_FROZEN_OBJECT,
+  AJSB_FROZEN_ARRAY,
+  AJSB_FROZEN_STRING,
+  AJSB_FROZEN_NUMBER,
+  AJSB_FROZEN_TRUE,
+  AJSB_FROZEN_FALSE,
+  AJSB_FROZEN_NULL
+} ajsb_frozen_type_t;
+
+/* A node is a (blob, offset) pair passed by value. */
+typedef struct {
+  const ajsb_frozen_t *f;
+  uint32_t at;
+} ajsb_fnode_t;
+
+ajsb_fnode_t       ajsb_frozen_root(const ajsb_frozen_t *f, size_t i);
+ajsb_frozen_type_t ajsb_fnode_type(ajsb_fnode_t n);
+
+/* Members of an object or elements of an array. */
+size_t       ajsb_fnode_count(ajsb_fnode_t n);
+const char  *ajsb_fnode_key(ajsb_fnode_t n, size_t i);
+ajsb_fnode_t ajsb_fnode_value(ajsb_fnode_t n, size_t i);
+ajsb_fnode_t ajsb_fnode_get(ajsb_fnode_t n, const char *key);
+
+/* Encoded text of a string (without quotes) or number; NULL otherwise. */
+const char *ajsb_fnode_str(ajsb_fnode_t n);
+
+/* Append compact JSON for n, identical to ajsb_stringify of the original. */
+void ajsb_fnode_stringify(ajsb_fnode_t n, aml_buffer_t *bh);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* A_JSON_SCHEMA_BUILDER_FROZEN_H */
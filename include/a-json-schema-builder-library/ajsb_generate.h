@@ -0,0 +1,82 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#ifndef A_JSON_SCHEMA_BUILDER_GENERATE_H
+#define A_JSON_SCHEMA_BUILDER_GENERATE_H
+
+#include "a-json-library/ajson.h"
+#include "a-memory-library/aml_buffer.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Synthetic instances of a schema, for load tests and benchmarks.
+
+     ajsb_generator_t *g = ajsb_generator_init(schema, NULL);
+     ajsb_generate(g, 0, true, bh);              // instance 0, valid
+     ajsb_generate_file(g, "load.jsonl", (size_t)1 << 30);
+     ajsb_generator_destroy(g);
+
+   The generator walks the schema: properties and required (optional
+   properties are present half the time), enum and const, minimum/maximum and
+   their exclusive forms, minItems/maxItems, uniqueItems, minLength/maxLength,
+   the checked formats (date, time, date-time, email, uuid, ipv4) and
+   "pattern", by a random walk of its compiled DFA towards an accepting state.
+   allOf branches are combined, one anyOf/oneOf branch is taken at random, and
+   $ref / $dynamicRef are followed. Past max_depth only what is required is
+   generated (no optional properties, minItems items, the shallowest
+   branch), so recursive schemas terminate.
+
+   Each candidate is then checked with ajsb_validate and regenerated if the
+   walk missed something (oneOf exclusivity, not, a duplicate under
+   uniqueItems), so what comes out valid is valid. An invalid instance is a
+   valid one with a single subschema replaced by a value that breaks one of
+   its keywords (wrong type, outside a bound, missing required property,
+   unknown property, enum miss, pattern or format mismatch), also confirmed
+   by the validator.
+
+   Instance n depends only on the seed, n and validity, so runs are
+   reproducible and any range of instances can be produced independently. */
+
+typedef struct {
+  uint64_t seed;
+  int      max_depth;        /* nesting before only required parts are made; 0 = 6 */
+  size_t   max_items;        /* extra array items above minItems; 0 = 4 */
+  size_t   max_length;       /* extra string length above minLength; 0 = 12 */
+  double   invalid_ratio;    /* ajsb_generate_file: share of invalid lines, 0..1 */
+  int      threads;          /* ajsb_generate_file: workers; 0 = online CPUs */
+} ajsb_generate_options_t;
+
+typedef struct ajsb_generator_s ajsb_generator_t;
+
+/* Links and compiles schema; NULL if it does not compile (see ajsb_compile).
+   opts may be NULL. schema must outlive the generator and not change. */
+ajsb_generator_t *ajsb_generator_init(ajson_t *schema, const ajsb_generate_options_t *opts);
+void ajsb_generator_destroy(ajsb_generator_t *g);
+
+/* Appends instance n (compact JSON, no newline) to bh. False, with bh
+   unchanged, if no instance of that validity was found (an unsatisfiable
+   schema, or an invalid one asked of a schema that accepts everything).
+   Safe to call from several threads on one generator. */
+bool ajsb_generate(const ajsb_generator_t *g, uint64_t n, bool valid, aml_buffer_t *bh);
+
+/* Writes instances 0, 1, 2, ... as JSON Lines to path until it holds at least
+   bytes bytes, generating on several threads. Instance n is invalid for a
+   share invalid_ratio of n, chosen from the seed; the file is the same for
+   any number of threads. Instances that cannot be generated are skipped,
+   and writing stops early if none of a run of 256 can. Returns the number of
+   lines written, (size_t)-1 if the file cannot be written or no instance
+   could be generated. */
+size_t ajsb_generate_file(const ajsb_generator_t *g, const char *path, size_t bytes);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* A_JSON_SCHEMA_BUILDER_GENERATE_H */
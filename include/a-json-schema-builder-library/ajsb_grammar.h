@@ -0,0 +1,99 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#ifndef A_JSON_SCHEMA_BUILDER_GRAMMAR_H
+#define A_JSON_SCHEMA_BUILDER_GRAMMAR_H
+
+#include "a-json-schema-builder-library/ajsb_validate.h"
+#include "a-json-library/ajson.h"
+#include "a-memory-library/aml_pool.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Grammars for constrained decoding.
+
+   A schema is lowered into a table of byte-level rules (literal bytes, byte
+   classes and rule references) with FIRST sets and nullability precomputed
+   per alternative. The same table is rendered as GBNF text for external
+   samplers and driven directly by ajsb_grammar_matcher_t, a pushdown matcher
+   that answers "which bytes may come next" without re-reading the prefix.
+
+   The grammar describes the canonical shape a generator should produce:
+     - declared properties in declared order, required ones mandatory
+     - additional properties only for objects that declare none
+     - enum/const values, anyOf/oneOf alternatives, $ref/$defs recursion
+     - minItems/maxItems (bounds above 64 are treated as open)
+   Numeric bounds, uniqueItems, allOf beyond its first branch and not are left
+   to ajsb_validate, so run that on the finished text.
+
+   The grammar is a canonical-shape check for output being generated, not a
+   validator: JSON that ajsb_validate accepts can still fall outside it, e.g.
+   an undeclared property on an object that declares some (without
+   "additionalProperties": false), or a key spelled with escapes
+   ("k\u0069nd"). Use ajsb_validate to decide whether a document is valid. */
+typedef struct ajsb_grammar_s ajsb_grammar_t;
+typedef struct ajsb_grammar_matcher_s ajsb_grammar_matcher_t;
+typedef struct ajsb_grammar_cache_s ajsb_grammar_cache_t;
+
+/* ── Compile ─────────────────────────────────────────────────────────────── */
+
+/* Compile schema into a grammar allocated from p. NULL if the schema does not
+   compile (see ajsb_compile). */
+ajsb_grammar_t *ajsb_to_grammar(aml_pool_t *p, ajson_t *schema);
+
+/* Same, from an already compiled program. */
+ajsb_grammar_t *ajsb_grammar_from_program(aml_pool_t *p, const ajsb_program_t *prog);
+
+/* GBNF text; the start rule is "root". */
+const char *ajsb_grammar_gbnf(const ajsb_grammar_t *g);
+
+size_t ajsb_grammar_num_rules(const ajsb_grammar_t *g);
+
+/* ── Matcher (canonical shape, not validity) ────────────────────────────── */
+
+/* The matcher grows its own stacks, so it is heap allocated; destroy it when
+   done. g must outlive it. */
+ajsb_grammar_matcher_t *ajsb_grammar_matcher_init(const ajsb_grammar_t *g);
+void ajsb_grammar_matcher_destroy(ajsb_grammar_matcher_t *m);
+void ajsb_grammar_matcher_reset(ajsb_grammar_matcher_t *m);
+
+/* Advance over len bytes. Returns false (and stays false until reset) once
+   the text can no longer be completed to a sentence of the grammar. */
+bool ajsb_grammar_matcher_push(ajsb_grammar_matcher_t *m, const char *data, size_t len);
+
+/* True if the bytes pushed so far form a complete sentence of the grammar:
+   a document in canonical shape. Not a validity check (see above). */
+bool ajsb_grammar_matcher_complete(const ajsb_grammar_matcher_t *m);
+
+/* Set bit b of allowed[b >> 3] for every byte b that keeps the text viable.
+   Intersect a tokenizer vocabulary with this to build a logit mask. */
+void ajsb_grammar_matcher_allowed(const ajsb_grammar_matcher_t *m, uint8_t allowed[32]);
+
+/* ── Cache ───────────────────────────────────────────────────────────────── */
+
+/* Grammars keyed by a hash of the schema text, so a schema that recurs across
+   requests is compiled once. Entries live until the cache is destroyed; the
+   cache is safe to share between threads. */
+ajsb_grammar_cache_t *ajsb_grammar_cache_init(void);
+void ajsb_grammar_cache_destroy(ajsb_grammar_cache_t *c);
+
+/* Returns the cached grammar for schema, compiling it on first use.
+   Compiling does not block other lookups; threads that miss on the same
+   schema at once may each compile it, and all get the grammar kept. */
+const ajsb_grammar_t *ajsb_grammar_cache_get(ajsb_grammar_cache_t *c, ajson_t *schema);
+
+size_t ajsb_grammar_cache_hits(const ajsb_grammar_cache_t *c);
+size_t ajsb_grammar_cache_misses(const ajsb_grammar_cache_t *c);    /* compilations */
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* A_JSON_SCHEMA_BUILDER_GRAMMAR_H */
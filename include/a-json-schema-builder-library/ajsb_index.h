@@ -0,0 +1,53 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#ifndef A_JSON_SCHEMA_BUILDER_INDEX_H
+#define A_JSON_SCHEMA_BUILDER_INDEX_H
+
+#include "a-json-library/ajson.h"
+#include "a-memory-library/aml_pool.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Indexed builder for wide schemas.
+
+   ajsb_prop/ajsb_defs_set find an existing name by scanning the member list,
+   and ajsb_prop_required appends to "required" without checking, so building
+   an object with n properties costs O(n^2). The functions below do the same
+   edits through a hash index kept beside the tree (allocated from the pool),
+   making insert, replace and required-dedup O(1).
+
+   Output is byte-identical to the plain builders: new names are appended in
+   call order and replacing a name keeps its position. The only difference is
+   that a name is never listed twice in "required".
+
+   An object's existing members are indexed the first time the index touches
+   it, so indexing can start part way through a build. After that, edit that
+   object's properties/required/$defs only through the index. */
+typedef struct ajsb_index_s ajsb_index_t;
+
+ajsb_index_t *ajsb_index_init(aml_pool_t *p);
+
+void ajsb_index_prop(ajsb_index_t *ix, ajson_t *obj, const char *name, ajson_t *schema);
+void ajsb_index_prop_required(ajsb_index_t *ix, ajson_t *obj, const char *name, ajson_t *schema);
+
+/* Add name to obj.required unless already listed. */
+void ajsb_index_required_add(ajsb_index_t *ix, ajson_t *obj, const char *name);
+
+/* Replace-or-add root_obj.$defs[name]. */
+void ajsb_index_defs_set(ajsb_index_t *ix, ajson_t *root_obj, const char *name, ajson_t *schema);
+
+/* obj.properties[name], or NULL. */
+ajson_t *ajsb_index_get_prop(ajsb_index_t *ix, ajson_t *obj, const char *name);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* A_JSON_SCHEMA_BUILDER_INDEX_H */
@@ -0,0 +1,76 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#ifndef A_JSON_SCHEMA_BUILDER_INSTRUMENT_H
+#define A_JSON_SCHEMA_BUILDER_INSTRUMENT_H
+
+#include "a-json-schema-builder-library/ajsb_validate.h"
+#include "a-memory-library/aml_buffer.h"
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Where validation and schema construction spend their time, for finding the
+   part of a schema behind a latency spike (a slow pattern, a huge enum, anyOf
+   branches retried through $ref).
+
+   Counting is compiled in only when the library is built with AJSB_INSTRUMENT
+   (cmake -DAJSB_INSTRUMENT=ON; GCC or Clang only). Otherwise the hooks are not there at all, the
+   functions below still link, ajsb_profile_init returns NULL and the dumps
+   append nothing and return false.
+
+     ajsb_profile_t *pr = ajsb_profile_init(prog, schema);
+     ... ajsb_validate(prog, instance) anywhere, on any thread ...
+     ajsb_profile_dump(bh, pr);
+     ajsb_profile_destroy(pr);
+
+   While a profile is attached, every interpreter run of one of prog's nodes
+   (ajsb_validate, ajsb_validate_batch, the decoder's fallback) counts, per
+   node: hits, failures, time spent in the node and below it ("ns"), time in
+   the node itself ("self_ns"), and for anyOf/oneOf the branches tried and
+   rejected ("backtracks"). "ns" counts a recursive node once per level it is
+   on the stack; "self_ns" adds up. The streaming validator is not counted. */
+
+typedef struct ajsb_profile_s ajsb_profile_t;
+
+/* True if the library was built with AJSB_INSTRUMENT. */
+bool ajsb_instrumented(void);
+
+/* Attach a profile to prog. schema, if given, must be what prog was compiled
+   from; nodes are then reported by JSON pointer ("#/properties/sku"), else by
+   node id only. NULL if not instrumented, if schema does not compile to the
+   same program, or if 8 profiles are already attached. */
+ajsb_profile_t *ajsb_profile_init(const ajsb_program_t *prog, ajson_t *schema);
+
+/* Detach and free. No validation of prog may be running. */
+void ajsb_profile_destroy(ajsb_profile_t *pr);
+
+void ajsb_profile_reset(ajsb_profile_t *pr);
+
+/* Appends
+     {"validations":N,"nodes":[{"path":"#/properties/sku","node":12,"hits":..,
+       "failures":..,"ns":..,"self_ns":..,"backtracks":..}, ...]}
+   with the nodes that were hit, highest self_ns first. "validations" counts
+   runs of the root node. */
+bool ajsb_profile_dump(aml_buffer_t *bh, const ajsb_profile_t *pr);
+
+/* Builder counters, process wide: per ajsb_* builder function the calls,
+   the JSON nodes it created and the pool bytes they took (nested builder
+   calls count towards the outermost one), and the highest pool usage seen
+   when a builder returned. Each thread counts on its own; the dump adds them
+   up.
+     {"peak_pool":N,"calls":[{"fn":"ajsb_prop_required","calls":..,
+       "nodes":..,"bytes":..}, ...]}
+   most bytes first. */
+bool ajsb_build_stats_dump(aml_buffer_t *bh);
+void ajsb_build_stats_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* A_JSON_SCHEMA_BUILDER_INSTRUMENT_H */
@@ -0,0 +1,67 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#ifndef A_JSON_SCHEMA_BUILDER_INTERN_H
+#define A_JSON_SCHEMA_BUILDER_INTERN_H
+
+#include "a-json-library/ajson.h"
+#include "a-memory-library/aml_pool.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ── Structural identity ─────────────────────────────────────────────────── */
+
+/* Hash of a JSON tree by content. Object members are hashed in order, so
+   {"a":1,"b":2} and {"b":2,"a":1} differ (the builders always emit keywords in
+   the same order). Stable across runs and platforms. */
+uint64_t ajsb_schema_hash(ajson_t *schema);
+
+/* Deep equality under the same rules as ajsb_schema_hash. */
+bool ajsb_schema_equal(ajson_t *a, ajson_t *b);
+
+/* ── Hash-consing ────────────────────────────────────────────────────────── */
+
+/* A table of canonical subtrees. ajsb_intern rewrites schema bottom-up so that
+   every subtree structurally equal to one seen before (in this call or an
+   earlier one) is replaced by that earlier node, and returns the canonical
+   node for schema itself.
+
+   Interned nodes are shared between parents: finish mutating a subtree before
+   interning it. The table only holds pointers; the nodes stay in whatever
+   pool they were built in, which must outlive the table. */
+typedef struct ajsb_intern_s ajsb_intern_t;
+
+ajsb_intern_t *ajsb_intern_init(void);
+void ajsb_intern_destroy(ajsb_intern_t *in);
+
+ajson_t *ajsb_intern(ajsb_intern_t *in, ajson_t *schema);
+
+/* Distinct subtrees held, and how many subtrees were replaced by one. */
+size_t ajsb_intern_count(const ajsb_intern_t *in);
+size_t ajsb_intern_shared(const ajsb_intern_t *in);
+
+/* ── $defs extraction ────────────────────────────────────────────────────── */
+
+/* Move subschemas that occur at least min_uses times under root into
+   root.$defs and replace each occurrence with a {"$ref":"#/$defs/<name>"}.
+   A subschema is only moved when that makes the serialized schema smaller;
+   one equal to an existing $defs entry is replaced by a ref to that entry.
+   Names come from the property the subschema first appears under ("address",
+   "address_2", ...). Subschemas carrying $id, $anchor or $dynamicAnchor stay
+   in place, as do subschemas an existing "$ref" or "$dynamicRef" resolves to
+   and those enclosing one, so references keep their targets. Returns the
+   number of occurrences replaced. */
+size_t ajsb_hoist_defs(aml_pool_t *p, ajson_t *root, size_t min_uses);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* A_JSON_SCHEMA_BUILDER_INTERN_H */
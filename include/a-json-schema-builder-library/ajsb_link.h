@@ -0,0 +1,84 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#ifndef A_JSON_SCHEMA_BUILDER_LINK_H
+#define A_JSON_SCHEMA_BUILDER_LINK_H
+
+#include "a-json-library/ajson.h"
+#include "a-memory-library/aml_pool.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Resolved reference graph.
+
+   ajsb_ref, ajsb_anchor, ajsb_set_id and friends only write strings. ajsb_link
+   walks a finished schema once, indexes every "$id" (schema resource),
+   "$anchor" and "$dynamicAnchor", and resolves every "$ref" and "$dynamicRef"
+   to the node it names, so consumers follow a reference with one hash lookup
+   instead of re-parsing pointers or searching for anchors.
+
+     ajsb_link_t *l = ajsb_link(p, schema);
+     if (!ajsb_link_ok(l)) report(l);
+     ajson_t *target = ajsb_link_ref(l, node);     // node has "$ref"
+
+   The schema is not modified: the references stay strings (so the text is
+   unchanged) and the resolution lives in the link, allocated from p. Changing
+   the schema afterwards invalidates the link.
+
+   Resolution follows 2020-12: "$id" values are resolved against the enclosing
+   base URI, "#/pointer" fragments are relative to the enclosing resource and
+   "#name" finds an "$anchor" or "$dynamicAnchor" in it. Only resources inside
+   this document are known; anything else is reported as unresolved. */
+typedef struct ajsb_link_s ajsb_link_t;
+
+ajsb_link_t *ajsb_link(aml_pool_t *p, ajson_t *root);
+
+/* Target of schema's "$ref" / "$dynamicRef", NULL if schema has none or it did
+   not resolve. The dynamic target is computed for the lexical scope (the
+   resources enclosing schema in this document): the outermost of them with a
+   matching "$dynamicAnchor" wins when the initial target has one too. */
+ajson_t *ajsb_link_ref(const ajsb_link_t *l, const ajson_t *schema);
+ajson_t *ajsb_link_dynamic_ref(const ajsb_link_t *l, const ajson_t *schema);
+
+/* "$dynamicRef" target for an explicit dynamic scope: the resources entered
+   while evaluating, outermost first (resource roots, as returned by
+   ajsb_link_resource). */
+ajson_t *ajsb_link_dynamic_scope(const ajsb_link_t *l, const ajson_t *schema,
+                                 const ajson_t *const *scope, size_t n);
+
+/* Resource root registered for an absolute URI (or the document root for "").
+   NULL if unknown. */
+ajson_t *ajsb_link_resource(const ajsb_link_t *l, const char *uri);
+
+/* ── Problems ──────────────────────────────────────────────────────────── */
+typedef struct {
+  const char *path;    /* JSON Pointer of the schema holding the reference */
+  const char *ref;     /* the reference as written */
+} ajsb_link_issue_t;
+
+/* References that did not resolve. */
+size_t ajsb_link_unresolved(const ajsb_link_t *l, const ajsb_link_issue_t **issues);
+
+/* References that lead back to themselves without descending into the
+   instance ({"$ref": "#"} at the root, a → b → a, "allOf": [{"$ref": "#"}]).
+   A validator following them would never terminate. Recursion through
+   properties or items is fine and is not reported. */
+size_t ajsb_link_cycles(const ajsb_link_t *l, const ajsb_link_issue_t **issues);
+
+/* Whether schema's "$ref" or "$dynamicRef" is one of the cycles above. */
+bool ajsb_link_cyclic(const ajsb_link_t *l, const ajson_t *schema);
+
+/* No unresolved references and no cycles. */
+bool ajsb_link_ok(const ajsb_link_t *l);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* A_JSON_SCHEMA_BUILDER_LINK_H */
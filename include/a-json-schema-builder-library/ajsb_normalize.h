@@ -0,0 +1,66 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#ifndef A_JSON_SCHEMA_BUILDER_NORMALIZE_H
+#define A_JSON_SCHEMA_BUILDER_NORMALIZE_H
+
+#include "a-json-library/ajson.h"
+#include "a-memory-library/aml_pool.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Schema normalization.
+
+   Schemas composed with the builders accumulate structure that validates the
+   same as something smaller: allOf inside allOf, anyOf/oneOf of one branch,
+   the same branch twice, repeated "required" names and enum values, $defs
+   nobody references. ajsb_normalize returns an equivalent schema without it:
+
+     - allOf members that are themselves only an allOf are spliced in; true,
+       {} and repeated members are dropped
+     - allOf members that do not conflict with their parent are merged into
+       it: keywords it lacks are added, "required" lists are joined and
+       "properties" with different names are combined. Members carrying
+       $id, $anchor, $dynamicAnchor, $schema or $defs, and keywords that only
+       mean something together (properties/patternProperties/
+       additionalProperties, prefixItems/items, if/then/else, contains/
+       minContains/maxContains) are left in the allOf when both sides use them
+     - nested anyOf-only members are spliced, repeated branches dropped, and an
+       anyOf with a true or {} branch removed
+     - an anyOf or oneOf of one branch becomes an allOf member, and an object
+       whose only keyword is an allOf of one member becomes that member
+     - "required" and "enum" lose repeats (enum numbers compare by value)
+     - root $defs entries that no reference in the document can reach are
+       removed
+
+   Applicator arrays that a JSON Pointer reference points into (or below) keep
+   their shape, so every "$ref" still resolves to an equivalent schema. $defs
+   are only removed when every reference in the document resolves (see
+   ajsb_link); references from other documents into this one's $defs are not
+   known, so keep such schemas out of the tree-shaking by not normalizing them.
+
+   schema is not modified: changed nodes are copied into p and unchanged
+   subtrees are shared with schema. Only subschema positions are rewritten;
+   enum, const, default and examples values are data and stay as written. */
+typedef struct {
+  size_t nodes_before;      /* JSON values in the tree */
+  size_t nodes_after;
+  size_t bytes_before;      /* compact serialized length */
+  size_t bytes_after;
+} ajsb_normalize_stats_t;
+
+/* The normalized schema; schema itself if nothing could be simplified.
+   stats may be NULL. */
+ajson_t *ajsb_normalize(aml_pool_t *p, ajson_t *schema, ajsb_normalize_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* A_JSON_SCHEMA_BUILDER_NORMALIZE_H */
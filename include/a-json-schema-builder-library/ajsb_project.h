@@ -0,0 +1,72 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#ifndef A_JSON_SCHEMA_BUILDER_PROJECT_H
+#define A_JSON_SCHEMA_BUILDER_PROJECT_H
+
+#include "a-json-library/ajson.h"
+#include "a-memory-library/aml_pool.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Path-projected validation: check only the parts of a large document a
+   caller is going to read.
+
+     static const char *const reads[] = {"/id", "/customer/email", "/items/0"};
+     ajsb_projection_t *pr = ajsb_projection_init(p, order_schema, 3, reads);
+     if (ajsb_project_validate(pr, p, text, len, NULL) == AJSB_PROJECT_OK) ...
+
+   Each pointer (RFC 6901; a "*" token matches every member or item) names
+   a value that is validated in full, exactly as ajsb_validate would. The
+   objects and arrays on the way to it are checked for what can be decided
+   without looking inside their other members: type, required,
+   additionalProperties: false, minItems and maxItems. An ancestor whose
+   schema uses anyOf, oneOf, not, uniqueItems or object/array enum members
+   is validated in full instead.
+
+   Everything else is skipped without being parsed. A scanner that tests
+   eight bytes at a time jumps between quotes and brackets. Skipped text is
+   only checked for balanced brackets and terminated strings, so
+   AJSB_PROJECT_OK means the projected values are valid and the document
+   is well formed around them. It does not mean the whole document is
+   valid. The pointer "" projects the whole document. */
+
+typedef struct ajsb_projection_s ajsb_projection_t;
+
+/* Compile schema (see ajsb_compile) and the n pointers into a projection
+   allocated from p. It is read-only afterwards and may be shared between
+   threads. Returns NULL if the schema does not compile or a pointer is not
+   "" or "/..." with only ~0 and ~1 escapes. */
+ajsb_projection_t *ajsb_projection_init(aml_pool_t *p, ajson_t *schema,
+                                        size_t n, const char *const *pointers);
+
+typedef enum {
+  AJSB_PROJECT_OK = 0,
+  AJSB_PROJECT_INVALID,      /* a projected value or its path breaks the schema */
+  AJSB_PROJECT_SYNTAX_ERROR  /* not JSON */
+} ajsb_project_status_t;
+
+typedef struct {
+  const char *why;           /* short description */
+  size_t      offset;        /* byte offset where it was detected */
+} ajsb_project_error_t;
+
+#define AJSB_PROJECT_MAX_DEPTH 256  /* deeper nesting is reported as invalid */
+
+/* Validate the projected paths of json[0..len). Fully validated values are
+   parsed into p. err may be NULL. */
+ajsb_project_status_t ajsb_project_validate(const ajsb_projection_t *pr, aml_pool_t *p,
+                                            const char *json, size_t len,
+                                            ajsb_project_error_t *err);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* A_JSON_SCHEMA_BUILDER_PROJECT_H */
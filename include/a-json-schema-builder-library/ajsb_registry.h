@@ -0,0 +1,135 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#ifndef A_JSON_SCHEMA_BUILDER_REGISTRY_H
+#define A_JSON_SCHEMA_BUILDER_REGISTRY_H
+
+#include "a-json-schema-builder-library/ajsb_validate.h"
+#include "a-json-library/ajson.h"
+#include "a-memory-library/aml_pool.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Schema registry shared by many threads.
+
+   A generation is an immutable set of schemas indexed by name and by root
+   "$id". It is filled by one thread and then published; from then on the
+   registry owns it and readers look schemas up without taking any lock.
+   Publishing the next generation (for example one loaded from disk after the
+   files changed) swaps a pointer: readers inside the old one keep using it
+   until they leave, and it is freed once none can still see it.
+
+     // writer
+     ajsb_registry_gen_t *g = ajsb_registry_gen_init();
+     ajsb_registry_gen_load_dir(g, "/etc/app/schemas");
+     ajsb_registry_publish(reg, g);
+
+     // each reader thread, once
+     ajsb_registry_reader_t *rd = ajsb_registry_reader_init(reg);
+     // per request
+     const ajsb_registry_gen_t *s = ajsb_registry_enter(rd);
+     const ajsb_registry_entry_t *e = ajsb_registry_get(s, "order");
+     bool ok = e && e->program && ajsb_validate(e->program, doc);
+     ajsb_registry_leave(rd);
+
+   Reclamation is epoch based: entering records the registry's epoch in the
+   reader's own slot (two atomic stores and a load, no shared writes), and a
+   retired generation is freed when every reader is idle or entered after it
+   was replaced. Readers never wait; the writer never waits either, it frees
+   what it can on each publish and leaves the rest for the next one.
+
+   Cross-schema references go through the generation. When it is published,
+   every "$ref" that its own document does not resolve is looked up among the
+   generation's resources by absolute URI (relative references are taken
+   against the document's root "$id"), and the resources found are embedded
+   under "$defs" of a bundled copy, keyed by URI and carrying their "$id", so
+   ajsb_link and ajsb_compile resolve them like any compound document. The
+   schemas added are not modified. */
+
+typedef struct ajsb_registry_s ajsb_registry_t;
+typedef struct ajsb_registry_gen_s ajsb_registry_gen_t;
+typedef struct ajsb_registry_reader_s ajsb_registry_reader_t;
+
+typedef struct {
+  const char           *name;
+  const char           *id;        /* root "$id", NULL if none */
+  ajson_t              *schema;    /* as added */
+  ajson_t              *bundled;   /* schema plus the registry resources it references */
+  const ajsb_program_t *program;   /* compiled from bundled; NULL if that failed */
+  bool                  resolved;  /* every reference in bundled resolves, no cycles */
+} ajsb_registry_entry_t;
+
+/* ── Building a generation (one thread) ────────────────────────────────── */
+
+ajsb_registry_gen_t *ajsb_registry_gen_init(void);
+
+/* Frees a generation that was never published. */
+void ajsb_registry_gen_destroy(ajsb_registry_gen_t *g);
+
+/* Pool owned by the generation; schemas built here live exactly as long. */
+aml_pool_t *ajsb_registry_gen_pool(ajsb_registry_gen_t *g);
+
+/* Adds schema under name (its root "$id" if name is NULL). schema must outlive
+   the generation (allocate it from ajsb_registry_gen_pool). False if there is
+   no name, or the name or "$id" is already taken. */
+bool ajsb_registry_gen_add(ajsb_registry_gen_t *g, const char *name, ajson_t *schema);
+
+/* Parses path into the generation's pool and adds it. */
+bool ajsb_registry_gen_add_file(ajsb_registry_gen_t *g, const char *name, const char *path);
+
+/* Adds every *.json in dir, named by file name without ".json". Returns the
+   number added, (size_t)-1 if dir cannot be read. */
+size_t ajsb_registry_gen_load_dir(ajsb_registry_gen_t *g, const char *dir);
+
+/* ── Registry (any thread) ─────────────────────────────────────────────── */
+
+ajsb_registry_t *ajsb_registry_init(void);
+
+/* Frees every generation and reader. No reader may be inside a generation. */
+void ajsb_registry_destroy(ajsb_registry_t *r);
+
+/* Bundles, links and compiles g, makes it the current generation and frees
+   retired generations no reader can see. The registry owns g afterwards.
+   Publishers are serialized with each other, never with readers. */
+bool ajsb_registry_publish(ajsb_registry_t *r, ajsb_registry_gen_t *g);
+
+/* Frees what can be freed now; returns the retired generations still held
+   by a reader. */
+size_t ajsb_registry_reclaim(ajsb_registry_t *r);
+
+/* ── Reading (lock-free) ───────────────────────────────────────────────── */
+
+/* One per thread; registration itself takes the publisher lock. */
+ajsb_registry_reader_t *ajsb_registry_reader_init(ajsb_registry_t *r);
+void ajsb_registry_reader_destroy(ajsb_registry_reader_t *rd);
+
+/* The current generation, valid until ajsb_registry_leave (NULL if nothing
+   was published yet). Calls do not nest. */
+const ajsb_registry_gen_t *ajsb_registry_enter(ajsb_registry_reader_t *rd);
+void ajsb_registry_leave(ajsb_registry_reader_t *rd);
+
+/* Number of the generation: 1 for the first published, then 2, ... */
+uint64_t ajsb_registry_generation(const ajsb_registry_gen_t *g);
+
+/* Entry by name, or else by root "$id". NULL if neither matches. */
+const ajsb_registry_entry_t *ajsb_registry_get(const ajsb_registry_gen_t *g, const char *key);
+
+size_t ajsb_registry_count(const ajsb_registry_gen_t *g);
+const ajsb_registry_entry_t *ajsb_registry_at(const ajsb_registry_gen_t *g, size_t i);
+
+/* Schema named by an absolute URI: a resource ("$id" anywhere in the
+   generation) with an optional "#/json/pointer" or "#anchor" fragment. */
+ajson_t *ajsb_registry_resolve(const ajsb_registry_gen_t *g, const char *uri);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* A_JSON_SCHEMA_BUILDER_REGISTRY_H */
@@ -0,0 +1,203 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#ifndef A_JSON_SCHEMA_BUILDER_STATIC_H
+#define A_JSON_SCHEMA_BUILDER_STATIC_H
+
+#include "a-json-schema-builder-library/ajsb_validate.h"
+#include "a-json-library/ajson.h"
+#include "a-memory-library/aml_pool.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Compile-time schemas.
+
+   The AJSB_S_* macros expand to a single string literal holding the same
+   compact JSON the runtime builders produce, so a static schema costs nothing
+   at startup and its text lives in .rodata:
+
+     #define USER_SCHEMA                                                   \
+       AJSB_S_OBJECT(                                                      \
+         AJSB_S_PROPS(                                                     \
+           AJSB_S_PROP("email", AJSB_S_STRING(AJSB_S_FORMAT("email"))),    \
+           AJSB_S_PROP("age",   AJSB_S_INTEGER(AJSB_S_MIN(0)))),           \
+         AJSB_S_REQUIRED("email"),                                         \
+         AJSB_S_ADDITIONAL(false))
+
+     static ajsb_static_t user_schema = AJSB_STATIC_INIT(USER_SCHEMA);
+
+   Schema macros take keyword macros in the order they should appear (the
+   order the matching ajsb_* calls would have been made). Lists (properties,
+   required, enum, anyOf …) take up to 64 items.
+
+   Strings are C string literals; the macros quote them with the
+   preprocessor, so write escapes the way JSON wants them ("a\"b", "\\d", "\n").
+   Numbers are written as the runtime's "%g" would print them (0, 1.5, -2,
+   1e+06). */
+
+/* ── Schemas ────────────────────────────────────────────────────────────── */
+#define AJSB_S_OBJECT(...)   "{\"type\":\"object\""  AJSB_S__CAT(__VA_ARGS__) "}"
+#define AJSB_S_STRING(...)   "{\"type\":\"string\""  AJSB_S__CAT(__VA_ARGS__) "}"
+#define AJSB_S_NUMBER(...)   "{\"type\":\"number\""  AJSB_S__CAT(__VA_ARGS__) "}"
+#define AJSB_S_INTEGER(...)  "{\"type\":\"integer\"" AJSB_S__CAT(__VA_ARGS__) "}"
+#define AJSB_S_BOOLEAN(...)  "{\"type\":\"boolean\"" AJSB_S__CAT(__VA_ARGS__) "}"
+#define AJSB_S_NULL(...)     "{\"type\":\"null\""    AJSB_S__CAT(__VA_ARGS__) "}"
+/* AJSB_S_ARRAY(items_schema, keywords…) */
+#define AJSB_S_ARRAY(...)    "{\"type\":\"array\",\"items\":" AJSB_S__CAT(__VA_ARGS__) "}"
+#define AJSB_S_REF(ref)          "{\"$ref\":" #ref "}"
+#define AJSB_S_DYNAMIC_REF(ref)  "{\"$dynamicRef\":" #ref "}"
+#define AJSB_S_ANY_OF(...)   "{\"anyOf\":[" AJSB_S__JOIN(__VA_ARGS__) "]}"
+#define AJSB_S_ONE_OF(...)   "{\"oneOf\":[" AJSB_S__JOIN(__VA_ARGS__) "]}"
+#define AJSB_S_ALL_OF(...)   "{\"allOf\":[" AJSB_S__JOIN(__VA_ARGS__) "]}"
+
+/* ── Keywords ───────────────────────────────────────────────────────────── */
+#define AJSB_S_PROPS(...)          ",\"properties\":{" AJSB_S__JOIN(__VA_ARGS__) "}"
+#define AJSB_S_PROP(name, schema)  #name ":" schema
+#define AJSB_S_REQUIRED(...)       ",\"required\":[" AJSB_S__QJOIN(__VA_ARGS__) "]"
+#define AJSB_S_ADDITIONAL(b)       ",\"additionalProperties\":" #b
+#define AJSB_S_DEFS(...)           ",\"$defs\":{" AJSB_S__JOIN(__VA_ARGS__) "}"
+#define AJSB_S_DEF(name, schema)   #name ":" schema
+
+#define AJSB_S_TITLE(s)            ",\"title\":" #s
+#define AJSB_S_DESCRIPTION(s)      ",\"description\":" #s
+#define AJSB_S_DEFAULT(s)          ",\"default\":" #s
+
+#define AJSB_S_FORMAT(s)           ",\"format\":" #s
+#define AJSB_S_PATTERN(s)          ",\"pattern\":" #s
+#define AJSB_S_ENUM(...)           ",\"enum\":[" AJSB_S__QJOIN(__VA_ARGS__) "]"
+
+#define AJSB_S_MIN(n)              ",\"minimum\":" #n
+#define AJSB_S_MAX(n)              ",\"maximum\":" #n
+#define AJSB_S_EXCL_MIN(n)         ",\"exclusiveMinimum\":" #n
+#define AJSB_S_EXCL_MAX(n)         ",\"exclusiveMaximum\":" #n
+
+#define AJSB_S_MIN_ITEMS(n)        ",\"minItems\":" #n
+#define AJSB_S_MAX_ITEMS(n)        ",\"maxItems\":" #n
+#define AJSB_S_UNIQUE(b)           ",\"uniqueItems\":" #b
+
+#define AJSB_S_ID(s)               ",\"$id\":" #s
+#define AJSB_S_SCHEMA(s)           ",\"$schema\":" #s
+#define AJSB_S_ANCHOR(s)           ",\"$anchor\":" #s
+#define AJSB_S_DYNAMIC_ANCHOR(s)   ",\"$dynamicAnchor\":" #s
+
+/* ── Runtime side ───────────────────────────────────────────────────────── */
+
+/* The program is compiled from the text on first use and kept for the life
+   of the process; afterwards ajsb_static_program is a single atomic load.
+   A text that fails to compile is remembered as failed and not retried. */
+typedef struct {
+  const char *json;
+  size_t      len;
+  const ajsb_program_t *prog;
+  bool        failed;
+} ajsb_static_t;
+
+#define AJSB_STATIC_INIT(text) { text, sizeof(text) - 1, NULL, false }
+
+/* Compiled program for s (NULL if the text is not a valid schema). Thread-safe. */
+const ajsb_program_t *ajsb_static_program(ajsb_static_t *s);
+
+static inline bool ajsb_static_validate(ajsb_static_t *s, ajson_t *instance) {
+  return ajsb_validate(ajsb_static_program(s), instance);
+}
+
+/* Parse the text into a tree in p, e.g. to extend it with the builders. */
+ajson_t *ajsb_static_parse(aml_pool_t *p, const ajsb_static_t *s);
+
+/* ── Internals ──────────────────────────────────────────────────────────── */
+#define AJSB_S__ID(x) x
+#define AJSB_S__Q(x)  #x
+#define AJSB_S__PASTE(a, b)  AJSB_S__PASTE_(a, b)
+#define AJSB_S__PASTE_(a, b) a##b
+#define AJSB_S__EACH(m, s, ...) \
+  AJSB_S__PASTE(AJSB_S__EACH_, AJSB_S__NARG(__VA_ARGS__))(m, s, __VA_ARGS__)
+#define AJSB_S__CAT(...)   AJSB_S__EACH(AJSB_S__ID, , __VA_ARGS__)
+#define AJSB_S__JOIN(...)  AJSB_S__EACH(AJSB_S__ID, ",", __VA_ARGS__)
+#define AJSB_S__QJOIN(...) AJSB_S__EACH(AJSB_S__Q, ",", __VA_ARGS__)
+
+#define AJSB_S__NARG(...) AJSB_S__NARG_(__VA_ARGS__, \
+  64,63,62,61,60,59,58,57,56,55,54,53,52,51,50,49, \
+  48,47,46,45,44,43,42,41,40,39,38,37,36,35,34,33, \
+  32,31,30,29,28,27,26,25,24,23,22,21,20,19,18,17, \
+  16,15,14,13,12,11,10,9,8,7,6,5,4,3,2,1,0)
+#define AJSB_S__NARG_( \
+  _1,_2,_3,_4,_5,_6,_7,_8,_9,_10,_11,_12,_13,_14,_15,_16, \
+  _17,_18,_19,_20,_21,_22,_23,_24,_25,_26,_27,_28,_29,_30,_31,_32, \
+  _33,_34,_35,_36,_37,_38,_39,_40,_41,_42,_43,_44,_45,_46,_47,_48, \
+  _49,_50,_51,_52,_53,_54,_55,_56,_57,_58,_59,_60,_61,_62,_63,_64, N, ...) N
+#define AJSB_S__EACH_1(m, s, x) m(x)
+#define AJSB_S__EACH_2(m, s, x, ...) m(x) s AJSB_S__EACH_1(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_3(m, s, x, ...) m(x) s AJSB_S__EACH_2(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_4(m, s, x, ...) m(x) s AJSB_S__EACH_3(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_5(m, s, x, ...) m(x) s AJSB_S__EACH_4(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_6(m, s, x, ...) m(x) s AJSB_S__EACH_5(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_7(m, s, x, ...) m(x) s AJSB_S__EACH_6(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_8(m, s, x, ...) m(x) s AJSB_S__EACH_7(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_9(m, s, x, ...) m(x) s AJSB_S__EACH_8(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_10(m, s, x, ...) m(x) s AJSB_S__EACH_9(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_11(m, s, x, ...) m(x) s AJSB_S__EACH_10(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_12(m, s, x, ...) m(x) s AJSB_S__EACH_11(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_13(m, s, x, ...) m(x) s AJSB_S__EACH_12(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_14(m, s, x, ...) m(x) s AJSB_S__EACH_13(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_15(m, s, x, ...) m(x) s AJSB_S__EACH_14(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_16(m, s, x, ...) m(x) s AJSB_S__EACH_15(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_17(m, s, x, ...) m(x) s AJSB_S__EACH_16(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_18(m, s, x, ...) m(x) s AJSB_S__EACH_17(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_19(m, s, x, ...) m(x) s AJSB_S__EACH_18(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_20(m, s, x, ...) m(x) s AJSB_S__EACH_19(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_21(m, s, x, ...) m(x) s AJSB_S__EACH_20(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_22(m, s, x, ...) m(x) s AJSB_S__EACH_21(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_23(m, s, x, ...) m(x) s AJSB_S__EACH_22(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_24(m, s, x, ...) m(x) s AJSB_S__EACH_23(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_25(m, s, x, ...) m(x) s AJSB_S__EACH_24(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_26(m, s, x, ...) m(x) s AJSB_S__EACH_25(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_27(m, s, x, ...) m(x) s AJSB_S__EACH_26(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_28(m, s, x, ...) m(x) s AJSB_S__EACH_27(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_29(m, s, x, ...) m(x) s AJSB_S__EACH_28(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_30(m, s, x, ...) m(x) s AJSB_S__EACH_29(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_31(m, s, x, ...) m(x) s AJSB_S__EACH_30(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_32(m, s, x, ...) m(x) s AJSB_S__EACH_31(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_33(m, s, x, ...) m(x) s AJSB_S__EACH_32(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_34(m, s, x, ...) m(x) s AJSB_S__EACH_33(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_35(m, s, x, ...) m(x) s AJSB_S__EACH_34(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_36(m, s, x, ...) m(x) s AJSB_S__EACH_35(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_37(m, s, x, ...) m(x) s AJSB_S__EACH_36(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_38(m, s, x, ...) m(x) s AJSB_S__EACH_37(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_39(m, s, x, ...) m(x) s AJSB_S__EACH_38(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_40(m, s, x, ...) m(x) s AJSB_S__EACH_39(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_41(m, s, x, ...) m(x) s AJSB_S__EACH_40(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_42(m, s, x, ...) m(x) s AJSB_S__EACH_41(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_43(m, s, x, ...) m(x) s AJSB_S__EACH_42(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_44(m, s, x, ...) m(x) s AJSB_S__EACH_43(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_45(m, s, x, ...) m(x) s AJSB_S__EACH_44(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_46(m, s, x, ...) m(x) s AJSB_S__EACH_45(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_47(m, s, x, ...) m(x) s AJSB_S__EACH_46(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_48(m, s, x, ...) m(x) s AJSB_S__EACH_47(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_49(m, s, x, ...) m(x) s AJSB_S__EACH_48(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_50(m, s, x, ...) m(x) s AJSB_S__EACH_49(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_51(m, s, x, ...) m(x) s AJSB_S__EACH_50(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_52(m, s, x, ...) m(x) s AJSB_S__EACH_51(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_53(m, s, x, ...) m(x) s AJSB_S__EACH_52(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_54(m, s, x, ...) m(x) s AJSB_S__EACH_53(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_55(m, s, x, ...) m(x) s AJSB_S__EACH_54(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_56(m, s, x, ...) m(x) s AJSB_S__EACH_55(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_57(m, s, x, ...) m(x) s AJSB_S__EACH_56(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_58(m, s, x, ...) m(x) s AJSB_S__EACH_57(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_59(m, s, x, ...) m(x) s AJSB_S__EACH_58(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_60(m, s, x, ...) m(x) s AJSB_S__EACH_59(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_61(m, s, x, ...) m(x) s AJSB_S__EACH_60(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_62(m, s, x, ...) m(x) s AJSB_S__EACH_61(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_63(m, s, x, ...) m(x) s AJSB_S__EACH_62(m, s, __VA_ARGS__)
+#define AJSB_S__EACH_64(m, s, x, ...) m(x) s AJSB_S__EACH_63(m, s, __VA_ARGS__)
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* A_JSON_SCHEMA_BUILDER_STATIC_H */
@@ -0,0 +1,69 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#ifndef A_JSON_SCHEMA_BUILDER_STREAM_H
+#define A_JSON_SCHEMA_BUILDER_STREAM_H
+
+#include "a-json-schema-builder-library/ajsb_validate.h"
+#include "a-memory-library/aml_pool.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Incremental validator for JSON text that arrives in pieces (e.g. LLM tokens).
+   Bytes are pushed as they arrive; no DOM is built. A small stack of schema
+   frames tracks where the text is, and the first violation is reported as soon
+   as it is certain, so generation can be cancelled early:
+
+     - a value of the wrong type (decided on its first byte)
+     - a property name no schema allows when additionalProperties is false
+       (decided on the first byte that matches no declared name)
+     - a string that can no longer become one of the enum values (enums of
+       more than 64 values are checked when it closes), or that fails its
+       format or pattern (decided when it closes)
+     - too many array items, numbers out of bounds, missing required properties
+
+   Constraints under anyOf/oneOf/not are only used for type checks, so the
+   stream never rejects text that ajsb_validate would accept. uniqueItems and
+   composite enum members are left to a full ajsb_validate pass. */
+typedef struct ajsb_stream_s ajsb_stream_t;
+
+typedef enum {
+  AJSB_STREAM_CONTINUE = 0,   /* no violation so far; more input expected */
+  AJSB_STREAM_COMPLETE,       /* a complete top-level value has been read */
+  AJSB_STREAM_INVALID,        /* the text can no longer satisfy the schema */
+  AJSB_STREAM_SYNTAX_ERROR    /* the text is not JSON */
+} ajsb_stream_status_t;
+
+#define AJSB_STREAM_MAX_DEPTH 64   /* deeper nesting is reported as invalid */
+
+/* Create a stream over prog, allocated from p. Returns NULL on bad input. */
+ajsb_stream_t *ajsb_stream_init(aml_pool_t *p, const ajsb_program_t *prog);
+
+/* Start over for a new document. */
+void ajsb_stream_reset(ajsb_stream_t *s);
+
+/* Feed the next chunk. Once INVALID or SYNTAX_ERROR is returned the stream is
+   stuck in that state until reset. Trailing whitespace after a complete value
+   is accepted. */
+ajsb_stream_status_t ajsb_stream_push(ajsb_stream_t *s, const char *data, size_t len);
+
+/* Signal end of input. A top-level number is completed here; anything else
+   that is still open is a SYNTAX_ERROR. */
+ajsb_stream_status_t ajsb_stream_finish(ajsb_stream_t *s);
+
+/* Short description of the failure (NULL while CONTINUE/COMPLETE) and the
+   number of bytes consumed when it was detected. */
+const char *ajsb_stream_error(const ajsb_stream_t *s);
+size_t      ajsb_stream_offset(const ajsb_stream_t *s);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* A_JSON_SCHEMA_BUILDER_STREAM_H */
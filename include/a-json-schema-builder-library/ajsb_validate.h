@@ -0,0 +1,57 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#ifndef A_JSON_SCHEMA_BUILDER_VALIDATE_H
+#define A_JSON_SCHEMA_BUILDER_VALIDATE_H
+
+#include "a-json-library/ajson.h"
+#include "a-memory-library/aml_pool.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* A schema lowered into a flat, read-only instruction program. Keywords are
+   resolved to opcodes, bounds are stored as doubles and subschemas are
+   referenced by offset, so validation never looks at keyword strings. */
+typedef struct ajsb_program_s ajsb_program_t;
+
+/* ── Compile ────────────────────────────────────────────────────────────── */
+/* Lower a finished schema into a program allocated from p. $ref and
+   $dynamicRef are resolved with ajsb_link ("#", "#/json/pointer", "#anchor"
+   and "$id"-relative URIs inside the document) and stored as offsets.
+   Returns NULL if a reference cannot be resolved or loops without descending
+   (see ajsb_link_cycles), or a subschema is not an object or boolean. The
+   schema may be modified or freed afterwards.
+
+   anyOf/oneOf whose branches all require one property pinned by const or
+   enum to values no other branch allows (a discriminator, such as "kind")
+   get a hash table from value to branch, so an object runs only the branch
+   it names. Other anyOf try the branches that have matched most often
+   first. */
+ajsb_program_t *ajsb_compile(aml_pool_t *p, ajson_t *schema);
+
+/* Number of instructions in the program (a rough size measure). */
+size_t ajsb_program_length(const ajsb_program_t *prog);
+
+/* ── Validate ───────────────────────────────────────────────────────────── */
+/* true if instance satisfies the compiled schema. The instructions are
+   never written (anyOf match counters are updated atomically beside them),
+   so one program may be shared by any number of threads.
+   Keywords handled: type, enum, const, minimum, maximum, exclusiveMinimum,
+   exclusiveMaximum, items, minItems, maxItems, uniqueItems, format (date,
+   time, date-time, email, uuid, ipv4), pattern, properties, required,
+   additionalProperties, anyOf, oneOf, allOf, not, $ref, $dynamicRef. Other
+   keywords, other formats and patterns outside the subset described in
+   ajsb_format.h are treated as annotations. */
+bool ajsb_validate(const ajsb_program_t *prog, ajson_t *instance);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* A_JSON_SCHEMA_BUILDER_VALIDATE_H */
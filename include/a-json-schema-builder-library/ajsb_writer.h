@@ -0,0 +1,121 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#ifndef A_JSON_SCHEMA_BUILDER_WRITER_H
+#define A_JSON_SCHEMA_BUILDER_WRITER_H
+
+#include "a-memory-library/aml_buffer.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Streaming schema emitter.
+
+   For a schema that is built once and sent, the ajson_t tree and the
+   ajsb_stringify pass are pure overhead. The writer mirrors the builder
+   helpers but emits JSON text directly, in call order, into an aml_buffer_t,
+   a callback or a file descriptor. No nodes are allocated.
+
+   A schema is opened by one of the type calls (or ref/anyOf/…), receives
+   keyword calls, and is closed by ajsb_writer_end. A property, $defs entry or
+   "items" is written by naming the slot and then opening the child schema:
+
+     ajsb_writer_object(w);
+       ajsb_writer_prop_required(w, "email");
+         ajsb_writer_string(w); ajsb_writer_string_format(w, "email");
+         ajsb_writer_end(w);
+       ajsb_writer_additional_properties(w, false);
+     ajsb_writer_end(w);
+
+   Names passed to ajsb_writer_prop_required are emitted as "required" right
+   after the properties block, which matches what ajsb_prop_required builds.
+   The properties and $defs of one schema must each be written contiguously.
+
+   Nesting is checked with a small stack. Any misuse (a keyword where a schema
+   is expected, a second "properties" block, too deep, a failed write) puts the
+   writer in an error state; later calls are ignored and finish returns false. */
+typedef struct ajsb_writer_s ajsb_writer_t;
+
+/* Receives output in chunks. Return false to abort. */
+typedef bool (*ajsb_writer_sink_cb)(void *arg, const char *data, size_t len);
+
+#define AJSB_WRITER_MAX_DEPTH 64
+
+/* Append to bh (not cleared, not owned). */
+ajsb_writer_t *ajsb_writer_init(aml_buffer_t *bh);
+/* Buffer internally and hand full chunks to cb. */
+ajsb_writer_t *ajsb_writer_init_sink(ajsb_writer_sink_cb cb, void *arg);
+/* write(2) to fd (not closed). */
+ajsb_writer_t *ajsb_writer_init_fd(int fd);
+
+/* Flush any buffered output. True if exactly one complete schema was written
+   without error. */
+bool ajsb_writer_finish(ajsb_writer_t *w);
+
+/* Ready the writer for another schema on the same output. */
+void ajsb_writer_reset(ajsb_writer_t *w);
+void ajsb_writer_destroy(ajsb_writer_t *w);
+
+/* Description of the first error, or NULL. */
+const char *ajsb_writer_error(const ajsb_writer_t *w);
+
+/* ── Open a schema (root, property, def, items or anyOf/oneOf/allOf member) ── */
+void ajsb_writer_object (ajsb_writer_t *w);   /* { "type": "object" …  */
+void ajsb_writer_array  (ajsb_writer_t *w);   /* { "type": "array" …   */
+void ajsb_writer_string (ajsb_writer_t *w);
+void ajsb_writer_number (ajsb_writer_t *w);
+void ajsb_writer_integer(ajsb_writer_t *w);
+void ajsb_writer_boolean(ajsb_writer_t *w);
+void ajsb_writer_null   (ajsb_writer_t *w);
+void ajsb_writer_ref        (ajsb_writer_t *w, const char *ref);  /* { "$ref": … */
+void ajsb_writer_dynamic_ref(ajsb_writer_t *w, const char *ref);
+void ajsb_writer_schema     (ajsb_writer_t *w);                   /* { …  (no type) */
+
+/* { "anyOf": [ … ] }: members follow, ajsb_writer_end closes the list. */
+void ajsb_writer_anyOf(ajsb_writer_t *w);
+void ajsb_writer_oneOf(ajsb_writer_t *w);
+void ajsb_writer_allOf(ajsb_writer_t *w);
+
+/* Close the innermost open schema or combinator. */
+void ajsb_writer_end(ajsb_writer_t *w);
+
+/* ── Slots: the next opened schema becomes their value ─────────────────── */
+void ajsb_writer_prop         (ajsb_writer_t *w, const char *name);
+void ajsb_writer_prop_required(ajsb_writer_t *w, const char *name);
+void ajsb_writer_def          (ajsb_writer_t *w, const char *name);   /* $defs */
+void ajsb_writer_items        (ajsb_writer_t *w);
+
+/* ── Keywords on the open schema ───────────────────────────────────────── */
+void ajsb_writer_required(ajsb_writer_t *w, size_t n, const char *const *names);
+void ajsb_writer_additional_properties(ajsb_writer_t *w, bool allowed);
+
+void ajsb_writer_title      (ajsb_writer_t *w, const char *title);
+void ajsb_writer_description(ajsb_writer_t *w, const char *description);
+void ajsb_writer_default_str(ajsb_writer_t *w, const char *def_val);
+
+void ajsb_writer_string_format (ajsb_writer_t *w, const char *format);
+void ajsb_writer_string_pattern(ajsb_writer_t *w, const char *regex);
+void ajsb_writer_string_enum   (ajsb_writer_t *w, size_t n, const char *const *values);
+
+void ajsb_writer_number_min(ajsb_writer_t *w, double min, bool exclusive);
+void ajsb_writer_number_max(ajsb_writer_t *w, double max, bool exclusive);
+
+void ajsb_writer_array_min_items(ajsb_writer_t *w, int min_items);
+void ajsb_writer_array_max_items(ajsb_writer_t *w, int max_items);
+void ajsb_writer_array_unique   (ajsb_writer_t *w, bool on);
+
+void ajsb_writer_set_id        (ajsb_writer_t *w, const char *uri);
+void ajsb_writer_set_schema    (ajsb_writer_t *w, const char *uri);
+void ajsb_writer_anchor        (ajsb_writer_t *w, const char *name);
+void ajsb_writer_dynamic_anchor(ajsb_writer_t *w, const char *name);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* A_JSON_SCHEMA_BUILDER_WRITER_H */
@@ -5,34 +5,136 @@
 // Maintainer: Andy Curtis <contactandyc@gmail.com>
 
 #include "a-json-schema-builder-library/ajsb.h"
+#include "a-json-schema-builder-library/ajsb_cache.h"
+#include "a-memory-library/aml_alloc.h"
+#include "ajsb_program.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+
+/* ── Shared nodes ───────────────────────────────────────────────────────── */
+/* Immutable nodes that live for the whole process: the "type" strings and
+   true/false that every builder call used to allocate, and the opt-in shared
+   leaf schemas built from them. */
+enum { T_OBJECT, T_ARRAY, T_STRING, T_NUMBER, T_INTEGER, T_BOOLEAN, T_NULL, T_COUNT };
+enum { S_LEAF = T_COUNT,               /* leaf schemas for T_STRING..T_NULL */
+       S_TRUE = S_LEAF + T_COUNT - T_STRING,
+       S_FALSE,
+       S_COUNT };
+
+static const char *const type_names[T_COUNT] = {
+  "object", "array", "string", "number", "integer", "boolean", "null"
+};
+
+static pthread_once_t shared_once = PTHREAD_ONCE_INIT;
+static aml_pool_t    *shared_pool = NULL;
+static ajson_t       *shared_nodes[S_COUNT];
+static uintptr_t      shared_lo, shared_hi;    /* bounds of shared_nodes */
+static bool           shared_ready;            /* atomic; set after the above */
+
+static void shared_init(void) {
+  shared_pool = aml_pool_init(1024);
+  for (int t = 0; t < T_COUNT; t++) shared_nodes[t] = ajson_str(shared_pool, type_names[t]);
+  for (int t = T_STRING; t < T_COUNT; t++) {
+    ajson_t *o = ajsono(shared_pool);
+    ajsono_set(o, "type", shared_nodes[t], /*copy_key=*/false);
+    shared_nodes[S_LEAF + t - T_STRING] = o;
+  }
+  shared_nodes[S_TRUE]  = ajson_true(shared_pool);
+  shared_nodes[S_FALSE] = ajson_false(shared_pool);
+  shared_lo = UINTPTR_MAX;
+  for (int i = 0; i < S_COUNT; i++) {
+    uintptr_t a = (uintptr_t)shared_nodes[i];
+    if (a < shared_lo) shared_lo = a;
+    if (a > shared_hi) shared_hi = a;
+  }
+  __atomic_store_n(&shared_ready, true, __ATOMIC_RELEASE);
+}
+
+/* AJSB_INSTRUMENT builds count each builder call (see ajsb_instrument.h):
+   BUILD opens a scope that records the call when the function returns, and
+   the constructors below are wrapped so every node made in it is counted.
+   Defined after shared_init so the process-wide nodes are not. */
+#ifdef AJSB_INSTRUMENT
+#ifndef __GNUC__
+#error "AJSB_INSTRUMENT needs GCC or Clang (__attribute__((cleanup)))"
+#endif
+#define BUILD(p) \
+  ajsb_build_scope_t build_scope_ __attribute__((cleanup(ajsb_build_leave))) = \
+    ajsb_build_enter(__func__, p)
+#define ajsono(p)                    ajsb_build_node(ajsono(p))
+#define ajsona(p)                    ajsb_build_node(ajsona(p))
+#define ajson_str(p, s)              ajsb_build_node(ajson_str(p, s))
+#define ajson_number(p, n)           ajsb_build_node(ajson_number(p, n))
+#define ajson_decimal_stringf(p, ...) ajsb_build_node(ajson_decimal_stringf(p, __VA_ARGS__))
+#else
+#define BUILD(p) (void)(p)
+#endif
+
+static inline ajson_t *shared(int i) {
+  pthread_once(&shared_once, shared_init);
+  return shared_nodes[i];
+}
+
+/* Nothing is shared before the first shared node is handed out, and the
+   shared nodes sit together in one small pool, so most nodes fail the range
+   check without a scan. */
+bool ajsb_is_shared(const ajson_t *j) {
+  if (!j || !__atomic_load_n(&shared_ready, __ATOMIC_ACQUIRE)) return false;
+  uintptr_t a = (uintptr_t)j;
+  if (a < shared_lo || a > shared_hi) return false;
+  for (int i = 0; i < S_COUNT; i++)
+    if (shared_nodes[i] == j) return true;
+  return false;
+}
 
-/* replace-if-exists, else append. Used internally for hardcoded schema keys. */
+/* A helper asked to change a shared node: the caller forgot ajsb_cow. Debug
+   builds stop here; release builds leave the node alone. */
+static inline bool read_only(const ajson_t *j) {
+  if (!ajsb_is_shared(j)) return false;
+  assert(!"shared nodes are read-only; ajsb_cow them first");
+  return true;
+}
+
+/* replace-if-exists, else append. Used internally for hardcoded schema keys.
+   Shared nodes are never modified. Every in-place change is reported with
+   ajsb_touch so cached serializations (ajsb_cache.h) notice it. */
 static inline void kv_set(ajson_t *obj, const char *k, ajson_t *v) {
+  if (read_only(obj)) return;
   ajsono_set(obj, k, v, /*copy_key=*/false);
+  ajsb_touch(obj);
+}
+
+static inline ajson_t *typed(aml_pool_t *p, int t) {
+  ajson_t *o = ajsono(p);
+  ajsono_set(o, "type", shared(t), /*copy_key=*/false);
+  return o;
 }
 
 /* ── Primitives ─────────────────────────────────────────────────────────── */
 
 ajson_t *ajsb_object(aml_pool_t *p) {
-  ajson_t *o = ajsono(p);
-  kv_set(o, "type", ajson_str(p, "object"));
-  return o;
+  BUILD(p);
+  return typed(p, T_OBJECT);
 }
 
 ajson_t *ajsb_array(aml_pool_t *p, ajson_t *items_schema) {
-  ajson_t *o = ajsono(p);
-  kv_set(o, "type",  ajson_str(p, "array"));
+  BUILD(p);
+  ajson_t *o = typed(p, T_ARRAY);
   if (items_schema) kv_set(o, "items", items_schema);
   return o;
 }
 
-ajson_t *ajsb_string (aml_pool_t *p){ ajson_t *o=ajsono(p); kv_set(o,"type", ajson_str(p,"string"));  return o; }
-ajson_t *ajsb_number (aml_pool_t *p){ ajson_t *o=ajsono(p); kv_set(o,"type", ajson_str(p,"number"));  return o; }
-ajson_t *ajsb_integer(aml_pool_t *p){ ajson_t *o=ajsono(p); kv_set(o,"type", ajson_str(p,"integer")); return o; }
-ajson_t *ajsb_boolean(aml_pool_t *p){ ajson_t *o=ajsono(p); kv_set(o,"type", ajson_str(p,"boolean")); return o; }
-ajson_t *ajsb_null   (aml_pool_t *p){ ajson_t *o=ajsono(p); kv_set(o,"type", ajson_str(p,"null"));    return o; }
+ajson_t *ajsb_string (aml_pool_t *p){ BUILD(p); return typed(p, T_STRING);  }
+ajson_t *ajsb_number (aml_pool_t *p){ BUILD(p); return typed(p, T_NUMBER);  }
+ajson_t *ajsb_integer(aml_pool_t *p){ BUILD(p); return typed(p, T_INTEGER); }
+ajson_t *ajsb_boolean(aml_pool_t *p){ BUILD(p); return typed(p, T_BOOLEAN); }
+ajson_t *ajsb_null   (aml_pool_t *p){ BUILD(p); return typed(p, T_NULL);    }
 
 ajson_t *ajsb_ref(aml_pool_t *p, const char *ref) {
+  BUILD(p);
   ajson_t *o = ajsono(p);
   if (ref && *ref) kv_set(o, "$ref", ajson_str(p, ref));
   return o;
@@ -41,7 +143,8 @@ ajson_t *ajsb_ref(aml_pool_t *p, const char *ref) {
 /* ── Object helpers ─────────────────────────────────────────────────────── */
 
 void ajsb_prop(aml_pool_t *p, ajson_t *obj, const char *name, ajson_t *schema) {
-  if (!p || !obj || !name || !*name || !schema) return;
+  BUILD(p);
+  if (!p || !obj || !name || !*name || !schema || read_only(obj)) return;
   ajson_t *props = ajsono_scan(obj, "properties");
   if (!props || !ajson_is_object(props)) {
     props = ajsono(p);
@@ -49,10 +152,12 @@ void ajsb_prop(aml_pool_t *p, ajson_t *obj, const char *name, ajson_t *schema) {
   }
   // FIX: User-provided 'name' MUST be copied into the pool.
   ajsono_set(props, name, schema, true);
+  ajsb_touch(props);
 }
 
 void ajsb_prop_required(aml_pool_t *p, ajson_t *obj, const char *name, ajson_t *schema) {
-  if (!p || !obj || !name || !*name || !schema) return;
+  BUILD(p);
+  if (!p || !obj || !name || !*name || !schema || read_only(obj)) return;
   ajsb_prop(p, obj, name, schema);
 
   // Auto-append to "required" array
@@ -62,9 +167,11 @@ void ajsb_prop_required(aml_pool_t *p, ajson_t *obj, const char *name, ajson_t *
       kv_set(obj, "required", req);
   }
   ajsona_append(req, ajson_str(p, name));
+  ajsb_touch(req);
 }
 
 void ajsb_required(aml_pool_t *p, ajson_t *obj, size_t n, const char *const *names) {
+  BUILD(p);
   if (!p || !obj) return;
   ajson_t *arr = ajsona(p);
   for (size_t i = 0; i < n; ++i) {
@@ -74,12 +181,14 @@ void ajsb_required(aml_pool_t *p, ajson_t *obj, size_t n, const char *const *nam
 }
 
 void ajsb_additional_properties(aml_pool_t *p, ajson_t *obj, bool allowed) {
+  BUILD(p);
   if (!p || !obj) return;
-  kv_set(obj, "additionalProperties", allowed ? ajson_true(p) : ajson_false(p));
+  kv_set(obj, "additionalProperties", shared(allowed ? S_TRUE : S_FALSE));
 }
 
 void ajsb_defs_add(aml_pool_t *p, ajson_t *root_obj, const char *name, ajson_t *schema) {
-  if (!p || !root_obj || !name || !*name || !schema) return;
+  BUILD(p);
+  if (!p || !root_obj || !name || !*name || !schema || read_only(root_obj)) return;
   ajson_t *defs = ajsono_scan(root_obj, "$defs");
   if (!defs || !ajson_is_object(defs)) {
     defs = ajsono(p);
@@ -87,50 +196,73 @@ void ajsb_defs_add(aml_pool_t *p, ajson_t *root_obj, const char *name, ajson_t *
   }
   // FIX: User-provided 'name' MUST be copied into the pool.
   ajsono_set(defs, name, schema, true);
+  ajsb_touch(defs);
 }
 
 /* ── Metadata helpers ───────────────────────────────────────────────────── */
 void ajsb_title(aml_pool_t *p, ajson_t *schema, const char *title) {
+  BUILD(p);
   if (schema && title) kv_set(schema, "title", ajson_str(p, title));
 }
 
 void ajsb_description(aml_pool_t *p, ajson_t *schema, const char *description) {
+  BUILD(p);
   if (schema && description) kv_set(schema, "description", ajson_str(p, description));
 }
 
 void ajsb_default_str(aml_pool_t *p, ajson_t *schema, const char *def_val) {
+  BUILD(p);
   if (schema && def_val) kv_set(schema, "default", ajson_str(p, def_val));
 }
 
 /* ── String helpers ─────────────────────────────────────────────────────── */
 
 void ajsb_string_format(aml_pool_t *p, ajson_t *str_schema, const char *format) {
+  BUILD(p);
   if (!p || !str_schema || !format || !*format) return;
   kv_set(str_schema, "format", ajson_str(p, format));
 }
 
 void ajsb_string_pattern(aml_pool_t *p, ajson_t *str_schema, const char *regex) {
+  BUILD(p);
   if (!p || !str_schema || !regex || !*regex) return;
   kv_set(str_schema, "pattern", ajson_str(p, regex));
 }
 
+/* Repeated values are dropped (the first stays), through a scratch table of
+   value indexes so large lists stay linear. */
 void ajsb_string_enum(aml_pool_t *p, ajson_t *str_schema, size_t n, const char *const *values) {
+  BUILD(p);
   if (!p || !str_schema) return;
   ajson_t *arr = ajsona(p);
-  for (size_t i = 0; i < n; ++i)
-    if (values && values[i] && *values[i]) ajsona_append(arr, ajson_str(p, values[i]));
+  size_t mask = 15;
+  while (mask + 1 < n * 2) mask = mask * 2 + 1;
+  size_t *seen = values && n ? (size_t *)aml_calloc(mask + 1, sizeof(size_t)) : NULL;
+  for (size_t i = 0; i < n; ++i) {
+    if (!values || !values[i] || !*values[i]) continue;
+    if (seen) {
+      size_t len = strlen(values[i]), k = ajsb_hash32(values[i], len) & mask;
+      while (seen[k] && strcmp(values[seen[k] - 1], values[i])) k = (k + 1) & mask;
+      if (seen[k]) continue;
+      seen[k] = i + 1;
+    }
+    ajsona_append(arr, ajson_str(p, values[i]));
+  }
+  aml_free(seen);
   kv_set(str_schema, "enum", arr);
 }
 
 /* ── Number / Integer helpers ───────────────────────────────────────────── */
 
 void ajsb_number_min(aml_pool_t *p, ajson_t *num_schema, double min, bool exclusive) {
+  BUILD(p);
   if (!p || !num_schema) return;
   kv_set(num_schema, exclusive ? "exclusiveMinimum" : "minimum",
          ajson_decimal_stringf(p, "%g", min));
 }
 
 void ajsb_number_max(aml_pool_t *p, ajson_t *num_schema, double max, bool exclusive) {
+  BUILD(p);
   if (!p || !num_schema) return;
   kv_set(num_schema, exclusive ? "exclusiveMaximum" : "maximum",
          ajson_decimal_stringf(p, "%g", max));
@@ -139,18 +271,21 @@ void ajsb_number_max(aml_pool_t *p, ajson_t *num_schema, double max, bool exclus
 /* ── Array helpers ──────────────────────────────────────────────────────── */
 
 void ajsb_array_min_items(aml_pool_t *p, ajson_t *arr_schema, int min_items) {
+  BUILD(p);
   if (!p || !arr_schema || min_items < 0) return;
   kv_set(arr_schema, "minItems", ajson_number(p, min_items));
 }
 
 void ajsb_array_max_items(aml_pool_t *p, ajson_t *arr_schema, int max_items) {
+  BUILD(p);
   if (!p || !arr_schema || max_items < 0) return;
   kv_set(arr_schema, "maxItems", ajson_number(p, max_items));
 }
 
 void ajsb_array_unique(aml_pool_t *p, ajson_t *arr_schema, bool on) {
+  BUILD(p);
   if (!p || !arr_schema) return;
-  kv_set(arr_schema, "uniqueItems", on ? ajson_true(p) : ajson_false(p));
+  kv_set(arr_schema, "uniqueItems", shared(on ? S_TRUE : S_FALSE));
 }
 
 /* ── Combinators ────────────────────────────────────────────────────────── */
@@ -164,14 +299,15 @@ static ajson_t *combine(aml_pool_t *p, const char *kw, size_t n, ajson_t *const
   return o;
 }
 
-ajson_t *ajsb_anyOf(aml_pool_t *p, size_t n, ajson_t *const *schemas) { return combine(p, "anyOf", n, schemas); }
-ajson_t *ajsb_oneOf(aml_pool_t *p, size_t n, ajson_t *const *schemas) { return combine(p, "oneOf", n, schemas); }
-ajson_t *ajsb_allOf(aml_pool_t *p, size_t n, ajson_t *const *schemas) { return combine(p, "allOf", n, schemas); }
+ajson_t *ajsb_anyOf(aml_pool_t *p, size_t n, ajson_t *const *schemas) { BUILD(p); return combine(p, "anyOf", n, schemas); }
+ajson_t *ajsb_oneOf(aml_pool_t *p, size_t n, ajson_t *const *schemas) { BUILD(p); return combine(p, "oneOf", n, schemas); }
+ajson_t *ajsb_allOf(aml_pool_t *p, size_t n, ajson_t *const *schemas) { BUILD(p); return combine(p, "allOf", n, schemas); }
 
 /* ── Refs / IDs helpers (implementations) ───────────────────────────────── */
 
 ajson_t *ajsb_defs_ensure(aml_pool_t *p, ajson_t *root_obj) {
-  if (!p || !root_obj) return NULL;
+  BUILD(p);
+  if (!p || !root_obj || read_only(root_obj)) return NULL;
   ajson_t *defs = ajsono_scan(root_obj, "$defs");
   if (!defs || !ajson_is_object(defs)) {
     defs = ajsono(p);
@@ -181,34 +317,62 @@ ajson_t *ajsb_defs_ensure(aml_pool_t *p, ajson_t *root_obj) {
 }
 
 void ajsb_defs_set(aml_pool_t *p, ajson_t *root_obj, const char *name, ajson_t *schema) {
+  BUILD(p);
   if (!p || !root_obj || !name || !*name || !schema) return;
   ajson_t *defs = ajsb_defs_ensure(p, root_obj);
+  if (!defs) return;
   // FIX: User-provided 'name' MUST be copied into the pool.
   ajsono_set(defs, name, schema, /*copy_key=*/true);  /* replace-or-add */
+  ajsb_touch(defs);
 }
 
 void ajsb_set_id(aml_pool_t *p, ajson_t *schema, const char *uri) {
+  BUILD(p);
   if (!p || !schema || !uri || !*uri) return;
   kv_set(schema, "$id", ajson_str(p, uri));
 }
 
 void ajsb_set_schema(aml_pool_t *p, ajson_t *schema, const char *uri) {
+  BUILD(p);
   if (!p || !schema || !uri || !*uri) return;
   kv_set(schema, "$schema", ajson_str(p, uri));
 }
 
 void ajsb_anchor(aml_pool_t *p, ajson_t *schema, const char *name) {
+  BUILD(p);
   if (!p || !schema || !name || !*name) return;
   kv_set(schema, "$anchor", ajson_str(p, name));
 }
 
 void ajsb_dynamic_anchor(aml_pool_t *p, ajson_t *schema, const char *name) {
+  BUILD(p);
   if (!p || !schema || !name || !*name) return;
   kv_set(schema, "$dynamicAnchor", ajson_str(p, name));
 }
 
 ajson_t *ajsb_dynamic_ref(aml_pool_t *p, const char *ref) {
+  BUILD(p);
   ajson_t *o = ajsono(p);
   if (ref && *ref) kv_set(o, "$dynamicRef", ajson_str(p, ref));
   return o;
 }
+
+/* ── Shared leaves ──────────────────────────────────────────────────────── */
+
+ajson_t *ajsb_shared_string (void) { return shared(S_LEAF + T_STRING  - T_STRING); }
+ajson_t *ajsb_shared_number (void) { return shared(S_LEAF + T_NUMBER  - T_STRING); }
+ajson_t *ajsb_shared_integer(void) { return shared(S_LEAF + T_INTEGER - T_STRING); }
+ajson_t *ajsb_shared_boolean(void) { return shared(S_LEAF + T_BOOLEAN - T_STRING); }
+ajson_t *ajsb_shared_null   (void) { return shared(S_LEAF + T_NULL    - T_STRING); }
+ajson_t *ajsb_shared_true   (void) { return shared(S_TRUE);  }
+ajson_t *ajsb_shared_false  (void) { return shared(S_FALSE); }
+
+ajson_t *ajsb_cow(aml_pool_t *p, ajson_t *schema) {
+  BUILD(p);
+  if (!p || !ajsb_is_shared(schema) || !ajson_is_object(schema)) return schema;
+  /* members of shared leaves are shared scalars, so a shallow copy suffices */
+  ajson_t *o = ajsono(p);
+  for (ajsono_t *m = ajsono_first(schema); m; m = ajsono_next(m))
+    ajsono_append(o, m->key, m->value, /*copy_key=*/false);
+  return o;
+}
@@ -0,0 +1,209 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#include "a-json-schema-builder-library/ajsb_batch.h"
+#include "a-json-library/ajson.h"
+#include "a-memory-library/aml_alloc.h"
+#include "a-memory-library/aml_pool.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define DEFAULT_CHUNK (1u << 20)
+
+/* Per-chunk tallies; merged in chunk order once every worker is done. */
+typedef struct {
+  size_t   lines, valid, invalid, parse_errors, blank;
+  uint8_t *status;
+  size_t   cap;
+} chunk_t;
+
+typedef struct {
+  const ajsb_program_t *prog;
+  const char           *data;
+  size_t                len, chunk_size, num_chunks;
+  chunk_t              *chunks;
+  size_t                next;       /* next unclaimed chunk (atomic) */
+  bool                  statuses;
+  bool                  failed;     /* atomic */
+} batch_t;
+
+/* First line that starts at or after chunk i's nominal offset. */
+static const char *chunk_begin(const batch_t *b, size_t i) {
+  size_t at = i * b->chunk_size;
+  if (!i) return b->data;
+  if (at >= b->len) return b->data + b->len;
+  const char *nl = (const char *)memchr(b->data + at - 1, '\n', b->len - at + 1);
+  return nl ? nl + 1 : b->data + b->len;
+}
+
+static bool is_space(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static uint8_t check(const batch_t *b, aml_pool_t *pool, const char *s, const char *e) {
+  while (s < e && is_space(*s)) s++;
+  while (e > s && is_space(e[-1])) e--;
+  if (s == e) return AJSB_BATCH_BLANK;
+  /* the parser works in place and the input may be a read-only mapping */
+  char *t = aml_pool_strndup(pool, s, (size_t)(e - s));
+  ajson_t *j = ajson_parse(pool, t, t + (e - s));
+  uint8_t st;
+  if (!j || ajson_is_error(j)) st = AJSB_BATCH_PARSE_ERROR;
+  else st = ajsb_validate(b->prog, j) ? AJSB_BATCH_VALID : AJSB_BATCH_INVALID;
+  aml_pool_clear(pool);
+  return st;
+}
+
+static bool record(chunk_t *c, bool statuses, uint8_t st) {
+  if (statuses) {
+    if (c->lines == c->cap) {
+      size_t n = c->cap ? c->cap * 2 : 1024;
+      uint8_t *r = (uint8_t *)aml_realloc(c->status, n);
+      if (!r) return false;
+      c->status = r;
+      c->cap = n;
+    }
+    c->status[c->lines] = st;
+  }
+  c->lines++;
+  switch (st) {
+    case AJSB_BATCH_VALID:       c->valid++;        break;
+    case AJSB_BATCH_INVALID:     c->invalid++;      break;
+    case AJSB_BATCH_PARSE_ERROR: c->parse_errors++; break;
+    default:                     c->blank++;        break;
+  }
+  return true;
+}
+
+static void run_chunk(batch_t *b, size_t i, aml_pool_t *pool) {
+  chunk_t *c = b->chunks + i;
+  const char *s = chunk_begin(b, i), *end = chunk_begin(b, i + 1);
+  while (s < end) {
+    const char *nl = (const char *)memchr(s, '\n', (size_t)(end - s));
+    const char *e = nl ? nl : end;
+    if (!record(c, b->statuses, check(b, pool, s, e))) {
+      __atomic_store_n(&b->failed, true, __ATOMIC_RELAXED);
+      return;
+    }
+    s = e + (nl != NULL);
+  }
+}
+
+static void *worker(void *arg) {
+  batch_t *b = (batch_t *)arg;
+  aml_pool_t *pool = aml_pool_init(16384);
+  for (;;) {
+    size_t i = __atomic_fetch_add(&b->next, 1, __ATOMIC_RELAXED);
+    if (i >= b->num_chunks || __atomic_load_n(&b->failed, __ATOMIC_RELAXED)) break;
+    run_chunk(b, i, pool);
+  }
+  aml_pool_destroy(pool);
+  return NULL;
+}
+
+static int default_threads(void) {
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  return n > 0 ? (int)n : 1;
+}
+
+static bool merge(batch_t *b, ajsb_batch_result_t *res) {
+  for (size_t i = 0; i < b->num_chunks; i++) {
+    chunk_t *c = b->chunks + i;
+    res->lines        += c->lines;
+    res->valid        += c->valid;
+    res->invalid      += c->invalid;
+    res->parse_errors += c->parse_errors;
+    res->blank        += c->blank;
+  }
+  if (!b->statuses) return true;
+  res->status = (uint8_t *)aml_malloc(res->lines ? res->lines : 1);
+  if (!res->status) return false;
+  size_t at = 0;
+  for (size_t i = 0; i < b->num_chunks; i++) {
+    if (b->chunks[i].lines) memcpy(res->status + at, b->chunks[i].status, b->chunks[i].lines);
+    at += b->chunks[i].lines;
+  }
+  return true;
+}
+
+/* ── Public API ─────────────────────────────────────────────────────────── */
+
+bool ajsb_validate_batch(const ajsb_program_t *prog, const char *data, size_t len,
+                         const ajsb_batch_options_t *opts, ajsb_batch_result_t *res) {
+  if (!res) return false;
+  memset(res, 0, sizeof(*res));
+  if (!prog || (!data && len)) return false;
+
+  batch_t b;
+  memset(&b, 0, sizeof(b));
+  b.prog = prog;
+  b.data = data;
+  b.len = len;
+  b.chunk_size = opts && opts->chunk_size ? opts->chunk_size : DEFAULT_CHUNK;
+  b.num_chunks = (len + b.chunk_size - 1) / b.chunk_size;
+  b.statuses = opts && opts->statuses;
+  if (!b.num_chunks) {
+    if (b.statuses) res->status = (uint8_t *)aml_malloc(1);
+    return !b.statuses || res->status;
+  }
+  b.chunks = (chunk_t *)aml_calloc(b.num_chunks, sizeof(chunk_t));
+  if (!b.chunks) return false;
+
+  size_t threads = (size_t)(opts && opts->threads > 0 ? opts->threads : default_threads());
+  if (threads > b.num_chunks) threads = b.num_chunks;
+
+  /* the calling thread is one of the workers */
+  pthread_t *tids = threads > 1 ? (pthread_t *)aml_calloc(threads - 1, sizeof(pthread_t)) : NULL;
+  size_t started = 0;
+  for (; tids && started < threads - 1; started++)
+    if (pthread_create(tids + started, NULL, worker, &b)) break;
+  worker(&b);
+  for (size_t i = 0; i < started; i++) pthread_join(tids[i], NULL);
+  aml_free(tids);
+
+  bool ok = !b.failed && merge(&b, res);
+  for (size_t i = 0; i < b.num_chunks; i++) aml_free(b.chunks[i].status);
+  aml_free(b.chunks);
+  if (!ok) {
+    aml_free(res->status);
+    memset(res, 0, sizeof(*res));
+  }
+  return ok;
+}
+
+bool ajsb_validate_batch_file(const ajsb_program_t *prog, const char *path,
+                              const ajsb_batch_options_t *opts, ajsb_batch_result_t *res) {
+  if (res) memset(res, 0, sizeof(*res));
+  if (!path) return false;
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) return false;
+  struct stat st;
+  if (fstat(fd, &st)) {
+    close(fd);
+    return false;
+  }
+  size_t len = (size_t)st.st_size;
+  void *m = len ? mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0) : NULL;
+  close(fd);
+  if (m == MAP_FAILED) return false;
+#ifdef MADV_SEQUENTIAL
+  if (m) madvise(m, len, MADV_SEQUENTIAL);
+#endif
+  bool ok = ajsb_validate_batch(prog, (const char *)m, len, opts, res);
+  if (m) munmap(m, len);
+  return ok;
+}
+
+void ajsb_batch_result_destroy(ajsb_batch_result_t *res) {
+  if (!res) return;
+  aml_free(res->status);
+  res->status = NULL;
+}
@@ -0,0 +1,432 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#include "a-json-schema-builder-library/ajsb_cache.h"
+#include "ajsb_program.h"
+#include "a-memory-library/aml_alloc.h"
+#include "a-memory-library/aml_buffer.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+
+/* Each stringify writes a new generation buffer. Unchanged subtrees are
+   copied from whichever older generation holds their bytes, and their
+   entries then point into the new one; entries inside them keep pointing at
+   the older buffer, which stays alive while anything refers to it. When the
+   older buffers outgrow the output, the next stringify starts afresh.
+
+   ajsb_touch never takes a lock. It first checks a counting filter of the
+   nodes any cache holds (one counter per address hash, kept by the caches
+   as they add and drop entries), so touches on trees no cache has seen
+   return after a load. A node that may be held is appended to a global
+   ring (one atomic add for the slot, a sequence number per slot so a reader
+   can tell a slot was reused). Each cache remembers how far it has read and
+   replays the new touches at its next stringify or fingerprint, dropping
+   only the nodes it holds. A cache that fell more than a ring behind
+   starts afresh. */
+
+typedef struct gen_s {
+  aml_buffer_t *bh;
+  size_t        refs;               /* entries pointing into bh */
+  struct gen_s *next;               /* older generations still referenced */
+} gen_t;
+
+/* A cached object or array. parents are the containers it was emitted
+   under, for passing a touch upwards; many marks a node seen under more
+   than fit, which a touch handles by dropping everything. */
+typedef struct {
+  ajson_t  *node;                   /* NULL: empty slot */
+  gen_t    *gen;
+  size_t    off;
+  size_t    len;
+  uint64_t  fp;
+  ajson_t  *parents[2];
+  bool      many;
+} entry_t;
+
+struct ajsb_cache_s {
+  pthread_mutex_t       lock;
+  entry_t              *tab;
+  size_t                mask;
+  size_t                count;
+  gen_t                *cur;        /* last output */
+  gen_t                *old;
+  size_t                old_bytes;
+  uint64_t              seen;       /* touches replayed so far */
+};
+
+enum { LOG_SIZE = 1 << 14, HELD_SIZE = 1 << 17 };
+
+typedef struct {
+  uint64_t  seq;                    /* touch number + 1 once node is written */
+  ajson_t  *node;
+} touch_t;
+
+static touch_t   touch_log[LOG_SIZE];
+static uint64_t  touch_head;
+static uint32_t  num_live;
+static uint32_t  held[HELD_SIZE];   /* entries, across caches, per address hash */
+
+/* ── Fingerprints ───────────────────────────────────────────────────────── */
+
+enum { FP_OBJECT = 0x6f626a, FP_ARRAY = 0x617272, FP_STRING = 0x737472, FP_OTHER = 0x6c6974 };
+
+static inline uint64_t mix(uint64_t h) {
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdull;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ull;
+  h ^= h >> 33;
+  return h;
+}
+
+static inline uint64_t fold(uint64_t h, uint64_t v) {
+  return mix(h ^ v) + 0x9e3779b97f4a7c15ull;
+}
+
+/* Over the serialized text: raw string contents, number text, literals. */
+static uint64_t scalar_fp(ajson_t *j) {
+  const char *s;
+  uint64_t tag = FP_OTHER;
+  if (ajson_is_string(j))     { s = ajson_to_str(j, ""); tag = FP_STRING; }
+  else if (ajson_is_true(j))  s = "true";
+  else if (ajson_is_false(j)) s = "false";
+  else if (ajson_is_null(j))  s = "null";
+  else                        s = ajson_to_str(j, "");
+  return fold(tag, ajsb_hash64(s, strlen(s)));
+}
+
+static inline uint64_t finish(uint64_t h) {
+  return h ? h : 1;
+}
+
+/* ── Entry table (node address → entry, linear probing) ────────────────── */
+
+static inline size_t ptr_hash(const void *v) {
+  uintptr_t x = (uintptr_t)v;
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  return (size_t)x;
+}
+
+static inline uint32_t *held_at(const ajson_t *node) {
+  return held + (ptr_hash(node) & (HELD_SIZE - 1));
+}
+
+static entry_t *find(ajsb_cache_t *c, const ajson_t *node) {
+  for (size_t i = ptr_hash(node) & c->mask; c->tab[i].node; i = (i + 1) & c->mask)
+    if (c->tab[i].node == node) return c->tab + i;
+  return NULL;
+}
+
+static void gen_free(gen_t *g) {
+  aml_buffer_destroy(g->bh);
+  aml_free(g);
+}
+
+/* Drop a reference to g; an older generation nobody points into is freed. */
+static void gen_release(ajsb_cache_t *c, gen_t *g) {
+  if (--g->refs || g == c->cur) return;
+  for (gen_t **pp = &c->old; *pp; pp = &(*pp)->next) {
+    if (*pp != g) continue;
+    *pp = g->next;
+    c->old_bytes -= aml_buffer_length(g->bh);
+    gen_free(g);
+    return;
+  }
+}
+
+static void remove_at(ajsb_cache_t *c, size_t i) {
+  __atomic_sub_fetch(held_at(c->tab[i].node), 1, __ATOMIC_RELAXED);
+  gen_release(c, c->tab[i].gen);
+  c->count--;
+  for (size_t j = i;;) {
+    c->tab[i].node = NULL;
+    for (;;) {
+      j = (j + 1) & c->mask;
+      if (!c->tab[j].node) return;
+      size_t k = ptr_hash(c->tab[j].node) & c->mask;
+      /* move j back unless its home lies cyclically in (i, j] */
+      if (i <= j ? (k <= i || k > j) : (k <= i && k > j)) break;
+    }
+    c->tab[i] = c->tab[j];
+    i = j;
+  }
+}
+
+static bool grow(ajsb_cache_t *c) {
+  if ((c->count + 1) * 2 <= c->mask + 1) return true;
+  size_t size = (c->mask + 1) * 2;
+  entry_t *t = (entry_t *)aml_calloc(size, sizeof(entry_t));
+  if (!t) return false;
+  for (size_t i = 0; i <= c->mask; i++) {
+    if (!c->tab[i].node) continue;
+    size_t j = ptr_hash(c->tab[i].node) & (size - 1);
+    while (t[j].node) j = (j + 1) & (size - 1);
+    t[j] = c->tab[i];
+  }
+  aml_free(c->tab);
+  c->tab = t;
+  c->mask = size - 1;
+  return true;
+}
+
+static void add_parent(entry_t *e, ajson_t *parent) {
+  if (!parent || e->parents[0] == parent || e->parents[1] == parent) return;
+  if (!e->parents[0])      e->parents[0] = parent;
+  else if (!e->parents[1]) e->parents[1] = parent;
+  else                     e->many = true;
+}
+
+static void clear_all(ajsb_cache_t *c) {
+  for (size_t i = 0; i <= c->mask; i++) {
+    if (!c->tab[i].node) continue;
+    __atomic_sub_fetch(held_at(c->tab[i].node), 1, __ATOMIC_RELAXED);
+    c->tab[i].node = NULL;
+    c->tab[i].gen->refs--;
+  }
+  c->count = 0;
+  while (c->old) {
+    gen_t *g = c->old;
+    c->old = g->next;
+    gen_free(g);
+  }
+  c->old_bytes = 0;
+}
+
+static void drop(ajsb_cache_t *c, ajson_t *node) {
+  entry_t *e = find(c, node);
+  if (!e) return;
+  if (e->many) {
+    clear_all(c);
+    return;
+  }
+  ajson_t *p0 = e->parents[0], *p1 = e->parents[1];
+  remove_at(c, (size_t)(e - c->tab));
+  if (p0) drop(c, p0);
+  if (p1) drop(c, p1);
+}
+
+/* A slot still being written is a touch racing with this stringify, so not
+   one of this tree's (the caller orders those before it); it is replayed
+   again next time, along with everything after it. */
+static bool replay(ajsb_cache_t *c, uint64_t head) {
+  if (head - c->seen > LOG_SIZE) return false;
+  uint64_t resume = head;
+  for (uint64_t i = c->seen; i != head; i++) {
+    touch_t *t = touch_log + (i & (LOG_SIZE - 1));
+    uint64_t seq = __atomic_load_n(&t->seq, __ATOMIC_ACQUIRE);
+    if (seq > i + 1) return false;
+    if (seq < i + 1) {
+      if (resume == head) resume = i;
+      continue;
+    }
+    ajson_t *node = __atomic_load_n(&t->node, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&t->seq, __ATOMIC_RELAXED) != seq) return false;
+    drop(c, node);
+  }
+  c->seen = resume;
+  return true;
+}
+
+static void catch_up(ajsb_cache_t *c) {
+  uint64_t head = __atomic_load_n(&touch_head, __ATOMIC_ACQUIRE);
+  if (replay(c, head)) return;
+  clear_all(c);
+  c->seen = head;
+}
+
+/* ── Emitting ───────────────────────────────────────────────────────────── */
+
+static void copy_bytes(aml_buffer_t *bh, const gen_t *from, size_t off, size_t len) {
+  if (from->bh != bh) {
+    aml_buffer_append(bh, aml_buffer_data(from->bh) + off, len);
+    return;
+  }
+  /* a node met twice in this pass: appending may move the source */
+  char *tmp = (char *)aml_malloc(len ? len : 1);
+  memcpy(tmp, aml_buffer_data(bh) + off, len);
+  aml_buffer_append(bh, tmp, len);
+  aml_free(tmp);
+}
+
+static uint64_t emit(ajsb_cache_t *c, gen_t *g, ajson_t *j, ajson_t *parent) {
+  aml_buffer_t *bh = g->bh;
+  if (!ajson_is_object(j) && !ajson_is_array(j)) {
+    ajson_dump_to_buffer(bh, j);
+    return scalar_fp(j);
+  }
+
+  size_t start = aml_buffer_length(bh);
+  entry_t *e = find(c, j);
+  if (e) {
+    copy_bytes(bh, e->gen, e->off, e->len);
+    if (e->gen != g) {
+      gen_t *was = e->gen;
+      e->gen = g;
+      e->off = start;
+      g->refs++;
+      gen_release(c, was);
+    }
+    add_parent(e, parent);
+    return e->fp;
+  }
+
+  uint64_t h;
+  if (ajson_is_object(j)) {
+    h = FP_OBJECT;
+    aml_buffer_appendc(bh, '{');
+    for (ajsono_t *m = ajsono_first(j); m; m = ajsono_next(m)) {
+      if (m != ajsono_first(j)) aml_buffer_appendc(bh, ',');
+      aml_buffer_appendc(bh, '"');
+      aml_buffer_appends(bh, m->key);
+      aml_buffer_appends(bh, "\":");
+      h = fold(h, ajsb_hash64(m->key, strlen(m->key)));
+      h = fold(h, emit(c, g, m->value, j));
+    }
+    aml_buffer_appendc(bh, '}');
+  } else {
+    h = FP_ARRAY;
+    aml_buffer_appendc(bh, '[');
+    for (ajsona_t *a = ajsona_first(j); a; a = ajsona_next(a)) {
+      if (a != ajsona_first(j)) aml_buffer_appendc(bh, ',');
+      h = fold(h, emit(c, g, a->value, j));
+    }
+    aml_buffer_appendc(bh, ']');
+  }
+  h = finish(h);
+
+  if (grow(c)) {
+    size_t i = ptr_hash(j) & c->mask;
+    while (c->tab[i].node) i = (i + 1) & c->mask;
+    e = c->tab + i;
+    memset(e, 0, sizeof(*e));
+    e->node = j;
+    e->gen  = g;
+    e->off  = start;
+    e->len  = aml_buffer_length(bh) - start;
+    e->fp   = h;
+    add_parent(e, parent);
+    g->refs++;
+    c->count++;
+    __atomic_add_fetch(held_at(j), 1, __ATOMIC_RELAXED);
+  }
+  return h;
+}
+
+/* The same value emit would return, without writing anything. */
+static uint64_t fingerprint(ajsb_cache_t *c, ajson_t *j) {
+  if (!ajson_is_object(j) && !ajson_is_array(j)) return scalar_fp(j);
+  entry_t *e = find(c, j);
+  if (e) return e->fp;
+  uint64_t h;
+  if (ajson_is_object(j)) {
+    h = FP_OBJECT;
+    for (ajsono_t *m = ajsono_first(j); m; m = ajsono_next(m)) {
+      h = fold(h, ajsb_hash64(m->key, strlen(m->key)));
+      h = fold(h, fingerprint(c, m->value));
+    }
+  } else {
+    h = FP_ARRAY;
+    for (ajsona_t *a = ajsona_first(j); a; a = ajsona_next(a))
+      h = fold(h, fingerprint(c, a->value));
+  }
+  return finish(h);
+}
+
+/* ── Public API ─────────────────────────────────────────────────────────── */
+
+ajsb_cache_t *ajsb_cache_init(void) {
+  ajsb_cache_t *c = (ajsb_cache_t *)aml_calloc(1, sizeof(*c));
+  if (!c) return NULL;
+  c->mask = 63;
+  c->tab = (entry_t *)aml_calloc(c->mask + 1, sizeof(entry_t));
+  c->cur = (gen_t *)aml_calloc(1, sizeof(gen_t));
+  if (!c->tab || !c->cur) {
+    aml_free(c->tab);
+    aml_free(c->cur);
+    aml_free(c);
+    return NULL;
+  }
+  c->cur->bh = aml_buffer_init(64);
+  pthread_mutex_init(&c->lock, NULL);
+  __atomic_add_fetch(&num_live, 1, __ATOMIC_SEQ_CST);
+  c->seen = __atomic_load_n(&touch_head, __ATOMIC_SEQ_CST);
+  return c;
+}
+
+void ajsb_cache_destroy(ajsb_cache_t *c) {
+  if (!c) return;
+  __atomic_sub_fetch(&num_live, 1, __ATOMIC_RELEASE);
+  clear_all(c);
+  gen_free(c->cur);
+  aml_free(c->tab);
+  pthread_mutex_destroy(&c->lock);
+  aml_free(c);
+}
+
+void ajsb_cache_reset(ajsb_cache_t *c) {
+  if (!c) return;
+  pthread_mutex_lock(&c->lock);
+  clear_all(c);
+  c->seen = __atomic_load_n(&touch_head, __ATOMIC_ACQUIRE);
+  pthread_mutex_unlock(&c->lock);
+}
+
+const char *ajsb_cache_stringify(ajsb_cache_t *c, ajson_t *schema, size_t *len) {
+  if (len) *len = 0;
+  if (!c || !schema) return NULL;
+  pthread_mutex_lock(&c->lock);
+  catch_up(c);
+
+  size_t last = aml_buffer_length(c->cur->bh);
+  if (c->old_bytes > 2 * last + 4096) clear_all(c);
+
+  gen_t *g = (gen_t *)aml_calloc(1, sizeof(gen_t));
+  if (!g) {
+    pthread_mutex_unlock(&c->lock);
+    return NULL;
+  }
+  g->bh = aml_buffer_init(last + 64);
+  emit(c, g, schema, NULL);
+
+  gen_t *prev = c->cur;
+  c->cur = g;
+  if (prev->refs) {
+    prev->next = c->old;
+    c->old = prev;
+    c->old_bytes += aml_buffer_length(prev->bh);
+  }
+  else gen_free(prev);
+
+  const char *text = aml_buffer_data(g->bh);
+  if (len) *len = aml_buffer_length(g->bh);
+  pthread_mutex_unlock(&c->lock);
+  return text;
+}
+
+uint64_t ajsb_cache_fingerprint(ajsb_cache_t *c, ajson_t *node) {
+  if (!c || !node) return 0;
+  pthread_mutex_lock(&c->lock);
+  catch_up(c);
+  uint64_t h = fingerprint(c, node);
+  pthread_mutex_unlock(&c->lock);
+  return h;
+}
+
+void ajsb_touch(ajson_t *node) {
+  if (!node || !__atomic_load_n(&num_live, __ATOMIC_ACQUIRE)) return;
+  if (!__atomic_load_n(held_at(node), __ATOMIC_RELAXED)) return;
+  uint64_t n = __atomic_fetch_add(&touch_head, 1, __ATOMIC_RELAXED);
+  touch_t *t = touch_log + (n & (LOG_SIZE - 1));
+  __atomic_store_n(&t->seq, 0, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  __atomic_store_n(&t->node, node, __ATOMIC_RELAXED);
+  __atomic_store_n(&t->seq, n + 1, __ATOMIC_RELEASE);
+}
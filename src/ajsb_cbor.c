@@ -0,0 +1,569 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#include "a-json-schema-builder-library/ajsb_cbor.h"
+
+#include <errno.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Keyword tags: a keyword key is written as its position here. Only ever
+   append, or older payloads decode to the wrong keys. */
+static const char *const keywords[] = {
+  /* 0..23 fit in the initial byte */
+  "type", "properties", "required", "items", "$ref", "$defs", "enum", "const",
+  "description", "title", "default", "format", "pattern", "minimum", "maximum",
+  "additionalProperties", "anyOf", "oneOf", "allOf", "minLength", "maxLength",
+  "minItems", "maxItems", "$id",
+  /* 24.. take two bytes */
+  "$schema", "$anchor", "$dynamicRef", "$dynamicAnchor", "$comment", "$vocabulary",
+  "exclusiveMinimum", "exclusiveMaximum", "multipleOf", "uniqueItems",
+  "minProperties", "maxProperties", "patternProperties", "propertyNames",
+  "dependentRequired", "dependentSchemas", "prefixItems", "contains",
+  "minContains", "maxContains", "not", "if", "then", "else",
+  "unevaluatedProperties", "unevaluatedItems", "examples", "deprecated",
+  "readOnly", "writeOnly", "contentEncoding", "contentMediaType",
+  "contentSchema", "definitions", "additionalItems", "dependencies",
+};
+#define NUM_KEYWORDS (sizeof(keywords) / sizeof(keywords[0]))
+
+#define TAG_TYPE   0
+#define TAG_FORMAT 11
+
+/* Values of "type" and "format" that are written as CBOR simple values
+   0..19 (one byte, and never confused with a number or string). Append
+   only, at most 20 each. */
+typedef struct {
+  const char *const *names;
+  size_t             count;
+} names_t;
+
+static const char *const type_names[] = {
+  "null", "boolean", "object", "array", "number", "string", "integer",
+};
+static const char *const format_names[] = {
+  "date-time", "date", "time", "duration", "email", "idn-email", "hostname",
+  "idn-hostname", "ipv4", "ipv6", "uri", "uri-reference", "iri",
+  "iri-reference", "uuid", "uri-template", "json-pointer",
+  "relative-json-pointer", "regex",
+};
+static const names_t types = {type_names, sizeof(type_names) / sizeof(type_names[0])};
+static const names_t formats = {format_names, sizeof(format_names) / sizeof(format_names[0])};
+
+/* Names for the value of a member keyed by tag. */
+static const names_t *names_for(int tag) {
+  return tag == TAG_TYPE ? &types : tag == TAG_FORMAT ? &formats : NULL;
+}
+
+#define SELF_DESCRIBE 55799u    /* d9 d9 f7 */
+#define TAG_BIGNUM    2u        /* 3: negative, 4: decimal fraction */
+#define MAX_DEPTH     1024
+
+static uint8_t by_name[NUM_KEYWORDS];     /* keyword tags in strcmp order */
+static pthread_once_t by_name_once = PTHREAD_ONCE_INIT;
+
+static int cmp_keyword(const void *a, const void *b) {
+  return strcmp(keywords[*(const uint8_t *)a], keywords[*(const uint8_t *)b]);
+}
+
+static void by_name_init(void) {
+  for (size_t i = 0; i < NUM_KEYWORDS; i++) by_name[i] = (uint8_t)i;
+  qsort(by_name, NUM_KEYWORDS, 1, cmp_keyword);
+}
+
+/* Tag for key, -1 if it is not a keyword. */
+static int keyword_tag(const char *key) {
+  size_t lo = 0, hi = NUM_KEYWORDS;
+  while (lo < hi) {
+    size_t mid = (lo + hi) / 2;
+    int c = strcmp(key, keywords[by_name[mid]]);
+    if (!c) return by_name[mid];
+    if (c < 0) hi = mid;
+    else lo = mid + 1;
+  }
+  return -1;
+}
+
+/* ── Encoding ───────────────────────────────────────────────────────────── */
+
+static void head(aml_buffer_t *bh, unsigned major, uint64_t v) {
+  unsigned char b[9];
+  size_t n = 1;
+  major <<= 5;
+  if (v < 24) {
+    b[0] = (unsigned char)(major | v);
+  } else {
+    unsigned info = v <= 0xff ? 24 : v <= 0xffff ? 25 : v <= 0xffffffffu ? 26 : 27;
+    n = 1 + ((size_t)1 << (info - 24));
+    b[0] = (unsigned char)(major | info);
+    for (size_t i = n - 1; i > 0; i--, v >>= 8) b[i] = (unsigned char)v;
+  }
+  aml_buffer_append(bh, b, n);
+}
+
+/* d as an IEEE half, if that holds it exactly. */
+static bool half_of(double d, uint16_t *out) {
+  float f = (float)d;
+  if ((double)f != d) return false;
+  uint32_t x;
+  memcpy(&x, &f, sizeof(x));
+  uint16_t sign = (uint16_t)((x >> 16) & 0x8000);
+  int exp = (int)((x >> 23) & 0xff) - 127;
+  uint32_t mant = x & 0x7fffff;
+  if (!(x & 0x7fffffff)) {
+    *out = sign;
+    return true;
+  }
+  if (exp >= -14 && exp <= 15) {
+    if (mant & 0x1fff) return false;
+    *out = (uint16_t)(sign | (uint32_t)(exp + 15) << 10 | mant >> 13);
+    return true;
+  }
+  if (exp >= -24 && exp < -14) {        /* half subnormal: m * 2^-24 */
+    uint32_t full = 0x800000 | mant;
+    int shift = -exp - 1;
+    if (full & ((1u << shift) - 1)) return false;
+    *out = (uint16_t)(sign | full >> shift);
+    return true;
+  }
+  return false;
+}
+
+/* Shortest of half, single and double that holds d. */
+static void put_float(aml_buffer_t *bh, double d) {
+  unsigned char b[9];
+  uint16_t h;
+  float f = (float)d;
+  if (half_of(d, &h)) {
+    b[0] = 0xf9;
+    b[1] = (unsigned char)(h >> 8);
+    b[2] = (unsigned char)h;
+    aml_buffer_append(bh, b, 3);
+  } else if ((double)f == d) {
+    uint32_t x;
+    memcpy(&x, &f, sizeof(x));
+    b[0] = 0xfa;
+    for (int i = 4; i > 0; i--, x >>= 8) b[i] = (unsigned char)x;
+    aml_buffer_append(bh, b, 5);
+  } else {
+    uint64_t x;
+    memcpy(&x, &d, sizeof(x));
+    b[0] = 0xfb;
+    for (int i = 8; i > 0; i--, x >>= 8) b[i] = (unsigned char)x;
+    aml_buffer_append(bh, b, 9);
+  }
+}
+
+/* Shortest text that reads back as d. */
+static void shortest(char *buf, size_t cap, double d) {
+  for (int prec = 1; prec <= 17; prec++) {
+    snprintf(buf, cap, "%.*g", prec, d);
+    if (strtod(buf, NULL) == d) break;
+  }
+}
+
+/* A JSON number as its exact value: sign, significant digits without
+   leading or trailing zeros (empty for zero) and a power of ten, so
+   "-12.50e3" is -, "125", 2. False for an absurd exponent. */
+typedef struct {
+  bool        neg;
+  char       *digits;
+  size_t      n;
+  long long   exp;
+} exact_t;
+
+static bool exact_of(aml_pool_t *tmp, const char *s, exact_t *x) {
+  x->neg = *s == '-';
+  if (x->neg) s++;
+  x->digits = (char *)aml_pool_alloc(tmp, strlen(s) + 1);
+  x->n = 0;
+  x->exp = 0;
+  bool frac = false;
+  for (; (*s >= '0' && *s <= '9') || *s == '.'; s++) {
+    if (*s == '.') { frac = true; continue; }
+    if (x->n || *s != '0') x->digits[x->n++] = *s;
+    if (frac) x->exp--;
+  }
+  if (*s == 'e' || *s == 'E') {
+    errno = 0;
+    long long e = strtoll(s + 1, NULL, 10);
+    if (errno || e > INT64_MAX / 4 || e < -INT64_MAX / 4) return false;
+    x->exp += e;
+  }
+  while (x->n && x->digits[x->n - 1] == '0') {
+    x->n--;
+    x->exp++;
+  }
+  x->digits[x->n] = 0;
+  if (!x->n) x->exp = 0;
+  return true;
+}
+
+/* digits (no leading zeros) as a non-negative integer: a CBOR integer of
+   major type 0 or 1 when it fits, else a bignum (RFC 8949, 3.4.3). The
+   value written is n for positive and n - 1 for negative numbers. */
+static void put_integer(aml_buffer_t *bh, aml_pool_t *tmp, bool neg, const char *digits, size_t n) {
+  if (n < 20 || (n == 20 && strcmp(digits, "18446744073709551616") < 0) ||
+      (n == 20 && neg && !strcmp(digits, "18446744073709551616"))) {
+    uint64_t v = 0;
+    for (size_t i = 0; i < n; i++) v = v * 10 + (uint64_t)(digits[i] - '0');
+    head(bh, neg ? 1 : 0, neg ? v - 1 : v);
+    return;
+  }
+  /* base 256, most significant byte first */
+  unsigned char *b = (unsigned char *)aml_pool_alloc(tmp, n / 2 + 2);
+  size_t len = 0;
+  for (size_t i = 0; i < n; i++) {
+    unsigned carry = (unsigned)(digits[i] - '0');
+    for (size_t k = len; k-- > 0;) {
+      carry += b[k] * 10u;
+      b[k] = (unsigned char)carry;
+      carry >>= 8;
+    }
+    if (carry) {
+      memmove(b + 1, b, len++);
+      b[0] = (unsigned char)carry;
+    }
+  }
+  if (neg) {
+    size_t k = len;
+    while (k-- > 0 && b[k]-- == 0) {}
+    if (!b[0]) memmove(b, b + 1, --len);
+  }
+  head(bh, 6, TAG_BIGNUM + (neg ? 1 : 0));
+  head(bh, 2, len);
+  aml_buffer_append(bh, b, len);
+}
+
+/* Integers are written as integers and decimals as the shortest float that
+   holds them exactly; anything else (more than 64 bits, more digits than a
+   double keeps, out of its range) exactly, as a bignum or a decimal
+   fraction [exponent, mantissa]. */
+static bool put_number(aml_buffer_t *bh, aml_pool_t *tmp, ajson_t *j) {
+  const char *s = ajson_to_str(j, "0");
+  if (!strpbrk(s, ".eE")) {
+    const char *digits = s + (*s == '-');
+    while (*digits == '0' && digits[1]) digits++;
+    put_integer(bh, tmp, *s == '-' && *digits != '0', digits, strlen(digits));   /* "-0" is 0 */
+    return true;
+  }
+  exact_t x;
+  if (!exact_of(tmp, s, &x)) return false;
+  if (!x.n) {
+    put_float(bh, x.neg ? -0.0 : 0.0);
+    return true;
+  }
+  double d = strtod(s, NULL);
+  if (isfinite(d) && d != 0) {
+    char buf[40];
+    exact_t y;
+    shortest(buf, sizeof(buf), d);
+    if (exact_of(tmp, buf, &y) && y.exp == x.exp && !strcmp(y.digits, x.digits)) {
+      put_float(bh, d);
+      return true;
+    }
+  }
+  head(bh, 6, TAG_BIGNUM + 2);
+  head(bh, 4, 2);
+  if (x.exp < 0) head(bh, 1, (uint64_t)(-1 - x.exp));
+  else head(bh, 0, (uint64_t)x.exp);
+  put_integer(bh, tmp, x.neg, x.digits, x.n);
+  return true;
+}
+
+/* True if the raw JSON string text escapes a NUL, which a C string loses. */
+static bool escapes_nul(const char *raw) {
+  for (; *raw; raw++) {
+    if (*raw != '\\' || !raw[1]) continue;
+    if (raw[1] == 'u' && !strncmp(raw + 2, "0000", 4)) return true;
+    raw++;
+  }
+  return false;
+}
+
+typedef struct {
+  const char *key;       /* decoded */
+  size_t      len;
+  int         tag;       /* keyword tag or -1 */
+  ajson_t    *value;
+} member_t;
+
+static bool put_text(aml_buffer_t *bh, aml_pool_t *tmp, ajson_t *j, const names_t *names) {
+  const char *raw = ajson_to_str(j, "");
+  if (escapes_nul(raw)) return false;
+  const char *s = strchr(raw, '\\') ? ajson_to_strd(tmp, j, "") : raw;
+  for (size_t i = 0; names && i < names->count; i++) {
+    if (!strcmp(s, names->names[i])) {
+      head(bh, 7, i);
+      return true;
+    }
+  }
+  size_t len = strlen(s);
+  head(bh, 3, len);
+  aml_buffer_append(bh, s, len);
+  return true;
+}
+
+/* names: the value is that of "type" or "format" (or an array under one). */
+static bool put(aml_buffer_t *bh, aml_pool_t *tmp, ajson_t *j, const names_t *names) {
+  if (ajson_is_object(j)) {
+    size_t n = ajsono_count(j), i = 0;
+    member_t *m = (member_t *)aml_pool_alloc(tmp, (n ? n : 1) * sizeof(member_t));
+    for (ajsono_t *kv = ajsono_first(j); kv; kv = ajsono_next(kv), i++) {
+      if (escapes_nul(kv->key)) return false;
+      m[i].key = strchr(kv->key, '\\') ? ajson_decode(tmp, kv->key, strlen(kv->key)) : kv->key;
+      m[i].len = strlen(m[i].key);
+      m[i].tag = keyword_tag(m[i].key);
+      m[i].value = kv->value;
+    }
+    head(bh, 5, n);                     /* in tree order; see ajsb_cbor.h */
+    for (i = 0; i < n; i++) {
+      if (m[i].tag >= 0) {
+        head(bh, 0, (uint64_t)m[i].tag);
+      } else {
+        head(bh, 3, m[i].len);
+        aml_buffer_append(bh, m[i].key, m[i].len);
+      }
+      if (!put(bh, tmp, m[i].value, names_for(m[i].tag))) return false;
+    }
+    return true;
+  }
+  if (ajson_is_array(j)) {
+    head(bh, 4, ajsona_count(j));
+    for (ajsona_t *a = ajsona_first(j); a; a = ajsona_next(a))
+      if (!put(bh, tmp, a->value, names)) return false;
+    return true;
+  }
+  if (ajson_is_string(j)) return put_text(bh, tmp, j, names);
+  if (ajson_is_number(j) || ajson_is_decimal(j)) return put_number(bh, tmp, j);
+  if (ajson_is_true(j))  { aml_buffer_appendc(bh, (char)0xf5); return true; }
+  if (ajson_is_false(j)) { aml_buffer_appendc(bh, (char)0xf4); return true; }
+  if (ajson_is_null(j))  { aml_buffer_appendc(bh, (char)0xf6); return true; }
+  return false;
+}
+
+bool ajsb_encode_cbor(aml_buffer_t *bh, ajson_t *schema) {
+  if (!bh || !schema) return false;
+  pthread_once(&by_name_once, by_name_init);
+  size_t start = aml_buffer_length(bh);
+  aml_pool_t *tmp = aml_pool_init(4096);
+  bool ok = put(bh, tmp, schema, NULL);
+  aml_pool_destroy(tmp);
+  if (!ok) aml_buffer_shrink_by(bh, aml_buffer_length(bh) - start);
+  return ok;
+}
+
+/* ── Decoding ───────────────────────────────────────────────────────────── */
+
+typedef struct {
+  aml_pool_t          *p;
+  const unsigned char *s, *end;
+} dec_t;
+
+static bool read_head(dec_t *d, unsigned *major, unsigned *info, uint64_t *v) {
+  if (d->s >= d->end) return false;
+  unsigned b = *d->s++;
+  *major = b >> 5;
+  *info = b & 31;
+  if (*info < 24) {
+    *v = *info;
+    return true;
+  }
+  if (*info > 27) return false;             /* reserved, or indefinite length */
+  size_t n = (size_t)1 << (*info - 24);
+  if ((size_t)(d->end - d->s) < n) return false;
+  uint64_t x = 0;
+  for (size_t i = 0; i < n; i++) x = x << 8 | *d->s++;
+  *v = x;
+  return true;
+}
+
+static double half_value(uint16_t h) {
+  int e = (h >> 10) & 0x1f;
+  double m = h & 0x3ff, v;
+  if (e == 0) v = m / 16777216.0;                           /* m * 2^-24 */
+  else if (e == 31) v = m ? NAN : INFINITY;
+  else v = e >= 25 ? (m + 1024) * (double)(1u << (e - 25)) : (m + 1024) / (double)(1u << (25 - e));
+  return h & 0x8000 ? -v : v;
+}
+
+/* Shortest text that reads back as d, always with a '.' or exponent. */
+static ajson_t *decimal(aml_pool_t *p, double d) {
+  if (!isfinite(d)) return NULL;
+  char buf[40];
+  shortest(buf, sizeof(buf), d);
+  if (!strpbrk(buf, ".e")) strcat(buf, ".0");
+  return ajson_decimal_string(p, buf);
+}
+
+/* An integer as put_integer writes it: decimal digits of the magnitude in
+   the pool and whether it is negative. Bignums that would fit in 64 bits
+   or have leading zero bytes are not accepted. */
+static const char *integer(dec_t *d, unsigned major, uint64_t v, bool *neg) {
+  unsigned info;
+  *neg = major == 1;
+  if (major == 0) return aml_pool_strdupf(d->p, "%llu", (unsigned long long)v);
+  if (major == 1)
+    return v == UINT64_MAX ? "18446744073709551616" : aml_pool_strdupf(d->p, "%llu", (unsigned long long)v + 1);
+  if (major != 6 || (v != TAG_BIGNUM && v != TAG_BIGNUM + 1)) return NULL;
+  *neg = v != TAG_BIGNUM;
+  if (!read_head(d, &major, &info, &v) || major != 2 || v > (size_t)(d->end - d->s) || v <= 8 || !d->s[0])
+    return NULL;
+  size_t len = (size_t)v;
+  unsigned char *b = (unsigned char *)aml_pool_alloc(d->p, len + 1);
+  memcpy(b + 1, d->s, len);
+  d->s += len;
+  b[0] = 0;
+  if (*neg) {                                 /* -1 - n: the magnitude is n + 1 */
+    size_t k = len + 1;
+    while (k-- > 0 && ++b[k] == 0) {}
+  }
+  size_t start = b[0] ? 0 : 1, cap = len * 3 + 4;
+  char *digits = (char *)aml_pool_alloc(d->p, cap), *w = digits + cap - 1;
+  *w = 0;
+  while (start <= len) {                      /* divide by ten until zero */
+    unsigned rem = 0;
+    for (size_t k = start; k <= len; k++) {
+      rem = rem << 8 | b[k];
+      b[k] = (unsigned char)(rem / 10);
+      rem %= 10;
+    }
+    *--w = (char)('0' + rem);
+    while (start <= len && !b[start]) start++;
+  }
+  return w;
+}
+
+/* Decimal fraction [exponent, mantissa] as a decimal: the digits with a
+   point inside or in front of them, or an exponent. */
+static ajson_t *fraction(dec_t *d) {
+  unsigned major, info;
+  uint64_t v;
+  if (!read_head(d, &major, &info, &v) || major != 4 || v != 2) return NULL;
+  if (!read_head(d, &major, &info, &v) || major > 1 || v > INT64_MAX) return NULL;
+  bool after = major == 1;                    /* digits after the point */
+  uint64_t places = after ? v + 1 : v;
+  bool neg;
+  if (!read_head(d, &major, &info, &v)) return NULL;
+  const char *digits = integer(d, major, v, &neg);
+  if (!digits) return NULL;
+  size_t n = strlen(digits);
+  char *out = (char *)aml_pool_alloc(d->p, n + 32), *w = out;
+  if (neg) *w++ = '-';
+  if (after && places < n) {
+    memcpy(w, digits, n - places);
+    w += n - places;
+    *w++ = '.';
+    strcpy(w, digits + n - places);
+  } else if (after && places - n < 6) {
+    memcpy(w, "0.00000", 2 + places - n);
+    strcpy(w + 2 + places - n, digits);
+  } else {
+    strcpy(w, digits);
+    w += n;
+    if (!places) strcpy(w, ".0");
+    else snprintf(w, 24, "e%s%llu", after ? "-" : "", (unsigned long long)places);
+  }
+  return ajson_decimal_string(d->p, out);
+}
+
+static ajson_t *item(dec_t *d, int depth, const names_t *names) {
+  unsigned major, info;
+  uint64_t v;
+  if (depth > MAX_DEPTH || !read_head(d, &major, &info, &v)) return NULL;
+  size_t left = (size_t)(d->end - d->s);
+  switch (major) {
+    case 0:
+      return v <= INT64_MAX ? ajson_number(d->p, (ssize_t)v)
+                            : ajson_decimal_stringf(d->p, "%llu", (unsigned long long)v);
+    case 1:
+      if (v <= INT64_MAX) return ajson_number(d->p, -(ssize_t)v - 1);
+      return v == UINT64_MAX ? ajson_decimal_string(d->p, "-18446744073709551616")
+                             : ajson_decimal_stringf(d->p, "-%llu", (unsigned long long)v + 1);
+    case 3: {
+      if (v > left || memchr(d->s, 0, v)) return NULL;
+      char *s = aml_pool_strndup(d->p, (const char *)d->s, v);
+      d->s += v;
+      return ajson_str(d->p, s);
+    }
+    case 4: {
+      if (v > left) return NULL;
+      ajson_t *a = ajsona(d->p);
+      for (uint64_t i = 0; i < v; i++) {
+        ajson_t *e = item(d, depth + 1, names);
+        if (!e) return NULL;
+        ajsona_append(a, e);
+      }
+      return a;
+    }
+    case 5: {
+      if (v > left / 2) return NULL;
+      ajson_t *o = ajsono(d->p);
+      for (uint64_t i = 0; i < v; i++) {
+        unsigned km, ki;
+        uint64_t kv;
+        char *key;
+        const names_t *vn = NULL;
+        if (!read_head(d, &km, &ki, &kv)) return NULL;
+        if (km == 0 && kv < NUM_KEYWORDS) {
+          key = (char *)keywords[kv];
+          vn = names_for((int)kv);
+        } else if (km == 3 && kv <= (size_t)(d->end - d->s) && !memchr(d->s, 0, kv)) {
+          key = ajson_encode(d->p, (char *)d->s, kv);
+          d->s += kv;
+        } else {
+          return NULL;
+        }
+        ajson_t *e = item(d, depth + 1, vn);
+        if (!e) return NULL;
+        ajsono_append(o, key, e, /*copy_key=*/false);
+      }
+      return o;
+    }
+    case 6: {
+      if (v == SELF_DESCRIBE) return !depth ? item(d, depth + 1, NULL) : NULL;
+      if (v == TAG_BIGNUM + 2) return fraction(d);
+      if (v != TAG_BIGNUM && v != TAG_BIGNUM + 1) return NULL;
+      bool neg;
+      const char *digits = integer(d, major, v, &neg);
+      if (!digits) return NULL;
+      return ajson_decimal_string(d->p, neg ? aml_pool_strdupf(d->p, "-%s", digits) : digits);
+    }
+    case 7:
+      if (info < 20) return names && v < names->count ? ajson_str(d->p, names->names[v]) : NULL;
+      switch (info) {
+        case 20: return ajson_false(d->p);
+        case 21: return ajson_true(d->p);
+        case 22: return ajson_null(d->p);
+        case 25: return decimal(d->p, half_value((uint16_t)v));
+        case 26: {
+          uint32_t x = (uint32_t)v;
+          float f;
+          memcpy(&f, &x, sizeof(f));
+          return decimal(d->p, f);
+        }
+        case 27: {
+          double x;
+          memcpy(&x, &v, sizeof(x));
+          return decimal(d->p, x);
+        }
+        default: return NULL;
+      }
+    default:
+      return NULL;                          /* byte strings are never written */
+  }
+}
+
+ajson_t *ajsb_decode_cbor(aml_pool_t *p, const void *data, size_t len) {
+  if (!p || !data || !len) return NULL;
+  dec_t d = {p, (const unsigned char *)data, (const unsigned char *)data + len};
+  ajson_t *r = item(&d, 0, NULL);
+  return r && d.s == d.end ? r : NULL;
+}
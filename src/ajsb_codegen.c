@@ -0,0 +1,705 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#include "a-json-schema-builder-library/ajsb_codegen.h"
+#include "a-json-schema-builder-library/ajsb_format.h"
+#include "a-memory-library/aml_alloc.h"
+#include "a-memory-library/aml_pool.h"
+#include "ajsb_program.h"
+
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* The generated file repeats the interpreter's instance helpers so it does
+   not depend on this library (string comparison, format and pattern checks
+   come from the header-only ajsb_format.h). */
+static const char prelude[] =
+  "#include \"a-json-library/ajson.h\"\n"
+  "#include \"a-json-schema-builder-library/ajsb_format.h\"\n"
+  "\n"
+  "#include <math.h>\n"
+  "#include <stdbool.h>\n"
+  "#include <stdint.h>\n"
+  "#include <stdlib.h>\n"
+  "#include <string.h>\n"
+  "\n"
+  "enum { T_NULL = 1, T_BOOLEAN = 2, T_OBJECT = 4, T_ARRAY = 8, T_NUMBER = 16, T_STRING = 32,\n"
+  "       T_INTEGER = 64 };\n"
+  "\n"
+  "static inline unsigned kind_of(ajson_t *j) {\n"
+  "  if (ajson_is_object(j)) return T_OBJECT;\n"
+  "  if (ajson_is_array(j))  return T_ARRAY;\n"
+  "  if (ajson_is_string(j)) return T_STRING;\n"
+  "  if (ajson_is_number(j) || ajson_is_decimal(j)) return T_NUMBER;\n"
+  "  if (ajson_is_bool(j))   return T_BOOLEAN;\n"
+  "  if (ajson_is_null(j))   return T_NULL;\n"
+  "  return 0;\n"
+  "}\n"
+  "\n"
+  "static inline bool is_integer(unsigned k, ajson_t *j) {\n"
+  "  if (k != T_NUMBER) return false;\n"
+  "  double d = ajson_to_double(j, 0.5);\n"
+  "  return d >= -9007199254740992.0 && d <= 9007199254740992.0 && (double)(int64_t)d == d;\n"
+  "}\n"
+  "\n"
+  "/* member named by raw JSON text, however either side escapes it */\n"
+  "static inline ajson_t *member_of(ajson_t *j, const char *key, size_t len) {\n"
+  "  for (ajsono_t *m = ajsono_first(j); m; m = ajsono_next(m))\n"
+  "    if (ajsb_json_text_eq(m->key, strlen(m->key), key, len)) return m->value;\n"
+  "  return NULL;\n"
+  "}\n"
+  "\n"
+  "static inline bool json_equal(ajson_t *a, ajson_t *b) {\n"
+  "  unsigned ka = kind_of(a), kb = kind_of(b);\n"
+  "  if (ka != kb) return false;\n"
+  "  switch (ka) {\n"
+  "  case T_NUMBER:  return ajson_to_double(a, 0) == ajson_to_double(b, 0);\n"
+  "  case T_STRING: {\n"
+  "    const char *x = ajson_to_str(a, \"\"), *y = ajson_to_str(b, \"\");\n"
+  "    return ajsb_json_text_eq(x, strlen(x), y, strlen(y));\n"
+  "  }\n"
+  "  case T_BOOLEAN: return ajson_is_true(a) == ajson_is_true(b);\n"
+  "  case T_NULL:    return true;\n"
+  "  case T_ARRAY: {\n"
+  "    if (ajsona_count(a) != ajsona_count(b)) return false;\n"
+  "    ajsona_t *x = ajsona_first(a), *y = ajsona_first(b);\n"
+  "    for (; x && y; x = ajsona_next(x), y = ajsona_next(y))\n"
+  "      if (!json_equal(x->value, y->value)) return false;\n"
+  "    return true;\n"
+  "  }\n"
+  "  case T_OBJECT: {\n"
+  "    if (ajsono_count(a) != ajsono_count(b)) return false;\n"
+  "    for (ajsono_t *x = ajsono_first(a); x; x = ajsono_next(x)) {\n"
+  "      ajson_t *v = member_of(b, x->key, strlen(x->key));\n"
+  "      if (!v || !json_equal(x->value, v)) return false;\n"
+  "    }\n"
+  "    return true;\n"
+  "  }\n"
+  "  }\n"
+  "  return false;\n"
+  "}\n";
+
+/* json_equal against compact JSON text (object and array enum members) */
+static const char prelude_text[] =
+  "typedef struct { const char *s, *e; } text_t;\n"
+  "\n"
+  "static inline bool lit(text_t *c, const char *t, size_t n) {\n"
+  "  if ((size_t)(c->e - c->s) < n || memcmp(c->s, t, n)) return false;\n"
+  "  c->s += n;\n"
+  "  return true;\n"
+  "}\n"
+  "\n"
+  "static inline bool text_string(text_t *c, const char **s, size_t *len) {\n"
+  "  if (!lit(c, \"\\\"\", 1)) return false;\n"
+  "  const char *p = c->s;\n"
+  "  while (p < c->e && *p != '\"') p += *p == '\\\\' ? 2 : 1;\n"
+  "  if (p >= c->e) return false;\n"
+  "  *s = c->s;\n"
+  "  *len = (size_t)(p - c->s);\n"
+  "  c->s = p + 1;\n"
+  "  return true;\n"
+  "}\n"
+  "\n"
+  "static inline bool equals_text(ajson_t *j, text_t *c) {\n"
+  "  if (c->s >= c->e) return false;\n"
+  "  unsigned kind = kind_of(j);\n"
+  "  const char *s;\n"
+  "  size_t len;\n"
+  "  switch (*c->s) {\n"
+  "  case '{': {\n"
+  "    if (kind != T_OBJECT) return false;\n"
+  "    c->s++;\n"
+  "    if (lit(c, \"}\", 1)) return !ajsono_count(j);\n"
+  "    size_t n = 0;\n"
+  "    do {\n"
+  "      if (!text_string(c, &s, &len) || !lit(c, \":\", 1)) return false;\n"
+  "      ajson_t *v = member_of(j, s, len);\n"
+  "      if (!v || !equals_text(v, c)) return false;\n"
+  "      n++;\n"
+  "    } while (lit(c, \",\", 1));\n"
+  "    return lit(c, \"}\", 1) && n == ajsono_count(j);\n"
+  "  }\n"
+  "  case '[': {\n"
+  "    if (kind != T_ARRAY) return false;\n"
+  "    c->s++;\n"
+  "    ajsona_t *a = ajsona_first(j);\n"
+  "    if (lit(c, \"]\", 1)) return !a;\n"
+  "    for (;; a = ajsona_next(a)) {\n"
+  "      if (!a || !equals_text(a->value, c)) return false;\n"
+  "      if (!lit(c, \",\", 1)) break;\n"
+  "    }\n"
+  "    return lit(c, \"]\", 1) && !ajsona_next(a);\n"
+  "  }\n"
+  "  case '\"': {\n"
+  "    if (kind != T_STRING || !text_string(c, &s, &len)) return false;\n"
+  "    const char *t = ajson_to_str(j, \"\");\n"
+  "    return ajsb_json_text_eq(s, len, t, strlen(t));\n"
+  "  }\n"
+  "  case 't': return kind == T_BOOLEAN && ajson_is_true(j) && lit(c, \"true\", 4);\n"
+  "  case 'f': return kind == T_BOOLEAN && !ajson_is_true(j) && lit(c, \"false\", 5);\n"
+  "  case 'n': return kind == T_NULL && lit(c, \"null\", 4);\n"
+  "  default: {\n"
+  "    if (kind != T_NUMBER) return false;\n"
+  "    char *end;\n"
+  "    double d = strtod(c->s, &end);\n"
+  "    if (end == c->s || end > c->e) return false;\n"
+  "    c->s = end;\n"
+  "    return d == ajson_to_double(j, 0);\n"
+  "  }\n"
+  "  }\n"
+  "}\n";
+
+/* uniqueItems, only emitted when the schema uses it: sorted item hashes, so
+   only items with equal hashes are compared. */
+static const char prelude_unique[] =
+  "static inline uint64_t hash_bytes(const void *s, size_t len) {\n"
+  "  const unsigned char *b = (const unsigned char *)s;\n"
+  "  uint64_t h = 14695981039346656037ull;\n"
+  "  for (size_t i = 0; i < len; i++) h = (h ^ b[i]) * 1099511628211ull;\n"
+  "  return h;\n"
+  "}\n"
+  "\n"
+  "static inline uint64_t text_hash(const char *raw, size_t len) {\n"
+  "  char stack[128], *heap;\n"
+  "  const char *s = ajsb__canonical(raw, &len, stack, sizeof(stack), &heap);\n"
+  "  uint64_t h = s ? hash_bytes(s, len) : 0;\n"
+  "  free(heap);\n"
+  "  return h;\n"
+  "}\n"
+  "\n"
+  "/* agrees with json_equal: numbers by value, object members in any order */\n"
+  "static inline uint64_t json_hash(ajson_t *j) {\n"
+  "  switch (kind_of(j)) {\n"
+  "  case T_NUMBER: {\n"
+  "    double d = ajson_to_double(j, 0);\n"
+  "    if (d == 0) d = 0;\n"
+  "    return hash_bytes(&d, sizeof(d));\n"
+  "  }\n"
+  "  case T_STRING: {\n"
+  "    const char *s = ajson_to_str(j, \"\");\n"
+  "    return text_hash(s, strlen(s));\n"
+  "  }\n"
+  "  case T_BOOLEAN: return ajson_is_true(j) ? 1 : 2;\n"
+  "  case T_NULL:    return 3;\n"
+  "  case T_ARRAY: {\n"
+  "    uint64_t h = 4;\n"
+  "    for (ajsona_t *a = ajsona_first(j); a; a = ajsona_next(a))\n"
+  "      h = (h ^ json_hash(a->value)) * 1099511628211ull;\n"
+  "    return h;\n"
+  "  }\n"
+  "  case T_OBJECT: {\n"
+  "    uint64_t h = 5;\n"
+  "    for (ajsono_t *m = ajsono_first(j); m; m = ajsono_next(m)) {\n"
+  "      uint64_t x = text_hash(m->key, strlen(m->key)) ^ json_hash(m->value);\n"
+  "      x ^= x >> 33;\n"
+  "      x *= 0xff51afd7ed558ccdull;\n"
+  "      h += x ^ (x >> 33);\n"
+  "    }\n"
+  "    return h;\n"
+  "  }\n"
+  "  }\n"
+  "  return 0;\n"
+  "}\n"
+  "\n"
+  "typedef struct { uint64_t h; ajson_t *v; } hashed_t;\n"
+  "\n"
+  "static inline int by_item_hash(const void *a, const void *b) {\n"
+  "  uint64_t x = ((const hashed_t *)a)->h, y = ((const hashed_t *)b)->h;\n"
+  "  return x < y ? -1 : x > y;\n"
+  "}\n"
+  "\n"
+  "static inline bool unique_items(ajson_t *j) {\n"
+  "  size_t n = ajsona_count(j);\n"
+  "  hashed_t *t = n > 16 ? (hashed_t *)malloc(n * sizeof(hashed_t)) : NULL;\n"
+  "  if (!t) {\n"
+  "    for (ajsona_t *a = ajsona_first(j); a; a = ajsona_next(a))\n"
+  "      for (ajsona_t *b = ajsona_next(a); b; b = ajsona_next(b))\n"
+  "        if (json_equal(a->value, b->value)) return false;\n"
+  "    return true;\n"
+  "  }\n"
+  "  size_t i = 0;\n"
+  "  for (ajsona_t *a = ajsona_first(j); a; a = ajsona_next(a), i++) {\n"
+  "    t[i].h = json_hash(a->value);\n"
+  "    t[i].v = a->value;\n"
+  "  }\n"
+  "  qsort(t, n, sizeof(hashed_t), by_item_hash);\n"
+  "  bool unique = true;\n"
+  "  for (i = 0; i < n && unique; i++)\n"
+  "    for (size_t k = i + 1; k < n && t[k].h == t[i].h && unique; k++)\n"
+  "      unique = !json_equal(t[i].v, t[k].v);\n"
+  "  free(t);\n"
+  "  return unique;\n"
+  "}\n";
+
+typedef struct {
+  aml_buffer_t         *bh;
+  const ajsb_program_t *prog;
+  const char           *name;
+} gen_t;
+
+static void ind(gen_t *g, int level) { aml_buffer_appendn(g->bh, ' ', (size_t)level * 2); }
+
+/* C string literal; anything unusual as a three digit octal escape. */
+static void emit_str(gen_t *g, const char *s, size_t len) {
+  aml_buffer_appendc(g->bh, '"');
+  for (size_t i = 0; i < len; i++) {
+    unsigned char c = (unsigned char)s[i];
+    if (c >= 0x20 && c < 0x7f && c != '"' && c != '\\' && c != '?') aml_buffer_appendc(g->bh, (char)c);
+    else aml_buffer_appendf(g->bh, "\\%03o", c);
+  }
+  aml_buffer_appendc(g->bh, '"');
+}
+
+static void emit_double(gen_t *g, double d) {
+  if (isinf(d)) aml_buffer_appends(g->bh, d > 0 ? "HUGE_VAL" : "-HUGE_VAL");
+  else aml_buffer_appendf(g->bh, "%.17g", d);
+}
+
+static void emit_fn(gen_t *g, uint32_t node) {
+  aml_buffer_appendf(g->bh, "%s_s%u", g->name, node);
+}
+
+/* ── String dispatch ────────────────────────────────────────────────────── */
+
+/* What to do when s (length n) equals entries[i]. */
+typedef void (*action_fn)(gen_t *g, const ajsb_entry_t *e, int level);
+
+static int by_length(const void *a, const void *b) {
+  const ajsb_entry_t *x = *(const ajsb_entry_t *const *)a, *y = *(const ajsb_entry_t *const *)b;
+  if (x->len != y->len) return x->len < y->len ? -1 : 1;
+  return x < y ? -1 : x > y;     /* keep declaration order within a length */
+}
+
+static void emit_compare(gen_t *g, const ajsb_entry_t *e, action_fn act, int level) {
+  ind(g, level);
+  aml_buffer_appends(g->bh, "if (!memcmp(s, ");
+  emit_str(g, ajsb_entry_str(g->prog, e), e->len);
+  aml_buffer_appendf(g->bh, ", %u)) {\n", e->len);
+  act(g, e, level + 1);
+  ind(g, level);
+  aml_buffer_appends(g->bh, "}\n");
+}
+
+/* Byte position that splits keys[0..n) (all the same length) most ways. */
+static uint32_t best_byte(const gen_t *g, const ajsb_entry_t **keys, size_t n) {
+  uint32_t best = 0, best_distinct = 0;
+  for (uint32_t p = 0; p < keys[0]->len; p++) {
+    bool seen[256] = {0};
+    uint32_t distinct = 0;
+    for (size_t i = 0; i < n; i++) {
+      unsigned char c = (unsigned char)ajsb_entry_str(g->prog, keys[i])[p];
+      if (!seen[c]) { seen[c] = true; distinct++; }
+    }
+    if (distinct > best_distinct) { best = p; best_distinct = distinct; }
+  }
+  return best;
+}
+
+static void emit_same_length(gen_t *g, const ajsb_entry_t **keys, size_t n, action_fn act, int level) {
+  if (n <= 3 || !keys[0]->len) {
+    for (size_t i = 0; i < n; i++) emit_compare(g, keys[i], act, level);
+    return;
+  }
+  uint32_t p = best_byte(g, keys, n);
+  ind(g, level);
+  aml_buffer_appendf(g->bh, "switch ((unsigned char)s[%u]) {\n", p);
+  bool done[256] = {0};
+  for (size_t i = 0; i < n; i++) {
+    unsigned char c = (unsigned char)ajsb_entry_str(g->prog, keys[i])[p];
+    if (done[c]) continue;
+    done[c] = true;
+    ind(g, level);
+    aml_buffer_appendf(g->bh, "case %u:\n", c);
+    for (size_t k = i; k < n; k++)
+      if ((unsigned char)ajsb_entry_str(g->prog, keys[k])[p] == c) emit_compare(g, keys[k], act, level + 1);
+    ind(g, level + 1);
+    aml_buffer_appends(g->bh, "break;\n");
+  }
+  ind(g, level);
+  aml_buffer_appends(g->bh, "}\n");
+}
+
+/* switch (n) over the lengths, then a byte switch or memcmp chain. Expects
+   const char *s and size_t n in scope. */
+static void emit_dispatch(gen_t *g, const ajsb_entry_t *first, uint32_t count,
+                          bool (*want)(const ajsb_entry_t *), action_fn act, int level) {
+  const ajsb_entry_t **keys = (const ajsb_entry_t **)aml_malloc((count ? count : 1) * sizeof(*keys));
+  size_t n = 0;
+  for (uint32_t i = 0; i < count; i++)
+    if (!want || want(first + i)) keys[n++] = first + i;
+  qsort(keys, n, sizeof(*keys), by_length);
+
+  if (n) {
+    ind(g, level);
+    aml_buffer_appends(g->bh, "switch (n) {\n");
+    for (size_t i = 0; i < n;) {
+      size_t j = i;
+      while (j < n && keys[j]->len == keys[i]->len) j++;
+      ind(g, level);
+      aml_buffer_appendf(g->bh, "case %u:\n", keys[i]->len);
+      emit_same_length(g, keys + i, j - i, act, level + 1);
+      ind(g, level + 1);
+      aml_buffer_appends(g->bh, "break;\n");
+      i = j;
+    }
+    ind(g, level);
+    aml_buffer_appends(g->bh, "}\n");
+  }
+  aml_free(keys);
+}
+
+/* ── Keywords ───────────────────────────────────────────────────────────── */
+
+/* s is canonical text, possibly in heap, which an action frees. */
+static void act_enum(gen_t *g, const ajsb_entry_t *e, int level) {
+  (void)e;
+  ind(g, level);
+  aml_buffer_appends(g->bh, "free(heap);\n");
+  ind(g, level);
+  aml_buffer_appends(g->bh, "return true;\n");
+}
+
+static void act_prop(gen_t *g, const ajsb_entry_t *e, int level) {
+  if (e->aux) {
+    ind(g, level);
+    aml_buffer_appendf(g->bh, "seen[%u] |= (uint64_t)1 << %u;\n", (e->aux - 1) >> 6, (e->aux - 1) & 63);
+  }
+  ind(g, level);
+  aml_buffer_appends(g->bh, "free(heap);\n");
+  ind(g, level);
+  aml_buffer_appends(g->bh, "if (!");
+  emit_fn(g, e->node);
+  aml_buffer_appends(g->bh, "(m->value)) return false;\n");
+  ind(g, level);
+  aml_buffer_appends(g->bh, "continue;\n");
+}
+
+/* s and n: the canonical text of raw, the form entries are stored in. */
+static void emit_canonical(gen_t *g, const char *raw, int level) {
+  ind(g, level);
+  aml_buffer_appendf(g->bh, "const char *s = %s;\n", raw);
+  ind(g, level);
+  aml_buffer_appends(g->bh, "size_t n = strlen(s);\n");
+  ind(g, level);
+  aml_buffer_appends(g->bh, "char stack[128], *heap;\n");
+  ind(g, level);
+  aml_buffer_appends(g->bh, "if (!(s = ajsb__canonical(s, &n, stack, sizeof(stack), &heap))) return false;\n");
+}
+
+static bool is_string_member(const ajsb_entry_t *e) { return e->node == AJSB_V_STRING; }
+
+/* static bool <name>_e<at>(ajson_t *j, unsigned k) for the enum op at `at`. */
+static void emit_enum_fn(gen_t *g, uint32_t at) {
+  const ajsb_op_t *op = g->prog->ops + at;
+  const ajsb_entry_t *e = g->prog->entries + op->a, *end = e + op->u.b;
+  bool has[AJSB_V_JSON + 1] = {0};
+  for (const ajsb_entry_t *x = e; x < end; x++) has[x->node] = true;
+
+  aml_buffer_appendf(g->bh, "static bool %s_e%u(ajson_t *j, unsigned k) {\n", g->name, at);
+  aml_buffer_appends(g->bh, "  switch (k) {\n");
+  if (has[AJSB_V_STRING]) {
+    aml_buffer_appends(g->bh, "  case T_STRING: {\n");
+    emit_canonical(g, "ajson_to_str(j, \"\")", 2);
+    emit_dispatch(g, e, op->u.b, is_string_member, act_enum, 2);
+    aml_buffer_appends(g->bh, "    free(heap);\n    return false;\n  }\n");
+  }
+  if (has[AJSB_V_NUMBER]) {
+    aml_buffer_appends(g->bh, "  case T_NUMBER: {\n    double d = ajson_to_double(j, 0);\n    return");
+    const char *sep = " ";
+    for (const ajsb_entry_t *x = e; x < end; x++) {
+      if (x->node != AJSB_V_NUMBER) continue;
+      aml_buffer_appendf(g->bh, "%sd == ", sep);
+      emit_double(g, strtod(ajsb_entry_str(g->prog, x), NULL));
+      sep = " || ";
+    }
+    aml_buffer_appends(g->bh, ";\n  }\n");
+  }
+  if (has[AJSB_V_TRUE] || has[AJSB_V_FALSE])
+    aml_buffer_appendf(g->bh, "  case T_BOOLEAN: return %s;\n",
+                       has[AJSB_V_TRUE] && has[AJSB_V_FALSE] ? "true"
+                       : has[AJSB_V_TRUE] ? "ajson_is_true(j)" : "!ajson_is_true(j)");
+  if (has[AJSB_V_NULL]) aml_buffer_appends(g->bh, "  case T_NULL: return true;\n");
+  if (has[AJSB_V_JSON]) {
+    aml_buffer_appends(g->bh, "  case T_OBJECT: case T_ARRAY: case 0: {\n");
+    for (const ajsb_entry_t *x = e; x < end; x++) {
+      if (x->node != AJSB_V_JSON) continue;
+      aml_buffer_appends(g->bh, "    { text_t c = { ");
+      emit_str(g, ajsb_entry_str(g->prog, x), x->len);
+      aml_buffer_appendf(g->bh, ", NULL }; c.e = c.s + %u;\n", x->len);
+      aml_buffer_appends(g->bh, "      if (equals_text(j, &c) && c.s == c.e) return true; }\n");
+    }
+    aml_buffer_appends(g->bh, "    return false;\n  }\n");
+  }
+  aml_buffer_appends(g->bh, "  default: return false;\n  }\n}\n\n");
+}
+
+static void emit_pattern_table(gen_t *g, uint32_t at) {
+  const uint32_t *w = g->prog->lists + g->prog->ops[at].a;
+  size_t n = ajsb_pattern_words(w);
+  aml_buffer_appendf(g->bh, "static const uint32_t %s_p%u[%zu] = {", g->name, at, n);
+  for (size_t i = 0; i < n; i++)
+    aml_buffer_appendf(g->bh, "%s%s%u", i ? "," : "", i % 12 ? " " : "\n  ", w[i]);
+  aml_buffer_appends(g->bh, "\n};\n\n");
+}
+
+static void emit_string_check(gen_t *g, const ajsb_op_t *op, uint32_t at) {
+  aml_buffer_appends(g->bh, "  if (k == T_STRING) {\n    const char *s = ajson_to_str(j, \"\");\n");
+  if (op->op == AJSB_OP_FORMAT)
+    aml_buffer_appendf(g->bh, "    if (!ajsb_format_check_json((ajsb_format_t)%u, s, strlen(s))) return false;\n",
+                       op->a);
+  else
+    aml_buffer_appendf(g->bh, "    if (!ajsb_pattern_match_json(%s_p%u, s, strlen(s))) return false;\n",
+                       g->name, at);
+  aml_buffer_appends(g->bh, "  }\n");
+}
+
+static void emit_bound(gen_t *g, const ajsb_op_t *op, const char *cmp) {
+  aml_buffer_appendf(g->bh, "  if (k == T_NUMBER && !(ajson_to_double(j, 0) %s ", cmp);
+  emit_double(g, op->d);
+  aml_buffer_appends(g->bh, ")) return false;\n");
+}
+
+static void emit_list(gen_t *g, const ajsb_op_t *op, const char *join) {
+  for (uint32_t i = 0; i < op->u.b; i++) {
+    if (i) aml_buffer_appends(g->bh, join);
+    emit_fn(g, g->prog->lists[op->a + i]);
+    aml_buffer_appends(g->bh, "(j)");
+  }
+}
+
+static void emit_properties(gen_t *g, const ajsb_op_t *op) {
+  aml_buffer_appends(g->bh, "  if (k == T_OBJECT) {\n"
+                            "    for (ajsono_t *m = ajsono_first(j); m; m = ajsono_next(m)) {\n");
+  if (op->u.b) {
+    emit_canonical(g, "m->key", 3);
+    emit_dispatch(g, g->prog->entries + op->a, op->u.b, NULL, act_prop, 3);
+    aml_buffer_appends(g->bh, "      free(heap);\n");
+  }
+  if (op->flags & AJSB_PF_NO_ADDITIONAL) {
+    aml_buffer_appends(g->bh, "      return false;\n");
+  } else if (op->flags & AJSB_PF_ADDITIONAL) {
+    aml_buffer_appends(g->bh, "      if (!");
+    emit_fn(g, op[1].a);
+    aml_buffer_appends(g->bh, "(m->value)) return false;\n");
+  } else {
+    aml_buffer_appends(g->bh, "      (void)m;\n");
+  }
+  aml_buffer_appends(g->bh, "    }\n  }\n");
+}
+
+static void emit_required(gen_t *g, const ajsb_op_t *op) {
+  aml_buffer_appends(g->bh, "  if (k == T_OBJECT) {\n");
+  uint32_t bits = op->u.c;
+  for (uint32_t w = 0; bits; w++) {
+    uint64_t want = bits >= 64 ? UINT64_MAX : ((uint64_t)1 << bits) - 1;
+    aml_buffer_appendf(g->bh, "    if ((seen[%u] & 0x%llxull) != 0x%llxull) return false;\n",
+                       w, (unsigned long long)want, (unsigned long long)want);
+    bits = bits >= 64 ? bits - 64 : 0;
+  }
+  const ajsb_entry_t *e = g->prog->entries + op->a, *end = e + op->u.b;
+  for (; e < end; e++) {
+    aml_buffer_appends(g->bh, "    if (!member_of(j, ");
+    emit_str(g, ajsb_entry_str(g->prog, e), e->len);
+    aml_buffer_appendf(g->bh, ", %u)) return false;\n", e->len);
+  }
+  aml_buffer_appends(g->bh, "  }\n");
+}
+
+/* One function per node: the interpreter loop, unrolled. */
+static void emit_node(gen_t *g, uint32_t node) {
+  const ajsb_op_t *ops = g->prog->ops;
+  uint32_t words = 0;
+  for (const ajsb_op_t *op = ops + node; op->op != AJSB_OP_END; op++) {
+    if (op->op == AJSB_OP_ENUM) emit_enum_fn(g, (uint32_t)(op - ops));
+    if (op->op == AJSB_OP_PATTERN) emit_pattern_table(g, (uint32_t)(op - ops));
+    if (op->op == AJSB_OP_REQUIRED) words = (op->u.c + 63) / 64;
+  }
+
+  aml_buffer_appends(g->bh, "static bool ");
+  emit_fn(g, node);
+  aml_buffer_appends(g->bh, "(ajson_t *j) {\n");
+  if (ops[node].op == AJSB_OP_FALSE) {
+    aml_buffer_appends(g->bh, "  (void)j;\n  return false;\n}\n\n");
+    return;
+  }
+  aml_buffer_appends(g->bh, "  unsigned k = kind_of(j);\n  (void)k;\n");
+  if (words) aml_buffer_appendf(g->bh, "  uint64_t seen[%u] = {0};\n", words);
+
+  for (const ajsb_op_t *op = ops + node; op->op != AJSB_OP_END; op++) {
+    switch ((ajsb_opcode_t)op->op) {
+    case AJSB_OP_END:
+    case AJSB_OP_FALSE:
+    case AJSB_OP_ADDITIONAL:
+      break;
+    case AJSB_OP_TYPE:
+      if (op->a & AJSB_T_INTEGER)
+        aml_buffer_appendf(g->bh, "  if (!(k & %u) && !is_integer(k, j)) return false;\n", op->a & ~AJSB_T_INTEGER);
+      else
+        aml_buffer_appendf(g->bh, "  if (!(k & %u)) return false;\n", op->a);
+      break;
+    case AJSB_OP_ENUM:
+      aml_buffer_appendf(g->bh, "  if (!%s_e%u(j, k)) return false;\n", g->name, (uint32_t)(op - ops));
+      break;
+    case AJSB_OP_MINIMUM:      emit_bound(g, op, ">="); break;
+    case AJSB_OP_MAXIMUM:      emit_bound(g, op, "<="); break;
+    case AJSB_OP_EXCL_MINIMUM: emit_bound(g, op, ">");  break;
+    case AJSB_OP_EXCL_MAXIMUM: emit_bound(g, op, "<");  break;
+    case AJSB_OP_MIN_ITEMS:
+      aml_buffer_appendf(g->bh, "  if (k == T_ARRAY && ajsona_count(j) < %u) return false;\n", op->a);
+      break;
+    case AJSB_OP_MAX_ITEMS:
+      aml_buffer_appendf(g->bh, "  if (k == T_ARRAY && ajsona_count(j) > %u) return false;\n", op->a);
+      break;
+    case AJSB_OP_UNIQUE_ITEMS:
+      aml_buffer_appends(g->bh, "  if (k == T_ARRAY && !unique_items(j)) return false;\n");
+      break;
+    case AJSB_OP_FORMAT:
+    case AJSB_OP_PATTERN:
+      emit_string_check(g, op, (uint32_t)(op - ops));
+      break;
+    case AJSB_OP_ITEMS:
+      aml_buffer_appends(g->bh, "  if (k == T_ARRAY)\n"
+                                "    for (ajsona_t *a = ajsona_first(j); a; a = ajsona_next(a))\n"
+                                "      if (!");
+      emit_fn(g, op->a);
+      aml_buffer_appends(g->bh, "(a->value)) return false;\n");
+      break;
+    case AJSB_OP_PROPERTIES:
+      emit_properties(g, op);
+      break;
+    case AJSB_OP_REQUIRED:
+      emit_required(g, op);
+      break;
+    case AJSB_OP_ALL_OF:
+      if (!op->u.b) break;
+      aml_buffer_appends(g->bh, "  if (!(");
+      emit_list(g, op, " && ");
+      aml_buffer_appends(g->bh, ")) return false;\n");
+      break;
+    case AJSB_OP_ANY_OF:
+      aml_buffer_appends(g->bh, "  if (!(");
+      if (op->u.b) emit_list(g, op, " || ");
+      else aml_buffer_appends(g->bh, "false");
+      aml_buffer_appends(g->bh, ")) return false;\n");
+      break;
+    case AJSB_OP_ONE_OF:
+      aml_buffer_appends(g->bh, "  {\n    unsigned matched = 0;\n");
+      for (uint32_t i = 0; i < op->u.b; i++) {
+        aml_buffer_appends(g->bh, i ? "    if (matched < 2 && " : "    if (");
+        emit_fn(g, g->prog->lists[op->a + i]);
+        aml_buffer_appends(g->bh, "(j)) matched++;\n");
+      }
+      aml_buffer_appends(g->bh, "    if (matched != 1) return false;\n  }\n");
+      break;
+    case AJSB_OP_NOT:
+    case AJSB_OP_REF:
+      aml_buffer_appends(g->bh, op->op == AJSB_OP_NOT ? "  if (" : "  if (!");
+      emit_fn(g, op->a);
+      aml_buffer_appends(g->bh, "(j)) return false;\n");
+      break;
+    }
+  }
+  aml_buffer_appends(g->bh, "  return true;\n}\n\n");
+}
+
+static bool is_identifier(const char *s) {
+  if (!s || !(isalpha((unsigned char)*s) || *s == '_')) return false;
+  for (s++; *s; s++)
+    if (!isalnum((unsigned char)*s) && *s != '_') return false;
+  return true;
+}
+
+/* ── Public API ─────────────────────────────────────────────────────────── */
+
+bool ajsb_codegen_c(aml_buffer_t *bh, ajson_t *schema, const char *name) {
+  if (!bh || !schema || !is_identifier(name)) return false;
+  aml_pool_t *p = aml_pool_init(16384);
+  const ajsb_program_t *prog = ajsb_compile(p, schema);
+  if (!prog) {
+    aml_pool_destroy(p);
+    return false;
+  }
+  gen_t g = { bh, prog, name };
+
+  aml_buffer_appendf(bh, "/* Generated by ajsb_codegen_c; do not edit.\n"
+                         "   bool %s_validate(ajson_t *instance); */\n\n", name);
+  aml_buffer_appends(bh, prelude);
+  aml_buffer_appends(bh, "\n");
+  aml_buffer_appends(bh, prelude_text);
+  aml_buffer_appends(bh, "\n");
+  for (uint32_t i = 0; i < prog->num_ops; i++)
+    if (prog->ops[i].op == AJSB_OP_UNIQUE_ITEMS) {
+      aml_buffer_appends(bh, prelude_unique);
+      aml_buffer_appends(bh, "\n");
+      break;
+    }
+
+  /* a node starts at 0 and after every END */
+  for (uint32_t at = 0, start = 1; at < prog->num_ops; at++) {
+    if (start) {
+      aml_buffer_appends(bh, "static bool ");
+      emit_fn(&g, at);
+      aml_buffer_appends(bh, "(ajson_t *j);\n");
+    }
+    start = prog->ops[at].op == AJSB_OP_END;
+  }
+  aml_buffer_appends(bh, "\n");
+  for (uint32_t at = 0, start = 1; at < prog->num_ops; at++) {
+    if (start) emit_node(&g, at);
+    start = prog->ops[at].op == AJSB_OP_END;
+  }
+
+  aml_buffer_appendf(bh, "bool %s_validate(ajson_t *instance) {\n  return instance && ", name);
+  emit_fn(&g, prog->root);
+  aml_buffer_appends(bh, "(instance);\n}\n");
+  aml_pool_destroy(p);
+  return true;
+}
+
+bool ajsb_codegen_h(aml_buffer_t *bh, const char *name) {
+  if (!bh || !is_identifier(name)) return false;
+  size_t n = strlen(name);
+  char *guard = (char *)aml_malloc(n + 1);
+  for (size_t i = 0; i <= n; i++) guard[i] = (char)toupper((unsigned char)name[i]);
+  aml_buffer_appendf(bh, "/* Generated by ajsb_codegen_h; do not edit. */\n\n"
+                         "#ifndef %s_VALIDATE_H\n#define %s_VALIDATE_H\n\n"
+                         "#include \"a-json-library/ajson.h\"\n#include <stdbool.h>\n\n"
+                         "#ifdef __cplusplus\nextern \"C\" {\n#endif\n\n"
+                         "bool %s_validate(ajson_t *instance);\n\n"
+                         "#ifdef __cplusplus\n}\n#endif\n#endif\n", guard, guard, name);
+  aml_free(guard);
+  return true;
+}
+
+static bool write_file(const char *path, aml_buffer_t *bh) {
+  size_t plen = strlen(path);
+  char *tmp = (char *)aml_malloc(plen + 8);
+  memcpy(tmp, path, plen);
+  memcpy(tmp + plen, ".tmp", 5);
+  FILE *out = fopen(tmp, "wb");
+  bool ok = out && fwrite(aml_buffer_data(bh), 1, aml_buffer_length(bh), out) == aml_buffer_length(bh);
+  if (out && fclose(out)) ok = false;
+  if (ok) ok = rename(tmp, path) == 0;
+  if (!ok) remove(tmp);
+  aml_free(tmp);
+  return ok;
+}
+
+bool ajsb_codegen_file(const char *c_path, const char *header_path, ajson_t *schema,
+                       const char *name) {
+  if (!c_path || !*c_path) return false;
+  aml_buffer_t *bh = aml_buffer_init(1 << 14);
+  bool ok = ajsb_codegen_c(bh, schema, name) && write_file(c_path, bh);
+  if (ok && header_path) {
+    aml_buffer_clear(bh);
+    ok = ajsb_codegen_h(bh, name) && write_file(header_path, bh);
+  }
+  aml_buffer_destroy(bh);
+  return ok;
+}
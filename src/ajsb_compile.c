@@ -0,0 +1,754 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#include "ajsb_program.h"
+#include "a-json-schema-builder-library/ajsb_format.h"
+#include "a-json-schema-builder-library/ajsb_link.h"
+#include "a-memory-library/aml_alloc.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Keywords the compiler lowers. Everything else is an annotation. */
+enum {
+  KW_TYPE, KW_ENUM, KW_CONST,
+  KW_MINIMUM, KW_MAXIMUM, KW_EXCL_MINIMUM, KW_EXCL_MAXIMUM,
+  KW_ITEMS, KW_MIN_ITEMS, KW_MAX_ITEMS, KW_UNIQUE_ITEMS,
+  KW_FORMAT, KW_PATTERN,
+  KW_PROPERTIES, KW_ADDITIONAL, KW_REQUIRED,
+  KW_ANY_OF, KW_ONE_OF, KW_ALL_OF, KW_NOT,
+  KW_REF, KW_DYNAMIC_REF,
+  KW_COUNT
+};
+
+static const char *const keyword_names[KW_COUNT] = {
+  "type", "enum", "const",
+  "minimum", "maximum", "exclusiveMinimum", "exclusiveMaximum",
+  "items", "minItems", "maxItems", "uniqueItems",
+  "format", "pattern",
+  "properties", "additionalProperties", "required",
+  "anyOf", "oneOf", "allOf", "not",
+  "$ref", "$dynamicRef"
+};
+
+static int keyword(const char *k) {
+  for (int i = 0; i < KW_COUNT; i++)
+    if (!strcmp(k, keyword_names[i])) return i;
+  return -1;
+}
+
+typedef struct {
+  ajson_t  *schema;
+  uint32_t  node;
+} seen_t;
+
+typedef struct {
+  aml_pool_t   *p;
+  ajsb_link_t  *link;
+
+  ajsb_op_t    *ops;      uint32_t num_ops,     cap_ops;
+  ajsb_entry_t *entries;  uint32_t num_entries, cap_entries;
+  uint32_t     *lists;    uint32_t num_lists,   cap_lists;
+  char         *strings;  uint32_t strings_len, cap_strings;
+
+  seen_t       *seen;     uint32_t num_seen,    seen_mask;
+  uint32_t      num_adapt;
+  bool          failed;
+} compiler_t;
+
+/* ── Scratch growth (scratch lives in aml_malloc memory until finish) ───── */
+
+static bool reserve(compiler_t *c, void **arr, uint32_t *cap, uint32_t need, size_t elem) {
+  if (need <= *cap) return true;
+  uint32_t n = *cap ? *cap : 64;
+  while (n < need) n *= 2;
+  void *r = aml_realloc(*arr, (size_t)n * elem);
+  if (!r) { c->failed = true; return false; }
+  *arr = r;
+  *cap = n;
+  return true;
+}
+
+static uint32_t emit(compiler_t *c, uint8_t opcode) {
+  if (!reserve(c, (void **)&c->ops, &c->cap_ops, c->num_ops + 1, sizeof(ajsb_op_t)))
+    return 0;
+  ajsb_op_t *op = c->ops + c->num_ops;
+  memset(op, 0, sizeof(*op));
+  op->op = opcode;
+  return c->num_ops++;
+}
+
+static uint32_t add_string(compiler_t *c, const char *s, size_t len) {
+  if (!reserve(c, (void **)&c->strings, &c->cap_strings,
+               c->strings_len + (uint32_t)len + 1, 1))
+    return 0;
+  uint32_t off = c->strings_len;
+  memcpy(c->strings + off, s, len);
+  c->strings[off + len] = 0;
+  c->strings_len += (uint32_t)len + 1;
+  return off;
+}
+
+static uint32_t add_entries(compiler_t *c, uint32_t n) {
+  if (!reserve(c, (void **)&c->entries, &c->cap_entries,
+               c->num_entries + n, sizeof(ajsb_entry_t)))
+    return 0;
+  uint32_t first = c->num_entries;
+  memset(c->entries + first, 0, (size_t)n * sizeof(ajsb_entry_t));
+  c->num_entries += n;
+  return first;
+}
+
+static void set_entry(compiler_t *c, uint32_t idx, const char *s, uint32_t node) {
+  size_t len = strlen(s);
+  uint32_t off = add_string(c, s, len);
+  ajsb_entry_t *e = c->entries + idx;
+  e->str  = off;
+  e->len  = (uint32_t)len;
+  e->hash = ajsb_hash32(s, len);
+  e->node = node;
+}
+
+/* Names and string members are stored canonical (ajsb_json_canonical). */
+static const char *canonical(compiler_t *c, const char *raw) {
+  size_t len = strlen(raw);
+  if (!memchr(raw, '\\', len)) return raw;
+  char *s = (char *)aml_pool_alloc(c->p, len + 1);
+  s[ajsb_json_canonical(s, raw, len)] = 0;
+  return s;
+}
+
+static uint32_t add_lists(compiler_t *c, uint32_t n) {
+  if (!reserve(c, (void **)&c->lists, &c->cap_lists, c->num_lists + n, sizeof(uint32_t)))
+    return 0;
+  uint32_t first = c->num_lists;
+  memset(c->lists + first, 0, (size_t)n * sizeof(uint32_t));
+  c->num_lists += n;
+  return first;
+}
+
+/* ── Schema pointer → node id (handles shared subtrees and recursion) ──── */
+
+static inline size_t ptr_hash(const void *v) {
+  uintptr_t x = (uintptr_t)v;
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  return (size_t)x;
+}
+
+static uint32_t seen_get(compiler_t *c, ajson_t *s) {
+  if (!c->seen) return AJSB_NONE;
+  for (size_t i = ptr_hash(s) & c->seen_mask;; i = (i + 1) & c->seen_mask) {
+    if (!c->seen[i].schema) return AJSB_NONE;
+    if (c->seen[i].schema == s) return c->seen[i].node;
+  }
+}
+
+static void seen_put(compiler_t *c, ajson_t *s, uint32_t node) {
+  if ((c->num_seen + 1) * 2 > c->seen_mask + 1 || !c->seen) {
+    uint32_t size = c->seen ? (c->seen_mask + 1) * 2 : 64;
+    seen_t *n = (seen_t *)aml_calloc(size, sizeof(seen_t));
+    if (!n) { c->failed = true; return; }
+    for (uint32_t i = 0; c->seen && i <= c->seen_mask; i++) {
+      if (!c->seen[i].schema) continue;
+      size_t j = ptr_hash(c->seen[i].schema) & (size - 1);
+      while (n[j].schema) j = (j + 1) & (size - 1);
+      n[j] = c->seen[i];
+    }
+    aml_free(c->seen);
+    c->seen = n;
+    c->seen_mask = size - 1;
+  }
+  size_t i = ptr_hash(s) & c->seen_mask;
+  while (c->seen[i].schema) i = (i + 1) & c->seen_mask;
+  c->seen[i].schema = s;
+  c->seen[i].node = node;
+  c->num_seen++;
+}
+
+/* ── Keyword lowering ───────────────────────────────────────────────────── */
+
+static uint32_t type_bit(const char *t) {
+  if (!strcmp(t, "null"))    return AJSB_T_NULL;
+  if (!strcmp(t, "boolean")) return AJSB_T_BOOLEAN;
+  if (!strcmp(t, "object"))  return AJSB_T_OBJECT;
+  if (!strcmp(t, "array"))   return AJSB_T_ARRAY;
+  if (!strcmp(t, "number"))  return AJSB_T_NUMBER;
+  if (!strcmp(t, "string"))  return AJSB_T_STRING;
+  if (!strcmp(t, "integer")) return AJSB_T_INTEGER;
+  return 0;
+}
+
+static void lower_type(compiler_t *c, ajson_t *v) {
+  uint32_t mask = 0;
+  if (ajson_is_string(v)) mask = type_bit(ajson_to_str(v, ""));
+  else if (ajson_is_array(v)) {
+    for (ajsona_t *n = ajsona_first(v); n; n = ajsona_next(n)) {
+      uint32_t bit = ajson_is_string(n->value) ? type_bit(ajson_to_str(n->value, "")) : 0;
+      if (!bit) { mask = 0; break; }
+      mask |= bit;
+    }
+  }
+  if (!mask) { c->failed = true; return; }
+  uint32_t at = emit(c, AJSB_OP_TYPE);
+  c->ops[at].a = mask;
+}
+
+static void enum_value(compiler_t *c, uint32_t idx, ajson_t *v) {
+  if (ajson_is_string(v))                          set_entry(c, idx, canonical(c, ajson_to_str(v, "")), AJSB_V_STRING);
+  else if (ajson_is_number(v) || ajson_is_decimal(v)) set_entry(c, idx, ajson_to_str(v, "0"), AJSB_V_NUMBER);
+  else if (ajson_is_true(v))                       set_entry(c, idx, "", AJSB_V_TRUE);
+  else if (ajson_is_false(v))                      set_entry(c, idx, "", AJSB_V_FALSE);
+  else if (ajson_is_null(v))                       set_entry(c, idx, "", AJSB_V_NULL);
+  else {
+    set_entry(c, idx, ajson_stringify(c->p, v), AJSB_V_JSON);
+    c->entries[idx].hash = (uint32_t)ajsb_json_hash(v);
+  }
+}
+
+/* ── Enum membership ───────────────────────────────────────────────────── */
+
+#define ENUM_INDEX_MIN 16          /* smaller enums scan their precomputed hashes */
+#define ENUM_SEED_MAX  (1u << 16)  /* per bucket before giving up on the index */
+
+typedef struct {
+  uint64_t h;
+  uint32_t entry;
+  uint32_t bucket;
+} enum_key_t;
+
+static uint64_t member_hash(const compiler_t *c, const ajsb_entry_t *e) {
+  const char *s = c->strings + e->str;
+  if (e->node == AJSB_V_NUMBER) return ajsb_number_hash(strtod(s, NULL));
+  return ajsb_value_hash(e->node, s, e->len);
+}
+
+static bool member_eq(const compiler_t *c, const ajsb_entry_t *x, const ajsb_entry_t *y) {
+  if (x->node != y->node) return false;
+  const char *a = c->strings + x->str, *b = c->strings + y->str;
+  if (x->node == AJSB_V_NUMBER) return strtod(a, NULL) == strtod(b, NULL);
+  return x->len == y->len && !memcmp(a, b, x->len);
+}
+
+static int by_hash(const void *a, const void *b) {
+  const enum_key_t *x = (const enum_key_t *)a, *y = (const enum_key_t *)b;
+  if (x->h != y->h) return x->h < y->h ? -1 : 1;
+  return x->entry < y->entry ? -1 : x->entry > y->entry;
+}
+
+typedef struct {
+  uint32_t size, first;
+} bucket_t;
+
+static int by_size(const void *a, const void *b) {
+  const bucket_t *x = (const bucket_t *)a, *y = (const bucket_t *)b;
+  if (x->size != y->size) return x->size > y->size ? -1 : 1;
+  return x->first < y->first ? -1 : x->first > y->first;
+}
+
+/* Hash and displace: buckets with several keys, largest first, search for a
+   seed that sends every key to a free slot; single keys then take the
+   remaining slots directly. keys are the string and number members, with
+   distinct hashes. The op stays unindexed if a bucket finds no seed. */
+static void build_mph(compiler_t *c, uint32_t at, enum_key_t *keys, uint32_t n) {
+  uint32_t nb = n / 2 + 1;
+  bucket_t *b = (bucket_t *)aml_calloc(nb, sizeof(bucket_t));
+  enum_key_t *sorted = (enum_key_t *)aml_malloc((size_t)n * sizeof(enum_key_t));
+  uint32_t *g = (uint32_t *)aml_calloc(nb, sizeof(uint32_t));
+  uint32_t *slot_entry = (uint32_t *)aml_malloc((size_t)n * sizeof(uint32_t));
+  uint8_t *taken = (uint8_t *)aml_calloc(n, 1);
+  uint32_t *tried = (uint32_t *)aml_malloc((size_t)n * sizeof(uint32_t));
+  bucket_t *by = (bucket_t *)aml_malloc((size_t)nb * sizeof(bucket_t));
+  bool ok = b && sorted && g && slot_entry && taken && tried && by;
+
+  if (ok) {
+    for (uint32_t i = 0; i < n; i++) b[keys[i].bucket = (uint32_t)(keys[i].h >> 32) % nb].size++;
+    for (uint32_t i = 0, first = 0; i < nb; i++) { b[i].first = first; first += b[i].size; }
+    for (uint32_t i = 0; i < n; i++) sorted[b[keys[i].bucket].first++] = keys[i];
+    for (uint32_t i = 0; i < nb; i++) b[i].first -= b[i].size;
+    memcpy(by, b, (size_t)nb * sizeof(bucket_t));
+    qsort(by, nb, sizeof(bucket_t), by_size);
+  }
+
+  uint32_t i = 0;
+  for (; ok && i < nb && by[i].size > 1; i++) {
+    const enum_key_t *k = sorted + by[i].first;
+    uint32_t bucket = k->bucket, seed = 1, placed = 0;
+    for (; seed < ENUM_SEED_MAX; seed++) {
+      for (placed = 0; placed < by[i].size; placed++) {
+        uint32_t s = ajsb_mph_hash(k[placed].h, seed) % n;
+        if (taken[s]) break;
+        taken[s] = 1;
+        tried[placed] = s;
+      }
+      if (placed == by[i].size) break;
+      while (placed) taken[tried[--placed]] = 0;
+    }
+    if (seed == ENUM_SEED_MAX) { ok = false; break; }
+    g[bucket] = seed;
+    for (uint32_t j = 0; j < placed; j++) slot_entry[tried[j]] = k[j].entry;
+  }
+  for (uint32_t free_slot = 0; ok && i < nb && by[i].size == 1; i++) {
+    while (taken[free_slot]) free_slot++;
+    taken[free_slot] = 1;
+    g[sorted[by[i].first].bucket] = AJSB_MPH_DIRECT | free_slot;
+    slot_entry[free_slot] = sorted[by[i].first].entry;
+  }
+
+  if (ok) {
+    uint32_t first = add_lists(c, 2 + nb + n);
+    if (!c->failed) {
+      uint32_t *w = c->lists + first;
+      w[0] = nb;
+      w[1] = n;
+      memcpy(w + 2, g, (size_t)nb * sizeof(uint32_t));
+      memcpy(w + 2 + nb, slot_entry, (size_t)n * sizeof(uint32_t));
+      c->ops[at].u.c = first;
+    }
+  }
+  aml_free(b);
+  aml_free(by);
+  aml_free(sorted);
+  aml_free(g);
+  aml_free(slot_entry);
+  aml_free(taken);
+  aml_free(tried);
+}
+
+/* Drop repeated members (the first occurrence stays), record which kinds
+   are present and index large string/number sets. The op's entries are the
+   last ones added. */
+static void index_enum(compiler_t *c, uint32_t at) {
+  ajsb_op_t *op = c->ops + at;
+  op->u.c = AJSB_NONE;
+  if (c->failed) return;
+  uint32_t n = op->u.b;
+  enum_key_t *keys = (enum_key_t *)aml_malloc((n ? n : 1) * sizeof(enum_key_t));
+  uint8_t *dup = (uint8_t *)aml_calloc(n ? n : 1, 1);
+  if (!keys || !dup) { aml_free(keys); aml_free(dup); c->failed = true; return; }
+
+  for (uint32_t i = 0; i < n; i++) {
+    keys[i].h = member_hash(c, c->entries + op->a + i);
+    keys[i].entry = i;
+  }
+  qsort(keys, n, sizeof(enum_key_t), by_hash);
+  bool collision = false;
+  for (uint32_t i = 0; i < n; i++)
+    for (uint32_t j = i + 1; j < n && keys[j].h == keys[i].h; j++) {
+      if (dup[keys[i].entry] || dup[keys[j].entry]) continue;
+      const ajsb_entry_t *x = c->entries + op->a + keys[i].entry;
+      const ajsb_entry_t *y = c->entries + op->a + keys[j].entry;
+      if (member_eq(c, x, y)) dup[keys[j].entry] = 1;
+      else collision = true;
+    }
+
+  uint32_t kept = 0;
+  for (uint32_t i = 0; i < n; i++) {
+    if (dup[i]) continue;
+    c->entries[op->a + kept] = c->entries[op->a + i];
+    op->flags |= (uint8_t)(1u << c->entries[op->a + kept].node);
+    kept++;
+  }
+  c->num_entries -= n - kept;
+  op->u.b = kept;
+
+  uint32_t m = 0;
+  for (uint32_t i = 0; i < kept; i++) {
+    const ajsb_entry_t *e = c->entries + op->a + i;
+    if (e->node != AJSB_V_STRING && e->node != AJSB_V_NUMBER) continue;
+    keys[m].h = member_hash(c, e);
+    keys[m++].entry = op->a + i;
+  }
+  if (m >= ENUM_INDEX_MIN && !collision) build_mph(c, at, keys, m);
+  aml_free(keys);
+  aml_free(dup);
+}
+
+static void lower_enum(compiler_t *c, ajson_t *en, ajson_t *cn) {
+  if (en && ajson_is_array(en)) {
+    uint32_t n = (uint32_t)ajsona_count(en);
+    uint32_t first = add_entries(c, n), i = first;
+    for (ajsona_t *a = ajsona_first(en); a; a = ajsona_next(a)) enum_value(c, i++, a->value);
+    uint32_t at = emit(c, AJSB_OP_ENUM);
+    c->ops[at].a = first;
+    c->ops[at].u.b = n;
+    index_enum(c, at);
+  }
+  if (cn) {
+    uint32_t first = add_entries(c, 1);
+    enum_value(c, first, cn);
+    uint32_t at = emit(c, AJSB_OP_ENUM);
+    c->ops[at].a = first;
+    c->ops[at].u.b = 1;
+    index_enum(c, at);
+  }
+}
+
+static void lower_bound(compiler_t *c, uint8_t opcode, ajson_t *v) {
+  if (!v || !(ajson_is_number(v) || ajson_is_decimal(v))) return;
+  uint32_t at = emit(c, opcode);
+  c->ops[at].d = ajson_to_double(v, 0);
+}
+
+static void lower_count(compiler_t *c, uint8_t opcode, ajson_t *v) {
+  if (!v || !(ajson_is_number(v) || ajson_is_decimal(v))) return;
+  int n = ajson_to_int(v, 0);
+  uint32_t at = emit(c, opcode);
+  c->ops[at].a = n < 0 ? 0 : (uint32_t)n;
+}
+
+static void lower_format(compiler_t *c, ajson_t *v) {
+  if (!v || !ajson_is_string(v)) return;
+  ajsb_format_t f = ajsb_format_id(ajson_to_str(v, ""));
+  if (f == AJSB_FORMAT_NONE) return;
+  uint32_t at = emit(c, AJSB_OP_FORMAT);
+  c->ops[at].a = (uint32_t)f;
+}
+
+/* Patterns outside the supported subset stay annotations. */
+static void lower_pattern(compiler_t *c, ajson_t *v) {
+  if (!v || !ajson_is_string(v)) return;
+  const char *re = ajson_to_strd(c->p, v, "");
+  uint32_t *words, count;
+  if (!ajsb_pattern_compile(re, strlen(re), &words, &count) || !count) return;
+  uint32_t first = add_lists(c, count);
+  if (!c->failed) memcpy(c->lists + first, words, (size_t)count * sizeof(uint32_t));
+  aml_free(words);
+  uint32_t at = emit(c, AJSB_OP_PATTERN);
+  c->ops[at].a = first;
+}
+
+static uint32_t prop_lookup(compiler_t *c, const ajsb_op_t *op, const char *key) {
+  size_t len = strlen(key);
+  uint32_t h = ajsb_hash32(key, len);
+  for (uint32_t i = 0; i < op->u.b; i++) {
+    ajsb_entry_t *e = c->entries + op->a + i;
+    if (e->hash == h && e->len == len && !memcmp(c->strings + e->str, key, len))
+      return op->a + i;
+  }
+  return AJSB_NONE;
+}
+
+/* Open-addressed slots (entry index + 1) for wide objects. */
+static void index_props(compiler_t *c, uint32_t at) {
+  uint32_t count = c->ops[at].u.b;
+  if (count <= 8) { c->ops[at].u.c = AJSB_NONE; return; }
+  uint16_t bits = 1;
+  while ((1u << bits) < count * 2) bits++;
+  uint32_t slots = add_lists(c, 1u << bits);
+  uint32_t mask = (1u << bits) - 1;
+  ajsb_op_t *op = c->ops + at;
+  op->u.c = slots;
+  op->bits = bits;
+  for (uint32_t i = 0; i < count; i++) {
+    uint32_t e = op->a + i;
+    uint32_t s = c->entries[e].hash & mask;
+    while (c->lists[slots + s]) s = (s + 1) & mask;
+    c->lists[slots + s] = e + 1;
+  }
+}
+
+static void lower_required(compiler_t *c, ajson_t *req, uint32_t props_at) {
+  if (!ajson_is_array(req)) return;
+  uint32_t bits = 0, extra_first = c->num_entries, extras = 0;
+  for (ajsona_t *a = ajsona_first(req); a; a = ajsona_next(a)) {
+    if (!ajson_is_string(a->value)) continue;
+    const char *name = canonical(c, ajson_to_str(a->value, ""));
+    uint32_t e = props_at != AJSB_NONE ? prop_lookup(c, c->ops + props_at, name) : AJSB_NONE;
+    if (e != AJSB_NONE && c->entries[e].aux) continue;           /* duplicate */
+    if (e != AJSB_NONE && bits < AJSB_REQ_BITS) {
+      c->entries[e].aux = ++bits;
+      continue;
+    }
+    bool dup = false;
+    size_t len = strlen(name);
+    for (uint32_t i = 0; i < extras && !dup; i++) {
+      ajsb_entry_t *x = c->entries + extra_first + i;
+      dup = x->len == len && !memcmp(c->strings + x->str, name, len);
+    }
+    if (dup) continue;
+    set_entry(c, add_entries(c, 1), name, 0);
+    extras++;
+  }
+  if (!bits && !extras) return;
+  uint32_t at = emit(c, AJSB_OP_REQUIRED);
+  c->ops[at].a = extra_first;
+  c->ops[at].u.b = extras;
+  c->ops[at].u.c = bits;
+}
+
+static uint32_t lower_list(compiler_t *c, uint8_t opcode, ajson_t *arr, uint32_t *at) {
+  *at = AJSB_NONE;
+  if (!arr || !ajson_is_array(arr)) return 0;
+  uint32_t n = (uint32_t)ajsona_count(arr);
+  uint32_t first = add_lists(c, n);
+  *at = emit(c, opcode);
+  c->ops[*at].a = first;
+  c->ops[*at].u.b = n;
+  return first;
+}
+
+static uint32_t compile_node(compiler_t *c, ajson_t *s);
+
+static void link_list(compiler_t *c, uint32_t at, ajson_t *arr) {
+  if (at == AJSB_NONE) return;
+  uint32_t i = c->ops[at].a;
+  for (ajsona_t *a = ajsona_first(arr); a && !c->failed; a = ajsona_next(a)) {
+    uint32_t child = compile_node(c, a->value);
+    c->lists[i++] = child;
+  }
+}
+
+static void link_child(compiler_t *c, uint32_t at, ajson_t *s) {
+  if (at == AJSB_NONE || c->failed) return;
+  uint32_t child = compile_node(c, s);
+  c->ops[at].a = child;
+}
+
+static uint32_t compile_node(compiler_t *c, ajson_t *s) {
+  if (c->failed) return 0;
+  uint32_t node = seen_get(c, s);
+  if (node != AJSB_NONE) return node;
+
+  node = c->num_ops;
+  seen_put(c, s, node);
+
+  if (ajson_is_true(s))  { emit(c, AJSB_OP_END); return node; }
+  if (ajson_is_false(s)) { emit(c, AJSB_OP_FALSE); emit(c, AJSB_OP_END); return node; }
+  if (!ajson_is_object(s)) { c->failed = true; return node; }
+
+  ajson_t *kw[KW_COUNT] = {0};
+  for (ajsono_t *n = ajsono_first(s); n; n = ajsono_next(n)) {
+    int k = keyword(n->key);
+    if (k >= 0) kw[k] = n->value;
+  }
+
+  /* Cheap scalar checks first, then containers, then subschemas. */
+  if (kw[KW_TYPE]) lower_type(c, kw[KW_TYPE]);
+  if (kw[KW_ENUM] || kw[KW_CONST]) lower_enum(c, kw[KW_ENUM], kw[KW_CONST]);
+  lower_bound(c, AJSB_OP_MINIMUM,      kw[KW_MINIMUM]);
+  lower_bound(c, AJSB_OP_MAXIMUM,      kw[KW_MAXIMUM]);
+  lower_bound(c, AJSB_OP_EXCL_MINIMUM, kw[KW_EXCL_MINIMUM]);
+  lower_bound(c, AJSB_OP_EXCL_MAXIMUM, kw[KW_EXCL_MAXIMUM]);
+  lower_count(c, AJSB_OP_MIN_ITEMS,    kw[KW_MIN_ITEMS]);
+  lower_count(c, AJSB_OP_MAX_ITEMS,    kw[KW_MAX_ITEMS]);
+  if (kw[KW_UNIQUE_ITEMS] && ajson_is_true(kw[KW_UNIQUE_ITEMS])) emit(c, AJSB_OP_UNIQUE_ITEMS);
+  lower_format(c, kw[KW_FORMAT]);
+  lower_pattern(c, kw[KW_PATTERN]);
+
+  uint32_t items_at = AJSB_NONE;
+  if (kw[KW_ITEMS] && !ajson_is_array(kw[KW_ITEMS])) items_at = emit(c, AJSB_OP_ITEMS);
+
+  ajson_t *props = kw[KW_PROPERTIES] && ajson_is_object(kw[KW_PROPERTIES]) ? kw[KW_PROPERTIES] : NULL;
+  ajson_t *addl  = kw[KW_ADDITIONAL];
+  uint32_t props_at = AJSB_NONE, addl_at = AJSB_NONE;
+  if (props || (addl && !ajson_is_true(addl))) {
+    uint32_t n = props ? (uint32_t)ajsono_count(props) : 0;
+    uint32_t first = add_entries(c, n), i = first;
+    for (ajsono_t *m = props ? ajsono_first(props) : NULL; m; m = ajsono_next(m))
+      set_entry(c, i++, canonical(c, m->key), 0);
+    props_at = emit(c, AJSB_OP_PROPERTIES);
+    c->ops[props_at].a = first;
+    c->ops[props_at].u.b = n;
+    index_props(c, props_at);
+    if (addl && ajson_is_false(addl)) c->ops[props_at].flags |= AJSB_PF_NO_ADDITIONAL;
+    else if (addl && ajson_is_object(addl)) {
+      c->ops[props_at].flags |= AJSB_PF_ADDITIONAL;
+      addl_at = emit(c, AJSB_OP_ADDITIONAL);
+    }
+  }
+  if (kw[KW_REQUIRED]) lower_required(c, kw[KW_REQUIRED], props_at);
+
+  uint32_t any_at, one_at, all_at;
+  lower_list(c, AJSB_OP_ALL_OF, kw[KW_ALL_OF], &all_at);
+  lower_list(c, AJSB_OP_ANY_OF, kw[KW_ANY_OF], &any_at);
+  lower_list(c, AJSB_OP_ONE_OF, kw[KW_ONE_OF], &one_at);
+
+  uint32_t not_at  = kw[KW_NOT] ? emit(c, AJSB_OP_NOT) : AJSB_NONE;
+  uint32_t ref_at  = kw[KW_REF] ? emit(c, AJSB_OP_REF) : AJSB_NONE;
+  uint32_t dref_at = kw[KW_DYNAMIC_REF] ? emit(c, AJSB_OP_REF) : AJSB_NONE;
+  emit(c, AJSB_OP_END);
+
+  /* Children are laid out after this node so its ops stay contiguous. */
+  link_child(c, items_at, kw[KW_ITEMS]);
+  if (props_at != AJSB_NONE && props) {
+    uint32_t i = c->ops[props_at].a;
+    for (ajsono_t *m = ajsono_first(props); m && !c->failed; m = ajsono_next(m)) {
+      uint32_t child = compile_node(c, m->value);
+      c->entries[i++].node = child;
+    }
+  }
+  link_child(c, addl_at, addl);
+  link_list(c, all_at, kw[KW_ALL_OF]);
+  link_list(c, any_at, kw[KW_ANY_OF]);
+  link_list(c, one_at, kw[KW_ONE_OF]);
+  link_child(c, not_at, kw[KW_NOT]);
+
+  /* A reference loop that never descends would recurse forever. */
+  if ((ref_at != AJSB_NONE || dref_at != AJSB_NONE) && ajsb_link_cyclic(c->link, s))
+    c->failed = true;
+  if (ref_at != AJSB_NONE) {
+    ajson_t *target = ajsb_link_ref(c->link, s);
+    if (!target) c->failed = true;
+    else link_child(c, ref_at, target);
+  }
+  if (dref_at != AJSB_NONE) {
+    ajson_t *target = ajsb_link_dynamic_ref(c->link, s);
+    if (!target) c->failed = true;
+    else link_child(c, dref_at, target);
+  }
+  return node;
+}
+
+/* ── Unions ─────────────────────────────────────────────────────────────── */
+
+#define ADAPT_MAX 0xfffe  /* branch numbers + 1 fit in 16 bits */
+
+/* Follow nodes that are nothing but a $ref. */
+static uint32_t resolve(const compiler_t *c, uint32_t node) {
+  for (int depth = 0; depth < 16; depth++) {
+    const ajsb_op_t *op = c->ops + node;
+    if (op[0].op != AJSB_OP_REF || op[1].op != AJSB_OP_END) break;
+    node = op->a;
+  }
+  return node;
+}
+
+/* The enum a branch pins its required property name to: the only enum of
+   the property's schema, with scalar members. NULL if there is none. */
+static const ajsb_op_t *pinned(compiler_t *c, uint32_t branch, const char *name) {
+  const ajsb_op_t *props = NULL;
+  for (const ajsb_op_t *op = c->ops + branch; op->op != AJSB_OP_END && !props; op++)
+    if (op->op == AJSB_OP_PROPERTIES) props = op;
+  uint32_t e = props ? prop_lookup(c, props, name) : AJSB_NONE;
+  if (e == AJSB_NONE || !c->entries[e].aux) return NULL;
+  const ajsb_op_t *en = NULL;
+  for (const ajsb_op_t *op = c->ops + resolve(c, c->entries[e].node); op->op != AJSB_OP_END; op++) {
+    if (op->op != AJSB_OP_ENUM) continue;
+    if (en) return NULL;
+    en = op;
+  }
+  if (!en || !en->u.b || (en->flags & (1u << AJSB_V_JSON))) return NULL;
+  return en;
+}
+
+/* Map every pinned value of the property named by entry name to its branch.
+   Fails (and adds nothing) unless each branch pins the property and no value
+   is pinned by two branches. */
+static bool build_dispatch(compiler_t *c, uint32_t at, uint32_t name) {
+  uint32_t n = c->ops[at].u.b, list = c->ops[at].a, total = 0;
+  const ajsb_op_t **en = (const ajsb_op_t **)aml_malloc((size_t)n * sizeof(*en));
+  if (!en) { c->failed = true; return false; }
+  bool ok = true;
+  for (uint32_t i = 0; i < n && ok; i++) {
+    ok = (en[i] = pinned(c, resolve(c, c->lists[list + i]), c->strings + c->entries[name].str)) != NULL;
+    if (ok) total += en[i]->u.b;
+  }
+  uint16_t bits = 1;
+  while (ok && (1u << bits) < total * 2) bits++;
+  uint32_t first = ok ? add_lists(c, 2 + (2u << bits)) : 0;
+  ok = ok && !c->failed;
+  if (ok) {
+    uint32_t *w = c->lists + first, mask = (1u << bits) - 1;
+    w[0] = name;
+    w[1] = bits;
+    for (uint32_t i = 0; i < n && ok; i++)
+      for (uint32_t v = en[i]->a; v < en[i]->a + en[i]->u.b && ok; v++) {
+        uint32_t s = (uint32_t)member_hash(c, c->entries + v) & mask;
+        for (; w[2 + 2 * s]; s = (s + 1) & mask)
+          if (member_eq(c, c->entries + w[2 + 2 * s] - 1, c->entries + v)) ok = false;
+        w[2 + 2 * s] = v + 1;
+        w[3 + 2 * s] = i;
+      }
+    if (ok) {
+      c->ops[at].flags |= AJSB_UF_DISPATCH;
+      c->ops[at].u.c = first;
+    }
+    else c->num_lists = first;
+  }
+  aml_free(en);
+  return ok;
+}
+
+/* Look for a discriminator among the first branch's required properties;
+   an anyOf without one gets counters to order its branches by. */
+static void index_union(compiler_t *c, uint32_t at) {
+  uint32_t n = c->ops[at].u.b;
+  if (n < 2) return;
+  uint32_t first = resolve(c, c->lists[c->ops[at].a]);
+  for (const ajsb_op_t *op = c->ops + first; op->op != AJSB_OP_END; op++) {
+    if (op->op != AJSB_OP_PROPERTIES) continue;
+    for (uint32_t e = op->a; e < op->a + op->u.b && !c->failed; e++)
+      if (c->entries[e].aux && pinned(c, first, c->strings + c->entries[e].str) &&
+          build_dispatch(c, at, e))
+        return;
+    break;
+  }
+  if (c->ops[at].op == AJSB_OP_ANY_OF && n <= ADAPT_MAX) {
+    c->ops[at].flags |= AJSB_UF_ADAPT;
+    c->ops[at].u.c = c->num_adapt;
+    c->num_adapt += 2 + n;
+  }
+}
+
+static void index_unions(compiler_t *c) {
+  for (uint32_t i = 0; i < c->num_ops && !c->failed; i++)
+    if (c->ops[i].op == AJSB_OP_ANY_OF || c->ops[i].op == AJSB_OP_ONE_OF) index_union(c, i);
+}
+
+/* ── Public API ─────────────────────────────────────────────────────────── */
+
+static void *pool_copy(aml_pool_t *p, const void *d, size_t len) {
+  return len ? aml_pool_dup(p, d, len) : NULL;
+}
+
+ajsb_program_t *ajsb_compile_nodes(aml_pool_t *p, ajson_t *schema, ajson_t ***nodes) {
+  if (nodes) *nodes = NULL;
+  if (!p || !schema) return NULL;
+  compiler_t c;
+  memset(&c, 0, sizeof(c));
+  c.p = p;
+  c.link = ajsb_link(p, schema);
+
+  uint32_t root = compile_node(&c, schema);
+  index_unions(&c);
+
+  ajsb_program_t *prog = NULL;
+  if (!c.failed) {
+    prog = (ajsb_program_t *)aml_pool_zalloc(p, sizeof(*prog));
+    prog->ops         = (const ajsb_op_t *)pool_copy(p, c.ops, (size_t)c.num_ops * sizeof(ajsb_op_t));
+    prog->entries     = (const ajsb_entry_t *)pool_copy(p, c.entries, (size_t)c.num_entries * sizeof(ajsb_entry_t));
+    prog->lists       = (const uint32_t *)pool_copy(p, c.lists, (size_t)c.num_lists * sizeof(uint32_t));
+    prog->strings     = (const char *)pool_copy(p, c.strings, c.strings_len);
+    prog->num_ops     = c.num_ops;
+    prog->num_entries = c.num_entries;
+    prog->num_lists   = c.num_lists;
+    prog->strings_len = c.strings_len;
+    prog->root        = root;
+    prog->adapt       = c.num_adapt ? (uint64_t *)aml_pool_zalloc(p, (size_t)c.num_adapt * sizeof(uint64_t)) : NULL;
+    prog->num_adapt   = c.num_adapt;
+    if (nodes) {
+      *nodes = (ajson_t **)aml_pool_zalloc(p, (size_t)c.num_ops * sizeof(ajson_t *));
+      for (uint32_t i = 0; c.seen && i <= c.seen_mask; i++)
+        if (c.seen[i].schema) (*nodes)[c.seen[i].node] = c.seen[i].schema;
+    }
+  }
+  aml_free(c.ops);
+  aml_free(c.entries);
+  aml_free(c.lists);
+  aml_free(c.strings);
+  aml_free(c.seen);
+  return prog;
+}
+
+ajsb_program_t *ajsb_compile(aml_pool_t *p, ajson_t *schema) {
+  return ajsb_compile_nodes(p, schema, NULL);
+}
+
+size_t ajsb_program_length(const ajsb_program_t *prog) {
+  return prog ? prog->num_ops : 0;
+}
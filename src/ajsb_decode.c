@@ -0,0 +1,684 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#include "a-json-schema-builder-library/ajsb_decode.h"
+#include "a-json-schema-builder-library/ajsb.h"
+#include "a-json-schema-builder-library/ajsb_format.h"
+#include "ajsb_program.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CONJ 8      /* schema nodes checked directly against one value */
+
+typedef struct {
+  uint8_t type;
+  uint8_t elem_type;
+  size_t  offset;
+  size_t  elem_size;
+} field_t;
+
+/* ── Bindings: (object schema, property name) → field ───────────────────── */
+
+typedef struct {
+  const ajson_t *obj;
+  const char    *name;
+  uint32_t       hash;
+  field_t        field;
+} slot_t;
+
+struct ajsb_fields_s {
+  aml_pool_t *p;
+  slot_t     *slots;
+  size_t      mask, count;
+};
+
+static inline uint32_t key_hash(const ajson_t *obj, const char *name) {
+  uint64_t x = (uintptr_t)obj;
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  uint32_t h = (uint32_t)(x ^ (x >> 32));
+  for (const unsigned char *s = (const unsigned char *)name; *s; s++) {
+    h ^= *s;
+    h *= 16777619u;
+  }
+  return h;
+}
+
+static slot_t *find(const ajsb_fields_t *f, const ajson_t *obj, const char *name, uint32_t h) {
+  for (size_t i = h & f->mask;; i = (i + 1) & f->mask) {
+    slot_t *s = f->slots + i;
+    if (!s->obj) return s;
+    if (s->hash == h && s->obj == obj && !strcmp(s->name, name)) return s;
+  }
+}
+
+/* Tables live in the pool; a grown table simply abandons the old one. */
+static bool grow(ajsb_fields_t *f) {
+  if ((f->count + 1) * 2 <= f->mask + 1) return true;
+  size_t size = (f->mask + 1) * 2;
+  slot_t *n = (slot_t *)aml_pool_zalloc(f->p, size * sizeof(slot_t));
+  if (!n) return false;
+  for (size_t i = 0; i <= f->mask; i++) {
+    if (!f->slots[i].obj) continue;
+    size_t j = f->slots[i].hash & (size - 1);
+    while (n[j].obj) j = (j + 1) & (size - 1);
+    n[j] = f->slots[i];
+  }
+  f->slots = n;
+  f->mask = size - 1;
+  return true;
+}
+
+static void put(ajsb_fields_t *f, const ajson_t *obj, const char *name, field_t field) {
+  if (!grow(f)) return;
+  uint32_t h = key_hash(obj, name);
+  slot_t *s = find(f, obj, name, h);
+  if (!s->obj) {
+    s->obj = obj;
+    s->name = aml_pool_strdup(f->p, name);
+    s->hash = h;
+    f->count++;
+  }
+  s->field = field;
+}
+
+ajsb_fields_t *ajsb_fields_init(aml_pool_t *p) {
+  if (!p) return NULL;
+  ajsb_fields_t *f = (ajsb_fields_t *)aml_pool_zalloc(p, sizeof(*f));
+  f->p = p;
+  f->mask = 15;
+  f->slots = (slot_t *)aml_pool_zalloc(p, (f->mask + 1) * sizeof(slot_t));
+  return f;
+}
+
+static bool scalar_type(ajsb_field_type_t type) {
+  return type >= AJSB_FIELD_BOOL && type <= AJSB_FIELD_STRUCT;
+}
+
+void ajsb_fields_bind(ajsb_fields_t *f, ajson_t *obj, const char *name,
+                      ajsb_field_type_t type, size_t offset) {
+  if (!f || !obj || !name || !scalar_type(type)) return;
+  field_t field = { (uint8_t)type, 0, offset, 0 };
+  put(f, obj, name, field);
+}
+
+void ajsb_fields_bind_array(ajsb_fields_t *f, ajson_t *obj, const char *name, size_t offset,
+                            ajsb_field_type_t elem_type, size_t elem_size) {
+  if (!f || !obj || !name || !scalar_type(elem_type) || !elem_size) return;
+  field_t field = { AJSB_FIELD_ARRAY, (uint8_t)elem_type, offset, elem_size };
+  put(f, obj, name, field);
+}
+
+void ajsb_fields_prop(ajsb_fields_t *f, ajson_t *obj, const char *name, ajson_t *schema,
+                      ajsb_field_type_t type, size_t offset) {
+  if (!f) return;
+  ajsb_prop(f->p, obj, name, schema);
+  ajsb_fields_bind(f, obj, name, type, offset);
+}
+
+void ajsb_fields_prop_required(ajsb_fields_t *f, ajson_t *obj, const char *name, ajson_t *schema,
+                               ajsb_field_type_t type, size_t offset) {
+  if (!f) return;
+  ajsb_prop_required(f->p, obj, name, schema);
+  ajsb_fields_bind(f, obj, name, type, offset);
+}
+
+/* ── Decoder ────────────────────────────────────────────────────────────── */
+
+struct ajsb_decoder_s {
+  const ajsb_program_t *prog;
+  const field_t       **fields;     /* per entry: binding of that property or NULL */
+  uint8_t              *dom;        /* per node: needs a DOM to check */
+};
+
+#define FOR_OPS(prog, node, op) \
+  for (const ajsb_op_t *op = (prog)->ops + (node); op->op != AJSB_OP_END; op++)
+
+/* Keywords that compare a value with its siblings or try alternatives. */
+static bool needs_dom(const ajsb_program_t *prog, uint32_t node) {
+  FOR_OPS(prog, node, op) {
+    switch (op->op) {
+    case AJSB_OP_ANY_OF:
+    case AJSB_OP_ONE_OF:
+    case AJSB_OP_NOT:
+    case AJSB_OP_UNIQUE_ITEMS:
+      return true;
+    case AJSB_OP_ENUM:
+      if (op->flags & (1u << AJSB_V_JSON)) return true;
+      break;
+    case AJSB_OP_REQUIRED:
+      if (op->u.b > 64) return true;
+      break;
+    default:
+      break;
+    }
+  }
+  return false;
+}
+
+ajsb_decoder_t *ajsb_decoder_init(aml_pool_t *p, const ajsb_fields_t *f, ajson_t *schema) {
+  if (!p || !schema) return NULL;
+  ajson_t **nodes;
+  ajsb_program_t *prog = ajsb_compile_nodes(p, schema, &nodes);
+  if (!prog) return NULL;
+
+  ajsb_decoder_t *d = (ajsb_decoder_t *)aml_pool_zalloc(p, sizeof(*d));
+  d->prog = prog;
+  d->fields = (const field_t **)aml_pool_zalloc(p, (prog->num_entries + 1) * sizeof(field_t *));
+  d->dom = (uint8_t *)aml_pool_zalloc(p, prog->num_ops);
+  for (uint32_t node = 0; node < prog->num_ops; node++) {
+    if (!nodes[node]) continue;
+    d->dom[node] = needs_dom(prog, node);
+    if (!f) continue;
+    FOR_OPS(prog, node, op) {
+      if (op->op != AJSB_OP_PROPERTIES) continue;
+      for (uint32_t i = op->a; i < op->a + op->u.b; i++) {
+        const char *name = ajsb_entry_str(prog, prog->entries + i);
+        slot_t *s = find(f, nodes[node], name, key_hash(nodes[node], name));
+        if (s->obj) d->fields[i] = (const field_t *)aml_pool_dup(p, &s->field, sizeof(field_t));
+      }
+    }
+  }
+  return d;
+}
+
+/* A value is checked against every node of its context. top holds the nodes
+   it was reached through; $ref and allOf targets are folded into node. When a
+   node needs a DOM (or too many fold in), the value is checked by running the
+   interpreter over top instead. */
+typedef struct {
+  uint32_t top[CONJ], ntop;
+  uint32_t node[CONJ], n;
+  bool     dom;
+} ctx_t;
+
+static void ctx_fold(const ajsb_decoder_t *d, ctx_t *c, uint32_t node) {
+  for (uint32_t i = 0; i < c->n; i++) if (c->node[i] == node) return;
+  if (c->n == CONJ) { c->dom = true; return; }
+  c->node[c->n++] = node;
+  if (d->dom[node]) c->dom = true;
+  FOR_OPS(d->prog, node, op) {
+    if (op->op == AJSB_OP_REF) ctx_fold(d, c, op->a);
+    else if (op->op == AJSB_OP_ALL_OF)
+      for (uint32_t i = 0; i < op->u.b; i++) ctx_fold(d, c, d->prog->lists[op->a + i]);
+  }
+}
+
+/* Each parent node contributes at most one child, so top cannot overflow. */
+static void ctx_add(const ajsb_decoder_t *d, ctx_t *c, uint32_t node) {
+  for (uint32_t i = 0; i < c->ntop; i++) if (c->top[i] == node) return;
+  if (c->ntop == CONJ) return;
+  c->top[c->ntop++] = node;
+  ctx_fold(d, c, node);
+}
+
+typedef struct {
+  const ajsb_decoder_t *d;
+  const ajsb_program_t *prog;
+  aml_pool_t           *p;
+  const char           *s, *at, *e;
+  ajsb_decode_status_t  status;
+  const char           *why;
+  size_t                offset;
+  uint32_t              depth;
+} dec_t;
+
+static void fail(dec_t *x, ajsb_decode_status_t st, const char *why) {
+  if (x->status != AJSB_DECODE_OK) return;
+  x->status = st;
+  x->why = why;
+  x->offset = (size_t)(x->at - x->s);
+}
+#define INVALID(x, why) fail((x), AJSB_DECODE_INVALID, (why))
+#define SYNTAX(x, why)  fail((x), AJSB_DECODE_SYNTAX_ERROR, (why))
+#define MISFIT(x)       INVALID((x), "value does not fit the bound field")
+
+static inline void skip_ws(dec_t *x) {
+  while (x->at < x->e && (*x->at == ' ' || *x->at == '\n' || *x->at == '\r' || *x->at == '\t'))
+    x->at++;
+}
+
+static inline bool is_integral(double d) {
+  return d >= -9007199254740992.0 && d <= 9007199254740992.0 && (double)(int64_t)d == d;
+}
+
+static uint32_t enum_kind(uint32_t kind) {
+  switch (kind) {
+  case AJSB_T_STRING:  return 1u << AJSB_V_STRING;
+  case AJSB_T_NUMBER:  return 1u << AJSB_V_NUMBER;
+  case AJSB_T_BOOLEAN: return (1u << AJSB_V_TRUE) | (1u << AJSB_V_FALSE);
+  case AJSB_T_NULL:    return 1u << AJSB_V_NULL;
+  default:             return 1u << AJSB_V_JSON;
+  }
+}
+
+/* Checks decided by the first byte of a value. Integers are checked once the
+   number is read. */
+static bool check_kind(dec_t *x, const ctx_t *c, uint32_t kind) {
+  for (uint32_t i = 0; i < c->n; i++) {
+    FOR_OPS(x->prog, c->node[i], op) {
+      if (op->op == AJSB_OP_FALSE) { INVALID(x, "false schema"); return false; }
+      if (op->op == AJSB_OP_TYPE && !(op->a & kind) &&
+          !(kind == AJSB_T_NUMBER && (op->a & AJSB_T_INTEGER))) {
+        INVALID(x, "type mismatch");
+        return false;
+      }
+      if (op->op == AJSB_OP_ENUM && !(op->flags & enum_kind(kind))) {
+        INVALID(x, "enum mismatch");
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/* ── Scalars ────────────────────────────────────────────────────────────── */
+
+static inline int hex(char ch) {
+  if (ch >= '0' && ch <= '9') return ch - '0';
+  if (ch >= 'a' && ch <= 'f') return ch - 'a' + 10;
+  if (ch >= 'A' && ch <= 'F') return ch - 'A' + 10;
+  return -1;
+}
+
+/* At '"'. Leaves at after the closing quote; *raw/len span the escaped text. */
+static bool scan_string(dec_t *x, const char **raw, size_t *len, bool *escaped) {
+  const char *p = ++x->at;
+  *escaped = false;
+  while (p < x->e && *p != '"') {
+    unsigned char ch = (unsigned char)*p;
+    if (ch < 0x20) { x->at = p; SYNTAX(x, "control character in string"); return false; }
+    if (ch != '\\') { p++; continue; }
+    *escaped = true;
+    if (++p >= x->e) break;
+    if (*p == 'u') {
+      for (int i = 1; i <= 4; i++)
+        if (p + i >= x->e || hex(p[i]) < 0) { x->at = p; SYNTAX(x, "bad \\u escape"); return false; }
+      p += 5;
+    }
+    else if (*p && strchr("\"\\/bfnrt", *p)) p++;
+    else { x->at = p; SYNTAX(x, "bad escape"); return false; }
+  }
+  if (p >= x->e) { x->at = p; SYNTAX(x, "unterminated string"); return false; }
+  *raw = x->at;
+  *len = (size_t)(p - x->at);
+  x->at = p + 1;
+  return true;
+}
+
+/* Escapes never grow, so len + 1 bytes is enough. */
+static const char *unescape(aml_pool_t *p, const char *s, size_t len, size_t *out_len) {
+  char *r = (char *)aml_pool_alloc(p, len + 1);
+  *out_len = ajsb_json_unescape(r, s, len);
+  r[*out_len] = '\0';
+  return r;
+}
+
+static void string_value(dec_t *x, const ctx_t *c, const field_t *f, char *base, bool check) {
+  const char *raw;
+  size_t len;
+  bool escaped;
+  const char *start = x->at;
+  if (!scan_string(x, &raw, &len, &escaped)) return;
+
+  if (check) {
+    for (uint32_t i = 0; i < c->n; i++)
+      FOR_OPS(x->prog, c->node[i], op) {
+        const char *why = NULL;
+        if (op->op == AJSB_OP_ENUM && !ajsb_program_enum_string(x->prog, op, raw, len))
+          why = "enum mismatch";
+        else if (op->op == AJSB_OP_FORMAT && !ajsb_format_check_json((ajsb_format_t)op->a, raw, len))
+          why = "format mismatch";
+        else if (op->op == AJSB_OP_PATTERN && !ajsb_pattern_match_json(x->prog->lists + op->a, raw, len))
+          why = "pattern mismatch";
+        if (why) { x->at = start; INVALID(x, why); return; }
+      }
+  }
+  if (!f || !base) return;
+  if (f->type != AJSB_FIELD_STRING) { x->at = start; MISFIT(x); return; }
+  ajsb_text_t *t = (ajsb_text_t *)(base + f->offset);
+  if (escaped) t->s = unescape(x->p, raw, len, &t->len);
+  else {
+    t->s = raw;
+    t->len = len;
+  }
+}
+
+static bool to_int64(const char *text, bool fraction, double d, int64_t *out) {
+  if (!fraction) {
+    char *end;
+    errno = 0;
+    long long v = strtoll(text, &end, 10);
+    if (*end || errno == ERANGE) return false;
+    *out = (int64_t)v;
+    return true;
+  }
+  if (!(d >= -9223372036854775808.0 && d < 9223372036854775808.0) || (double)(int64_t)d != d)
+    return false;
+  *out = (int64_t)d;
+  return true;
+}
+
+static void number_value(dec_t *x, const ctx_t *c, const field_t *f, char *base, bool check) {
+  const char *start = x->at, *p = x->at;
+  bool fraction = false;
+  if (p < x->e && *p == '-') p++;
+  if (p < x->e && *p == '0') p++;
+  else if (p < x->e && *p >= '1' && *p <= '9') while (p < x->e && *p >= '0' && *p <= '9') p++;
+  else { SYNTAX(x, "bad number"); return; }
+  if (p < x->e && *p == '.') {
+    fraction = true;
+    if (++p >= x->e || *p < '0' || *p > '9') { x->at = p; SYNTAX(x, "bad number"); return; }
+    while (p < x->e && *p >= '0' && *p <= '9') p++;
+  }
+  if (p < x->e && (*p == 'e' || *p == 'E')) {
+    fraction = true;
+    p++;
+    if (p < x->e && (*p == '+' || *p == '-')) p++;
+    if (p >= x->e || *p < '0' || *p > '9') { x->at = p; SYNTAX(x, "bad number"); return; }
+    while (p < x->e && *p >= '0' && *p <= '9') p++;
+  }
+  x->at = p;
+
+  size_t len = (size_t)(p - start);
+  char buf[64];
+  char *text = len < sizeof(buf) ? buf : (char *)aml_pool_alloc(x->p, len + 1);
+  memcpy(text, start, len);
+  text[len] = '\0';
+  double d = strtod(text, NULL);
+
+  if (check) {
+    for (uint32_t i = 0; i < c->n; i++)
+      FOR_OPS(x->prog, c->node[i], op) {
+        bool ok = true;
+        switch (op->op) {
+        case AJSB_OP_TYPE:
+          ok = (op->a & AJSB_T_NUMBER) || is_integral(d);
+          break;
+        case AJSB_OP_MINIMUM:      ok = d >= op->d; break;
+        case AJSB_OP_MAXIMUM:      ok = d <= op->d; break;
+        case AJSB_OP_EXCL_MINIMUM: ok = d >  op->d; break;
+        case AJSB_OP_EXCL_MAXIMUM: ok = d <  op->d; break;
+        case AJSB_OP_ENUM:         ok = ajsb_program_enum_number(x->prog, op, d); break;
+        default: break;
+        }
+        if (!ok) {
+          x->at = start;
+          INVALID(x, op->op == AJSB_OP_TYPE ? "type mismatch" :
+                     op->op == AJSB_OP_ENUM ? "enum mismatch" : "number out of range");
+          return;
+        }
+      }
+  }
+  if (!f || !base) return;
+  void *m = base + f->offset;
+  int64_t v;
+  switch (f->type) {
+  case AJSB_FIELD_DOUBLE:
+    *(double *)m = d;
+    return;
+  case AJSB_FIELD_INT64:
+    if (to_int64(text, fraction, d, &v)) { *(int64_t *)m = v; return; }
+    break;
+  case AJSB_FIELD_INT:
+    if (to_int64(text, fraction, d, &v) && v >= INT_MIN && v <= INT_MAX) { *(int *)m = (int)v; return; }
+    break;
+  default:
+    break;
+  }
+  x->at = start;
+  MISFIT(x);
+}
+
+static void literal_value(dec_t *x, const ctx_t *c, const field_t *f, char *base, bool check) {
+  const char *lit = *x->at == 't' ? "true" : *x->at == 'f' ? "false" : "null";
+  size_t n = strlen(lit);
+  if ((size_t)(x->e - x->at) < n || memcmp(x->at, lit, n)) { SYNTAX(x, "bad literal"); return; }
+  uint32_t v = lit[0] == 't' ? AJSB_V_TRUE : lit[0] == 'f' ? AJSB_V_FALSE : AJSB_V_NULL;
+  if (check) {
+    for (uint32_t i = 0; i < c->n; i++)
+      FOR_OPS(x->prog, c->node[i], op) {
+        if (op->op == AJSB_OP_ENUM && !(op->flags & (1u << v))) { INVALID(x, "enum mismatch"); return; }
+      }
+  }
+  if (f && base && v != AJSB_V_NULL) {
+    if (f->type != AJSB_FIELD_BOOL) { MISFIT(x); return; }
+    *(bool *)(base + f->offset) = v == AJSB_V_TRUE;
+  }
+  x->at += n;
+}
+
+/* ── Containers ─────────────────────────────────────────────────────────── */
+
+static void value(dec_t *x, const ctx_t *c, const field_t *f, char *base, bool check);
+
+static bool next_member(dec_t *x, char close) {
+  skip_ws(x);
+  if (x->at < x->e && *x->at == ',') { x->at++; skip_ws(x); return true; }
+  if (x->at < x->e && *x->at == close) { x->at++; return false; }
+  SYNTAX(x, close == '}' ? "expected ',' or '}'" : "expected ',' or ']'");
+  return false;
+}
+
+static void object_value(dec_t *x, const ctx_t *c, const field_t *f, char *base, bool check) {
+  const ajsb_program_t *prog = x->prog;
+  if (f && base && f->type != AJSB_FIELD_STRUCT) { MISFIT(x); return; }
+  char *sbase = f && base ? base + f->offset : NULL;
+  uint64_t req[CONJ][AJSB_REQ_BITS / 64];
+  uint64_t extra[CONJ];
+  memset(req, 0, sizeof(req));
+  memset(extra, 0, sizeof(extra));
+  const char *start = x->at;
+
+  x->at++;
+  skip_ws(x);
+  if (x->at < x->e && *x->at == '}') x->at++;
+  else do {
+    if (x->at >= x->e || *x->at != '"') { SYNTAX(x, "expected property name"); return; }
+    const char *key;
+    size_t len;
+    bool escaped;
+    if (!scan_string(x, &key, &len, &escaped)) return;
+    skip_ws(x);
+    if (x->at >= x->e || *x->at != ':') { SYNTAX(x, "expected ':'"); return; }
+    x->at++;
+
+    const char *name = key;
+    size_t nlen = len;
+    if (escaped) {
+      char *t = (char *)aml_pool_alloc(x->p, len + 1);
+      nlen = ajsb_json_canonical(t, key, len);
+      name = t;
+    }
+    ctx_t next;
+    memset(&next, 0, sizeof(next));
+    const field_t *mf = NULL;
+    uint32_t h = ajsb_hash32(name, nlen);
+    for (uint32_t i = 0; i < c->n; i++) {
+      FOR_OPS(prog, c->node[i], op) {
+        if (op->op == AJSB_OP_PROPERTIES) {
+          const ajsb_entry_t *e = ajsb_program_prop(prog, op, name, nlen, h);
+          if (e) {
+            if (e->aux) req[i][(e->aux - 1) >> 6] |= (uint64_t)1 << ((e->aux - 1) & 63);
+            ctx_add(x->d, &next, e->node);
+            if (!mf) mf = x->d->fields[e - prog->entries];
+          }
+          else if (op->flags & AJSB_PF_NO_ADDITIONAL) {
+            if (check) { x->at = key - 1; INVALID(x, "unknown property"); return; }
+          }
+          else if (op->flags & AJSB_PF_ADDITIONAL) ctx_add(x->d, &next, op[1].a);
+        }
+        else if (op->op == AJSB_OP_REQUIRED) {
+          for (uint32_t e = 0; e < op->u.b && e < 64; e++)
+            if (ajsb_entry_eq(prog, prog->entries + op->a + e, name, nlen, h))
+              extra[i] |= (uint64_t)1 << e;
+        }
+      }
+    }
+    value(x, &next, mf, sbase, check);
+    if (x->status != AJSB_DECODE_OK) return;
+  } while (next_member(x, '}'));
+  if (x->status != AJSB_DECODE_OK || !check) return;
+
+  for (uint32_t i = 0; i < c->n; i++) {
+    FOR_OPS(prog, c->node[i], op) {
+      if (op->op != AJSB_OP_REQUIRED) continue;
+      uint32_t bits = op->u.c;
+      bool ok = true;
+      for (uint32_t w = 0; bits && ok; w++) {
+        uint64_t want = bits >= 64 ? UINT64_MAX : ((uint64_t)1 << bits) - 1;
+        ok = (req[i][w] & want) == want;
+        bits = bits >= 64 ? bits - 64 : 0;
+      }
+      uint64_t want = op->u.b >= 64 ? UINT64_MAX : ((uint64_t)1 << op->u.b) - 1;
+      if (!ok || (extra[i] & want) != want) {
+        x->at = start;
+        INVALID(x, "missing required property");
+        return;
+      }
+    }
+  }
+}
+
+static void array_value(dec_t *x, const ctx_t *c, const field_t *f, char *base, bool check) {
+  const ajsb_program_t *prog = x->prog;
+  if (f && base && f->type != AJSB_FIELD_ARRAY) { MISFIT(x); return; }
+  ctx_t next;
+  memset(&next, 0, sizeof(next));
+  for (uint32_t i = 0; i < c->n; i++)
+    FOR_OPS(prog, c->node[i], op)
+      if (op->op == AJSB_OP_ITEMS) ctx_add(x->d, &next, op->a);
+
+  field_t ef = { 0, 0, 0, 0 };
+  char *items = NULL;
+  size_t count = 0, cap = 0;
+  if (f && base) ef.type = f->elem_type;
+  const char *start = x->at;
+
+  x->at++;
+  skip_ws(x);
+  if (x->at < x->e && *x->at == ']') x->at++;
+  else do {
+    char *elem = NULL;
+    if (f && base) {
+      if (count == cap) {
+        size_t ncap = cap ? cap * 2 : 8;
+        char *n = (char *)aml_pool_zalloc(x->p, ncap * f->elem_size);
+        if (count) memcpy(n, items, count * f->elem_size);
+        items = n;
+        cap = ncap;
+      }
+      elem = items + count * f->elem_size;
+    }
+    value(x, &next, elem ? &ef : NULL, elem, check);
+    if (x->status != AJSB_DECODE_OK) return;
+    count++;
+  } while (next_member(x, ']'));
+  if (x->status != AJSB_DECODE_OK) return;
+
+  if (check) {
+    for (uint32_t i = 0; i < c->n; i++)
+      FOR_OPS(prog, c->node[i], op) {
+        if ((op->op == AJSB_OP_MIN_ITEMS && count < op->a) ||
+            (op->op == AJSB_OP_MAX_ITEMS && count > op->a)) {
+          x->at = start;
+          INVALID(x, "item count out of range");
+          return;
+        }
+      }
+  }
+  if (f && base) {
+    ajsb_slice_t *sl = (ajsb_slice_t *)(base + f->offset);
+    sl->items = items;
+    sl->count = count;
+  }
+}
+
+/* Check the value on a DOM of its own text, then walk it again to bind. */
+static void dom_value(dec_t *x, const ctx_t *c, const field_t *f, char *base) {
+  const char *start = x->at;
+  value(x, c, NULL, NULL, false);
+  if (x->status != AJSB_DECODE_OK) return;
+  size_t len = (size_t)(x->at - start);
+  char *copy = aml_pool_strndup(x->p, start, len);
+  ajson_t *j = ajson_parse(x->p, copy, copy + len);
+  if (!j || ajson_is_error(j)) { x->at = start; SYNTAX(x, "bad JSON"); return; }
+  for (uint32_t i = 0; i < c->ntop; i++)
+    if (!ajsb_program_run(x->prog, c->top[i], j)) {
+      x->at = start;
+      INVALID(x, "value does not match schema");
+      return;
+    }
+  if (!f || !base) return;
+  const char *end = x->at;
+  x->at = start;
+  value(x, c, f, base, false);
+  x->at = end;
+}
+
+static void value(dec_t *x, const ctx_t *c, const field_t *f, char *base, bool check) {
+  skip_ws(x);
+  if (x->at >= x->e) { SYNTAX(x, "unexpected end of input"); return; }
+  if (check && c->dom) { dom_value(x, c, f, base); return; }
+  if (f && base && f->type == AJSB_FIELD_JSON) {
+    const char *start = x->at;
+    value(x, c, NULL, NULL, check);
+    if (x->status != AJSB_DECODE_OK) return;
+    ajsb_text_t *t = (ajsb_text_t *)(base + f->offset);
+    t->s = start;
+    t->len = (size_t)(x->at - start);
+    return;
+  }
+
+  char ch = *x->at;
+  uint32_t kind = ch == '{' ? AJSB_T_OBJECT : ch == '[' ? AJSB_T_ARRAY : ch == '"' ? AJSB_T_STRING
+                : ch == 't' || ch == 'f' ? AJSB_T_BOOLEAN : ch == 'n' ? AJSB_T_NULL
+                : ch == '-' || (ch >= '0' && ch <= '9') ? AJSB_T_NUMBER : 0;
+  if (!kind) { SYNTAX(x, "unexpected character"); return; }
+  if (check && !check_kind(x, c, kind)) return;
+  if ((kind == AJSB_T_OBJECT || kind == AJSB_T_ARRAY) && ++x->depth > AJSB_DECODE_MAX_DEPTH) {
+    INVALID(x, "nesting too deep");
+    return;
+  }
+  switch (kind) {
+  case AJSB_T_OBJECT: object_value(x, c, f, base, check); x->depth--; break;
+  case AJSB_T_ARRAY:  array_value(x, c, f, base, check);  x->depth--; break;
+  case AJSB_T_STRING: string_value(x, c, f, base, check); break;
+  case AJSB_T_NUMBER: number_value(x, c, f, base, check); break;
+  default:            literal_value(x, c, f, base, check); break;
+  }
+}
+
+ajsb_decode_status_t ajsb_decode(const ajsb_decoder_t *d, aml_pool_t *p, const char *json,
+                                 size_t len, void *out, ajsb_decode_error_t *err) {
+  dec_t x;
+  memset(&x, 0, sizeof(x));
+  x.d = d;
+  x.p = p;
+  x.s = x.at = json;
+  x.e = json ? json + len : json;
+
+  if (!d || !p || !json) INVALID(&x, "bad arguments");
+  else {
+    x.prog = d->prog;
+    ctx_t c;
+    memset(&c, 0, sizeof(c));
+    ctx_add(d, &c, d->prog->root);
+    field_t root = { AJSB_FIELD_STRUCT, 0, 0, 0 };
+    value(&x, &c, &root, (char *)out, true);
+    skip_ws(&x);
+    if (x.status == AJSB_DECODE_OK && x.at != x.e) SYNTAX(&x, "trailing characters");
+  }
+  if (err) {
+    err->why = x.why;
+    err->offset = x.offset;
+  }
+  return x.status;
+}
@@ -0,0 +1,150 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#include "a-json-schema-builder-library/ajsb_derive.h"
+#include "a-json-schema-builder-library/ajsb_cache.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct ajsb_derive_s {
+  aml_pool_t    *p;
+  ajson_t       *root;
+  const ajson_t **own;          /* pointer set of copied nodes (pool tables) */
+  size_t         mask, count;
+};
+
+static inline size_t ptr_hash(const void *ptr) {
+  uint64_t x = (uintptr_t)ptr;
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  return (size_t)(x ^ (x >> 32));
+}
+
+static const ajson_t **own_slot(const ajsb_derive_t *d, const ajson_t *j) {
+  for (size_t i = ptr_hash(j) & d->mask;; i = (i + 1) & d->mask)
+    if (!d->own[i] || d->own[i] == j) return d->own + i;
+}
+
+static void own_add(ajsb_derive_t *d, const ajson_t *j) {
+  if ((d->count + 1) * 2 > d->mask + 1) {
+    const ajson_t **old = d->own;
+    size_t old_mask = d->mask;
+    d->mask = old_mask * 2 + 1;
+    d->own = (const ajson_t **)aml_pool_zalloc(d->p, (d->mask + 1) * sizeof(*d->own));
+    for (size_t i = 0; i <= old_mask; i++)
+      if (old[i]) *own_slot(d, old[i]) = old[i];
+  }
+  *own_slot(d, j) = j;
+  d->count++;
+}
+
+/* One-level copy: the members are still the base's nodes. Scalars are never
+   modified in place, so they are not copied. */
+static ajson_t *copy(ajsb_derive_t *d, ajson_t *j) {
+  ajson_t *c;
+  if (ajson_is_object(j)) {
+    c = ajsono(d->p);
+    for (ajsono_t *m = ajsono_first(j); m; m = ajsono_next(m))
+      ajsono_append(c, m->key, m->value, /*copy_key=*/false);
+  } else if (ajson_is_array(j)) {
+    c = ajsona(d->p);
+    for (ajsona_t *a = ajsona_first(j); a; a = ajsona_next(a)) ajsona_append(c, a->value);
+  } else {
+    return j;
+  }
+  own_add(d, c);
+  return c;
+}
+
+/* Make the member key of the owned object obj owned; returns it (or NULL). */
+static ajson_t *own_member(ajsb_derive_t *d, ajson_t *obj, const char *key) {
+  for (ajsono_t *m = ajsono_first(obj); m; m = ajsono_next(m)) {
+    if (strcmp(m->key, key)) continue;
+    if (!ajsb_derive_owns(d, m->value)) {
+      m->value = copy(d, m->value);
+      ajsb_touch(obj);
+    }
+    return m->value;
+  }
+  return NULL;
+}
+
+static ajson_t *own_element(ajsb_derive_t *d, ajson_t *arr, size_t index) {
+  size_t i = 0;
+  for (ajsona_t *a = ajsona_first(arr); a; a = ajsona_next(a), i++) {
+    if (i != index) continue;
+    if (!ajsb_derive_owns(d, a->value)) {
+      a->value = copy(d, a->value);
+      ajsb_touch(arr);
+    }
+    return a->value;
+  }
+  return NULL;
+}
+
+/* The containers the ajsb_* helpers modify in place. */
+static ajson_t *writable(ajsb_derive_t *d, ajson_t *node) {
+  if (ajson_is_object(node)) {
+    own_member(d, node, "properties");
+    own_member(d, node, "required");
+    own_member(d, node, "$defs");
+  }
+  return node;
+}
+
+/* ── Public API ─────────────────────────────────────────────────────────── */
+
+ajsb_derive_t *ajsb_derive(aml_pool_t *p, ajson_t *base) {
+  if (!p || !base) return NULL;
+  ajsb_derive_t *d = (ajsb_derive_t *)aml_pool_zalloc(p, sizeof(*d));
+  d->p = p;
+  d->mask = 31;
+  d->own = (const ajson_t **)aml_pool_zalloc(p, (d->mask + 1) * sizeof(*d->own));
+  d->root = writable(d, copy(d, base));
+  return d;
+}
+
+ajson_t *ajsb_derive_root(const ajsb_derive_t *d) {
+  return d ? d->root : NULL;
+}
+
+bool ajsb_derive_owns(const ajsb_derive_t *d, const ajson_t *node) {
+  return d && node && *own_slot(d, node) == node;
+}
+
+ajson_t *ajsb_derive_at(ajsb_derive_t *d, const char *pointer) {
+  if (!d || !pointer) return NULL;
+  if (*pointer == '#') pointer++;
+  ajson_t *node = d->root;
+  size_t cap = strlen(pointer) + 1;
+  char *token = (char *)aml_pool_alloc(d->p, cap);
+
+  while (*pointer == '/' && node) {
+    /* decode one reference token (~1 → '/', ~0 → '~') */
+    const char *s = ++pointer;
+    size_t n = 0;
+    for (; *s && *s != '/'; s++) {
+      if (*s == '~' && (s[1] == '0' || s[1] == '1')) token[n++] = *++s == '1' ? '/' : '~';
+      else token[n++] = *s;
+    }
+    token[n] = '\0';
+    pointer = s;
+
+    if (ajson_is_object(node)) {
+      node = own_member(d, node, token);
+    } else if (ajson_is_array(node)) {
+      char *end;
+      unsigned long i = strtoul(token, &end, 10);
+      node = n && !*end ? own_element(d, node, i) : NULL;
+    } else {
+      node = NULL;
+    }
+  }
+  if (*pointer) return NULL;
+  return node ? writable(d, node) : NULL;
+}
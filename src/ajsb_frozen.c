@@ -0,0 +1,490 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#include "a-json-schema-builder-library/ajsb_frozen.h"
+#include "a-memory-library/aml_alloc.h"
+#include "a-memory-library/aml_pool.h"
+#include "ajsb_program.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* Blob layout (all offsets relative to the blob, sections 8-byte aligned):
+
+     header | records[count] | order[count] | per schema: ops, entries, lists,
+     program strings | nodes (uint32 words) | strings (interned, NUL-terminated)
+
+   A tree node is a word index into nodes. Its first word is the type in the
+   low 3 bits and the member count above them, followed by
+     object: count × (key string, key length, child node)
+     array:  count × child node
+     string/number: string offset, length */
+
+#define FROZEN_MAGIC   "AJSBFRZ"
+#define FROZEN_VERSION 3u
+#define FROZEN_ENDIAN  0x01020304u
+
+typedef struct {
+  char     magic[8];
+  uint32_t version;
+  uint32_t endian;
+  uint32_t op_size;
+  uint32_t entry_size;
+  uint32_t count;
+  uint32_t reserved;
+  uint64_t total;
+  uint64_t records;
+  uint64_t order;
+  uint64_t nodes;
+  uint64_t strings;
+} header_t;
+
+typedef struct {
+  uint32_t name, name_len;      /* string table */
+  uint32_t node;                /* tree root */
+  uint32_t root;                /* program root */
+  uint64_t ops, entries, lists, pstrings;
+  uint32_t num_ops, num_entries, num_lists, strings_len;
+} record_t;
+
+struct ajsb_frozen_s {
+  const uint8_t   *base;
+  size_t           map_len;     /* nonzero when mapped */
+  const record_t  *records;
+  const uint32_t  *order;
+  const uint32_t  *words;
+  const char      *strings;
+  uint32_t         count;
+  ajsb_program_t   progs[];
+};
+
+static inline uint64_t align8(uint64_t n) { return (n + 7) & ~(uint64_t)7; }
+
+/* ── Freezing ───────────────────────────────────────────────────────────── */
+
+typedef struct { uint32_t off1, hash; } str_slot_t;          /* off1 = offset + 1 */
+typedef struct { const ajson_t *j; uint32_t at; } memo_slot_t;
+
+typedef struct {
+  aml_buffer_t *words;
+  aml_buffer_t *strings;
+  str_slot_t   *str;
+  size_t        str_mask, str_count;
+  memo_slot_t  *memo;
+  size_t        memo_mask, memo_count;
+} freezer_t;
+
+static uint32_t intern_str(freezer_t *fz, const char *s, size_t len) {
+  if ((fz->str_count + 1) * 2 > fz->str_mask + 1) {
+    size_t size = (fz->str_mask + 1) * 2;
+    str_slot_t *n = (str_slot_t *)aml_calloc(size, sizeof(str_slot_t));
+    for (size_t i = 0; i <= fz->str_mask; i++) {
+      if (!fz->str[i].off1) continue;
+      size_t j = fz->str[i].hash & (size - 1);
+      while (n[j].off1) j = (j + 1) & (size - 1);
+      n[j] = fz->str[i];
+    }
+    aml_free(fz->str);
+    fz->str = n;
+    fz->str_mask = size - 1;
+  }
+  uint32_t h = ajsb_hash32(s, len);
+  for (size_t i = h & fz->str_mask;; i = (i + 1) & fz->str_mask) {
+    str_slot_t *e = fz->str + i;
+    if (!e->off1) {
+      uint32_t off = (uint32_t)aml_buffer_length(fz->strings);
+      aml_buffer_append(fz->strings, s, len);
+      aml_buffer_appendc(fz->strings, '\0');
+      e->off1 = off + 1;
+      e->hash = h;
+      fz->str_count++;
+      return off;
+    }
+    const char *have = aml_buffer_data(fz->strings) + e->off1 - 1;
+    if (e->hash == h && !memcmp(have, s, len) && !have[len]) return e->off1 - 1;
+  }
+}
+
+static inline uint32_t ptr_hash(const void *p) {
+  uint64_t x = (uintptr_t)p;
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  return (uint32_t)(x ^ (x >> 32));
+}
+
+static memo_slot_t *memo_find(freezer_t *fz, const ajson_t *j) {
+  for (size_t i = ptr_hash(j) & fz->memo_mask;; i = (i + 1) & fz->memo_mask)
+    if (!fz->memo[i].j || fz->memo[i].j == j) return fz->memo + i;
+}
+
+static void memo_put(freezer_t *fz, const ajson_t *j, uint32_t at) {
+  if ((fz->memo_count + 1) * 2 > fz->memo_mask + 1) {
+    memo_slot_t *old = fz->memo;
+    size_t old_mask = fz->memo_mask;
+    fz->memo_mask = old_mask * 2 + 1;
+    fz->memo = (memo_slot_t *)aml_calloc(fz->memo_mask + 1, sizeof(memo_slot_t));
+    for (size_t i = 0; i <= old_mask; i++)
+      if (old[i].j) *memo_find(fz, old[i].j) = old[i];
+    aml_free(old);
+  }
+  *memo_find(fz, j) = (memo_slot_t){ j, at };
+  fz->memo_count++;
+}
+
+static uint32_t reserve(freezer_t *fz, size_t n) {
+  uint32_t at = (uint32_t)(aml_buffer_length(fz->words) / sizeof(uint32_t));
+  aml_buffer_appendn(fz->words, 0, n * sizeof(uint32_t));
+  return at;
+}
+
+static inline uint32_t *word(freezer_t *fz, uint32_t at) {
+  return (uint32_t *)aml_buffer_data(fz->words) + at;
+}
+
+/* Shared subtrees (e.g. after ajsb_intern) are written once. */
+static uint32_t freeze_node(freezer_t *fz, ajson_t *j) {
+  memo_slot_t *m = memo_find(fz, j);
+  if (m->j) return m->at;
+
+  uint32_t at;
+  if (ajson_is_object(j)) {
+    uint32_t n = (uint32_t)ajsono_count(j), i = 0;
+    at = reserve(fz, 1 + 3 * (size_t)n);
+    word(fz, at)[0] = AJSB_FROZEN_OBJECT | n << 3;
+    for (ajsono_t *o = ajsono_first(j); o; o = ajsono_next(o), i++) {
+      size_t len = strlen(o->key);
+      uint32_t key = intern_str(fz, o->key, len);
+      uint32_t child = freeze_node(fz, o->value);
+      uint32_t *w = word(fz, at) + 1 + 3 * i;
+      w[0] = key;
+      w[1] = (uint32_t)len;
+      w[2] = child;
+    }
+  } else if (ajson_is_array(j)) {
+    uint32_t n = (uint32_t)ajsona_count(j), i = 0;
+    at = reserve(fz, 1 + (size_t)n);
+    word(fz, at)[0] = AJSB_FROZEN_ARRAY | n << 3;
+    for (ajsona_t *a = ajsona_first(j); a; a = ajsona_next(a), i++) {
+      uint32_t child = freeze_node(fz, a->value);
+      word(fz, at)[1 + i] = child;
+    }
+  } else if (ajson_is_string(j) || ajson_is_number(j) || ajson_is_decimal(j)) {
+    const char *s = ajson_to_str(j, "");
+    size_t len = strlen(s);
+    uint32_t off = intern_str(fz, s, len);
+    at = reserve(fz, 3);
+    uint32_t *w = word(fz, at);
+    w[0] = ajson_is_string(j) ? AJSB_FROZEN_STRING : AJSB_FROZEN_NUMBER;
+    w[1] = off;
+    w[2] = (uint32_t)len;
+  } else {
+    at = reserve(fz, 1);
+    word(fz, at)[0] = ajson_is_true(j) ? AJSB_FROZEN_TRUE
+                    : ajson_is_false(j) ? AJSB_FROZEN_FALSE : AJSB_FROZEN_NULL;
+  }
+  memo_put(fz, j, at);
+  return at;
+}
+
+typedef struct { const char *name; uint32_t index; } sort_t;
+
+static int cmp_sort(const void *a, const void *b) {
+  return strcmp(((const sort_t *)a)->name, ((const sort_t *)b)->name);
+}
+
+static inline void put_at(aml_buffer_t *bh, size_t base, uint64_t off, const void *d, size_t len) {
+  if (len) memcpy(aml_buffer_data(bh) + base + off, d, len);
+}
+
+bool ajsb_freeze(aml_buffer_t *bh, size_t n, const char *const *names, ajson_t *const *schemas) {
+  if (!bh || (n && !schemas) || n > UINT32_MAX) return false;
+  for (size_t i = 0; i < n; i++)
+    if (!schemas[i]) return false;
+
+  aml_pool_t *p = aml_pool_init(4096);
+  ajsb_program_t **progs = (ajsb_program_t **)aml_calloc(n + 1, sizeof(*progs));
+  bool ok = true;
+  for (size_t i = 0; i < n && ok; i++) ok = (progs[i] = ajsb_compile(p, schemas[i])) != NULL;
+
+  if (ok) {
+    freezer_t fz;
+    memset(&fz, 0, sizeof(fz));
+    fz.words = aml_buffer_init(4096);
+    fz.strings = aml_buffer_init(4096);
+    fz.str_mask = 255;
+    fz.str = (str_slot_t *)aml_calloc(fz.str_mask + 1, sizeof(str_slot_t));
+    fz.memo_mask = 255;
+    fz.memo = (memo_slot_t *)aml_calloc(fz.memo_mask + 1, sizeof(memo_slot_t));
+
+    record_t *recs = (record_t *)aml_calloc(n + 1, sizeof(record_t));
+    sort_t *sorted = (sort_t *)aml_calloc(n + 1, sizeof(sort_t));
+    uint32_t *order = (uint32_t *)aml_calloc(n + 1, sizeof(uint32_t));
+    for (size_t i = 0; i < n; i++) {
+      const char *name = names && names[i] ? names[i] : "";
+      recs[i].name = intern_str(&fz, name, strlen(name));
+      recs[i].name_len = (uint32_t)strlen(name);
+      recs[i].node = freeze_node(&fz, schemas[i]);
+      sorted[i] = (sort_t){ name, (uint32_t)i };
+    }
+    qsort(sorted, n, sizeof(sort_t), cmp_sort);
+    for (size_t i = 0; i < n; i++) order[i] = sorted[i].index;
+
+    /* lay out the sections */
+    header_t h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, FROZEN_MAGIC, sizeof(h.magic));
+    h.version = FROZEN_VERSION;
+    h.endian = FROZEN_ENDIAN;
+    h.op_size = sizeof(ajsb_op_t);
+    h.entry_size = sizeof(ajsb_entry_t);
+    h.count = (uint32_t)n;
+
+    uint64_t off = align8(sizeof(header_t));
+    h.records = off;  off = align8(off + n * sizeof(record_t));
+    h.order = off;    off = align8(off + n * sizeof(uint32_t));
+    for (size_t i = 0; i < n; i++) {
+      const ajsb_program_t *pr = progs[i];
+      record_t *r = recs + i;
+      r->root = pr->root;
+      r->num_ops = pr->num_ops;
+      r->num_entries = pr->num_entries;
+      r->num_lists = pr->num_lists;
+      r->strings_len = pr->strings_len;
+      r->ops = off;      off = align8(off + (uint64_t)pr->num_ops * sizeof(ajsb_op_t));
+      r->entries = off;  off = align8(off + (uint64_t)pr->num_entries * sizeof(ajsb_entry_t));
+      r->lists = off;    off = align8(off + (uint64_t)pr->num_lists * sizeof(uint32_t));
+      r->pstrings = off; off = align8(off + pr->strings_len);
+    }
+    h.nodes = off;    off = align8(off + aml_buffer_length(fz.words));
+    h.strings = off;  off = align8(off + aml_buffer_length(fz.strings));
+    h.total = off;
+
+    size_t base = aml_buffer_length(bh);
+    aml_buffer_appendn(bh, 0, (size_t)off);
+    put_at(bh, base, 0, &h, sizeof(h));
+    put_at(bh, base, h.records, recs, n * sizeof(record_t));
+    put_at(bh, base, h.order, order, n * sizeof(uint32_t));
+    for (size_t i = 0; i < n; i++) {
+      const ajsb_program_t *pr = progs[i];
+      put_at(bh, base, recs[i].ops, pr->ops, pr->num_ops * sizeof(ajsb_op_t));
+      put_at(bh, base, recs[i].entries, pr->entries, pr->num_entries * sizeof(ajsb_entry_t));
+      put_at(bh, base, recs[i].lists, pr->lists, pr->num_lists * sizeof(uint32_t));
+      put_at(bh, base, recs[i].pstrings, pr->strings, pr->strings_len);
+    }
+    put_at(bh, base, h.nodes, aml_buffer_data(fz.words), aml_buffer_length(fz.words));
+    put_at(bh, base, h.strings, aml_buffer_data(fz.strings), aml_buffer_length(fz.strings));
+
+    aml_free(order);
+    aml_free(sorted);
+    aml_free(recs);
+    aml_free(fz.memo);
+    aml_free(fz.str);
+    aml_buffer_destroy(fz.strings);
+    aml_buffer_destroy(fz.words);
+  }
+  aml_free(progs);
+  aml_pool_destroy(p);
+  return ok;
+}
+
+bool ajsb_freeze_file(const char *path, size_t n, const char *const *names, ajson_t *const *schemas) {
+  if (!path || !*path) return false;
+  aml_buffer_t *bh = aml_buffer_init(1 << 16);
+  bool ok = ajsb_freeze(bh, n, names, schemas);
+  if (ok) {
+    size_t plen = strlen(path);
+    char *tmp = (char *)aml_malloc(plen + 8);
+    memcpy(tmp, path, plen);
+    memcpy(tmp + plen, ".tmp", 5);
+    FILE *out = fopen(tmp, "wb");
+    ok = out && fwrite(aml_buffer_data(bh), 1, aml_buffer_length(bh), out) == aml_buffer_length(bh);
+    if (out && fclose(out)) ok = false;
+    if (ok) ok = rename(tmp, path) == 0;
+    if (!ok) remove(tmp);
+    aml_free(tmp);
+  }
+  aml_buffer_destroy(bh);
+  return ok;
+}
+
+/* ── Loading ────────────────────────────────────────────────────────────── */
+
+static ajsb_frozen_t *view(const void *data, size_t len) {
+  if (!data || ((uintptr_t)data & 7) || len < sizeof(header_t)) return NULL;
+  const header_t *h = (const header_t *)data;
+  if (memcmp(h->magic, FROZEN_MAGIC, sizeof(h->magic)) || h->version != FROZEN_VERSION ||
+      h->endian != FROZEN_ENDIAN || h->op_size != sizeof(ajsb_op_t) ||
+      h->entry_size != sizeof(ajsb_entry_t) || h->total > len ||
+      h->records + (uint64_t)h->count * sizeof(record_t) > h->total ||
+      h->order + (uint64_t)h->count * sizeof(uint32_t) > h->total ||
+      h->nodes > h->total || h->strings > h->total)
+    return NULL;
+
+  const uint8_t *base = (const uint8_t *)data;
+  ajsb_frozen_t *f = (ajsb_frozen_t *)aml_malloc(sizeof(*f) + h->count * sizeof(ajsb_program_t));
+  f->base = base;
+  f->map_len = 0;
+  f->records = (const record_t *)(base + h->records);
+  f->order = (const uint32_t *)(base + h->order);
+  f->words = (const uint32_t *)(base + h->nodes);
+  f->strings = (const char *)(base + h->strings);
+  f->count = h->count;
+  for (uint32_t i = 0; i < h->count; i++) {
+    const record_t *r = f->records + i;
+    ajsb_program_t *pr = f->progs + i;
+    pr->ops = (const ajsb_op_t *)(base + r->ops);
+    pr->entries = (const ajsb_entry_t *)(base + r->entries);
+    pr->lists = (const uint32_t *)(base + r->lists);
+    pr->strings = (const char *)(base + r->pstrings);
+    pr->num_ops = r->num_ops;
+    pr->num_entries = r->num_entries;
+    pr->num_lists = r->num_lists;
+    pr->strings_len = r->strings_len;
+    pr->root = r->root;
+    pr->adapt = NULL;       /* the mapping is read-only: anyOf keeps its order */
+    pr->num_adapt = 0;
+  }
+  return f;
+}
+
+ajsb_frozen_t *ajsb_frozen_load(const void *data, size_t len) {
+  return view(data, len);
+}
+
+ajsb_frozen_t *ajsb_frozen_open(const char *path) {
+  if (!path) return NULL;
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) return NULL;
+  struct stat st;
+  void *m = MAP_FAILED;
+  if (!fstat(fd, &st) && st.st_size > 0)
+    m = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (m == MAP_FAILED) return NULL;
+  ajsb_frozen_t *f = view(m, (size_t)st.st_size);
+  if (!f) {
+    munmap(m, (size_t)st.st_size);
+    return NULL;
+  }
+  f->map_len = (size_t)st.st_size;
+  return f;
+}
+
+void ajsb_frozen_close(ajsb_frozen_t *f) {
+  if (!f) return;
+  if (f->map_len) munmap((void *)f->base, f->map_len);
+  aml_free(f);
+}
+
+size_t ajsb_frozen_count(const ajsb_frozen_t *f) { return f ? f->count : 0; }
+
+const char *ajsb_frozen_name(const ajsb_frozen_t *f, size_t i) {
+  return f && i < f->count ? f->strings + f->records[i].name : NULL;
+}
+
+int ajsb_frozen_find(const ajsb_frozen_t *f, const char *name) {
+  if (!f || !name) return -1;
+  size_t lo = 0, hi = f->count;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    uint32_t i = f->order[mid];
+    int c = strcmp(f->strings + f->records[i].name, name);
+    if (!c) return (int)i;
+    if (c < 0) lo = mid + 1;
+    else hi = mid;
+  }
+  return -1;
+}
+
+const ajsb_program_t *ajsb_frozen_program(const ajsb_frozen_t *f, size_t i) {
+  return f && i < f->count ? f->progs + i : NULL;
+}
+
+/* ── Tree access ────────────────────────────────────────────────────────── */
+
+static const ajsb_fnode_t no_node = { NULL, 0 };
+
+static inline const uint32_t *W(ajsb_fnode_t n) { return n.f->words + n.at; }
+
+ajsb_fnode_t ajsb_frozen_root(const ajsb_frozen_t *f, size_t i) {
+  if (!f || i >= f->count) return no_node;
+  return (ajsb_fnode_t){ f, f->records[i].node };
+}
+
+ajsb_frozen_type_t ajsb_fnode_type(ajsb_fnode_t n) {
+  return n.f ? (ajsb_frozen_type_t)(W(n)[0] & 7) : AJSB_FROZEN_NONE;
+}
+
+size_t ajsb_fnode_count(ajsb_fnode_t n) {
+  ajsb_frozen_type_t t = ajsb_fnode_type(n);
+  return t == AJSB_FROZEN_OBJECT || t == AJSB_FROZEN_ARRAY ? W(n)[0] >> 3 : 0;
+}
+
+const char *ajsb_fnode_key(ajsb_fnode_t n, size_t i) {
+  if (ajsb_fnode_type(n) != AJSB_FROZEN_OBJECT || i >= ajsb_fnode_count(n)) return NULL;
+  return n.f->strings + W(n)[1 + 3 * i];
+}
+
+ajsb_fnode_t ajsb_fnode_value(ajsb_fnode_t n, size_t i) {
+  if (i >= ajsb_fnode_count(n)) return no_node;
+  if (ajsb_fnode_type(n) == AJSB_FROZEN_OBJECT) return (ajsb_fnode_t){ n.f, W(n)[3 + 3 * i] };
+  return (ajsb_fnode_t){ n.f, W(n)[1 + i] };
+}
+
+ajsb_fnode_t ajsb_fnode_get(ajsb_fnode_t n, const char *key) {
+  if (!key || ajsb_fnode_type(n) != AJSB_FROZEN_OBJECT) return no_node;
+  size_t len = strlen(key), count = W(n)[0] >> 3;
+  const uint32_t *m = W(n) + 1;
+  for (size_t i = 0; i < count; i++, m += 3)
+    if (m[1] == len && !memcmp(n.f->strings + m[0], key, len)) return (ajsb_fnode_t){ n.f, m[2] };
+  return no_node;
+}
+
+const char *ajsb_fnode_str(ajsb_fnode_t n) {
+  ajsb_frozen_type_t t = ajsb_fnode_type(n);
+  return t == AJSB_FROZEN_STRING || t == AJSB_FROZEN_NUMBER ? n.f->strings + W(n)[1] : NULL;
+}
+
+void ajsb_fnode_stringify(ajsb_fnode_t n, aml_buffer_t *bh) {
+  if (!bh) return;
+  const uint32_t *w = n.f ? W(n) : NULL;
+  switch (ajsb_fnode_type(n)) {
+    case AJSB_FROZEN_OBJECT:
+      aml_buffer_appendc(bh, '{');
+      for (uint32_t i = 0, c = w[0] >> 3; i < c; i++) {
+        if (i) aml_buffer_appendc(bh, ',');
+        aml_buffer_appendc(bh, '"');
+        aml_buffer_append(bh, n.f->strings + w[1 + 3 * i], w[2 + 3 * i]);
+        aml_buffer_append(bh, "\":", 2);
+        ajsb_fnode_stringify((ajsb_fnode_t){ n.f, w[3 + 3 * i] }, bh);
+      }
+      aml_buffer_appendc(bh, '}');
+      break;
+    case AJSB_FROZEN_ARRAY:
+      aml_buffer_appendc(bh, '[');
+      for (uint32_t i = 0, c = w[0] >> 3; i < c; i++) {
+        if (i) aml_buffer_appendc(bh, ',');
+        ajsb_fnode_stringify((ajsb_fnode_t){ n.f, w[1 + i] }, bh);
+      }
+      aml_buffer_appendc(bh, ']');
+      break;
+    case AJSB_FROZEN_STRING:
+      aml_buffer_appendc(bh, '"');
+      aml_buffer_append(bh, n.f->strings + w[1], w[2]);
+      aml_buffer_appendc(bh, '"');
+      break;
+    case AJSB_FROZEN_NUMBER: aml_buffer_append(bh, n.f->strings + w[1], w[2]); break;
+    case AJSB_FROZEN_TRUE:   aml_buffer_appends(bh, "true");  break;
+    case AJSB_FROZEN_FALSE:  aml_buffer_appends(bh, "false"); break;
+    case AJSB_FROZEN_NULL:   aml_buffer_appends(bh, "null");  break;
+    default: break;
+  }
+}
@@ -0,0 +1,965 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#include "a-json-schema-builder-library/ajsb_generate.h"
+#include "a-json-schema-builder-library/ajsb_format.h"
+#include "a-json-schema-builder-library/ajsb_link.h"
+#include "a-json-schema-builder-library/ajsb_validate.h"
+#include "ajsb_program.h"
+#include "a-memory-library/aml_alloc.h"
+#include "a-memory-library/aml_pool.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define DEFAULT_DEPTH  6
+#define DEFAULT_ITEMS  4
+#define DEFAULT_LENGTH 12
+#define HARD_DEPTH     64        /* past max_depth: required recursion that never ends */
+#define ATTEMPTS       32        /* candidates per instance */
+#define UNIQUE_TRIES   8         /* per item under uniqueItems */
+#define VIEW_MAX       32        /* subschemas combined for one instance value */
+#define BLOCK          256       /* instances per unit of work in ajsb_generate_file */
+#define NO_BREAK       UINT64_MAX
+#define INF            UINT32_MAX
+#define SIZE_MAX_GEN   (1u << 20)  /* largest minItems / minLength honored */
+#define INVALID_SALT   0x6a09e667f3bcc909ULL
+
+enum { T_NULL = 1, T_BOOL = 2, T_OBJECT = 4, T_ARRAY = 8, T_STRING = 16, T_NUMBER = 32, T_INTEGER = 64 };
+#define T_ALL    127
+#define T_SCALAR (T_NULL | T_BOOL | T_STRING | T_NUMBER | T_INTEGER)
+
+/* A compiled "pattern" with what the random walk needs. A span is treated
+   as one byte class. */
+typedef struct {
+  const ajson_t  *node;         /* the "pattern" string in the schema */
+  const uint32_t *words;
+  uint32_t       *dist;         /* DFA: steps from each state to a match, INF if none */
+  uint16_t       *off;          /* bytes of class c: bytes[off[c] .. off[c + 1]) */
+  uint16_t       *printable;    /* how many of those (they come first) are printable ASCII */
+  uint8_t        *bytes;
+} pattern_t;
+
+struct ajsb_generator_s {
+  aml_pool_t             *pool;
+  ajson_t                *schema;
+  ajsb_link_t            *link;
+  ajsb_program_t         *prog;
+  pattern_t              *patterns;   /* sorted by node */
+  size_t                  num_patterns;
+  ajsb_generate_options_t opts;
+};
+
+/* ── Randomness (splitmix64) ────────────────────────────────────────────── */
+
+typedef struct { uint64_t s; } rng_t;
+
+static uint64_t mix(uint64_t x) {
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+static uint64_t next(rng_t *r) { return mix(r->s += 0x9e3779b97f4a7c15ULL); }
+static uint64_t below(rng_t *r, uint64_t n) { return n ? next(r) % n : 0; }
+static bool coin(rng_t *r) { return next(r) >> 63; }
+static double unit(rng_t *r) { return (double)(next(r) >> 11) / 9007199254740992.0; }
+
+/* ── Patterns ───────────────────────────────────────────────────────────── */
+
+static bool is_printable(unsigned b) { return b >= 0x20 && b < 0x7f; }
+
+static unsigned byte_class(const uint32_t *w, unsigned b) {
+  if (w[0] == AJSB_PATTERN_SPAN) return (w[3 + (b >> 5)] >> (b & 31)) & 1 ? 0 : 1;
+  return (w[3 + (b >> 2)] >> ((b & 3) * 8)) & 0xFF;
+}
+
+/* Group the bytes by class, printable ones first in each. */
+static void pattern_bytes(aml_pool_t *p, pattern_t *pt, unsigned classes) {
+  pt->off = (uint16_t *)aml_pool_zalloc(p, (classes + 1) * sizeof(uint16_t));
+  pt->printable = (uint16_t *)aml_pool_zalloc(p, classes * sizeof(uint16_t));
+  pt->bytes = (uint8_t *)aml_pool_alloc(p, 256);
+  for (unsigned b = 0; b < 256; b++) {
+    unsigned c = byte_class(pt->words, b);
+    if (c < classes) pt->off[c + 1]++;
+  }
+  for (unsigned c = 0; c < classes; c++) pt->off[c + 1] += pt->off[c];
+  uint16_t *fill = (uint16_t *)aml_pool_dup(p, pt->off, classes * sizeof(uint16_t));
+  for (int pass = 0; pass < 2; pass++) {
+    for (unsigned b = 0; b < 256; b++) {
+      unsigned c = byte_class(pt->words, b);
+      if (c >= classes || is_printable(b) != !pass) continue;
+      pt->bytes[fill[c]++] = (uint8_t)b;
+      if (!pass) pt->printable[c]++;
+    }
+  }
+}
+
+/* Breadth-first over reversed transitions from the matching states. */
+static uint32_t *pattern_dist(aml_pool_t *p, const uint32_t *w) {
+  uint32_t states = w[1], classes = w[2];
+  const uint32_t *flags = w + 3 + 64, *next = flags + states;
+  uint32_t *dist = (uint32_t *)aml_pool_alloc(p, states * sizeof(uint32_t));
+  uint32_t *start = (uint32_t *)aml_calloc(states + 1, sizeof(uint32_t));   /* edges into t: */
+  uint32_t *fill = (uint32_t *)aml_malloc(states * sizeof(uint32_t));       /* from[start[t] .. start[t + 1]) */
+  uint32_t *from = (uint32_t *)aml_malloc((size_t)states * classes * sizeof(uint32_t));
+  uint32_t *queue = (uint32_t *)aml_malloc(states * sizeof(uint32_t));
+  size_t head = 0, tail = 0;
+  for (uint32_t s = 0; s < states; s++) {
+    dist[s] = INF;
+    for (uint32_t c = 0; c < classes; c++) start[next[s * classes + c] + 1]++;
+  }
+  for (uint32_t t = 0; t < states; t++) start[t + 1] += start[t];
+  memcpy(fill, start, states * sizeof(uint32_t));
+  for (uint32_t s = 0; s < states; s++)
+    for (uint32_t c = 0; c < classes; c++) from[fill[next[s * classes + c]]++] = s;
+  for (uint32_t s = 1; s < states; s++)
+    if (flags[s] & (AJSB_DFA_MATCH | AJSB_DFA_END_MATCH)) {
+      dist[s] = 0;
+      queue[tail++] = s;
+    }
+  while (head < tail) {
+    uint32_t t = queue[head++];
+    for (uint32_t i = start[t]; i < start[t + 1]; i++) {
+      uint32_t s = from[i];
+      if (s && dist[s] == INF) {
+        dist[s] = dist[t] + 1;
+        queue[tail++] = s;
+      }
+    }
+  }
+  aml_free(start);
+  aml_free(fill);
+  aml_free(from);
+  aml_free(queue);
+  return dist;
+}
+
+static void collect_patterns(ajsb_generator_t *g, ajson_t *j, size_t *cap) {
+  if (ajson_is_array(j)) {
+    for (ajsona_t *a = ajsona_first(j); a; a = ajsona_next(a)) collect_patterns(g, a->value, cap);
+    return;
+  }
+  if (!ajson_is_object(j)) return;
+  for (ajsono_t *m = ajsono_first(j); m; m = ajsono_next(m)) {
+    if (strcmp(m->key, "pattern") || !ajson_is_string(m->value)) {
+      collect_patterns(g, m->value, cap);
+      continue;
+    }
+    const char *re = ajson_to_strd(g->pool, m->value, "");
+    uint32_t *words, count;
+    if (!ajsb_pattern_compile(re, strlen(re), &words, &count) || !count) continue;
+    if (g->num_patterns == *cap) {
+      *cap = *cap ? *cap * 2 : 8;
+      pattern_t *r = (pattern_t *)aml_pool_alloc(g->pool, *cap * sizeof(pattern_t));
+      if (g->num_patterns) memcpy(r, g->patterns, g->num_patterns * sizeof(pattern_t));
+      g->patterns = r;
+    }
+    pattern_t *pt = g->patterns + g->num_patterns++;
+    memset(pt, 0, sizeof(*pt));
+    pt->node = m->value;
+    pt->words = (const uint32_t *)aml_pool_dup(g->pool, words, count * sizeof(uint32_t));
+    aml_free(words);
+    if (pt->words[0] == AJSB_PATTERN_DFA) {
+      pt->dist = pattern_dist(g->pool, pt->words);
+      pattern_bytes(g->pool, pt, pt->words[2]);
+    } else {
+      pattern_bytes(g->pool, pt, 1);
+    }
+  }
+}
+
+static int cmp_pattern(const void *a, const void *b) {
+  uintptr_t x = (uintptr_t)((const pattern_t *)a)->node, y = (uintptr_t)((const pattern_t *)b)->node;
+  return x < y ? -1 : x > y;
+}
+
+static const pattern_t *find_pattern(const ajsb_generator_t *g, const ajson_t *node) {
+  pattern_t key;
+  key.node = node;
+  return node ? (const pattern_t *)bsearch(&key, g->patterns, g->num_patterns,
+                                           sizeof(pattern_t), cmp_pattern) : NULL;
+}
+
+/* ── Generation context ─────────────────────────────────────────────────── */
+
+typedef struct {
+  const ajsb_generator_t *g;
+  aml_buffer_t           *bh;
+  aml_pool_t             *pool;       /* scratch, cleared per candidate */
+  rng_t                   rng;
+  uint64_t                visits;     /* values generated so far */
+  uint64_t                break_at;   /* value to make invalid, NO_BREAK for none */
+} ctx_t;
+
+/* The subschemas one value must satisfy: a schema with its $ref targets,
+   allOf branches and chosen anyOf/oneOf branches. */
+typedef struct {
+  ajson_t *s[VIEW_MAX];
+  size_t   n;
+  bool     never;      /* false is among them */
+} view_t;
+
+static bool shallow(ajson_t *s) {
+  return ajson_is_true(s) ||
+         (ajson_is_object(s) && !ajsono_scan(s, "$ref") && !ajsono_scan(s, "$dynamicRef") &&
+          !ajsono_scan(s, "required") && !ajsono_scan(s, "minItems") && !ajsono_scan(s, "allOf"));
+}
+
+static void view_add(ctx_t *c, view_t *v, ajson_t *s, int depth, int hops);
+
+static void view_pick(ctx_t *c, view_t *v, ajson_t *list, int depth, int hops) {
+  size_t n = ajsona_count(list);
+  if (!ajson_is_array(list) || !n) return;
+  size_t at = (size_t)below(&c->rng, n), i = 0;
+  ajsona_t *a = ajsona_first(list), *pick = NULL;
+  for (; a; a = ajsona_next(a), i++) {
+    if (i == at) pick = a;
+    if (depth >= c->g->opts.max_depth && i >= at && shallow(a->value)) {
+      pick = a;
+      break;
+    }
+  }
+  view_add(c, v, pick->value, depth, hops + 1);
+}
+
+static void view_add(ctx_t *c, view_t *v, ajson_t *s, int depth, int hops) {
+  if (ajson_is_false(s)) v->never = true;
+  if (!ajson_is_object(s) || v->n == VIEW_MAX || hops > VIEW_MAX) return;
+  for (size_t i = 0; i < v->n; i++)
+    if (v->s[i] == s) return;
+  v->s[v->n++] = s;
+  ajson_t *t = ajsb_link_ref(c->g->link, s);
+  if (t) view_add(c, v, t, depth, hops + 1);
+  if ((t = ajsb_link_dynamic_ref(c->g->link, s))) view_add(c, v, t, depth, hops + 1);
+  ajson_t *all = ajsono_scan(s, "allOf");
+  if (ajson_is_array(all))
+    for (ajsona_t *a = ajsona_first(all); a; a = ajsona_next(a)) view_add(c, v, a->value, depth, hops + 1);
+  view_pick(c, v, ajsono_scan(s, "anyOf"), depth, hops);
+  view_pick(c, v, ajsono_scan(s, "oneOf"), depth, hops);
+}
+
+static ajson_t *kw(const view_t *v, const char *name) {
+  for (size_t i = 0; i < v->n; i++) {
+    ajson_t *k = ajsono_scan(v->s[i], name);
+    if (k) return k;
+  }
+  return NULL;
+}
+
+static bool kw_any(const view_t *v, const char *const *names) {
+  for (; *names; names++)
+    if (kw(v, *names)) return true;
+  return false;
+}
+
+/* Tightest non-negative integer keyword over the view (largest if want_max
+   is false, smallest otherwise). */
+static bool kw_count(const view_t *v, const char *name, bool smallest, uint64_t *out) {
+  bool found = false;
+  for (size_t i = 0; i < v->n; i++) {
+    ajson_t *k = ajsono_scan(v->s[i], name);
+    if (!k || !(ajson_is_number(k) || ajson_is_decimal(k))) continue;
+    double d = ajson_to_double(k, 0);
+    uint64_t n = d <= 0 ? 0 : d >= 1e15 ? (uint64_t)1e15 : (uint64_t)d;
+    if (!found || (smallest ? n < *out : n > *out)) *out = n;
+    found = true;
+  }
+  return found;
+}
+
+static unsigned type_bits(ajson_t *t) {
+  if (ajson_is_array(t)) {
+    unsigned m = 0;
+    for (ajsona_t *a = ajsona_first(t); a; a = ajsona_next(a)) m |= type_bits(a->value);
+    return m;
+  }
+  const char *s = ajson_to_str(t, "");
+  if (!strcmp(s, "null"))    return T_NULL;
+  if (!strcmp(s, "boolean")) return T_BOOL;
+  if (!strcmp(s, "object"))  return T_OBJECT;
+  if (!strcmp(s, "array"))   return T_ARRAY;
+  if (!strcmp(s, "string"))  return T_STRING;
+  if (!strcmp(s, "number"))  return T_NUMBER | T_INTEGER;
+  if (!strcmp(s, "integer")) return T_INTEGER;
+  return 0;
+}
+
+static const char *const object_keywords[] = {"properties", "required", "additionalProperties", NULL};
+static const char *const array_keywords[] = {"items", "minItems", "maxItems", "uniqueItems", NULL};
+static const char *const string_keywords[] = {"pattern", "format", "minLength", "maxLength", NULL};
+static const char *const number_keywords[] = {"minimum", "maximum", "exclusiveMinimum", "exclusiveMaximum", NULL};
+
+/* Types the view allows; without "type", the ones its keywords are about. */
+static unsigned view_types(const view_t *v, bool *typed) {
+  unsigned m = T_ALL;
+  *typed = false;
+  for (size_t i = 0; i < v->n; i++) {
+    ajson_t *t = ajsono_scan(v->s[i], "type");
+    if (t) {
+      m &= type_bits(t);
+      *typed = true;
+    }
+  }
+  if (*typed) return m;
+  m = 0;
+  if (kw_any(v, object_keywords)) m |= T_OBJECT;
+  if (kw_any(v, array_keywords))  m |= T_ARRAY;
+  if (kw_any(v, string_keywords)) m |= T_STRING;
+  if (kw_any(v, number_keywords)) m |= T_NUMBER;
+  return m ? m : T_NULL | T_BOOL | T_STRING | T_INTEGER;
+}
+
+typedef struct {
+  double lo, hi;
+  bool   has_lo, has_hi, lo_excl, hi_excl;
+} bounds_t;
+
+static void view_bounds(const view_t *v, bounds_t *b) {
+  memset(b, 0, sizeof(*b));
+  for (size_t i = 0; i < v->n; i++) {
+    for (ajsono_t *m = ajsono_first(v->s[i]); m; m = ajsono_next(m)) {
+      if (!ajson_is_number(m->value) && !ajson_is_decimal(m->value)) continue;
+      double d = ajson_to_double(m->value, 0);
+      bool excl = !strncmp(m->key, "exclusive", 9);
+      if (!strcmp(m->key, "minimum") || !strcmp(m->key, "exclusiveMinimum")) {
+        if (!b->has_lo || d > b->lo || (d == b->lo && excl)) {
+          b->lo = d;
+          b->lo_excl = excl;
+        }
+        b->has_lo = true;
+      } else if (!strcmp(m->key, "maximum") || !strcmp(m->key, "exclusiveMaximum")) {
+        if (!b->has_hi || d < b->hi || (d == b->hi && excl)) {
+          b->hi = d;
+          b->hi_excl = excl;
+        }
+        b->has_hi = true;
+      }
+    }
+  }
+}
+
+/* ── Values ─────────────────────────────────────────────────────────────── */
+
+static void put_string(aml_buffer_t *bh, const uint8_t *s, size_t len) {
+  aml_buffer_appendc(bh, '"');
+  for (size_t i = 0; i < len; i++) {
+    if (s[i] == '"' || s[i] == '\\') {
+      aml_buffer_appendc(bh, '\\');
+      aml_buffer_appendc(bh, (char)s[i]);
+    } else if (s[i] < 0x20) {
+      aml_buffer_appendf(bh, "\\u%04x", s[i]);
+    } else {
+      aml_buffer_appendc(bh, (char)s[i]);
+    }
+  }
+  aml_buffer_appendc(bh, '"');
+}
+
+/* Shortest text that reads back as d. */
+static void put_double(aml_buffer_t *bh, double d) {
+  char buf[40];
+  for (int prec = 1; prec <= 17; prec++) {
+    snprintf(buf, sizeof(buf), "%.*g", prec, d);
+    if (strtod(buf, NULL) == d) break;
+  }
+  aml_buffer_appends(bh, buf);
+}
+
+static const char alnum[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+
+static void put_word(ctx_t *c, size_t len) {
+  for (size_t i = 0; i < len; i++) aml_buffer_appendc(c->bh, alnum[below(&c->rng, 62)]);
+}
+
+static void put_format(ctx_t *c, ajsb_format_t f) {
+  aml_buffer_t *bh = c->bh;
+  rng_t *r = &c->rng;
+  aml_buffer_appendc(bh, '"');
+  if (f == AJSB_FORMAT_DATE || f == AJSB_FORMAT_DATE_TIME)
+    aml_buffer_appendf(bh, "%04u-%02u-%02u", 1970 + (unsigned)below(r, 60),
+                       1 + (unsigned)below(r, 12), 1 + (unsigned)below(r, 28));
+  if (f == AJSB_FORMAT_DATE_TIME) aml_buffer_appendc(bh, 'T');
+  if (f == AJSB_FORMAT_TIME || f == AJSB_FORMAT_DATE_TIME) {
+    aml_buffer_appendf(bh, "%02u:%02u:%02u", (unsigned)below(r, 24), (unsigned)below(r, 60),
+                       (unsigned)below(r, 60));
+    if (coin(r)) aml_buffer_appendf(bh, ".%03u", (unsigned)below(r, 1000));
+    if (coin(r)) aml_buffer_appendc(bh, 'Z');
+    else aml_buffer_appendf(bh, "%c%02u:%02u", coin(r) ? '+' : '-', (unsigned)below(r, 14),
+                            (unsigned)below(r, 4) * 15);
+  }
+  if (f == AJSB_FORMAT_EMAIL) {
+    put_word(c, 1 + below(r, 10));
+    aml_buffer_appendc(bh, '@');
+    put_word(c, 1 + below(r, 10));
+    aml_buffer_appends(bh, coin(r) ? ".com" : ".org");
+  }
+  if (f == AJSB_FORMAT_UUID)
+    aml_buffer_appendf(bh, "%08x-%04x-4%03x-%04x-%012llx", (unsigned)below(r, 1ull << 32),
+                       (unsigned)below(r, 1 << 16), (unsigned)below(r, 1 << 12),
+                       0x8000u | (unsigned)below(r, 1 << 14),
+                       (unsigned long long)below(r, 1ull << 48));
+  if (f == AJSB_FORMAT_IPV4)
+    aml_buffer_appendf(bh, "%u.%u.%u.%u", (unsigned)below(r, 256), (unsigned)below(r, 256),
+                       (unsigned)below(r, 256), (unsigned)below(r, 256));
+  aml_buffer_appendc(bh, '"');
+}
+
+static uint8_t class_byte(ctx_t *c, const pattern_t *pt, unsigned cls) {
+  unsigned first = pt->off[cls], n = pt->off[cls + 1] - first;
+  if (pt->printable[cls]) n = pt->printable[cls];
+  return pt->bytes[first + below(&c->rng, n)];
+}
+
+/* A string of about target bytes that the pattern accepts. */
+static bool put_pattern(ctx_t *c, const pattern_t *pt, size_t target) {
+  const uint32_t *w = pt->words;
+  uint8_t *s;
+  size_t len = 0;
+  if (w[0] == AJSB_PATTERN_SPAN) {
+    size_t lo = w[1], hi = w[2];
+    if (!pt->off[1] && lo) return false;
+    if (hi > lo + c->g->opts.max_length) hi = lo + c->g->opts.max_length;
+    len = target < lo ? lo : target > hi ? hi : target;
+    s = (uint8_t *)aml_pool_alloc(c->pool, len + 1);
+    for (size_t i = 0; i < len; i++) s[i] = class_byte(c, pt, 0);
+    put_string(c->bh, s, len);
+    return true;
+  }
+  uint32_t states = w[1], classes = w[2];
+  const uint32_t *flags = w + 3 + 64, *next = flags + states;
+  if (pt->dist[1] == INF) return false;
+  size_t cap = target + states + 16;
+  s = (uint8_t *)aml_pool_alloc(c->pool, cap);
+  uint32_t *pick = (uint32_t *)aml_pool_alloc(c->pool, classes * sizeof(uint32_t));
+  uint32_t st = 1;
+  for (;;) {
+    if (flags[st] & AJSB_DFA_MATCH) {           /* whatever follows is accepted */
+      while (len < target) s[len++] = (uint8_t)alnum[below(&c->rng, 62)];
+      break;
+    }
+    if ((flags[st] & AJSB_DFA_END_MATCH) && len >= target) break;
+    if (len == cap) return false;
+    /* live moves before target, then only moves that get closer; printable if possible */
+    size_t n = 0;
+    for (int want_printable = 1; want_printable >= 0 && !n; want_printable--) {
+      for (uint32_t k = 0; k < classes; k++) {
+        uint32_t t = next[st * classes + k];
+        if (!t || pt->dist[t] == INF) continue;
+        if (len >= target && pt->dist[t] >= pt->dist[st]) continue;
+        if (want_printable && !pt->printable[k]) continue;
+        pick[n++] = k;
+      }
+    }
+    if (!n) {
+      if (flags[st] & AJSB_DFA_END_MATCH) break;   /* shorter than target, but complete */
+      return false;
+    }
+    uint32_t k = pick[below(&c->rng, n)];
+    s[len++] = class_byte(c, pt, k);
+    st = next[st * classes + k];
+  }
+  put_string(c->bh, s, len);
+  return true;
+}
+
+/* ── The walk ───────────────────────────────────────────────────────────── */
+
+static bool gen(ctx_t *c, ajson_t *const *roots, size_t n, int depth);
+
+typedef struct {
+  const char *key;       /* raw JSON text */
+  ajson_t   **roots;
+  size_t      n;
+  uint32_t    hash;
+  bool        required, present;
+} prop_t;
+
+typedef struct {
+  prop_t   *props;
+  size_t    num, cap;
+  uint32_t *slots;       /* index + 1, 0 = empty */
+  size_t    mask;
+  size_t    maps;        /* "properties" objects in the view */
+} props_t;
+
+static prop_t *prop_find(ctx_t *c, props_t *t, const char *key) {
+  size_t len = strlen(key);
+  uint32_t h = ajsb_hash32(key, len);
+  size_t i = h & t->mask;
+  for (; t->slots[i]; i = (i + 1) & t->mask) {
+    prop_t *p = t->props + t->slots[i] - 1;
+    if (p->hash == h && !strcmp(p->key, key)) return p;
+  }
+  if (t->num == t->cap) return NULL;
+  prop_t *p = t->props + t->num++;
+  memset(p, 0, sizeof(*p));
+  p->key = key;
+  p->hash = h;
+  p->roots = (ajson_t **)aml_pool_alloc(c->pool, (t->maps ? t->maps : 1) * sizeof(ajson_t *));
+  t->slots[i] = (uint32_t)t->num;
+  return p;
+}
+
+static bool gen_object(ctx_t *c, const view_t *v, int depth) {
+  props_t t;
+  memset(&t, 0, sizeof(t));
+  for (size_t i = 0; i < v->n; i++) {
+    ajson_t *props = ajsono_scan(v->s[i], "properties"), *req = ajsono_scan(v->s[i], "required");
+    if (ajson_is_object(props)) {
+      t.cap += ajsono_count(props);
+      t.maps++;
+    }
+    if (ajson_is_array(req)) t.cap += ajsona_count(req);
+  }
+  size_t slots = 16;
+  while (slots < t.cap * 2) slots <<= 1;
+  t.mask = slots - 1;
+  t.slots = (uint32_t *)aml_pool_zalloc(c->pool, slots * sizeof(uint32_t));
+  t.props = (prop_t *)aml_pool_alloc(c->pool, (t.cap ? t.cap : 1) * sizeof(prop_t));
+
+  ajson_t *additional = NULL;
+  for (size_t i = 0; i < v->n; i++) {
+    ajson_t *props = ajsono_scan(v->s[i], "properties");
+    if (!additional) additional = ajsono_scan(v->s[i], "additionalProperties");
+    if (!ajson_is_object(props)) continue;
+    for (ajsono_t *m = ajsono_first(props); m; m = ajsono_next(m)) {
+      prop_t *p = prop_find(c, &t, m->key);
+      if (p) p->roots[p->n++] = m->value;
+    }
+  }
+  for (size_t i = 0; i < v->n; i++) {
+    ajson_t *req = ajsono_scan(v->s[i], "required");
+    if (!ajson_is_array(req)) continue;
+    for (ajsona_t *a = ajsona_first(req); a; a = ajsona_next(a)) {
+      if (!ajson_is_string(a->value)) continue;
+      prop_t *p = prop_find(c, &t, ajson_to_str(a->value, ""));
+      if (!p) continue;
+      p->required = true;
+      if (!p->n && additional && !ajson_is_false(additional)) p->roots[p->n++] = additional;
+    }
+  }
+
+  bool optional = depth < c->g->opts.max_depth;
+  bool first = true;
+  aml_buffer_appendc(c->bh, '{');
+  for (size_t i = 0; i < t.num; i++) {
+    prop_t *p = t.props + i;
+    if (!p->required && !(optional && coin(&c->rng))) continue;
+    if (!first) aml_buffer_appendc(c->bh, ',');
+    first = false;
+    aml_buffer_appendc(c->bh, '"');
+    aml_buffer_appends(c->bh, p->key);
+    aml_buffer_appends(c->bh, "\":");
+    if (!gen(c, p->roots, p->n, depth + 1)) return false;
+  }
+  aml_buffer_appendc(c->bh, '}');
+  return true;
+}
+
+static bool gen_array(ctx_t *c, const view_t *v, int depth) {
+  uint64_t lo = 0, hi = 0;
+  kw_count(v, "minItems", false, &lo);
+  bool bounded = kw_count(v, "maxItems", true, &hi);
+  uint64_t top = lo + c->g->opts.max_items;
+  if (!bounded || hi > top) hi = top;
+  if (hi < lo || lo > SIZE_MAX_GEN) return false;
+  uint64_t n = depth < c->g->opts.max_depth ? lo + below(&c->rng, hi - lo + 1) : lo;
+
+  ajson_t **roots = (ajson_t **)aml_pool_alloc(c->pool, v->n * sizeof(ajson_t *) + 1);
+  size_t num_roots = 0;
+  for (size_t i = 0; i < v->n; i++) {
+    ajson_t *items = ajsono_scan(v->s[i], "items");
+    if (ajson_is_false(items)) n = 0;
+    if (ajson_is_object(items)) roots[num_roots++] = items;
+  }
+  ajson_t *unique = kw(v, "uniqueItems");
+  bool distinct = unique && ajson_is_true(unique) && n > 1;
+  size_t *at = distinct ? (size_t *)aml_pool_alloc(c->pool, (size_t)n * 2 * sizeof(size_t)) : NULL;
+
+  aml_buffer_appendc(c->bh, '[');
+  for (uint64_t i = 0; i < n; i++) {
+    if (i) aml_buffer_appendc(c->bh, ',');
+    size_t start = aml_buffer_length(c->bh);
+    for (int tries = 0;; tries++) {
+      if (!gen(c, roots, num_roots, depth + 1)) return false;
+      if (!distinct) break;
+      size_t len = aml_buffer_length(c->bh) - start;
+      const char *d = aml_buffer_data(c->bh);
+      bool dup = false;
+      for (uint64_t j = 0; j < i && !dup; j++)
+        dup = at[2 * j + 1] == len && !memcmp(d + at[2 * j], d + start, len);
+      if (!dup || tries == UNIQUE_TRIES) {
+        at[2 * i] = start;
+        at[2 * i + 1] = len;
+        break;
+      }
+      aml_buffer_shrink_by(c->bh, len);
+    }
+  }
+  aml_buffer_appendc(c->bh, ']');
+  return true;
+}
+
+static bool gen_string(ctx_t *c, const view_t *v) {
+  uint64_t lo = 0, hi = 0;
+  kw_count(v, "minLength", false, &lo);
+  bool bounded = kw_count(v, "maxLength", true, &hi);
+  uint64_t top = lo + c->g->opts.max_length;
+  if (!bounded || hi > top) hi = top;
+  if (hi < lo || lo > SIZE_MAX_GEN) return false;
+  size_t len = (size_t)(lo + below(&c->rng, hi - lo + 1));
+
+  ajson_t *f = kw(v, "format");
+  ajsb_format_t id = ajson_is_string(f) ? ajsb_format_id(ajson_to_str(f, "")) : AJSB_FORMAT_NONE;
+  if (id != AJSB_FORMAT_NONE) {
+    put_format(c, id);
+    return true;
+  }
+  const pattern_t *pt = find_pattern(c->g, kw(v, "pattern"));
+  if (pt) return put_pattern(c, pt, len);
+  aml_buffer_appendc(c->bh, '"');
+  put_word(c, len);
+  aml_buffer_appendc(c->bh, '"');
+  return true;
+}
+
+#define INT_LIMIT 4503599627370496.0   /* 2^52: integers stay exact */
+
+static bool gen_number(ctx_t *c, const view_t *v, bool integer) {
+  bounds_t b;
+  view_bounds(v, &b);
+  double lo = b.has_lo ? b.lo : b.has_hi ? b.hi - 1000 : -1000;
+  double hi = b.has_hi ? b.hi : lo + 1000;
+  if (integer) {
+    lo = lo < -INT_LIMIT ? -INT_LIMIT : lo;
+    hi = hi > INT_LIMIT ? INT_LIMIT : hi;
+    long long a = (long long)lo, z = (long long)hi;
+    if ((double)a < lo || (b.lo_excl && (double)a == lo)) a++;
+    if ((double)z > hi || (b.hi_excl && (double)z == hi)) z--;
+    if (z < a) return false;
+    aml_buffer_appendf(c->bh, "%lld", a + (long long)below(&c->rng, (uint64_t)(z - a) + 1));
+    return true;
+  }
+  if (hi < lo || (hi == lo && (b.lo_excl || b.hi_excl))) return false;
+  double x = lo + (hi - lo) * unit(&c->rng);
+  double r = (double)(long long)(x * 100) / 100;        /* two decimals when that still fits */
+  if (x > -INT_LIMIT && x < INT_LIMIT && r >= lo && r <= hi) x = r;
+  if ((b.lo_excl && x <= lo) || (b.hi_excl && x >= hi)) x = lo + (hi - lo) / 2;
+  put_double(c->bh, x);
+  return true;
+}
+
+/* Replace this value with one that breaks one of the view's keywords.
+   False if the view has nothing checkable to break. */
+static bool gen_broken(ctx_t *c, const view_t *v) {
+  enum { B_TYPE, B_ENUM, B_BELOW, B_ABOVE, B_FEW, B_MANY, B_MISSING, B_EXTRA, B_PATTERN, B_FORMAT };
+  int opts[10], n = 0;
+  bool typed;
+  unsigned types = view_types(v, &typed);
+  bounds_t b;
+  view_bounds(v, &b);
+  uint64_t count;
+  ajson_t *k;
+  const pattern_t *pt = find_pattern(c->g, kw(v, "pattern"));
+  if (typed && types != T_ALL) opts[n++] = B_TYPE;
+  if (kw(v, "enum") || kw(v, "const")) opts[n++] = B_ENUM;
+  if (b.has_lo) opts[n++] = B_BELOW;
+  if (b.has_hi) opts[n++] = B_ABOVE;
+  if (kw_count(v, "minItems", false, &count) && count) opts[n++] = B_FEW;
+  if (kw_count(v, "maxItems", true, &count) && count < 1000) opts[n++] = B_MANY;
+  if ((k = kw(v, "required")) && ajsona_count(k)) opts[n++] = B_MISSING;
+  if ((k = kw(v, "additionalProperties")) && ajson_is_false(k)) opts[n++] = B_EXTRA;
+  if (pt) opts[n++] = B_PATTERN;
+  if ((k = kw(v, "format")) && ajsb_format_id(ajson_to_str(k, "")) != AJSB_FORMAT_NONE) opts[n++] = B_FORMAT;
+  if (!n) return false;
+
+  static const struct { unsigned type; const char *text; } wrong[] = {
+    {T_NULL, "null"}, {T_BOOL, "false"}, {T_STRING, "\"\""}, {T_INTEGER, "1"},
+    {T_NUMBER, "0.5"}, {T_OBJECT, "{}"}, {T_ARRAY, "[]"},
+  };
+  aml_buffer_t *bh = c->bh;
+  switch (opts[below(&c->rng, (uint64_t)n)]) {
+    case B_TYPE: {
+      size_t at = (size_t)below(&c->rng, 7);
+      for (size_t i = 0; i < 7; i++) {
+        size_t w = (at + i) % 7;
+        if (!(types & wrong[w].type)) {
+          aml_buffer_appends(bh, wrong[w].text);
+          return true;
+        }
+      }
+      return false;
+    }
+    case B_ENUM:    aml_buffer_appends(bh, "\"\\u0001not-a-member\""); return true;
+    case B_BELOW:   put_double(bh, b.lo_excl ? b.lo : b.lo - 1); return true;
+    case B_ABOVE:   put_double(bh, b.hi_excl ? b.hi : b.hi + 1); return true;
+    case B_FEW:     aml_buffer_appends(bh, "[]"); return true;
+    case B_MANY:
+      aml_buffer_appendc(bh, '[');
+      for (uint64_t i = 0; i <= count; i++) aml_buffer_appends(bh, i ? ",null" : "null");
+      aml_buffer_appendc(bh, ']');
+      return true;
+    case B_MISSING: aml_buffer_appends(bh, "{}"); return true;
+    case B_EXTRA:   aml_buffer_appends(bh, "{\"\\u0001extra\":null}"); return true;
+    case B_PATTERN: {
+      static const char *const miss[] = {"", "\x01", "~", " ", "0", "a"};
+      for (size_t i = 0; i < sizeof(miss) / sizeof(miss[0]); i++) {
+        if (!ajsb_pattern_match(pt->words, miss[i], strlen(miss[i]))) {
+          put_string(bh, (const uint8_t *)miss[i], strlen(miss[i]));
+          return true;
+        }
+      }
+      return false;
+    }
+    default:        aml_buffer_appends(bh, "\"?\""); return true;
+  }
+}
+
+static bool gen(ctx_t *c, ajson_t *const *roots, size_t n, int depth) {
+  if (depth > c->g->opts.max_depth + HARD_DEPTH) return false;
+  view_t v;
+  v.n = 0;
+  v.never = false;
+  for (size_t i = 0; i < n; i++) view_add(c, &v, roots[i], depth, 0);
+  if (v.never) return false;
+  if (c->visits++ == c->break_at && gen_broken(c, &v)) return true;
+
+  ajson_t *k = kw(&v, "const");
+  if (k) {
+    ajson_dump_to_buffer(c->bh, k);
+    return true;
+  }
+  k = kw(&v, "enum");
+  if (ajson_is_array(k) && ajsona_count(k)) {
+    uint64_t at = below(&c->rng, ajsona_count(k));
+    ajsona_t *a = ajsona_first(k);
+    while (at--) a = ajsona_next(a);
+    ajson_dump_to_buffer(c->bh, a->value);
+    return true;
+  }
+
+  bool typed;
+  unsigned types = view_types(&v, &typed);
+  if (depth >= c->g->opts.max_depth && (types & T_SCALAR)) types &= T_SCALAR;
+  if (!types) return false;
+  unsigned bits[7], num = 0;
+  for (unsigned t = 1; t <= T_INTEGER; t <<= 1)
+    if (types & t) bits[num++] = t;
+  switch (bits[below(&c->rng, num)]) {
+    case T_NULL:    aml_buffer_appends(c->bh, "null"); return true;
+    case T_BOOL:    aml_buffer_appends(c->bh, coin(&c->rng) ? "true" : "false"); return true;
+    case T_OBJECT:  return gen_object(c, &v, depth);
+    case T_ARRAY:   return gen_array(c, &v, depth);
+    case T_STRING:  return gen_string(c, &v);
+    case T_NUMBER:  return gen_number(c, &v, false);
+    default:        return gen_number(c, &v, true);
+  }
+}
+
+/* ── Instances ──────────────────────────────────────────────────────────── */
+
+static bool check(const ajsb_generator_t *g, aml_pool_t *pool, aml_buffer_t *bh, size_t start) {
+  size_t len = aml_buffer_length(bh) - start;
+  char *t = aml_pool_strndup(pool, aml_buffer_data(bh) + start, len);
+  ajson_t *j = ajson_parse(pool, t, t + len);
+  return j && !ajson_is_error(j) && ajsb_validate(g->prog, j);
+}
+
+static bool generate(const ajsb_generator_t *g, aml_pool_t *pool, uint64_t n, bool valid,
+                     aml_buffer_t *bh) {
+  ctx_t c;
+  c.g = g;
+  c.bh = bh;
+  c.pool = pool;
+  c.rng.s = mix(g->opts.seed ^ mix(valid ? n : n ^ INVALID_SALT));
+  size_t start = aml_buffer_length(bh);
+  for (int attempt = 0; attempt < ATTEMPTS; attempt++) {
+    aml_pool_clear(pool);
+    c.visits = 0;
+    c.break_at = NO_BREAK;
+    if (!valid) {
+      /* walk once to count the values (as far as it gets), then replay and
+         break one of them */
+      rng_t saved = c.rng;
+      gen(&c, &g->schema, 1, 0);
+      aml_buffer_shrink_by(bh, aml_buffer_length(bh) - start);
+      c.break_at = below(&c.rng, c.visits);
+      c.rng = saved;
+      c.visits = 0;
+      aml_pool_clear(pool);
+    }
+    if (gen(&c, &g->schema, 1, 0) && check(g, pool, bh, start) == valid) return true;
+    aml_buffer_shrink_by(bh, aml_buffer_length(bh) - start);
+  }
+  return false;
+}
+
+/* ── Public API ─────────────────────────────────────────────────────────── */
+
+ajsb_generator_t *ajsb_generator_init(ajson_t *schema, const ajsb_generate_options_t *opts) {
+  if (!schema) return NULL;
+  aml_pool_t *pool = aml_pool_init(16384);
+  ajsb_generator_t *g = (ajsb_generator_t *)aml_pool_zalloc(pool, sizeof(*g));
+  g->pool = pool;
+  g->schema = schema;
+  if (opts) g->opts = *opts;
+  if (g->opts.max_depth <= 0) g->opts.max_depth = DEFAULT_DEPTH;
+  if (!g->opts.max_items) g->opts.max_items = DEFAULT_ITEMS;
+  if (!g->opts.max_length) g->opts.max_length = DEFAULT_LENGTH;
+  g->prog = ajsb_compile(pool, schema);
+  if (!g->prog) {
+    aml_pool_destroy(pool);
+    return NULL;
+  }
+  g->link = ajsb_link(pool, schema);
+  size_t cap = 0;
+  collect_patterns(g, schema, &cap);
+  if (g->num_patterns) qsort(g->patterns, g->num_patterns, sizeof(pattern_t), cmp_pattern);
+  return g;
+}
+
+void ajsb_generator_destroy(ajsb_generator_t *g) {
+  if (g) aml_pool_destroy(g->pool);
+}
+
+bool ajsb_generate(const ajsb_generator_t *g, uint64_t n, bool valid, aml_buffer_t *bh) {
+  if (!g || !bh) return false;
+  aml_pool_t *pool = aml_pool_init(4096);
+  bool ok = generate(g, pool, n, valid, bh);
+  aml_pool_destroy(pool);
+  return ok;
+}
+
+/* ── JSON Lines file ────────────────────────────────────────────────────── */
+
+/* Workers claim blocks of BLOCK instances in order and fill a ring of
+   slots; the calling thread writes the slots out in block order, so the file
+   does not depend on how the work was spread. */
+typedef struct {
+  aml_buffer_t *bh;
+  uint64_t      block;
+  bool          ready;
+} slot_t;
+
+typedef struct {
+  const ajsb_generator_t *g;
+  pthread_mutex_t         mu;
+  pthread_cond_t          cv;
+  slot_t                 *slots;
+  size_t                  num_slots;
+  uint64_t                next;        /* next block to claim */
+  uint64_t                written;     /* blocks written out */
+  bool                    stop;
+} file_job_t;
+
+static bool is_valid(const ajsb_generator_t *g, uint64_t n) {
+  double r = (double)(mix(g->opts.seed ^ mix(n ^ INVALID_SALT ^ 1)) >> 11) / 9007199254740992.0;
+  return r >= g->opts.invalid_ratio;
+}
+
+static void *file_worker(void *arg) {
+  file_job_t *job = (file_job_t *)arg;
+  aml_pool_t *pool = aml_pool_init(16384);
+  aml_buffer_t *bh = aml_buffer_init(1 << 16);
+  pthread_mutex_lock(&job->mu);
+  while (!job->stop) {
+    uint64_t block = job->next++;
+    slot_t *slot = job->slots + block % job->num_slots;
+    while (!job->stop && block >= job->written + job->num_slots) pthread_cond_wait(&job->cv, &job->mu);
+    if (job->stop) break;
+    pthread_mutex_unlock(&job->mu);
+
+    aml_buffer_clear(bh);
+    for (uint64_t n = block * BLOCK; n < (block + 1) * BLOCK; n++)
+      if (generate(job->g, pool, n, is_valid(job->g, n), bh)) aml_buffer_appendc(bh, '\n');
+
+    pthread_mutex_lock(&job->mu);
+    aml_buffer_t *t = slot->bh;
+    slot->bh = bh;
+    bh = t;
+    slot->block = block;
+    slot->ready = true;
+    pthread_cond_broadcast(&job->cv);
+  }
+  pthread_mutex_unlock(&job->mu);
+  aml_buffer_destroy(bh);
+  aml_pool_destroy(pool);
+  return NULL;
+}
+
+static int default_threads(void) {
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  return n > 0 ? (int)n : 1;
+}
+
+size_t ajsb_generate_file(const ajsb_generator_t *g, const char *path, size_t bytes) {
+  if (!g || !path) return (size_t)-1;
+  FILE *out = fopen(path, "wb");
+  if (!out) return (size_t)-1;
+
+  file_job_t job;
+  memset(&job, 0, sizeof(job));
+  job.g = g;
+  pthread_mutex_init(&job.mu, NULL);
+  pthread_cond_init(&job.cv, NULL);
+  size_t threads = (size_t)(g->opts.threads > 0 ? g->opts.threads : default_threads());
+  job.num_slots = threads * 2;
+  job.slots = (slot_t *)aml_calloc(job.num_slots, sizeof(slot_t));
+  for (size_t i = 0; i < job.num_slots; i++) job.slots[i].bh = aml_buffer_init(1 << 16);
+  pthread_t *tids = (pthread_t *)aml_calloc(threads, sizeof(pthread_t));
+  size_t started = 0;
+  for (; started < threads; started++)
+    if (pthread_create(tids + started, NULL, file_worker, &job)) break;
+
+  size_t total = 0, lines = 0;
+  bool ok = started > 0, io_error = false;
+  aml_buffer_t *bh = aml_buffer_init(1 << 16);
+  pthread_mutex_lock(&job.mu);
+  while (ok && total < bytes) {
+    slot_t *slot = job.slots + job.written % job.num_slots;
+    while (!(slot->ready && slot->block == job.written)) pthread_cond_wait(&job.cv, &job.mu);
+    aml_buffer_t *t = slot->bh;
+    slot->bh = bh;
+    bh = t;
+    slot->ready = false;
+    pthread_mutex_unlock(&job.mu);
+
+    const char *s = aml_buffer_data(bh), *e = s + aml_buffer_length(bh), *from = s;
+    if (s == e) ok = false;                          /* a whole block failed: stop */
+    while (s < e && total + (size_t)(s - from) < bytes) {
+      s = (const char *)memchr(s, '\n', (size_t)(e - s)) + 1;
+      lines++;
+    }
+    if (s > from && fwrite(from, 1, (size_t)(s - from), out) != (size_t)(s - from)) {
+      io_error = true;
+      ok = false;
+    }
+    total += (size_t)(s - from);
+
+    pthread_mutex_lock(&job.mu);
+    job.written++;
+    pthread_cond_broadcast(&job.cv);
+  }
+  job.stop = true;
+  pthread_cond_broadcast(&job.cv);
+  pthread_mutex_unlock(&job.mu);
+  for (size_t i = 0; i < started; i++) pthread_join(tids[i], NULL);
+
+  aml_free(tids);
+  for (size_t i = 0; i < job.num_slots; i++) aml_buffer_destroy(job.slots[i].bh);
+  aml_free(job.slots);
+  aml_buffer_destroy(bh);
+  pthread_cond_destroy(&job.cv);
+  pthread_mutex_destroy(&job.mu);
+  if (fclose(out)) io_error = true;
+  return io_error || (bytes && !lines) ? (size_t)-1 : lines;
+}
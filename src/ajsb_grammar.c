@@ -0,0 +1,1037 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#include "a-json-schema-builder-library/ajsb_grammar.h"
+#include "ajsb_program.h"
+#include "a-memory-library/aml_alloc.h"
+#include "a-memory-library/aml_buffer.h"
+
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Elements of an alternative, kind in the top two bits. A byte literal is a
+   run of E_CHAR elements; every alternative ends with E_END. */
+enum { E_END = 0, E_CHAR, E_CLASS, E_RULE };
+#define E(kind, arg)  (((uint32_t)(kind) << 30) | (uint32_t)(arg))
+#define E_KIND(e)     ((e) >> 30)
+#define E_ARG(e)      ((e) & 0x3fffffffu)
+#define SEP           UINT32_MAX      /* alternative separator while building */
+
+#define MAX_BOUND     64              /* larger minItems/maxItems are left open */
+#define MAX_EPSILON   1024            /* recursion guard for empty expansions */
+
+typedef struct { uint8_t bits[32]; } byteset_t;
+
+typedef struct {
+  uint32_t name;                      /* offset into names */
+  uint32_t first_alt;
+  uint32_t num_alts;
+} rule_t;
+
+struct ajsb_grammar_s {
+  const rule_t    *rules;
+  const uint32_t  *alts;              /* first element of each alternative */
+  const uint32_t  *elems;
+  const byteset_t *classes;
+  const byteset_t *alt_first;         /* bytes an alternative can start with */
+  const uint8_t   *alt_nullable;
+  const byteset_t *rule_first;
+  const uint8_t   *rule_nullable;
+  const char      *names;
+  const char      *gbnf;
+  uint32_t num_rules, num_alts, num_elems, num_classes;
+  uint32_t start;                     /* element where matching begins */
+};
+
+static inline bool set_has(const byteset_t *s, uint8_t c) { return (s->bits[c >> 3] >> (c & 7)) & 1; }
+static inline void set_add(byteset_t *s, uint8_t c) { s->bits[c >> 3] |= (uint8_t)(1u << (c & 7)); }
+static inline bool set_or(byteset_t *d, const byteset_t *s) {
+  bool changed = false;
+  for (int i = 0; i < 32; i++) {
+    uint8_t v = d->bits[i] | s->bits[i];
+    changed |= v != d->bits[i];
+    d->bits[i] = v;
+  }
+  return changed;
+}
+static void set_range(byteset_t *s, int lo, int hi) { for (int c = lo; c <= hi; c++) set_add(s, (uint8_t)c); }
+
+/* ── Builder ────────────────────────────────────────────────────────────── */
+
+typedef struct {
+  uint32_t *e;
+  uint32_t  n, cap;
+} seq_t;
+
+/* Shared helper rules, created on first use. */
+enum {
+  H_WS, H_VALUE, H_OBJECT, H_OBJECT_REST, H_MEMBER, H_ARRAY, H_ARRAY_REST,
+  H_STRING, H_CHARS, H_CHAR, H_ESCAPE, H_HEX,
+  H_INTEGER, H_INT, H_DIGITS, H_NUMBER, H_FRAC, H_EXP,
+  H_COUNT
+};
+
+static const char *const helper_names[H_COUNT] = {
+  "ws", "value", "object", "object-rest", "member", "array", "array-rest",
+  "string", "chars", "char", "escape", "hex",
+  "integer", "int", "digits", "number", "frac", "exp"
+};
+
+typedef struct {
+  const ajsb_program_t *prog;
+  rule_t    *rules;    uint32_t num_rules,   cap_rules;
+  uint32_t  *alts;     uint32_t num_alts,    cap_alts;
+  uint32_t  *elems;    uint32_t num_elems,   cap_elems;
+  byteset_t *classes;  uint32_t num_classes, cap_classes;
+  char      *names;    uint32_t names_len,   cap_names;
+  uint32_t  *node_rule;                 /* program node → rule id + 1 */
+  uint32_t   helper[H_COUNT];           /* rule id + 1 */
+  bool       failed;
+} builder_t;
+
+static bool reserve(builder_t *b, void **arr, uint32_t *cap, uint32_t need, size_t elem) {
+  if (need <= *cap) return true;
+  uint32_t n = *cap ? *cap : 64;
+  while (n < need) n *= 2;
+  void *r = aml_realloc(*arr, (size_t)n * elem);
+  if (!r) { b->failed = true; return false; }
+  *arr = r;
+  *cap = n;
+  return true;
+}
+
+static void push(builder_t *b, seq_t *s, uint32_t e) {
+  if (!reserve(b, (void **)&s->e, &s->cap, s->n + 1, sizeof(uint32_t))) return;
+  s->e[s->n++] = e;
+}
+
+static void lit(builder_t *b, seq_t *s, const char *text, size_t len) {
+  for (size_t i = 0; i < len; i++) push(b, s, E(E_CHAR, (unsigned char)text[i]));
+}
+#define LIT(b, s, text) lit((b), (s), (text), sizeof(text) - 1)
+
+static void alt(builder_t *b, seq_t *s) { push(b, s, SEP); }
+
+static void ref(builder_t *b, seq_t *s, uint32_t rule) {
+  if (rule != AJSB_NONE) push(b, s, E(E_RULE, rule));
+}
+
+static uint32_t class_id(builder_t *b, const byteset_t *set) {
+  for (uint32_t i = 0; i < b->num_classes; i++)
+    if (!memcmp(b->classes + i, set, sizeof(*set))) return i;
+  if (!reserve(b, (void **)&b->classes, &b->cap_classes, b->num_classes + 1, sizeof(byteset_t)))
+    return 0;
+  b->classes[b->num_classes] = *set;
+  return b->num_classes++;
+}
+
+static void cls(builder_t *b, seq_t *s, const byteset_t *set) {
+  push(b, s, E(E_CLASS, class_id(b, set)));
+}
+
+static void cls_range(builder_t *b, seq_t *s, int lo, int hi) {
+  byteset_t set = {{0}};
+  set_range(&set, lo, hi);
+  cls(b, s, &set);
+}
+
+static uint32_t new_rule(builder_t *b, const char *fmt, ...) {
+  char name[64];
+  va_list args;
+  va_start(args, fmt);
+  int len = vsnprintf(name, sizeof(name), fmt, args);
+  va_end(args);
+  if (len < 0) len = 0;
+  if (len >= (int)sizeof(name)) len = sizeof(name) - 1;
+
+  if (!reserve(b, (void **)&b->names, &b->cap_names, b->names_len + (uint32_t)len + 1, 1) ||
+      !reserve(b, (void **)&b->rules, &b->cap_rules, b->num_rules + 1, sizeof(rule_t)))
+    return 0;
+  memcpy(b->names + b->names_len, name, (size_t)len + 1);
+  rule_t *r = b->rules + b->num_rules;
+  r->name = b->names_len;
+  r->first_alt = 0;
+  r->num_alts = 0;
+  b->names_len += (uint32_t)len + 1;
+  return b->num_rules++;
+}
+
+/* Split s on SEP into the alternatives of rule and release s. */
+static void commit(builder_t *b, uint32_t rule, seq_t *s) {
+  if (!b->failed) {
+    b->rules[rule].first_alt = b->num_alts;
+    uint32_t i = 0;
+    do {
+      if (!reserve(b, (void **)&b->alts, &b->cap_alts, b->num_alts + 1, sizeof(uint32_t))) break;
+      b->alts[b->num_alts++] = b->num_elems;
+      b->rules[rule].num_alts++;
+      for (; i < s->n && s->e[i] != SEP; i++) {
+        if (!reserve(b, (void **)&b->elems, &b->cap_elems, b->num_elems + 1, sizeof(uint32_t))) break;
+        b->elems[b->num_elems++] = s->e[i];
+      }
+      if (!reserve(b, (void **)&b->elems, &b->cap_elems, b->num_elems + 1, sizeof(uint32_t))) break;
+      b->elems[b->num_elems++] = E(E_END, 0);
+    } while (i++ < s->n);
+  }
+  aml_free(s->e);
+  memset(s, 0, sizeof(*s));
+}
+
+static uint32_t helper(builder_t *b, int h);
+
+static void ws(builder_t *b, seq_t *s) { ref(b, s, helper(b, H_WS)); }
+
+static uint32_t helper(builder_t *b, int h) {
+  if (b->helper[h]) return b->helper[h] - 1;
+  uint32_t r = new_rule(b, "%s", helper_names[h]);
+  b->helper[h] = r + 1;
+
+  seq_t s = {0};
+  switch (h) {
+  case H_WS: {                       /* ws ::= | [ \t\n\r] ws */
+    byteset_t set = {{0}};
+    set_add(&set, ' '); set_add(&set, '\t'); set_add(&set, '\n'); set_add(&set, '\r');
+    alt(b, &s);
+    cls(b, &s, &set);
+    ref(b, &s, r);
+    break;
+  }
+  case H_VALUE:
+    ref(b, &s, helper(b, H_OBJECT));  alt(b, &s);
+    ref(b, &s, helper(b, H_ARRAY));   alt(b, &s);
+    ref(b, &s, helper(b, H_STRING));  alt(b, &s);
+    ref(b, &s, helper(b, H_NUMBER));  alt(b, &s);
+    LIT(b, &s, "true");  alt(b, &s);
+    LIT(b, &s, "false"); alt(b, &s);
+    LIT(b, &s, "null");
+    break;
+  case H_OBJECT:
+    LIT(b, &s, "{"); ws(b, &s); LIT(b, &s, "}");
+    alt(b, &s);
+    LIT(b, &s, "{"); ws(b, &s); ref(b, &s, helper(b, H_MEMBER)); ref(b, &s, helper(b, H_OBJECT_REST));
+    break;
+  case H_OBJECT_REST:
+    LIT(b, &s, "}");
+    alt(b, &s);
+    LIT(b, &s, ","); ws(b, &s); ref(b, &s, helper(b, H_MEMBER)); ref(b, &s, r);
+    break;
+  case H_MEMBER:
+    ref(b, &s, helper(b, H_STRING)); ws(b, &s); LIT(b, &s, ":"); ws(b, &s);
+    ref(b, &s, helper(b, H_VALUE)); ws(b, &s);
+    break;
+  case H_ARRAY:
+    LIT(b, &s, "["); ws(b, &s); LIT(b, &s, "]");
+    alt(b, &s);
+    LIT(b, &s, "["); ws(b, &s); ref(b, &s, helper(b, H_VALUE)); ws(b, &s);
+    ref(b, &s, helper(b, H_ARRAY_REST));
+    break;
+  case H_ARRAY_REST:
+    LIT(b, &s, "]");
+    alt(b, &s);
+    LIT(b, &s, ","); ws(b, &s); ref(b, &s, helper(b, H_VALUE)); ws(b, &s); ref(b, &s, r);
+    break;
+  case H_STRING:
+    LIT(b, &s, "\""); ref(b, &s, helper(b, H_CHARS)); LIT(b, &s, "\"");
+    break;
+  case H_CHARS:                      /* chars ::= | char chars */
+    alt(b, &s);
+    ref(b, &s, helper(b, H_CHAR)); ref(b, &s, r);
+    break;
+  case H_CHAR: {
+    byteset_t set;
+    memset(&set, 0xff, sizeof(set));
+    for (int c = 0; c < 0x20; c++) set.bits[c >> 3] &= (uint8_t)~(1u << (c & 7));
+    set.bits['"' >> 3]  &= (uint8_t)~(1u << ('"' & 7));
+    set.bits['\\' >> 3] &= (uint8_t)~(1u << ('\\' & 7));
+    cls(b, &s, &set);
+    alt(b, &s);
+    LIT(b, &s, "\\"); ref(b, &s, helper(b, H_ESCAPE));
+    break;
+  }
+  case H_ESCAPE: {
+    byteset_t set = {{0}};
+    for (const char *c = "\"\\/bfnrt"; *c; c++) set_add(&set, (uint8_t)*c);
+    cls(b, &s, &set);
+    alt(b, &s);
+    uint32_t hex = helper(b, H_HEX);
+    LIT(b, &s, "u"); ref(b, &s, hex); ref(b, &s, hex); ref(b, &s, hex); ref(b, &s, hex);
+    break;
+  }
+  case H_HEX: {
+    byteset_t set = {{0}};
+    set_range(&set, '0', '9'); set_range(&set, 'a', 'f'); set_range(&set, 'A', 'F');
+    cls(b, &s, &set);
+    break;
+  }
+  case H_INTEGER:
+    LIT(b, &s, "-"); ref(b, &s, helper(b, H_INT));
+    alt(b, &s);
+    ref(b, &s, helper(b, H_INT));
+    break;
+  case H_INT:
+    LIT(b, &s, "0");
+    alt(b, &s);
+    cls_range(b, &s, '1', '9'); ref(b, &s, helper(b, H_DIGITS));
+    break;
+  case H_DIGITS:                     /* digits ::= | [0-9] digits */
+    alt(b, &s);
+    cls_range(b, &s, '0', '9'); ref(b, &s, r);
+    break;
+  case H_NUMBER:
+    ref(b, &s, helper(b, H_INTEGER)); ref(b, &s, helper(b, H_FRAC)); ref(b, &s, helper(b, H_EXP));
+    break;
+  case H_FRAC:
+    alt(b, &s);
+    LIT(b, &s, "."); cls_range(b, &s, '0', '9'); ref(b, &s, helper(b, H_DIGITS));
+    break;
+  case H_EXP: {
+    byteset_t e = {{0}}, sign = {{0}};
+    set_add(&e, 'e'); set_add(&e, 'E');
+    set_add(&sign, '+'); set_add(&sign, '-');
+    alt(b, &s);
+    cls(b, &s, &e); cls(b, &s, &sign); cls_range(b, &s, '0', '9'); ref(b, &s, helper(b, H_DIGITS));
+    alt(b, &s);
+    cls(b, &s, &e); cls_range(b, &s, '0', '9'); ref(b, &s, helper(b, H_DIGITS));
+    break;
+  }
+  }
+  commit(b, r, &s);
+  return r;
+}
+
+/* ── Lowering program nodes ─────────────────────────────────────────────── */
+
+static uint32_t node_rule(builder_t *b, uint32_t node);
+
+static const char *rule_name(builder_t *b, uint32_t r) { return b->names + b->rules[r].name; }
+
+/* "name" ws ":" ws value ws */
+static void member(builder_t *b, seq_t *s, const ajsb_entry_t *e) {
+  LIT(b, s, "\"");
+  lit(b, s, ajsb_entry_str(b->prog, e), e->len);
+  LIT(b, s, "\"");
+  ws(b, s); LIT(b, s, ":"); ws(b, s);
+  ref(b, s, node_rule(b, e->node));
+  ws(b, s);
+}
+
+static void lower_object(builder_t *b, uint32_t r, seq_t *s,
+                         const ajsb_op_t *props, const ajsb_op_t *addl) {
+  uint32_t n = props ? props->u.b : 0;
+  if (!n) {
+    if (props && (props->flags & AJSB_PF_NO_ADDITIONAL)) {
+      LIT(b, s, "{"); ws(b, s); LIT(b, s, "}");
+      return;
+    }
+    if (!addl) { ref(b, s, helper(b, H_OBJECT)); return; }
+    /* "{" ws ( string ws ":" ws addl ws ("," ws string ...)* )? "}" */
+    uint32_t kv = new_rule(b, "%s-kv", rule_name(b, r));
+    uint32_t rest = new_rule(b, "%s-rest", rule_name(b, r));
+    seq_t k = {0}, t = {0};
+    ref(b, &k, helper(b, H_STRING)); ws(b, &k); LIT(b, &k, ":"); ws(b, &k);
+    ref(b, &k, node_rule(b, addl->a)); ws(b, &k);
+    commit(b, kv, &k);
+    LIT(b, &t, "}");
+    alt(b, &t);
+    LIT(b, &t, ","); ws(b, &t); ref(b, &t, kv); ref(b, &t, rest);
+    commit(b, rest, &t);
+    LIT(b, s, "{"); ws(b, s); LIT(b, s, "}");
+    alt(b, s);
+    LIT(b, s, "{"); ws(b, s); ref(b, s, kv); ref(b, s, rest);
+    return;
+  }
+
+  const ajsb_entry_t *e = b->prog->entries + props->a;
+  bool all_required = true;
+  for (uint32_t i = 0; i < n; i++) all_required &= e[i].aux != 0;
+
+  LIT(b, s, "{"); ws(b, s);
+  if (all_required) {
+    for (uint32_t i = 0; i < n; i++) {
+      if (i) { LIT(b, s, ","); ws(b, s); }
+      member(b, s, e + i);
+    }
+    LIT(b, s, "}");
+    return;
+  }
+
+  /* start[i]: members i.. with none written yet; after[i]: at least one
+     written, so each is preceded by a comma. Optional members may be skipped. */
+  uint32_t *start = (uint32_t *)aml_malloc(sizeof(uint32_t) * 2 * (n + 1));
+  uint32_t *after = start + n + 1;
+  start[n] = after[n] = AJSB_NONE;
+  for (uint32_t i = n; i-- > 0;) {
+    bool optional = !e[i].aux;
+    if (i) {                          /* after[0] is never reached */
+      seq_t a = {0};
+      after[i] = new_rule(b, "%s-a%u", rule_name(b, r), i);
+      LIT(b, &a, ","); ws(b, &a); member(b, &a, e + i); ref(b, &a, after[i + 1]);
+      if (optional) { alt(b, &a); ref(b, &a, after[i + 1]); }
+      commit(b, after[i], &a);
+    }
+    if (!i || !e[i - 1].aux) {        /* reached only by skipping member i - 1 */
+      seq_t f = {0};
+      start[i] = new_rule(b, "%s-s%u", rule_name(b, r), i);
+      member(b, &f, e + i); ref(b, &f, after[i + 1]);
+      if (optional) { alt(b, &f); ref(b, &f, start[i + 1]); }
+      commit(b, start[i], &f);
+    }
+  }
+  ref(b, s, start[0]);
+  LIT(b, s, "}");
+  aml_free(start);
+}
+
+static void lower_array(builder_t *b, uint32_t r, seq_t *s,
+                        uint32_t item_node, uint32_t min, uint32_t max) {
+  if (max != AJSB_NONE && max > MAX_BOUND) max = AJSB_NONE;
+  if (min > MAX_BOUND) min = MAX_BOUND;
+  if (max != AJSB_NONE && min > max) min = max;
+  if (max == 0) { LIT(b, s, "["); ws(b, s); LIT(b, s, "]"); return; }
+
+  uint32_t item = item_node == AJSB_NONE ? helper(b, H_VALUE) : node_rule(b, item_node);
+
+  /* tail k = what may follow once k items are written */
+  uint32_t top = max != AJSB_NONE ? max : (min > 1 ? min : 1);
+  uint32_t next = AJSB_NONE;
+  for (uint32_t k = top; k >= 1; k--) {
+    if (max != AJSB_NONE && k == max) { next = AJSB_NONE; continue; }
+    uint32_t t = new_rule(b, "%s-t%u", rule_name(b, r), k);
+    seq_t q = {0};
+    if (k >= min) alt(b, &q);                 /* may stop here */
+    LIT(b, &q, ","); ws(b, &q); ref(b, &q, item); ws(b, &q);
+    ref(b, &q, (max == AJSB_NONE && k == top) ? t : next);
+    commit(b, t, &q);
+    next = t;
+  }
+  if (!min) {
+    LIT(b, s, "["); ws(b, s); LIT(b, s, "]");
+    alt(b, s);
+  }
+  LIT(b, s, "["); ws(b, s); ref(b, s, item); ws(b, s); ref(b, s, next); LIT(b, s, "]");
+}
+
+static void lower_enum(builder_t *b, seq_t *s, const ajsb_op_t *op, uint32_t mask) {
+  bool first = true;
+  for (uint32_t i = 0; i < op->u.b; i++) {
+    const ajsb_entry_t *e = b->prog->entries + op->a + i;
+    uint32_t need;
+    switch (e->node) {
+    case AJSB_V_STRING: need = AJSB_T_STRING; break;
+    case AJSB_V_NUMBER: need = AJSB_T_NUMBER | AJSB_T_INTEGER; break;
+    case AJSB_V_TRUE:
+    case AJSB_V_FALSE:  need = AJSB_T_BOOLEAN; break;
+    case AJSB_V_NULL:   need = AJSB_T_NULL; break;
+    default:            need = AJSB_T_OBJECT | AJSB_T_ARRAY; break;
+    }
+    if (!(mask & need)) continue;
+    if (!first) alt(b, s);
+    first = false;
+    switch (e->node) {
+    case AJSB_V_STRING:
+      LIT(b, s, "\""); lit(b, s, ajsb_entry_str(b->prog, e), e->len); LIT(b, s, "\"");
+      break;
+    case AJSB_V_TRUE:  LIT(b, s, "true");  break;
+    case AJSB_V_FALSE: LIT(b, s, "false"); break;
+    case AJSB_V_NULL:  LIT(b, s, "null");  break;
+    default:           lit(b, s, ajsb_entry_str(b->prog, e), e->len); break;
+    }
+  }
+  if (first) cls(b, s, &(byteset_t){{0}});   /* nothing allowed */
+}
+
+static void lower_node(builder_t *b, uint32_t node, uint32_t r, seq_t *s) {
+  const ajsb_program_t *prog = b->prog;
+  const ajsb_op_t *en = NULL, *props = NULL, *addl = NULL, *any = NULL, *all = NULL;
+  uint32_t mask = 0x7f, items = AJSB_NONE, min = 0, max = AJSB_NONE, target = AJSB_NONE;
+  bool typed = false, shaped_object = false, shaped_array = false;
+
+  for (const ajsb_op_t *op = prog->ops + node; op->op != AJSB_OP_END; op++) {
+    switch (op->op) {
+    case AJSB_OP_FALSE:      cls(b, s, &(byteset_t){{0}}); return;
+    case AJSB_OP_TYPE:       mask &= op->a; typed = true; break;
+    case AJSB_OP_ENUM:       if (!en) en = op; break;
+    case AJSB_OP_MIN_ITEMS:  min = op->a; shaped_array = true; break;
+    case AJSB_OP_MAX_ITEMS:  max = op->a; shaped_array = true; break;
+    case AJSB_OP_ITEMS:      items = op->a; shaped_array = true; break;
+    case AJSB_OP_PROPERTIES: props = op; shaped_object = true; break;
+    case AJSB_OP_ADDITIONAL: addl = op; break;
+    case AJSB_OP_ANY_OF:
+    case AJSB_OP_ONE_OF:     if (!any) any = op; break;
+    case AJSB_OP_ALL_OF:     if (!all) all = op; break;
+    case AJSB_OP_REF:        if (target == AJSB_NONE) target = op->a; break;
+    default: break;
+    }
+  }
+
+  if (en) { lower_enum(b, s, en, mask); return; }
+  if (any) {
+    for (uint32_t i = 0; i < any->u.b; i++) {
+      if (i) alt(b, s);
+      ref(b, s, node_rule(b, prog->lists[any->a + i]));
+    }
+    return;
+  }
+  if (!typed && !shaped_object && !shaped_array) {
+    if (target != AJSB_NONE) { ref(b, s, node_rule(b, target)); return; }
+    if (all && all->u.b) { ref(b, s, node_rule(b, prog->lists[all->a])); return; }
+    ref(b, s, helper(b, H_VALUE));
+    return;
+  }
+  if (!typed) mask = (shaped_object ? AJSB_T_OBJECT : 0) | (shaped_array ? AJSB_T_ARRAY : 0);
+
+  bool first = true;
+#define NEXT_ALT() do { if (!first) alt(b, s); first = false; } while (0)
+  if (mask & AJSB_T_OBJECT)  { NEXT_ALT(); lower_object(b, r, s, props, addl); }
+  if (mask & AJSB_T_ARRAY)   { NEXT_ALT(); lower_array(b, r, s, items, min, max); }
+  if (mask & AJSB_T_STRING)  { NEXT_ALT(); ref(b, s, helper(b, H_STRING)); }
+  if (mask & AJSB_T_NUMBER)  { NEXT_ALT(); ref(b, s, helper(b, H_NUMBER)); }
+  else if (mask & AJSB_T_INTEGER) { NEXT_ALT(); ref(b, s, helper(b, H_INTEGER)); }
+  if (mask & AJSB_T_BOOLEAN) { NEXT_ALT(); LIT(b, s, "true"); alt(b, s); LIT(b, s, "false"); }
+  if (mask & AJSB_T_NULL)    { NEXT_ALT(); LIT(b, s, "null"); }
+#undef NEXT_ALT
+  if (first) cls(b, s, &(byteset_t){{0}});
+}
+
+static uint32_t node_rule(builder_t *b, uint32_t node) {
+  if (b->failed || node >= b->prog->num_ops) return 0;
+  if (b->node_rule[node]) return b->node_rule[node] - 1;
+  uint32_t r = new_rule(b, "n%u", node);
+  b->node_rule[node] = r + 1;
+  seq_t s = {0};
+  lower_node(b, node, r, &s);
+  commit(b, r, &s);
+  return r;
+}
+
+/* ── Tables ─────────────────────────────────────────────────────────────── */
+
+/* FIRST/nullable of the element run starting at e; returns nullable. */
+static bool first_of(const ajsb_grammar_t *g, const uint32_t *e, byteset_t *first,
+                     const byteset_t *rule_first, const uint8_t *rule_nullable) {
+  for (;; e++) {
+    switch (E_KIND(*e)) {
+    case E_END:   return true;
+    case E_CHAR:  set_add(first, (uint8_t)E_ARG(*e)); return false;
+    case E_CLASS: set_or(first, g->classes + E_ARG(*e)); return false;
+    default:
+      set_or(first, rule_first + E_ARG(*e));
+      if (!rule_nullable[E_ARG(*e)]) return false;
+    }
+  }
+}
+
+static void compute_first(ajsb_grammar_t *g, byteset_t *alt_first, uint8_t *alt_nullable,
+                          byteset_t *rule_first, uint8_t *rule_nullable) {
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (uint32_t r = 0; r < g->num_rules; r++) {
+      const rule_t *rule = g->rules + r;
+      for (uint32_t a = rule->first_alt; a < rule->first_alt + rule->num_alts; a++) {
+        byteset_t f = alt_first[a];
+        bool n = first_of(g, g->elems + g->alts[a], &f, rule_first, rule_nullable);
+        if (memcmp(&f, alt_first + a, sizeof(f)) || n != alt_nullable[a]) {
+          alt_first[a] = f;
+          alt_nullable[a] = n;
+          changed = true;
+        }
+        changed |= set_or(rule_first + r, &f);
+        if (n && !rule_nullable[r]) { rule_nullable[r] = 1; changed = true; }
+      }
+    }
+  }
+}
+
+/* ── GBNF rendering ─────────────────────────────────────────────────────── */
+
+static void gbnf_char(aml_buffer_t *bh, uint8_t c, bool in_class) {
+  switch (c) {
+  case '\n': aml_buffer_appends(bh, "\\n"); return;
+  case '\r': aml_buffer_appends(bh, "\\r"); return;
+  case '\t': aml_buffer_appends(bh, "\\t"); return;
+  case '\\': aml_buffer_appends(bh, "\\\\"); return;
+  case '"':  aml_buffer_appends(bh, "\\\""); return;
+  default: break;
+  }
+  if (c < 0x20 || c == 0x7f || (in_class && (c == ']' || c == '^' || c == '-' || c == '[')))
+    aml_buffer_appendf(bh, "\\x%02X", c);
+  else
+    aml_buffer_appendc(bh, (char)c);
+}
+
+/* Byte classes are ASCII sets or complements of one, so a set containing the
+   high half is rendered negated (matching any non-ASCII code point). */
+static void gbnf_class(aml_buffer_t *bh, const byteset_t *set) {
+  bool negate = set_has(set, 0x80);
+  int listed = 0;
+  for (int c = 0; c < 0x80; c++) listed += set_has(set, (uint8_t)c) != negate;
+  if (!listed) {                      /* nothing, or everything */
+    aml_buffer_appends(bh, negate ? "[\\x00-\\U0010FFFF]" : "[^\\x00-\\U0010FFFF]");
+    return;
+  }
+  aml_buffer_appends(bh, negate ? "[^" : "[");
+  for (int c = 0; c < 0x80; c++) {
+    if (set_has(set, (uint8_t)c) == negate) continue;
+    int hi = c;
+    while (hi + 1 < 0x80 && set_has(set, (uint8_t)(hi + 1)) != negate) hi++;
+    gbnf_char(bh, (uint8_t)c, true);
+    if (hi - c >= 2) { aml_buffer_appendc(bh, '-'); gbnf_char(bh, (uint8_t)hi, true); c = hi; }
+  }
+  aml_buffer_appendc(bh, ']');
+}
+
+static const char *render_gbnf(aml_pool_t *p, const ajsb_grammar_t *g) {
+  aml_buffer_t *bh = aml_buffer_init(1024);
+  for (uint32_t r = 0; r < g->num_rules; r++) {
+    const rule_t *rule = g->rules + r;
+    aml_buffer_appends(bh, g->names + rule->name);
+    aml_buffer_appends(bh, " ::=");
+    for (uint32_t a = 0; a < rule->num_alts; a++) {
+      if (a) aml_buffer_appends(bh, " |");
+      const uint32_t *e = g->elems + g->alts[rule->first_alt + a];
+      while (E_KIND(*e) != E_END) {
+        aml_buffer_appendc(bh, ' ');
+        if (E_KIND(*e) == E_CHAR) {
+          aml_buffer_appendc(bh, '"');
+          for (; E_KIND(*e) == E_CHAR; e++) gbnf_char(bh, (uint8_t)E_ARG(*e), false);
+          aml_buffer_appendc(bh, '"');
+          continue;
+        }
+        if (E_KIND(*e) == E_CLASS) gbnf_class(bh, g->classes + E_ARG(*e));
+        else aml_buffer_appends(bh, g->names + g->rules[E_ARG(*e)].name);
+        e++;
+      }
+    }
+    aml_buffer_appendc(bh, '\n');
+  }
+  const char *text = aml_pool_strdup(p, aml_buffer_data(bh));
+  aml_buffer_destroy(bh);
+  return text;
+}
+
+/* ── Public API: compile ────────────────────────────────────────────────── */
+
+static void *pool_copy(aml_pool_t *p, const void *d, size_t len) {
+  return len ? aml_pool_dup(p, d, len) : NULL;
+}
+
+ajsb_grammar_t *ajsb_grammar_from_program(aml_pool_t *p, const ajsb_program_t *prog) {
+  if (!p || !prog) return NULL;
+  builder_t b;
+  memset(&b, 0, sizeof(b));
+  b.prog = prog;
+  b.node_rule = (uint32_t *)aml_calloc(prog->num_ops ? prog->num_ops : 1, sizeof(uint32_t));
+  if (!b.node_rule) return NULL;
+
+  /* root ::= ws <schema> ws */
+  uint32_t root = new_rule(&b, "root");
+  seq_t s = {0};
+  ws(&b, &s);
+  ref(&b, &s, node_rule(&b, prog->root));
+  ws(&b, &s);
+  commit(&b, root, &s);
+
+  ajsb_grammar_t *g = NULL;
+  if (!b.failed) {
+    g = (ajsb_grammar_t *)aml_pool_zalloc(p, sizeof(*g));
+    g->rules       = (const rule_t *)pool_copy(p, b.rules, (size_t)b.num_rules * sizeof(rule_t));
+    g->alts        = (const uint32_t *)pool_copy(p, b.alts, (size_t)b.num_alts * sizeof(uint32_t));
+    g->elems       = (const uint32_t *)pool_copy(p, b.elems, (size_t)b.num_elems * sizeof(uint32_t));
+    g->classes     = (const byteset_t *)pool_copy(p, b.classes, (size_t)b.num_classes * sizeof(byteset_t));
+    g->names       = (const char *)pool_copy(p, b.names, b.names_len);
+    g->num_rules   = b.num_rules;
+    g->num_alts    = b.num_alts;
+    g->num_elems   = b.num_elems;
+    g->num_classes = b.num_classes;
+    g->start       = g->alts[g->rules[root].first_alt];
+
+    byteset_t *alt_first  = (byteset_t *)aml_pool_zalloc(p, (size_t)b.num_alts * sizeof(byteset_t));
+    uint8_t   *alt_null   = (uint8_t *)aml_pool_zalloc(p, b.num_alts);
+    byteset_t *rule_first = (byteset_t *)aml_pool_zalloc(p, (size_t)b.num_rules * sizeof(byteset_t));
+    uint8_t   *rule_null  = (uint8_t *)aml_pool_zalloc(p, b.num_rules);
+    compute_first(g, alt_first, alt_null, rule_first, rule_null);
+    g->alt_first     = alt_first;
+    g->alt_nullable  = alt_null;
+    g->rule_first    = rule_first;
+    g->rule_nullable = rule_null;
+    g->gbnf          = render_gbnf(p, g);
+  }
+  aml_free(b.rules);
+  aml_free(b.alts);
+  aml_free(b.elems);
+  aml_free(b.classes);
+  aml_free(b.names);
+  aml_free(b.node_rule);
+  return g;
+}
+
+ajsb_grammar_t *ajsb_to_grammar(aml_pool_t *p, ajson_t *schema) {
+  if (!p || !schema) return NULL;
+  aml_pool_t *tmp = aml_pool_init(4096);
+  ajsb_grammar_t *g = ajsb_grammar_from_program(p, ajsb_compile(tmp, schema));
+  aml_pool_destroy(tmp);
+  return g;
+}
+
+const char *ajsb_grammar_gbnf(const ajsb_grammar_t *g) {
+  return g ? g->gbnf : NULL;
+}
+
+size_t ajsb_grammar_num_rules(const ajsb_grammar_t *g) {
+  return g ? g->num_rules : 0;
+}
+
+/* ── Matcher ────────────────────────────────────────────────────────────── */
+
+/* Each live parse is a stack of return positions. Stacks are hash-consed into
+   a generation so equal suffixes are shared and equal parses collapse; every
+   byte copies the surviving stacks into the other generation, which drops the
+   dead ones. */
+typedef struct {
+  uint32_t item;                      /* element index */
+  uint32_t parent;                    /* node below, or AJSB_NONE */
+} snode_t;
+
+typedef struct {
+  snode_t  *n;      uint32_t num, cap;
+  uint32_t *tab;    uint32_t mask;    /* node index + 1 */
+  uint8_t  *live;   uint32_t cap_live;
+} gen_t;
+
+struct ajsb_grammar_matcher_s {
+  const ajsb_grammar_t *g;
+  gen_t     gen[2];
+  int       cur;
+  uint32_t *configs;  uint32_t num_configs,  cap_configs;
+  uint32_t *next;     uint32_t num_next,     cap_next;
+  uint32_t *copied;   uint32_t cap_copied;   /* old node → new node + 1 */
+  bool      dead;
+};
+
+static bool grow(void **arr, uint32_t *cap, uint32_t need, size_t elem) {
+  if (need <= *cap) return true;
+  uint32_t n = *cap ? *cap : 64;
+  while (n < need) n *= 2;
+  void *r = aml_realloc(*arr, (size_t)n * elem);
+  if (!r) return false;
+  *arr = r;
+  *cap = n;
+  return true;
+}
+
+static inline uint32_t snode_hash(uint32_t item, uint32_t parent) {
+  uint64_t x = ((uint64_t)item << 32) | parent;
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  return (uint32_t)x;
+}
+
+static void gen_clear(gen_t *g) {
+  g->num = 0;
+  if (g->tab) memset(g->tab, 0, (size_t)(g->mask + 1) * sizeof(uint32_t));
+}
+
+static uint32_t gen_intern(gen_t *g, uint32_t item, uint32_t parent) {
+  if (!g->tab || (g->num + 1) * 2 > g->mask + 1) {
+    uint32_t size = g->tab ? (g->mask + 1) * 2 : 256;
+    uint32_t *t = (uint32_t *)aml_calloc(size, sizeof(uint32_t));
+    if (!t) return AJSB_NONE;
+    for (uint32_t i = 0; i < g->num; i++) {
+      uint32_t j = snode_hash(g->n[i].item, g->n[i].parent) & (size - 1);
+      while (t[j]) j = (j + 1) & (size - 1);
+      t[j] = i + 1;
+    }
+    aml_free(g->tab);
+    g->tab = t;
+    g->mask = size - 1;
+  }
+  uint32_t j = snode_hash(item, parent) & g->mask;
+  for (; g->tab[j]; j = (j + 1) & g->mask) {
+    snode_t *x = g->n + g->tab[j] - 1;
+    if (x->item == item && x->parent == parent) return g->tab[j] - 1;
+  }
+  if (!grow((void **)&g->n, &g->cap, g->num + 1, sizeof(snode_t)) ||
+      !grow((void **)&g->live, &g->cap_live, g->num + 1, 1))
+    return AJSB_NONE;
+  g->n[g->num].item = item;
+  g->n[g->num].parent = parent;
+  g->live[g->num] = 0;
+  g->tab[j] = g->num + 1;
+  return g->num++;
+}
+
+/* Copy an old-generation stack into the new one. */
+static uint32_t copy_stack(ajsb_grammar_matcher_t *m, gen_t *from, gen_t *to, uint32_t i) {
+  if (i == AJSB_NONE) return AJSB_NONE;
+  if (m->copied[i]) return m->copied[i] - 1;
+  uint32_t parent = copy_stack(m, from, to, from->n[i].parent);
+  uint32_t r = gen_intern(to, from->n[i].item, parent);
+  m->copied[i] = r + 1;
+  return r;
+}
+
+static void add_config(ajsb_grammar_matcher_t *m, gen_t *to, uint32_t i) {
+  if (i == AJSB_NONE || to->live[i]) return;
+  if (!grow((void **)&m->next, &m->cap_next, m->num_next + 1, sizeof(uint32_t))) return;
+  to->live[i] = 1;
+  m->next[m->num_next++] = i;
+}
+
+/* Consume c at element item with the return stack parent (new generation). */
+static void advance(ajsb_grammar_matcher_t *m, gen_t *to, uint32_t item, uint32_t parent,
+                    uint8_t c, int depth) {
+  const ajsb_grammar_t *g = m->g;
+  if (depth > MAX_EPSILON) return;
+  uint32_t e = g->elems[item];
+  switch (E_KIND(e)) {
+  case E_CHAR:
+    if (E_ARG(e) == c) add_config(m, to, gen_intern(to, item + 1, parent));
+    return;
+  case E_CLASS:
+    if (set_has(g->classes + E_ARG(e), c)) add_config(m, to, gen_intern(to, item + 1, parent));
+    return;
+  case E_RULE: {
+    const rule_t *r = g->rules + E_ARG(e);
+    uint32_t ret = AJSB_NONE;
+    for (uint32_t a = r->first_alt; a < r->first_alt + r->num_alts; a++) {
+      if (!set_has(g->alt_first + a, c) && !g->alt_nullable[a]) continue;
+      if (ret == AJSB_NONE) ret = gen_intern(to, item + 1, parent);
+      if (ret == AJSB_NONE) return;
+      advance(m, to, g->alts[a], ret, c, depth + 1);
+    }
+    return;
+  }
+  default:                            /* E_END: return to the caller */
+    if (parent != AJSB_NONE)
+      advance(m, to, to->n[parent].item, to->n[parent].parent, c, depth + 1);
+    return;
+  }
+}
+
+static void step(ajsb_grammar_matcher_t *m, uint8_t c) {
+  gen_t *from = m->gen + m->cur, *to = m->gen + !m->cur;
+  gen_clear(to);
+  if (!grow((void **)&m->copied, &m->cap_copied, from->num ? from->num : 1, sizeof(uint32_t))) {
+    m->dead = true;
+    return;
+  }
+  memset(m->copied, 0, (size_t)from->num * sizeof(uint32_t));
+  m->num_next = 0;
+  for (uint32_t i = 0; i < m->num_configs; i++) {
+    const snode_t *x = from->n + m->configs[i];
+    advance(m, to, x->item, copy_stack(m, from, to, x->parent), c, 0);
+  }
+
+  uint32_t *t = m->configs; m->configs = m->next; m->next = t;
+  uint32_t cap = m->cap_configs; m->cap_configs = m->cap_next; m->cap_next = cap;
+  m->num_configs = m->num_next;
+  m->cur = !m->cur;
+  if (!m->num_configs) m->dead = true;
+}
+
+ajsb_grammar_matcher_t *ajsb_grammar_matcher_init(const ajsb_grammar_t *g) {
+  if (!g) return NULL;
+  ajsb_grammar_matcher_t *m = (ajsb_grammar_matcher_t *)aml_calloc(1, sizeof(*m));
+  if (!m) return NULL;
+  m->g = g;
+  ajsb_grammar_matcher_reset(m);
+  return m;
+}
+
+void ajsb_grammar_matcher_destroy(ajsb_grammar_matcher_t *m) {
+  if (!m) return;
+  for (int i = 0; i < 2; i++) {
+    aml_free(m->gen[i].n);
+    aml_free(m->gen[i].tab);
+    aml_free(m->gen[i].live);
+  }
+  aml_free(m->configs);
+  aml_free(m->next);
+  aml_free(m->copied);
+  aml_free(m);
+}
+
+void ajsb_grammar_matcher_reset(ajsb_grammar_matcher_t *m) {
+  if (!m) return;
+  m->cur = 0;
+  m->dead = false;
+  m->num_configs = 0;
+  gen_clear(m->gen);
+  uint32_t i = gen_intern(m->gen, m->g->start, AJSB_NONE);
+  if (i == AJSB_NONE || !grow((void **)&m->configs, &m->cap_configs, 1, sizeof(uint32_t))) {
+    m->dead = true;
+    return;
+  }
+  m->configs[m->num_configs++] = i;
+}
+
+bool ajsb_grammar_matcher_push(ajsb_grammar_matcher_t *m, const char *data, size_t len) {
+  if (!m || m->dead) return false;
+  for (size_t i = 0; i < len && !m->dead; i++) step(m, (uint8_t)data[i]);
+  return !m->dead;
+}
+
+/* Walk from a configuration over empty-deriving rules, collecting the bytes
+   that may come next. Returns true if the stack can be emptied. */
+static bool walk(const ajsb_grammar_matcher_t *m, uint32_t i, byteset_t *allowed) {
+  const ajsb_grammar_t *g = m->g;
+  const gen_t *gen = m->gen + m->cur;
+  uint32_t item = gen->n[i].item, parent = gen->n[i].parent;
+  for (;;) {
+    uint32_t e = g->elems[item];
+    switch (E_KIND(e)) {
+    case E_CHAR:
+      if (allowed) set_add(allowed, (uint8_t)E_ARG(e));
+      return false;
+    case E_CLASS:
+      if (allowed) set_or(allowed, g->classes + E_ARG(e));
+      return false;
+    case E_RULE:
+      if (allowed) set_or(allowed, g->rule_first + E_ARG(e));
+      if (!g->rule_nullable[E_ARG(e)]) return false;
+      item++;
+      break;
+    default:
+      if (parent == AJSB_NONE) return true;
+      item = gen->n[parent].item;
+      parent = gen->n[parent].parent;
+      break;
+    }
+  }
+}
+
+bool ajsb_grammar_matcher_complete(const ajsb_grammar_matcher_t *m) {
+  if (!m || m->dead) return false;
+  for (uint32_t i = 0; i < m->num_configs; i++)
+    if (walk(m, m->configs[i], NULL)) return true;
+  return false;
+}
+
+void ajsb_grammar_matcher_allowed(const ajsb_grammar_matcher_t *m, uint8_t allowed[32]) {
+  if (!allowed) return;
+  memset(allowed, 0, 32);
+  if (!m || m->dead) return;
+  byteset_t set = {{0}};
+  for (uint32_t i = 0; i < m->num_configs; i++) walk(m, m->configs[i], &set);
+  memcpy(allowed, set.bits, 32);
+}
+
+/* ── Cache ──────────────────────────────────────────────────────────────── */
+
+typedef struct {
+  uint64_t        hash;
+  const char     *text;               /* compact schema text, confirms the hit */
+  ajsb_grammar_t *g;
+  aml_pool_t     *pool;               /* holds text and g */
+} cache_entry_t;
+
+struct ajsb_grammar_cache_s {
+  pthread_mutex_t lock;
+  cache_entry_t  *tab;
+  size_t          mask, count;
+  size_t          hits, misses;       /* atomic */
+};
+
+static uint64_t hash64(const char *s) {
+  uint64_t h = 1469598103934665603ULL;
+  for (; *s; s++) {
+    h ^= (unsigned char)*s;
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+ajsb_grammar_cache_t *ajsb_grammar_cache_init(void) {
+  ajsb_grammar_cache_t *c = (ajsb_grammar_cache_t *)aml_calloc(1, sizeof(*c));
+  if (!c) return NULL;
+  pthread_mutex_init(&c->lock, NULL);
+  c->mask = 63;
+  c->tab = (cache_entry_t *)aml_calloc(c->mask + 1, sizeof(cache_entry_t));
+  return c;
+}
+
+void ajsb_grammar_cache_destroy(ajsb_grammar_cache_t *c) {
+  if (!c) return;
+  pthread_mutex_destroy(&c->lock);
+  for (size_t i = 0; c->tab && i <= c->mask; i++)
+    if (c->tab[i].pool) aml_pool_destroy(c->tab[i].pool);
+  aml_free(c->tab);
+  aml_free(c);
+}
+
+static void cache_grow(ajsb_grammar_cache_t *c) {
+  size_t size = (c->mask + 1) * 2;
+  cache_entry_t *t = (cache_entry_t *)aml_calloc(size, sizeof(cache_entry_t));
+  if (!t) return;
+  for (size_t i = 0; i <= c->mask; i++) {
+    if (!c->tab[i].g) continue;
+    size_t j = c->tab[i].hash & (size - 1);
+    while (t[j].g) j = (j + 1) & (size - 1);
+    t[j] = c->tab[i];
+  }
+  aml_free(c->tab);
+  c->tab = t;
+  c->mask = size - 1;
+}
+
+/* Slot holding text, or the empty slot where it belongs. Under c->lock. */
+static cache_entry_t *cache_find(ajsb_grammar_cache_t *c, uint64_t h, const char *text) {
+  size_t i = h & c->mask;
+  while (c->tab[i].g && (c->tab[i].hash != h || strcmp(c->tab[i].text, text)))
+    i = (i + 1) & c->mask;
+  return c->tab + i;
+}
+
+/* A miss compiles outside the lock, into the pool that already holds the
+   schema text; the entry keeps that pool. If another thread inserted the
+   same schema meanwhile, its grammar wins and ours is dropped. */
+const ajsb_grammar_t *ajsb_grammar_cache_get(ajsb_grammar_cache_t *c, ajson_t *schema) {
+  if (!c || !schema || !c->tab) return NULL;
+  aml_pool_t *tmp = aml_pool_init(4096);
+  const char *text = ajson_stringify(tmp, schema);
+  uint64_t h = hash64(text);
+
+  pthread_mutex_lock(&c->lock);
+  ajsb_grammar_t *g = cache_find(c, h, text)->g;
+  pthread_mutex_unlock(&c->lock);
+  if (g) {
+    __atomic_fetch_add(&c->hits, 1, __ATOMIC_RELAXED);
+    aml_pool_destroy(tmp);
+    return g;
+  }
+
+  __atomic_fetch_add(&c->misses, 1, __ATOMIC_RELAXED);
+  ajsb_grammar_t *mine = ajsb_to_grammar(tmp, schema);
+  if (!mine) {
+    aml_pool_destroy(tmp);
+    return NULL;
+  }
+  pthread_mutex_lock(&c->lock);
+  cache_entry_t *e = cache_find(c, h, text);
+  g = e->g;
+  if (!g) {
+    *e = (cache_entry_t){ h, text, mine, tmp };
+    g = mine;
+    tmp = NULL;
+    if (++c->count * 2 > c->mask + 1) cache_grow(c);
+  }
+  pthread_mutex_unlock(&c->lock);
+  if (tmp) aml_pool_destroy(tmp);
+  return g;
+}
+
+size_t ajsb_grammar_cache_hits(const ajsb_grammar_cache_t *c) {
+  return c ? __atomic_load_n(&c->hits, __ATOMIC_RELAXED) : 0;
+}
+
+size_t ajsb_grammar_cache_misses(const ajsb_grammar_cache_t *c) {
+  return c ? __atomic_load_n(&c->misses, __ATOMIC_RELAXED) : 0;
+}
@@ -0,0 +1,170 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#include "a-json-schema-builder-library/ajsb_index.h"
+#include "a-json-schema-builder-library/ajsb.h"
+#include "a-json-schema-builder-library/ajsb_cache.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+
+/* One table for everything: (container, name) → member. A container's own
+   entry (name == NULL) records that its existing members have been indexed. */
+typedef struct {
+  const ajson_t *container;
+  const char    *name;
+  void          *member;      /* ajsono_t* for objects, ajsona_t* for required */
+  uint32_t       hash;
+} slot_t;
+
+struct ajsb_index_s {
+  aml_pool_t *p;
+  slot_t     *slots;
+  size_t      mask, count;
+};
+
+static inline uint32_t key_hash(const ajson_t *c, const char *name) {
+  uint64_t x = (uintptr_t)c;
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  uint32_t h = (uint32_t)(x ^ (x >> 32));
+  for (const unsigned char *s = (const unsigned char *)name; s && *s; s++) {
+    h ^= *s;
+    h *= 16777619u;
+  }
+  return h;
+}
+
+static bool same_name(const char *a, const char *b) {
+  if (!a || !b) return a == b;
+  return !strcmp(a, b);
+}
+
+static slot_t *find(ajsb_index_t *ix, const ajson_t *c, const char *name, uint32_t h) {
+  for (size_t i = h & ix->mask;; i = (i + 1) & ix->mask) {
+    slot_t *s = ix->slots + i;
+    if (!s->container) return s;
+    if (s->hash == h && s->container == c && same_name(s->name, name)) return s;
+  }
+}
+
+/* Tables live in the pool; a grown table simply abandons the old one. */
+static bool grow(ajsb_index_t *ix) {
+  if ((ix->count + 1) * 2 <= ix->mask + 1) return true;
+  size_t size = (ix->mask + 1) * 2;
+  slot_t *n = (slot_t *)aml_pool_zalloc(ix->p, size * sizeof(slot_t));
+  if (!n) return false;
+  for (size_t i = 0; i <= ix->mask; i++) {
+    if (!ix->slots[i].container) continue;
+    size_t j = ix->slots[i].hash & (size - 1);
+    while (n[j].container) j = (j + 1) & (size - 1);
+    n[j] = ix->slots[i];
+  }
+  ix->slots = n;
+  ix->mask = size - 1;
+  return true;
+}
+
+static void put(ajsb_index_t *ix, const ajson_t *c, const char *name, void *member) {
+  if (!grow(ix)) return;
+  uint32_t h = key_hash(c, name);
+  slot_t *s = find(ix, c, name, h);
+  if (!s->container) ix->count++;
+  s->container = c;
+  s->name = name;
+  s->member = member;
+  s->hash = h;
+}
+
+/* Index the members a container already has, once. */
+static void adopt(ajsb_index_t *ix, ajson_t *c) {
+  if (find(ix, c, NULL, key_hash(c, NULL))->container) return;
+  if (ajson_is_object(c)) {
+    for (ajsono_t *m = ajsono_first(c); m; m = ajsono_next(m)) put(ix, c, m->key, m);
+  } else {
+    for (ajsona_t *a = ajsona_first(c); a; a = ajsona_next(a))
+      if (ajson_is_string(a->value)) put(ix, c, ajson_to_strd(ix->p, a->value, ""), a);
+  }
+  put(ix, c, NULL, c);
+}
+
+static ajson_t *child(ajsb_index_t *ix, ajson_t *obj, const char *key, bool array) {
+  ajson_t *c = ajsono_scan(obj, key);
+  if (!c || (array ? !ajson_is_array(c) : !ajson_is_object(c))) {
+    c = array ? ajsona(ix->p) : ajsono(ix->p);
+    ajsono_set(obj, key, c, /*copy_key=*/false);
+    ajsb_touch(obj);
+  }
+  adopt(ix, c);
+  return c;
+}
+
+static void set_member(ajsb_index_t *ix, ajson_t *c, const char *name, ajson_t *schema) {
+  slot_t *s = find(ix, c, name, key_hash(c, name));
+  if (s->container) {
+    ((ajsono_t *)s->member)->value = schema;       /* replace in place */
+    ajsb_touch(c);
+    return;
+  }
+  char *key = aml_pool_strdup(ix->p, name);
+  ajsono_append(c, key, schema, /*copy_key=*/false);
+  put(ix, c, key, ajsono_last(c));
+  ajsb_touch(c);
+}
+
+/* ── Public API ─────────────────────────────────────────────────────────── */
+
+/* Same contract as ajsb.h: changing a shared node means a missing ajsb_cow. */
+static inline bool read_only(const ajson_t *j) {
+  if (!ajsb_is_shared(j)) return false;
+  assert(!"shared nodes are read-only; ajsb_cow them first");
+  return true;
+}
+
+ajsb_index_t *ajsb_index_init(aml_pool_t *p) {
+  if (!p) return NULL;
+  ajsb_index_t *ix = (ajsb_index_t *)aml_pool_zalloc(p, sizeof(*ix));
+  ix->p = p;
+  ix->mask = 63;
+  ix->slots = (slot_t *)aml_pool_zalloc(p, (ix->mask + 1) * sizeof(slot_t));
+  return ix;
+}
+
+void ajsb_index_prop(ajsb_index_t *ix, ajson_t *obj, const char *name, ajson_t *schema) {
+  if (!ix || !obj || !name || !*name || !schema || read_only(obj)) return;
+  set_member(ix, child(ix, obj, "properties", false), name, schema);
+}
+
+void ajsb_index_required_add(ajsb_index_t *ix, ajson_t *obj, const char *name) {
+  if (!ix || !obj || !name || !*name || read_only(obj)) return;
+  ajson_t *req = child(ix, obj, "required", true);
+  if (find(ix, req, name, key_hash(req, name))->container) return;
+  char *copy = aml_pool_strdup(ix->p, name);
+  ajsona_append(req, ajson_str(ix->p, copy));
+  put(ix, req, copy, NULL);
+  ajsb_touch(req);
+}
+
+void ajsb_index_prop_required(ajsb_index_t *ix, ajson_t *obj, const char *name, ajson_t *schema) {
+  if (!ix || !obj || !name || !*name || !schema) return;
+  ajsb_index_prop(ix, obj, name, schema);
+  ajsb_index_required_add(ix, obj, name);
+}
+
+void ajsb_index_defs_set(ajsb_index_t *ix, ajson_t *root_obj, const char *name, ajson_t *schema) {
+  if (!ix || !root_obj || !name || !*name || !schema || read_only(root_obj)) return;
+  set_member(ix, child(ix, root_obj, "$defs", false), name, schema);
+}
+
+ajson_t *ajsb_index_get_prop(ajsb_index_t *ix, ajson_t *obj, const char *name) {
+  if (!ix || !obj || !name) return NULL;
+  ajson_t *props = ajsono_scan(obj, "properties");
+  if (!props || !ajson_is_object(props)) return NULL;
+  adopt(ix, props);
+  slot_t *s = find(ix, props, name, key_hash(props, name));
+  return s->container ? ((ajsono_t *)s->member)->value : NULL;
+}
@@ -0,0 +1,482 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#include "a-json-schema-builder-library/ajsb_instrument.h"
+#include "ajsb_program.h"
+#include "a-memory-library/aml_alloc.h"
+#include "a-memory-library/aml_pool.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef AJSB_INSTRUMENT
+
+/* ── Profiles ───────────────────────────────────────────────────────────── */
+
+#define MAX_PROFILES 8
+
+typedef struct {
+  uint64_t hits;
+  uint64_t failures;
+  uint64_t ns;
+  uint64_t self_ns;
+  uint64_t backtracks;
+} counter_t;
+
+struct ajsb_profile_s {
+  const ajsb_program_t *prog;
+  aml_pool_t           *p;
+  const char          **paths;        /* by node id; NULL if unknown */
+  counter_t            *c;            /* by node id */
+};
+
+static ajsb_profile_t  *attached[MAX_PROFILES];
+static uint32_t         num_attached;
+static pthread_mutex_t  attach_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Time spent in finished children of the node running on this thread. */
+static _Thread_local uint64_t child_ns;
+
+static inline uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static inline void add(uint64_t *v, uint64_t n) {
+  __atomic_fetch_add(v, n, __ATOMIC_RELAXED);
+}
+
+static inline uint64_t get(const uint64_t *v) {
+  return __atomic_load_n(v, __ATOMIC_RELAXED);
+}
+
+ajsb_profile_t *ajsb_profile_of(const ajsb_program_t *prog) {
+  if (!__atomic_load_n(&num_attached, __ATOMIC_ACQUIRE)) return NULL;
+  for (int i = 0; i < MAX_PROFILES; i++) {
+    ajsb_profile_t *pr = __atomic_load_n(attached + i, __ATOMIC_ACQUIRE);
+    if (pr && pr->prog == prog) return pr;
+  }
+  return NULL;
+}
+
+ajsb_profile_frame_t ajsb_profile_enter(void) {
+  ajsb_profile_frame_t f = { now_ns(), child_ns };
+  child_ns = 0;
+  return f;
+}
+
+void ajsb_profile_leave(ajsb_profile_t *pr, uint32_t node, bool ok, ajsb_profile_frame_t f) {
+  uint64_t dt = now_ns() - f.start;
+  counter_t *c = pr->c + node;
+  add(&c->hits, 1);
+  if (!ok) add(&c->failures, 1);
+  add(&c->ns, dt);
+  add(&c->self_ns, dt > child_ns ? dt - child_ns : 0);
+  child_ns = f.outer + dt;
+}
+
+void ajsb_profile_backtracks(const ajsb_program_t *prog, uint32_t node, uint32_t n) {
+  if (!n) return;
+  ajsb_profile_t *pr = ajsb_profile_of(prog);
+  if (pr) add(&pr->c[node].backtracks, n);
+}
+
+/* ── Node paths ─────────────────────────────────────────────────────────── */
+
+typedef struct {
+  aml_pool_t    *p;
+  aml_buffer_t  *path;
+  const char   **paths;
+  ajson_t      **keys;                  /* schema → node id, open addressing */
+  uint32_t      *ids;
+  size_t         mask;
+} namer_t;
+
+static inline size_t ptr_hash(const void *v) {
+  uintptr_t x = (uintptr_t)v;
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  return (size_t)x;
+}
+
+static uint32_t node_of(const namer_t *n, ajson_t *s) {
+  for (size_t i = ptr_hash(s) & n->mask; n->keys[i]; i = (i + 1) & n->mask)
+    if (n->keys[i] == s) return n->ids[i];
+  return AJSB_NONE;
+}
+
+/* Keywords whose values are instance data, not schemas. */
+static bool is_data(const char *k) {
+  return !strcmp(k, "enum") || !strcmp(k, "const") ||
+         !strcmp(k, "default") || !strcmp(k, "examples");
+}
+
+static void path_key(aml_buffer_t *bh, const char *k) {
+  aml_buffer_appendc(bh, '/');
+  for (; *k; k++) {
+    if (*k == '~')      aml_buffer_appends(bh, "~0");
+    else if (*k == '/') aml_buffer_appends(bh, "~1");
+    else aml_buffer_appendc(bh, *k);
+  }
+}
+
+/* Depth first, so a node reached more than once keeps its first path. */
+static void name_nodes(namer_t *n, ajson_t *s) {
+  uint32_t id = node_of(n, s);
+  if (id != AJSB_NONE) {
+    if (n->paths[id]) return;
+    n->paths[id] = aml_pool_strdup(n->p, aml_buffer_data(n->path));
+  }
+  size_t len = aml_buffer_length(n->path);
+  if (ajson_is_object(s)) {
+    for (ajsono_t *m = ajsono_first(s); m; m = ajsono_next(m)) {
+      if (id != AJSB_NONE && is_data(m->key)) continue;
+      path_key(n->path, m->key);
+      name_nodes(n, m->value);
+      aml_buffer_shrink_by(n->path, aml_buffer_length(n->path) - len);
+    }
+  }
+  else if (ajson_is_array(s)) {
+    size_t i = 0;
+    for (ajsona_t *a = ajsona_first(s); a; a = ajsona_next(a), i++) {
+      aml_buffer_appendf(n->path, "/%zu", i);
+      name_nodes(n, a->value);
+      aml_buffer_shrink_by(n->path, aml_buffer_length(n->path) - len);
+    }
+  }
+}
+
+static bool name_all(ajsb_profile_t *pr, ajson_t *schema) {
+  ajson_t **nodes;
+  const ajsb_program_t *again = ajsb_compile_nodes(pr->p, schema, &nodes);
+  const ajsb_program_t *prog = pr->prog;
+  if (!again || again->num_ops != prog->num_ops || again->root != prog->root ||
+      again->num_entries != prog->num_entries)
+    return false;
+
+  namer_t n = { .p = pr->p, .paths = pr->paths };
+  size_t size = 16;
+  while (size < (size_t)prog->num_ops * 2) size <<= 1;
+  n.mask = size - 1;
+  n.keys = (ajson_t **)aml_pool_zalloc(pr->p, size * sizeof(ajson_t *));
+  n.ids  = (uint32_t *)aml_pool_alloc(pr->p, size * sizeof(uint32_t));
+  for (uint32_t id = 0; id < prog->num_ops; id++) {
+    if (!nodes[id]) continue;
+    size_t i = ptr_hash(nodes[id]) & n.mask;
+    while (n.keys[i] && n.keys[i] != nodes[id]) i = (i + 1) & n.mask;
+    if (n.keys[i]) continue;
+    n.keys[i] = nodes[id];
+    n.ids[i] = id;
+  }
+  n.path = aml_buffer_init(256);
+  aml_buffer_appendc(n.path, '#');
+  name_nodes(&n, schema);
+  aml_buffer_destroy(n.path);
+  return true;
+}
+
+/* ── Public API ─────────────────────────────────────────────────────────── */
+
+bool ajsb_instrumented(void) { return true; }
+
+ajsb_profile_t *ajsb_profile_init(const ajsb_program_t *prog, ajson_t *schema) {
+  if (!prog) return NULL;
+  aml_pool_t *p = aml_pool_init(4096);
+  ajsb_profile_t *pr = (ajsb_profile_t *)aml_pool_zalloc(p, sizeof(*pr));
+  pr->prog  = prog;
+  pr->p     = p;
+  pr->paths = (const char **)aml_pool_zalloc(p, (prog->num_ops + 1) * sizeof(char *));
+  pr->c     = (counter_t *)aml_calloc(prog->num_ops + 1, sizeof(counter_t));
+  if (schema && !name_all(pr, schema)) {
+    aml_free(pr->c);
+    aml_pool_destroy(p);
+    return NULL;
+  }
+
+  pthread_mutex_lock(&attach_lock);
+  int slot = -1;
+  for (int i = 0; i < MAX_PROFILES && slot < 0; i++)
+    if (!attached[i]) slot = i;
+  if (slot >= 0) {
+    __atomic_store_n(attached + slot, pr, __ATOMIC_RELEASE);
+    __atomic_add_fetch(&num_attached, 1, __ATOMIC_RELEASE);
+  }
+  pthread_mutex_unlock(&attach_lock);
+  if (slot < 0) {
+    aml_free(pr->c);
+    aml_pool_destroy(p);
+    return NULL;
+  }
+  return pr;
+}
+
+void ajsb_profile_destroy(ajsb_profile_t *pr) {
+  if (!pr) return;
+  pthread_mutex_lock(&attach_lock);
+  for (int i = 0; i < MAX_PROFILES; i++) {
+    if (attached[i] != pr) continue;
+    __atomic_store_n(attached + i, NULL, __ATOMIC_RELEASE);
+    __atomic_sub_fetch(&num_attached, 1, __ATOMIC_RELEASE);
+  }
+  pthread_mutex_unlock(&attach_lock);
+  aml_free(pr->c);
+  aml_pool_destroy(pr->p);
+}
+
+void ajsb_profile_reset(ajsb_profile_t *pr) {
+  if (!pr) return;
+  for (uint32_t i = 0; i < pr->prog->num_ops; i++) {
+    counter_t *c = pr->c + i;
+    __atomic_store_n(&c->hits, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&c->failures, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&c->ns, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&c->self_ns, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&c->backtracks, 0, __ATOMIC_RELAXED);
+  }
+}
+
+typedef struct {
+  uint32_t  node;
+  counter_t c;
+} row_t;
+
+static int by_self_ns(const void *a, const void *b) {
+  const row_t *x = (const row_t *)a, *y = (const row_t *)b;
+  if (x->c.self_ns != y->c.self_ns) return x->c.self_ns < y->c.self_ns ? 1 : -1;
+  return x->node < y->node ? -1 : x->node > y->node;
+}
+
+bool ajsb_profile_dump(aml_buffer_t *bh, const ajsb_profile_t *pr) {
+  if (!bh || !pr) return false;
+  const ajsb_program_t *prog = pr->prog;
+  row_t *rows = (row_t *)aml_malloc((prog->num_ops + 1) * sizeof(row_t));
+  size_t n = 0;
+  for (uint32_t i = 0; i < prog->num_ops; i++) {
+    const counter_t *c = pr->c + i;
+    row_t *r = rows + n;
+    r->node         = i;
+    r->c.hits       = get(&c->hits);
+    if (!r->c.hits) continue;
+    r->c.failures   = get(&c->failures);
+    r->c.ns         = get(&c->ns);
+    r->c.self_ns    = get(&c->self_ns);
+    r->c.backtracks = get(&c->backtracks);
+    n++;
+  }
+  qsort(rows, n, sizeof(row_t), by_self_ns);
+
+  aml_buffer_appendf(bh, "{\"validations\":%llu,\"nodes\":[",
+                     (unsigned long long)get(&pr->c[prog->root].hits));
+  for (size_t i = 0; i < n; i++) {
+    const row_t *r = rows + i;
+    if (i) aml_buffer_appendc(bh, ',');
+    aml_buffer_appendc(bh, '{');
+    if (pr->paths[r->node]) {
+      aml_buffer_appends(bh, "\"path\":\"");
+      aml_buffer_appends(bh, pr->paths[r->node]);
+      aml_buffer_appends(bh, "\",");
+    }
+    aml_buffer_appendf(bh, "\"node\":%u,\"hits\":%llu,\"failures\":%llu,\"ns\":%llu,"
+                       "\"self_ns\":%llu,\"backtracks\":%llu}",
+                       r->node, (unsigned long long)r->c.hits,
+                       (unsigned long long)r->c.failures, (unsigned long long)r->c.ns,
+                       (unsigned long long)r->c.self_ns, (unsigned long long)r->c.backtracks);
+  }
+  aml_buffer_appends(bh, "]}");
+  aml_free(rows);
+  return true;
+}
+
+/* ── Builder counters ───────────────────────────────────────────────────── */
+
+#define MAX_BUILDERS 64
+
+typedef struct {
+  const char *fn;                       /* __func__ of the builder */
+  uint64_t    calls;
+  uint64_t    nodes;
+  uint64_t    bytes;
+} build_stat_t;
+
+/* Each thread counts into its own table, so a builder call takes no lock and
+   shares no cache line; the dump merges the tables. A table outlives its
+   thread (the counts still matter) and is handed to the next thread that
+   starts building. Counters are atomics only so a dump or reset on another
+   thread reads and clears them cleanly; the owner never contends on them. */
+typedef struct build_table_s {
+  build_stat_t          s[MAX_BUILDERS];
+  size_t                n;              /* atomic; s[0..n) have fn set */
+  size_t                peak_pool;      /* atomic */
+  bool                  live;           /* owned by a thread; under tables_lock */
+  struct build_table_s *next;
+} build_table_t;
+
+static build_table_t  *tables;
+static pthread_mutex_t tables_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t  tables_once = PTHREAD_ONCE_INIT;
+static pthread_key_t   tables_key;
+
+static _Thread_local build_table_t *build_table;
+static _Thread_local uint32_t       build_depth;
+static _Thread_local uint64_t       build_nodes;
+
+static void table_release(void *v) {
+  pthread_mutex_lock(&tables_lock);
+  ((build_table_t *)v)->live = false;
+  pthread_mutex_unlock(&tables_lock);
+}
+
+static void tables_init(void) { pthread_key_create(&tables_key, table_release); }
+
+static build_table_t *table_acquire(void) {
+  pthread_once(&tables_once, tables_init);
+  pthread_mutex_lock(&tables_lock);
+  build_table_t *t = tables;
+  while (t && t->live) t = t->next;
+  if (!t) {
+    t = (build_table_t *)calloc(1, sizeof(*t));   /* never freed; see above */
+    if (t) {
+      t->next = tables;
+      tables = t;
+    }
+  }
+  if (t) t->live = true;
+  pthread_mutex_unlock(&tables_lock);
+  if (t) pthread_setspecific(tables_key, t);
+  return t;
+}
+
+ajsb_build_scope_t ajsb_build_enter(const char *fn, aml_pool_t *p) {
+  ajsb_build_scope_t s = { fn, p, 0, build_depth == 0 };
+  if (s.outer) {
+    build_nodes = 0;
+    s.size = p ? aml_pool_size(p) : 0;
+  }
+  build_depth++;
+  return s;
+}
+
+void ajsb_build_leave(ajsb_build_scope_t *s) {
+  build_depth--;
+  if (!s->outer) return;
+  build_table_t *t = build_table ? build_table : (build_table = table_acquire());
+  if (!t) return;
+  size_t size = s->p ? aml_pool_size(s->p) : 0;
+  size_t used = s->p ? aml_pool_used(s->p) : 0;
+  size_t n = __atomic_load_n(&t->n, __ATOMIC_RELAXED);   /* only this thread grows n */
+  build_stat_t *b = NULL;
+  for (size_t i = 0; i < n && !b; i++)
+    if (t->s[i].fn == s->fn || !strcmp(t->s[i].fn, s->fn)) b = t->s + i;
+  if (!b && n < MAX_BUILDERS) {
+    b = t->s + n;
+    b->fn = s->fn;
+    __atomic_store_n(&t->n, n + 1, __ATOMIC_RELEASE);
+  }
+  if (b) {
+    add(&b->calls, 1);
+    add(&b->nodes, build_nodes);
+    add(&b->bytes, size > s->size ? size - s->size : 0);   /* 0 if the pool was cleared */
+  }
+  if (used > __atomic_load_n(&t->peak_pool, __ATOMIC_RELAXED))
+    __atomic_store_n(&t->peak_pool, used, __ATOMIC_RELAXED);
+}
+
+ajson_t *ajsb_build_node(ajson_t *j) {
+  if (build_depth) build_nodes++;
+  return j;
+}
+
+static int by_bytes(const void *a, const void *b) {
+  const build_stat_t *x = (const build_stat_t *)a, *y = (const build_stat_t *)b;
+  if (x->bytes != y->bytes) return x->bytes < y->bytes ? 1 : -1;
+  return strcmp(x->fn, y->fn);
+}
+
+bool ajsb_build_stats_dump(aml_buffer_t *bh) {
+  if (!bh) return false;
+  build_stat_t merged[MAX_BUILDERS];
+  size_t n = 0, peak = 0;
+  pthread_mutex_lock(&tables_lock);
+  for (build_table_t *t = tables; t; t = t->next) {
+    size_t tp = __atomic_load_n(&t->peak_pool, __ATOMIC_RELAXED);
+    if (tp > peak) peak = tp;
+    size_t tn = __atomic_load_n(&t->n, __ATOMIC_ACQUIRE);
+    for (size_t i = 0; i < tn; i++) {
+      const build_stat_t *src = t->s + i;
+      uint64_t calls = get(&src->calls);
+      if (!calls) continue;             /* reset since */
+      build_stat_t *b = NULL;
+      for (size_t k = 0; k < n && !b; k++)
+        if (merged[k].fn == src->fn || !strcmp(merged[k].fn, src->fn)) b = merged + k;
+      if (!b) {
+        if (n == MAX_BUILDERS) continue;
+        b = merged + n++;
+        *b = (build_stat_t){ src->fn, 0, 0, 0 };
+      }
+      b->calls += calls;
+      b->nodes += get(&src->nodes);
+      b->bytes += get(&src->bytes);
+    }
+  }
+  pthread_mutex_unlock(&tables_lock);
+  qsort(merged, n, sizeof(build_stat_t), by_bytes);
+
+  aml_buffer_appendf(bh, "{\"peak_pool\":%zu,\"calls\":[", peak);
+  for (size_t i = 0; i < n; i++)
+    aml_buffer_appendf(bh, "%s{\"fn\":\"%s\",\"calls\":%llu,\"nodes\":%llu,\"bytes\":%llu}",
+                       i ? "," : "", merged[i].fn, (unsigned long long)merged[i].calls,
+                       (unsigned long long)merged[i].nodes, (unsigned long long)merged[i].bytes);
+  aml_buffer_appends(bh, "]}");
+  return true;
+}
+
+/* Builder calls finishing on other threads meanwhile may survive the reset. */
+void ajsb_build_stats_reset(void) {
+  pthread_mutex_lock(&tables_lock);
+  for (build_table_t *t = tables; t; t = t->next) {
+    size_t tn = __atomic_load_n(&t->n, __ATOMIC_ACQUIRE);
+    for (size_t i = 0; i < tn; i++) {
+      __atomic_store_n(&t->s[i].calls, 0, __ATOMIC_RELAXED);
+      __atomic_store_n(&t->s[i].nodes, 0, __ATOMIC_RELAXED);
+      __atomic_store_n(&t->s[i].bytes, 0, __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&t->peak_pool, 0, __ATOMIC_RELAXED);
+  }
+  pthread_mutex_unlock(&tables_lock);
+}
+
+#else  /* !AJSB_INSTRUMENT: the API links, nothing is counted */
+
+bool ajsb_instrumented(void) { return false; }
+
+ajsb_profile_t *ajsb_profile_init(const ajsb_program_t *prog, ajson_t *schema) {
+  (void)prog;
+  (void)schema;
+  return NULL;
+}
+
+void ajsb_profile_destroy(ajsb_profile_t *pr) { (void)pr; }
+void ajsb_profile_reset(ajsb_profile_t *pr) { (void)pr; }
+
+bool ajsb_profile_dump(aml_buffer_t *bh, const ajsb_profile_t *pr) {
+  (void)bh;
+  (void)pr;
+  return false;
+}
+
+bool ajsb_build_stats_dump(aml_buffer_t *bh) {
+  (void)bh;
+  return false;
+}
+
+void ajsb_build_stats_reset(void) {}
+
+#endif
@@ -0,0 +1,570 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#include "a-json-schema-builder-library/ajsb_intern.h"
+#include "a-json-schema-builder-library/ajsb.h"
+#include "a-json-schema-builder-library/ajsb_cache.h"
+#include "a-json-schema-builder-library/ajsb_link.h"
+#include "a-memory-library/aml_alloc.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ── Hashing ────────────────────────────────────────────────────────────── */
+
+#define FNV_OFFSET 1469598103934665603ULL
+#define FNV_PRIME  1099511628211ULL
+
+static inline uint64_t fnv_bytes(uint64_t h, const void *d, size_t len) {
+  const unsigned char *s = (const unsigned char *)d;
+  for (size_t i = 0; i < len; i++) {
+    h ^= s[i];
+    h *= FNV_PRIME;
+  }
+  return h;
+}
+
+static inline uint64_t fnv_str(uint64_t h, const char *s) {
+  return fnv_bytes(h, s, strlen(s) + 1);
+}
+
+static inline uint64_t fnv_u64(uint64_t h, uint64_t v) {
+  return fnv_bytes(h, &v, sizeof(v));
+}
+
+static char kind_of(ajson_t *j) {
+  if (ajson_is_object(j))  return 'o';
+  if (ajson_is_array(j))   return 'a';
+  if (ajson_is_string(j))  return 's';
+  if (ajson_is_number(j) || ajson_is_decimal(j)) return 'n';
+  if (ajson_is_true(j))    return 't';
+  if (ajson_is_false(j))   return 'f';
+  return 'z';
+}
+
+/* Hash of a scalar, or of a container given its children's hashes. */
+static uint64_t hash_node(ajson_t *j, uint64_t (*child)(void *, ajson_t *), void *arg) {
+  char k = kind_of(j);
+  uint64_t h = fnv_bytes(FNV_OFFSET, &k, 1);
+  if (k == 'o') {
+    for (ajsono_t *m = ajsono_first(j); m; m = ajsono_next(m)) {
+      h = fnv_str(h, m->key);
+      h = fnv_u64(h, child(arg, m->value));
+    }
+  } else if (k == 'a') {
+    for (ajsona_t *a = ajsona_first(j); a; a = ajsona_next(a))
+      h = fnv_u64(h, child(arg, a->value));
+  } else if (k == 's' || k == 'n') {
+    h = fnv_str(h, ajson_to_str(j, ""));
+  }
+  return h;
+}
+
+static uint64_t plain_child(void *arg, ajson_t *j) {
+  (void)arg;
+  return ajsb_schema_hash(j);
+}
+
+uint64_t ajsb_schema_hash(ajson_t *schema) {
+  if (!schema) return 0;
+  return hash_node(schema, plain_child, NULL);
+}
+
+static bool scalar_equal(ajson_t *a, ajson_t *b) {
+  char k = kind_of(a);
+  if (k != kind_of(b)) return false;
+  if (k == 's' || k == 'n') return !strcmp(ajson_to_str(a, ""), ajson_to_str(b, ""));
+  return true;
+}
+
+bool ajsb_schema_equal(ajson_t *a, ajson_t *b) {
+  if (a == b) return true;
+  if (!a || !b || !scalar_equal(a, b)) return false;
+  if (ajson_is_object(a)) {
+    ajsono_t *x = ajsono_first(a), *y = ajsono_first(b);
+    for (; x && y; x = ajsono_next(x), y = ajsono_next(y))
+      if (strcmp(x->key, y->key) || !ajsb_schema_equal(x->value, y->value)) return false;
+    return !x && !y;
+  }
+  if (ajson_is_array(a)) {
+    ajsona_t *x = ajsona_first(a), *y = ajsona_first(b);
+    for (; x && y; x = ajsona_next(x), y = ajsona_next(y))
+      if (!ajsb_schema_equal(x->value, y->value)) return false;
+    return !x && !y;
+  }
+  return true;
+}
+
+/* ── Node memo (pointer → facts about the subtree) ──────────────────────── */
+
+typedef struct {
+  ajson_t  *node;
+  uint64_t  hash;
+  uint32_t  size;           /* compact JSON length */
+  uint8_t   canon;          /* node is the canonical copy (intern) */
+  uint8_t   pinned;         /* subtree carries $id/$anchor/$dynamicAnchor */
+  uint8_t   targeted;       /* node or a descendant is a $ref target (hoist) */
+} memo_t;
+
+typedef struct {
+  memo_t *slots;
+  size_t  mask, count;
+} memo_map_t;
+
+static inline size_t ptr_hash(const void *v) {
+  uintptr_t x = (uintptr_t)v;
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  return (size_t)x;
+}
+
+static memo_t *memo_find(memo_map_t *m, ajson_t *j) {
+  if (!m->slots) return NULL;
+  for (size_t i = ptr_hash(j) & m->mask;; i = (i + 1) & m->mask) {
+    if (!m->slots[i].node) return NULL;
+    if (m->slots[i].node == j) return m->slots + i;
+  }
+}
+
+static memo_t *memo_add(memo_map_t *m, ajson_t *j) {
+  if (!m->slots || (m->count + 1) * 2 > m->mask + 1) {
+    size_t size = m->slots ? (m->mask + 1) * 2 : 256;
+    memo_t *n = (memo_t *)aml_calloc(size, sizeof(memo_t));
+    if (!n) return NULL;
+    for (size_t i = 0; m->slots && i <= m->mask; i++) {
+      if (!m->slots[i].node) continue;
+      size_t k = ptr_hash(m->slots[i].node) & (size - 1);
+      while (n[k].node) k = (k + 1) & (size - 1);
+      n[k] = m->slots[i];
+    }
+    aml_free(m->slots);
+    m->slots = n;
+    m->mask = size - 1;
+  }
+  size_t i = ptr_hash(j) & m->mask;
+  while (m->slots[i].node) i = (i + 1) & m->mask;
+  memset(m->slots + i, 0, sizeof(memo_t));
+  m->slots[i].node = j;
+  m->count++;
+  return m->slots + i;
+}
+
+static void memo_clear(memo_map_t *m) {
+  if (m->slots) memset(m->slots, 0, (m->mask + 1) * sizeof(memo_t));
+  m->count = 0;
+}
+
+/* ── Interning ──────────────────────────────────────────────────────────── */
+
+struct ajsb_intern_s {
+  memo_map_t  memo;
+  ajson_t   **tab;            /* canonical nodes, by hash */
+  size_t      mask, count;
+  size_t      shared;
+};
+
+ajsb_intern_t *ajsb_intern_init(void) {
+  ajsb_intern_t *in = (ajsb_intern_t *)aml_calloc(1, sizeof(*in));
+  if (!in) return NULL;
+  in->mask = 255;
+  in->tab = (ajson_t **)aml_calloc(in->mask + 1, sizeof(ajson_t *));
+  /* shared leaves are canonical, so equal pool nodes collapse onto them */
+  ajson_t *seed[] = { ajsb_shared_true(), ajsb_shared_false(), ajsb_shared_string(),
+                      ajsb_shared_number(), ajsb_shared_integer(), ajsb_shared_boolean(),
+                      ajsb_shared_null() };
+  for (size_t i = 0; i < sizeof(seed) / sizeof(seed[0]); i++) ajsb_intern(in, seed[i]);
+  return in;
+}
+
+void ajsb_intern_destroy(ajsb_intern_t *in) {
+  if (!in) return;
+  aml_free(in->memo.slots);
+  aml_free(in->tab);
+  aml_free(in);
+}
+
+static uint64_t memo_hash(void *arg, ajson_t *j) {
+  memo_t *m = memo_find((memo_map_t *)arg, j);
+  return m ? m->hash : ajsb_schema_hash(j);
+}
+
+/* Children are canonical, so equal subtrees are already the same pointer. */
+static bool shallow_equal(ajson_t *a, ajson_t *b) {
+  if (!scalar_equal(a, b)) return false;
+  if (ajson_is_object(a)) {
+    ajsono_t *x = ajsono_first(a), *y = ajsono_first(b);
+    for (; x && y; x = ajsono_next(x), y = ajsono_next(y))
+      if (x->value != y->value || strcmp(x->key, y->key)) return false;
+    return !x && !y;
+  }
+  if (ajson_is_array(a)) {
+    ajsona_t *x = ajsona_first(a), *y = ajsona_first(b);
+    for (; x && y; x = ajsona_next(x), y = ajsona_next(y))
+      if (x->value != y->value) return false;
+    return !x && !y;
+  }
+  return true;
+}
+
+static void intern_grow(ajsb_intern_t *in) {
+  size_t size = (in->mask + 1) * 2;
+  ajson_t **t = (ajson_t **)aml_calloc(size, sizeof(ajson_t *));
+  if (!t) return;
+  for (size_t i = 0; i <= in->mask; i++) {
+    if (!in->tab[i]) continue;
+    size_t k = memo_hash(&in->memo, in->tab[i]) & (size - 1);
+    while (t[k]) k = (k + 1) & (size - 1);
+    t[k] = in->tab[i];
+  }
+  aml_free(in->tab);
+  in->tab = t;
+  in->mask = size - 1;
+}
+
+ajson_t *ajsb_intern(ajsb_intern_t *in, ajson_t *schema) {
+  if (!in || !schema || !in->tab) return schema;
+  memo_t *m = memo_find(&in->memo, schema);
+  if (m && m->canon) return schema;
+
+  /* only write when the child changes: shared nodes must stay untouched */
+  if (ajson_is_object(schema)) {
+    for (ajsono_t *o = ajsono_first(schema); o; o = ajsono_next(o)) {
+      ajson_t *c = ajsb_intern(in, o->value);
+      if (c != o->value && !ajsb_is_shared(schema)) {
+        o->value = c;
+        ajsb_touch(schema);
+      }
+    }
+  } else if (ajson_is_array(schema)) {
+    for (ajsona_t *a = ajsona_first(schema); a; a = ajsona_next(a)) {
+      ajson_t *c = ajsb_intern(in, a->value);
+      if (c != a->value) {
+        a->value = c;
+        ajsb_touch(schema);
+      }
+    }
+  }
+
+  uint64_t h = hash_node(schema, memo_hash, &in->memo);
+  size_t i = h & in->mask;
+  for (; in->tab[i]; i = (i + 1) & in->mask) {
+    ajson_t *c = in->tab[i];
+    if (memo_hash(&in->memo, c) == h && shallow_equal(c, schema)) {
+      in->shared++;
+      return c;
+    }
+  }
+  m = memo_find(&in->memo, schema);
+  if (!m) m = memo_add(&in->memo, schema);
+  if (!m) return schema;
+  m->hash = h;
+  m->canon = 1;
+  in->tab[i] = schema;
+  if (++in->count * 2 > in->mask + 1) intern_grow(in);
+  return schema;
+}
+
+size_t ajsb_intern_count(const ajsb_intern_t *in) {
+  return in ? in->count : 0;
+}
+
+size_t ajsb_intern_shared(const ajsb_intern_t *in) {
+  return in ? in->shared : 0;
+}
+
+/* ── $defs extraction ───────────────────────────────────────────────────── */
+
+/* Where subschemas live. Everything else (enum, const, required, ...) is data. */
+static const char *const schema_maps[]   = { "properties", "patternProperties", "$defs",
+                                             "definitions", "dependentSchemas", NULL };
+static const char *const schema_single[] = { "items", "additionalProperties", "additionalItems",
+                                             "not", "if", "then", "else", "contains",
+                                             "propertyNames", "unevaluatedItems",
+                                             "unevaluatedProperties", NULL };
+static const char *const schema_lists[]  = { "anyOf", "allOf", "oneOf", "prefixItems", "items", NULL };
+
+static bool in_list(const char *const *list, const char *k) {
+  for (; *list; list++)
+    if (!strcmp(*list, k)) return true;
+  return false;
+}
+
+typedef struct {
+  uint64_t     hash;
+  ajson_t     *repr;
+  const char  *hint;
+  const char  *def_name;    /* equal to an existing root $defs entry */
+  size_t       count;
+  uint32_t     size;
+} group_t;
+
+typedef struct {
+  aml_pool_t  *p;
+  ajson_t     *root;
+  size_t       min_uses;
+  memo_map_t   memo;
+  memo_map_t   targets;     /* nodes an existing reference resolves to */
+  group_t     *groups;
+  size_t       gmask, gcount;
+
+  bool         replacing;
+  ajson_t     *target;      /* replace subschemas equal to this ... */
+  uint64_t     target_hash;
+  const char  *ref;         /* ... with {"$ref": ref} */
+  size_t       replaced;
+} hoist_t;
+
+static uint32_t num_len(const char *s) { return (uint32_t)strlen(s); }
+
+static memo_t *facts(hoist_t *h, ajson_t *j);
+
+static uint64_t facts_hash(void *arg, ajson_t *j) {
+  memo_t *m = facts((hoist_t *)arg, j);
+  return m ? m->hash : 0;
+}
+
+/* Hash, serialized size and pinning of a subtree, memoized per round. */
+static memo_t *facts(hoist_t *h, ajson_t *j) {
+  memo_t *m = memo_find(&h->memo, j);
+  if (m) return m;
+
+  uint32_t size = 0;
+  uint8_t pinned = 0, targeted = memo_find(&h->targets, j) != NULL;
+  switch (kind_of(j)) {
+  case 'o': {
+    size = 2;
+    size_t n = 0;
+    for (ajsono_t *o = ajsono_first(j); o; o = ajsono_next(o), n++) {
+      memo_t *c = facts(h, o->value);
+      size += num_len(o->key) + 3 + (c ? c->size : 0) + (n ? 1 : 0);
+      pinned |= c ? c->pinned : 0;
+      targeted |= c ? c->targeted : 0;
+      if (!strcmp(o->key, "$id") || !strcmp(o->key, "$anchor") || !strcmp(o->key, "$dynamicAnchor"))
+        pinned = 1;
+    }
+    break;
+  }
+  case 'a': {
+    size = 2;
+    size_t n = 0;
+    for (ajsona_t *a = ajsona_first(j); a; a = ajsona_next(a), n++) {
+      memo_t *c = facts(h, a->value);
+      size += (c ? c->size : 0) + (n ? 1 : 0);
+      pinned |= c ? c->pinned : 0;
+      targeted |= c ? c->targeted : 0;
+    }
+    break;
+  }
+  case 's': size = num_len(ajson_to_str(j, "")) + 2; break;
+  case 'n': size = num_len(ajson_to_str(j, "")); break;
+  case 'f': size = 5; break;
+  default:  size = 4; break;
+  }
+  uint64_t hash = hash_node(j, facts_hash, h);
+  m = memo_add(&h->memo, j);
+  if (!m) return NULL;
+  m->hash = hash;
+  m->size = size;
+  m->pinned = pinned;
+  m->targeted = targeted;
+  return m;
+}
+
+static group_t *group_for(hoist_t *h, ajson_t *j, uint64_t hash) {
+  if (!h->groups || (h->gcount + 1) * 2 > h->gmask + 1) {
+    size_t size = h->groups ? (h->gmask + 1) * 2 : 256;
+    group_t *n = (group_t *)aml_calloc(size, sizeof(group_t));
+    if (!n) return NULL;
+    for (size_t i = 0; h->groups && i <= h->gmask; i++) {
+      if (!h->groups[i].repr) continue;
+      size_t k = h->groups[i].hash & (size - 1);
+      while (n[k].repr) k = (k + 1) & (size - 1);
+      n[k] = h->groups[i];
+    }
+    aml_free(h->groups);
+    h->groups = n;
+    h->gmask = size - 1;
+  }
+  size_t i = hash & h->gmask;
+  for (; h->groups[i].repr; i = (i + 1) & h->gmask)
+    if (h->groups[i].hash == hash && ajsb_schema_equal(h->groups[i].repr, j)) return h->groups + i;
+  h->groups[i].hash = hash;
+  h->groups[i].repr = j;
+  h->gcount++;
+  return h->groups + i;
+}
+
+static bool is_plain_ref(ajson_t *j) {
+  ajsono_t *o = ajsono_first(j);
+  return o && !ajsono_next(o) && (!strcmp(o->key, "$ref") || !strcmp(o->key, "$dynamicRef"));
+}
+
+static void walk(hoist_t *h, ajson_t *schema, const char *hint);
+
+/* A subschema position (a member of holder). is_def marks direct children of
+   root.$defs. Targets of existing references and their ancestors are neither
+   moved nor counted, though an existing definition can still be reused. */
+static void visit(hoist_t *h, ajson_t *holder, ajson_t **slot, const char *hint,
+                  const char *def_name) {
+  ajson_t *j = *slot;
+  if (!j || !ajson_is_object(j)) return;
+
+  memo_t *m = facts(h, j);
+  if (!m) return;
+  if (h->replacing) {
+    if (!def_name && !m->targeted && m->hash == h->target_hash && ajsb_schema_equal(j, h->target)) {
+      *slot = ajsb_ref(h->p, h->ref);
+      ajsb_touch(holder);
+      h->replaced++;
+      return;
+    }
+  } else if (!m->pinned && !is_plain_ref(j) && (def_name || !m->targeted)) {
+    group_t *g = group_for(h, j, m->hash);
+    if (g) {
+      g->size = m->size;
+      if (def_name) g->def_name = def_name;
+      else {
+        g->count++;
+        if (!g->hint) g->hint = hint;
+      }
+    }
+  }
+  walk(h, j, hint);
+}
+
+static void walk(hoist_t *h, ajson_t *schema, const char *hint) {
+  for (ajsono_t *o = ajsono_first(schema); o; o = ajsono_next(o)) {
+    ajson_t *v = o->value;
+    if (ajson_is_object(v) && in_list(schema_maps, o->key)) {
+      bool defs = schema == h->root && !strcmp(o->key, "$defs");
+      for (ajsono_t *c = ajsono_first(v); c; c = ajsono_next(c))
+        visit(h, v, &c->value, c->key, defs ? c->key : NULL);
+    } else if (ajson_is_array(v) && in_list(schema_lists, o->key)) {
+      for (ajsona_t *a = ajsona_first(v); a; a = ajsona_next(a))
+        visit(h, v, &a->value, hint, NULL);
+    } else if (in_list(schema_single, o->key)) {
+      visit(h, schema, &o->value, hint, NULL);
+    }
+  }
+}
+
+/* Every node a "$ref" or "$dynamicRef" in the tree resolves to. */
+static void add_targets(hoist_t *h, const ajsb_link_t *l, memo_map_t *seen, ajson_t *j) {
+  if (!ajson_is_object(j) && !ajson_is_array(j)) return;
+  if (memo_find(seen, j) || !memo_add(seen, j)) return;
+  if (ajson_is_object(j)) {
+    ajson_t *t = ajsb_link_ref(l, j);
+    if (t && !memo_find(&h->targets, t)) memo_add(&h->targets, t);
+    t = ajsb_link_dynamic_ref(l, j);
+    if (t && !memo_find(&h->targets, t)) memo_add(&h->targets, t);
+    for (ajsono_t *o = ajsono_first(j); o; o = ajsono_next(o)) add_targets(h, l, seen, o->value);
+  } else {
+    for (ajsona_t *a = ajsona_first(j); a; a = ajsona_next(a)) add_targets(h, l, seen, a->value);
+  }
+}
+
+/* "#/$defs/<name>" with name as a JSON Pointer token (~0, ~1) in a URI
+   fragment (%25), written as JSON string text. */
+static const char *def_ref(aml_pool_t *p, const char *name) {
+  char *plain = strchr(name, '\\') ? ajson_decode(p, (char *)name, strlen(name)) : (char *)name;
+  char *out = (char *)aml_pool_alloc(p, 8 + 3 * strlen(plain) + 1), *w = out;
+  memcpy(w, "#/$defs/", 8);
+  w += 8;
+  for (const char *c = plain; *c; c++) {
+    if (*c == '~')      { memcpy(w, "~0", 2); w += 2; }
+    else if (*c == '/') { memcpy(w, "~1", 2); w += 2; }
+    else if (*c == '%') { memcpy(w, "%25", 3); w += 3; }
+    else *w++ = *c;
+  }
+  *w = 0;
+  return ajson_encode(p, out, (size_t)(w - out));
+}
+
+static void def_name(hoist_t *h, const char *hint, char *out, size_t cap) {
+  size_t n = 0;
+  for (const char *s = hint ? hint : ""; *s && n + 8 < cap; s++) {
+    char c = *s;
+    bool ok = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+              c == '_' || c == '-';
+    out[n++] = ok ? c : '_';
+  }
+  if (!n) { memcpy(out, "def", 3); n = 3; }
+  out[n] = 0;
+  ajson_t *defs = ajsono_scan(h->root, "$defs");
+  if (!defs || !ajson_is_object(defs) || !ajsono_scan(defs, out)) return;
+  for (int i = 2;; i++) {
+    snprintf(out + n, cap - n, "_%d", i);
+    if (!ajsono_scan(defs, out)) return;
+  }
+}
+
+/* {"$ref":"#/$defs/"} plus the name */
+#define REF_COST(name_len) (19 + (long)(name_len))
+
+static group_t *best_group(hoist_t *h) {
+  group_t *best = NULL;
+  long best_saving = 0;
+  for (size_t i = 0; h->groups && i <= h->gmask; i++) {
+    group_t *g = h->groups + i;
+    if (!g->repr || !g->count) continue;
+    long saving;
+    if (g->def_name)
+      saving = (long)g->count * ((long)g->size - REF_COST(strlen(g->def_name)));
+    else {
+      if (g->count < h->min_uses) continue;
+      long name = (long)(g->hint ? strlen(g->hint) : 3) + 2;
+      saving = (long)g->count * ((long)g->size - REF_COST(name)) - ((long)g->size + name + 4);
+    }
+    if (saving > best_saving) { best = g; best_saving = saving; }
+  }
+  return best;
+}
+
+size_t ajsb_hoist_defs(aml_pool_t *p, ajson_t *root, size_t min_uses) {
+  if (!p || !root || !ajson_is_object(root)) return 0;
+  hoist_t h;
+  memset(&h, 0, sizeof(h));
+  h.p = p;
+  h.root = root;
+  h.min_uses = min_uses < 2 ? 2 : min_uses;
+
+  /* new references only ever point into $defs, which is never moved */
+  memo_map_t seen = {0};
+  add_targets(&h, ajsb_link(p, root), &seen, root);
+  aml_free(seen.slots);
+
+  for (;;) {
+    memo_clear(&h.memo);
+    if (h.groups) memset(h.groups, 0, (h.gmask + 1) * sizeof(group_t));
+    h.gcount = 0;
+    h.replacing = false;
+    walk(&h, root, NULL);
+
+    group_t *g = best_group(&h);
+    if (!g) break;
+
+    if (g->def_name) h.ref = def_ref(p, g->def_name);
+    else {
+      char name[128];
+      def_name(&h, g->hint, name, sizeof(name));
+      ajsb_defs_set(p, root, name, g->repr);
+      h.ref = def_ref(p, name);        /* in p: ajson_str may keep the pointer */
+    }
+
+    h.replacing = true;
+    h.target = g->repr;
+    h.target_hash = g->hash;
+    size_t before = h.replaced;
+    walk(&h, root, NULL);
+    if (h.replaced == before) break;          /* nothing moved; avoid spinning */
+  }
+  aml_free(h.memo.slots);
+  aml_free(h.targets.slots);
+  aml_free(h.groups);
+  return h.replaced;
+}
@@ -0,0 +1,492 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#include "a-json-schema-builder-library/ajsb_link.h"
+#include "ajsb_program.h"
+#include "a-memory-library/aml_buffer.h"
+
+#include <ctype.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct res_s {
+  const char   *uri;        /* absolute, no fragment; "" if the document has no $id */
+  ajson_t      *node;
+  struct res_s *parent;     /* enclosing resource */
+} res_t;
+
+typedef struct {
+  ajson_t    *holder;
+  const char *text;
+  const char *path;
+  res_t      *res;
+  ajson_t    *initial;      /* what the reference names */
+  ajson_t    *target;       /* initial, or the outermost dynamic anchor in scope */
+  const char *anchor;       /* $dynamicRef whose initial target has a matching $dynamicAnchor */
+  bool        dynamic, cyclic;
+} ref_t;
+
+/* One table for everything, told apart by kind. */
+enum { K_EMPTY, K_RESOURCE, K_ANCHOR, K_REF, K_DYNAMIC_REF, K_COLOR };
+enum { A_DYNAMIC = 1 };
+enum { WHITE, GRAY, BLACK };
+
+typedef struct {
+  const void *key;          /* node (NULL for resources) */
+  const char *name;         /* uri or anchor name, NULL otherwise */
+  void       *value;
+  uint32_t    hash;
+  uint8_t     kind, flags;
+} slot_t;
+
+typedef struct {
+  ajsb_link_issue_t *v;
+  size_t             n, cap;
+} issues_t;
+
+struct ajsb_link_s {
+  aml_pool_t *p;
+  res_t      *doc;
+  slot_t     *slots;  size_t mask, count;
+  ref_t      *refs;   size_t num_refs, cap_refs;
+  issues_t    unresolved, cycles;
+};
+
+/* ── Table ──────────────────────────────────────────────────────────────── */
+
+static inline size_t ptr_hash(const void *v) {
+  uintptr_t x = (uintptr_t)v;
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  return (size_t)x;
+}
+
+static uint32_t slot_hash(int kind, const void *key, const char *name) {
+  uint32_t h = (uint32_t)ptr_hash(key) ^ ((uint32_t)kind * 0x9e3779b9u);
+  return name ? h ^ ajsb_hash32(name, strlen(name)) : h;
+}
+
+/* The slot for (kind, key, name): the existing one or the empty one it would
+   go in. */
+static slot_t *slot_find(const ajsb_link_t *l, int kind, const void *key, const char *name,
+                         uint32_t h) {
+  for (size_t i = h & l->mask;; i = (i + 1) & l->mask) {
+    slot_t *s = l->slots + i;
+    if (s->kind == K_EMPTY) return s;
+    if (s->hash == h && s->kind == kind && s->key == key &&
+        (s->name == name || (s->name && name && !strcmp(s->name, name))))
+      return s;
+  }
+}
+
+static slot_t *slot_get(const ajsb_link_t *l, int kind, const void *key, const char *name) {
+  slot_t *s = slot_find(l, kind, key, name, slot_hash(kind, key, name));
+  return s->kind == K_EMPTY ? NULL : s;
+}
+
+/* Existing or new slot; a new one has value NULL and flags 0. */
+static slot_t *slot_put(ajsb_link_t *l, int kind, const void *key, const char *name) {
+  if ((l->count + 1) * 2 > l->mask + 1) {
+    slot_t *old = l->slots;
+    size_t old_mask = l->mask;
+    l->mask = old_mask * 2 + 1;
+    l->slots = (slot_t *)aml_pool_zalloc(l->p, (l->mask + 1) * sizeof(slot_t));
+    for (size_t i = 0; i <= old_mask; i++) {
+      if (old[i].kind == K_EMPTY) continue;
+      size_t j = old[i].hash & l->mask;
+      while (l->slots[j].kind != K_EMPTY) j = (j + 1) & l->mask;
+      l->slots[j] = old[i];
+    }
+  }
+  uint32_t h = slot_hash(kind, key, name);
+  slot_t *s = slot_find(l, kind, key, name, h);
+  if (s->kind == K_EMPTY) {
+    s->hash = h;
+    s->kind = (uint8_t)kind;
+    s->key = key;
+    s->name = name;
+    l->count++;
+  }
+  return s;
+}
+
+static void *pool_grow(aml_pool_t *p, void *arr, size_t n, size_t *cap, size_t elem) {
+  if (n < *cap) return arr;
+  *cap = *cap ? *cap * 2 : 16;
+  void *r = aml_pool_alloc(p, *cap * elem);
+  if (n) memcpy(r, arr, n * elem);
+  return r;
+}
+
+static void add_issue(aml_pool_t *p, issues_t *is, const ref_t *r) {
+  is->v = (ajsb_link_issue_t *)pool_grow(p, is->v, is->n, &is->cap, sizeof(*is->v));
+  is->v[is->n].path = r->path;
+  is->v[is->n].ref = r->text;
+  is->n++;
+}
+
+/* ── URIs (RFC 3986 reference resolution, enough for $id / $ref) ────────── */
+
+static size_t scheme_len(const char *s, size_t n) {
+  if (!n || !isalpha((unsigned char)s[0])) return 0;
+  for (size_t i = 1; i < n; i++) {
+    if (s[i] == ':') return i + 1;
+    if (!isalnum((unsigned char)s[i]) && s[i] != '+' && s[i] != '-' && s[i] != '.') return 0;
+  }
+  return 0;
+}
+
+/* Length of "scheme://authority". */
+static size_t authority_len(const char *s) {
+  size_t i = scheme_len(s, strlen(s));
+  if (s[i] == '/' && s[i + 1] == '/') {
+    i += 2;
+    while (s[i] && s[i] != '/') i++;
+  }
+  return i;
+}
+
+/* Drop "." and ".." segments in place. */
+static void remove_dots(char *path) {
+  char *w = path, *start;
+  const char *r = path;
+  if (*r == '/') { w++; r++; }
+  start = w;
+  while (*r) {
+    const char *e = strchr(r, '/');
+    size_t n = e ? (size_t)(e - r) : strlen(r);
+    if (n == 2 && r[0] == '.' && r[1] == '.') {
+      if (w > start) {
+        w--;
+        while (w > start && w[-1] != '/') w--;
+      }
+    } else if (!(n == 1 && r[0] == '.')) {
+      memmove(w, r, n);
+      w += n;
+      if (e) *w++ = '/';
+    }
+    r += n;
+    if (*r == '/') r++;
+  }
+  *w = '\0';
+}
+
+/* ref (n bytes, no fragment) resolved against base. */
+static const char *uri_resolve(aml_pool_t *p, const char *base, const char *ref, size_t n) {
+  size_t blen = strlen(base), keep;
+  bool slash = false;
+  if (!n) return base;
+  if (scheme_len(ref, n)) keep = 0;
+  else if (n >= 2 && ref[0] == '/' && ref[1] == '/') keep = scheme_len(base, blen);
+  else if (ref[0] == '/') keep = authority_len(base);
+  else {
+    size_t a = authority_len(base);
+    const char *last = strrchr(base + a, '/');
+    keep = last ? (size_t)(last - base) + 1 : a;
+    slash = !last && a > scheme_len(base, blen);    /* "https://host" + "x" */
+  }
+  char *out = (char *)aml_pool_alloc(p, keep + slash + n + 1);
+  memcpy(out, base, keep);
+  if (slash) out[keep++] = '/';
+  memcpy(out + keep, ref, n);
+  out[keep + n] = '\0';
+  remove_dots(out + authority_len(out));
+  return out;
+}
+
+static int hex(int c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+/* URI fragments are percent-encoded. */
+static char *fragment_decode(aml_pool_t *p, const char *s) {
+  char *out = (char *)aml_pool_alloc(p, strlen(s) + 1), *w = out;
+  for (; *s; s++) {
+    int hi, lo;
+    if (*s == '%' && (hi = hex(s[1])) >= 0 && (lo = hex(s[2])) >= 0) {
+      *w++ = (char)(hi * 16 + lo);
+      s += 2;
+    } else {
+      *w++ = *s;
+    }
+  }
+  *w = '\0';
+  return out;
+}
+
+static ajson_t *follow_pointer(aml_pool_t *p, ajson_t *s, const char *ptr) {
+  char *seg = (char *)aml_pool_alloc(p, strlen(ptr) + 1);
+  while (s && *ptr == '/') {
+    ptr++;
+    size_t n = 0;
+    while (*ptr && *ptr != '/') {
+      if (ptr[0] == '~' && ptr[1] == '1')      { seg[n++] = '/'; ptr += 2; }
+      else if (ptr[0] == '~' && ptr[1] == '0') { seg[n++] = '~'; ptr += 2; }
+      else seg[n++] = *ptr++;
+    }
+    seg[n] = 0;
+    if (ajson_is_object(s)) s = ajsono_scan(s, seg);
+    else if (ajson_is_array(s)) {
+      char *end = NULL;
+      long idx = strtol(seg, &end, 10);
+      s = (n && !*end && idx >= 0) ? ajsona_scan(s, (int)idx) : NULL;
+    }
+    else s = NULL;
+  }
+  return *ptr ? NULL : s;
+}
+
+/* ── Indexing walk ──────────────────────────────────────────────────────── */
+
+typedef struct {
+  ajsb_link_t  *l;
+  aml_buffer_t *path;
+} walker_t;
+
+/* Keywords whose values are instance data, not schemas. */
+static bool is_data(const char *k) {
+  return !strcmp(k, "enum") || !strcmp(k, "const") ||
+         !strcmp(k, "default") || !strcmp(k, "examples");
+}
+
+static void path_key(aml_buffer_t *bh, const char *k) {
+  aml_buffer_appendc(bh, '/');
+  for (; *k; k++) {
+    if (*k == '~')      aml_buffer_appends(bh, "~0");
+    else if (*k == '/') aml_buffer_appends(bh, "~1");
+    else aml_buffer_appendc(bh, *k);
+  }
+}
+
+static void path_pop(aml_buffer_t *bh, size_t len) {
+  aml_buffer_shrink_by(bh, aml_buffer_length(bh) - len);
+}
+
+static const char *str(aml_pool_t *p, ajson_t *j) {
+  return j && ajson_is_string(j) ? ajson_to_strd(p, j, NULL) : NULL;
+}
+
+static void add_anchor(ajsb_link_t *l, res_t *res, const char *name, ajson_t *s, uint8_t flags) {
+  slot_t *a = slot_put(l, K_ANCHOR, res->node, name);
+  if (!a->value) a->value = s;
+  if (a->value == s) a->flags |= flags;
+}
+
+static void add_ref(walker_t *w, ajson_t *s, res_t *res, const char *text, bool dynamic) {
+  ajsb_link_t *l = w->l;
+  l->refs = (ref_t *)pool_grow(l->p, l->refs, l->num_refs, &l->cap_refs, sizeof(ref_t));
+  ref_t *r = l->refs + l->num_refs++;
+  memset(r, 0, sizeof(*r));
+  r->holder = s;
+  r->text = text;
+  r->path = aml_pool_strdup(l->p, aml_buffer_data(w->path));
+  r->res = res;
+  r->dynamic = dynamic;
+}
+
+static void walk(walker_t *w, ajson_t *s, res_t *res) {
+  ajsb_link_t *l = w->l;
+  size_t len = aml_buffer_length(w->path);
+
+  if (ajson_is_array(s)) {
+    int i = 0;
+    for (ajsona_t *a = ajsona_first(s); a; a = ajsona_next(a), i++) {
+      aml_buffer_appendf(w->path, "/%d", i);
+      walk(w, a->value, res);
+      path_pop(w->path, len);
+    }
+    return;
+  }
+  if (!ajson_is_object(s)) return;
+
+  const char *id = str(l->p, ajsono_scan(s, "$id"));
+  if (id) {
+    size_t n = strlen(id);
+    if (n && id[n - 1] == '#') n--;
+    const char *uri = uri_resolve(l->p, res->uri, id, n);
+    if (res->node != s) {
+      res_t *r = (res_t *)aml_pool_zalloc(l->p, sizeof(*r));
+      r->node = s;
+      r->parent = res;
+      res = r;
+    }
+    res->uri = uri;
+    slot_t *rs = slot_put(l, K_RESOURCE, NULL, uri);
+    if (!rs->value) rs->value = res;
+  }
+
+  const char *anchor = str(l->p, ajsono_scan(s, "$anchor"));
+  if (anchor) add_anchor(l, res, anchor, s, 0);
+  anchor = str(l->p, ajsono_scan(s, "$dynamicAnchor"));
+  if (anchor) add_anchor(l, res, anchor, s, A_DYNAMIC);
+
+  const char *ref = str(l->p, ajsono_scan(s, "$ref"));
+  if (ref) add_ref(w, s, res, ref, false);
+  ref = str(l->p, ajsono_scan(s, "$dynamicRef"));
+  if (ref) add_ref(w, s, res, ref, true);
+
+  for (ajsono_t *m = ajsono_first(s); m; m = ajsono_next(m)) {
+    if (is_data(m->key) || (!ajson_is_object(m->value) && !ajson_is_array(m->value))) continue;
+    path_key(w->path, m->key);
+    walk(w, m->value, res);
+    path_pop(w->path, len);
+  }
+}
+
+/* ── Resolution ─────────────────────────────────────────────────────────── */
+
+static ajson_t *resolve(ajsb_link_t *l, ref_t *r) {
+  const char *hash = strchr(r->text, '#');
+  size_t n = hash ? (size_t)(hash - r->text) : strlen(r->text);
+  res_t *res = r->res;
+  if (n) {
+    slot_t *rs = slot_get(l, K_RESOURCE, NULL, uri_resolve(l->p, res->uri, r->text, n));
+    if (!rs) return NULL;
+    res = (res_t *)rs->value;
+  }
+  const char *frag = hash ? fragment_decode(l->p, hash + 1) : "";
+  if (!*frag) return res->node;
+  if (*frag == '/') return follow_pointer(l->p, res->node, frag);
+  slot_t *a = slot_get(l, K_ANCHOR, res->node, frag);
+  if (!a) return NULL;
+  if (r->dynamic && (a->flags & A_DYNAMIC)) r->anchor = frag;
+  return (ajson_t *)a->value;
+}
+
+static ajson_t *dynamic_anchor(const ajsb_link_t *l, const ajson_t *resource, const char *name) {
+  slot_t *a = slot_get(l, K_ANCHOR, resource, name);
+  return a && (a->flags & A_DYNAMIC) ? (ajson_t *)a->value : NULL;
+}
+
+/* ── Cycles ─────────────────────────────────────────────────────────────── */
+
+/* Depth-first over the edges that stay on the same instance: $ref,
+   $dynamicRef and the in-place applicators. via is the last reference taken,
+   which is on any cycle closed below it. */
+static void visit(ajsb_link_t *l, ajson_t *s, ref_t *via) {
+  if (!ajson_is_object(s)) return;
+  slot_t *c = slot_put(l, K_COLOR, s, NULL);
+  if (c->flags == GRAY) {
+    if (via && !via->cyclic) {
+      via->cyclic = true;
+      add_issue(l->p, &l->cycles, via);
+    }
+    return;
+  }
+  if (c->flags == BLACK) return;
+  c->flags = GRAY;
+
+  for (ajsono_t *m = ajsono_first(s); m; m = ajsono_next(m)) {
+    const char *k = m->key;
+    if (!strcmp(k, "allOf") || !strcmp(k, "anyOf") || !strcmp(k, "oneOf")) {
+      for (ajsona_t *a = ajsona_first(m->value); a; a = ajsona_next(a)) visit(l, a->value, via);
+    } else if (!strcmp(k, "not") || !strcmp(k, "if") || !strcmp(k, "then") || !strcmp(k, "else")) {
+      visit(l, m->value, via);
+    } else if (!strcmp(k, "dependentSchemas") && ajson_is_object(m->value)) {
+      for (ajsono_t *d = ajsono_first(m->value); d; d = ajsono_next(d)) visit(l, d->value, via);
+    }
+  }
+  for (int kind = K_REF; kind <= K_DYNAMIC_REF; kind++) {
+    slot_t *rs = slot_get(l, kind, s, NULL);
+    ref_t *r = rs ? (ref_t *)rs->value : NULL;
+    if (r && r->target) visit(l, r->target, r);
+  }
+  slot_get(l, K_COLOR, s, NULL)->flags = BLACK;    /* c may have moved */
+}
+
+/* ── Public API ─────────────────────────────────────────────────────────── */
+
+ajsb_link_t *ajsb_link(aml_pool_t *p, ajson_t *root) {
+  if (!p || !root) return NULL;
+  ajsb_link_t *l = (ajsb_link_t *)aml_pool_zalloc(p, sizeof(*l));
+  l->p = p;
+  l->mask = 63;
+  l->slots = (slot_t *)aml_pool_zalloc(p, (l->mask + 1) * sizeof(slot_t));
+
+  l->doc = (res_t *)aml_pool_zalloc(p, sizeof(res_t));
+  l->doc->uri = "";
+  l->doc->node = root;
+  slot_put(l, K_RESOURCE, NULL, "")->value = l->doc;
+
+  walker_t w = { l, aml_buffer_init(256) };
+  walk(&w, root, l->doc);
+  aml_buffer_destroy(w.path);
+
+  /* every resource and anchor is known now, so forward references work */
+  for (size_t i = 0; i < l->num_refs; i++) {
+    ref_t *r = l->refs + i;
+    r->initial = r->target = resolve(l, r);
+    if (!r->initial) { add_issue(p, &l->unresolved, r); continue; }
+    if (r->anchor) {
+      for (res_t *e = r->res; e; e = e->parent) {
+        ajson_t *t = dynamic_anchor(l, e->node, r->anchor);
+        if (t) r->target = t;                      /* outermost wins */
+      }
+    }
+    slot_put(l, r->dynamic ? K_DYNAMIC_REF : K_REF, r->holder, NULL)->value = r;
+  }
+
+  for (size_t i = 0; i < l->num_refs; i++)
+    if (l->refs[i].target) visit(l, l->refs[i].holder, NULL);
+  return l;
+}
+
+static ref_t *find_ref(const ajsb_link_t *l, int kind, const ajson_t *schema) {
+  slot_t *s = l && schema ? slot_get(l, kind, schema, NULL) : NULL;
+  return s ? (ref_t *)s->value : NULL;
+}
+
+ajson_t *ajsb_link_ref(const ajsb_link_t *l, const ajson_t *schema) {
+  ref_t *r = find_ref(l, K_REF, schema);
+  return r ? r->target : NULL;
+}
+
+ajson_t *ajsb_link_dynamic_ref(const ajsb_link_t *l, const ajson_t *schema) {
+  ref_t *r = find_ref(l, K_DYNAMIC_REF, schema);
+  return r ? r->target : NULL;
+}
+
+ajson_t *ajsb_link_dynamic_scope(const ajsb_link_t *l, const ajson_t *schema,
+                                 const ajson_t *const *scope, size_t n) {
+  ref_t *r = find_ref(l, K_DYNAMIC_REF, schema);
+  if (!r) return NULL;
+  if (r->anchor) {
+    for (size_t i = 0; i < n; i++) {
+      ajson_t *t = scope[i] ? dynamic_anchor(l, scope[i], r->anchor) : NULL;
+      if (t) return t;
+    }
+  }
+  return r->initial;
+}
+
+bool ajsb_link_cyclic(const ajsb_link_t *l, const ajson_t *schema) {
+  ref_t *r = find_ref(l, K_REF, schema), *d = find_ref(l, K_DYNAMIC_REF, schema);
+  return (r && r->cyclic) || (d && d->cyclic);
+}
+
+ajson_t *ajsb_link_resource(const ajsb_link_t *l, const char *uri) {
+  slot_t *s = l && uri ? slot_get(l, K_RESOURCE, NULL, uri) : NULL;
+  return s ? ((res_t *)s->value)->node : NULL;
+}
+
+size_t ajsb_link_unresolved(const ajsb_link_t *l, const ajsb_link_issue_t **issues) {
+  if (issues) *issues = l ? l->unresolved.v : NULL;
+  return l ? l->unresolved.n : 0;
+}
+
+size_t ajsb_link_cycles(const ajsb_link_t *l, const ajsb_link_issue_t **issues) {
+  if (issues) *issues = l ? l->cycles.v : NULL;
+  return l ? l->cycles.n : 0;
+}
+
+bool ajsb_link_ok(const ajsb_link_t *l) {
+  return l && !l->unresolved.n && !l->cycles.n;
+}
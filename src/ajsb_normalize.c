@@ -0,0 +1,596 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#include "a-json-schema-builder-library/ajsb_normalize.h"
+#include "a-json-schema-builder-library/ajsb_intern.h"
+#include "a-json-schema-builder-library/ajsb_link.h"
+#include "a-memory-library/aml_alloc.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Where subschemas live. Everything else (enum, const, required, ...) is data. */
+static const char *const schema_maps[]   = { "properties", "patternProperties", "$defs",
+                                             "definitions", "dependentSchemas", NULL };
+static const char *const schema_single[] = { "items", "additionalProperties", "additionalItems",
+                                             "not", "if", "then", "else", "contains",
+                                             "propertyNames", "unevaluatedItems",
+                                             "unevaluatedProperties", NULL };
+static const char *const schema_lists[]  = { "anyOf", "allOf", "oneOf", "prefixItems", "items", NULL };
+
+/* A member carrying one of these is never merged into its parent: they name a
+   resource or depend on everything evaluated next to them. */
+static const char *const unmergeable[]   = { "$id", "$anchor", "$dynamicAnchor", "$schema",
+                                             "$vocabulary", "$defs", "definitions",
+                                             "unevaluatedProperties", "unevaluatedItems", NULL };
+
+/* Keywords read together. Parent and member may not both use one group,
+   except that both may have plain "properties". */
+static const char *const groups[][4] = {
+  { "properties", "patternProperties", "additionalProperties", NULL },
+  { "prefixItems", "items", "additionalItems", NULL },
+  { "if", "then", "else", NULL },
+  { "contains", "minContains", "maxContains", NULL },
+};
+
+static bool in_list(const char *const *list, const char *k) {
+  for (; *list; list++)
+    if (!strcmp(*list, k)) return true;
+  return false;
+}
+
+typedef void (*visit_fn)(void *arg, ajson_t *schema);
+
+/* fn for every direct subschema of s, skipping the member named skip. */
+static void each_subschema(ajson_t *s, const char *skip, visit_fn fn, void *arg) {
+  for (ajsono_t *m = ajsono_first(s); m; m = ajsono_next(m)) {
+    ajson_t *v = m->value;
+    if (skip && !strcmp(m->key, skip)) continue;
+    if (ajson_is_array(v) && in_list(schema_lists, m->key)) {
+      for (ajsona_t *a = ajsona_first(v); a; a = ajsona_next(a)) fn(arg, a->value);
+    } else if (ajson_is_object(v) && in_list(schema_maps, m->key)) {
+      for (ajsono_t *e = ajsono_first(v); e; e = ajsono_next(e)) fn(arg, e->value);
+    } else if (in_list(schema_single, m->key)) {
+      fn(arg, v);
+    }
+  }
+}
+
+/* ── Pointer map ────────────────────────────────────────────────────────── */
+
+typedef struct {
+  const ajson_t *key;
+  ajson_t       *value;
+  uint32_t       n;
+  uint8_t        flag;
+} slot_t;
+
+typedef struct {
+  aml_pool_t *p;
+  slot_t     *slots;
+  size_t      mask, count;
+} ptr_map_t;
+
+static inline size_t ptr_hash(const void *v) {
+  uintptr_t x = (uintptr_t)v;
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  return (size_t)x;
+}
+
+static void map_init(ptr_map_t *m, aml_pool_t *p) {
+  m->p = p;
+  m->mask = 63;
+  m->count = 0;
+  m->slots = (slot_t *)aml_pool_zalloc(p, (m->mask + 1) * sizeof(slot_t));
+}
+
+static slot_t *map_slot(const ptr_map_t *m, const ajson_t *k) {
+  for (size_t i = ptr_hash(k) & m->mask;; i = (i + 1) & m->mask)
+    if (!m->slots[i].key || m->slots[i].key == k) return m->slots + i;
+}
+
+static slot_t *map_find(const ptr_map_t *m, const ajson_t *k) {
+  slot_t *s = map_slot(m, k);
+  return s->key ? s : NULL;
+}
+
+/* The slot for k, zeroed if new. Invalidated by the next map_put. */
+static slot_t *map_put(ptr_map_t *m, const ajson_t *k) {
+  slot_t *s = map_slot(m, k);
+  if (s->key) return s;
+  if ((m->count + 1) * 2 > m->mask + 1) {
+    slot_t *old = m->slots;
+    size_t old_mask = m->mask;
+    m->mask = old_mask * 2 + 1;
+    m->slots = (slot_t *)aml_pool_zalloc(m->p, (m->mask + 1) * sizeof(slot_t));
+    for (size_t i = 0; i <= old_mask; i++)
+      if (old[i].key) *map_slot(m, old[i].key) = old[i];
+    s = map_slot(m, k);
+  }
+  s->key = k;
+  m->count++;
+  return s;
+}
+
+/* ── Small helpers ──────────────────────────────────────────────────────── */
+
+static inline bool is_num(ajson_t *j) { return ajson_is_number(j) || ajson_is_decimal(j); }
+
+/* true and {} accept everything. */
+static inline bool is_trivial(ajson_t *s) {
+  return ajson_is_true(s) || (ajson_is_object(s) && !ajsono_count(s));
+}
+
+static bool only_key(ajson_t *s, const char *kw) {
+  return ajson_is_object(s) && ajsono_count(s) == 1 && !strcmp(ajsono_first(s)->key, kw) &&
+         ajson_is_array(ajsono_first(s)->value);
+}
+
+static ajson_t *without(aml_pool_t *p, ajson_t *o, const char *key) {
+  ajson_t *r = ajsono(p);
+  for (ajsono_t *m = ajsono_first(o); m; m = ajsono_next(m))
+    if (strcmp(m->key, key)) ajsono_append(r, m->key, m->value, /*copy_key=*/false);
+  return r;
+}
+
+static ajson_t *copy_array(aml_pool_t *p, ajson_t *arr) {
+  ajson_t *r = ajsona(p);
+  for (ajsona_t *a = ajsona_first(arr); a; a = ajsona_next(a)) ajsona_append(r, a->value);
+  return r;
+}
+
+/* JSON Schema equality for enum values: numbers by value. */
+static bool value_equal(ajson_t *a, ajson_t *b) {
+  if (is_num(a) && is_num(b)) return ajson_to_double(a, 0) == ajson_to_double(b, 0);
+  return ajsb_schema_equal(a, b);
+}
+
+static uint64_t value_hash(ajson_t *v) {
+  if (!is_num(v)) return ajsb_schema_hash(v);
+  double d = ajson_to_double(v, 0);
+  if (d == 0) d = 0;
+  uint64_t h;
+  memcpy(&h, &d, sizeof(h));
+  return h * 0x9e3779b97f4a7c15ULL;
+}
+
+typedef struct {
+  uint64_t  h;
+  ajson_t  *v;
+} item_t;
+
+/* arr without repeated values (the first stays), or arr if it has none. */
+static ajson_t *unique_values(aml_pool_t *p, ajson_t *arr) {
+  size_t n = ajsona_count(arr);
+  if (n < 2) return arr;
+  size_t mask = 15;
+  while (mask + 1 < n * 2) mask = mask * 2 + 1;
+  item_t *items = (item_t *)aml_malloc(n * sizeof(item_t));
+  size_t *tab = (size_t *)aml_calloc(mask + 1, sizeof(size_t));
+  size_t kept = 0;
+  for (ajsona_t *a = ajsona_first(arr); a; a = ajsona_next(a)) {
+    uint64_t h = value_hash(a->value);
+    size_t k = h & mask;
+    bool dup = false;
+    while (tab[k] && !dup) {
+      const item_t *o = items + tab[k] - 1;
+      dup = o->h == h && value_equal(o->v, a->value);
+      if (!dup) k = (k + 1) & mask;
+    }
+    if (dup) continue;
+    items[kept].h = h;
+    items[kept].v = a->value;
+    tab[k] = ++kept;
+  }
+  ajson_t *r = arr;
+  if (kept < n) {
+    r = ajsona(p);
+    for (size_t i = 0; i < kept; i++) ajsona_append(r, items[i].v);
+  }
+  aml_free(items);
+  aml_free(tab);
+  return r;
+}
+
+/* Members that are only {kw: [...]} replaced by their own members. */
+static ajson_t *splice(aml_pool_t *p, ajson_t *arr, const char *kw) {
+  bool any = false;
+  for (ajsona_t *a = ajsona_first(arr); a && !any; a = ajsona_next(a)) any = only_key(a->value, kw);
+  if (!any) return arr;
+  ajson_t *r = ajsona(p);
+  for (ajsona_t *a = ajsona_first(arr); a; a = ajsona_next(a)) {
+    if (!only_key(a->value, kw)) { ajsona_append(r, a->value); continue; }
+    ajson_t *inner = ajsono_first(a->value)->value;
+    for (ajsona_t *b = ajsona_first(inner); b; b = ajsona_next(b)) ajsona_append(r, b->value);
+  }
+  return r;
+}
+
+/* ── allOf merging ──────────────────────────────────────────────────────── */
+
+static bool uses_group(ajson_t *s, size_t g) {
+  for (const char *const *k = groups[g]; *k; k++)
+    if (ajsono_scan(s, *k)) return true;
+  return false;
+}
+
+static bool can_merge(ajson_t *o, ajson_t *m) {
+  if (!ajson_is_object(m)) return false;
+  for (const char *const *k = unmergeable; *k; k++)
+    if (ajsono_scan(m, *k)) return false;
+  if (ajsono_scan(o, "unevaluatedProperties") || ajsono_scan(o, "unevaluatedItems")) return false;
+  for (size_t g = 0; g < sizeof(groups) / sizeof(groups[0]); g++) {
+    if (!uses_group(o, g) || !uses_group(m, g)) continue;
+    if (g || ajsono_scan(o, "patternProperties") || ajsono_scan(o, "additionalProperties") ||
+        ajsono_scan(m, "patternProperties") || ajsono_scan(m, "additionalProperties"))
+      return false;
+  }
+  for (ajsono_t *kv = ajsono_first(m); kv; kv = ajsono_next(kv)) {
+    ajson_t *ov = ajsono_scan(o, kv->key);
+    if (!ov || !strcmp(kv->key, "allOf")) continue;
+    if (!strcmp(kv->key, "required") && ajson_is_array(ov) && ajson_is_array(kv->value)) continue;
+    if (!strcmp(kv->key, "properties") && ajson_is_object(ov) && ajson_is_object(kv->value)) {
+      for (ajsono_t *e = ajsono_first(kv->value); e; e = ajsono_next(e)) {
+        ajson_t *same = ajsono_scan(ov, e->key);
+        if (same && !ajsb_schema_equal(same, e->value)) return false;
+      }
+      continue;
+    }
+    if (!ajsb_schema_equal(ov, kv->value)) return false;
+  }
+  return true;
+}
+
+/* Add m's keywords to o (a fresh object); m's own allOf members go to rest. */
+static void merge(aml_pool_t *p, ajson_t *o, ajson_t *m, ajson_t *rest) {
+  for (ajsono_t *kv = ajsono_first(m); kv; kv = ajsono_next(kv)) {
+    ajson_t *ov = ajsono_scan(o, kv->key);
+    if (!strcmp(kv->key, "allOf") && ajson_is_array(kv->value)) {
+      for (ajsona_t *a = ajsona_first(kv->value); a; a = ajsona_next(a)) ajsona_append(rest, a->value);
+    } else if (!ov) {
+      ajsono_append(o, kv->key, kv->value, /*copy_key=*/false);
+    } else if (!strcmp(kv->key, "required") && ajson_is_array(ov)) {
+      ajson_t *both = copy_array(p, ov);
+      for (ajsona_t *a = ajsona_first(kv->value); a; a = ajsona_next(a)) ajsona_append(both, a->value);
+      ajsono_set(o, kv->key, unique_values(p, both), /*copy_key=*/false);
+    } else if (!strcmp(kv->key, "properties") && ajson_is_object(ov)) {
+      ajson_t *props = ajsono(p);
+      for (ajsono_t *e = ajsono_first(ov); e; e = ajsono_next(e))
+        ajsono_append(props, e->key, e->value, /*copy_key=*/false);
+      for (ajsono_t *e = ajsono_first(kv->value); e; e = ajsono_next(e))
+        if (!ajsono_scan(ov, e->key)) ajsono_append(props, e->key, e->value, /*copy_key=*/false);
+      ajsono_set(o, kv->key, props, /*copy_key=*/false);
+    }
+  }
+}
+
+/* ── Normalizing ────────────────────────────────────────────────────────── */
+
+typedef struct {
+  aml_pool_t        *p;
+  const ajsb_link_t *link;
+  ptr_map_t          targets;   /* nodes some reference resolves to */
+  ptr_map_t          seen;
+  ptr_map_t          memo;      /* input node → result, flag = pinned */
+} norm_t;
+
+static void add_targets(void *arg, ajson_t *s) {
+  norm_t *x = (norm_t *)arg;
+  if (!ajson_is_object(s)) return;
+  slot_t *v = map_put(&x->seen, s);
+  if (v->flag) return;
+  v->flag = 1;
+  ajson_t *t = ajsb_link_ref(x->link, s);
+  if (t) map_put(&x->targets, t);
+  if ((t = ajsb_link_dynamic_ref(x->link, s))) map_put(&x->targets, t);
+  each_subschema(s, NULL, add_targets, x);
+}
+
+static ajson_t *norm(norm_t *x, ajson_t *s, bool *pinned);
+
+static ajson_t *norm_list(norm_t *x, ajson_t *arr, bool *pinned) {
+  ajson_t *r = ajsona(x->p);
+  bool changed = false;
+  for (ajsona_t *a = ajsona_first(arr); a; a = ajsona_next(a)) {
+    bool pin;
+    ajson_t *v = norm(x, a->value, &pin);
+    *pinned |= pin;
+    changed |= v != a->value;
+    ajsona_append(r, v);
+  }
+  return changed ? r : arr;
+}
+
+static ajson_t *norm_map(norm_t *x, ajson_t *obj, bool *pinned) {
+  ajson_t *r = ajsono(x->p);
+  bool changed = false;
+  for (ajsono_t *m = ajsono_first(obj); m; m = ajsono_next(m)) {
+    bool pin;
+    ajson_t *v = norm(x, m->value, &pin);
+    *pinned |= pin;
+    changed |= v != m->value;
+    ajsono_append(r, m->key, v, /*copy_key=*/false);
+  }
+  return changed ? r : obj;
+}
+
+/* allOf: splice, drop trivial and repeated members, merge what fits into o. */
+static ajson_t *simplify_all(norm_t *x, ajson_t *o, ajson_t *all, bool *changed) {
+  ajson_t *flat = splice(x->p, all, "allOf");
+  ajson_t *members = ajsona(x->p);
+  for (ajsona_t *a = ajsona_first(flat); a; a = ajsona_next(a))
+    if (!is_trivial(a->value)) ajsona_append(members, a->value);
+  members = unique_values(x->p, members);
+
+  ajson_t *rest = ajsona(x->p);
+  for (ajsona_t *a = ajsona_first(members); a; a = ajsona_next(a)) {
+    if (can_merge(o, a->value)) merge(x->p, o, a->value, rest);
+    else ajsona_append(rest, a->value);
+  }
+  if (ajsona_count(rest) == ajsona_count(all) && ajsb_schema_equal(rest, all)) return o;
+  *changed = true;
+  if (!ajsona_count(rest)) return without(x->p, o, "allOf");
+  ajsono_set(o, "allOf", rest, /*copy_key=*/false);
+  return o;
+}
+
+/* Keyword-level rewrites of o, a fresh copy whose subschemas are already
+   normalized. pin_* say whether a reference points into that applicator. */
+static ajson_t *simplify(norm_t *x, ajson_t *o, bool pin_all, bool pin_any, bool pin_one,
+                         bool *changed) {
+  ajson_t *all = ajsono_scan(o, "allOf");
+  if (all && !ajson_is_array(all)) return o;
+  ajson_t *moved = ajsona(x->p);         /* single anyOf/oneOf branches */
+
+  ajson_t *any = ajsono_scan(o, "anyOf");
+  if (any && ajson_is_array(any) && !pin_any) {
+    ajson_t *flat = splice(x->p, any, "anyOf");
+    bool always = false;
+    for (ajsona_t *a = ajsona_first(flat); a && !always; a = ajsona_next(a)) always = is_trivial(a->value);
+    if (!always) flat = unique_values(x->p, flat);
+    if (always || ajsona_count(flat) == 1) {
+      if (!always) ajsona_append(moved, ajsona_first(flat)->value);
+      o = without(x->p, o, "anyOf");
+      *changed = true;
+    } else if (flat != any) {
+      ajsono_set(o, "anyOf", flat, /*copy_key=*/false);
+      *changed = true;
+    }
+  }
+  ajson_t *one = ajsono_scan(o, "oneOf");
+  if (one && ajson_is_array(one) && !pin_one && ajsona_count(one) == 1) {
+    ajsona_append(moved, ajsona_first(one)->value);
+    o = without(x->p, o, "oneOf");
+    *changed = true;
+  }
+  if (ajsona_count(moved)) {
+    ajson_t *joined = all ? copy_array(x->p, all) : ajsona(x->p);
+    for (ajsona_t *a = ajsona_first(moved); a; a = ajsona_next(a)) ajsona_append(joined, a->value);
+    ajsono_set(o, "allOf", joined, /*copy_key=*/false);
+    all = joined;
+  }
+  if (!all || pin_all) return o;
+
+  o = simplify_all(x, o, all, changed);
+  ajsono_t *only = ajsono_count(o) == 1 ? ajsono_first(o) : NULL;
+  if (only && !strcmp(only->key, "allOf") && ajsona_count(only->value) == 1) {
+    *changed = true;
+    return ajsona_first(only->value)->value;
+  }
+  return o;
+}
+
+static ajson_t *norm(norm_t *x, ajson_t *s, bool *pinned) {
+  *pinned = map_find(&x->targets, s) != NULL;
+  if (!ajson_is_object(s)) return s;
+  slot_t *memo = map_find(&x->memo, s);
+  if (memo) {
+    *pinned = memo->flag;
+    return memo->value;
+  }
+
+  ajson_t *o = ajsono(x->p);
+  bool changed = false, pin_all = false, pin_any = false, pin_one = false;
+  for (ajsono_t *m = ajsono_first(s); m; m = ajsono_next(m)) {
+    ajson_t *v = m->value, *nv = v;
+    bool pin = false;
+    if (ajson_is_array(v) && in_list(schema_lists, m->key)) nv = norm_list(x, v, &pin);
+    else if (ajson_is_object(v) && in_list(schema_maps, m->key)) nv = norm_map(x, v, &pin);
+    else if (in_list(schema_single, m->key)) nv = norm(x, v, &pin);
+    else if (ajson_is_array(v) && (!strcmp(m->key, "required") || !strcmp(m->key, "enum")))
+      nv = unique_values(x->p, v);
+    if (!strcmp(m->key, "allOf")) pin_all = pin;
+    if (!strcmp(m->key, "anyOf")) pin_any = pin;
+    if (!strcmp(m->key, "oneOf")) pin_one = pin;
+    *pinned |= pin;
+    changed |= nv != v;
+    ajsono_append(o, m->key, nv, /*copy_key=*/false);
+  }
+  o = simplify(x, o, pin_all, pin_any, pin_one, &changed);
+
+  ajson_t *r = changed ? o : s;
+  slot_t *slot = map_put(&x->memo, s);
+  slot->value = r;
+  slot->flag = *pinned;
+  return r;
+}
+
+/* ── $defs tree shaking ─────────────────────────────────────────────────── */
+
+#define SHARED 1    /* owner slot flag: node is inside more than one $defs entry */
+
+typedef struct {
+  const char *name;
+  uint32_t    def;
+} anchor_t;
+
+typedef struct {
+  aml_pool_t        *p;
+  const ajsb_link_t *link;
+  ajson_t          **defs;
+  uint8_t           *used;
+  uint32_t           num_defs, cur;
+  ptr_map_t          owner;     /* node → n = $defs index + 1 */
+  ptr_map_t          seen;
+  anchor_t          *anchors;   /* $dynamicAnchor names inside $defs */
+  size_t             num_anchors, cap_anchors;
+} shake_t;
+
+static void own(void *arg, ajson_t *s) {
+  shake_t *k = (shake_t *)arg;
+  slot_t *o = map_put(&k->owner, s);
+  if (o->n == k->cur + 1) return;
+  if (o->n) o->flag = SHARED;
+  o->n = k->cur + 1;
+  if (!ajson_is_object(s)) return;
+  ajson_t *da = ajsono_scan(s, "$dynamicAnchor");
+  if (da && ajson_is_string(da)) {
+    if (k->num_anchors == k->cap_anchors) {
+      k->cap_anchors = k->cap_anchors ? k->cap_anchors * 2 : 8;
+      anchor_t *n = (anchor_t *)aml_pool_alloc(k->p, k->cap_anchors * sizeof(anchor_t));
+      if (k->num_anchors) memcpy(n, k->anchors, k->num_anchors * sizeof(anchor_t));
+      k->anchors = n;
+    }
+    k->anchors[k->num_anchors].name = ajson_to_str(da, "");
+    k->anchors[k->num_anchors++].def = k->cur;
+  }
+  each_subschema(s, NULL, own, k);
+}
+
+static bool contains(ajson_t *s, const ajson_t *t) {
+  if (s == t) return true;
+  if (!ajson_is_object(s)) return false;
+  for (ajsono_t *m = ajsono_first(s); m; m = ajsono_next(m)) {
+    ajson_t *v = m->value;
+    if (ajson_is_array(v) && in_list(schema_lists, m->key)) {
+      for (ajsona_t *a = ajsona_first(v); a; a = ajsona_next(a))
+        if (contains(a->value, t)) return true;
+    } else if (ajson_is_object(v) && in_list(schema_maps, m->key)) {
+      for (ajsono_t *e = ajsono_first(v); e; e = ajsono_next(e))
+        if (contains(e->value, t)) return true;
+    } else if (in_list(schema_single, m->key) && contains(v, t)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static void reach(void *arg, ajson_t *s);
+
+static void mark(shake_t *k, uint32_t def) {
+  if (k->used[def]) return;
+  k->used[def] = 1;
+  reach(k, k->defs[def]);
+}
+
+static void use(shake_t *k, const ajson_t *t) {
+  slot_t *o = map_find(&k->owner, t);
+  if (!o) return;
+  if (!(o->flag & SHARED)) { mark(k, o->n - 1); return; }
+  for (uint32_t i = 0; i < k->num_defs; i++)
+    if (!k->used[i] && contains(k->defs[i], t)) mark(k, i);
+}
+
+static void refs_of(shake_t *k, ajson_t *s) {
+  ajson_t *t;
+  if ((t = ajsb_link_ref(k->link, s))) use(k, t);
+  if ((t = ajsb_link_dynamic_ref(k->link, s))) use(k, t);
+  /* the dynamic scope may pick any $dynamicAnchor of the same name */
+  ajson_t *dr = ajsono_scan(s, "$dynamicRef");
+  const char *hash = dr && ajson_is_string(dr) ? strchr(ajson_to_str(dr, ""), '#') : NULL;
+  if (!hash || strchr(hash, '/')) return;
+  for (size_t i = 0; i < k->num_anchors; i++)
+    if (!strcmp(k->anchors[i].name, hash + 1)) mark(k, k->anchors[i].def);
+}
+
+static void reach(void *arg, ajson_t *s) {
+  shake_t *k = (shake_t *)arg;
+  if (!ajson_is_object(s)) return;
+  slot_t *v = map_put(&k->seen, s);
+  if (v->flag) return;
+  v->flag = 1;
+  refs_of(k, s);
+  each_subschema(s, NULL, reach, k);
+}
+
+/* root without the $defs entries nothing reaches. */
+static ajson_t *shake_defs(aml_pool_t *p, ajson_t *root) {
+  ajson_t *defs = ajson_is_object(root) ? ajsono_scan(root, "$defs") : NULL;
+  if (!defs || !ajson_is_object(defs) || !ajsono_count(defs)) return root;
+  shake_t k;
+  memset(&k, 0, sizeof(k));
+  k.p = p;
+  k.link = ajsb_link(p, root);
+  if (ajsb_link_unresolved(k.link, NULL)) return root;
+
+  k.num_defs = (uint32_t)ajsono_count(defs);
+  k.defs = (ajson_t **)aml_pool_alloc(p, k.num_defs * sizeof(ajson_t *));
+  k.used = (uint8_t *)aml_pool_zalloc(p, k.num_defs);
+  map_init(&k.owner, p);
+  map_init(&k.seen, p);
+  for (ajsono_t *m = ajsono_first(defs); m; m = ajsono_next(m), k.cur++) {
+    k.defs[k.cur] = m->value;
+    own(&k, m->value);
+  }
+
+  map_put(&k.seen, root)->flag = 1;
+  refs_of(&k, root);
+  each_subschema(root, "$defs", reach, &k);
+
+  uint32_t i = 0, kept = 0;
+  for (i = 0; i < k.num_defs; i++) kept += k.used[i];
+  if (kept == k.num_defs) return root;
+  ajson_t *nd = ajsono(p);
+  i = 0;
+  for (ajsono_t *m = ajsono_first(defs); m; m = ajsono_next(m), i++)
+    if (k.used[i]) ajsono_append(nd, m->key, m->value, /*copy_key=*/false);
+  ajson_t *r = ajsono(p);
+  for (ajsono_t *m = ajsono_first(root); m; m = ajsono_next(m)) {
+    if (strcmp(m->key, "$defs")) ajsono_append(r, m->key, m->value, /*copy_key=*/false);
+    else if (kept) ajsono_append(r, m->key, nd, /*copy_key=*/false);
+  }
+  return r;
+}
+
+/* ── Public API ─────────────────────────────────────────────────────────── */
+
+static size_t count_nodes(ajson_t *j) {
+  size_t n = 1;
+  if (ajson_is_object(j))
+    for (ajsono_t *m = ajsono_first(j); m; m = ajsono_next(m)) n += count_nodes(m->value);
+  else if (ajson_is_array(j))
+    for (ajsona_t *a = ajsona_first(j); a; a = ajsona_next(a)) n += count_nodes(a->value);
+  return n;
+}
+
+ajson_t *ajsb_normalize(aml_pool_t *p, ajson_t *schema, ajsb_normalize_stats_t *stats) {
+  if (stats) memset(stats, 0, sizeof(*stats));
+  if (!p || !schema) return schema;
+  if (stats) {
+    stats->nodes_before = count_nodes(schema);
+    stats->bytes_before = strlen(ajson_stringify(p, schema));
+  }
+
+  norm_t x;
+  x.p = p;
+  x.link = ajsb_link(p, schema);
+  map_init(&x.targets, p);
+  map_init(&x.seen, p);
+  map_init(&x.memo, p);
+  add_targets(&x, schema);
+
+  bool pinned;
+  ajson_t *r = shake_defs(p, norm(&x, schema, &pinned));
+
+  if (stats) {
+    stats->nodes_after = count_nodes(r);
+    stats->bytes_after = r == schema ? stats->bytes_before : strlen(ajson_stringify(p, r));
+  }
+  return r;
+}
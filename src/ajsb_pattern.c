@@ -0,0 +1,765 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+/* "pattern" compiler: ECMA-262 source → syntax tree → Thompson NFA over UTF-8
+   bytes → DFA by subset construction over byte classes.
+
+   Supported: literals, ".", [classes] and [^classes] (non-ASCII members only
+   as single characters), \d \w \s and their negations (ASCII, as in
+   ECMA-262 without the u flag), \t \n \r \v \f \0 \cX \xHH \uHHHH, identity
+   escapes of punctuation, (groups), (?:groups), (?<named>groups), |, * + ?
+   {n} {n,} {n,m} (lazy forms match the same strings), ^ and $. Back
+   references, lookaround and \b are not regular and are refused, as are
+   \p{...} and ranges over non-ASCII characters. */
+
+#include "ajsb_program.h"
+#include "a-json-schema-builder-library/ajsb_format.h"
+#include "a-memory-library/aml_alloc.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define NFA_MAX    4096        /* NFA states */
+#define DFA_MAX    2048        /* DFA states */
+#define TABLE_MAX  (1u << 18)  /* DFA transition words */
+#define REPEAT_MAX 1000        /* largest {n,m} bound */
+#define DEPTH_MAX  64          /* group nesting */
+#define INF        UINT32_MAX
+
+typedef struct { uint64_t w[4]; } bset_t;
+
+static inline void bset_add(bset_t *s, unsigned b) { s->w[b >> 6] |= (uint64_t)1 << (b & 63); }
+static inline bool bset_has(const bset_t *s, unsigned b) { return (s->w[b >> 6] >> (b & 63)) & 1; }
+
+static void bset_range(bset_t *s, unsigned lo, unsigned hi) {
+  for (unsigned b = lo; b <= hi; b++) bset_add(s, b);
+}
+
+static bool grow(void **arr, uint32_t *cap, uint32_t need, size_t elem) {
+  if (need <= *cap) return true;
+  uint32_t n = *cap ? *cap : 64;
+  while (n < need) n *= 2;
+  void *r = aml_realloc(*arr, (size_t)n * elem);
+  if (!r) return false;
+  *arr = r;
+  *cap = n;
+  return true;
+}
+
+/* ── Parse ──────────────────────────────────────────────────────────────── */
+
+enum { A_EMPTY, A_SET, A_CAT, A_ALT, A_REPEAT, A_BOL, A_EOL };
+
+typedef struct {
+  uint8_t  kind;
+  uint32_t a, b;            /* CAT and ALT children; REPEAT child in a */
+  uint32_t min, max;        /* REPEAT */
+  uint32_t set;             /* SET: index into sets */
+} ast_t;
+
+typedef struct {
+  const char *s, *e;
+  ast_t    *ast;   uint32_t num_ast,  cap_ast;
+  bset_t   *sets;  uint32_t num_sets, cap_sets;
+  bool      bad;
+} parser_t;
+
+/* Node 0 is A_EMPTY, so failures can return 0. */
+static uint32_t node(parser_t *p, uint8_t kind, uint32_t a, uint32_t b) {
+  if (p->bad) return 0;
+  if (!grow((void **)&p->ast, &p->cap_ast, p->num_ast + 1, sizeof(ast_t)) ||
+      p->num_ast >= NFA_MAX * 4) {
+    p->bad = true;
+    return 0;
+  }
+  ast_t *n = p->ast + p->num_ast;
+  memset(n, 0, sizeof(*n));
+  n->kind = kind;
+  n->a = a;
+  n->b = b;
+  return p->num_ast++;
+}
+
+static uint32_t set_node(parser_t *p, const bset_t *set) {
+  if (p->bad) return 0;
+  if (!grow((void **)&p->sets, &p->cap_sets, p->num_sets + 1, sizeof(bset_t))) {
+    p->bad = true;
+    return 0;
+  }
+  uint32_t n = node(p, A_SET, 0, 0);
+  if (p->bad) return 0;
+  p->sets[p->num_sets] = *set;
+  p->ast[n].set = p->num_sets++;
+  return n;
+}
+
+static uint32_t byte_node(parser_t *p, unsigned b) {
+  bset_t s = {{0}};
+  bset_add(&s, b);
+  return set_node(p, &s);
+}
+
+static uint32_t cat(parser_t *p, uint32_t a, uint32_t b) {
+  if (p->ast[a].kind == A_EMPTY) return b;
+  if (p->ast[b].kind == A_EMPTY) return a;
+  return node(p, A_CAT, a, b);
+}
+
+static uint32_t alt(parser_t *p, uint32_t a, uint32_t b) {
+  return node(p, A_ALT, a, b);
+}
+
+static uint32_t utf8_node(parser_t *p, uint32_t cp) {
+  unsigned char u[4];
+  int n;
+  if (cp < 0x80)         { u[0] = (unsigned char)cp; n = 1; }
+  else if (cp < 0x800)   { u[0] = (unsigned char)(0xC0 | (cp >> 6)); n = 2; }
+  else if (cp < 0x10000) { u[0] = (unsigned char)(0xE0 | (cp >> 12)); n = 3; }
+  else                   { u[0] = (unsigned char)(0xF0 | (cp >> 18)); n = 4; }
+  for (int i = 1; i < n; i++) u[i] = (unsigned char)(0x80 | ((cp >> (6 * (n - 1 - i))) & 0x3F));
+  uint32_t r = 0;
+  for (int i = 0; i < n; i++) r = cat(p, r, byte_node(p, u[i]));
+  return r;
+}
+
+/* Any one non-ASCII character. */
+static uint32_t multibyte(parser_t *p) {
+  bset_t lead2 = {{0}}, lead3 = {{0}}, lead4 = {{0}}, cont = {{0}};
+  bset_range(&lead2, 0xC2, 0xDF);
+  bset_range(&lead3, 0xE0, 0xEF);
+  bset_range(&lead4, 0xF0, 0xF4);
+  bset_range(&cont, 0x80, 0xBF);
+  uint32_t two = cat(p, set_node(p, &lead2), set_node(p, &cont));
+  uint32_t three = cat(p, set_node(p, &lead3), cat(p, set_node(p, &cont), set_node(p, &cont)));
+  uint32_t four = cat(p, set_node(p, &lead4),
+                      cat(p, set_node(p, &cont), cat(p, set_node(p, &cont), set_node(p, &cont))));
+  return alt(p, two, alt(p, three, four));
+}
+
+/* One UTF-8 character at p->s. */
+static uint32_t next_cp(parser_t *p) {
+  unsigned char c = (unsigned char)*p->s++;
+  if (c < 0x80) return c;
+  int n = c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : c >= 0xC0 ? 1 : 0;
+  uint32_t cp = c & (0x3F >> n);
+  for (int i = 0; i < n; i++) {
+    if (p->s >= p->e || ((unsigned char)*p->s & 0xC0) != 0x80) { p->bad = true; return 0; }
+    cp = cp << 6 | ((unsigned char)*p->s++ & 0x3F);
+  }
+  if (!n) p->bad = true;
+  return cp;
+}
+
+static int hexval(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+static bool hex_digits(parser_t *p, int n, uint32_t *out) {
+  if (p->e - p->s < n) return false;
+  uint32_t v = 0;
+  for (int i = 0; i < n; i++) {
+    int h = hexval(p->s[i]);
+    if (h < 0) return false;
+    v = v << 4 | (uint32_t)h;
+  }
+  p->s += n;
+  *out = v;
+  return true;
+}
+
+/* \d \w \s and negations: an ASCII set plus whether it is negated. */
+static bool class_escape(char c, bset_t *set, bool *negated) {
+  memset(set, 0, sizeof(*set));
+  switch (c | 0x20) {
+  case 'd': bset_range(set, '0', '9'); break;
+  case 'w':
+    bset_range(set, '0', '9');
+    bset_range(set, 'A', 'Z');
+    bset_range(set, 'a', 'z');
+    bset_add(set, '_');
+    break;
+  case 's': bset_range(set, '\t', '\r'); bset_add(set, ' '); break;
+  default: return false;
+  }
+  *negated = c >= 'A' && c <= 'Z';
+  return true;
+}
+
+/* After '\': a character escape. */
+static uint32_t char_escape(parser_t *p, bool in_class) {
+  if (p->s >= p->e) { p->bad = true; return 0; }
+  char c = *p->s;
+  if ((unsigned char)c >= 0x80) return next_cp(p);
+  p->s++;
+  switch (c) {
+  case 't': return '\t';
+  case 'n': return '\n';
+  case 'r': return '\r';
+  case 'v': return '\v';
+  case 'f': return '\f';
+  case 'b': if (in_class) return '\b'; break;
+  case '0': if (p->s >= p->e || *p->s < '0' || *p->s > '9') return 0; break;
+  case 'c':
+    if (p->s < p->e && ((*p->s | 0x20) >= 'a' && (*p->s | 0x20) <= 'z')) return (uint32_t)(*p->s++ & 31);
+    break;
+  case 'x': {
+    uint32_t v;
+    if (hex_digits(p, 2, &v)) return v;
+    break;
+  }
+  case 'u': {
+    uint32_t v, lo;
+    if (!hex_digits(p, 4, &v)) break;
+    if (v >= 0xDC00 && v < 0xE000) break;
+    if (v < 0xD800 || v >= 0xDC00) return v;
+    if (p->e - p->s >= 6 && p->s[0] == '\\' && p->s[1] == 'u') {
+      p->s += 2;
+      if (hex_digits(p, 4, &lo) && lo >= 0xDC00 && lo < 0xE000)
+        return 0x10000 + ((v - 0xD800) << 10) + (lo - 0xDC00);
+    }
+    break;
+  }
+  default:
+    if ((c >= 0x21 && c <= 0x2F) || (c >= 0x3A && c <= 0x40) || (c >= 0x5B && c <= 0x60) ||
+        (c >= 0x7B && c <= 0x7E))
+      return (uint32_t)(unsigned char)c;
+    break;
+  }
+  p->bad = true;   /* back references, \b, \B, \p, \k, unknown letters */
+  return 0;
+}
+
+#define CLASS_WIDE_MAX 64
+
+static uint32_t parse_class(parser_t *p) {
+  bool negated = p->s < p->e && *p->s == '^';
+  if (negated) p->s++;
+  bset_t set = {{0}};
+  uint32_t wide[CLASS_WIDE_MAX], num_wide = 0;
+  bool any_wide = false;   /* a negated escape such as \D admits every non-ASCII character */
+
+  while (!p->bad) {
+    if (p->s >= p->e) { p->bad = true; break; }
+    if (*p->s == ']') { p->s++; break; }
+    uint32_t lo;
+    if (*p->s == '\\' && p->s + 1 < p->e) {
+      bset_t esc;
+      bool neg;
+      if (class_escape(p->s[1], &esc, &neg)) {
+        p->s += 2;
+        for (unsigned b = 0; b < 128; b++)
+          if (bset_has(&esc, b) != neg) bset_add(&set, b);
+        if (neg) any_wide = true;
+        continue;
+      }
+      p->s++;
+      lo = char_escape(p, true);
+    }
+    else lo = next_cp(p);
+    uint32_t hi = lo;
+    if (p->e - p->s >= 2 && p->s[0] == '-' && p->s[1] != ']') {
+      p->s++;
+      if (*p->s == '\\') {
+        p->s++;
+        bset_t esc;
+        bool neg;
+        if (p->s < p->e && class_escape(*p->s, &esc, &neg)) { p->bad = true; break; }
+        hi = char_escape(p, true);
+      }
+      else hi = next_cp(p);
+      if (hi < lo) { p->bad = true; break; }
+    }
+    if (hi < 0x80) bset_range(&set, lo, hi);
+    else if (lo == hi && num_wide < CLASS_WIDE_MAX) wide[num_wide++] = lo;
+    else p->bad = true;
+  }
+  if (p->bad) return 0;
+  if (negated) {
+    if (num_wide || any_wide) { p->bad = true; return 0; }
+    bset_t inv = {{0}};
+    for (unsigned b = 0; b < 128; b++)
+      if (!bset_has(&set, b)) bset_add(&inv, b);
+    return alt(p, set_node(p, &inv), multibyte(p));
+  }
+  uint32_t r = set_node(p, &set);
+  if (any_wide) r = alt(p, r, multibyte(p));
+  for (uint32_t i = 0; i < num_wide; i++) r = alt(p, r, utf8_node(p, wide[i]));
+  return r;
+}
+
+static uint32_t parse_alt(parser_t *p, int depth);
+
+static uint32_t parse_atom(parser_t *p, int depth) {
+  char c = *p->s++;
+  switch (c) {
+  case '^': return node(p, A_BOL, 0, 0);
+  case '$': return node(p, A_EOL, 0, 0);
+  case '.': {
+    bset_t set = {{0}};
+    bset_range(&set, 0, 127);
+    set.w[0] &= ~(((uint64_t)1 << '\n') | ((uint64_t)1 << '\r'));
+    return alt(p, set_node(p, &set), multibyte(p));
+  }
+  case '[':
+    return parse_class(p);
+  case '(': {
+    if (depth >= DEPTH_MAX) { p->bad = true; return 0; }
+    if (p->s < p->e && *p->s == '?') {
+      if (p->e - p->s >= 2 && p->s[1] == ':') p->s += 2;
+      else if (p->e - p->s >= 3 && p->s[1] == '<' && p->s[2] != '=' && p->s[2] != '!') {
+        const char *gt = memchr(p->s, '>', (size_t)(p->e - p->s));
+        if (!gt) { p->bad = true; return 0; }
+        p->s = gt + 1;
+      }
+      else { p->bad = true; return 0; }   /* lookaround */
+    }
+    uint32_t r = parse_alt(p, depth + 1);
+    if (p->s >= p->e || *p->s != ')') { p->bad = true; return 0; }
+    p->s++;
+    return r;
+  }
+  case '\\': {
+    bset_t set;
+    bool neg;
+    if (p->s < p->e && class_escape(*p->s, &set, &neg)) {
+      p->s++;
+      if (!neg) return set_node(p, &set);
+      bset_t inv = {{0}};
+      for (unsigned b = 0; b < 128; b++)
+        if (!bset_has(&set, b)) bset_add(&inv, b);
+      return alt(p, set_node(p, &inv), multibyte(p));
+    }
+    return utf8_node(p, char_escape(p, false));
+  }
+  case '*': case '+': case '?':
+    p->bad = true;   /* nothing to repeat */
+    return 0;
+  default:
+    p->s--;
+    return utf8_node(p, next_cp(p));
+  }
+}
+
+static bool number(parser_t *p, uint32_t *out) {
+  if (p->s >= p->e || *p->s < '0' || *p->s > '9') return false;
+  uint32_t v = 0;
+  while (p->s < p->e && *p->s >= '0' && *p->s <= '9') {
+    v = v * 10 + (uint32_t)(*p->s++ - '0');
+    if (v > REPEAT_MAX) v = REPEAT_MAX + 1;
+  }
+  *out = v;
+  return true;
+}
+
+/* {n}, {n,} or {n,m} at p->s; anything else leaves '{' as a literal. */
+static bool braces(parser_t *p, uint32_t *min, uint32_t *max) {
+  const char *save = p->s++;
+  if (number(p, min)) {
+    *max = *min;
+    if (p->s < p->e && *p->s == ',') {
+      p->s++;
+      if (!number(p, max)) *max = INF;
+    }
+    if (p->s < p->e && *p->s == '}') {
+      p->s++;
+      return true;
+    }
+  }
+  p->s = save;
+  return false;
+}
+
+static uint32_t parse_repeat(parser_t *p, int depth) {
+  uint32_t r = parse_atom(p, depth);
+  while (!p->bad && p->s < p->e) {
+    uint32_t min, max;
+    char c = *p->s;
+    if (c == '*')      { min = 0; max = INF; p->s++; }
+    else if (c == '+') { min = 1; max = INF; p->s++; }
+    else if (c == '?') { min = 0; max = 1;   p->s++; }
+    else if (c != '{' || !braces(p, &min, &max)) break;
+    if (min > REPEAT_MAX || (max != INF && (max > REPEAT_MAX || max < min))) {
+      p->bad = true;
+      return 0;
+    }
+    if (p->s < p->e && *p->s == '?') p->s++;   /* lazy */
+    uint32_t n = node(p, A_REPEAT, r, 0);
+    if (p->bad) return 0;
+    p->ast[n].min = min;
+    p->ast[n].max = max;
+    r = n;
+  }
+  return r;
+}
+
+static uint32_t parse_alt(parser_t *p, int depth) {
+  uint32_t r = 0;
+  while (!p->bad && p->s < p->e && *p->s != '|' && *p->s != ')')
+    r = cat(p, r, parse_repeat(p, depth));
+  if (!p->bad && p->s < p->e && *p->s == '|') {
+    p->s++;
+    r = alt(p, r, parse_alt(p, depth));
+  }
+  return r;
+}
+
+/* ^C{min,max}$ for an ASCII set C, or ^$. */
+static bool as_span(const parser_t *p, uint32_t root, uint32_t *words) {
+  uint32_t items[3], n = 0;
+  uint32_t stack[4], top = 0;
+  stack[top++] = root;
+  while (top) {
+    const ast_t *x = p->ast + stack[--top];
+    if (x->kind == A_CAT) {
+      if (top + 2 > 4) return false;
+      stack[top++] = x->b;
+      stack[top++] = x->a;
+    }
+    else if (x->kind != A_EMPTY) {
+      if (n == 3) return false;
+      items[n++] = (uint32_t)(x - p->ast);
+    }
+  }
+  if (n < 2 || p->ast[items[0]].kind != A_BOL || p->ast[items[n - 1]].kind != A_EOL) return false;
+
+  uint32_t min = 0, max = 0;
+  const bset_t *set = NULL;
+  if (n == 3) {
+    const ast_t *x = p->ast + items[1];
+    min = max = 1;
+    if (x->kind == A_REPEAT) {
+      min = x->min;
+      max = x->max;
+      x = p->ast + x->a;
+    }
+    if (x->kind != A_SET) return false;
+    set = p->sets + x->set;
+    if (set->w[2] || set->w[3]) return false;
+  }
+  memset(words, 0, 11 * sizeof(uint32_t));
+  words[0] = AJSB_PATTERN_SPAN;
+  words[1] = min;
+  words[2] = max;
+  for (unsigned b = 0; set && b < 128; b++)
+    if (bset_has(set, b)) words[3 + (b >> 5)] |= 1u << (b & 31);
+  return true;
+}
+
+/* ── NFA ────────────────────────────────────────────────────────────────── */
+
+enum { N_MATCH, N_SET, N_SPLIT, N_BOL, N_EOL };
+
+typedef struct {
+  uint8_t  kind;
+  uint32_t out, out2;
+  uint32_t set;
+} nstate_t;
+
+typedef struct {
+  nstate_t *st;  uint32_t num, cap;
+  bool      bad;
+} nfa_t;
+
+static uint32_t nstate(nfa_t *n, uint8_t kind, uint32_t out, uint32_t out2) {
+  if (n->bad) return 0;
+  if (n->num >= NFA_MAX || !grow((void **)&n->st, &n->cap, n->num + 1, sizeof(nstate_t))) {
+    n->bad = true;
+    return 0;
+  }
+  nstate_t *s = n->st + n->num;
+  s->kind = kind;
+  s->out = out;
+  s->out2 = out2;
+  s->set = 0;
+  return n->num++;
+}
+
+/* States for ast node a, continuing at out. Returns the entry state. */
+static uint32_t build(const parser_t *p, nfa_t *n, uint32_t a, uint32_t out) {
+  if (n->bad) return 0;
+  const ast_t *x = p->ast + a;
+  switch (x->kind) {
+  case A_EMPTY: return out;
+  case A_SET: {
+    uint32_t s = nstate(n, N_SET, out, 0);
+    if (!n->bad) n->st[s].set = x->set;
+    return s;
+  }
+  case A_BOL: return nstate(n, N_BOL, out, 0);
+  case A_EOL: return nstate(n, N_EOL, out, 0);
+  case A_CAT: return build(p, n, x->a, build(p, n, x->b, out));
+  case A_ALT: return nstate(n, N_SPLIT, build(p, n, x->a, out), build(p, n, x->b, out));
+  case A_REPEAT: {
+    uint32_t tail = out;
+    if (x->max == INF) {
+      uint32_t loop = nstate(n, N_SPLIT, 0, out);
+      uint32_t body = build(p, n, x->a, loop);
+      if (!n->bad) n->st[loop].out = body;
+      tail = loop;
+    }
+    else {
+      for (uint32_t i = x->min; i < x->max && !n->bad; i++)
+        tail = nstate(n, N_SPLIT, build(p, n, x->a, tail), out);
+    }
+    for (uint32_t i = 0; i < x->min && !n->bad; i++) tail = build(p, n, x->a, tail);
+    return tail;
+  }
+  }
+  return 0;
+}
+
+/* ── DFA ────────────────────────────────────────────────────────────────── */
+
+typedef struct {
+  const parser_t *p;
+  const nfa_t    *n;
+  uint32_t        start;
+  uint32_t       *mark;  uint32_t gen;
+  uint32_t       *stack;
+  uint32_t       *cur;   uint32_t num_cur;    /* set being built */
+
+  uint32_t       *items; uint32_t num_items, cap_items;   /* every state's sorted set */
+  uint32_t       *off, *len, *hash;           /* per DFA state */
+  uint32_t       *flags;
+  uint32_t       *next;  uint32_t cap_next;
+  uint32_t        num_states;
+  uint32_t       *slots;                      /* state id + 1 */
+  bool            bad;
+
+  uint8_t         cls[256];
+  uint32_t        rep[256];
+  uint32_t        classes;
+} dfa_t;
+
+/* Add the ε-closure of s to cur. ^ is passed only at the start of the text;
+   $ is kept as a member and resolved by end_match. */
+static void closure(dfa_t *d, uint32_t s, bool bol) {
+  uint32_t top = 0;
+  if (d->mark[s] == d->gen) return;
+  d->mark[s] = d->gen;
+  d->stack[top++] = s;
+  while (top) {
+    const nstate_t *x = d->n->st + d->stack[--top];
+    uint32_t follow[2], nf = 0;
+    switch (x->kind) {
+    case N_SPLIT: follow[nf++] = x->out2; follow[nf++] = x->out; break;
+    case N_BOL:   if (bol) follow[nf++] = x->out; break;
+    default:      d->cur[d->num_cur++] = (uint32_t)(x - d->n->st); break;
+    }
+    for (uint32_t i = 0; i < nf; i++)
+      if (d->mark[follow[i]] != d->gen) {
+        d->mark[follow[i]] = d->gen;
+        d->stack[top++] = follow[i];
+      }
+  }
+}
+
+/* true if a set accepts at the end of the text. */
+static bool end_match(dfa_t *d, const uint32_t *set, uint32_t count, bool bol) {
+  uint32_t top = 0;
+  d->gen++;
+  for (uint32_t i = 0; i < count; i++) {
+    const nstate_t *x = d->n->st + set[i];
+    if (x->kind == N_MATCH) return true;
+    if (x->kind == N_EOL && d->mark[x->out] != d->gen) {
+      d->mark[x->out] = d->gen;
+      d->stack[top++] = x->out;
+    }
+  }
+  while (top) {
+    const nstate_t *x = d->n->st + d->stack[--top];
+    uint32_t follow[2], nf = 0;
+    switch (x->kind) {
+    case N_MATCH: return true;
+    case N_SPLIT: follow[nf++] = x->out2; follow[nf++] = x->out; break;
+    case N_EOL:   follow[nf++] = x->out; break;
+    case N_BOL:   if (bol) follow[nf++] = x->out; break;
+    default: break;
+    }
+    for (uint32_t i = 0; i < nf; i++)
+      if (d->mark[follow[i]] != d->gen) {
+        d->mark[follow[i]] = d->gen;
+        d->stack[top++] = follow[i];
+      }
+  }
+  return false;
+}
+
+static int cmp_u32(const void *a, const void *b) {
+  uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+  return x < y ? -1 : x > y;
+}
+
+/* Intern d->cur as a DFA state; initial states are never shared. */
+static uint32_t intern(dfa_t *d, bool initial) {
+  uint32_t *set = d->cur, count = d->num_cur;
+  if (!count) return 0;
+  for (uint32_t i = 0; i < count; i++)
+    if (d->n->st[set[i]].kind == N_MATCH) {
+      set[0] = set[i];
+      count = 1;
+      break;
+    }
+  qsort(set, count, sizeof(uint32_t), cmp_u32);
+  uint32_t h = ajsb_hash32((const char *)set, count * sizeof(uint32_t));
+  uint32_t mask = DFA_MAX * 2 - 1, slot = h & mask;
+  if (!initial) {
+    for (; d->slots[slot]; slot = (slot + 1) & mask) {
+      uint32_t id = d->slots[slot] - 1;
+      if (d->hash[id] == h && d->len[id] == count &&
+          !memcmp(d->items + d->off[id], set, count * sizeof(uint32_t)))
+        return id;
+    }
+  }
+  uint32_t id = d->num_states;
+  if (id >= DFA_MAX || (uint64_t)(id + 1) * d->classes > TABLE_MAX ||
+      !grow((void **)&d->items, &d->cap_items, d->num_items + count, sizeof(uint32_t)) ||
+      !grow((void **)&d->next, &d->cap_next, (id + 1) * d->classes, sizeof(uint32_t))) {
+    d->bad = true;
+    return 0;
+  }
+  memcpy(d->items + d->num_items, set, count * sizeof(uint32_t));
+  d->off[id] = d->num_items;
+  d->len[id] = count;
+  d->hash[id] = h;
+  d->num_items += count;
+  d->flags[id] = d->n->st[set[0]].kind == N_MATCH ? AJSB_DFA_MATCH
+               : end_match(d, set, count, initial) ? AJSB_DFA_END_MATCH : 0;
+  if (!initial) d->slots[slot] = id + 1;
+  d->num_states++;
+  return id;
+}
+
+/* Byte classes: bytes no set tells apart share a class. */
+static void byte_classes(dfa_t *d) {
+  memset(d->cls, 0, sizeof(d->cls));
+  d->classes = 1;
+  for (uint32_t s = 0; s < d->p->num_sets; s++) {
+    uint16_t remap[512];
+    uint8_t next[256];
+    uint32_t count = 0;
+    memset(remap, 0xFF, sizeof(remap));
+    for (unsigned b = 0; b < 256; b++) {
+      unsigned key = d->cls[b] * 2u + bset_has(d->p->sets + s, b);
+      if (remap[key] == 0xFFFF) remap[key] = (uint16_t)count++;
+      next[b] = (uint8_t)remap[key];
+    }
+    memcpy(d->cls, next, sizeof(next));
+    d->classes = count;
+  }
+  for (unsigned b = 256; b-- > 0;) d->rep[d->cls[b]] = b;
+}
+
+static bool subset_construct(dfa_t *d) {
+  byte_classes(d);
+  d->cur   = (uint32_t *)aml_malloc((size_t)d->n->num * sizeof(uint32_t));
+  d->mark  = (uint32_t *)aml_calloc(d->n->num, sizeof(uint32_t));
+  d->stack = (uint32_t *)aml_malloc((size_t)d->n->num * sizeof(uint32_t));
+  d->off   = (uint32_t *)aml_malloc(DFA_MAX * sizeof(uint32_t));
+  d->len   = (uint32_t *)aml_malloc(DFA_MAX * sizeof(uint32_t));
+  d->hash  = (uint32_t *)aml_malloc(DFA_MAX * sizeof(uint32_t));
+  d->flags = (uint32_t *)aml_malloc(DFA_MAX * sizeof(uint32_t));
+  d->slots = (uint32_t *)aml_calloc(DFA_MAX * 2, sizeof(uint32_t));
+  if (!d->cur || !d->mark || !d->stack || !d->off || !d->len || !d->hash || !d->flags || !d->slots)
+    return false;
+
+  /* state 0 is dead, state 1 the start */
+  d->num_cur = 0;
+  d->off[0] = d->len[0] = d->hash[0] = d->flags[0] = 0;
+  d->num_states = 1;
+  if (!grow((void **)&d->next, &d->cap_next, d->classes, sizeof(uint32_t))) return false;
+  memset(d->next, 0, d->classes * sizeof(uint32_t));
+  d->gen++;
+  closure(d, d->start, true);
+  intern(d, true);
+
+  for (uint32_t id = 1; id < d->num_states && !d->bad; id++) {
+    for (uint32_t c = 0; c < d->classes && !d->bad; c++) {
+      d->gen++;
+      d->num_cur = 0;
+      if (!(d->flags[id] & AJSB_DFA_MATCH)) {
+        for (uint32_t i = 0; i < d->len[id]; i++) {
+          const nstate_t *x = d->n->st + d->items[d->off[id] + i];
+          if (x->kind == N_SET && bset_has(d->p->sets + x->set, d->rep[c])) closure(d, x->out, false);
+        }
+        closure(d, d->start, false);   /* a match may begin at any position */
+      }
+      uint32_t to = d->flags[id] & AJSB_DFA_MATCH ? id : intern(d, false);
+      d->next[id * d->classes + c] = to;
+    }
+  }
+  return !d->bad;
+}
+
+static void dfa_free(dfa_t *d) {
+  aml_free(d->cur);
+  aml_free(d->mark);
+  aml_free(d->stack);
+  aml_free(d->items);
+  aml_free(d->off);
+  aml_free(d->len);
+  aml_free(d->hash);
+  aml_free(d->flags);
+  aml_free(d->next);
+  aml_free(d->slots);
+}
+
+static bool compile_dfa(const parser_t *p, uint32_t root, uint32_t **words, uint32_t *count) {
+  nfa_t n;
+  dfa_t d;
+  memset(&n, 0, sizeof(n));
+  memset(&d, 0, sizeof(d));
+  uint32_t match = nstate(&n, N_MATCH, 0, 0);
+  d.p = p;
+  d.n = &n;
+  d.start = build(p, &n, root, match);
+  bool ok = !n.bad && subset_construct(&d);
+
+  if (ok && !(d.flags[1] & AJSB_DFA_MATCH)) {   /* else it matches every string */
+    uint32_t total = 3 + 64 + d.num_states + d.num_states * d.classes;
+    uint32_t *w = (uint32_t *)aml_calloc(total, sizeof(uint32_t));
+    w[0] = AJSB_PATTERN_DFA;
+    w[1] = d.num_states;
+    w[2] = d.classes;
+    for (unsigned b = 0; b < 256; b++) w[3 + (b >> 2)] |= (uint32_t)d.cls[b] << ((b & 3) * 8);
+    memcpy(w + 3 + 64, d.flags, d.num_states * sizeof(uint32_t));
+    memcpy(w + 3 + 64 + d.num_states, d.next, (size_t)d.num_states * d.classes * sizeof(uint32_t));
+    *words = w;
+    *count = total;
+  }
+  aml_free(n.st);
+  dfa_free(&d);
+  return ok;
+}
+
+/* ── Compiler entry point ───────────────────────────────────────────────── */
+
+bool ajsb_pattern_compile(const char *re, size_t len, uint32_t **words, uint32_t *count) {
+  *words = NULL;
+  *count = 0;
+  parser_t p;
+  memset(&p, 0, sizeof(p));
+  p.s = re;
+  p.e = re + len;
+  node(&p, A_EMPTY, 0, 0);
+  uint32_t root = parse_alt(&p, 0);
+  if (p.s != p.e) p.bad = true;
+
+  uint32_t span[11];
+  bool ok = !p.bad;
+  if (ok && as_span(&p, root, span)) {
+    *words = (uint32_t *)aml_malloc(sizeof(span));
+    memcpy(*words, span, sizeof(span));
+    *count = 11;
+  }
+  else if (ok) ok = compile_dfa(&p, root, words, count);
+  aml_free(p.ast);
+  aml_free(p.sets);
+  return ok;
+}
@@ -0,0 +1,257 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+/* Private layout of ajsb_program_t. Shared by the compiler, the interpreter and
+   anything else that walks a compiled schema. Not installed. */
+
+#ifndef A_JSON_SCHEMA_BUILDER_PROGRAM_H
+#define A_JSON_SCHEMA_BUILDER_PROGRAM_H
+
+#include "a-json-schema-builder-library/ajsb_validate.h"
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* A node is a run of ops starting at its id and ending at AJSB_OP_END.
+   Children (items, property schemas, branches, ref targets) are node ids. */
+typedef enum {
+  AJSB_OP_END = 0,
+  AJSB_OP_FALSE,            /* boolean schema false */
+  AJSB_OP_TYPE,             /* a = AJSB_T_* mask */
+  AJSB_OP_ENUM,             /* a = first entry, b = count, c = membership index or
+                               AJSB_NONE, flags = 1 << AJSB_V_* of every member
+                               (const is an enum of one) */
+  AJSB_OP_MINIMUM,          /* d */
+  AJSB_OP_MAXIMUM,          /* d */
+  AJSB_OP_EXCL_MINIMUM,     /* d */
+  AJSB_OP_EXCL_MAXIMUM,     /* d */
+  AJSB_OP_MIN_ITEMS,        /* a */
+  AJSB_OP_MAX_ITEMS,        /* a */
+  AJSB_OP_UNIQUE_ITEMS,
+  AJSB_OP_ITEMS,            /* a = child */
+  AJSB_OP_PROPERTIES,       /* a = first entry, b = count, c = first hash slot or
+                               AJSB_NONE, bits = log2(slots), flags = AJSB_PF_* */
+  AJSB_OP_ADDITIONAL,       /* a = child; always directly follows PROPERTIES */
+  AJSB_OP_REQUIRED,         /* a = first extra entry, b = extra count, c = required bits */
+  AJSB_OP_ANY_OF,           /* a = first list slot, b = count, flags = AJSB_UF_*,
+                               c = dispatch table or adapt offset */
+  AJSB_OP_ONE_OF,           /* a = first list slot, b = count, flags = AJSB_UF_*,
+                               c = dispatch table */
+  AJSB_OP_ALL_OF,           /* a = first list slot, b = count */
+  AJSB_OP_NOT,              /* a = child */
+  AJSB_OP_REF,              /* a = child */
+  AJSB_OP_FORMAT,           /* a = ajsb_format_t */
+  AJSB_OP_PATTERN           /* a = first list word of the compiled pattern (ajsb_format.h) */
+} ajsb_opcode_t;
+
+/* AJSB_OP_TYPE mask bits */
+enum {
+  AJSB_T_NULL    = 1u << 0,
+  AJSB_T_BOOLEAN = 1u << 1,
+  AJSB_T_OBJECT  = 1u << 2,
+  AJSB_T_ARRAY   = 1u << 3,
+  AJSB_T_NUMBER  = 1u << 4,
+  AJSB_T_STRING  = 1u << 5,
+  AJSB_T_INTEGER = 1u << 6
+};
+
+/* AJSB_OP_PROPERTIES flags */
+enum {
+  AJSB_PF_NO_ADDITIONAL = 1u << 0,  /* additionalProperties: false */
+  AJSB_PF_ADDITIONAL    = 1u << 1   /* AJSB_OP_ADDITIONAL follows */
+};
+
+/* AJSB_OP_ANY_OF / AJSB_OP_ONE_OF flags */
+enum {
+  /* Every branch requires one property whose enum is disjoint from the
+     others', so an object can match only the branch its value names. c is
+     the first list word of [name entry, bits, (value entry + 1, branch) x
+     (1 << bits)], slots probed linearly from the value's hash. */
+  AJSB_UF_DISPATCH = 1u << 0,
+  /* Branches are tried most-matched first when the program has adapt
+     words: c is the first of [hot, matches, count x branches]. hot packs up
+     to four branch numbers (16 bits each, 0xffff unused). */
+  AJSB_UF_ADAPT    = 1u << 1
+};
+
+/* Kinds stored in ajsb_entry_t.node for enum members */
+enum {
+  AJSB_V_STRING = 0,
+  AJSB_V_NUMBER,
+  AJSB_V_TRUE,
+  AJSB_V_FALSE,
+  AJSB_V_NULL,
+  AJSB_V_JSON               /* object/array member as compact JSON text, equal
+                               under json_equal; hash is ajsb_json_hash */
+};
+
+#define AJSB_NONE       UINT32_MAX
+#define AJSB_MPH_DIRECT 0x80000000u  /* displacement word holding a slot, not a seed */
+#define AJSB_REQ_BITS   256          /* required names tracked as bits per object */
+
+typedef struct {
+  uint8_t  op;
+  uint8_t  flags;
+  uint16_t bits;
+  uint32_t a;
+  union {
+    double d;
+    struct { uint32_t b, c; } u;
+  };
+} ajsb_op_t;
+
+/* A string plus its precomputed hash. Used for property names (node = child,
+   aux = required bit + 1 or 0), required names and enum members. Names and
+   string members are stored in canonical form (ajsb_json_canonical), so
+   instance text is canonicalized before it is hashed or compared. */
+typedef struct {
+  uint32_t str;             /* offset into strings */
+  uint32_t len;
+  uint32_t hash;
+  uint32_t node;
+  uint32_t aux;
+} ajsb_entry_t;
+
+struct ajsb_program_s {
+  const ajsb_op_t    *ops;
+  const ajsb_entry_t *entries;
+  const uint32_t     *lists;
+  const char         *strings;
+  uint32_t num_ops;
+  uint32_t num_entries;
+  uint32_t num_lists;
+  uint32_t strings_len;
+  uint32_t root;
+  uint64_t *adapt;          /* match counters for AJSB_UF_ADAPT or NULL; the
+                               only memory validation writes */
+  uint32_t num_adapt;
+};
+
+/* FNV-1a; stable across builds so it can be stored in frozen programs. */
+static inline uint32_t ajsb_hash32(const char *s, size_t len) {
+  uint32_t h = 2166136261u;
+  for (size_t i = 0; i < len; i++) {
+    h ^= (unsigned char)s[i];
+    h *= 16777619u;
+  }
+  return h;
+}
+
+/* 64-bit FNV-1a, for enum membership and uniqueItems. */
+static inline uint64_t ajsb_hash64(const void *s, size_t len) {
+  const unsigned char *b = (const unsigned char *)s;
+  uint64_t h = 14695981039346656037ull;
+  for (size_t i = 0; i < len; i++) {
+    h ^= b[i];
+    h *= 1099511628211ull;
+  }
+  return h;
+}
+
+/* Numbers hash by value, so 1, 1.0 and 1e0 are one key (and -0 is 0). */
+static inline uint64_t ajsb_number_hash(double d) {
+  if (d == 0) d = 0;
+  uint64_t h = ajsb_hash64(&d, sizeof(d));
+  return h ^ (h >> 29) ^ 0x6e756d62ull;
+}
+
+/* Hash of an enum member or instance scalar of kind AJSB_V_* (raw text for
+   strings, "" for true/false/null). Numbers use ajsb_number_hash. */
+static inline uint64_t ajsb_value_hash(uint32_t kind, const char *s, size_t len) {
+  return ajsb_hash64(s, len) + kind;
+}
+
+static inline uint32_t ajsb_mph_hash(uint64_t h, uint32_t seed) {
+  h ^= seed * 0x9e3779b97f4a7c15ull;
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdull;
+  h ^= h >> 33;
+  return (uint32_t)h;
+}
+
+/* Minimal perfect hash over the string and number members of a large enum:
+   words [buckets, n, g[buckets], entry[n]]. A key's bucket word is either
+   AJSB_MPH_DIRECT | slot or a seed for ajsb_mph_hash. Every key maps to a
+   distinct slot; anything else maps to some member and fails the compare. */
+static inline uint32_t ajsb_mph_entry(const uint32_t *mph, uint64_t h) {
+  uint32_t buckets = mph[0], n = mph[1];
+  uint32_t g = mph[2 + (uint32_t)(h >> 32) % buckets];
+  uint32_t slot = g & AJSB_MPH_DIRECT ? g & ~AJSB_MPH_DIRECT : ajsb_mph_hash(h, g) % n;
+  return mph[2 + buckets + slot];
+}
+
+static inline const char *ajsb_entry_str(const ajsb_program_t *prog, const ajsb_entry_t *e) {
+  return prog->strings + e->str;
+}
+
+static inline bool ajsb_entry_eq(const ajsb_program_t *prog, const ajsb_entry_t *e,
+                                 const char *s, size_t len, uint32_t hash) {
+  return e->hash == hash && e->len == len && !memcmp(prog->strings + e->str, s, len);
+}
+
+/* Find a property entry of an AJSB_OP_PROPERTIES op, or NULL. key is
+   canonical and hash is ajsb_hash32 of it. */
+const ajsb_entry_t *ajsb_program_prop(const ajsb_program_t *prog, const ajsb_op_t *op,
+                                      const char *key, size_t len, uint32_t hash);
+
+/* Membership of a string (raw JSON text between the quotes, escaped any
+   way) or number in an AJSB_OP_ENUM op: O(1) through the index when the op
+   has one, otherwise a scan of the precomputed hashes. */
+bool ajsb_program_enum_string(const ajsb_program_t *prog, const ajsb_op_t *op,
+                              const char *s, size_t len);
+bool ajsb_program_enum_number(const ajsb_program_t *prog, const ajsb_op_t *op, double d);
+
+/* Hash that agrees with JSON equality: numbers by value, strings and names
+   however they are escaped, object members in any order. */
+uint64_t ajsb_json_hash(ajson_t *j);
+
+/* ajsb_compile, also returning the schema each node was compiled from:
+   (*nodes)[id] for every node id, NULL elsewhere. Allocated from p. */
+ajsb_program_t *ajsb_compile_nodes(aml_pool_t *p, ajson_t *schema, ajson_t ***nodes);
+
+/* Compile an ECMA-262 "pattern" (UTF-8) into the words described in
+   ajsb_format.h, allocated with aml_malloc. Returns false if it uses syntax
+   outside the supported subset or its DFA is too large, and true with
+   *count 0 if it matches every string. */
+bool ajsb_pattern_compile(const char *re, size_t len, uint32_t **words, uint32_t *count);
+
+/* Validate j against node. ajsb_validate is ajsb_program_run(prog, prog->root, j). */
+bool ajsb_program_run(const ajsb_program_t *prog, uint32_t node, ajson_t *j);
+
+/* Instrumentation hooks (ajsb_instrument.c), present only in AJSB_INSTRUMENT
+   builds. ajsb_profile_of is the profile attached to prog or NULL; a frame
+   from enter is handed back to leave once the node has run. Builders open a
+   scope per call and pass each JSON node they create through
+   ajsb_build_node. */
+#ifdef AJSB_INSTRUMENT
+typedef struct ajsb_profile_s ajsb_profile_t;
+typedef struct { uint64_t start, outer; } ajsb_profile_frame_t;
+ajsb_profile_t *ajsb_profile_of(const ajsb_program_t *prog);
+ajsb_profile_frame_t ajsb_profile_enter(void);
+void ajsb_profile_leave(ajsb_profile_t *pr, uint32_t node, bool ok, ajsb_profile_frame_t f);
+void ajsb_profile_backtracks(const ajsb_program_t *prog, uint32_t node, uint32_t n);
+#define AJSB_PROFILE_BACKTRACKS(prog, node, n) ajsb_profile_backtracks(prog, node, n)
+
+typedef struct {
+  const char *fn;
+  aml_pool_t *p;
+  size_t      size;         /* aml_pool_size on entry */
+  bool        outer;
+} ajsb_build_scope_t;
+ajsb_build_scope_t ajsb_build_enter(const char *fn, aml_pool_t *p);
+void ajsb_build_leave(ajsb_build_scope_t *s);
+ajson_t *ajsb_build_node(ajson_t *j);
+#else
+#define AJSB_PROFILE_BACKTRACKS(prog, node, n) ((void)0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* A_JSON_SCHEMA_BUILDER_PROGRAM_H */
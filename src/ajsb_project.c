@@ -0,0 +1,517 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#include "a-json-schema-builder-library/ajsb_project.h"
+#include "a-json-schema-builder-library/ajsb_format.h"
+#include "ajsb_program.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#define CONJ 8      /* schema nodes, or projection nodes, applied to one value */
+
+/* ── Pointers ───────────────────────────────────────────────────────────── */
+
+/* One token of a projected path; whole marks the end of a pointer. */
+typedef struct pnode_s pnode_t;
+struct pnode_s {
+  const char *token;        /* unescaped */
+  size_t      len;
+  bool        whole;
+  pnode_t    *kids, *next;
+};
+
+struct ajsb_projection_s {
+  const ajsb_program_t *prog;
+  uint8_t              *dom;      /* per node: needs a DOM to check */
+  pnode_t               root;
+};
+
+static pnode_t *kid(aml_pool_t *p, pnode_t *n, const char *token, size_t len) {
+  for (pnode_t *k = n->kids; k; k = k->next)
+    if (k->len == len && !memcmp(k->token, token, len)) return k;
+  pnode_t *k = (pnode_t *)aml_pool_zalloc(p, sizeof(*k));
+  k->token = token;
+  k->len = len;
+  k->next = n->kids;
+  n->kids = k;
+  return k;
+}
+
+static bool add_pointer(aml_pool_t *p, pnode_t *root, const char *ptr) {
+  if (*ptr && *ptr != '/') return false;
+  pnode_t *n = root;
+  while (*ptr) {
+    const char *s = ptr + 1;
+    size_t raw = strcspn(s, "/"), len = 0;
+    char *t = (char *)aml_pool_alloc(p, raw + 1);
+    for (size_t i = 0; i < raw; i++) {
+      if (s[i] != '~') t[len++] = s[i];
+      else if (i + 1 < raw && (s[i + 1] == '0' || s[i + 1] == '1')) t[len++] = s[++i] == '0' ? '~' : '/';
+      else return false;
+    }
+    t[len] = '\0';
+    n = kid(p, n, t, len);
+    ptr = s + raw;
+  }
+  n->whole = true;
+  return true;
+}
+
+/* The projection nodes that apply to one value; whole once any of them
+   ends there (or too many apply to track). */
+typedef struct {
+  const pnode_t *at[CONJ];
+  uint32_t       n;
+  bool           whole;
+} proj_t;
+
+static void proj_add(proj_t *q, const pnode_t *k) {
+  if (q->whole) return;
+  if (k->whole || q->n == CONJ) { q->whole = true; return; }
+  q->at[q->n++] = k;
+}
+
+/* Projection of the member or item named name[0..len). */
+static void proj_step(const proj_t *q, const char *name, size_t len, proj_t *next) {
+  memset(next, 0, sizeof(*next));
+  for (uint32_t i = 0; i < q->n; i++)
+    for (const pnode_t *k = q->at[i]->kids; k; k = k->next)
+      if ((k->len == 1 && k->token[0] == '*') || (k->len == len && !memcmp(k->token, name, len)))
+        proj_add(next, k);
+}
+
+static inline bool projected(const proj_t *q) {
+  return q->whole || q->n;
+}
+
+/* ── Schema context (as in ajsb_decode) ─────────────────────────────────── */
+
+#define FOR_OPS(prog, node, op) \
+  for (const ajsb_op_t *op = (prog)->ops + (node); op->op != AJSB_OP_END; op++)
+
+/* Keywords that compare a value with its siblings or try alternatives. */
+static bool needs_dom(const ajsb_program_t *prog, uint32_t node) {
+  FOR_OPS(prog, node, op) {
+    switch (op->op) {
+    case AJSB_OP_ANY_OF:
+    case AJSB_OP_ONE_OF:
+    case AJSB_OP_NOT:
+    case AJSB_OP_UNIQUE_ITEMS:
+      return true;
+    case AJSB_OP_ENUM:
+      if (op->flags & (1u << AJSB_V_JSON)) return true;
+      break;
+    case AJSB_OP_REQUIRED:
+      if (op->u.b > 64) return true;
+      break;
+    default:
+      break;
+    }
+  }
+  return false;
+}
+
+ajsb_projection_t *ajsb_projection_init(aml_pool_t *p, ajson_t *schema,
+                                        size_t n, const char *const *pointers) {
+  if (!p || !schema || (n && !pointers)) return NULL;
+  ajson_t **nodes;
+  ajsb_program_t *prog = ajsb_compile_nodes(p, schema, &nodes);
+  if (!prog) return NULL;
+
+  ajsb_projection_t *pr = (ajsb_projection_t *)aml_pool_zalloc(p, sizeof(*pr));
+  pr->prog = prog;
+  for (size_t i = 0; i < n; i++)
+    if (!pointers[i] || !add_pointer(p, &pr->root, pointers[i])) return NULL;
+  pr->dom = (uint8_t *)aml_pool_zalloc(p, prog->num_ops);
+  for (uint32_t node = 0; node < prog->num_ops; node++)
+    if (nodes[node]) pr->dom[node] = needs_dom(prog, node);
+  return pr;
+}
+
+/* A value is checked against every node of its context. top holds the nodes
+   it was reached through; $ref and allOf targets are folded into node. When a
+   node needs a DOM (or too many fold in), the value is validated in full. */
+typedef struct {
+  uint32_t top[CONJ], ntop;
+  uint32_t node[CONJ], n;
+  bool     dom;
+} ctx_t;
+
+static void ctx_fold(const ajsb_projection_t *pr, ctx_t *c, uint32_t node) {
+  for (uint32_t i = 0; i < c->n; i++) if (c->node[i] == node) return;
+  if (c->n == CONJ) { c->dom = true; return; }
+  c->node[c->n++] = node;
+  if (pr->dom[node]) c->dom = true;
+  FOR_OPS(pr->prog, node, op) {
+    if (op->op == AJSB_OP_REF) ctx_fold(pr, c, op->a);
+    else if (op->op == AJSB_OP_ALL_OF)
+      for (uint32_t i = 0; i < op->u.b; i++) ctx_fold(pr, c, pr->prog->lists[op->a + i]);
+  }
+}
+
+/* Each parent node contributes at most one child, so top cannot overflow. */
+static void ctx_add(const ajsb_projection_t *pr, ctx_t *c, uint32_t node) {
+  for (uint32_t i = 0; i < c->ntop; i++) if (c->top[i] == node) return;
+  if (c->ntop == CONJ) return;
+  c->top[c->ntop++] = node;
+  ctx_fold(pr, c, node);
+}
+
+/* ── Walker ─────────────────────────────────────────────────────────────── */
+
+typedef struct {
+  const ajsb_projection_t *pr;
+  const ajsb_program_t    *prog;
+  aml_pool_t              *p;
+  const char              *s, *at, *e;
+  ajsb_project_status_t    status;
+  const char              *why;
+  size_t                   offset;
+  uint32_t                 depth;
+} walk_t;
+
+static void fail(walk_t *x, ajsb_project_status_t st, const char *why) {
+  if (x->status != AJSB_PROJECT_OK) return;
+  x->status = st;
+  x->why = why;
+  x->offset = (size_t)(x->at - x->s);
+}
+#define INVALID(x, why) fail((x), AJSB_PROJECT_INVALID, (why))
+#define SYNTAX(x, why)  fail((x), AJSB_PROJECT_SYNTAX_ERROR, (why))
+
+static inline void skip_ws(walk_t *x) {
+  while (x->at < x->e && (*x->at == ' ' || *x->at == '\n' || *x->at == '\r' || *x->at == '\t'))
+    x->at++;
+}
+
+/* ── Skipping ───────────────────────────────────────────────────────────── */
+
+#define ONES  0x0101010101010101ull
+#define HIGHS 0x8080808080808080ull
+
+/* Nonzero exactly when some byte of w is c. */
+static inline uint64_t has_byte(uint64_t w, unsigned char c) {
+  uint64_t v = w ^ (ONES * c);
+  return (v - ONES) & ~v & HIGHS;
+}
+
+/* First '"' or '\\' in [p, e), or e; eight bytes per step. */
+static const char *string_stop(const char *p, const char *e) {
+  for (; e - p >= 8; p += 8) {
+    uint64_t w;
+    memcpy(&w, p, 8);
+    if (has_byte(w, '"') | has_byte(w, '\\')) break;
+  }
+  while (p < e && *p != '"' && *p != '\\') p++;
+  return p;
+}
+
+/* First quote or bracket in [p, e), or e. Clearing 0x20 folds '{' onto '['
+   and '}' onto ']'. */
+static const char *struct_stop(const char *p, const char *e) {
+  for (; e - p >= 8; p += 8) {
+    uint64_t w;
+    memcpy(&w, p, 8);
+    uint64_t f = w & ~(ONES * 0x20);
+    if (has_byte(w, '"') | has_byte(f, '[') | has_byte(f, ']')) break;
+  }
+  while (p < e && *p != '"' && (*p & ~0x20) != '[' && (*p & ~0x20) != ']') p++;
+  return p;
+}
+
+/* At '"'; leaves at after the closing quote. */
+static bool skip_string(walk_t *x) {
+  const char *p = x->at + 1;
+  for (;;) {
+    p = string_stop(p, x->e);
+    if (p >= x->e) { SYNTAX(x, "unterminated string"); return false; }
+    if (*p == '"') break;
+    if (x->e - p < 2) { SYNTAX(x, "unterminated string"); return false; }
+    p += 2;                               /* the escaped byte cannot end it */
+  }
+  x->at = p + 1;
+  return true;
+}
+
+/* Jump over a value, checking only that strings end and brackets pair. */
+static void skip_value(walk_t *x) {
+  char ch = *x->at;
+  if (ch == '"') { skip_string(x); return; }
+  if (ch != '{' && ch != '[') {
+    const char *start = x->at;
+    while (x->at < x->e && !memchr(",:]} \t\r\n\"{[", *x->at, 11)) x->at++;
+    if (x->at == start) SYNTAX(x, "unexpected character");
+    return;
+  }
+  uint64_t curly[AJSB_PROJECT_MAX_DEPTH / 64] = {0};
+  uint32_t depth = 0;
+  const char *p = x->at;
+  for (;;) {
+    p = struct_stop(p, x->e);
+    if (p >= x->e) { x->at = p; SYNTAX(x, "unexpected end of input"); return; }
+    char c = *p;
+    if (c == '"') {
+      x->at = p;
+      if (!skip_string(x)) return;
+      p = x->at;
+      continue;
+    }
+    uint64_t bit = (uint64_t)((c & 0x20) != 0);
+    if ((c & ~0x20) == '[') {
+      if (x->depth + depth >= AJSB_PROJECT_MAX_DEPTH) { x->at = p; INVALID(x, "nesting too deep"); return; }
+      curly[depth >> 6] = (curly[depth >> 6] & ~((uint64_t)1 << (depth & 63))) | bit << (depth & 63);
+      depth++;
+    }
+    else if (!depth || ((curly[(depth - 1) >> 6] >> ((depth - 1) & 63)) & 1) != bit) {
+      x->at = p;
+      SYNTAX(x, "mismatched bracket");
+      return;
+    }
+    else if (!--depth) {
+      x->at = p + 1;
+      return;
+    }
+    p++;
+  }
+}
+
+/* ── Checks ─────────────────────────────────────────────────────────────── */
+
+/* Validate the value at x->at on a DOM of its own text. */
+static void full_value(walk_t *x, const ctx_t *c) {
+  const char *start = x->at;
+  skip_value(x);
+  if (x->status != AJSB_PROJECT_OK) return;
+  size_t len = (size_t)(x->at - start);
+  char *copy = aml_pool_strndup(x->p, start, len);
+  ajson_t *j = ajson_parse(x->p, copy, copy + len);
+  if (!j || ajson_is_error(j)) { x->at = start; SYNTAX(x, "bad JSON"); return; }
+  for (uint32_t i = 0; i < c->ntop; i++)
+    if (!ajsb_program_run(x->prog, c->top[i], j)) {
+      x->at = start;
+      INVALID(x, "value does not match schema");
+      return;
+    }
+}
+
+static bool check_kind(walk_t *x, const ctx_t *c, uint32_t kind) {
+  uint32_t ekind = kind == AJSB_T_OBJECT || kind == AJSB_T_ARRAY ? 1u << AJSB_V_JSON : 0;
+  for (uint32_t i = 0; i < c->n; i++) {
+    FOR_OPS(x->prog, c->node[i], op) {
+      if (op->op == AJSB_OP_FALSE) { INVALID(x, "false schema"); return false; }
+      if (op->op == AJSB_OP_TYPE && !(op->a & kind)) { INVALID(x, "type mismatch"); return false; }
+      if (op->op == AJSB_OP_ENUM && !(op->flags & ekind)) { INVALID(x, "enum mismatch"); return false; }
+    }
+  }
+  return true;
+}
+
+static void walk(walk_t *x, const ctx_t *c, const proj_t *q);
+
+static inline int hex(char ch) {
+  if (ch >= '0' && ch <= '9') return ch - '0';
+  if (ch >= 'a' && ch <= 'f') return ch - 'a' + 10;
+  if (ch >= 'A' && ch <= 'F') return ch - 'A' + 10;
+  return -1;
+}
+
+/* Escapes of a property name, checked before it is unescaped. */
+static bool escapes_ok(const char *s, size_t len) {
+  for (size_t i = 0; i < len; i++) {
+    if (s[i] != '\\') continue;
+    if (++i >= len) return false;
+    if (s[i] == 'u') {
+      for (int k = 1; k <= 4; k++)
+        if (i + k >= len || hex(s[i + k]) < 0) return false;
+      i += 4;
+    }
+    else if (!strchr("\"\\/bfnrt", s[i]) || !s[i]) return false;
+  }
+  return true;
+}
+
+/* Item number as pointer text. */
+static size_t decimal(char *buf, size_t v) {
+  char tmp[24];
+  size_t n = 0;
+  do tmp[n++] = (char)('0' + v % 10); while (v /= 10);
+  for (size_t i = 0; i < n; i++) buf[i] = tmp[n - 1 - i];
+  return n;
+}
+
+static bool next_member(walk_t *x, char close) {
+  skip_ws(x);
+  if (x->at < x->e && *x->at == ',') { x->at++; skip_ws(x); return true; }
+  if (x->at < x->e && *x->at == close) { x->at++; return false; }
+  SYNTAX(x, close == '}' ? "expected ',' or '}'" : "expected ',' or ']'");
+  return false;
+}
+
+/* A member's value: walked if projected, otherwise skipped. */
+static void member_value(walk_t *x, const ctx_t *c, const proj_t *q) {
+  skip_ws(x);
+  if (x->at >= x->e) { SYNTAX(x, "unexpected end of input"); return; }
+  if (projected(q)) walk(x, c, q);
+  else skip_value(x);
+}
+
+static void object_walk(walk_t *x, const ctx_t *c, const proj_t *q) {
+  const ajsb_program_t *prog = x->prog;
+  uint64_t req[CONJ][AJSB_REQ_BITS / 64];
+  uint64_t extra[CONJ];
+  memset(req, 0, sizeof(req));
+  memset(extra, 0, sizeof(extra));
+  const char *start = x->at;
+
+  x->at++;
+  skip_ws(x);
+  if (x->at < x->e && *x->at == '}') x->at++;
+  else do {
+    if (x->at >= x->e || *x->at != '"') { SYNTAX(x, "expected property name"); return; }
+    const char *key = x->at + 1;
+    if (!skip_string(x)) return;
+    size_t len = (size_t)(x->at - 1 - key);
+    skip_ws(x);
+    if (x->at >= x->e || *x->at != ':') { SYNTAX(x, "expected ':'"); return; }
+    x->at++;
+
+    /* pointers match the decoded name, entries the canonical one */
+    proj_t nq;
+    const char *name = key;
+    size_t nlen = len;
+    if (memchr(key, '\\', len)) {
+      if (!escapes_ok(key, len)) { x->at = key; SYNTAX(x, "bad escape"); return; }
+      char *d = (char *)aml_pool_alloc(x->p, 2 * len + 2);
+      proj_step(q, d, ajsb_json_unescape(d, key, len), &nq);
+      char *t = d + len + 1;
+      nlen = ajsb_json_canonical(t, key, len);
+      name = t;
+    }
+    else proj_step(q, key, len, &nq);
+
+    ctx_t next;
+    memset(&next, 0, sizeof(next));
+    uint32_t h = ajsb_hash32(name, nlen);
+    for (uint32_t i = 0; i < c->n; i++) {
+      FOR_OPS(prog, c->node[i], op) {
+        if (op->op == AJSB_OP_PROPERTIES) {
+          const ajsb_entry_t *e = ajsb_program_prop(prog, op, name, nlen, h);
+          if (e) {
+            if (e->aux) req[i][(e->aux - 1) >> 6] |= (uint64_t)1 << ((e->aux - 1) & 63);
+            ctx_add(x->pr, &next, e->node);
+          }
+          else if (op->flags & AJSB_PF_NO_ADDITIONAL) { x->at = key - 1; INVALID(x, "unknown property"); return; }
+          else if (op->flags & AJSB_PF_ADDITIONAL) ctx_add(x->pr, &next, op[1].a);
+        }
+        else if (op->op == AJSB_OP_REQUIRED) {
+          for (uint32_t e = 0; e < op->u.b && e < 64; e++)
+            if (ajsb_entry_eq(prog, prog->entries + op->a + e, name, nlen, h))
+              extra[i] |= (uint64_t)1 << e;
+        }
+      }
+    }
+    member_value(x, &next, &nq);
+    if (x->status != AJSB_PROJECT_OK) return;
+  } while (next_member(x, '}'));
+  if (x->status != AJSB_PROJECT_OK) return;
+
+  for (uint32_t i = 0; i < c->n; i++) {
+    FOR_OPS(prog, c->node[i], op) {
+      if (op->op != AJSB_OP_REQUIRED) continue;
+      uint32_t bits = op->u.c;
+      bool ok = true;
+      for (uint32_t w = 0; bits && ok; w++) {
+        uint64_t want = bits >= 64 ? UINT64_MAX : ((uint64_t)1 << bits) - 1;
+        ok = (req[i][w] & want) == want;
+        bits = bits >= 64 ? bits - 64 : 0;
+      }
+      uint64_t want = op->u.b >= 64 ? UINT64_MAX : ((uint64_t)1 << op->u.b) - 1;
+      if (!ok || (extra[i] & want) != want) {
+        x->at = start;
+        INVALID(x, "missing required property");
+        return;
+      }
+    }
+  }
+}
+
+static void array_walk(walk_t *x, const ctx_t *c, const proj_t *q) {
+  const ajsb_program_t *prog = x->prog;
+  ctx_t next;
+  memset(&next, 0, sizeof(next));
+  for (uint32_t i = 0; i < c->n; i++)
+    FOR_OPS(prog, c->node[i], op)
+      if (op->op == AJSB_OP_ITEMS) ctx_add(x->pr, &next, op->a);
+  const char *start = x->at;
+  size_t count = 0;
+
+  x->at++;
+  skip_ws(x);
+  if (x->at < x->e && *x->at == ']') x->at++;
+  else do {
+    char index[24];
+    proj_t nq;
+    proj_step(q, index, decimal(index, count), &nq);
+    member_value(x, &next, &nq);
+    if (x->status != AJSB_PROJECT_OK) return;
+    count++;
+  } while (next_member(x, ']'));
+  if (x->status != AJSB_PROJECT_OK) return;
+
+  for (uint32_t i = 0; i < c->n; i++)
+    FOR_OPS(prog, c->node[i], op) {
+      if ((op->op == AJSB_OP_MIN_ITEMS && count < op->a) ||
+          (op->op == AJSB_OP_MAX_ITEMS && count > op->a)) {
+        x->at = start;
+        INVALID(x, "item count out of range");
+        return;
+      }
+    }
+}
+
+/* Objects and arrays on a projected path are checked member by member;
+   targets, scalars and anything needing a DOM are validated in full. */
+static void walk(walk_t *x, const ctx_t *c, const proj_t *q) {
+  char ch = *x->at;
+  if (q->whole || c->dom || (ch != '{' && ch != '[')) { full_value(x, c); return; }
+  uint32_t kind = ch == '{' ? AJSB_T_OBJECT : AJSB_T_ARRAY;
+  if (!check_kind(x, c, kind)) return;
+  if (++x->depth > AJSB_PROJECT_MAX_DEPTH) { INVALID(x, "nesting too deep"); return; }
+  if (kind == AJSB_T_OBJECT) object_walk(x, c, q);
+  else array_walk(x, c, q);
+  x->depth--;
+}
+
+ajsb_project_status_t ajsb_project_validate(const ajsb_projection_t *pr, aml_pool_t *p,
+                                            const char *json, size_t len,
+                                            ajsb_project_error_t *err) {
+  walk_t x;
+  memset(&x, 0, sizeof(x));
+  x.pr = pr;
+  x.p = p;
+  x.s = x.at = json;
+  x.e = json ? json + len : json;
+
+  if (!pr || !p || !json) INVALID(&x, "bad arguments");
+  else {
+    x.prog = pr->prog;
+    ctx_t c;
+    memset(&c, 0, sizeof(c));
+    ctx_add(pr, &c, pr->prog->root);
+    proj_t q;
+    memset(&q, 0, sizeof(q));
+    proj_add(&q, &pr->root);
+    member_value(&x, &c, &q);
+    skip_ws(&x);
+    if (x.status == AJSB_PROJECT_OK && x.at != x.e) SYNTAX(&x, "trailing characters");
+  }
+  if (err) {
+    err->why = x.why;
+    err->offset = x.offset;
+  }
+  return x.status;
+}
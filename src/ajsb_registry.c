@@ -0,0 +1,469 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#include "a-json-schema-builder-library/ajsb_registry.h"
+#include "a-json-schema-builder-library/ajsb_link.h"
+#include "a-memory-library/aml_alloc.h"
+#include "ajsb_program.h"
+
+#include <dirent.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct ajsb_registry_gen_s {
+  aml_pool_t             *pool;
+  ajsb_registry_entry_t  *entries;
+  ajsb_link_t           **links;      /* per entry, of the schema as added */
+  size_t                  count, cap;
+  uint32_t               *by_name;    /* entry index + 1, 0 = empty */
+  uint32_t               *by_id;
+  size_t                  mask;
+  uint64_t                number;
+  uint64_t                retired_at; /* registry epoch when replaced */
+  ajsb_registry_gen_t    *next;       /* retired list */
+};
+
+struct ajsb_registry_reader_s {
+  ajsb_registry_t        *r;
+  uint64_t                epoch;      /* atomic; 0 while outside */
+  ajsb_registry_reader_t *next;
+};
+
+struct ajsb_registry_s {
+  ajsb_registry_gen_t    *current;    /* atomic */
+  uint64_t                epoch;      /* atomic, starts at 1 */
+  uint64_t                published;
+  pthread_mutex_t         lock;       /* publishers and reader registration */
+  ajsb_registry_reader_t *readers;
+  ajsb_registry_gen_t    *retired;
+};
+
+/* ── Generations ────────────────────────────────────────────────────────── */
+
+ajsb_registry_gen_t *ajsb_registry_gen_init(void) {
+  aml_pool_t *p = aml_pool_init(65536);
+  ajsb_registry_gen_t *g = (ajsb_registry_gen_t *)aml_pool_zalloc(p, sizeof(*g));
+  g->pool = p;
+  return g;
+}
+
+void ajsb_registry_gen_destroy(ajsb_registry_gen_t *g) {
+  if (g) aml_pool_destroy(g->pool);
+}
+
+aml_pool_t *ajsb_registry_gen_pool(ajsb_registry_gen_t *g) { return g ? g->pool : NULL; }
+
+static const char *root_id(aml_pool_t *p, ajson_t *schema) {
+  ajson_t *id = ajson_is_object(schema) ? ajsono_scan(schema, "$id") : NULL;
+  return id && ajson_is_string(id) ? ajson_to_strd(p, id, NULL) : NULL;
+}
+
+bool ajsb_registry_gen_add(ajsb_registry_gen_t *g, const char *name, ajson_t *schema) {
+  if (!g || !schema || ajson_is_error(schema)) return false;
+  const char *id = root_id(g->pool, schema);
+  if (!name) name = id;
+  if (!name || !*name) return false;
+  for (size_t i = 0; i < g->count; i++) {
+    const ajsb_registry_entry_t *e = g->entries + i;
+    if (!strcmp(e->name, name) || (id && e->id && !strcmp(e->id, id))) return false;
+  }
+  if (g->count == g->cap) {
+    size_t cap = g->cap ? g->cap * 2 : 16;
+    ajsb_registry_entry_t *n = (ajsb_registry_entry_t *)aml_pool_zalloc(g->pool, cap * sizeof(*n));
+    if (g->count) memcpy(n, g->entries, g->count * sizeof(*n));
+    g->entries = n;
+    g->cap = cap;
+  }
+  ajsb_registry_entry_t *e = g->entries + g->count++;
+  e->name = aml_pool_strdup(g->pool, name);
+  e->id = id;
+  e->schema = schema;
+  e->bundled = schema;
+  return true;
+}
+
+bool ajsb_registry_gen_add_file(ajsb_registry_gen_t *g, const char *name, const char *path) {
+  if (!g || !path) return false;
+  FILE *fp = fopen(path, "rb");
+  if (!fp) return false;
+  char *s = NULL;
+  if (!fseek(fp, 0, SEEK_END)) {
+    long n = ftell(fp);
+    if (n >= 0 && !fseek(fp, 0, SEEK_SET)) {
+      s = (char *)aml_pool_alloc(g->pool, (size_t)n + 1);
+      if (fread(s, 1, (size_t)n, fp) != (size_t)n) s = NULL;
+      else s[n] = '\0';
+    }
+  }
+  fclose(fp);
+  return s && ajsb_registry_gen_add(g, name, ajson_parse_string(g->pool, s));
+}
+
+static int by_file_name(const void *a, const void *b) {
+  return strcmp(*(const char *const *)a, *(const char *const *)b);
+}
+
+size_t ajsb_registry_gen_load_dir(ajsb_registry_gen_t *g, const char *dir) {
+  if (!g || !dir) return (size_t)-1;
+  DIR *d = opendir(dir);
+  if (!d) return (size_t)-1;
+  size_t n = 0, cap = 0;
+  char **names = NULL;
+  for (struct dirent *de; (de = readdir(d));) {
+    size_t len = strlen(de->d_name);
+    if (len <= 5 || de->d_name[0] == '.' || strcmp(de->d_name + len - 5, ".json")) continue;
+    if (n == cap) {
+      cap = cap ? cap * 2 : 32;
+      names = (char **)aml_realloc(names, cap * sizeof(*names));
+    }
+    names[n++] = aml_pool_strdup(g->pool, de->d_name);
+  }
+  closedir(d);
+  /* directory order is arbitrary; keep generations reproducible */
+  if (n) qsort(names, n, sizeof(*names), by_file_name);
+  size_t added = 0;
+  for (size_t i = 0; i < n; i++) {
+    char *path = aml_pool_strdupf(g->pool, "%s/%s", dir, names[i]);
+    names[i][strlen(names[i]) - 5] = '\0';
+    added += ajsb_registry_gen_add_file(g, names[i], path);
+  }
+  aml_free(names);
+  return added;
+}
+
+/* ── Lookup ─────────────────────────────────────────────────────────────── */
+
+static uint32_t *probe(const ajsb_registry_gen_t *g, uint32_t *tab, const char *key, bool by_id) {
+  for (size_t i = ajsb_hash32(key, strlen(key)) & g->mask;; i = (i + 1) & g->mask) {
+    if (!tab[i]) return tab + i;
+    const ajsb_registry_entry_t *e = g->entries + tab[i] - 1;
+    if (!strcmp(by_id ? e->id : e->name, key)) return tab + i;
+  }
+}
+
+static const ajsb_registry_entry_t *find(const ajsb_registry_gen_t *g, const char *key) {
+  if (!g->by_name) {      /* not published yet */
+    for (size_t i = 0; i < g->count; i++)
+      if (!strcmp(g->entries[i].name, key)) return g->entries + i;
+    for (size_t i = 0; i < g->count; i++)
+      if (g->entries[i].id && !strcmp(g->entries[i].id, key)) return g->entries + i;
+    return NULL;
+  }
+  uint32_t *s = probe(g, g->by_name, key, false);
+  if (!*s) s = probe(g, g->by_id, key, true);
+  return *s ? g->entries + *s - 1 : NULL;
+}
+
+const ajsb_registry_entry_t *ajsb_registry_get(const ajsb_registry_gen_t *g, const char *key) {
+  return g && key ? find(g, key) : NULL;
+}
+
+size_t ajsb_registry_count(const ajsb_registry_gen_t *g) { return g ? g->count : 0; }
+
+const ajsb_registry_entry_t *ajsb_registry_at(const ajsb_registry_gen_t *g, size_t i) {
+  return g && i < g->count ? g->entries + i : NULL;
+}
+
+uint64_t ajsb_registry_generation(const ajsb_registry_gen_t *g) { return g ? g->number : 0; }
+
+/* Resource root with this absolute URI (no fragment). Root "$id"s are
+   indexed; embedded resources are found through each document's link. */
+static ajson_t *resource(const ajsb_registry_gen_t *g, const char *uri) {
+  const ajsb_registry_entry_t *e = find(g, uri);
+  if (e && e->id && !strcmp(e->id, uri)) return e->schema;
+  for (size_t i = 0; i < g->count; i++) {
+    ajson_t *r = g->links && g->links[i] ? ajsb_link_resource(g->links[i], uri) : NULL;
+    if (r) return r;
+  }
+  return NULL;
+}
+
+static ajson_t *walk_pointer(aml_pool_t *p, ajson_t *node, const char *ptr) {
+  while (node && *ptr == '/') {
+    const char *end = strchr(++ptr, '/');
+    size_t len = end ? (size_t)(end - ptr) : strlen(ptr);
+    char *seg = (char *)aml_pool_alloc(p, len + 1), *w = seg;
+    for (size_t i = 0; i < len; i++) {
+      if (ptr[i] == '~' && i + 1 < len && (ptr[i + 1] == '0' || ptr[i + 1] == '1'))
+        *w++ = ptr[++i] == '0' ? '~' : '/';
+      else
+        *w++ = ptr[i];
+    }
+    *w = '\0';
+    if (ajson_is_object(node)) {
+      node = ajsono_scan(node, seg);
+    } else if (ajson_is_array(node)) {
+      char *stop;
+      unsigned long idx = strtoul(seg, &stop, 10);
+      ajsona_t *a = *seg && !*stop ? ajsona_first(node) : NULL;
+      for (; a && idx; idx--) a = ajsona_next(a);
+      node = a ? a->value : NULL;
+    } else {
+      node = NULL;
+    }
+    ptr += len;
+  }
+  return *ptr ? NULL : node;
+}
+
+/* "$anchor" / "$dynamicAnchor" name inside the resource at s. */
+static ajson_t *find_anchor(ajson_t *s, const char *name, bool top) {
+  if (ajson_is_array(s)) {
+    for (ajsona_t *a = ajsona_first(s); a; a = ajsona_next(a)) {
+      ajson_t *r = find_anchor(a->value, name, false);
+      if (r) return r;
+    }
+    return NULL;
+  }
+  if (!ajson_is_object(s) || (!top && ajsono_scan(s, "$id"))) return NULL;
+  static const char *const anchors[] = {"$anchor", "$dynamicAnchor"};
+  for (size_t i = 0; i < 2; i++) {
+    ajson_t *a = ajsono_scan(s, anchors[i]);
+    if (a && ajson_is_string(a) && !strcmp(ajson_to_str(a, ""), name)) return s;
+  }
+  for (ajsono_t *m = ajsono_first(s); m; m = ajsono_next(m)) {
+    if (!strcmp(m->key, "enum") || !strcmp(m->key, "const") || !strcmp(m->key, "default") ||
+        !strcmp(m->key, "examples"))
+      continue;
+    ajson_t *r = find_anchor(m->value, name, false);
+    if (r) return r;
+  }
+  return NULL;
+}
+
+ajson_t *ajsb_registry_resolve(const ajsb_registry_gen_t *g, const char *uri) {
+  if (!g || !uri) return NULL;
+  const char *hash = strchr(uri, '#');
+  size_t len = hash ? (size_t)(hash - uri) : strlen(uri);
+  char buf[512];
+  char *base = len < sizeof(buf) ? buf : (char *)aml_malloc(len + 1);
+  memcpy(base, uri, len);
+  base[len] = '\0';
+  ajson_t *r = resource(g, base);
+  if (base != buf) aml_free(base);
+  if (!r || !hash || !hash[1]) return r;
+  if (hash[1] == '/') {
+    aml_pool_t *tmp = aml_pool_init(256);
+    r = walk_pointer(tmp, r, hash + 1);
+    aml_pool_destroy(tmp);
+    return r;
+  }
+  return find_anchor(r, hash + 1, true);
+}
+
+/* ── Bundling ───────────────────────────────────────────────────────────── */
+
+/* Absolute URI (without fragment) for ref written in a document whose root
+   "$id" is base; NULL for same-document references. */
+static char *absolute(aml_pool_t *p, const char *base, const char *ref) {
+  const char *hash = strchr(ref, '#');
+  size_t len = hash ? (size_t)(hash - ref) : strlen(ref);
+  if (!len) return NULL;
+  const char *colon = memchr(ref, ':', len), *slash = memchr(ref, '/', len);
+  if (colon && (!slash || colon < slash)) return aml_pool_strndup(p, ref, len);
+  if (!base) return NULL;
+  size_t keep;
+  if (ref[0] == '/') {              /* authority of base + path */
+    const char *auth = strstr(base, "://");
+    const char *path = auth ? strchr(auth + 3, '/') : NULL;
+    keep = path ? (size_t)(path - base) : strlen(base);
+  } else {
+    const char *last = strrchr(base, '/');
+    keep = last ? (size_t)(last - base) + 1 : 0;
+  }
+  char *r = (char *)aml_pool_alloc(p, keep + len + 1);
+  memcpy(r, base, keep);
+  memcpy(r + keep, ref, len);
+  r[keep + len] = '\0';
+  return r;
+}
+
+/* node with "$id" set to uri (a copy if it had a different one). */
+static ajson_t *with_id(aml_pool_t *p, ajson_t *node, const char *uri) {
+  const char *id = root_id(p, node);
+  if (!ajson_is_object(node) || (id && !strcmp(id, uri))) return node;
+  ajson_t *r = ajsono(p);
+  ajsono_append(r, "$id", ajson_str(p, uri), /*copy_key=*/false);
+  for (ajsono_t *m = ajsono_first(node); m; m = ajsono_next(m))
+    if (strcmp(m->key, "$id")) ajsono_append(r, m->key, m->value, /*copy_key=*/false);
+  return r;
+}
+
+/* Sets e->bundled to the schema with every registry resource it reaches
+   embedded; returns its link. */
+static ajsb_link_t *bundle(ajsb_registry_gen_t *g, size_t i) {
+  ajsb_registry_entry_t *e = g->entries + i;
+  aml_pool_t *p = g->pool;
+  ajsb_link_t *l = g->links[i];
+  ajson_t *defs = NULL, *root = e->schema;
+  ajson_t *old_defs = ajson_is_object(root) ? ajsono_scan(root, "$defs") : NULL;
+  if (old_defs && !ajson_is_object(old_defs)) return l;
+
+  /* each round embeds what the previous one still could not resolve */
+  for (size_t round = 0; round <= g->count && ajson_is_object(root); round++) {
+    const ajsb_link_issue_t *issues;
+    size_t n = ajsb_link_unresolved(l, &issues);
+    bool added = false;
+    for (size_t k = 0; k < n; k++) {
+      char *uri = absolute(p, e->id, issues[k].ref);
+      if (!uri || (defs && ajsono_scan(defs, uri)) || (old_defs && ajsono_scan(old_defs, uri))) continue;
+      ajson_t *target = resource(g, uri);
+      if (!target || target == e->schema) continue;
+      if (!defs) {
+        defs = ajsono(p);
+        for (ajsono_t *m = old_defs ? ajsono_first(old_defs) : NULL; m; m = ajsono_next(m))
+          ajsono_append(defs, m->key, m->value, /*copy_key=*/false);
+      }
+      ajsono_append(defs, uri, with_id(p, target, uri), /*copy_key=*/false);
+      added = true;
+    }
+    if (!added) break;
+    if (root == e->schema) {
+      root = ajsono(p);
+      for (ajsono_t *m = ajsono_first(e->schema); m; m = ajsono_next(m))
+        if (strcmp(m->key, "$defs")) ajsono_append(root, m->key, m->value, /*copy_key=*/false);
+      ajsono_append(root, "$defs", defs, /*copy_key=*/false);
+    }
+    l = ajsb_link(p, root);
+  }
+  e->bundled = root;
+  return l;
+}
+
+static void finish(ajsb_registry_gen_t *g) {
+  aml_pool_t *p = g->pool;
+  g->links = (ajsb_link_t **)aml_pool_zalloc(p, (g->count + 1) * sizeof(ajsb_link_t *));
+  /* links of the schemas as added, so resource() sees embedded "$id"s */
+  for (size_t i = 0; i < g->count; i++) g->links[i] = ajsb_link(p, g->entries[i].schema);
+
+  g->mask = 15;
+  while (g->mask + 1 < g->count * 2) g->mask = g->mask * 2 + 1;
+  g->by_name = (uint32_t *)aml_pool_zalloc(p, (g->mask + 1) * sizeof(uint32_t));
+  g->by_id = (uint32_t *)aml_pool_zalloc(p, (g->mask + 1) * sizeof(uint32_t));
+  for (size_t i = 0; i < g->count; i++) {
+    *probe(g, g->by_name, g->entries[i].name, false) = (uint32_t)i + 1;
+    if (g->entries[i].id) *probe(g, g->by_id, g->entries[i].id, true) = (uint32_t)i + 1;
+  }
+
+  for (size_t i = 0; i < g->count; i++) {
+    ajsb_registry_entry_t *e = g->entries + i;
+    e->resolved = ajsb_link_ok(bundle(g, i));
+    e->program = ajsb_compile(p, e->bundled);
+  }
+}
+
+/* ── Registry ───────────────────────────────────────────────────────────── */
+
+ajsb_registry_t *ajsb_registry_init(void) {
+  ajsb_registry_t *r = (ajsb_registry_t *)aml_calloc(1, sizeof(*r));
+  r->epoch = 1;
+  pthread_mutex_init(&r->lock, NULL);
+  return r;
+}
+
+/* Frees retired generations no reader can still see; returns how many stay. */
+static size_t reclaim_locked(ajsb_registry_t *r) {
+  uint64_t oldest = UINT64_MAX;
+  for (ajsb_registry_reader_t *rd = r->readers; rd; rd = rd->next) {
+    uint64_t e = __atomic_load_n(&rd->epoch, __ATOMIC_SEQ_CST);
+    if (e && e < oldest) oldest = e;
+  }
+  size_t held = 0;
+  for (ajsb_registry_gen_t **pg = &r->retired; *pg;) {
+    ajsb_registry_gen_t *g = *pg;
+    if (g->retired_at <= oldest) {
+      *pg = g->next;
+      ajsb_registry_gen_destroy(g);
+    } else {
+      pg = &g->next;
+      held++;
+    }
+  }
+  return held;
+}
+
+bool ajsb_registry_publish(ajsb_registry_t *r, ajsb_registry_gen_t *g) {
+  if (!r || !g) return false;
+  finish(g);
+  pthread_mutex_lock(&r->lock);
+  g->number = ++r->published;
+  ajsb_registry_gen_t *old = __atomic_exchange_n(&r->current, g, __ATOMIC_SEQ_CST);
+  if (old) {
+    /* a reader that saw the new epoch entered after the exchange */
+    old->retired_at = __atomic_add_fetch(&r->epoch, 1, __ATOMIC_SEQ_CST);
+    old->next = r->retired;
+    r->retired = old;
+  }
+  reclaim_locked(r);
+  pthread_mutex_unlock(&r->lock);
+  return true;
+}
+
+size_t ajsb_registry_reclaim(ajsb_registry_t *r) {
+  if (!r) return 0;
+  pthread_mutex_lock(&r->lock);
+  size_t held = reclaim_locked(r);
+  pthread_mutex_unlock(&r->lock);
+  return held;
+}
+
+void ajsb_registry_destroy(ajsb_registry_t *r) {
+  if (!r) return;
+  ajsb_registry_gen_destroy(r->current);
+  while (r->retired) {
+    ajsb_registry_gen_t *next = r->retired->next;
+    ajsb_registry_gen_destroy(r->retired);
+    r->retired = next;
+  }
+  while (r->readers) {
+    ajsb_registry_reader_t *next = r->readers->next;
+    aml_free(r->readers);
+    r->readers = next;
+  }
+  pthread_mutex_destroy(&r->lock);
+  aml_free(r);
+}
+
+/* ── Readers ────────────────────────────────────────────────────────────── */
+
+ajsb_registry_reader_t *ajsb_registry_reader_init(ajsb_registry_t *r) {
+  if (!r) return NULL;
+  ajsb_registry_reader_t *rd = (ajsb_registry_reader_t *)aml_calloc(1, sizeof(*rd));
+  rd->r = r;
+  pthread_mutex_lock(&r->lock);
+  rd->next = r->readers;
+  r->readers = rd;
+  pthread_mutex_unlock(&r->lock);
+  return rd;
+}
+
+void ajsb_registry_reader_destroy(ajsb_registry_reader_t *rd) {
+  if (!rd) return;
+  ajsb_registry_t *r = rd->r;
+  pthread_mutex_lock(&r->lock);
+  for (ajsb_registry_reader_t **p = &r->readers; *p; p = &(*p)->next) {
+    if (*p == rd) {
+      *p = rd->next;
+      break;
+    }
+  }
+  pthread_mutex_unlock(&r->lock);
+  aml_free(rd);
+}
+
+const ajsb_registry_gen_t *ajsb_registry_enter(ajsb_registry_reader_t *rd) {
+  if (!rd) return NULL;
+  /* Publish the epoch before reading current: a publisher that misses this
+     store scans after its exchange, so the load below sees the new one. */
+  __atomic_store_n(&rd->epoch, __atomic_load_n(&rd->r->epoch, __ATOMIC_SEQ_CST), __ATOMIC_SEQ_CST);
+  return __atomic_load_n(&rd->r->current, __ATOMIC_SEQ_CST);
+}
+
+void ajsb_registry_leave(ajsb_registry_reader_t *rd) {
+  if (rd) __atomic_store_n(&rd->epoch, 0, __ATOMIC_RELEASE);
+}
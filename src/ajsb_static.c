@@ -0,0 +1,43 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#include "a-json-schema-builder-library/ajsb_static.h"
+
+#include <pthread.h>
+
+/* Programs for static schemas live as long as the process, like the schemas. */
+static pthread_mutex_t static_lock = PTHREAD_MUTEX_INITIALIZER;
+static aml_pool_t     *static_pool = NULL;
+
+static ajson_t *parse(aml_pool_t *p, const ajsb_static_t *s) {
+  char *text = (char *)aml_pool_dup(p, s->json, s->len + 1);
+  ajson_t *j = ajson_parse_string(p, text);
+  return j && !ajson_is_error(j) ? j : NULL;
+}
+
+const ajsb_program_t *ajsb_static_program(ajsb_static_t *s) {
+  if (!s || !s->json) return NULL;
+  const ajsb_program_t *prog = __atomic_load_n(&s->prog, __ATOMIC_ACQUIRE);
+  if (prog || __atomic_load_n(&s->failed, __ATOMIC_RELAXED)) return prog;
+
+  /* a text that does not compile is tried once, not on every call */
+  pthread_mutex_lock(&static_lock);
+  prog = s->prog;
+  if (!prog && !s->failed) {
+    if (!static_pool) static_pool = aml_pool_init(16384);
+    ajson_t *j = parse(static_pool, s);
+    prog = j ? ajsb_compile(static_pool, j) : NULL;
+    if (prog) __atomic_store_n(&s->prog, prog, __ATOMIC_RELEASE);
+    else      __atomic_store_n(&s->failed, true, __ATOMIC_RELAXED);
+  }
+  pthread_mutex_unlock(&static_lock);
+  return prog;
+}
+
+ajson_t *ajsb_static_parse(aml_pool_t *p, const ajsb_static_t *s) {
+  if (!p || !s || !s->json) return NULL;
+  return parse(p, s);
+}
@@ -0,0 +1,592 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#include "a-json-schema-builder-library/ajsb_stream.h"
+#include "ajsb_program.h"
+#include "a-json-schema-builder-library/ajsb_format.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CONJ        4       /* schema nodes that must all hold for one value */
+#define TEXT_CAP    1024    /* longest key/string/number checked byte by byte */
+#define PREFIX_MAX  64      /* longer property lists and enums are checked per key/string */
+#define ALL_TYPES   0x7fu
+
+/* A value is governed by the conjunction of up to CONJ nodes ($ref and allOf
+   targets are folded in). Dropping a node only loosens the check. */
+typedef struct {
+  uint32_t node[CONJ];
+  uint32_t n;
+} ctx_t;
+
+enum { FRAME_OBJECT, FRAME_ARRAY };
+
+typedef struct {
+  uint8_t  kind;
+  ctx_t    ctx;
+  uint32_t count;
+  bool     lost;            /* a key was too long to match; skip required */
+  uint64_t req[CONJ][AJSB_REQ_BITS / 64];
+  uint64_t extra[CONJ];
+} frame_t;
+
+enum {
+  S_VALUE,          /* expecting a value */
+  S_OBJ_FIRST,      /* after '{': key or '}' */
+  S_OBJ_KEY,        /* after ',': key */
+  S_COLON,
+  S_OBJ_NEXT,       /* after member: ',' or '}' */
+  S_ARR_FIRST,      /* after '[': value or ']' */
+  S_ARR_NEXT,       /* after item: ',' or ']' */
+  S_STRING,         /* inside a key or string value */
+  S_NUMBER,
+  S_LITERAL,
+  S_DONE
+};
+
+enum { N_SIGN, N_ZERO, N_INT, N_FRAC0, N_FRAC, N_EXP0, N_EXPS, N_EXP };
+
+struct ajsb_stream_s {
+  const ajsb_program_t *prog;
+  ajsb_stream_status_t  status;
+  const char           *error;
+  size_t                offset;
+
+  uint8_t               state;
+  uint8_t               num;         /* N_* */
+  uint8_t               esc;         /* 1 after '\\', 2..5 inside \uXXXX */
+  bool                  in_key;
+  const char           *lit;
+  uint8_t               lit_pos;
+
+  ctx_t                 cur;         /* context of the value being read */
+  uint32_t              depth;
+  frame_t              *frames;
+
+  char                 *text;
+  size_t                text_len;
+  bool                  text_overflow;
+};
+
+/* ── Schema queries ─────────────────────────────────────────────────────── */
+
+#define FOR_OPS(prog, node, op) \
+  for (const ajsb_op_t *op = (prog)->ops + (node); op->op != AJSB_OP_END; op++)
+
+static const ajsb_op_t *find_op(const ajsb_program_t *prog, uint32_t node, uint8_t opcode) {
+  FOR_OPS(prog, node, op) if (op->op == opcode) return op;
+  return NULL;
+}
+
+static void ctx_add(const ajsb_program_t *prog, ctx_t *c, uint32_t node) {
+  for (uint32_t i = 0; i < c->n; i++) if (c->node[i] == node) return;
+  if (c->n == CONJ) return;
+  c->node[c->n++] = node;
+  FOR_OPS(prog, node, op) {
+    if (op->op == AJSB_OP_REF) ctx_add(prog, c, op->a);
+    else if (op->op == AJSB_OP_ALL_OF)
+      for (uint32_t i = 0; i < op->u.b; i++) ctx_add(prog, c, prog->lists[op->a + i]);
+  }
+}
+
+/* INTEGER means integral numbers are allowed, NUMBER means any number is. */
+static inline uint32_t widen(uint32_t m) {
+  return (m & AJSB_T_NUMBER) ? (m | AJSB_T_INTEGER) : m;
+}
+
+static uint32_t node_mask(const ajsb_program_t *prog, uint32_t node, int depth) {
+  if (depth > 8) return ALL_TYPES;
+  uint32_t mask = ALL_TYPES;
+  FOR_OPS(prog, node, op) {
+    switch (op->op) {
+    case AJSB_OP_FALSE: return 0;
+    case AJSB_OP_TYPE:  mask &= widen(op->a); break;
+    case AJSB_OP_REF:   mask &= node_mask(prog, op->a, depth + 1); break;
+    case AJSB_OP_ALL_OF:
+      for (uint32_t i = 0; i < op->u.b; i++) mask &= node_mask(prog, prog->lists[op->a + i], depth + 1);
+      break;
+    case AJSB_OP_ANY_OF:
+    case AJSB_OP_ONE_OF: {
+      uint32_t any = 0;
+      for (uint32_t i = 0; i < op->u.b; i++) any |= node_mask(prog, prog->lists[op->a + i], depth + 1);
+      mask &= any;
+      break;
+    }
+    default: break;
+    }
+  }
+  return mask;
+}
+
+static uint32_t enum_kind_bit(uint32_t kind) {
+  switch (kind) {
+  case AJSB_T_STRING:  return 1u << AJSB_V_STRING;
+  case AJSB_T_NUMBER:  return 1u << AJSB_V_NUMBER;
+  case AJSB_T_BOOLEAN: return (1u << AJSB_V_TRUE) | (1u << AJSB_V_FALSE);
+  case AJSB_T_NULL:    return 1u << AJSB_V_NULL;
+  default:             return 1u << AJSB_V_JSON;
+  }
+}
+
+/* ── Failure reporting ──────────────────────────────────────────────────── */
+
+static void fail(ajsb_stream_t *s, ajsb_stream_status_t st, const char *why) {
+  if (s->status == AJSB_STREAM_INVALID || s->status == AJSB_STREAM_SYNTAX_ERROR) return;
+  s->status = st;
+  s->error = why;
+}
+#define INVALID(s, why) fail((s), AJSB_STREAM_INVALID, (why))
+#define SYNTAX(s, why)  fail((s), AJSB_STREAM_SYNTAX_ERROR, (why))
+
+static inline bool failed(const ajsb_stream_t *s) {
+  return s->status == AJSB_STREAM_INVALID || s->status == AJSB_STREAM_SYNTAX_ERROR;
+}
+
+/* ── Checks on the value being read ─────────────────────────────────────── */
+
+static void check_start(ajsb_stream_t *s, uint32_t kind) {
+  const ajsb_program_t *prog = s->prog;
+  uint32_t want = kind == AJSB_T_NUMBER ? (AJSB_T_NUMBER | AJSB_T_INTEGER) : kind;
+  for (uint32_t i = 0; i < s->cur.n; i++) {
+    if (!(node_mask(prog, s->cur.node[i], 0) & want)) { INVALID(s, "type mismatch"); return; }
+    FOR_OPS(prog, s->cur.node[i], op) {
+      if (op->op == AJSB_OP_ENUM && !(op->flags & enum_kind_bit(kind))) { INVALID(s, "enum mismatch"); return; }
+    }
+  }
+}
+
+/* Text before the first escape, which is already canonical: the part of an
+   unfinished string that can be compared with entries. */
+static size_t plain_len(const char *t, size_t len) {
+  const char *b = (const char *)memchr(t, '\\', len);
+  return b ? (size_t)(b - t) : len;
+}
+
+/* complete = false: can the text still grow into a member? Enums longer than
+   PREFIX_MAX are only checked once the string ends. */
+static bool enum_match(const ajsb_program_t *prog, const ajsb_op_t *op,
+                       const char *t, size_t len, bool complete) {
+  if (complete) return ajsb_program_enum_string(prog, op, t, len);
+  if (op->u.b > PREFIX_MAX) return true;
+  len = plain_len(t, len);
+  for (uint32_t i = 0; i < op->u.b; i++) {
+    const ajsb_entry_t *e = prog->entries + op->a + i;
+    if (e->node == AJSB_V_STRING && e->len >= len && !memcmp(ajsb_entry_str(prog, e), t, len))
+      return true;
+  }
+  return false;
+}
+
+static void check_string(ajsb_stream_t *s, bool complete) {
+  if (s->text_overflow) return;
+  for (uint32_t i = 0; i < s->cur.n; i++)
+    FOR_OPS(s->prog, s->cur.node[i], op) {
+      if (op->op == AJSB_OP_ENUM &&
+          !enum_match(s->prog, op, s->text, s->text_len, complete)) {
+        INVALID(s, "enum mismatch");
+        return;
+      }
+      if (!complete) continue;
+      if (op->op == AJSB_OP_FORMAT &&
+          !ajsb_format_check_json((ajsb_format_t)op->a, s->text, s->text_len)) {
+        INVALID(s, "format mismatch");
+        return;
+      }
+      if (op->op == AJSB_OP_PATTERN &&
+          !ajsb_pattern_match_json(s->prog->lists + op->a, s->text, s->text_len)) {
+        INVALID(s, "pattern mismatch");
+        return;
+      }
+    }
+}
+
+static void check_key_prefix(ajsb_stream_t *s) {
+  if (s->text_overflow) return;
+  frame_t *f = s->frames + s->depth - 1;
+  for (uint32_t i = 0; i < f->ctx.n; i++) {
+    const ajsb_op_t *op = find_op(s->prog, f->ctx.node[i], AJSB_OP_PROPERTIES);
+    if (!op || !(op->flags & AJSB_PF_NO_ADDITIONAL) || op->u.b > PREFIX_MAX) continue;
+    bool any = false;
+    size_t len = plain_len(s->text, s->text_len);
+    for (uint32_t e = 0; e < op->u.b && !any; e++) {
+      const ajsb_entry_t *en = s->prog->entries + op->a + e;
+      any = en->len >= len && !memcmp(ajsb_entry_str(s->prog, en), s->text, len);
+    }
+    if (!any) { INVALID(s, "unknown property"); return; }
+  }
+}
+
+static bool integral_text(const char *t) {
+  double d = strtod(t, NULL);
+  return d >= -9007199254740992.0 && d <= 9007199254740992.0 && (double)(int64_t)d == d;
+}
+
+static void check_number(ajsb_stream_t *s) {
+  if (s->text_overflow) return;
+  const ajsb_program_t *prog = s->prog;
+  double d = strtod(s->text, NULL);
+  for (uint32_t i = 0; i < s->cur.n; i++) {
+    uint32_t mask = node_mask(prog, s->cur.node[i], 0);
+    if (!(mask & AJSB_T_NUMBER) && !integral_text(s->text)) { INVALID(s, "type mismatch"); return; }
+    FOR_OPS(prog, s->cur.node[i], op) {
+      bool ok = true;
+      switch (op->op) {
+      case AJSB_OP_MINIMUM:      ok = d >= op->d; break;
+      case AJSB_OP_MAXIMUM:      ok = d <= op->d; break;
+      case AJSB_OP_EXCL_MINIMUM: ok = d >  op->d; break;
+      case AJSB_OP_EXCL_MAXIMUM: ok = d <  op->d; break;
+      case AJSB_OP_ENUM:
+        if (!ajsb_program_enum_number(prog, op, d)) { INVALID(s, "enum mismatch"); return; }
+        break;
+      default: break;
+      }
+      if (!ok) { INVALID(s, "number out of range"); return; }
+    }
+  }
+}
+
+static void check_literal(ajsb_stream_t *s) {
+  uint32_t v = s->lit[0] == 't' ? AJSB_V_TRUE : s->lit[0] == 'f' ? AJSB_V_FALSE : AJSB_V_NULL;
+  for (uint32_t i = 0; i < s->cur.n; i++)
+    FOR_OPS(s->prog, s->cur.node[i], op) {
+      if (op->op == AJSB_OP_ENUM && !(op->flags & (1u << v))) { INVALID(s, "enum mismatch"); return; }
+    }
+}
+
+/* ── Frames ─────────────────────────────────────────────────────────────── */
+
+static void value_done(ajsb_stream_t *s) {
+  if (!s->depth) { s->state = S_DONE; s->status = AJSB_STREAM_COMPLETE; return; }
+  s->state = s->frames[s->depth - 1].kind == FRAME_OBJECT ? S_OBJ_NEXT : S_ARR_NEXT;
+}
+
+static void push_frame(ajsb_stream_t *s, uint8_t kind) {
+  if (s->depth == AJSB_STREAM_MAX_DEPTH) { INVALID(s, "nesting too deep"); return; }
+  frame_t *f = s->frames + s->depth++;
+  memset(f, 0, sizeof(*f));
+  f->kind = kind;
+  f->ctx = s->cur;
+}
+
+/* Resolve the context of the member value once its key is complete. */
+static void key_done(ajsb_stream_t *s) {
+  const ajsb_program_t *prog = s->prog;
+  frame_t *f = s->frames + s->depth - 1;
+  ctx_t next = { {0}, 0 };
+  uint32_t h = ajsb_hash32(s->text, s->text_len);
+
+  if (s->text_overflow) f->lost = true;
+  for (uint32_t i = 0; i < f->ctx.n && !s->text_overflow; i++) {
+    uint32_t node = f->ctx.node[i];
+    const ajsb_op_t *props = find_op(prog, node, AJSB_OP_PROPERTIES);
+    if (props) {
+      const ajsb_entry_t *e = ajsb_program_prop(prog, props, s->text, s->text_len, h);
+      if (e) {
+        if (e->aux) f->req[i][(e->aux - 1) >> 6] |= (uint64_t)1 << ((e->aux - 1) & 63);
+        ctx_add(prog, &next, e->node);
+      }
+      else if (props->flags & AJSB_PF_NO_ADDITIONAL) { INVALID(s, "unknown property"); return; }
+      else if (props->flags & AJSB_PF_ADDITIONAL) ctx_add(prog, &next, props[1].a);
+    }
+    const ajsb_op_t *req = find_op(prog, node, AJSB_OP_REQUIRED);
+    for (uint32_t x = 0; req && x < req->u.b && x < 64; x++)
+      if (ajsb_entry_eq(prog, prog->entries + req->a + x, s->text, s->text_len, h))
+        f->extra[i] |= (uint64_t)1 << x;
+  }
+  s->cur = next;
+  s->state = S_COLON;
+}
+
+static void object_done(ajsb_stream_t *s) {
+  const ajsb_program_t *prog = s->prog;
+  frame_t *f = s->frames + s->depth - 1;
+  for (uint32_t i = 0; i < f->ctx.n && !f->lost; i++) {
+    const ajsb_op_t *req = find_op(prog, f->ctx.node[i], AJSB_OP_REQUIRED);
+    if (!req) continue;
+    uint32_t bits = req->u.c;
+    for (uint32_t w = 0; bits; w++) {
+      uint64_t want = bits >= 64 ? UINT64_MAX : ((uint64_t)1 << bits) - 1;
+      if ((f->req[i][w] & want) != want) { INVALID(s, "missing required property"); return; }
+      bits = bits >= 64 ? bits - 64 : 0;
+    }
+    uint32_t extras = req->u.b < 64 ? req->u.b : 64;
+    uint64_t want = extras == 64 ? UINT64_MAX : ((uint64_t)1 << extras) - 1;
+    if ((f->extra[i] & want) != want) { INVALID(s, "missing required property"); return; }
+  }
+  s->depth--;
+  value_done(s);
+}
+
+static void array_item(ajsb_stream_t *s) {
+  const ajsb_program_t *prog = s->prog;
+  frame_t *f = s->frames + s->depth - 1;
+  ctx_t next = { {0}, 0 };
+  f->count++;
+  for (uint32_t i = 0; i < f->ctx.n; i++) {
+    FOR_OPS(prog, f->ctx.node[i], op) {
+      if (op->op == AJSB_OP_MAX_ITEMS && f->count > op->a) { INVALID(s, "too many items"); return; }
+      if (op->op == AJSB_OP_ITEMS) ctx_add(prog, &next, op->a);
+    }
+  }
+  s->cur = next;
+}
+
+static void array_done(ajsb_stream_t *s) {
+  frame_t *f = s->frames + s->depth - 1;
+  for (uint32_t i = 0; i < f->ctx.n; i++) {
+    const ajsb_op_t *op = find_op(s->prog, f->ctx.node[i], AJSB_OP_MIN_ITEMS);
+    if (op && f->count < op->a) { INVALID(s, "too few items"); return; }
+  }
+  s->depth--;
+  value_done(s);
+}
+
+/* ── Tokenizer ──────────────────────────────────────────────────────────── */
+
+static inline bool is_ws(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+static inline bool is_digit(char c) { return c >= '0' && c <= '9'; }
+static inline bool is_hex(char c) {
+  return is_digit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+static void text_put(ajsb_stream_t *s, char c) {
+  if (s->text_len + 1 >= TEXT_CAP) { s->text_overflow = true; return; }
+  s->text[s->text_len++] = c;
+  s->text[s->text_len] = 0;
+}
+
+/* A finished key or string, rewritten in place to the canonical form entries
+   are stored in. Format and pattern checks decode it the same. */
+static void text_canonical(ajsb_stream_t *s) {
+  if (s->text_overflow || !memchr(s->text, '\\', s->text_len)) return;
+  s->text_len = ajsb_json_canonical(s->text, s->text, s->text_len);
+  s->text[s->text_len] = 0;
+}
+
+static void text_start(ajsb_stream_t *s) {
+  s->text_len = 0;
+  s->text[0] = 0;
+  s->text_overflow = false;
+}
+
+static void begin_value(ajsb_stream_t *s, char c) {
+  uint32_t kind;
+  switch (c) {
+  case '{': kind = AJSB_T_OBJECT;  break;
+  case '[': kind = AJSB_T_ARRAY;   break;
+  case '"': kind = AJSB_T_STRING;  break;
+  case 't': case 'f': kind = AJSB_T_BOOLEAN; break;
+  case 'n': kind = AJSB_T_NULL;    break;
+  default:
+    if (c == '-' || is_digit(c)) { kind = AJSB_T_NUMBER; break; }
+    SYNTAX(s, "unexpected character");
+    return;
+  }
+  check_start(s, kind);
+  if (failed(s)) return;
+
+  switch (kind) {
+  case AJSB_T_OBJECT: push_frame(s, FRAME_OBJECT); s->state = S_OBJ_FIRST; break;
+  case AJSB_T_ARRAY:  push_frame(s, FRAME_ARRAY);  s->state = S_ARR_FIRST; break;
+  case AJSB_T_STRING:
+    text_start(s);
+    s->in_key = false;
+    s->esc = 0;
+    s->state = S_STRING;
+    check_string(s, false);
+    break;
+  case AJSB_T_NUMBER:
+    text_start(s);
+    text_put(s, c);
+    s->num = c == '-' ? N_SIGN : c == '0' ? N_ZERO : N_INT;
+    s->state = S_NUMBER;
+    break;
+  default:
+    s->lit = c == 't' ? "true" : c == 'f' ? "false" : "null";
+    s->lit_pos = 1;
+    s->state = S_LITERAL;
+    break;
+  }
+}
+
+static void number_done(ajsb_stream_t *s) {
+  check_number(s);
+  if (!failed(s)) value_done(s);
+}
+
+/* Returns false when c ends the number and must be handled by the next state. */
+static bool number_byte(ajsb_stream_t *s, char c) {
+  uint8_t n = s->num;
+  if (is_digit(c)) {
+    if (n == N_ZERO) { SYNTAX(s, "leading zero"); return true; }
+    s->num = n == N_SIGN ? (c == '0' ? N_ZERO : N_INT)
+           : n == N_FRAC0 ? N_FRAC
+           : (n == N_EXP0 || n == N_EXPS) ? N_EXP
+           : n;
+  }
+  else if (c == '.' && (n == N_ZERO || n == N_INT)) s->num = N_FRAC0;
+  else if ((c == 'e' || c == 'E') && (n == N_ZERO || n == N_INT || n == N_FRAC)) s->num = N_EXP0;
+  else if ((c == '+' || c == '-') && n == N_EXP0) s->num = N_EXPS;
+  else if (n == N_ZERO || n == N_INT || n == N_FRAC || n == N_EXP) return false;
+  else { SYNTAX(s, "bad number"); return true; }
+  text_put(s, c);
+  return true;
+}
+
+static void string_byte(ajsb_stream_t *s, char c) {
+  if (s->esc == 1) {
+    if (!strchr("\"\\/bfnrtu", c) || !c) { SYNTAX(s, "bad escape"); return; }
+    s->esc = c == 'u' ? 2 : 0;
+  }
+  else if (s->esc) {
+    if (!is_hex(c)) { SYNTAX(s, "bad escape"); return; }
+    s->esc = s->esc == 5 ? 0 : s->esc + 1;
+  }
+  else if (c == '\\') s->esc = 1;
+  else if (c == '"') {
+    text_canonical(s);
+    if (s->in_key) key_done(s);
+    else {
+      check_string(s, true);
+      if (!failed(s)) value_done(s);
+    }
+    return;
+  }
+  else if ((unsigned char)c < 0x20) { SYNTAX(s, "control character in string"); return; }
+
+  text_put(s, c);
+  if (s->in_key) check_key_prefix(s);
+  else check_string(s, false);
+}
+
+static void step(ajsb_stream_t *s, char c) {
+again:
+  switch (s->state) {
+  case S_VALUE:
+    if (!is_ws(c)) begin_value(s, c);
+    break;
+
+  case S_OBJ_FIRST:
+  case S_OBJ_KEY:
+    if (is_ws(c)) break;
+    if (c == '"') {
+      text_start(s);
+      s->in_key = true;
+      s->esc = 0;
+      s->state = S_STRING;
+    }
+    else if (c == '}' && s->state == S_OBJ_FIRST) object_done(s);
+    else SYNTAX(s, "expected property name");
+    break;
+
+  case S_COLON:
+    if (is_ws(c)) break;
+    if (c == ':') s->state = S_VALUE;
+    else SYNTAX(s, "expected ':'");
+    break;
+
+  case S_OBJ_NEXT:
+    if (is_ws(c)) break;
+    if (c == ',') s->state = S_OBJ_KEY;
+    else if (c == '}') object_done(s);
+    else SYNTAX(s, "expected ',' or '}'");
+    break;
+
+  case S_ARR_FIRST:
+    if (is_ws(c)) break;
+    if (c == ']') { array_done(s); break; }
+    array_item(s);
+    if (!failed(s)) begin_value(s, c);
+    break;
+
+  case S_ARR_NEXT:
+    if (is_ws(c)) break;
+    if (c == ',') {
+      array_item(s);
+      s->state = S_VALUE;
+    }
+    else if (c == ']') array_done(s);
+    else SYNTAX(s, "expected ',' or ']'");
+    break;
+
+  case S_STRING:
+    string_byte(s, c);
+    break;
+
+  case S_NUMBER:
+    if (!number_byte(s, c)) {
+      number_done(s);
+      if (!failed(s)) goto again;
+    }
+    break;
+
+  case S_LITERAL:
+    if (c != s->lit[s->lit_pos]) { SYNTAX(s, "bad literal"); break; }
+    if (!s->lit[++s->lit_pos]) {
+      check_literal(s);
+      if (!failed(s)) value_done(s);
+    }
+    break;
+
+  case S_DONE:
+    if (!is_ws(c)) SYNTAX(s, "trailing characters");
+    break;
+  }
+}
+
+/* ── Public API ─────────────────────────────────────────────────────────── */
+
+ajsb_stream_t *ajsb_stream_init(aml_pool_t *p, const ajsb_program_t *prog) {
+  if (!p || !prog) return NULL;
+  ajsb_stream_t *s = (ajsb_stream_t *)aml_pool_zalloc(p, sizeof(*s));
+  s->prog = prog;
+  s->frames = (frame_t *)aml_pool_alloc(p, sizeof(frame_t) * AJSB_STREAM_MAX_DEPTH);
+  s->text = (char *)aml_pool_alloc(p, TEXT_CAP);
+  ajsb_stream_reset(s);
+  return s;
+}
+
+void ajsb_stream_reset(ajsb_stream_t *s) {
+  if (!s) return;
+  s->status = AJSB_STREAM_CONTINUE;
+  s->error = NULL;
+  s->offset = 0;
+  s->state = S_VALUE;
+  s->depth = 0;
+  s->cur.n = 0;
+  ctx_add(s->prog, &s->cur, s->prog->root);
+  text_start(s);
+}
+
+ajsb_stream_status_t ajsb_stream_push(ajsb_stream_t *s, const char *data, size_t len) {
+  if (!s) return AJSB_STREAM_SYNTAX_ERROR;
+  for (size_t i = 0; i < len && !failed(s); i++) {
+    step(s, data[i]);
+    if (!failed(s)) s->offset++;
+  }
+  return s->status;
+}
+
+ajsb_stream_status_t ajsb_stream_finish(ajsb_stream_t *s) {
+  if (!s) return AJSB_STREAM_SYNTAX_ERROR;
+  if (failed(s)) return s->status;
+  if (s->state == S_NUMBER && !s->depth) {
+    if (s->num == N_ZERO || s->num == N_INT || s->num == N_FRAC || s->num == N_EXP) number_done(s);
+    else SYNTAX(s, "bad number");
+  }
+  if (!failed(s) && s->state != S_DONE) SYNTAX(s, "unexpected end of input");
+  return s->status;
+}
+
+const char *ajsb_stream_error(const ajsb_stream_t *s) {
+  return s ? s->error : NULL;
+}
+
+size_t ajsb_stream_offset(const ajsb_stream_t *s) {
+  return s ? s->offset : 0;
+}
@@ -0,0 +1,604 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#include "ajsb_program.h"
+#include "a-json-schema-builder-library/ajsb_format.h"
+#include "a-memory-library/aml_alloc.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ── Instance helpers ───────────────────────────────────────────────────── */
+
+static inline uint32_t kind_of(ajson_t *j) {
+  if (ajson_is_object(j)) return AJSB_T_OBJECT;
+  if (ajson_is_array(j))  return AJSB_T_ARRAY;
+  if (ajson_is_string(j)) return AJSB_T_STRING;
+  if (ajson_is_number(j) || ajson_is_decimal(j)) return AJSB_T_NUMBER;
+  if (ajson_is_bool(j))   return AJSB_T_BOOLEAN;
+  if (ajson_is_null(j))   return AJSB_T_NULL;
+  return 0;
+}
+
+static inline bool is_integral(double d) {
+  return d >= -9007199254740992.0 && d <= 9007199254740992.0 && (double)(int64_t)d == d;
+}
+
+static bool type_ok(uint32_t mask, uint32_t kind, ajson_t *j) {
+  if (mask & kind) return true;
+  return kind == AJSB_T_NUMBER && (mask & AJSB_T_INTEGER) && is_integral(ajson_to_double(j, 0.5));
+}
+
+/* Hash of raw string text in canonical form. */
+static uint64_t text_hash(const char *raw, size_t len) {
+  char stack[128], *heap;
+  const char *s = ajsb__canonical(raw, &len, stack, sizeof(stack), &heap);
+  uint64_t h = s ? ajsb_hash64(s, len) : 0;
+  free(heap);
+  return h;
+}
+
+/* Member of object j named by raw text key[0..len), or NULL. */
+static ajson_t *member_of(ajson_t *j, const char *key, size_t len) {
+  for (ajsono_t *m = ajsono_first(j); m; m = ajsono_next(m))
+    if (ajsb_json_text_eq(m->key, strlen(m->key), key, len)) return m->value;
+  return NULL;
+}
+
+static bool json_equal(ajson_t *a, ajson_t *b) {
+  uint32_t ka = kind_of(a), kb = kind_of(b);
+  if (ka != kb) return false;
+  switch (ka) {
+  case AJSB_T_NUMBER:  return ajson_to_double(a, 0) == ajson_to_double(b, 0);
+  case AJSB_T_STRING: {
+    const char *x = ajson_to_str(a, ""), *y = ajson_to_str(b, "");
+    return ajsb_json_text_eq(x, strlen(x), y, strlen(y));
+  }
+  case AJSB_T_BOOLEAN: return ajson_is_true(a) == ajson_is_true(b);
+  case AJSB_T_NULL:    return true;
+  case AJSB_T_ARRAY: {
+    if (ajsona_count(a) != ajsona_count(b)) return false;
+    ajsona_t *x = ajsona_first(a), *y = ajsona_first(b);
+    for (; x && y; x = ajsona_next(x), y = ajsona_next(y))
+      if (!json_equal(x->value, y->value)) return false;
+    return true;
+  }
+  case AJSB_T_OBJECT: {
+    if (ajsono_count(a) != ajsono_count(b)) return false;
+    for (ajsono_t *x = ajsono_first(a); x; x = ajsono_next(x)) {
+      ajson_t *v = member_of(b, x->key, strlen(x->key));
+      if (!v || !json_equal(x->value, v)) return false;
+    }
+    return true;
+  }
+  }
+  return false;
+}
+
+/* Agrees with json_equal: numbers by value, object members in any order. */
+uint64_t ajsb_json_hash(ajson_t *j) {
+  switch (kind_of(j)) {
+  case AJSB_T_NUMBER:  return ajsb_number_hash(ajson_to_double(j, 0));
+  case AJSB_T_STRING: {
+    const char *s = ajson_to_str(j, "");
+    return text_hash(s, strlen(s));
+  }
+  case AJSB_T_BOOLEAN: return ajson_is_true(j) ? 1 : 2;
+  case AJSB_T_NULL:    return 3;
+  case AJSB_T_ARRAY: {
+    uint64_t h = 4;
+    for (ajsona_t *a = ajsona_first(j); a; a = ajsona_next(a))
+      h = (h ^ ajsb_json_hash(a->value)) * 1099511628211ull;
+    return h;
+  }
+  case AJSB_T_OBJECT: {
+    uint64_t h = 5;
+    for (ajsono_t *m = ajsono_first(j); m; m = ajsono_next(m))
+      h += ajsb_mph_hash(text_hash(m->key, strlen(m->key)) ^ ajsb_json_hash(m->value), 5);
+    return h;
+  }
+  }
+  return 0;
+}
+
+/* json_equal against compact JSON text as produced by ajson_stringify (an
+   object or array enum member), consuming it. */
+typedef struct { const char *s, *e; } cursor_t;
+
+static bool lit(cursor_t *c, const char *t, size_t n) {
+  if ((size_t)(c->e - c->s) < n || memcmp(c->s, t, n)) return false;
+  c->s += n;
+  return true;
+}
+
+/* Text of the string that opens at c, which is left after it. */
+static bool text_string(cursor_t *c, const char **s, size_t *len) {
+  if (!lit(c, "\"", 1)) return false;
+  const char *p = c->s;
+  while (p < c->e && *p != '"') p += *p == '\\' ? 2 : 1;
+  if (p >= c->e) return false;
+  *s = c->s;
+  *len = (size_t)(p - c->s);
+  c->s = p + 1;
+  return true;
+}
+
+static bool equals_text(ajson_t *j, cursor_t *c) {
+  if (c->s >= c->e) return false;
+  uint32_t kind = kind_of(j);
+  const char *s;
+  size_t len;
+  switch (*c->s) {
+  case '{': {
+    if (kind != AJSB_T_OBJECT) return false;
+    c->s++;
+    if (lit(c, "}", 1)) return !ajsono_count(j);
+    size_t n = 0;
+    do {
+      if (!text_string(c, &s, &len) || !lit(c, ":", 1)) return false;
+      ajson_t *v = member_of(j, s, len);
+      if (!v || !equals_text(v, c)) return false;
+      n++;
+    } while (lit(c, ",", 1));
+    return lit(c, "}", 1) && n == ajsono_count(j);
+  }
+  case '[': {
+    if (kind != AJSB_T_ARRAY) return false;
+    c->s++;
+    ajsona_t *a = ajsona_first(j);
+    if (lit(c, "]", 1)) return !a;
+    for (;; a = ajsona_next(a)) {
+      if (!a || !equals_text(a->value, c)) return false;
+      if (!lit(c, ",", 1)) break;
+    }
+    return lit(c, "]", 1) && !ajsona_next(a);
+  }
+  case '"': {
+    if (kind != AJSB_T_STRING || !text_string(c, &s, &len)) return false;
+    const char *t = ajson_to_str(j, "");
+    return ajsb_json_text_eq(s, len, t, strlen(t));
+  }
+  case 't': return kind == AJSB_T_BOOLEAN && ajson_is_true(j) && lit(c, "true", 4);
+  case 'f': return kind == AJSB_T_BOOLEAN && !ajson_is_true(j) && lit(c, "false", 5);
+  case 'n': return kind == AJSB_T_NULL && lit(c, "null", 4);
+  default: {
+    if (kind != AJSB_T_NUMBER) return false;
+    char *end;
+    double d = strtod(c->s, &end);
+    if (end == c->s || end > c->e) return false;
+    c->s = end;
+    return d == ajson_to_double(j, 0);
+  }
+  }
+}
+
+/* ── Keyword checks ─────────────────────────────────────────────────────── */
+
+static bool enum_canonical(const ajsb_program_t *prog, const ajsb_op_t *op,
+                           const char *s, size_t len) {
+  if (op->u.c != AJSB_NONE) {
+    const ajsb_entry_t *e = prog->entries + ajsb_mph_entry(prog->lists + op->u.c, ajsb_hash64(s, len));
+    return e->node == AJSB_V_STRING && e->len == len && !memcmp(ajsb_entry_str(prog, e), s, len);
+  }
+  uint32_t h = ajsb_hash32(s, len);
+  const ajsb_entry_t *e = prog->entries + op->a, *end = e + op->u.b;
+  for (; e < end; e++)
+    if (e->node == AJSB_V_STRING && ajsb_entry_eq(prog, e, s, len, h)) return true;
+  return false;
+}
+
+bool ajsb_program_enum_string(const ajsb_program_t *prog, const ajsb_op_t *op,
+                              const char *s, size_t len) {
+  if (!(op->flags & (1u << AJSB_V_STRING))) return false;
+  char stack[256], *heap;
+  const char *t = ajsb__canonical(s, &len, stack, sizeof(stack), &heap);
+  bool ok = t && enum_canonical(prog, op, t, len);
+  free(heap);
+  return ok;
+}
+
+bool ajsb_program_enum_number(const ajsb_program_t *prog, const ajsb_op_t *op, double d) {
+  if (!(op->flags & (1u << AJSB_V_NUMBER))) return false;
+  if (op->u.c != AJSB_NONE) {
+    const ajsb_entry_t *e = prog->entries + ajsb_mph_entry(prog->lists + op->u.c, ajsb_number_hash(d));
+    return e->node == AJSB_V_NUMBER && strtod(ajsb_entry_str(prog, e), NULL) == d;
+  }
+  const ajsb_entry_t *e = prog->entries + op->a, *end = e + op->u.b;
+  for (; e < end; e++)
+    if (e->node == AJSB_V_NUMBER && strtod(ajsb_entry_str(prog, e), NULL) == d) return true;
+  return false;
+}
+
+static bool enum_has(const ajsb_program_t *prog, const ajsb_op_t *op, ajson_t *j, uint32_t kind) {
+  switch (kind) {
+  case AJSB_T_STRING: {
+    const char *s = ajson_to_str(j, "");
+    return ajsb_program_enum_string(prog, op, s, strlen(s));
+  }
+  case AJSB_T_NUMBER:
+    return ajsb_program_enum_number(prog, op, ajson_to_double(j, 0));
+  case AJSB_T_BOOLEAN:
+    return op->flags & (1u << (ajson_is_true(j) ? AJSB_V_TRUE : AJSB_V_FALSE));
+  case AJSB_T_NULL:
+    return op->flags & (1u << AJSB_V_NULL);
+  default: {
+    if (!(op->flags & (1u << AJSB_V_JSON))) return false;
+    uint32_t h = (uint32_t)ajsb_json_hash(j);
+    const ajsb_entry_t *e = prog->entries + op->a, *end = e + op->u.b;
+    for (; e < end; e++) {
+      if (e->node != AJSB_V_JSON || e->hash != h) continue;
+      cursor_t c = { ajsb_entry_str(prog, e), ajsb_entry_str(prog, e) + e->len };
+      if (equals_text(j, &c) && c.s == c.e) return true;
+    }
+    return false;
+  }
+  }
+}
+
+#define UNIQUE_SCAN_MAX 16   /* shorter arrays are compared pairwise */
+
+typedef struct {
+  uint64_t  h;
+  ajson_t  *v;
+} hashed_t;
+
+static int by_item_hash(const void *a, const void *b) {
+  uint64_t x = ((const hashed_t *)a)->h, y = ((const hashed_t *)b)->h;
+  return x < y ? -1 : x > y;
+}
+
+/* Sort the item hashes; only items with equal hashes are compared. */
+static bool unique_items(ajson_t *j) {
+  size_t n = ajsona_count(j);
+  hashed_t *t = n > UNIQUE_SCAN_MAX ? (hashed_t *)aml_malloc(n * sizeof(hashed_t)) : NULL;
+  if (!t) {
+    for (ajsona_t *a = ajsona_first(j); a; a = ajsona_next(a))
+      for (ajsona_t *b = ajsona_next(a); b; b = ajsona_next(b))
+        if (json_equal(a->value, b->value)) return false;
+    return true;
+  }
+  size_t i = 0;
+  for (ajsona_t *a = ajsona_first(j); a; a = ajsona_next(a), i++) {
+    t[i].h = ajsb_json_hash(a->value);
+    t[i].v = a->value;
+  }
+  qsort(t, n, sizeof(hashed_t), by_item_hash);
+  bool unique = true;
+  for (i = 0; i < n && unique; i++)
+    for (size_t k = i + 1; k < n && t[k].h == t[i].h && unique; k++)
+      unique = !json_equal(t[i].v, t[k].v);
+  aml_free(t);
+  return unique;
+}
+
+const ajsb_entry_t *ajsb_program_prop(const ajsb_program_t *prog, const ajsb_op_t *op,
+                                      const char *key, size_t len, uint32_t hash) {
+  if (op->u.c == AJSB_NONE) {
+    const ajsb_entry_t *e = prog->entries + op->a, *end = e + op->u.b;
+    for (; e < end; e++)
+      if (ajsb_entry_eq(prog, e, key, len, hash)) return e;
+    return NULL;
+  }
+  const uint32_t *slots = prog->lists + op->u.c;
+  uint32_t mask = (1u << op->bits) - 1;
+  for (uint32_t i = hash & mask; slots[i]; i = (i + 1) & mask) {
+    const ajsb_entry_t *e = prog->entries + slots[i] - 1;
+    if (ajsb_entry_eq(prog, e, key, len, hash)) return e;
+  }
+  return NULL;
+}
+
+static bool has_key(ajson_t *j, const ajsb_program_t *prog, const ajsb_entry_t *e) {
+  return member_of(j, ajsb_entry_str(prog, e), e->len) != NULL;
+}
+
+/* The property entry for raw instance key, or NULL. */
+static const ajsb_entry_t *prop_of(const ajsb_program_t *prog, const ajsb_op_t *op,
+                                   const char *key) {
+  char stack[128], *heap;
+  size_t len = strlen(key);
+  const char *k = ajsb__canonical(key, &len, stack, sizeof(stack), &heap);
+  const ajsb_entry_t *e = k ? ajsb_program_prop(prog, op, k, len, ajsb_hash32(k, len)) : NULL;
+  free(heap);
+  return e;
+}
+
+static bool required_ok(const ajsb_program_t *prog, const ajsb_op_t *op, ajson_t *j,
+                        const uint64_t *seen) {
+  uint32_t bits = op->u.c;
+  for (uint32_t w = 0; bits; w++) {
+    uint64_t want = bits >= 64 ? UINT64_MAX : ((uint64_t)1 << bits) - 1;
+    if ((seen[w] & want) != want) return false;
+    bits = bits >= 64 ? bits - 64 : 0;
+  }
+  const ajsb_entry_t *e = prog->entries + op->a, *end = e + op->u.b;
+  for (; e < end; e++)
+    if (!has_key(j, prog, e)) return false;
+  return true;
+}
+
+/* ── Unions ─────────────────────────────────────────────────────────────── */
+
+#define ADAPT_HOT    4    /* branches tried first */
+#define ADAPT_SAMPLE 8    /* one match in this many is counted */
+#define ADAPT_RERANK 16   /* counted matches between re-rankings */
+
+/* The only branch of a discriminated union object j can match, or AJSB_NONE
+   if it can match none. */
+static uint32_t dispatch(const ajsb_program_t *prog, const ajsb_op_t *op, ajson_t *j) {
+  const uint32_t *t = prog->lists + op->u.c;
+  const ajsb_entry_t *name = prog->entries + t[0];
+  ajson_t *v = member_of(j, ajsb_entry_str(prog, name), name->len);
+  if (!v) return AJSB_NONE;
+
+  const char *s = "";
+  char stack[128], *heap = NULL;
+  size_t len = 0;
+  double d = 0;
+  uint32_t vk;
+  uint64_t h;
+  switch (kind_of(v)) {
+  case AJSB_T_STRING:
+    s = ajson_to_str(v, "");
+    len = strlen(s);
+    s = ajsb__canonical(s, &len, stack, sizeof(stack), &heap);
+    if (!s) return AJSB_NONE;
+    h = ajsb_value_hash(vk = AJSB_V_STRING, s, len);
+    break;
+  case AJSB_T_NUMBER:
+    d = ajson_to_double(v, 0);
+    h = ajsb_number_hash(d);
+    vk = AJSB_V_NUMBER;
+    break;
+  case AJSB_T_BOOLEAN:
+    h = ajsb_value_hash(vk = ajson_is_true(v) ? AJSB_V_TRUE : AJSB_V_FALSE, "", 0);
+    break;
+  case AJSB_T_NULL:
+    h = ajsb_value_hash(vk = AJSB_V_NULL, "", 0);
+    break;
+  default:
+    return AJSB_NONE;       /* no branch pins an object or array */
+  }
+
+  uint32_t mask = (1u << t[1]) - 1, branch = AJSB_NONE;
+  const uint32_t *slots = t + 2;
+  for (uint32_t i = (uint32_t)h & mask; slots[2 * i] && branch == AJSB_NONE; i = (i + 1) & mask) {
+    const ajsb_entry_t *e = prog->entries + slots[2 * i] - 1;
+    if (e->node != vk) continue;
+    if (vk == AJSB_V_STRING ? e->len == len && !memcmp(ajsb_entry_str(prog, e), s, len)
+        : vk == AJSB_V_NUMBER ? strtod(ajsb_entry_str(prog, e), NULL) == d
+        : true)
+      branch = slots[2 * i + 1];
+  }
+  free(heap);
+  return branch;
+}
+
+static _Thread_local uint32_t adapt_tick;
+
+/* Count one match in ADAPT_SAMPLE and, every ADAPT_RERANK counted, publish
+   the four busiest branches and halve the counts so the order follows
+   recent traffic. The per-thread tick picks which matches count, so
+   threads sharing a program rarely write the shared words. The counters
+   are hints: racing updates may lose a few, but hot is written whole, so
+   readers always see a valid set. */
+static void adapt_hit(uint64_t *w, uint32_t n, uint32_t branch) {
+  if (++adapt_tick % ADAPT_SAMPLE) return;
+  __atomic_fetch_add(w + 2 + branch, 1, __ATOMIC_RELAXED);
+  if (__atomic_add_fetch(w + 1, 1, __ATOMIC_RELAXED) % ADAPT_RERANK) return;
+  uint32_t top[ADAPT_HOT] = {0};
+  uint64_t most[ADAPT_HOT] = {0};
+  for (uint32_t i = 0; i < n; i++) {
+    uint64_t v = __atomic_load_n(w + 2 + i, __ATOMIC_RELAXED);
+    __atomic_store_n(w + 2 + i, v / 2, __ATOMIC_RELAXED);
+    for (int k = 0; k < ADAPT_HOT; k++) {
+      if (v <= most[k]) continue;
+      memmove(top + k + 1, top + k, (ADAPT_HOT - 1 - k) * sizeof(top[0]));
+      memmove(most + k + 1, most + k, (ADAPT_HOT - 1 - k) * sizeof(most[0]));
+      top[k] = i + 1;
+      most[k] = v;
+      break;
+    }
+  }
+  uint64_t hot = 0;
+  for (int k = 0; k < ADAPT_HOT; k++) hot |= (uint64_t)top[k] << (16 * k);
+  __atomic_store_n(w, hot, __ATOMIC_RELAXED);
+}
+
+static inline bool is_hot(uint64_t hot, uint32_t branch) {
+  for (int k = 0; k < ADAPT_HOT; k++)
+    if (((hot >> (16 * k)) & 0xffff) == branch + 1) return true;
+  return false;
+}
+
+/* anyOf: the named branch of a discriminated union, the busiest branches
+   first when counters are attached, otherwise in order. *tried counts the
+   branches run. */
+static bool any_of(const ajsb_program_t *prog, const ajsb_op_t *op, ajson_t *j,
+                   uint32_t kind, uint32_t *tried) {
+  const uint32_t *list = prog->lists + op->a;
+  uint32_t n = op->u.b;
+  if ((op->flags & AJSB_UF_DISPATCH) && kind == AJSB_T_OBJECT) {
+    uint32_t b = dispatch(prog, op, j);
+    if (b == AJSB_NONE) return false;
+    *tried = 1;
+    return ajsb_program_run(prog, list[b], j);
+  }
+  if (!(op->flags & AJSB_UF_ADAPT) || !prog->adapt) {
+    for (uint32_t i = 0; i < n; i++) {
+      ++*tried;
+      if (ajsb_program_run(prog, list[i], j)) return true;
+    }
+    return false;
+  }
+  uint64_t *w = prog->adapt + op->u.c;
+  uint64_t hot = __atomic_load_n(w, __ATOMIC_RELAXED);
+  for (int k = 0; k < ADAPT_HOT; k++) {
+    uint32_t b = (uint32_t)(hot >> (16 * k)) & 0xffff;
+    if (!b-- || b >= n) continue;
+    ++*tried;
+    if (ajsb_program_run(prog, list[b], j)) { adapt_hit(w, n, b); return true; }
+  }
+  for (uint32_t b = 0; b < n; b++) {
+    if (is_hot(hot, b)) continue;
+    ++*tried;
+    if (ajsb_program_run(prog, list[b], j)) { adapt_hit(w, n, b); return true; }
+  }
+  return false;
+}
+
+/* oneOf: how many branches match, stopping at 2. Every branch has to run to
+   prove a match is the only one, so only a discriminator shortens it. */
+static uint32_t one_of(const ajsb_program_t *prog, const ajsb_op_t *op, ajson_t *j,
+                       uint32_t kind, uint32_t *tried) {
+  const uint32_t *list = prog->lists + op->a;
+  if ((op->flags & AJSB_UF_DISPATCH) && kind == AJSB_T_OBJECT) {
+    uint32_t b = dispatch(prog, op, j);
+    if (b == AJSB_NONE) return 0;
+    *tried = 1;
+    return ajsb_program_run(prog, list[b], j);
+  }
+  uint32_t matched = 0;
+  for (uint32_t i = 0; i < op->u.b && matched < 2; i++, ++*tried)
+    if (ajsb_program_run(prog, list[i], j)) matched++;
+  return matched;
+}
+
+/* ── Interpreter ────────────────────────────────────────────────────────── */
+
+static bool run(const ajsb_program_t *prog, uint32_t node, ajson_t *j) {
+  uint32_t kind = kind_of(j);
+  uint64_t seen[AJSB_REQ_BITS / 64] = {0};
+
+  for (const ajsb_op_t *op = prog->ops + node;; op++) {
+    switch ((ajsb_opcode_t)op->op) {
+    case AJSB_OP_END:
+      return true;
+
+    case AJSB_OP_FALSE:
+      return false;
+
+    case AJSB_OP_TYPE:
+      if (!type_ok(op->a, kind, j)) return false;
+      break;
+
+    case AJSB_OP_ENUM:
+      if (!enum_has(prog, op, j, kind)) return false;
+      break;
+
+    case AJSB_OP_MINIMUM:
+      if (kind == AJSB_T_NUMBER && !(ajson_to_double(j, 0) >= op->d)) return false;
+      break;
+    case AJSB_OP_MAXIMUM:
+      if (kind == AJSB_T_NUMBER && !(ajson_to_double(j, 0) <= op->d)) return false;
+      break;
+    case AJSB_OP_EXCL_MINIMUM:
+      if (kind == AJSB_T_NUMBER && !(ajson_to_double(j, 0) > op->d)) return false;
+      break;
+    case AJSB_OP_EXCL_MAXIMUM:
+      if (kind == AJSB_T_NUMBER && !(ajson_to_double(j, 0) < op->d)) return false;
+      break;
+
+    case AJSB_OP_MIN_ITEMS:
+      if (kind == AJSB_T_ARRAY && ajsona_count(j) < op->a) return false;
+      break;
+    case AJSB_OP_MAX_ITEMS:
+      if (kind == AJSB_T_ARRAY && ajsona_count(j) > op->a) return false;
+      break;
+    case AJSB_OP_UNIQUE_ITEMS:
+      if (kind == AJSB_T_ARRAY && !unique_items(j)) return false;
+      break;
+
+    case AJSB_OP_FORMAT:
+      if (kind == AJSB_T_STRING) {
+        const char *s = ajson_to_str(j, "");
+        if (!ajsb_format_check_json((ajsb_format_t)op->a, s, strlen(s))) return false;
+      }
+      break;
+    case AJSB_OP_PATTERN:
+      if (kind == AJSB_T_STRING) {
+        const char *s = ajson_to_str(j, "");
+        if (!ajsb_pattern_match_json(prog->lists + op->a, s, strlen(s))) return false;
+      }
+      break;
+
+    case AJSB_OP_ITEMS:
+      if (kind != AJSB_T_ARRAY) break;
+      for (ajsona_t *a = ajsona_first(j); a; a = ajsona_next(a))
+        if (!ajsb_program_run(prog, op->a, a->value)) return false;
+      break;
+
+    case AJSB_OP_PROPERTIES:
+      if (kind != AJSB_T_OBJECT) break;
+      for (ajsono_t *m = ajsono_first(j); m; m = ajsono_next(m)) {
+        const ajsb_entry_t *e = prop_of(prog, op, m->key);
+        if (e) {
+          if (e->aux) seen[(e->aux - 1) >> 6] |= (uint64_t)1 << ((e->aux - 1) & 63);
+          if (!ajsb_program_run(prog, e->node, m->value)) return false;
+        }
+        else if (op->flags & AJSB_PF_NO_ADDITIONAL) return false;
+        else if ((op->flags & AJSB_PF_ADDITIONAL) && !ajsb_program_run(prog, op[1].a, m->value))
+          return false;
+      }
+      break;
+
+    case AJSB_OP_ADDITIONAL:
+      break;  /* consumed by AJSB_OP_PROPERTIES */
+
+    case AJSB_OP_REQUIRED:
+      if (kind == AJSB_T_OBJECT && !required_ok(prog, op, j, seen)) return false;
+      break;
+
+    case AJSB_OP_ALL_OF:
+      for (uint32_t i = 0; i < op->u.b; i++)
+        if (!ajsb_program_run(prog, prog->lists[op->a + i], j)) return false;
+      break;
+
+    case AJSB_OP_ANY_OF: {
+      uint32_t tried = 0;
+      bool any = any_of(prog, op, j, kind, &tried);
+      AJSB_PROFILE_BACKTRACKS(prog, node, tried - any);
+      if (!any) return false;
+      break;
+    }
+
+    case AJSB_OP_ONE_OF: {
+      uint32_t tried = 0, matched = one_of(prog, op, j, kind, &tried);
+      AJSB_PROFILE_BACKTRACKS(prog, node, tried - matched);
+      if (matched != 1) return false;
+      break;
+    }
+
+    case AJSB_OP_NOT:
+      if (ajsb_program_run(prog, op->a, j)) return false;
+      break;
+
+    case AJSB_OP_REF:
+      if (!ajsb_program_run(prog, op->a, j)) return false;
+      break;
+    }
+  }
+}
+
+/* Children are run through here too, so an attached profile sees every node. */
+bool ajsb_program_run(const ajsb_program_t *prog, uint32_t node, ajson_t *j) {
+#ifdef AJSB_INSTRUMENT
+  ajsb_profile_t *pr = ajsb_profile_of(prog);
+  if (pr) {
+    ajsb_profile_frame_t f = ajsb_profile_enter();
+    bool ok = run(prog, node, j);
+    ajsb_profile_leave(pr, node, ok, f);
+    return ok;
+  }
+#endif
+  return run(prog, node, j);
+}
+
+bool ajsb_validate(const ajsb_program_t *prog, ajson_t *instance) {
+  if (!prog || !instance) return false;
+  return ajsb_program_run(prog, prog->root, instance);
+}
@@ -0,0 +1,442 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#include "a-json-schema-builder-library/ajsb_writer.h"
+#include "a-memory-library/aml_alloc.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#define CHUNK 4096
+
+enum { F_SCHEMA, F_LIST };                           /* frame kinds */
+enum { G_NONE, G_PROPS, G_DEFS };                    /* open keyword block */
+enum { D_PROPS = 1, D_DEFS = 2, D_REQUIRED = 4 };    /* blocks already closed */
+
+typedef struct {
+  uint8_t kind, group, done;
+  bool    first;          /* nothing written yet inside this {…} / […] */
+  bool    group_first;    /* nothing written yet inside the open block */
+  bool    await;          /* a slot was named; its schema comes next */
+  size_t  req_off;        /* this frame's pending required names start here */
+} frame_t;
+
+struct ajsb_writer_s {
+  aml_buffer_t *out;      /* the caller's buffer, or our staging buffer */
+  bool          own_out;
+  aml_buffer_t *names;    /* encoded prop_required names, '\0' separated */
+
+  ajsb_writer_sink_cb cb;
+  void *arg;
+  int   fd;
+
+  frame_t stack[AJSB_WRITER_MAX_DEPTH];
+  int     depth;
+  bool    done;           /* the root schema has been closed */
+  const char *error;
+};
+
+/* ── Output ─────────────────────────────────────────────────────────────── */
+
+static bool fail(ajsb_writer_t *w, const char *msg) {
+  if (!w->error) w->error = msg;
+  return false;
+}
+
+static void flush(ajsb_writer_t *w) {
+  size_t len = aml_buffer_length(w->out);
+  if (!w->cb || !len) return;
+  if (!w->error && !w->cb(w->arg, aml_buffer_data(w->out), len)) fail(w, "write failed");
+  aml_buffer_clear(w->out);
+}
+
+static void put(ajsb_writer_t *w, const char *s, size_t len) {
+  aml_buffer_append(w->out, s, len);
+  if (w->cb && aml_buffer_length(w->out) >= CHUNK) flush(w);
+}
+
+static inline void puts_(ajsb_writer_t *w, const char *s) { put(w, s, strlen(s)); }
+
+/* JSON-escape s into bh (same escapes as ajson_str). */
+static void escape(aml_buffer_t *bh, const char *s) {
+  const char *run = s;
+  for (; *s; s++) {
+    unsigned char c = (unsigned char)*s;
+    if (c >= 0x20 && c != '"' && c != '\\') continue;
+    aml_buffer_append(bh, run, (size_t)(s - run));
+    run = s + 1;
+    switch (c) {
+      case '"':  aml_buffer_appends(bh, "\\\""); break;
+      case '\\': aml_buffer_appends(bh, "\\\\"); break;
+      case '\n': aml_buffer_appends(bh, "\\n");  break;
+      case '\t': aml_buffer_appends(bh, "\\t");  break;
+      case '\r': aml_buffer_appends(bh, "\\r");  break;
+      case '\b': aml_buffer_appends(bh, "\\b");  break;
+      case '\f': aml_buffer_appends(bh, "\\f");  break;
+      default:   aml_buffer_appendf(bh, "\\u%04x", c); break;
+    }
+  }
+  aml_buffer_append(bh, run, (size_t)(s - run));
+}
+
+static void put_str(ajsb_writer_t *w, const char *s) {
+  aml_buffer_appendc(w->out, '"');
+  escape(w->out, s);
+  put(w, "\"", 1);
+}
+
+/* ── Nesting ────────────────────────────────────────────────────────────── */
+
+static inline frame_t *top(ajsb_writer_t *w) { return w->depth ? w->stack + w->depth - 1 : NULL; }
+
+/* A schema value is about to be written: find its place and separate it. */
+static bool open_value(ajsb_writer_t *w) {
+  if (w->error) return false;
+  frame_t *f = top(w);
+  if (!f) return w->done ? fail(w, "schema already complete") : true;
+  if (f->kind == F_LIST) {
+    if (!f->first) put(w, ",", 1);
+    f->first = false;
+    return true;
+  }
+  if (!f->await) return fail(w, "schema written where a keyword was expected");
+  f->await = false;
+  return true;
+}
+
+static bool push(ajsb_writer_t *w, uint8_t kind) {
+  if (w->depth == AJSB_WRITER_MAX_DEPTH) return fail(w, "nesting too deep");
+  frame_t *f = w->stack + w->depth++;
+  memset(f, 0, sizeof(*f));
+  f->kind = kind;
+  f->first = true;
+  f->req_off = aml_buffer_length(w->names);
+  return true;
+}
+
+/* Close an open properties/$defs block; required names follow properties. */
+static void close_group(ajsb_writer_t *w, frame_t *f) {
+  if (f->group == G_NONE) return;
+  put(w, "}", 1);
+  f->done |= f->group == G_PROPS ? D_PROPS : D_DEFS;
+  if (f->group == G_PROPS && aml_buffer_length(w->names) > f->req_off) {
+    puts_(w, ",\"required\":[");
+    const char *s = aml_buffer_data(w->names) + f->req_off;
+    const char *end = aml_buffer_data(w->names) + aml_buffer_length(w->names);
+    for (bool first = true; s < end; s += strlen(s) + 1, first = false) {
+      if (!first) put(w, ",", 1);
+      put(w, "\"", 1);
+      puts_(w, s);
+      put(w, "\"", 1);
+    }
+    put(w, "]", 1);
+    f->done |= D_REQUIRED;
+    aml_buffer_shrink_by(w->names, aml_buffer_length(w->names) - f->req_off);
+  }
+  f->group = G_NONE;
+}
+
+/* Start keyword kw on the open schema. */
+static bool keyword(ajsb_writer_t *w, const char *kw) {
+  if (w->error) return false;
+  frame_t *f = top(w);
+  if (!f || f->kind != F_SCHEMA) return fail(w, "keyword outside a schema");
+  if (f->await) return fail(w, "keyword written where a schema was expected");
+  close_group(w, f);
+  if (!f->first) put(w, ",", 1);
+  f->first = false;
+  put(w, "\"", 1);
+  puts_(w, kw);
+  put(w, "\":", 2);
+  return true;
+}
+
+static void open_schema(ajsb_writer_t *w, const char *type) {
+  if (!open_value(w) || !push(w, F_SCHEMA)) return;
+  put(w, "{", 1);
+  if (!type) return;
+  puts_(w, "\"type\":\"");
+  puts_(w, type);
+  put(w, "\"", 1);
+  top(w)->first = false;
+}
+
+static bool slot(ajsb_writer_t *w, uint8_t group, const char *name) {
+  if (w->error) return false;
+  frame_t *f = top(w);
+  if (!f || f->kind != F_SCHEMA) return fail(w, "keyword outside a schema");
+  if (f->await) return fail(w, "keyword written where a schema was expected");
+  if (f->group != group) {
+    if (f->done & (group == G_PROPS ? D_PROPS : D_DEFS))
+      return fail(w, group == G_PROPS ? "properties already written" : "$defs already written");
+    if (!keyword(w, group == G_PROPS ? "properties" : "$defs")) return false;
+    put(w, "{", 1);
+    f->group = group;
+    f->group_first = true;
+  }
+  if (!f->group_first) put(w, ",", 1);
+  f->group_first = false;
+  put_str(w, name);
+  put(w, ":", 1);
+  f->await = true;
+  return true;
+}
+
+static void str_keyword(ajsb_writer_t *w, const char *kw, const char *s) {
+  if (keyword(w, kw)) put_str(w, s);
+}
+
+static void combinator(ajsb_writer_t *w, const char *kw) {
+  if (!open_value(w) || !push(w, F_LIST)) return;
+  puts_(w, "{\"");
+  puts_(w, kw);
+  puts_(w, "\":[");
+}
+
+/* ── Lifecycle ──────────────────────────────────────────────────────────── */
+
+static ajsb_writer_t *writer_new(aml_buffer_t *out, bool own) {
+  ajsb_writer_t *w = (ajsb_writer_t *)aml_calloc(1, sizeof(*w));
+  w->out = out;
+  w->own_out = own;
+  w->names = aml_buffer_init(256);
+  w->fd = -1;
+  return w;
+}
+
+ajsb_writer_t *ajsb_writer_init(aml_buffer_t *bh) {
+  if (!bh) return NULL;
+  return writer_new(bh, false);
+}
+
+ajsb_writer_t *ajsb_writer_init_sink(ajsb_writer_sink_cb cb, void *arg) {
+  if (!cb) return NULL;
+  ajsb_writer_t *w = writer_new(aml_buffer_init(CHUNK + 256), true);
+  w->cb = cb;
+  w->arg = arg;
+  return w;
+}
+
+static bool fd_sink(void *arg, const char *data, size_t len) {
+  int fd = ((ajsb_writer_t *)arg)->fd;
+  while (len) {
+    ssize_t n = write(fd, data, len);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    data += n;
+    len -= (size_t)n;
+  }
+  return true;
+}
+
+ajsb_writer_t *ajsb_writer_init_fd(int fd) {
+  if (fd < 0) return NULL;
+  ajsb_writer_t *w = ajsb_writer_init_sink(fd_sink, NULL);
+  w->arg = w;
+  w->fd = fd;
+  return w;
+}
+
+bool ajsb_writer_finish(ajsb_writer_t *w) {
+  if (!w) return false;
+  if (!w->error && (w->depth || !w->done)) fail(w, "schema is incomplete");
+  flush(w);
+  return !w->error;
+}
+
+void ajsb_writer_reset(ajsb_writer_t *w) {
+  if (!w) return;
+  if (w->own_out) aml_buffer_clear(w->out);
+  aml_buffer_clear(w->names);
+  w->depth = 0;
+  w->done = false;
+  w->error = NULL;
+}
+
+void ajsb_writer_destroy(ajsb_writer_t *w) {
+  if (!w) return;
+  if (w->own_out) aml_buffer_destroy(w->out);
+  aml_buffer_destroy(w->names);
+  aml_free(w);
+}
+
+const char *ajsb_writer_error(const ajsb_writer_t *w) { return w ? w->error : NULL; }
+
+/* ── Schemas ────────────────────────────────────────────────────────────── */
+
+void ajsb_writer_object (ajsb_writer_t *w) { if (w) open_schema(w, "object");  }
+void ajsb_writer_array  (ajsb_writer_t *w) { if (w) open_schema(w, "array");   }
+void ajsb_writer_string (ajsb_writer_t *w) { if (w) open_schema(w, "string");  }
+void ajsb_writer_number (ajsb_writer_t *w) { if (w) open_schema(w, "number");  }
+void ajsb_writer_integer(ajsb_writer_t *w) { if (w) open_schema(w, "integer"); }
+void ajsb_writer_boolean(ajsb_writer_t *w) { if (w) open_schema(w, "boolean"); }
+void ajsb_writer_null   (ajsb_writer_t *w) { if (w) open_schema(w, "null");    }
+void ajsb_writer_schema (ajsb_writer_t *w) { if (w) open_schema(w, NULL);      }
+
+void ajsb_writer_ref(ajsb_writer_t *w, const char *ref) {
+  if (!w) return;
+  open_schema(w, NULL);
+  if (ref && *ref) str_keyword(w, "$ref", ref);
+}
+
+void ajsb_writer_dynamic_ref(ajsb_writer_t *w, const char *ref) {
+  if (!w) return;
+  open_schema(w, NULL);
+  if (ref && *ref) str_keyword(w, "$dynamicRef", ref);
+}
+
+void ajsb_writer_anyOf(ajsb_writer_t *w) { if (w) combinator(w, "anyOf"); }
+void ajsb_writer_oneOf(ajsb_writer_t *w) { if (w) combinator(w, "oneOf"); }
+void ajsb_writer_allOf(ajsb_writer_t *w) { if (w) combinator(w, "allOf"); }
+
+void ajsb_writer_end(ajsb_writer_t *w) {
+  if (!w || w->error) return;
+  frame_t *f = top(w);
+  if (!f) { fail(w, "end without an open schema"); return; }
+  if (f->kind == F_LIST) {
+    put(w, "]}", 2);
+  } else {
+    if (f->await) { fail(w, "slot closed without a schema"); return; }
+    close_group(w, f);
+    put(w, "}", 1);
+  }
+  aml_buffer_shrink_by(w->names, aml_buffer_length(w->names) - f->req_off);
+  if (--w->depth == 0) w->done = true;
+}
+
+/* ── Slots ──────────────────────────────────────────────────────────────── */
+
+void ajsb_writer_prop(ajsb_writer_t *w, const char *name) {
+  if (!w || !name || !*name) return;
+  slot(w, G_PROPS, name);
+}
+
+void ajsb_writer_prop_required(ajsb_writer_t *w, const char *name) {
+  if (!w || !name || !*name) return;
+  if (!slot(w, G_PROPS, name)) return;
+  if (top(w)->done & D_REQUIRED) { fail(w, "required already written"); return; }
+  escape(w->names, name);
+  aml_buffer_appendc(w->names, '\0');
+}
+
+void ajsb_writer_def(ajsb_writer_t *w, const char *name) {
+  if (!w || !name || !*name) return;
+  slot(w, G_DEFS, name);
+}
+
+void ajsb_writer_items(ajsb_writer_t *w) {
+  if (w && keyword(w, "items")) top(w)->await = true;
+}
+
+/* ── Keywords ───────────────────────────────────────────────────────────── */
+
+void ajsb_writer_required(ajsb_writer_t *w, size_t n, const char *const *names) {
+  if (!w || w->error) return;
+  frame_t *f = top(w);
+  if (f && f->kind == F_SCHEMA && !f->await) close_group(w, f);
+  if (f && (f->done & D_REQUIRED)) { fail(w, "required already written"); return; }
+  if (!keyword(w, "required")) return;
+  put(w, "[", 1);
+  bool first = true;
+  for (size_t i = 0; i < n; ++i) {
+    if (!names || !names[i] || !*names[i]) continue;
+    if (!first) put(w, ",", 1);
+    first = false;
+    put_str(w, names[i]);
+  }
+  put(w, "]", 1);
+  f->done |= D_REQUIRED;
+}
+
+void ajsb_writer_additional_properties(ajsb_writer_t *w, bool allowed) {
+  if (w && keyword(w, "additionalProperties")) puts_(w, allowed ? "true" : "false");
+}
+
+void ajsb_writer_title(ajsb_writer_t *w, const char *title) {
+  if (w && title) str_keyword(w, "title", title);
+}
+
+void ajsb_writer_description(ajsb_writer_t *w, const char *description) {
+  if (w && description) str_keyword(w, "description", description);
+}
+
+void ajsb_writer_default_str(ajsb_writer_t *w, const char *def_val) {
+  if (w && def_val) str_keyword(w, "default", def_val);
+}
+
+void ajsb_writer_string_format(ajsb_writer_t *w, const char *format) {
+  if (w && format && *format) str_keyword(w, "format", format);
+}
+
+void ajsb_writer_string_pattern(ajsb_writer_t *w, const char *regex) {
+  if (w && regex && *regex) str_keyword(w, "pattern", regex);
+}
+
+void ajsb_writer_string_enum(ajsb_writer_t *w, size_t n, const char *const *values) {
+  if (!w || !keyword(w, "enum")) return;
+  put(w, "[", 1);
+  bool first = true;
+  for (size_t i = 0; i < n; ++i) {
+    if (!values || !values[i] || !*values[i]) continue;
+    if (!first) put(w, ",", 1);
+    first = false;
+    put_str(w, values[i]);
+  }
+  put(w, "]", 1);
+}
+
+static void number_kw(ajsb_writer_t *w, const char *kw, double v) {
+  char tmp[32];
+  int n = snprintf(tmp, sizeof(tmp), "%g", v);
+  if (keyword(w, kw)) put(w, tmp, (size_t)n);
+}
+
+void ajsb_writer_number_min(ajsb_writer_t *w, double min, bool exclusive) {
+  if (w) number_kw(w, exclusive ? "exclusiveMinimum" : "minimum", min);
+}
+
+void ajsb_writer_number_max(ajsb_writer_t *w, double max, bool exclusive) {
+  if (w) number_kw(w, exclusive ? "exclusiveMaximum" : "maximum", max);
+}
+
+static void int_kw(ajsb_writer_t *w, const char *kw, int v) {
+  char tmp[16];
+  int n = snprintf(tmp, sizeof(tmp), "%d", v);
+  if (keyword(w, kw)) put(w, tmp, (size_t)n);
+}
+
+void ajsb_writer_array_min_items(ajsb_writer_t *w, int min_items) {
+  if (w && min_items >= 0) int_kw(w, "minItems", min_items);
+}
+
+void ajsb_writer_array_max_items(ajsb_writer_t *w, int max_items) {
+  if (w && max_items >= 0) int_kw(w, "maxItems", max_items);
+}
+
+void ajsb_writer_array_unique(ajsb_writer_t *w, bool on) {
+  if (w && keyword(w, "uniqueItems")) puts_(w, on ? "true" : "false");
+}
+
+void ajsb_writer_set_id(ajsb_writer_t *w, const char *uri) {
+  if (w && uri && *uri) str_keyword(w, "$id", uri);
+}
+
+void ajsb_writer_set_schema(ajsb_writer_t *w, const char *uri) {
+  if (w && uri && *uri) str_keyword(w, "$schema", uri);
+}
+
+void ajsb_writer_anchor(ajsb_writer_t *w, const char *name) {
+  if (w && name && *name) str_keyword(w, "$anchor", name);
+}
+
+void ajsb_writer_dynamic_anchor(ajsb_writer_t *w, const char *name) {
+  if (w && name && *name) str_keyword(w, "$dynamicAnchor", name);
+}
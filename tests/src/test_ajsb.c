@@ -381,6 +381,38 @@ MACRO_TEST(ajsb_dynamic_keys_memory_safety) {
   aml_pool_destroy(p);
 }
 
+/* ---------- 13) shared_leaves ---------- */
+MACRO_TEST(ajsb_shared_leaves) {
+  aml_pool_t *p = aml_pool_init(1024);
+
+  ajson_t *s = ajsb_shared_string();
+  MACRO_ASSERT_TRUE(s == ajsb_shared_string());
+  MACRO_ASSERT_TRUE(ajsb_is_shared(s));
+  MACRO_ASSERT_TRUE(!ajsb_is_shared(ajsb_string(p)));
+  MACRO_ASSERT_STREQ(J(p, s), J(p, ajsb_string(p)));
+  MACRO_ASSERT_STREQ(J(p, ajsb_shared_integer()), "{\"type\":\"integer\"}");
+  MACRO_ASSERT_STREQ(J(p, ajsb_shared_false()), "false");
+
+  /* shared leaves build the same text as pool leaves */
+  ajson_t *a = ajsb_object(p), *b = ajsb_object(p);
+  ajsb_prop_required(p, a, "name", ajsb_string(p));
+  ajsb_prop(p, a, "age", ajsb_integer(p));
+  ajsb_prop_required(p, b, "name", ajsb_shared_string());
+  ajsb_prop(p, b, "age", ajsb_shared_integer());
+  MACRO_ASSERT_STREQ(J(p, a), J(p, b));
+
+  /* shared nodes are read-only; cow gives a private copy */
+  MACRO_ASSERT_STREQ(J(p, s), "{\"type\":\"string\"}");
+  ajson_t *email = ajsb_cow(p, s);
+  MACRO_ASSERT_TRUE(email != s && !ajsb_is_shared(email));
+  ajsb_string_format(p, email, "email");
+  MACRO_ASSERT_STREQ(J(p, email), "{\"type\":\"string\",\"format\":\"email\"}");
+  MACRO_ASSERT_STREQ(J(p, s), "{\"type\":\"string\"}");
+  MACRO_ASSERT_TRUE(ajsb_cow(p, email) == email);
+
+  aml_pool_destroy(p);
+}
+
 /* ---------- Runner ---------- */
 int main(void) {
   macro_test_case tests[64];
@@ -400,6 +432,7 @@ int main(void) {
   MACRO_ADD(tests, ajsb_metadata_helpers);
   MACRO_ADD(tests, ajsb_convenience_prop_required);
   MACRO_ADD(tests, ajsb_dynamic_keys_memory_safety);
+  MACRO_ADD(tests, ajsb_shared_leaves);
 
   macro_run_all("a-json-schema-builder/ajsb_examples", tests, test_count);
   return 0;
@@ -0,0 +1,126 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#include "a-json-schema-builder-library/ajsb.h"
+#include "a-json-schema-builder-library/ajsb_batch.h"
+#include "a-json-schema-builder-library/ajsb_validate.h"
+#include "a-json-library/ajson.h"
+#include "a-memory-library/aml_buffer.h"
+#include "a-memory-library/aml_pool.h"
+#include "the-macro-library/macro_test.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+
+static ajsb_program_t *record_program(aml_pool_t *p) {
+  ajson_t *o = ajsb_object(p);
+  ajson_t *n = ajsb_integer(p);
+  ajsb_number_min(p, n, 0, false);
+  ajsb_prop_required(p, o, "n", n);
+  ajsb_prop(p, o, "tag", ajsb_string(p));
+  return ajsb_compile(p, o);
+}
+
+/* Line i (0-based) of the generated input and its expected status. */
+static uint8_t make_line(aml_buffer_t *bh, int i) {
+  switch (i % 7) {
+    case 0:  aml_buffer_appendf(bh, "{\"n\":%d,\"tag\":\"t%d\"}\n", i, i); return AJSB_BATCH_VALID;
+    case 1:  aml_buffer_appendf(bh, "{\"n\":-%d}\n", i);               return AJSB_BATCH_INVALID;
+    case 2:  aml_buffer_appends(bh, "\n");                             return AJSB_BATCH_BLANK;
+    case 3:  aml_buffer_appendf(bh, "{\"n\":%d\n", i);                 return AJSB_BATCH_PARSE_ERROR;
+    case 4:  aml_buffer_appendf(bh, "  {\"n\":%d}  \r\n", i);          return AJSB_BATCH_VALID;
+    case 5:  aml_buffer_appendf(bh, "{\"tag\":\"%d\"}\n", i);          return AJSB_BATCH_INVALID;
+    default: aml_buffer_appendf(bh, "{\"n\":%d,\"tag\":\"%0*d\"}\n", i, i % 300, 0);
+             return AJSB_BATCH_VALID;
+  }
+}
+
+/* ---------- 1) chunks_and_threads ---------- */
+MACRO_TEST(ajsb_batch_chunks_and_threads) {
+  aml_pool_t *p = aml_pool_init(4096);
+  ajsb_program_t *prog = record_program(p);
+
+  enum { N = 5000 };
+  aml_buffer_t *bh = aml_buffer_init(1 << 16);
+  static uint8_t expect[N];
+  size_t counts[4] = {0};
+  for (int i = 0; i < N; i++) counts[expect[i] = make_line(bh, i)]++;
+
+  size_t chunks[] = { 0, 1, 7, 64, 4096 };
+  int threads[] = { 1, 3, 8 };
+  for (size_t c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++) {
+    for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); t++) {
+      ajsb_batch_options_t o = { threads[t], chunks[c], true };
+      ajsb_batch_result_t r;
+      MACRO_ASSERT_TRUE(ajsb_validate_batch(prog, aml_buffer_data(bh), aml_buffer_length(bh), &o, &r));
+      MACRO_ASSERT_TRUE(r.lines == N);
+      MACRO_ASSERT_TRUE(r.valid == counts[AJSB_BATCH_VALID]);
+      MACRO_ASSERT_TRUE(r.invalid == counts[AJSB_BATCH_INVALID]);
+      MACRO_ASSERT_TRUE(r.parse_errors == counts[AJSB_BATCH_PARSE_ERROR]);
+      MACRO_ASSERT_TRUE(r.blank == counts[AJSB_BATCH_BLANK]);
+      MACRO_ASSERT_TRUE(!memcmp(r.status, expect, N));
+      ajsb_batch_result_destroy(&r);
+    }
+  }
+
+  /* counts only, default options */
+  ajsb_batch_result_t r;
+  MACRO_ASSERT_TRUE(ajsb_validate_batch(prog, aml_buffer_data(bh), aml_buffer_length(bh), NULL, &r));
+  MACRO_ASSERT_TRUE(r.lines == N && r.status == NULL);
+  MACRO_ASSERT_TRUE(r.invalid == counts[AJSB_BATCH_INVALID]);
+
+  aml_buffer_destroy(bh);
+  aml_pool_destroy(p);
+}
+
+/* ---------- 2) edges ---------- */
+MACRO_TEST(ajsb_batch_edges) {
+  aml_pool_t *p = aml_pool_init(4096);
+  ajsb_program_t *prog = record_program(p);
+  ajsb_batch_options_t o = { 2, 3, true };
+  ajsb_batch_result_t r;
+
+  /* last line without '\n' */
+  const char *s = "{\"n\":1}\n{\"n\":-1}";
+  MACRO_ASSERT_TRUE(ajsb_validate_batch(prog, s, strlen(s), &o, &r));
+  MACRO_ASSERT_TRUE(r.lines == 2 && r.valid == 1 && r.invalid == 1);
+  MACRO_ASSERT_TRUE(r.status[1] == AJSB_BATCH_INVALID);
+  ajsb_batch_result_destroy(&r);
+
+  /* empty input */
+  MACRO_ASSERT_TRUE(ajsb_validate_batch(prog, "", 0, &o, &r));
+  MACRO_ASSERT_TRUE(r.lines == 0);
+  ajsb_batch_result_destroy(&r);
+
+  MACRO_ASSERT_TRUE(!ajsb_validate_batch(NULL, s, strlen(s), &o, &r));
+  MACRO_ASSERT_TRUE(!ajsb_validate_batch_file(prog, "no/such/file.jsonl", &o, &r));
+
+  /* from a file */
+  const char *path = "ajsb_batch_test.jsonl";
+  FILE *fp = fopen(path, "wb");
+  MACRO_ASSERT_TRUE(fp != NULL);
+  for (int i = 0; i < 1000; i++) fprintf(fp, i % 10 ? "{\"n\":%d}\n" : "{\"n\":\"%d\"}\n", i);
+  fclose(fp);
+  MACRO_ASSERT_TRUE(ajsb_validate_batch_file(prog, path, NULL, &r));
+  MACRO_ASSERT_TRUE(r.lines == 1000 && r.valid == 900 && r.invalid == 100);
+  ajsb_batch_result_destroy(&r);
+  remove(path);
+
+  aml_pool_destroy(p);
+}
+
+/* ---------- Runner ---------- */
+int main(void) {
+  macro_test_case tests[16];
+  size_t test_count = 0;
+
+  MACRO_ADD(tests, ajsb_batch_chunks_and_threads);
+  MACRO_ADD(tests, ajsb_batch_edges);
+
+  macro_run_all("a-json-schema-builder/ajsb_batch", tests, test_count);
+  return 0;
+}
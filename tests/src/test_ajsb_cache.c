@@ -0,0 +1,284 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#include "a-json-schema-builder-library/ajsb.h"
+#include "a-json-schema-builder-library/ajsb_cache.h"
+#include "a-json-schema-builder-library/ajsb_derive.h"
+#include "a-json-schema-builder-library/ajsb_index.h"
+#include "a-json-schema-builder-library/ajsb_intern.h"
+#include "a-json-library/ajson.h"
+#include "a-memory-library/aml_pool.h"
+#include "the-macro-library/macro_test.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+
+static ajson_t *order_schema(aml_pool_t *p) {
+  ajson_t *s = ajsb_object(p);
+  ajsb_title(p, s, "Order");
+  ajson_t *addr = ajsb_object(p);
+  ajsb_prop_required(p, addr, "street", ajsb_string(p));
+  ajsb_prop(p, addr, "zip", ajsb_string(p));
+  ajsb_defs_add(p, s, "address", addr);
+  ajsb_prop_required(p, s, "ship", ajsb_ref(p, "#/$defs/address"));
+  ajson_t *items = ajsb_object(p);
+  ajsb_prop_required(p, items, "sku", ajsb_string(p));
+  ajsb_prop(p, items, "qty", ajsb_integer(p));
+  ajsb_prop(p, s, "items", ajsb_array(p, items));
+  static const char *const states[] = {"new", "paid"};
+  ajson_t *status = ajsb_string(p);
+  ajsb_string_enum(p, status, 2, states);
+  ajsb_prop(p, s, "status", status);
+  return s;
+}
+
+static bool same(ajsb_cache_t *c, aml_pool_t *p, ajson_t *s) {
+  size_t len;
+  const char *text = ajsb_cache_stringify(c, s, &len);
+  const char *want = ajsb_stringify(p, s);
+  return text && len == strlen(want) && !strcmp(text, want);
+}
+
+/* ---------- 1) text ---------- */
+MACRO_TEST(ajsb_cache_text) {
+  aml_pool_t *p = aml_pool_init(4096);
+  ajsb_cache_t *c = ajsb_cache_init();
+  ajson_t *s = order_schema(p);
+  MACRO_ASSERT_TRUE(same(c, p, s));
+  MACRO_ASSERT_TRUE(same(c, p, s));                    /* nothing changed */
+
+  /* every in-place mutator is seen */
+  ajson_t *props = ajsono_scan(s, "properties");
+  ajson_t *addr = ajsono_scan(ajsono_scan(s, "$defs"), "address");
+  ajsb_prop(p, addr, "city", ajsb_string(p));
+  MACRO_ASSERT_TRUE(same(c, p, s));
+  static const char *const more[] = {"new", "paid", "shipped"};
+  ajsb_string_enum(p, ajsono_scan(props, "status"), 3, more);
+  MACRO_ASSERT_TRUE(same(c, p, s));
+  ajsb_prop_required(p, ajsono_scan(ajsono_scan(props, "items"), "items"), "note", ajsb_string(p));
+  MACRO_ASSERT_TRUE(same(c, p, s));
+  ajsb_number_min(p, ajsono_scan(ajsono_scan(ajsono_scan(ajsono_scan(props, "items"), "items"),
+                                             "properties"), "qty"), 1, false);
+  MACRO_ASSERT_TRUE(same(c, p, s));
+  ajsb_defs_set(p, s, "address", ajsb_string(p));
+  MACRO_ASSERT_TRUE(same(c, p, s));
+  ajsb_additional_properties(p, s, false);
+  MACRO_ASSERT_TRUE(same(c, p, s));
+
+  ajsb_index_t *ix = ajsb_index_init(p);
+  ajsb_index_prop_required(ix, s, "id", ajsb_string(p));
+  ajsb_index_prop(ix, s, "id", ajsb_integer(p));
+  MACRO_ASSERT_TRUE(same(c, p, s));
+
+  ajsb_intern_t *in = ajsb_intern_init();
+  ajsb_prop(p, s, "again", order_schema(p));
+  MACRO_ASSERT_TRUE(same(c, p, s));
+  ajsb_intern(in, s);
+  MACRO_ASSERT_TRUE(same(c, p, s));
+  ajsb_intern_destroy(in);
+
+  /* a derived tree shares the base's nodes and copies what it changes */
+  ajsb_derive_t *d = ajsb_derive(p, s);
+  ajson_t *root = ajsb_derive_root(d);
+  MACRO_ASSERT_TRUE(same(c, p, root));
+  ajsb_prop(p, ajsb_derive_at(d, "#/properties/again"), "extra", ajsb_null(p));
+  MACRO_ASSERT_TRUE(same(c, p, root));
+  MACRO_ASSERT_TRUE(same(c, p, s));
+
+  /* a subtree, then the tree holding it */
+  MACRO_ASSERT_TRUE(same(c, p, props));
+  MACRO_ASSERT_TRUE(same(c, p, s));
+  size_t len = 1;
+  MACRO_ASSERT_TRUE(ajsb_cache_stringify(c, NULL, &len) == NULL && len == 0);
+
+  ajsb_cache_destroy(c);
+  aml_pool_destroy(p);
+}
+
+/* ---------- 2) incremental ---------- */
+MACRO_TEST(ajsb_cache_incremental) {
+  aml_pool_t *p = aml_pool_init(4096);
+  ajsb_cache_t *c = ajsb_cache_init();
+  ajson_t *s = order_schema(p);
+  ajsb_cache_stringify(c, s, NULL);
+
+  /* change a subtree behind the cache's back: clean subtrees are copied, so
+     the old bytes come out until it is touched */
+  ajson_t *items = ajsono_scan(ajsono_scan(s, "properties"), "items");
+  ajsono_set(items, "minItems", ajson_number(p, 1), false);
+  ajsb_title(p, s, "Order v2");                      /* the root is re-emitted */
+  const char *text = ajsb_cache_stringify(c, s, NULL);
+  MACRO_ASSERT_TRUE(strstr(text, "\"Order v2\"") && !strstr(text, "minItems"));
+  ajsb_touch(items);
+  MACRO_ASSERT_TRUE(same(c, p, s));
+
+  /* every live cache hears a touch */
+  ajsb_cache_t *c2 = ajsb_cache_init();
+  MACRO_ASSERT_TRUE(same(c2, p, s));
+  ajsb_array_max_items(p, items, 9);
+  MACRO_ASSERT_TRUE(same(c, p, s) && same(c2, p, s));
+  ajsb_cache_destroy(c2);
+
+  /* a node under several parents; touching it forgets everything */
+  ajson_t *shared = ajsb_object(p);
+  ajsb_prop(p, shared, "v", ajsb_string(p));
+  ajsb_prop(p, s, "a", shared);
+  ajsb_prop(p, s, "b", shared);
+  ajsb_prop(p, items, "c", shared);
+  MACRO_ASSERT_TRUE(same(c, p, s));
+  ajsb_prop(p, shared, "w", ajsb_number(p));
+  MACRO_ASSERT_TRUE(same(c, p, s));
+
+  /* many small edits: older buffers are released or compacted */
+  for (int i = 0; i < 2000; i++) {
+    char name[16];
+    snprintf(name, sizeof(name), "p%d", i % 50);
+    ajson_t *t = i % 3 ? items : ajsono_scan(ajsono_scan(s, "$defs"), "address");
+    ajsb_prop(p, i % 7 ? s : t, name, i % 2 ? ajsb_string(p) : ajsb_integer(p));
+    if (i % 97 == 0) MACRO_ASSERT_TRUE(same(c, p, s));
+    else ajsb_cache_stringify(c, s, NULL);
+  }
+  MACRO_ASSERT_TRUE(same(c, p, s));
+
+  /* after the pool goes away, reset */
+  ajsb_cache_reset(c);
+  aml_pool_clear(p);
+  s = order_schema(p);
+  MACRO_ASSERT_TRUE(same(c, p, s));
+
+  ajsb_cache_destroy(c);
+  aml_pool_destroy(p);
+}
+
+/* ---------- 3) fingerprints ---------- */
+MACRO_TEST(ajsb_cache_fingerprints) {
+  aml_pool_t *p = aml_pool_init(4096);
+  ajsb_cache_t *c = ajsb_cache_init(), *c2 = ajsb_cache_init();
+  ajson_t *a = order_schema(p), *b = order_schema(p);
+
+  /* by content, cached or not, in any cache */
+  uint64_t fa = ajsb_cache_fingerprint(c, a);
+  MACRO_ASSERT_TRUE(fa != 0 && fa == ajsb_cache_fingerprint(c2, b));
+  ajsb_cache_stringify(c, a, NULL);
+  MACRO_ASSERT_TRUE(ajsb_cache_fingerprint(c, a) == fa);
+
+  /* a change moves the fingerprint of the touched path only */
+  ajson_t *defs = ajsono_scan(a, "$defs");
+  ajson_t *props = ajsono_scan(a, "properties");
+  uint64_t fd = ajsb_cache_fingerprint(c, defs), fp = ajsb_cache_fingerprint(c, props);
+  ajsb_prop(p, ajsono_scan(defs, "address"), "city", ajsb_string(p));
+  MACRO_ASSERT_TRUE(ajsb_cache_fingerprint(c, a) != fa);
+  MACRO_ASSERT_TRUE(ajsb_cache_fingerprint(c, defs) != fd);
+  MACRO_ASSERT_TRUE(ajsb_cache_fingerprint(c, props) == fp);
+  ajsb_prop(p, ajsono_scan(ajsono_scan(b, "$defs"), "address"), "city", ajsb_string(p));
+  MACRO_ASSERT_TRUE(ajsb_cache_fingerprint(c, a) == ajsb_cache_fingerprint(c2, b));
+
+  /* text decides: member order, strings vs numbers, nesting */
+  MACRO_ASSERT_TRUE(ajsb_cache_fingerprint(c, ajson_parse_string(p, aml_pool_strdup(p, "{\"a\":1,\"b\":2}"))) !=
+                    ajsb_cache_fingerprint(c, ajson_parse_string(p, aml_pool_strdup(p, "{\"b\":2,\"a\":1}"))));
+  MACRO_ASSERT_TRUE(ajsb_cache_fingerprint(c, ajson_parse_string(p, aml_pool_strdup(p, "[\"1\"]"))) !=
+                    ajsb_cache_fingerprint(c, ajson_parse_string(p, aml_pool_strdup(p, "[1]"))));
+  MACRO_ASSERT_TRUE(ajsb_cache_fingerprint(c, ajson_parse_string(p, aml_pool_strdup(p, "[[]]"))) !=
+                    ajsb_cache_fingerprint(c, ajson_parse_string(p, aml_pool_strdup(p, "[]"))));
+  MACRO_ASSERT_TRUE(ajsb_cache_fingerprint(c, NULL) == 0);
+
+  ajsb_cache_destroy(c);
+  ajsb_cache_destroy(c2);
+  aml_pool_destroy(p);
+}
+
+/* ---------- 4) touches elsewhere ---------- */
+static void *builder_main(void *arg) {
+  bool *done = (bool *)arg;
+  aml_pool_t *p = aml_pool_init(4096);
+  while (!__atomic_load_n(done, __ATOMIC_ACQUIRE)) {
+    order_schema(p);
+    aml_pool_clear(p);
+  }
+  aml_pool_destroy(p);
+  return NULL;
+}
+
+/* builds and discards trees until more than 16384 nodes were touched */
+static void *count_main(void *arg) {
+  size_t *built = (size_t *)arg;
+  aml_pool_t *p = aml_pool_init(4096);
+  while (*built <= 20000) {
+    ajson_t *o = ajsb_object(p);
+    for (int i = 0; i < 100; i++) {
+      char name[16];
+      snprintf(name, sizeof(name), "f%d", i);
+      ajsb_prop(p, o, name, ajsb_string(p));
+    }
+    *built += 100;
+    aml_pool_clear(p);
+  }
+  aml_pool_destroy(p);
+  return NULL;
+}
+
+MACRO_TEST(ajsb_cache_foreign_touches) {
+  aml_pool_t *p = aml_pool_init(4096);
+  ajsb_cache_t *c = ajsb_cache_init();
+  ajson_t *s = order_schema(p);
+  ajson_t *items = ajsono_scan(ajsono_scan(s, "properties"), "items");
+  MACRO_ASSERT_TRUE(same(c, p, s));
+
+  /* a tree no cache holds is not logged, however much it changes: another
+     thread builds past the log size and the next stringify still copies
+     the clean subtrees (a change made behind the cache's back stays out) */
+  ajson_t *addr = ajsono_scan(ajsono_scan(s, "$defs"), "address");
+  ajsono_set(addr, "zz", ajson_number(p, 1), false);
+  size_t built = 0;
+  pthread_t bt;
+  pthread_create(&bt, NULL, count_main, &built);
+  pthread_join(bt, NULL);
+  MACRO_ASSERT_TRUE(built > 16384);
+  ajsb_array_min_items(p, items, 2);
+  const char *text = ajsb_cache_stringify(c, s, NULL);
+  MACRO_ASSERT_TRUE(strstr(text, "\"minItems\":2") && !strstr(text, "\"zz\""));
+  ajsb_touch(addr);
+  MACRO_ASSERT_TRUE(same(c, p, s));
+
+  /* more touches on held nodes than the log holds: the next stringify
+     starts afresh */
+  for (int i = 0; i < 40000; i++) ajsb_touch(items);
+  ajsb_array_min_items(p, items, 3);
+  MACRO_ASSERT_TRUE(same(c, p, s));
+
+  /* other threads building other trees do not block or confuse this one */
+  enum { BUILDERS = 4 };
+  bool done = false;
+  pthread_t t[BUILDERS];
+  for (int i = 0; i < BUILDERS; i++) pthread_create(t + i, NULL, builder_main, &done);
+  for (int i = 0; i < 500; i++) {
+    char name[16];
+    snprintf(name, sizeof(name), "q%d", i % 40);
+    ajsb_prop(p, i % 2 ? s : items, name, i % 3 ? ajsb_string(p) : ajsb_integer(p));
+    MACRO_ASSERT_TRUE(same(c, p, s));
+  }
+  __atomic_store_n(&done, true, __ATOMIC_RELEASE);
+  for (int i = 0; i < BUILDERS; i++) pthread_join(t[i], NULL);
+
+  ajsb_cache_destroy(c);
+  aml_pool_destroy(p);
+}
+
+/* ---------- Runner ---------- */
+int main(void) {
+  macro_test_case tests[16];
+  size_t test_count = 0;
+
+  MACRO_ADD(tests, ajsb_cache_text);
+  MACRO_ADD(tests, ajsb_cache_incremental);
+  MACRO_ADD(tests, ajsb_cache_fingerprints);
+  MACRO_ADD(tests, ajsb_cache_foreign_touches);
+
+  macro_run_all("a-json-schema-builder/ajsb_cache", tests, test_count);
+  return 0;
+}
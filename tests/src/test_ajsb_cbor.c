@@ -0,0 +1,218 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#include "a-json-schema-builder-library/ajsb.h"
+#include "a-json-schema-builder-library/ajsb_cbor.h"
+#include "a-json-library/ajson.h"
+#include "a-memory-library/aml_buffer.h"
+#include "a-memory-library/aml_pool.h"
+#include "the-macro-library/macro_test.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+
+static ajson_t *P(aml_pool_t *p, const char *s) { return ajson_parse_string(p, aml_pool_strdup(p, s)); }
+
+static bool bytes_are(aml_buffer_t *bh, const char *hex) {
+  char out[256] = "";
+  const unsigned char *d = (const unsigned char *)aml_buffer_data(bh);
+  for (size_t i = 0; i < aml_buffer_length(bh) && 2 * i + 3 < sizeof(out); i++)
+    snprintf(out + 2 * i, 3, "%02x", d[i]);
+  return !strcmp(out, hex);
+}
+
+static const char *text_of(aml_pool_t *p, aml_buffer_t *bh) {
+  ajson_t *j = ajsb_decode_cbor(p, aml_buffer_data(bh), aml_buffer_length(bh));
+  return j ? ajson_stringify(p, j) : NULL;
+}
+
+/* ---------- 1) round_trip ---------- */
+MACRO_TEST(ajsb_cbor_round_trip) {
+  aml_pool_t *p = aml_pool_init(1024);
+  aml_buffer_t *bh = aml_buffer_init(256);
+
+  ajson_t *s = ajsb_object(p);
+  ajsb_title(p, s, "Order \"A\"");
+  ajson_t *qty = ajsb_integer(p);
+  ajsb_number_min(p, qty, -5, false);
+  ajsb_number_max(p, qty, 100000, false);
+  ajsb_prop_required(p, s, "qty", qty);
+  ajson_t *price = ajsb_number(p);
+  ajsb_number_min(p, price, 0.5, true);
+  ajsb_number_max(p, price, 1e300, false);
+  ajsb_prop(p, s, "price", price);
+  ajsb_prop(p, s, "x-note\tcustom", ajsb_string(p));
+  MACRO_ASSERT_TRUE(ajsb_encode_cbor(bh, s));
+
+  /* keyword keys come back as themselves, custom keys and escapes intact */
+  ajson_t *back = ajsb_decode_cbor(p, aml_buffer_data(bh), aml_buffer_length(bh));
+  MACRO_ASSERT_TRUE(back && ajson_is_object(back));
+  MACRO_ASSERT_TRUE(!strcmp(ajson_to_strd(p, ajsono_scan(back, "title"), ""), "Order \"A\""));
+  ajson_t *props = ajsono_scan(back, "properties");
+  MACRO_ASSERT_TRUE(ajsono_scan(props, "x-note\\tcustom") != NULL);
+  ajson_t *q = ajsono_scan(props, "qty");
+  MACRO_ASSERT_TRUE(!strcmp(ajson_to_str(ajsono_scan(q, "minimum"), ""), "-5"));
+  MACRO_ASSERT_TRUE(!strcmp(ajson_to_str(ajsono_scan(q, "maximum"), ""), "100000"));
+  ajson_t *pr = ajsono_scan(props, "price");
+  MACRO_ASSERT_TRUE(ajson_is_decimal(ajsono_scan(pr, "exclusiveMinimum")) &&
+                    ajson_to_double(ajsono_scan(pr, "exclusiveMinimum"), 0) == 0.5);
+  MACRO_ASSERT_TRUE(ajson_to_double(ajsono_scan(pr, "maximum"), 0) == 1e300);
+  MACRO_ASSERT_TRUE(ajsona_count(ajsono_scan(back, "required")) == 1);
+
+  /* the same text comes back: declared property order, keyword order */
+  aml_buffer_t *ordered = aml_buffer_init(256);
+  ajson_t *o = ajsb_object(p);
+  ajsb_prop_required(p, o, "zeta", ajsb_string(p));
+  ajsb_prop(p, o, "alpha", ajsb_integer(p));
+  ajsb_prop_required(p, o, "mid", ajsb_boolean(p));
+  ajsb_description(p, o, "last");
+  MACRO_ASSERT_TRUE(ajsb_encode_cbor(ordered, o));
+  MACRO_ASSERT_TRUE(!strcmp(text_of(p, ordered), ajson_stringify(p, o)));
+  aml_buffer_destroy(ordered);
+
+  /* re-encoding what was decoded gives the same bytes */
+  aml_buffer_t *again = aml_buffer_init(256);
+  MACRO_ASSERT_TRUE(ajsb_encode_cbor(again, back));
+  MACRO_ASSERT_TRUE(aml_buffer_length(again) == aml_buffer_length(bh) &&
+                    !memcmp(aml_buffer_data(again), aml_buffer_data(bh), aml_buffer_length(bh)));
+
+  /* decimals stay decimals, integers stay integers */
+  aml_buffer_clear(bh);
+  MACRO_ASSERT_TRUE(ajsb_encode_cbor(bh, P(p, "[1.0,2.5,18446744073709551615,-9223372036854775808,true,null]")));
+  MACRO_ASSERT_TRUE(!strcmp(text_of(p, bh), "[1.0,2.5,18446744073709551615,-9223372036854775808,true,null]"));
+  aml_buffer_clear(bh);
+  /* and neither loses digits: past 64 bits or a double, they are exact */
+  static const char *const exact =
+    "[123456789012345678901234567890,-18446744073709551617,-18446744073709551616,"
+    "0.12345678901234567890123,1e999,-25e-401,1234567890123456789012.0,0.000001000000000000000000001]";
+  aml_buffer_clear(bh);
+  MACRO_ASSERT_TRUE(ajsb_encode_cbor(bh, P(p, exact)));
+  MACRO_ASSERT_TRUE(!strcmp(text_of(p, bh), exact));
+  aml_buffer_t *twice = aml_buffer_init(256);
+  MACRO_ASSERT_TRUE(ajsb_encode_cbor(twice, ajsb_decode_cbor(p, aml_buffer_data(bh), aml_buffer_length(bh))));
+  MACRO_ASSERT_TRUE(aml_buffer_length(twice) == aml_buffer_length(bh) &&
+                    !memcmp(aml_buffer_data(twice), aml_buffer_data(bh), aml_buffer_length(bh)));
+  aml_buffer_destroy(twice);
+  aml_buffer_clear(bh);
+  MACRO_ASSERT_TRUE(ajsb_encode_cbor(bh, P(p, "[18446744073709551616,-18446744073709551617,1e999,1.5e-400]")));
+  MACRO_ASSERT_TRUE(bytes_are(bh, "84" "c249010000000000000000" "c349010000000000000000"
+                                  "c4821903e701" "c482390190" "0f"));
+  aml_buffer_clear(bh);
+  MACRO_ASSERT_TRUE(ajsb_encode_cbor(bh, P(p, "\"a\\\"b\\n\"")));      /* strings go out decoded */
+  MACRO_ASSERT_TRUE(bytes_are(bh, "646122620a"));
+
+  aml_buffer_destroy(again);
+  aml_buffer_destroy(bh);
+  aml_pool_destroy(p);
+}
+
+/* ---------- 2) canonical ---------- */
+MACRO_TEST(ajsb_cbor_canonical) {
+  aml_pool_t *p = aml_pool_init(1024);
+  aml_buffer_t *a = aml_buffer_init(64), *b = aml_buffer_init(64);
+
+  /* members keep their order, keyword or not, and decode back in it */
+  static const char *const zz = "{\"zz\":1,\"a\":2,\"type\":\"string\",\"required\":[]}";
+  static const char *const req = "{\"required\":[],\"a\":2,\"type\":\"string\",\"zz\":1}";
+  MACRO_ASSERT_TRUE(ajsb_encode_cbor(a, P(p, zz)));
+  MACRO_ASSERT_TRUE(ajsb_encode_cbor(b, P(p, req)));
+  MACRO_ASSERT_TRUE(bytes_are(a, "a4627a7a0161610200e50280"));
+  MACRO_ASSERT_TRUE(bytes_are(b, "a40280616102" "00e5627a7a01"));
+  MACRO_ASSERT_TRUE(!strcmp(text_of(p, a), zz) && !strcmp(text_of(p, b), req));
+
+  /* standard "type" and "format" values are one byte; others stay text */
+  aml_buffer_clear(a);
+  MACRO_ASSERT_TRUE(ajsb_encode_cbor(a, P(p, "{\"type\":[\"string\",\"null\"],\"format\":\"x-id\"}")));
+  MACRO_ASSERT_TRUE(bytes_are(a, "a20082e5e00b64782d6964"));
+  MACRO_ASSERT_TRUE(!strcmp(text_of(p, a), "{\"type\":[\"string\",\"null\"],\"format\":\"x-id\"}"));
+  aml_buffer_clear(a);
+  MACRO_ASSERT_TRUE(ajsb_encode_cbor(a, P(p, "{\"const\":{\"type\":5,\"format\":\"email\"}}")));
+  MACRO_ASSERT_TRUE(!strcmp(text_of(p, a), "{\"const\":{\"type\":5,\"format\":\"email\"}}"));
+
+  /* shortest heads and floats */
+  aml_buffer_clear(a);
+  ajsb_encode_cbor(a, P(p, "[23,24,255,256,-1,-25,1.5,0.1,100000.5,-0.0]"));
+  MACRO_ASSERT_TRUE(bytes_are(a, "8a171818" "18ff" "190100" "20" "3818" "f93e00"
+                                 "fb3fb999999999999a" "fa47c35040" "f98000"));
+
+  /* a schema built with the builders is far smaller than its JSON */
+  aml_buffer_clear(a);
+  ajson_t *s = ajsb_object(p);
+  for (int i = 0; i < 20; i++) {
+    char name[16];
+    snprintf(name, sizeof(name), "f%d", i);
+    ajson_t *f = ajsb_string(p);
+    ajsb_string_format(p, f, "email");
+    ajsb_prop_required(p, s, name, f);
+  }
+  ajsb_additional_properties(p, s, false);
+  MACRO_ASSERT_TRUE(ajsb_encode_cbor(a, s));
+  MACRO_ASSERT_TRUE(aml_buffer_length(a) * 3 <= strlen(ajson_stringify(p, s)));
+
+  aml_buffer_destroy(a);
+  aml_buffer_destroy(b);
+  aml_pool_destroy(p);
+}
+
+/* ---------- 3) malformed ---------- */
+MACRO_TEST(ajsb_cbor_malformed) {
+  aml_pool_t *p = aml_pool_init(1024);
+  aml_buffer_t *bh = aml_buffer_init(64);
+
+  /* encode failures leave the buffer as it was */
+  aml_buffer_appends(bh, "x");
+  MACRO_ASSERT_TRUE(!ajsb_encode_cbor(bh, P(p, "{\"type\":\"string\",\"const\":\"a\\u0000b\"}")));
+  MACRO_ASSERT_TRUE(!ajsb_encode_cbor(bh, P(p, "[1,2,1e99999999999999999999]")));
+  MACRO_ASSERT_TRUE(aml_buffer_length(bh) == 1);
+
+  static const struct { const char *bytes; size_t len; } bad[] = {
+    {"\x82\x01", 2},                  /* truncated array */
+    {"\x01\x02", 2},                  /* trailing bytes */
+    {"\x9f\x01\xff", 3},              /* indefinite length */
+    {"\xa1\x18\xff\x01", 4},          /* unknown keyword tag */
+    {"\xa1\x41\x61\x01", 4},          /* byte string key */
+    {"\x62\x61\x00", 3},              /* NUL in text */
+    {"\xf9\x7c\x00", 3},              /* infinity */
+    {"\xc1\x01", 2},                  /* other tags */
+    {"\xc2\x48\x01\x00\x00\x00\x00\x00\x00\x00", 10},   /* bignum that fits 64 bits */
+    {"\xc2\x49\x00\x01\x00\x00\x00\x00\x00\x00\x00", 11},  /* leading zero byte */
+    {"\xc2\x01", 2},                  /* bignum of an integer */
+    {"\xc4\x81\x01", 3},              /* decimal fraction of one item */
+    {"\xc4\x82\x01\xf6", 4},          /* ... or of null */
+    {"\xa1\x00\xf3", 3},              /* no such type name */
+    {"\x81\xe5", 2},                  /* name outside "type" */
+    {"\x9b\xff\xff\xff\xff\xff\xff\xff\xff", 9},   /* huge count */
+  };
+  for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++)
+    MACRO_ASSERT_TRUE(ajsb_decode_cbor(p, bad[i].bytes, bad[i].len) == NULL);
+
+  /* nesting deeper than the limit */
+  char deep[2000];
+  memset(deep, 0x81, sizeof(deep) - 1);
+  deep[sizeof(deep) - 1] = (char)0xf6;
+  MACRO_ASSERT_TRUE(ajsb_decode_cbor(p, deep, sizeof(deep)) == NULL);
+
+  /* self-describe tag, then {"type":"null"} */
+  ajson_t *j = ajsb_decode_cbor(p, "\xd9\xd9\xf7\xa1\x00\x64null", 10);
+  MACRO_ASSERT_TRUE(j && !strcmp(ajson_to_str(ajsono_scan(j, "type"), ""), "null"));
+
+  aml_buffer_destroy(bh);
+  aml_pool_destroy(p);
+}
+
+/* ---------- Runner ---------- */
+int main(void) {
+  macro_test_case tests[16];
+  size_t test_count = 0;
+
+  MACRO_ADD(tests, ajsb_cbor_round_trip);
+  MACRO_ADD(tests, ajsb_cbor_canonical);
+  MACRO_ADD(tests, ajsb_cbor_malformed);
+
+  macro_run_all("a-json-schema-builder/ajsb_cbor", tests, test_count);
+  return 0;
+}
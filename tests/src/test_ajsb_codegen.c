@@ -0,0 +1,178 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#include "a-json-schema-builder-library/ajsb.h"
+#include "a-json-schema-builder-library/ajsb_codegen.h"
+#include "a-json-schema-builder-library/ajsb_validate.h"
+#include "a-json-library/ajson.h"
+#include "a-memory-library/aml_buffer.h"
+#include "a-memory-library/aml_pool.h"
+#include "the-macro-library/macro_test.h"
+
+#include "codegen_order_validate.h"     /* generated by ajsb_add_validator */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+
+#define HAS(hay, needle) MACRO_ASSERT_TRUE(strstr((hay), (needle)) != NULL)
+
+static ajson_t *P(aml_pool_t *p, const char *s) { return ajson_parse_string(p, aml_pool_strdup(p, s)); }
+
+static char *read_file(aml_pool_t *p, const char *path) {
+  FILE *fp = fopen(path, "rb");
+  if (!fp) return NULL;
+  fseek(fp, 0, SEEK_END);
+  long n = ftell(fp);
+  fseek(fp, 0, SEEK_SET);
+  char *s = (char *)aml_pool_alloc(p, (size_t)n + 1);
+  s[fread(s, 1, (size_t)n, fp)] = '\0';
+  fclose(fp);
+  return s;
+}
+
+/* ---------- 1) matches_interpreter ---------- */
+MACRO_TEST(ajsb_codegen_matches_interpreter) {
+  aml_pool_t *p = aml_pool_init(8192);
+  char *text = read_file(p, AJSB_CODEGEN_SCHEMA);
+  MACRO_ASSERT_TRUE(text != NULL);
+  ajsb_program_t *prog = ajsb_compile(p, ajson_parse_string(p, text));
+  MACRO_ASSERT_TRUE(prog != NULL);
+
+  static const char *const docs[] = {
+    "{\"id\":1,\"code\":\"aa01\",\"extra_required\":\"x\"}",
+    "{\"id\":1,\"code\":\"aa01\"}",
+    "{\"id\":0,\"code\":\"aa01\",\"extra_required\":\"x\"}",
+    "{\"id\":1.5,\"code\":\"aa01\",\"extra_required\":\"x\"}",
+    "{\"id\":2.0,\"code\":\"bb04\",\"extra_required\":\"x\"}",
+    "{\"id\":1e12,\"code\":\"aa01\",\"extra_required\":\"x\"}",
+    "{\"id\":1,\"code\":\"aa02\",\"extra_required\":\"x\"}",
+    "{\"id\":1,\"code\":\"x\",\"extra_required\":\"x\"}",
+    "{\"id\":1,\"code\":\"\\\"q\\\"\",\"extra_required\":\"x\"}",
+    "{\"id\":1,\"code\":\"caf\xc3\xa9\",\"extra_required\":\"x\"}",
+    "{\"id\":1,\"code\":\"zz99\",\"extra_required\":\"x\",\"kind\":2.5}",
+    "{\"id\":1,\"code\":\"zz99\",\"extra_required\":\"x\",\"kind\":2.50}",
+    "{\"id\":1,\"code\":\"zz99\",\"extra_required\":\"x\",\"kind\":3}",
+    "{\"id\":1,\"code\":\"zz99\",\"extra_required\":\"x\",\"kind\":true}",
+    "{\"id\":1,\"code\":\"zz99\",\"extra_required\":\"x\",\"kind\":false}",
+    "{\"id\":1,\"code\":\"zz99\",\"extra_required\":\"x\",\"kind\":null}",
+    "{\"id\":1,\"code\":\"zz99\",\"extra_required\":\"x\",\"kind\":{\"a\":[1,2]}}",
+    "{\"id\":1,\"code\":\"zz99\",\"extra_required\":\"x\",\"kind\":{\"a\":[1]}}",
+    "{\"id\":1,\"code\":\"zz99\",\"extra_required\":\"x\",\"kind\":[3]}",
+    "{\"id\":1,\"code\":\"zz99\",\"extra_required\":\"x\",\"kind\":\"other\"}",
+    "{\"id\":1,\"code\":\"zz99\",\"extra_required\":\"x\",\"flag\":null}",
+    "{\"id\":1,\"code\":\"zz99\",\"extra_required\":\"x\",\"flag\":0}",
+    "{\"id\":1,\"code\":\"ab02\",\"extra_required\":\"x\",\"tags\":[\"a\",\"b\"]}",
+    "{\"id\":1,\"code\":\"ab02\",\"extra_required\":\"x\",\"tags\":[]}",
+    "{\"id\":1,\"code\":\"ab02\",\"extra_required\":\"x\",\"tags\":[\"a\",\"a\"]}",
+    "{\"id\":1,\"code\":\"ab02\",\"extra_required\":\"x\",\"tags\":[\"a\",\"b\",\"c\",\"d\",\"e\"]}",
+    "{\"id\":1,\"code\":\"ab02\",\"extra_required\":\"x\",\"tags\":[1]}",
+    "{\"id\":1,\"code\":\"ba03\",\"extra_required\":\"x\",\"qty1\":0}",
+    "{\"id\":1,\"code\":\"ba03\",\"extra_required\":\"x\",\"qty1\":99.5}",
+    "{\"id\":1,\"code\":\"ba03\",\"extra_required\":\"x\",\"qty1\":99.6}",
+    "{\"id\":1,\"code\":\"ba03\",\"extra_required\":\"x\",\"qty2\":\"s\"}",
+    "{\"id\":1,\"code\":\"ba03\",\"extra_required\":\"x\",\"qty4\":3}",
+    "{\"id\":1,\"code\":\"ba03\",\"extra_required\":\"x\",\"qty4\":12}",
+    "{\"id\":1,\"code\":\"ba03\",\"extra_required\":\"x\",\"qty4\":12.5}",
+    "{\"id\":1,\"code\":\"ba03\",\"extra_required\":\"x\",\"qty4\":2.5}",
+    "{\"id\":1,\"code\":\"ba03\",\"extra_required\":\"x\",\"note\":null,\"both\":3}",
+    "{\"id\":1,\"code\":\"ba03\",\"extra_required\":\"x\",\"note\":1}",
+    "{\"id\":1,\"code\":\"ba03\",\"extra_required\":\"x\",\"both\":0}",
+    "{\"id\":1,\"code\":\"ba03\",\"extra_required\":\"x\",\"never\":1}",
+    "{\"id\":1,\"code\":\"ba03\",\"extra_required\":\"x\",\"a/b~c\":[{}]}",
+    "{\"id\":1,\"code\":\"ba03\",\"extra_required\":\"x\",\"other\":\"s\"}",
+    "{\"id\":1,\"code\":\"ba03\",\"extra_required\":\"x\",\"other\":1}",
+    "{\"id\":1,\"code\":\"ba03\",\"extra_required\":\"x\",\"tree\":{\"label\":\"r\",\"children\":"
+      "[{\"label\":\"a\"},{\"label\":\"b\",\"children\":[{\"label\":\"c\"}]}]}}",
+    "{\"id\":1,\"code\":\"ba03\",\"extra_required\":\"x\",\"tree\":{\"label\":\"r\",\"children\":"
+      "[{\"label\":\"a\"},{\"label\":\"b\",\"children\":[{\"name\":\"c\"}]}]}}",
+    "{\"id\":1,\"code\":\"ba03\",\"extra_required\":\"x\",\"sku\":\"AB-1234\"}",
+    "{\"id\":1,\"code\":\"ba03\",\"extra_required\":\"x\",\"sku\":\"AB-12\"}",
+    "{\"id\":1,\"code\":\"ba03\",\"extra_required\":\"x\",\"sku\":\"\\u0041B-123\"}",
+    "{\"id\":1,\"code\":\"ba03\",\"extra_required\":\"x\",\"host\":\"api.example.com\"}",
+    "{\"id\":1,\"code\":\"ba03\",\"extra_required\":\"x\",\"host\":\"badexample.com\"}",
+    "{\"id\":1,\"code\":\"ba03\",\"extra_required\":\"x\",\"when\":\"2024-02-29T12:00:00Z\"}",
+    "{\"id\":1,\"code\":\"ba03\",\"extra_required\":\"x\",\"when\":\"2023-02-29T12:00:00Z\"}",
+    "{\"id\":1,\"code\":\"ba03\",\"extra_required\":\"x\",\"when\":7}",
+    "[1]", "\"s\"", "null", "{}"
+  };
+  size_t n = sizeof(docs) / sizeof(docs[0]), valid = 0;
+  for (size_t i = 0; i < n; i++) {
+    ajson_t *j = P(p, docs[i]);
+    bool want = ajsb_validate(prog, j);
+    if (codegen_order_validate(j) != want) {
+      fprintf(stderr, "mismatch on %s\n", docs[i]);
+      MACRO_ASSERT_TRUE(false);
+    }
+    valid += want;
+  }
+  MACRO_ASSERT_TRUE(valid > 10 && valid < n - 10);    /* both outcomes exercised */
+  MACRO_ASSERT_TRUE(!codegen_order_validate(NULL));
+
+  aml_pool_destroy(p);
+}
+
+/* ---------- 2) emitted_source ---------- */
+MACRO_TEST(ajsb_codegen_emitted_source) {
+  aml_pool_t *p = aml_pool_init(4096);
+  aml_buffer_t *bh = aml_buffer_init(4096);
+
+  ajson_t *o = ajsb_object(p);
+  ajson_t *age = ajsb_integer(p);
+  ajsb_number_max(p, age, 150, false);
+  ajsb_prop_required(p, o, "age", age);
+  const char *colors[] = {"red", "tan", "blue"};
+  ajson_t *c = ajsb_string(p);
+  ajsb_string_enum(p, c, 3, colors);
+  ajsb_prop(p, o, "color", c);
+  ajsb_prop(p, o, "next", ajsb_ref(p, "#"));
+
+  MACRO_ASSERT_TRUE(ajsb_codegen_c(bh, o, "person"));
+  const char *src = aml_buffer_data(bh);
+  HAS(src, "bool person_validate(ajson_t *instance) {");
+  HAS(src, "switch (n) {");
+  HAS(src, "if (!memcmp(s, \"age\", 3)) {");
+  HAS(src, "<= 150)) return false;");
+  HAS(src, "if (!memcmp(s, \"tan\", 3)) {");
+  HAS(src, "if (!person_s0(j)) return false;");            /* $ref "#" is a direct call */
+  HAS(src, "ajsb__canonical(s, &n,");                       /* names compare canonical */
+  MACRO_ASSERT_TRUE(strstr(src, "ajsb_validate") == NULL);   /* standalone */
+
+  aml_buffer_clear(bh);
+  ajson_t *zip = ajsb_string(p);
+  ajsb_string_pattern(p, zip, "^\\d{5}$");
+  ajsb_string_format(p, zip, "ipv4");
+  MACRO_ASSERT_TRUE(ajsb_codegen_c(bh, zip, "zip"));
+  src = aml_buffer_data(bh);
+  HAS(src, "#include \"a-json-schema-builder-library/ajsb_format.h\"");
+  HAS(src, "static const uint32_t zip_p");
+  HAS(src, "ajsb_pattern_match_json(zip_p");
+  HAS(src, "ajsb_format_check_json(");
+
+  aml_buffer_clear(bh);
+  MACRO_ASSERT_TRUE(ajsb_codegen_h(bh, "person"));
+  HAS(aml_buffer_data(bh), "#ifndef PERSON_VALIDATE_H");
+  HAS(aml_buffer_data(bh), "bool person_validate(ajson_t *instance);");
+
+  MACRO_ASSERT_TRUE(!ajsb_codegen_c(bh, o, "not a name"));
+  MACRO_ASSERT_TRUE(!ajsb_codegen_c(bh, o, "9lives"));
+  MACRO_ASSERT_TRUE(!ajsb_codegen_c(bh, ajsb_ref(p, "#/$defs/missing"), "broken"));
+
+  aml_buffer_destroy(bh);
+  aml_pool_destroy(p);
+}
+
+/* ---------- Runner ---------- */
+int main(void) {
+  macro_test_case tests[16];
+  size_t test_count = 0;
+
+  MACRO_ADD(tests, ajsb_codegen_matches_interpreter);
+  MACRO_ADD(tests, ajsb_codegen_emitted_source);
+
+  macro_run_all("a-json-schema-builder/ajsb_codegen", tests, test_count);
+  return 0;
+}
@@ -0,0 +1,264 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#include "a-json-schema-builder-library/ajsb.h"
+#include "a-json-schema-builder-library/ajsb_decode.h"
+#include "a-json-schema-builder-library/ajsb_validate.h"
+#include "a-json-library/ajson.h"
+#include "a-memory-library/aml_pool.h"
+#include "the-macro-library/macro_test.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+
+static bool text_is(ajsb_text_t t, const char *s) {
+  return t.s && t.len == strlen(s) && !memcmp(t.s, s, t.len);
+}
+
+static ajsb_decode_status_t decode(const ajsb_decoder_t *d, aml_pool_t *p, const char *s, void *out) {
+  return ajsb_decode(d, p, s, strlen(s), out, NULL);
+}
+
+typedef struct {
+  ajsb_text_t  city;
+  double       temp_c;
+  ajsb_slice_t conditions;
+} weather_t;
+
+/* ---------- 1) weather ---------- */
+MACRO_TEST(ajsb_decode_weather) {
+  aml_pool_t *p = aml_pool_init(4096);
+  ajsb_fields_t *f = ajsb_fields_init(p);
+  ajson_t *w = ajsb_object(p);
+  ajsb_fields_prop_required(f, w, "city", ajsb_string(p), AJSB_FIELD_STRING, offsetof(weather_t, city));
+  ajsb_fields_prop_required(f, w, "tempC", ajsb_number(p), AJSB_FIELD_DOUBLE, offsetof(weather_t, temp_c));
+  const char *conds[] = {"sunny", "cloudy", "rain"};
+  ajson_t *c = ajsb_string(p);
+  ajsb_string_enum(p, c, 3, conds);
+  ajson_t *arr = ajsb_array(p, c);
+  ajsb_array_max_items(p, arr, 3);
+  ajsb_prop(p, w, "conditions", arr);
+  ajsb_fields_bind_array(f, w, "conditions", offsetof(weather_t, conditions),
+                         AJSB_FIELD_STRING, sizeof(ajsb_text_t));
+  ajsb_additional_properties(p, w, false);
+  ajsb_decoder_t *d = ajsb_decoder_init(p, f, w);
+  MACRO_ASSERT_TRUE(d != NULL);
+
+  const char *s = "{ \"city\": \"Paris\", \"tempC\": 21.5, \"conditions\": [\"sunny\", \"rain\"] }";
+  weather_t out;
+  memset(&out, 0, sizeof(out));
+  MACRO_ASSERT_TRUE(decode(d, p, s, &out) == AJSB_DECODE_OK);
+  MACRO_ASSERT_TRUE(text_is(out.city, "Paris"));
+  MACRO_ASSERT_TRUE(out.city.s > s && out.city.s < s + strlen(s));      /* zero-copy */
+  MACRO_ASSERT_TRUE(out.temp_c == 21.5);
+  MACRO_ASSERT_TRUE(out.conditions.count == 2);
+  ajsb_text_t *ct = (ajsb_text_t *)out.conditions.items;
+  MACRO_ASSERT_TRUE(text_is(ct[0], "sunny") && text_is(ct[1], "rain"));
+
+  /* escapes are decoded into the pool */
+  memset(&out, 0, sizeof(out));
+  s = "{\"city\":\"S\\u00e3o \\\"Paulo\\\"\",\"tempC\":-3}";
+  MACRO_ASSERT_TRUE(decode(d, p, s, &out) == AJSB_DECODE_OK);
+  MACRO_ASSERT_TRUE(text_is(out.city, "S\xc3\xa3o \"Paulo\""));
+  MACRO_ASSERT_TRUE(out.temp_c == -3 && out.conditions.count == 0);
+
+  /* failures, with where they were found */
+  ajsb_decode_error_t err;
+  s = "{\"city\":\"Oslo\"}";
+  MACRO_ASSERT_TRUE(ajsb_decode(d, p, s, strlen(s), &out, &err) == AJSB_DECODE_INVALID);
+  MACRO_ASSERT_TRUE(!strcmp(err.why, "missing required property"));
+  s = "{\"city\":\"Oslo\",\"tempC\":\"cold\"}";
+  MACRO_ASSERT_TRUE(ajsb_decode(d, p, s, strlen(s), &out, &err) == AJSB_DECODE_INVALID);
+  MACRO_ASSERT_TRUE(err.offset == 23);
+  s = "{\"city\":\"Oslo\",\"tempC\":1,\"conditions\":[\"snow\"]}";
+  MACRO_ASSERT_TRUE(decode(d, p, s, &out) == AJSB_DECODE_INVALID);
+  s = "{\"city\":\"Oslo\",\"tempC\":1,\"conditions\":[\"rain\",\"rain\",\"rain\",\"rain\"]}";
+  MACRO_ASSERT_TRUE(decode(d, p, s, &out) == AJSB_DECODE_INVALID);
+  s = "{\"city\":\"Oslo\",\"tempC\":1,\"wind\":3}";
+  MACRO_ASSERT_TRUE(decode(d, p, s, &out) == AJSB_DECODE_INVALID);
+  s = "{\"city\":\"Oslo\",\"tempC\":1";
+  MACRO_ASSERT_TRUE(ajsb_decode(d, p, s, strlen(s), &out, &err) == AJSB_DECODE_SYNTAX_ERROR);
+  MACRO_ASSERT_TRUE(err.offset == strlen(s));
+  s = "{\"city\":\"Oslo\",\"tempC\":01}";
+  MACRO_ASSERT_TRUE(decode(d, p, s, &out) == AJSB_DECODE_SYNTAX_ERROR);
+  s = "{\"city\":\"Oslo\",\"tempC\":1} x";
+  MACRO_ASSERT_TRUE(decode(d, p, s, &out) == AJSB_DECODE_SYNTAX_ERROR);
+  s = "{\"city\":\"Os\\qlo\",\"tempC\":1}";
+  MACRO_ASSERT_TRUE(decode(d, p, s, &out) == AJSB_DECODE_SYNTAX_ERROR);
+
+  /* the input need not be NUL-terminated; out may be NULL */
+  s = "{\"city\":\"Rome\",\"tempC\":30}GARBAGE";
+  MACRO_ASSERT_TRUE(ajsb_decode(d, p, s, strlen(s) - 7, NULL, NULL) == AJSB_DECODE_OK);
+  MACRO_ASSERT_TRUE(ajsb_decode(NULL, p, s, 1, &out, NULL) == AJSB_DECODE_INVALID);
+  MACRO_ASSERT_TRUE(ajsb_decoder_init(p, f, ajsb_ref(p, "#/nowhere")) == NULL);
+
+  aml_pool_destroy(p);
+}
+
+typedef struct {
+  ajsb_text_t name;
+  int         qty;
+  double      price;
+} line_t;
+
+typedef struct {
+  int64_t      id;
+  bool         paid;
+  struct { double lat, lon; } at;
+  ajsb_slice_t lines;
+  ajsb_text_t  note;
+  ajsb_text_t  meta;
+  ajsb_slice_t tags;
+  int          priority;
+} order_t;
+
+/* ---------- 2) nested ---------- */
+MACRO_TEST(ajsb_decode_nested) {
+  aml_pool_t *p = aml_pool_init(4096);
+  ajsb_fields_t *f = ajsb_fields_init(p);
+  ajson_t *o = ajsb_object(p);
+
+  ajson_t *line = ajsb_object(p);
+  ajsb_fields_prop_required(f, line, "name", ajsb_string(p), AJSB_FIELD_STRING, offsetof(line_t, name));
+  ajson_t *qty = ajsb_integer(p);
+  ajsb_number_min(p, qty, 1, false);
+  ajsb_fields_prop_required(f, line, "qty", qty, AJSB_FIELD_INT, offsetof(line_t, qty));
+  ajsb_fields_prop(f, line, "price", ajsb_number(p), AJSB_FIELD_DOUBLE, offsetof(line_t, price));
+  ajsb_defs_add(p, o, "line", line);
+
+  ajsb_fields_prop_required(f, o, "id", ajsb_integer(p), AJSB_FIELD_INT64, offsetof(order_t, id));
+  ajsb_fields_prop(f, o, "paid", ajsb_boolean(p), AJSB_FIELD_BOOL, offsetof(order_t, paid));
+  ajson_t *at = ajsb_object(p);
+  ajsb_fields_prop_required(f, at, "lat", ajsb_number(p), AJSB_FIELD_DOUBLE, 0);
+  ajsb_fields_prop_required(f, at, "lon", ajsb_number(p), AJSB_FIELD_DOUBLE, sizeof(double));
+  ajsb_fields_prop(f, o, "at", at, AJSB_FIELD_STRUCT, offsetof(order_t, at));
+  ajsb_prop(p, o, "lines", ajsb_array(p, ajsb_ref(p, "#/$defs/line")));
+  ajsb_fields_bind_array(f, o, "lines", offsetof(order_t, lines), AJSB_FIELD_STRUCT, sizeof(line_t));
+  ajson_t *nullable[] = { ajsb_string(p), ajsb_null(p) };
+  ajsb_fields_prop(f, o, "note", ajsb_anyOf(p, 2, nullable), AJSB_FIELD_STRING, offsetof(order_t, note));
+  ajsb_fields_prop(f, o, "meta", ajsb_object(p), AJSB_FIELD_JSON, offsetof(order_t, meta));
+  ajson_t *tags = ajsb_array(p, ajsb_string(p));
+  ajsb_array_unique(p, tags, true);
+  ajsb_prop(p, o, "tags", tags);
+  ajsb_fields_bind_array(f, o, "tags", offsetof(order_t, tags), AJSB_FIELD_STRING, sizeof(ajsb_text_t));
+  ajson_t *low[] = { ajsb_integer(p) };
+  ajsb_number_max(p, low[0], 3, false);
+  ajsb_fields_prop(f, o, "priority", ajsb_allOf(p, 1, low), AJSB_FIELD_INT, offsetof(order_t, priority));
+  ajsb_decoder_t *d = ajsb_decoder_init(p, f, o);
+  MACRO_ASSERT_TRUE(d != NULL);
+
+  const char *s =
+    "{\"id\":9007199254740993,\"paid\":true,\"at\":{\"lon\":2.35,\"lat\":48.85},"
+    "\"lines\":[{\"name\":\"tea\",\"qty\":2,\"price\":3.5},{\"name\":\"cake\",\"qty\":1},"
+    "{\"name\":\"jam\",\"qty\":12.0,\"price\":4}],"
+    "\"note\":\"ring twice\",\"meta\":{\"src\":[1,2]},\"tags\":[\"a\",\"b\\n\"],\"priority\":2}";
+  order_t out;
+  memset(&out, 0, sizeof(out));
+  MACRO_ASSERT_TRUE(decode(d, p, s, &out) == AJSB_DECODE_OK);
+  MACRO_ASSERT_TRUE(out.id == 9007199254740993LL && out.paid);
+  MACRO_ASSERT_TRUE(out.at.lat == 48.85 && out.at.lon == 2.35);
+  MACRO_ASSERT_TRUE(out.lines.count == 3);
+  line_t *l = (line_t *)out.lines.items;
+  MACRO_ASSERT_TRUE(text_is(l[0].name, "tea") && l[0].qty == 2 && l[0].price == 3.5);
+  MACRO_ASSERT_TRUE(text_is(l[1].name, "cake") && l[1].qty == 1 && l[1].price == 0);
+  MACRO_ASSERT_TRUE(text_is(l[2].name, "jam") && l[2].qty == 12 && l[2].price == 4);
+  MACRO_ASSERT_TRUE(text_is(out.note, "ring twice"));
+  MACRO_ASSERT_TRUE(text_is(out.meta, "{\"src\":[1,2]}"));
+  MACRO_ASSERT_TRUE(out.tags.count == 2 && text_is(((ajsb_text_t *)out.tags.items)[1], "b\n"));
+  MACRO_ASSERT_TRUE(out.priority == 2);
+
+  /* null leaves the member alone */
+  memset(&out, 0, sizeof(out));
+  MACRO_ASSERT_TRUE(decode(d, p, "{\"id\":1,\"note\":null}", &out) == AJSB_DECODE_OK);
+  MACRO_ASSERT_TRUE(out.id == 1 && out.note.s == NULL);
+
+  /* checked through $ref, allOf, anyOf and uniqueItems */
+  MACRO_ASSERT_TRUE(decode(d, p, "{\"id\":1,\"lines\":[{\"name\":\"x\",\"qty\":0}]}", &out) == AJSB_DECODE_INVALID);
+  MACRO_ASSERT_TRUE(decode(d, p, "{\"id\":1,\"lines\":[{\"qty\":1}]}", &out) == AJSB_DECODE_INVALID);
+  MACRO_ASSERT_TRUE(decode(d, p, "{\"id\":1,\"priority\":4}", &out) == AJSB_DECODE_INVALID);
+  MACRO_ASSERT_TRUE(decode(d, p, "{\"id\":1,\"note\":7}", &out) == AJSB_DECODE_INVALID);
+  MACRO_ASSERT_TRUE(decode(d, p, "{\"id\":1,\"tags\":[\"a\",\"a\"]}", &out) == AJSB_DECODE_INVALID);
+  MACRO_ASSERT_TRUE(decode(d, p, "{\"id\":1.5}", &out) == AJSB_DECODE_INVALID);
+
+  /* valid JSON that the C member cannot hold */
+  MACRO_ASSERT_TRUE(decode(d, p, "{\"id\":1,\"lines\":[{\"name\":\"x\",\"qty\":3000000000}]}", &out)
+                    == AJSB_DECODE_INVALID);
+  MACRO_ASSERT_TRUE(decode(d, p, "{\"id\":1,\"lines\":[{\"name\":\"x\",\"qty\":3000000000}]}", NULL)
+                    == AJSB_DECODE_OK);
+
+  aml_pool_destroy(p);
+}
+
+/* ---------- 3) matches_validate ---------- */
+MACRO_TEST(ajsb_decode_matches_validate) {
+  aml_pool_t *p = aml_pool_init(4096);
+  char *schema = aml_pool_strdup(p,
+    "{\"type\":\"object\",\"properties\":{"
+      "\"a\":{\"type\":\"integer\",\"minimum\":0,\"exclusiveMaximum\":10},"
+      "\"b\":{\"enum\":[\"x\",\"y\\\"z\",2,true,null,[1]]},"
+      "\"c\":{\"oneOf\":[{\"type\":\"string\"},{\"type\":\"number\",\"minimum\":5}]},"
+      "\"d\":{\"type\":\"array\",\"items\":{\"$ref\":\"#/$defs/n\"},\"minItems\":1},"
+      "\"e\":{\"not\":{\"const\":\"no\"}},"
+      "\"f\":false},"
+    "\"required\":[\"a\",\"z\"],"
+    "\"additionalProperties\":{\"type\":\"boolean\"},"
+    "\"$defs\":{\"n\":{\"allOf\":[{\"type\":\"object\",\"required\":[\"k\"]},"
+                              "{\"properties\":{\"k\":{\"type\":\"string\"},\"m\":{\"$ref\":\"#/$defs/n\"}}}]}}}");
+  ajson_t *sj = ajson_parse_string(p, schema);
+  ajsb_program_t *prog = ajsb_compile(p, sj);
+  ajsb_decoder_t *d = ajsb_decoder_init(p, NULL, sj);
+  MACRO_ASSERT_TRUE(prog && d);
+
+  static const char *const docs[] = {
+    "{\"a\":1,\"z\":true}", "{\"a\":1}", "{\"z\":true}", "{\"a\":10,\"z\":true}", "{\"a\":9.0,\"z\":true}",
+    "{\"a\":-1,\"z\":true}", "{\"a\":0.5,\"z\":true}", "{\"a\":1,\"z\":1}",
+    "{\"a\":1,\"z\":true,\"b\":\"x\"}", "{\"a\":1,\"z\":true,\"b\":\"y\\\"z\"}", "{\"a\":1,\"z\":true,\"b\":\"y\"}",
+    "{\"a\":1,\"z\":true,\"b\":2.0}", "{\"a\":1,\"z\":true,\"b\":3}", "{\"a\":1,\"z\":true,\"b\":true}",
+    "{\"a\":1,\"z\":true,\"b\":false}", "{\"a\":1,\"z\":true,\"b\":null}", "{\"a\":1,\"z\":true,\"b\":[1]}",
+    "{\"a\":1,\"z\":true,\"b\":[2]}", "{\"a\":1,\"z\":true,\"b\":{}}",
+    "{\"a\":1,\"z\":true,\"c\":\"s\"}", "{\"a\":1,\"z\":true,\"c\":6}", "{\"a\":1,\"z\":true,\"c\":4}",
+    "{\"a\":1,\"z\":true,\"c\":null}",
+    "{\"a\":1,\"z\":true,\"d\":[]}", "{\"a\":1,\"z\":true,\"d\":[{\"k\":\"v\"}]}",
+    "{\"a\":1,\"z\":true,\"d\":[{\"k\":1}]}", "{\"a\":1,\"z\":true,\"d\":[{}]}",
+    "{\"a\":1,\"z\":true,\"d\":[{\"k\":\"v\",\"m\":{\"k\":\"w\",\"m\":{\"k\":\"x\"}}}]}",
+    "{\"a\":1,\"z\":true,\"d\":[{\"k\":\"v\",\"m\":{\"k\":\"w\",\"m\":{\"j\":\"x\"}}}]}",
+    "{\"a\":1,\"z\":true,\"d\":[{\"k\":\"v\",\"m\":[]}]}",
+    "{\"a\":1,\"z\":true,\"e\":\"yes\"}", "{\"a\":1,\"z\":true,\"e\":\"no\"}",
+    "{\"a\":1,\"z\":true,\"f\":0}", "{\"a\":1,\"z\":true,\"g\":false}", "{\"a\":1,\"z\":true,\"g\":\"s\"}",
+    "{\"\\u0061\":1,\"z\":true}", "{\"a\":1,\"\\u007a\":true,\"b\":\"y\\u0022z\"}",
+    "{\"a\":1,\"z\":true,\"b\":\"\\u0078\"}", "{\"a\":1,\"z\":true,\"\\u0066\":0}",
+    "[]", "\"s\"", "3", "null"
+  };
+  size_t n = sizeof(docs) / sizeof(docs[0]), valid = 0;
+  for (size_t i = 0; i < n; i++) {
+    bool want = ajsb_validate(prog, ajson_parse_string(p, aml_pool_strdup(p, docs[i])));
+    bool got = decode(d, p, docs[i], NULL) == AJSB_DECODE_OK;
+    if (got != want) {
+      fprintf(stderr, "mismatch on %s\n", docs[i]);
+      MACRO_ASSERT_TRUE(false);
+    }
+    valid += want;
+  }
+  MACRO_ASSERT_TRUE(valid > 10 && valid < n - 10);
+
+  aml_pool_destroy(p);
+}
+
+/* ---------- Runner ---------- */
+int main(void) {
+  macro_test_case tests[16];
+  size_t test_count = 0;
+
+  MACRO_ADD(tests, ajsb_decode_weather);
+  MACRO_ADD(tests, ajsb_decode_nested);
+  MACRO_ADD(tests, ajsb_decode_matches_validate);
+
+  macro_run_all("a-json-schema-builder/ajsb_decode", tests, test_count);
+  return 0;
+}
@@ -0,0 +1,132 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#include "a-json-schema-builder-library/ajsb.h"
+#include "a-json-schema-builder-library/ajsb_derive.h"
+#include "a-json-schema-builder-library/ajsb_validate.h"
+#include "a-json-library/ajson.h"
+#include "a-memory-library/aml_pool.h"
+#include "the-macro-library/macro_test.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+
+/* Small helpers */
+static const char *J(aml_pool_t *p, ajson_t *j) { return ajson_stringify(p, j); }
+static ajson_t *P(aml_pool_t *p, const char *s) { return ajson_parse_string(p, aml_pool_strdup(p, s)); }
+
+static ajson_t *address(aml_pool_t *p) {
+  ajson_t *a = ajsb_object(p);
+  ajsb_prop_required(p, a, "street", ajsb_string(p));
+  ajsb_prop(p, a, "city", ajsb_string(p));
+  return a;
+}
+
+/* base; with_changes selects the hand-built equivalent of the derived variant */
+static ajson_t *order(aml_pool_t *p, bool with_changes) {
+  ajson_t *o = ajsb_object(p);
+  const char *status[] = {"new", "paid", "shipped"};
+  const char *narrow[] = {"new", "paid"};
+  ajson_t *st = ajsb_string(p);
+  ajsb_string_enum(p, st, with_changes ? 2 : 3, with_changes ? narrow : status);
+  ajsb_prop_required(p, o, "status", st);
+  ajson_t *tags = ajsb_array(p, ajsb_string(p));
+  ajsb_array_max_items(p, tags, with_changes ? 3 : 10);
+  ajsb_prop(p, o, "tags", tags);
+  ajsb_prop(p, o, "ship_to", address(p));
+  ajsb_prop(p, o, "bill_to", address(p));
+  if (with_changes) ajsb_prop_required(p, o, "trace_id", ajsb_string(p));
+  ajsb_additional_properties(p, o, false);
+  return o;
+}
+
+/* ---------- 1) overlay ---------- */
+MACRO_TEST(ajsb_derive_overlay) {
+  aml_pool_t *bp = aml_pool_init(4096);
+  ajson_t *base = order(bp, false);
+  const char *before = J(bp, base);
+
+  aml_pool_t *p = aml_pool_init(4096);
+  ajsb_derive_t *d = ajsb_derive(p, base);
+  const char *narrow[] = {"new", "paid"};
+  ajsb_string_enum(p, ajsb_derive_at(d, "/properties/status"), 2, narrow);
+  ajsb_array_max_items(p, ajsb_derive_at(d, "#/properties/tags"), 3);
+  ajsb_prop_required(p, ajsb_derive_root(d), "trace_id", ajsb_string(p));
+
+  ajson_t *root = ajsb_derive_root(d);
+  MACRO_ASSERT_STREQ(J(p, root), J(p, order(p, true)));
+  MACRO_ASSERT_STREQ(J(bp, base), before);              /* base untouched */
+
+  /* unchanged subtrees are the base's nodes */
+  ajson_t *bprops = ajsono_scan(base, "properties"), *dprops = ajsono_scan(root, "properties");
+  MACRO_ASSERT_TRUE(bprops != dprops);
+  MACRO_ASSERT_TRUE(ajsono_scan(dprops, "ship_to") == ajsono_scan(bprops, "ship_to"));
+  MACRO_ASSERT_TRUE(ajsono_scan(ajsono_scan(dprops, "tags"), "items") ==
+                    ajsono_scan(ajsono_scan(bprops, "tags"), "items"));
+  MACRO_ASSERT_TRUE(ajsb_derive_owns(d, ajsono_scan(dprops, "tags")));
+  MACRO_ASSERT_TRUE(!ajsb_derive_owns(d, ajsono_scan(dprops, "bill_to")));
+
+  /* validation sees the merged view */
+  ajsb_program_t *dv = ajsb_compile(p, root), *bv = ajsb_compile(p, base);
+  const char *doc = "{\"status\":\"shipped\",\"trace_id\":\"x\"}";
+  MACRO_ASSERT_TRUE(!ajsb_validate(dv, P(p, doc)));
+  MACRO_ASSERT_TRUE(ajsb_validate(bv, P(p, "{\"status\":\"shipped\"}")));
+  MACRO_ASSERT_TRUE(!ajsb_validate(dv, P(p, "{\"status\":\"new\"}")));
+  MACRO_ASSERT_TRUE(ajsb_validate(dv, P(p, "{\"status\":\"new\",\"trace_id\":\"x\"}")));
+
+  /* a second variant from the same base is independent */
+  aml_pool_destroy(p);
+  p = aml_pool_init(4096);
+  d = ajsb_derive(p, base);
+  ajsb_prop(p, ajsb_derive_at(d, "/properties/ship_to"), "zip", ajsb_string(p));
+  const char *out = J(p, ajsb_derive_root(d));
+  MACRO_ASSERT_TRUE(strstr(out, "\"zip\"") != NULL);
+  MACRO_ASSERT_TRUE(strstr(out, "\"trace_id\"") == NULL);
+  MACRO_ASSERT_STREQ(J(bp, base), before);
+
+  aml_pool_destroy(p);
+  aml_pool_destroy(bp);
+}
+
+/* ---------- 2) pointers ---------- */
+MACRO_TEST(ajsb_derive_pointers) {
+  aml_pool_t *p = aml_pool_init(4096);
+
+  ajson_t *base = ajsb_object(p);
+  ajsb_prop(p, base, "a/b", ajsb_string(p));
+  ajson_t *alts[] = { ajsb_string(p), ajsb_shared_integer() };
+  ajsb_prop(p, base, "v", ajsb_anyOf(p, 2, alts));
+
+  ajsb_derive_t *d = ajsb_derive(p, base);
+  MACRO_ASSERT_TRUE(ajsb_derive_at(d, "") == ajsb_derive_root(d));
+  MACRO_ASSERT_TRUE(ajsb_derive_at(d, "/properties/a~1b") != NULL);
+  MACRO_ASSERT_TRUE(ajsb_derive_at(d, "/properties/missing") == NULL);
+  MACRO_ASSERT_TRUE(ajsb_derive_at(d, "/properties/v/anyOf/2") == NULL);
+  MACRO_ASSERT_TRUE(ajsb_derive_at(d, "/properties/v/anyOf/x") == NULL);
+
+  /* shared leaves become private copies that helpers can change */
+  ajson_t *i = ajsb_derive_at(d, "/properties/v/anyOf/1");
+  MACRO_ASSERT_TRUE(i != ajsb_shared_integer() && !ajsb_is_shared(i));
+  ajsb_number_min(p, i, 0, false);
+  MACRO_ASSERT_STREQ(J(p, ajsb_shared_integer()), "{\"type\":\"integer\"}");
+  MACRO_ASSERT_TRUE(strstr(J(p, ajsb_derive_root(d)), "{\"type\":\"integer\",\"minimum\":0}") != NULL);
+  MACRO_ASSERT_TRUE(strstr(J(p, base), "minimum") == NULL);
+
+  aml_pool_destroy(p);
+}
+
+/* ---------- Runner ---------- */
+int main(void) {
+  macro_test_case tests[16];
+  size_t test_count = 0;
+
+  MACRO_ADD(tests, ajsb_derive_overlay);
+  MACRO_ADD(tests, ajsb_derive_pointers);
+
+  macro_run_all("a-json-schema-builder/ajsb_derive", tests, test_count);
+  return 0;
+}
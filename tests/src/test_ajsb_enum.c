@@ -0,0 +1,168 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#include "a-json-schema-builder-library/ajsb.h"
+#include "a-json-schema-builder-library/ajsb_decode.h"
+#include "a-json-schema-builder-library/ajsb_stream.h"
+#include "a-json-schema-builder-library/ajsb_validate.h"
+#include "a-json-library/ajson.h"
+#include "a-memory-library/aml_buffer.h"
+#include "a-memory-library/aml_pool.h"
+#include "the-macro-library/macro_test.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+
+static ajson_t *P(aml_pool_t *p, const char *s) { return ajson_parse_string(p, aml_pool_strdup(p, s)); }
+
+#define SKUS 20000
+
+static const char **make_skus(aml_pool_t *p, size_t n) {
+  const char **v = (const char **)aml_pool_alloc(p, n * sizeof(*v));
+  for (size_t i = 0; i < n; i++) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "SKU-%05zu", i % 10 == 9 ? i - 9 : i);   /* every tenth repeats */
+    v[i] = aml_pool_strdup(p, buf);
+  }
+  return v;
+}
+
+/* ---------- 1) string_enum_dedup ---------- */
+MACRO_TEST(ajsb_string_enum_dedup) {
+  aml_pool_t *p = aml_pool_init(8192);
+  static const char *const v[] = {"red", "green", "red", NULL, "", "blue", "green", "red"};
+  ajson_t *s = ajsb_string(p);
+  ajsb_string_enum(p, s, sizeof(v) / sizeof(v[0]), v);
+  const char *text = ajson_stringify(p, s);
+  MACRO_ASSERT_TRUE(strstr(text, "\"enum\":[\"red\",\"green\",\"blue\"]") != NULL);
+
+  const char **skus = make_skus(p, SKUS);
+  ajson_t *big = ajsb_string(p);
+  ajsb_string_enum(p, big, SKUS, skus);
+  MACRO_ASSERT_TRUE(ajsona_count(ajsono_scan(big, "enum")) == SKUS - SKUS / 10);
+  aml_pool_destroy(p);
+}
+
+/* ---------- 2) large_enum_membership ---------- */
+MACRO_TEST(ajsb_large_enum_membership) {
+  aml_pool_t *p = aml_pool_init(1 << 16);
+  typedef struct { ajsb_text_t sku; ajsb_text_t qty; } line_t;
+
+  ajsb_fields_t *f = ajsb_fields_init(p);
+  ajson_t *o = ajsb_object(p);
+  ajson_t *sku = ajsb_string(p);
+  ajsb_string_enum(p, sku, SKUS, make_skus(p, SKUS));
+  ajsb_fields_prop_required(f, o, "sku", sku, AJSB_FIELD_STRING, offsetof(line_t, sku));
+
+  /* numbers compare by value and repeats in a parsed schema are dropped */
+  aml_buffer_t *bh = aml_buffer_init(1024);
+  aml_buffer_appends(bh, "{\"enum\":[-0,1.0");
+  for (int i = 0; i < 100; i++) aml_buffer_appendf(bh, ",%d", i * 3);
+  aml_buffer_appends(bh, ",\"three\",null]}");
+  ajson_t *qty = P(p, aml_buffer_data(bh));
+  aml_buffer_destroy(bh);
+  ajsb_fields_prop(f, o, "qty", qty, AJSB_FIELD_JSON, offsetof(line_t, qty));
+
+  ajsb_program_t *prog = ajsb_compile(p, o);
+  ajsb_decoder_t *d = ajsb_decoder_init(p, f, o);
+  ajsb_stream_t *st = ajsb_stream_init(p, prog);
+  MACRO_ASSERT_TRUE(prog && d && st);
+
+  static const char *const docs[] = {
+    "{\"sku\":\"SKU-00000\"}",
+    "{\"sku\":\"SKU-19998\",\"qty\":297}",
+    "{\"sku\":\"SKU-00009\"}",                   /* only ever a repeat of SKU-00000 */
+    "{\"sku\":\"SKU-20000\"}",
+    "{\"sku\":\"SKU-0000\"}",
+    "{\"sku\":\"SKU-12345\",\"qty\":1}",
+    "{\"sku\":\"SKU-12345\",\"qty\":0.0}",
+    "{\"sku\":\"SKU-12345\",\"qty\":-0}",
+    "{\"sku\":\"SKU-12345\",\"qty\":3e1}",
+    "{\"sku\":\"SKU-12345\",\"qty\":2}",
+    "{\"sku\":\"SKU-12345\",\"qty\":\"three\"}",
+    "{\"sku\":\"SKU-12345\",\"qty\":\"four\"}",
+    "{\"sku\":\"SKU-12345\",\"qty\":null}",
+    "{\"sku\":\"SKU-12345\",\"qty\":true}",
+    "{\"sku\":\"SKU-\\u0030\\u0030000\"}",      /* SKU-00000, escaped */
+  };
+  static const bool want[] = {true, true, false, false, false, true, true, true, true, false,
+                              true, false, true, false, true};
+  for (size_t i = 0; i < sizeof(docs) / sizeof(docs[0]); i++) {
+    size_t len = strlen(docs[i]);
+    bool v = ajsb_validate(prog, P(p, docs[i]));
+
+    line_t r = {0};
+    bool dv = ajsb_decode(d, p, docs[i], len, &r, NULL) == AJSB_DECODE_OK;
+
+    ajsb_stream_reset(st);
+    ajsb_stream_status_t ss = ajsb_stream_push(st, docs[i], len);
+    if (ss == AJSB_STREAM_CONTINUE) ss = ajsb_stream_finish(st);
+    bool sv = ss == AJSB_STREAM_COMPLETE;
+
+    if (v != want[i] || dv != want[i] || sv != want[i])
+      fprintf(stderr, "%s: validate %d decode %d stream %d, expected %d\n", docs[i], v, dv, sv, want[i]);
+    MACRO_ASSERT_TRUE(v == want[i] && dv == want[i] && sv == want[i]);
+  }
+
+  /* every member, not just a sample */
+  const char **skus = make_skus(p, SKUS);
+  ajsb_program_t *only = ajsb_compile(p, sku);
+  for (size_t i = 0; i < SKUS; i++) {
+    char doc[32];
+    snprintf(doc, sizeof(doc), "\"%s\"", skus[i]);
+    MACRO_ASSERT_TRUE(ajsb_validate(only, P(p, doc)));
+    doc[5] = 'X';
+    MACRO_ASSERT_TRUE(!ajsb_validate(only, P(p, doc)));
+  }
+  aml_pool_destroy(p);
+}
+
+/* ---------- 3) unique_items_hashed ---------- */
+MACRO_TEST(ajsb_unique_items_hashed) {
+  aml_pool_t *p = aml_pool_init(8192);
+  ajson_t *arr = ajsb_array(p, NULL);
+  ajsb_array_unique(p, arr, true);
+  ajsb_program_t *prog = ajsb_compile(p, arr);
+  MACRO_ASSERT_TRUE(prog != NULL);
+
+  static const char *const head = "[0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18,19";
+  static const struct { const char *tail; bool want; } cases[] = {
+    {"]", true},
+    {",19]", false},
+    {",19.0]", false},
+    {",\"19\"]", true},
+    {",{\"a\":1,\"b\":[1,2]},{\"b\":[1,2],\"a\":1}]", false},
+    {",{\"a\":1,\"b\":[1,2]},{\"b\":[2,1],\"a\":1}]", true},
+    {",{\"a\":1},{\"a\":1,\"b\":null}]", true},
+    {",[1,[2]],[1,[2.0]]]", false},
+    {",true,false,null,[],{}]", true},
+    {",true,false,null,[],{},null]", false},
+    {",-0,\"x\"]", false},
+  };
+  for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    char doc[256];
+    snprintf(doc, sizeof(doc), "%s%s", head, cases[i].tail);
+    MACRO_ASSERT_TRUE(ajsb_validate(prog, P(p, doc)) == cases[i].want);
+  }
+  /* short arrays still compare pairwise */
+  MACRO_ASSERT_TRUE(!ajsb_validate(prog, P(p, "[{\"a\":1,\"b\":2},{\"b\":2,\"a\":1}]")));
+  MACRO_ASSERT_TRUE(ajsb_validate(prog, P(p, "[1,\"1\"]")));
+  aml_pool_destroy(p);
+}
+
+/* ---------- Runner ---------- */
+int main(void) {
+  macro_test_case tests[16];
+  size_t test_count = 0;
+
+  MACRO_ADD(tests, ajsb_string_enum_dedup);
+  MACRO_ADD(tests, ajsb_large_enum_membership);
+  MACRO_ADD(tests, ajsb_unique_items_hashed);
+
+  macro_run_all("a-json-schema-builder/ajsb_enum", tests, test_count);
+  return 0;
+}
@@ -0,0 +1,213 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#include "a-json-schema-builder-library/ajsb.h"
+#include "a-json-schema-builder-library/ajsb_decode.h"
+#include "a-json-schema-builder-library/ajsb_format.h"
+#include "a-json-schema-builder-library/ajsb_stream.h"
+#include "a-json-schema-builder-library/ajsb_validate.h"
+#include "a-json-library/ajson.h"
+#include "a-memory-library/aml_pool.h"
+#include "the-macro-library/macro_test.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+
+static ajson_t *P(aml_pool_t *p, const char *s) { return ajson_parse_string(p, aml_pool_strdup(p, s)); }
+
+typedef struct {
+  const char *schema_value;   /* format name or pattern */
+  const char *instance;       /* JSON string text, escapes allowed */
+  bool        want;
+} string_case_t;
+
+static bool run_cases(aml_pool_t *p, const char *keyword, const string_case_t *cases, size_t n) {
+  bool ok = true;
+  for (size_t i = 0; i < n; i++) {
+    ajson_t *s = ajsb_string(p);
+    if (!strcmp(keyword, "format")) ajsb_string_format(p, s, cases[i].schema_value);
+    else ajsb_string_pattern(p, s, cases[i].schema_value);
+    ajsb_program_t *prog = ajsb_compile(p, s);
+    char doc[256];
+    snprintf(doc, sizeof(doc), "\"%s\"", cases[i].instance);
+    if (!prog || ajsb_validate(prog, P(p, doc)) != cases[i].want) {
+      fprintf(stderr, "%s %s on %s: expected %d\n", keyword, cases[i].schema_value, doc, cases[i].want);
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+/* ---------- 1) format_checks ---------- */
+MACRO_TEST(ajsb_format_checks) {
+  aml_pool_t *p = aml_pool_init(8192);
+  static const string_case_t cases[] = {
+    {"date", "2024-02-29", true},
+    {"date", "2023-02-29", false},
+    {"date", "1900-02-29", false},
+    {"date", "2000-02-29", true},
+    {"date", "2024-04-31", false},
+    {"date", "2024-13-01", false},
+    {"date", "2024-1-01", false},
+    {"date", "2024-01-01x", false},
+    {"date", "2024/01/01", false},
+    {"time", "23:59:59Z", true},
+    {"time", "08:30:06.283185+01:00", true},
+    {"time", "23:59:60Z", true},
+    {"time", "23:59:60+00:30", false},
+    {"time", "00:29:60+00:30", true},
+    {"time", "24:00:00Z", false},
+    {"time", "12:00:00", false},
+    {"time", "12:00:00.Z", false},
+    {"time", "12:00:00+1:00", false},
+    {"date-time", "1963-06-19T08:30:06.283185Z", true},
+    {"date-time", "1963-06-19t08:30:06z", true},
+    {"date-time", "1963-06-19 08:30:06Z", false},
+    {"date-time", "1963-06-19T08:30:06", false},
+    {"uuid", "2eb8aa08-aa98-11ea-b4aa-73b441d16380", true},
+    {"uuid", "2EB8AA08-AA98-11EA-B4AA-73B441D16380", true},
+    {"uuid", "2eb8aa08-aa98-11ea-b4aa-73b441d1638", false},
+    {"uuid", "2eb8aa08aa98-11ea-b4aa-73b441d163800", false},
+    {"uuid", "2eb8aa08-aa98-11ea-b4aa-73b441d1638g", false},
+    {"ipv4", "192.168.0.1", true},
+    {"ipv4", "255.255.255.255", true},
+    {"ipv4", "256.0.0.1", false},
+    {"ipv4", "192.168.0", false},
+    {"ipv4", "192.168.00.1", false},
+    {"ipv4", "1.2.3.4.5", false},
+    {"email", "joe.bloggs@example.com", true},
+    {"email", "te~st@example.com", true},
+    {"email", "\\\"joe bloggs\\\"@example.com", true},
+    {"email", "joe@[127.0.0.1]", true},
+    {"email", ".joe@example.com", false},
+    {"email", "joe..bloggs@example.com", false},
+    {"email", "joe@-example.com", false},
+    {"email", "joe", false},
+    {"email", "joe@", false},
+    {"lowercase", "Anything", true},      /* unknown formats stay annotations */
+  };
+  MACRO_ASSERT_TRUE(run_cases(p, "format", cases, sizeof(cases) / sizeof(cases[0])));
+
+  /* escapes in the instance are decoded before checking */
+  MACRO_ASSERT_TRUE(ajsb_format_check_json(AJSB_FORMAT_DATE, "2024\\u002d01-01", 15));
+  MACRO_ASSERT_TRUE(!ajsb_format_check_json(AJSB_FORMAT_DATE, "2024\\u002f01-01", 15));
+  MACRO_ASSERT_TRUE(ajsb_format_id("date-time") == AJSB_FORMAT_DATE_TIME);
+  MACRO_ASSERT_TRUE(ajsb_format_id("hostname") == AJSB_FORMAT_NONE);
+
+  /* only strings are checked */
+  ajsb_program_t *prog = ajsb_compile(p, P(p, "{\"format\":\"uuid\"}"));
+  MACRO_ASSERT_TRUE(ajsb_validate(prog, P(p, "42")));
+  aml_pool_destroy(p);
+}
+
+/* ---------- 2) pattern_matching ---------- */
+MACRO_TEST(ajsb_pattern_matching) {
+  aml_pool_t *p = aml_pool_init(8192);
+  static const string_case_t cases[] = {
+    {"^[0-9a-fA-F-]{36}$", "2eb8aa08-aa98-11ea-b4aa-73b441d16380", true},
+    {"^[0-9a-fA-F-]{36}$", "2eb8aa08-aa98-11ea-b4aa-73b441d1638", false},
+    {"^[0-9a-fA-F-]{36}$", "2eb8aa08-aa98-11ea-b4aa-73b441d1638z", false},
+    {"^\\d+$", "12345", true},
+    {"^\\d+$", "", false},
+    {"^\\d*$", "", true},
+    {"^$", "", true},
+    {"^$", "x", false},
+    {"ab", "xxabyy", true},                  /* unanchored search */
+    {"ab", "xxaxbyy", false},
+    {"^ab", "xab", false},
+    {"ab$", "xab", true},
+    {"ab$", "abx", false},
+    {"^(cat|dog)s?$", "dogs", true},
+    {"^(cat|dog)s?$", "cow", false},
+    {"^(?:ab){2,3}$", "ababab", true},
+    {"^(?:ab){2,3}$", "ab", false},
+    {"^(?:ab){2,3}$", "abababab", false},
+    {"^(?<year>\\d{4})-\\d{2}$", "2024-06", true},
+    {"^a{2,}?$", "aaaa", true},
+    {"^a{2,}?$", "a", false},
+    {"^[^a-z]+$", "ABC\xc3\xa9", true},       /* negated classes take whole characters */
+    {"^[^a-z]+$", "ABc", false},
+    {"^.{3}$", "caf\xc3\xa9" "x", false},
+    {"^.{4}$", "caf\xc3\xa9", true},
+    {"^caf\xc3\xa9$", "caf\\u00e9", true},     /* instance escapes decoded */
+    {"^[\xc3\xa9x]$", "\xc3\xa9", true},
+    {"^\\u00e9$", "\xc3\xa9", true},
+    {"^[\\w.-]+@[\\w-]+\\.[a-z]{2,}$", "jo.e@ex-ample.com", true},
+    {"^[\\w.-]+@[\\w-]+\\.[a-z]{2,}$", "jo e@example.com", false},
+    {"^\\S+$", "no-spaces", true},
+    {"^\\S+$", "one space", false},
+    {"a.c", "a\\nc", false},                   /* . excludes line terminators */
+    {"[]", "anything", false},
+    {"^[a-]+$", "a-a", true},
+    {"^\\$\\d+\\.\\d{2}$", "$10.50", true},
+    {"^(a|b)*abb$", "babaabb", true},
+    {"^(a|b)*abb$", "babaab", false},
+    {"(\\w)\\1", "aa", true},              /* back reference: not compiled, unchecked */
+    {"a(?=b)", "ac", true},                    /* lookahead: unchecked */
+    {"x*", "anything", true},                  /* matches everything */
+  };
+  MACRO_ASSERT_TRUE(run_cases(p, "pattern", cases, sizeof(cases) / sizeof(cases[0])));
+  aml_pool_destroy(p);
+}
+
+/* ---------- 3) consumers_agree ---------- */
+MACRO_TEST(ajsb_format_consumers_agree) {
+  aml_pool_t *p = aml_pool_init(8192);
+  typedef struct { ajsb_text_t id; ajsb_text_t day; } rec_t;
+
+  ajsb_fields_t *f = ajsb_fields_init(p);
+  ajson_t *o = ajsb_object(p);
+  ajson_t *id = ajsb_string(p);
+  ajsb_string_format(p, id, "uuid");
+  ajson_t *day = ajsb_string(p);
+  ajsb_string_pattern(p, day, "^(mon|tue|wed|thu|fri)$");
+  ajsb_fields_prop_required(f, o, "id", id, AJSB_FIELD_STRING, offsetof(rec_t, id));
+  ajsb_fields_prop(f, o, "day", day, AJSB_FIELD_STRING, offsetof(rec_t, day));
+
+  ajsb_program_t *prog = ajsb_compile(p, o);
+  ajsb_decoder_t *d = ajsb_decoder_init(p, f, o);
+  ajsb_stream_t *st = ajsb_stream_init(p, prog);
+  MACRO_ASSERT_TRUE(prog && d && st);
+
+  static const char *const docs[] = {
+    "{\"id\":\"2eb8aa08-aa98-11ea-b4aa-73b441d16380\",\"day\":\"tue\"}",
+    "{\"id\":\"2eb8aa08-aa98-11ea-b4aa-73b441d16380\",\"day\":\"sat\"}",
+    "{\"id\":\"2eb8aa08-aa98-11ea-b4aa-73b441d1638\"}",
+    "{\"id\":\"2eb8aa08-aa98-11ea-b4aa-73b441d16380\",\"day\":\"\\u0074ue\"}",
+    "{\"id\":\"2eb8aa08\\u002daa98-11ea-b4aa-73b441d16380\"}",
+    "{\"id\":\"not-a-uuid\",\"day\":\"mon\"}",
+  };
+  static const bool want[] = {true, false, false, true, true, false};
+  for (size_t i = 0; i < sizeof(docs) / sizeof(docs[0]); i++) {
+    size_t len = strlen(docs[i]);
+    MACRO_ASSERT_TRUE(ajsb_validate(prog, P(p, docs[i])) == want[i]);
+
+    rec_t r = {0};
+    ajsb_decode_error_t err;
+    ajsb_decode_status_t ds = ajsb_decode(d, p, docs[i], len, &r, &err);
+    MACRO_ASSERT_TRUE((ds == AJSB_DECODE_OK) == want[i]);
+
+    ajsb_stream_reset(st);
+    ajsb_stream_status_t ss = ajsb_stream_push(st, docs[i], len);
+    if (ss == AJSB_STREAM_CONTINUE) ss = ajsb_stream_finish(st);
+    MACRO_ASSERT_TRUE((ss == AJSB_STREAM_COMPLETE) == want[i]);
+  }
+  aml_pool_destroy(p);
+}
+
+/* ---------- Runner ---------- */
+int main(void) {
+  macro_test_case tests[16];
+  size_t test_count = 0;
+
+  MACRO_ADD(tests, ajsb_format_checks);
+  MACRO_ADD(tests, ajsb_pattern_matching);
+  MACRO_ADD(tests, ajsb_format_consumers_agree);
+
+  macro_run_all("a-json-schema-builder/ajsb_format", tests, test_count);
+  return 0;
+}
@@ -0,0 +1,170 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#include "a-json-schema-builder-library/ajsb.h"
+#include "a-json-schema-builder-library/ajsb_frozen.h"
+#include "a-json-schema-builder-library/ajsb_intern.h"
+#include "a-json-schema-builder-library/ajsb_validate.h"
+#include "a-json-library/ajson.h"
+#include "a-memory-library/aml_buffer.h"
+#include "a-memory-library/aml_pool.h"
+#include "the-macro-library/macro_test.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+
+/* Small helpers */
+static ajson_t *P(aml_pool_t *p, const char *s) { return ajson_parse_string(p, aml_pool_strdup(p, s)); }
+
+static const char *S(aml_pool_t *p, ajsb_fnode_t n) {
+  aml_buffer_t *bh = aml_buffer_init(256);
+  ajsb_fnode_stringify(n, bh);
+  char *r = aml_pool_strdup(p, aml_buffer_data(bh));
+  aml_buffer_destroy(bh);
+  return r;
+}
+
+static ajson_t *user(aml_pool_t *p) {
+  ajson_t *u = ajsb_object(p);
+  ajson_t *email = ajsb_string(p);
+  ajsb_string_format(p, email, "email");
+  ajsb_prop_required(p, u, "email", email);
+  ajson_t *age = ajsb_integer(p);
+  ajsb_number_min(p, age, 0, false);
+  ajsb_prop(p, u, "age", age);
+  const char *roles[] = {"admin", "user"};
+  ajson_t *role = ajsb_string(p);
+  ajsb_string_enum(p, role, 2, roles);
+  ajsb_prop(p, u, "role", role);
+  ajsb_additional_properties(p, u, false);
+  return u;
+}
+
+static ajson_t *tree(aml_pool_t *p) {
+  ajson_t *node = ajsb_object(p);
+  ajsb_prop_required(p, node, "value", ajsb_number(p));
+  ajsb_prop(p, node, "children", ajsb_array(p, ajsb_ref(p, "#")));
+  return node;
+}
+
+/* ---------- 1) round_trip ---------- */
+MACRO_TEST(ajsb_frozen_round_trip) {
+  aml_pool_t *p = aml_pool_init(4096);
+  aml_buffer_t *bh = aml_buffer_init(1024);
+
+  const char *names[] = {"user", "tree", "flag"};
+  ajson_t *schemas[] = {user(p), tree(p), ajsb_boolean(p)};
+  MACRO_ASSERT_TRUE(ajsb_freeze(bh, 3, names, schemas));
+
+  ajsb_frozen_t *f = ajsb_frozen_load(aml_buffer_data(bh), aml_buffer_length(bh));
+  MACRO_ASSERT_TRUE(f != NULL);
+  MACRO_ASSERT_TRUE(ajsb_frozen_count(f) == 3);
+  MACRO_ASSERT_STREQ(ajsb_frozen_name(f, 1), "tree");
+  MACRO_ASSERT_TRUE(ajsb_frozen_find(f, "flag") == 2);
+  MACRO_ASSERT_TRUE(ajsb_frozen_find(f, "user") == 0);
+  MACRO_ASSERT_TRUE(ajsb_frozen_find(f, "nope") == -1);
+
+  for (size_t i = 0; i < 3; i++)
+    MACRO_ASSERT_STREQ(S(p, ajsb_frozen_root(f, i)), ajsb_stringify(p, schemas[i]));
+
+  /* accessors */
+  ajsb_fnode_t u = ajsb_frozen_root(f, 0);
+  MACRO_ASSERT_TRUE(ajsb_fnode_type(u) == AJSB_FROZEN_OBJECT);
+  MACRO_ASSERT_STREQ(ajsb_fnode_key(u, 0), "type");
+  ajsb_fnode_t email = ajsb_fnode_get(ajsb_fnode_get(u, "properties"), "email");
+  MACRO_ASSERT_STREQ(ajsb_fnode_str(ajsb_fnode_get(email, "format")), "email");
+  ajsb_fnode_t req = ajsb_fnode_get(u, "required");
+  MACRO_ASSERT_TRUE(ajsb_fnode_type(req) == AJSB_FROZEN_ARRAY && ajsb_fnode_count(req) == 1);
+  MACRO_ASSERT_TRUE(ajsb_fnode_type(ajsb_fnode_get(u, "additionalProperties")) == AJSB_FROZEN_FALSE);
+  MACRO_ASSERT_TRUE(ajsb_fnode_type(ajsb_fnode_get(u, "missing")) == AJSB_FROZEN_NONE);
+
+  /* validation straight off the blob */
+  const char *docs[] = {
+    "{\"email\":\"a@b\",\"age\":3,\"role\":\"admin\"}",
+    "{\"email\":\"a@b\",\"role\":\"root\"}",
+    "{\"age\":3}",
+  };
+  ajsb_program_t *prog = ajsb_compile(p, schemas[0]);
+  for (size_t i = 0; i < 3; i++)
+    MACRO_ASSERT_TRUE(ajsb_frozen_validate(f, 0, P(p, docs[i])) == ajsb_validate(prog, P(p, docs[i])));
+  MACRO_ASSERT_TRUE(ajsb_frozen_validate(f, 1, P(p, "{\"value\":1,\"children\":[{\"value\":2}]}")));
+  MACRO_ASSERT_TRUE(!ajsb_frozen_validate(f, 1, P(p, "{\"value\":1,\"children\":[{}]}")));
+  MACRO_ASSERT_TRUE(ajsb_frozen_validate(f, 2, P(p, "true")));
+
+  ajsb_frozen_close(f);
+  aml_buffer_destroy(bh);
+  aml_pool_destroy(p);
+}
+
+/* ---------- 2) shared_strings_and_subtrees ---------- */
+MACRO_TEST(ajsb_frozen_shared_strings_and_subtrees) {
+  aml_pool_t *p = aml_pool_init(4096);
+  aml_buffer_t *a = aml_buffer_init(1024), *b = aml_buffer_init(1024);
+
+  ajson_t *plain[8], *shared[8];
+  ajsb_intern_t *in = ajsb_intern_init();
+  for (int i = 0; i < 8; i++) {
+    plain[i] = user(p);
+    shared[i] = ajsb_intern(in, user(p));
+  }
+  MACRO_ASSERT_TRUE(ajsb_freeze(a, 8, NULL, plain));
+  MACRO_ASSERT_TRUE(ajsb_freeze(b, 8, NULL, shared));
+  /* interned trees are stored once */
+  MACRO_ASSERT_TRUE(aml_buffer_length(b) < aml_buffer_length(a));
+
+  ajsb_frozen_t *f = ajsb_frozen_load(aml_buffer_data(b), aml_buffer_length(b));
+  MACRO_ASSERT_STREQ(S(p, ajsb_frozen_root(f, 7)), ajsb_stringify(p, plain[0]));
+  MACRO_ASSERT_STREQ(ajsb_frozen_name(f, 7), "");
+  ajsb_frozen_close(f);
+
+  ajsb_intern_destroy(in);
+  aml_buffer_destroy(a);
+  aml_buffer_destroy(b);
+  aml_pool_destroy(p);
+}
+
+/* ---------- 3) file_and_rejects ---------- */
+MACRO_TEST(ajsb_frozen_file_and_rejects) {
+  aml_pool_t *p = aml_pool_init(4096);
+  const char *path = "ajsb_frozen_test.bin";
+
+  const char *names[] = {"user"};
+  ajson_t *schemas[] = {user(p)};
+  MACRO_ASSERT_TRUE(ajsb_freeze_file(path, 1, names, schemas));
+  ajsb_frozen_t *f = ajsb_frozen_open(path);
+  MACRO_ASSERT_TRUE(f != NULL);
+  MACRO_ASSERT_STREQ(S(p, ajsb_frozen_root(f, 0)), ajsb_stringify(p, schemas[0]));
+  MACRO_ASSERT_TRUE(ajsb_frozen_validate(f, 0, P(p, "{\"email\":\"x@example.com\"}")));
+  ajsb_frozen_close(f);
+  remove(path);
+
+  MACRO_ASSERT_TRUE(ajsb_frozen_open(path) == NULL);
+
+  /* damaged or truncated blobs are refused */
+  aml_buffer_t *bh = aml_buffer_init(1024);
+  ajsb_freeze(bh, 1, names, schemas);
+  MACRO_ASSERT_TRUE(ajsb_frozen_load(aml_buffer_data(bh), 16) == NULL);
+  MACRO_ASSERT_TRUE(ajsb_frozen_load(aml_buffer_data(bh), aml_buffer_length(bh) - 8) == NULL);
+  aml_buffer_data(bh)[0] = 'X';
+  MACRO_ASSERT_TRUE(ajsb_frozen_load(aml_buffer_data(bh), aml_buffer_length(bh)) == NULL);
+  aml_buffer_destroy(bh);
+
+  aml_pool_destroy(p);
+}
+
+/* ---------- Runner ---------- */
+int main(void) {
+  macro_test_case tests[16];
+  size_t test_count = 0;
+
+  MACRO_ADD(tests, ajsb_frozen_round_trip);
+  MACRO_ADD(tests, ajsb_frozen_shared_strings_and_subtrees);
+  MACRO_ADD(tests, ajsb_frozen_file_and_rejects);
+
+  macro_run_all("a-json-schema-builder/ajsb_frozen", tests, test_count);
+  return 0;
+}
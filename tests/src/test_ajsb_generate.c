@@ -0,0 +1,255 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#include "a-json-schema-builder-library/ajsb.h"
+#include "a-json-schema-builder-library/ajsb_batch.h"
+#include "a-json-schema-builder-library/ajsb_generate.h"
+#include "a-json-schema-builder-library/ajsb_validate.h"
+#include "a-json-library/ajson.h"
+#include "a-memory-library/aml_buffer.h"
+#include "a-memory-library/aml_pool.h"
+#include "the-macro-library/macro_test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+
+static ajson_t *P(aml_pool_t *p, const char *s) { return ajson_parse_string(p, aml_pool_strdup(p, s)); }
+
+/* order: id (uuid), status (enum), qty (1..99), price (0 < x <= 1e4), sku
+   (pattern), tags (1..3 unique strings), placed (date-time), contact
+   (email or null), parts (recursive through $defs) */
+static ajson_t *order_schema(aml_pool_t *p) {
+  ajson_t *s = ajsb_object(p);
+  ajson_t *id = ajsb_string(p);
+  ajsb_string_format(p, id, "uuid");
+  ajsb_prop_required(p, s, "id", id);
+  static const char *const states[] = {"new", "paid", "shipped"};
+  ajson_t *status = ajsb_string(p);
+  ajsb_string_enum(p, status, 3, states);
+  ajsb_prop_required(p, s, "status", status);
+  ajson_t *qty = ajsb_integer(p);
+  ajsb_number_min(p, qty, 1, false);
+  ajsb_number_max(p, qty, 99, false);
+  ajsb_prop_required(p, s, "qty", qty);
+  ajson_t *price = ajsb_number(p);
+  ajsb_number_min(p, price, 0, true);
+  ajsb_number_max(p, price, 10000, false);
+  ajsb_prop(p, s, "price", price);
+  ajson_t *sku = ajsb_string(p);
+  ajsb_string_pattern(p, sku, "^[A-Z]{3}-[0-9]{2,4}(/(ab|cd)+)?$");
+  ajsb_prop_required(p, s, "sku", sku);
+  ajson_t *tags = ajsb_array(p, ajsb_string(p));
+  ajsb_array_min_items(p, tags, 1);
+  ajsb_array_max_items(p, tags, 3);
+  ajsb_array_unique(p, tags, true);
+  ajsb_prop(p, s, "tags", tags);
+  ajson_t *placed = ajsb_string(p);
+  ajsb_string_format(p, placed, "date-time");
+  ajsb_prop(p, s, "placed", placed);
+  ajson_t *email = ajsb_string(p);
+  ajsb_string_format(p, email, "email");
+  ajson_t *contact[] = {email, ajsb_null(p)};
+  ajsb_prop(p, s, "contact", ajsb_anyOf(p, 2, contact));
+  ajson_t *part = ajsb_object(p);
+  ajsb_prop_required(p, part, "name", ajsb_string(p));
+  ajsb_prop(p, part, "parts", ajsb_array(p, ajsb_ref(p, "#/$defs/part")));
+  ajsb_defs_add(p, s, "part", part);
+  ajsb_prop(p, s, "parts", ajsb_array(p, ajsb_ref(p, "#/$defs/part")));
+  ajsb_additional_properties(p, s, false);
+  return s;
+}
+
+static bool validates(aml_pool_t *p, const ajsb_program_t *prog, const char *text, size_t len) {
+  char *t = aml_pool_strndup(p, text, len);
+  ajson_t *j = ajson_parse(p, t, t + len);
+  return j && !ajson_is_error(j) && ajsb_validate(prog, j);
+}
+
+/* ---------- 1) valid ---------- */
+MACRO_TEST(ajsb_generate_valid) {
+  aml_pool_t *p = aml_pool_init(4096);
+  ajson_t *s = order_schema(p);
+  const ajsb_program_t *prog = ajsb_compile(p, s);
+  ajsb_generate_options_t opts = {.seed = 42};
+  ajsb_generator_t *g = ajsb_generator_init(s, &opts);
+  MACRO_ASSERT_TRUE(g != NULL);
+
+  aml_buffer_t *bh = aml_buffer_init(1024);
+  aml_pool_t *tmp = aml_pool_init(4096);
+  size_t with_price = 0, nested = 0;
+  for (uint64_t n = 0; n < 300; n++) {
+    aml_buffer_clear(bh);
+    MACRO_ASSERT_TRUE(ajsb_generate(g, n, true, bh));
+    const char *text = aml_buffer_data(bh);
+    MACRO_ASSERT_TRUE(validates(tmp, prog, text, aml_buffer_length(bh)));
+    MACRO_ASSERT_TRUE(!memchr(text, '\n', aml_buffer_length(bh)));
+    with_price += strstr(text, "\"price\":") != NULL;
+    nested += strstr(text, "\"parts\":[{") != NULL;
+    aml_pool_clear(tmp);
+  }
+  MACRO_ASSERT_TRUE(with_price > 50 && with_price < 250);      /* optional: about half */
+  MACRO_ASSERT_TRUE(nested > 0);
+
+  /* same seed and n, same bytes; another seed, other bytes */
+  ajsb_generator_t *same = ajsb_generator_init(s, &opts);
+  opts.seed = 43;
+  ajsb_generator_t *other = ajsb_generator_init(s, &opts);
+  aml_buffer_t *a = aml_buffer_init(256), *b = aml_buffer_init(256), *c = aml_buffer_init(256);
+  ajsb_generate(g, 7, true, a);
+  ajsb_generate(same, 7, true, b);
+  ajsb_generate(other, 7, true, c);
+  MACRO_ASSERT_TRUE(!strcmp(aml_buffer_data(a), aml_buffer_data(b)));
+  MACRO_ASSERT_TRUE(strcmp(aml_buffer_data(a), aml_buffer_data(c)));
+
+  /* recursion stops: a schema that may nest forever */
+  ajson_t *tree = P(p, "{\"type\":\"object\",\"properties\":{\"kids\":{\"type\":\"array\","
+                       "\"items\":{\"$ref\":\"#\"},\"minItems\":1}}}");
+  ajsb_generator_t *t = ajsb_generator_init(tree, NULL);
+  for (uint64_t n = 0; n < 50; n++) MACRO_ASSERT_TRUE(ajsb_generate(t, n, true, bh));
+
+  aml_buffer_destroy(a);
+  aml_buffer_destroy(b);
+  aml_buffer_destroy(c);
+  ajsb_generator_destroy(t);
+  ajsb_generator_destroy(same);
+  ajsb_generator_destroy(other);
+  ajsb_generator_destroy(g);
+  aml_buffer_destroy(bh);
+  aml_pool_destroy(tmp);
+  aml_pool_destroy(p);
+}
+
+/* ---------- 2) invalid ---------- */
+MACRO_TEST(ajsb_generate_invalid) {
+  aml_pool_t *p = aml_pool_init(4096);
+  ajson_t *s = order_schema(p);
+  const ajsb_program_t *prog = ajsb_compile(p, s);
+  ajsb_generator_t *g = ajsb_generator_init(s, NULL);
+  aml_buffer_t *bh = aml_buffer_init(1024);
+  aml_pool_t *tmp = aml_pool_init(4096);
+  for (uint64_t n = 0; n < 300; n++) {
+    aml_buffer_clear(bh);
+    MACRO_ASSERT_TRUE(ajsb_generate(g, n, false, bh));
+    MACRO_ASSERT_TRUE(!validates(tmp, prog, aml_buffer_data(bh), aml_buffer_length(bh)));
+    char *t = aml_pool_strndup(tmp, aml_buffer_data(bh), aml_buffer_length(bh));
+    MACRO_ASSERT_TRUE(ajson_parse(tmp, t, t + aml_buffer_length(bh)) != NULL);   /* still JSON */
+    aml_pool_clear(tmp);
+  }
+  ajsb_generator_destroy(g);
+
+  /* nothing to break in true, nothing to make from false */
+  aml_buffer_clear(bh);
+  aml_buffer_appends(bh, "x");
+  g = ajsb_generator_init(P(p, "true"), NULL);
+  MACRO_ASSERT_TRUE(ajsb_generate(g, 0, true, bh));
+  MACRO_ASSERT_TRUE(!ajsb_generate(g, 0, false, bh));
+  ajsb_generator_destroy(g);
+  g = ajsb_generator_init(P(p, "{\"type\":\"integer\",\"minimum\":5,\"maximum\":4}"), NULL);
+  size_t len = aml_buffer_length(bh);
+  MACRO_ASSERT_TRUE(!ajsb_generate(g, 0, true, bh) && aml_buffer_length(bh) == len);
+  MACRO_ASSERT_TRUE(ajsb_generate(g, 0, false, bh));
+  ajsb_generator_destroy(g);
+  MACRO_ASSERT_TRUE(ajsb_generator_init(P(p, "{\"$ref\":\"#/nowhere\"}"), NULL) == NULL);
+
+  aml_buffer_destroy(bh);
+  aml_pool_destroy(tmp);
+  aml_pool_destroy(p);
+}
+
+/* ---------- 3) patterns ---------- */
+MACRO_TEST(ajsb_generate_patterns) {
+  static const char *const patterns[] = {
+    "^[a-z]{4,8}$", "^(ab|cd)+x?$", "foo", "^\\\\d{3}-\\\\d{4}$", "^[^\\\"]{2}\\\\.[0-9]+$",
+    "^(a|b|c)*z$", "^\\\\w+@\\\\w+$",
+  };
+  aml_pool_t *p = aml_pool_init(4096);
+  aml_buffer_t *bh = aml_buffer_init(256);
+  for (size_t i = 0; i < sizeof(patterns) / sizeof(patterns[0]); i++) {
+    char text[128];
+    snprintf(text, sizeof(text), "{\"type\":\"string\",\"pattern\":\"%s\",\"maxLength\":20}", patterns[i]);
+    ajson_t *s = P(p, text);
+    const ajsb_program_t *prog = ajsb_compile(p, s);
+    ajsb_generator_t *g = ajsb_generator_init(s, NULL);
+    for (uint64_t n = 0; n < 100; n++) {
+      aml_buffer_clear(bh);
+      MACRO_ASSERT_TRUE(ajsb_generate(g, n, true, bh));
+      MACRO_ASSERT_TRUE(validates(p, prog, aml_buffer_data(bh), aml_buffer_length(bh)));
+      aml_buffer_clear(bh);
+      MACRO_ASSERT_TRUE(ajsb_generate(g, n, false, bh));
+      MACRO_ASSERT_TRUE(!validates(p, prog, aml_buffer_data(bh), aml_buffer_length(bh)));
+    }
+    ajsb_generator_destroy(g);
+  }
+  aml_buffer_destroy(bh);
+  aml_pool_destroy(p);
+}
+
+/* ---------- 4) file ---------- */
+static char *slurp(const char *path, size_t *len) {
+  FILE *fp = fopen(path, "rb");
+  fseek(fp, 0, SEEK_END);
+  *len = (size_t)ftell(fp);
+  fseek(fp, 0, SEEK_SET);
+  char *d = (char *)malloc(*len + 1);
+  *len = fread(d, 1, *len, fp);
+  fclose(fp);
+  return d;
+}
+
+MACRO_TEST(ajsb_generate_jsonl) {
+  aml_pool_t *p = aml_pool_init(4096);
+  ajson_t *s = order_schema(p);
+  const ajsb_program_t *prog = ajsb_compile(p, s);
+  char one[] = "/tmp/ajsb_generate_1_XXXXXX", four[] = "/tmp/ajsb_generate_4_XXXXXX";
+  close(mkstemp(one));
+  close(mkstemp(four));
+
+  ajsb_generate_options_t opts = {.seed = 7, .invalid_ratio = 0.25, .threads = 1};
+  ajsb_generator_t *g = ajsb_generator_init(s, &opts);
+  size_t lines = ajsb_generate_file(g, one, 200000);
+  ajsb_generator_destroy(g);
+  opts.threads = 4;
+  g = ajsb_generator_init(s, &opts);
+  MACRO_ASSERT_TRUE(ajsb_generate_file(g, four, 200000) == lines);
+  ajsb_generator_destroy(g);
+
+  size_t a_len, b_len;
+  char *a = slurp(one, &a_len), *b = slurp(four, &b_len);
+  MACRO_ASSERT_TRUE(a_len >= 200000 && a_len == b_len && !memcmp(a, b, a_len));
+  MACRO_ASSERT_TRUE(a[a_len - 1] == '\n');
+  free(a);
+  free(b);
+
+  ajsb_batch_result_t r;
+  MACRO_ASSERT_TRUE(ajsb_validate_batch_file(prog, one, NULL, &r));
+  MACRO_ASSERT_TRUE(r.lines == lines && r.parse_errors == 0 && r.blank == 0);
+  MACRO_ASSERT_TRUE(r.invalid > lines / 8 && r.invalid < lines * 3 / 8);
+  ajsb_batch_result_destroy(&r);
+
+  g = ajsb_generator_init(P(p, "false"), NULL);
+  MACRO_ASSERT_TRUE(ajsb_generate_file(g, one, 100) == (size_t)-1);
+  ajsb_generator_destroy(g);
+  unlink(one);
+  unlink(four);
+  aml_pool_destroy(p);
+}
+
+/* ---------- Runner ---------- */
+int main(void) {
+  macro_test_case tests[16];
+  size_t test_count = 0;
+
+  MACRO_ADD(tests, ajsb_generate_valid);
+  MACRO_ADD(tests, ajsb_generate_invalid);
+  MACRO_ADD(tests, ajsb_generate_patterns);
+  MACRO_ADD(tests, ajsb_generate_jsonl);
+
+  macro_run_all("a-json-schema-builder/ajsb_generate", tests, test_count);
+  return 0;
+}
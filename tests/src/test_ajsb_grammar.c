@@ -0,0 +1,268 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#include "a-json-schema-builder-library/ajsb.h"
+#include "a-json-schema-builder-library/ajsb_grammar.h"
+#include "a-json-library/ajson.h"
+#include "a-memory-library/aml_pool.h"
+#include "the-macro-library/macro_test.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+
+/* Small helpers */
+static bool matches(const ajsb_grammar_t *g, const char *text) {
+  ajsb_grammar_matcher_t *m = ajsb_grammar_matcher_init(g);
+  bool ok = ajsb_grammar_matcher_push(m, text, strlen(text)) && ajsb_grammar_matcher_complete(m);
+  ajsb_grammar_matcher_destroy(m);
+  return ok;
+}
+#define OK(g, text)  MACRO_ASSERT_TRUE(matches((g), (text)))
+#define BAD(g, text) MACRO_ASSERT_TRUE(!matches((g), (text)))
+
+static bool allows(const uint8_t set[32], char c) {
+  return (set[(uint8_t)c >> 3] >> ((uint8_t)c & 7)) & 1;
+}
+
+static ajson_t *weather(aml_pool_t *p) {
+  ajson_t *root = ajsb_object(p);
+  ajsb_prop(p, root, "city",       ajsb_string(p));
+  ajsb_prop(p, root, "tempC",      ajsb_number(p));
+  ajsb_prop(p, root, "conditions", ajsb_string(p));
+  const char *req[] = {"city","tempC","conditions"};
+  ajsb_required(p, root, 3, req);
+  ajsb_additional_properties(p, root, false);
+  return root;
+}
+
+/* ---------- 1) weather_gbnf ---------- */
+MACRO_TEST(ajsb_grammar_weather_gbnf) {
+  aml_pool_t *p = aml_pool_init(4096);
+  ajsb_grammar_t *g = ajsb_to_grammar(p, weather(p));
+  MACRO_ASSERT_TRUE(g != NULL);
+
+  const char *gbnf = ajsb_grammar_gbnf(g);
+  MACRO_ASSERT_TRUE(!strncmp(gbnf, "root ::= ws n0 ws\n", 18));
+  MACRO_ASSERT_TRUE(strstr(gbnf, "n0 ::= \"{\" ws \"\\\"city\\\"\" ws \":\" ws ") != NULL);
+  MACRO_ASSERT_TRUE(strstr(gbnf, "ws ::= | [\\t\\n\\r ] ws\n") != NULL);
+  MACRO_ASSERT_TRUE(strstr(gbnf, "char ::= [^\\x00-\\x1F\\\"\\\\] | \"\\\\\" escape\n") != NULL);
+
+  OK(g,  "{\"city\":\"Oslo\",\"tempC\":-3.5e2,\"conditions\":\"snow \\u00e9\"}");
+  OK(g,  " {\n  \"city\" : \"Oslo\",\n  \"tempC\" : 0,\n  \"conditions\" : \"\"\n}\n");
+  BAD(g, "{\"city\":\"Oslo\",\"tempC\":01,\"conditions\":\"snow\"}");
+  BAD(g, "{\"city\":\"Oslo\",\"conditions\":\"snow\"}");
+
+  /* the matcher reports what may come next */
+  ajsb_grammar_matcher_t *m = ajsb_grammar_matcher_init(g);
+  uint8_t next[32];
+  MACRO_ASSERT_TRUE(ajsb_grammar_matcher_push(m, "{\"c", 3));
+  ajsb_grammar_matcher_allowed(m, next);
+  MACRO_ASSERT_TRUE(allows(next, 'i'));
+  MACRO_ASSERT_TRUE(!allows(next, 'o'));
+  MACRO_ASSERT_TRUE(!ajsb_grammar_matcher_push(m, "o", 1));
+  MACRO_ASSERT_TRUE(!ajsb_grammar_matcher_complete(m));
+  ajsb_grammar_matcher_reset(m);
+  ajsb_grammar_matcher_allowed(m, next);
+  MACRO_ASSERT_TRUE(allows(next, '{') && allows(next, ' ') && !allows(next, '['));
+  ajsb_grammar_matcher_destroy(m);
+
+  aml_pool_destroy(p);
+}
+
+/* ---------- 2) enum_optional_anyof ---------- */
+MACRO_TEST(ajsb_grammar_enum_optional_anyof) {
+  aml_pool_t *p = aml_pool_init(4096);
+
+  ajson_t *sort_enum = ajsb_string(p);
+  const char *vals[] = {"asc","desc"};
+  ajsb_string_enum(p, sort_enum, 2, vals);
+  ajson_t *alts[2] = { sort_enum, ajsb_null(p) };
+  ajson_t *root = ajsb_object(p);
+  ajsb_prop(p, root, "term", ajsb_string(p));
+  ajsb_prop_required(p, root, "sort", ajsb_anyOf(p, 2, alts));
+  ajsb_prop(p, root, "page", ajsb_integer(p));
+  ajsb_additional_properties(p, root, false);
+
+  ajsb_grammar_t *g = ajsb_to_grammar(p, root);
+  OK(g,  "{\"sort\":\"asc\"}");
+  OK(g,  "{\"term\":\"x\",\"sort\":null}");
+  OK(g,  "{\"term\":\"x\",\"sort\":\"desc\",\"page\":2}");
+  OK(g,  "{\"sort\":\"desc\",\"page\":2}");
+  BAD(g, "{\"term\":\"x\"}");                      /* sort is required */
+  BAD(g, "{\"sort\":\"up\"}");
+  BAD(g, "{\"sort\":\"asc\",\"page\":2.5}");
+  BAD(g, "{\"page\":2,\"sort\":\"asc\"}");         /* declared order only */
+  BAD(g, "{\"sort\":\"asc\",}");
+
+  aml_pool_destroy(p);
+}
+
+/* ---------- 3) bounded_arrays ---------- */
+MACRO_TEST(ajsb_grammar_bounded_arrays) {
+  aml_pool_t *p = aml_pool_init(4096);
+
+  ajson_t *arr = ajsb_array(p, ajsb_boolean(p));
+  ajsb_array_min_items(p, arr, 1);
+  ajsb_array_max_items(p, arr, 3);
+  ajsb_grammar_t *g = ajsb_to_grammar(p, arr);
+  BAD(g, "[]");
+  OK(g,  "[true]");
+  OK(g,  "[ true , false ,true ]");
+  BAD(g, "[true,true,true,true]");
+  BAD(g, "[1]");
+
+  ajson_t *open = ajsb_array(p, ajsb_integer(p));
+  ajsb_array_min_items(p, open, 2);
+  g = ajsb_to_grammar(p, open);
+  BAD(g, "[1]");
+  OK(g,  "[1,2]");
+  OK(g,  "[1,2,3,4,5,6,7,8,9,10]");
+
+  g = ajsb_to_grammar(p, ajsb_array(p, NULL));     /* untyped items */
+  OK(g,  "[]");
+  OK(g,  "[1,\"a\",{\"k\":[null]},[true]]");
+
+  aml_pool_destroy(p);
+}
+
+/* ---------- 4) recursive_defs ---------- */
+MACRO_TEST(ajsb_grammar_recursive_defs) {
+  aml_pool_t *p = aml_pool_init(8192);
+
+  ajson_t *node = ajsb_object(p);
+  ajsb_prop_required(p, node, "label", ajsb_string(p));
+  ajsb_prop_required(p, node, "children", ajsb_array(p, ajsb_ref(p, "#/$defs/node")));
+  ajsb_additional_properties(p, node, false);
+  ajson_t *root = ajsb_object(p);
+  ajsb_defs_add(p, root, "node", node);
+  ajsb_prop_required(p, root, "root", ajsb_ref(p, "#/$defs/node"));
+
+  ajsb_grammar_t *g = ajsb_to_grammar(p, root);
+  MACRO_ASSERT_TRUE(g != NULL);
+  OK(g,  "{\"root\":{\"label\":\"a\",\"children\":[{\"label\":\"b\",\"children\":[]}]}}");
+  OK(g,  "{\"root\":{\"label\":\"a\",\"children\":[{\"label\":\"b\",\"children\":[{\"label\":\"c\",\"children\":[]}]},"
+         "{\"label\":\"d\",\"children\":[]}]}}");
+  BAD(g, "{\"root\":{\"label\":\"a\",\"children\":[{\"label\":\"b\"}]}}");
+
+  MACRO_ASSERT_TRUE(ajsb_to_grammar(p, ajsb_ref(p, "#/$defs/missing")) == NULL);
+
+  aml_pool_destroy(p);
+}
+
+/* ---------- 5) cache ---------- */
+MACRO_TEST(ajsb_grammar_cache) {
+  aml_pool_t *p = aml_pool_init(4096);
+  ajsb_grammar_cache_t *c = ajsb_grammar_cache_init();
+
+  const ajsb_grammar_t *a = ajsb_grammar_cache_get(c, weather(p));
+  const ajsb_grammar_t *b = ajsb_grammar_cache_get(c, weather(p));   /* equal, not the same tree */
+  MACRO_ASSERT_TRUE(a != NULL && a == b);
+  MACRO_ASSERT_TRUE(ajsb_grammar_cache_hits(c) == 1);
+  MACRO_ASSERT_TRUE(ajsb_grammar_cache_misses(c) == 1);
+
+  char name[16];
+  for (int i = 0; i < 100; i++) {
+    ajson_t *s = ajsb_object(p);
+    sprintf(name, "f%d", i);
+    ajsb_prop_required(p, s, name, ajsb_integer(p));
+    MACRO_ASSERT_TRUE(ajsb_grammar_cache_get(c, s) != NULL);
+  }
+  MACRO_ASSERT_TRUE(ajsb_grammar_cache_misses(c) == 101);
+  MACRO_ASSERT_TRUE(ajsb_grammar_cache_get(c, weather(p)) == a);
+  MACRO_ASSERT_TRUE(matches(a, "{\"city\":\"a\",\"tempC\":1,\"conditions\":\"b\"}"));
+
+  ajsb_grammar_cache_destroy(c);
+  aml_pool_destroy(p);
+}
+
+/* ---------- 6) shape_not_validity ---------- */
+MACRO_TEST(ajsb_grammar_shape_not_validity) {
+  aml_pool_t *p = aml_pool_init(4096);
+
+  /* valid documents outside the canonical shape: the matcher is not a
+     validator */
+  ajson_t *s = ajson_parse_string(p, aml_pool_strdup(p,
+    "{\"type\":\"object\",\"properties\":{\"xq\":{\"type\":\"object\"},"
+    "\"kind\":{\"type\":\"string\"}},\"required\":[\"xq\"]}"));
+  ajsb_grammar_t *g = ajsb_to_grammar(p, s);
+  const ajsb_program_t *prog = ajsb_compile(p, s);
+  static const char *const outside[] = {
+    "{\"name\":{},\"xq\":{}}",                  /* undeclared property */
+    "{\"xq\":{},\"k\\u0069nd\":\"a\"}",         /* escaped key */
+  };
+  for (size_t i = 0; i < 2; i++) {
+    MACRO_ASSERT_TRUE(ajsb_validate(prog, ajson_parse_string(p, aml_pool_strdup(p, outside[i]))));
+    BAD(g, outside[i]);
+  }
+  OK(g, "{\"xq\":{},\"kind\":\"a\"}");
+
+  aml_pool_destroy(p);
+}
+
+/* ---------- 7) cache_concurrent ---------- */
+#define THREADS 8
+#define SCHEMAS 16
+
+typedef struct {
+  ajsb_grammar_cache_t *c;
+  const ajsb_grammar_t *got[SCHEMAS];
+} worker_t;
+
+static void *worker_main(void *arg) {
+  worker_t *w = (worker_t *)arg;
+  aml_pool_t *p = aml_pool_init(4096);
+  char name[16];
+  for (int round = 0; round < 4; round++)
+    for (int i = 0; i < SCHEMAS; i++) {
+      ajson_t *s = ajsb_object(p);
+      sprintf(name, "f%d", i);
+      ajsb_prop_required(p, s, name, ajsb_integer(p));
+      const ajsb_grammar_t *g = ajsb_grammar_cache_get(w->c, s);
+      if (round == 0) w->got[i] = g;
+      else if (g != w->got[i]) w->got[i] = NULL;
+    }
+  aml_pool_destroy(p);
+  return NULL;
+}
+
+MACRO_TEST(ajsb_grammar_cache_concurrent) {
+  ajsb_grammar_cache_t *c = ajsb_grammar_cache_init();
+  worker_t w[THREADS];
+  pthread_t t[THREADS];
+  for (int i = 0; i < THREADS; i++) {
+    w[i].c = c;
+    pthread_create(t + i, NULL, worker_main, w + i);
+  }
+  for (int i = 0; i < THREADS; i++) pthread_join(t[i], NULL);
+
+  /* racing misses may each compile, but one grammar per schema is kept */
+  for (int i = 0; i < THREADS; i++)
+    for (int k = 0; k < SCHEMAS; k++)
+      MACRO_ASSERT_TRUE(w[i].got[k] != NULL && w[i].got[k] == w[0].got[k]);
+  size_t misses = ajsb_grammar_cache_misses(c);
+  MACRO_ASSERT_TRUE(misses >= SCHEMAS && misses <= SCHEMAS * THREADS);
+  MACRO_ASSERT_TRUE(ajsb_grammar_cache_hits(c) + misses == THREADS * SCHEMAS * 4);
+  ajsb_grammar_cache_destroy(c);
+}
+
+/* ---------- Runner ---------- */
+int main(void) {
+  macro_test_case tests[16];
+  size_t test_count = 0;
+
+  MACRO_ADD(tests, ajsb_grammar_weather_gbnf);
+  MACRO_ADD(tests, ajsb_grammar_enum_optional_anyof);
+  MACRO_ADD(tests, ajsb_grammar_bounded_arrays);
+  MACRO_ADD(tests, ajsb_grammar_recursive_defs);
+  MACRO_ADD(tests, ajsb_grammar_cache);
+  MACRO_ADD(tests, ajsb_grammar_shape_not_validity);
+  MACRO_ADD(tests, ajsb_grammar_cache_concurrent);
+
+  macro_run_all("a-json-schema-builder/ajsb_grammar", tests, test_count);
+  return 0;
+}
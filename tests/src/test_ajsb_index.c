@@ -0,0 +1,115 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#include "a-json-schema-builder-library/ajsb.h"
+#include "a-json-schema-builder-library/ajsb_index.h"
+#include "a-json-library/ajson.h"
+#include "a-memory-library/aml_pool.h"
+#include "the-macro-library/macro_test.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+
+/* Small helpers */
+static const char *J(aml_pool_t *p, ajson_t *j) { return ajson_stringify(p, j); }
+
+/* ---------- 1) matches_plain_builder ---------- */
+MACRO_TEST(ajsb_index_matches_plain_builder) {
+  aml_pool_t *p = aml_pool_init(1 << 16);
+  ajsb_index_t *ix = ajsb_index_init(p);
+
+  ajson_t *plain = ajsb_object(p), *fast = ajsb_object(p);
+  for (int i = 0; i < 5000; i++) {
+    char name[16];
+    sprintf(name, "f%d", i);
+    if (i % 3) {
+      ajsb_prop(p, plain, name, ajsb_string(p));
+      ajsb_index_prop(ix, fast, name, ajsb_string(p));
+    } else {
+      ajsb_prop_required(p, plain, name, ajsb_integer(p));
+      ajsb_index_prop_required(ix, fast, name, ajsb_integer(p));
+    }
+  }
+  ajsb_defs_set(p, plain, "d", ajsb_number(p));
+  ajsb_index_defs_set(ix, fast, "d", ajsb_number(p));
+  MACRO_ASSERT_STREQ(J(p, fast), J(p, plain));
+
+  aml_pool_destroy(p);
+}
+
+/* ---------- 2) replace_keeps_position ---------- */
+MACRO_TEST(ajsb_index_replace_keeps_position) {
+  aml_pool_t *p = aml_pool_init(4096);
+  ajsb_index_t *ix = ajsb_index_init(p);
+
+  ajson_t *o = ajsb_object(p);
+  ajsb_index_prop(ix, o, "a", ajsb_string(p));
+  ajsb_index_prop(ix, o, "b", ajsb_string(p));
+  ajsb_index_prop(ix, o, "a", ajsb_number(p));
+  MACRO_ASSERT_STREQ(J(p, o),
+    "{\"type\":\"object\",\"properties\":{\"a\":{\"type\":\"number\"},\"b\":{\"type\":\"string\"}}}");
+  MACRO_ASSERT_STREQ(J(p, ajsb_index_get_prop(ix, o, "a")), "{\"type\":\"number\"}");
+  MACRO_ASSERT_TRUE(ajsb_index_get_prop(ix, o, "c") == NULL);
+
+  ajson_t *root = ajsb_object(p);
+  ajsb_index_defs_set(ix, root, "x", ajsb_string(p));
+  ajsb_index_defs_set(ix, root, "y", ajsb_string(p));
+  ajsb_index_defs_set(ix, root, "x", ajsb_boolean(p));
+  MACRO_ASSERT_STREQ(J(p, ajsono_scan(root, "$defs")),
+    "{\"x\":{\"type\":\"boolean\"},\"y\":{\"type\":\"string\"}}");
+
+  aml_pool_destroy(p);
+}
+
+/* ---------- 3) required_dedup ---------- */
+MACRO_TEST(ajsb_index_required_dedup) {
+  aml_pool_t *p = aml_pool_init(4096);
+  ajsb_index_t *ix = ajsb_index_init(p);
+
+  ajson_t *o = ajsb_object(p);
+  ajsb_index_prop_required(ix, o, "a", ajsb_string(p));
+  ajsb_index_prop_required(ix, o, "a", ajsb_string(p));
+  ajsb_index_required_add(ix, o, "b");
+  ajsb_index_required_add(ix, o, "a");
+  MACRO_ASSERT_STREQ(J(p, ajsono_scan(o, "required")), "[\"a\",\"b\"]");
+
+  aml_pool_destroy(p);
+}
+
+/* ---------- 4) adopts_existing_members ---------- */
+MACRO_TEST(ajsb_index_adopts_existing_members) {
+  aml_pool_t *p = aml_pool_init(4096);
+  ajsb_index_t *ix = ajsb_index_init(p);
+
+  ajson_t *o = ajsb_object(p);
+  ajsb_prop_required(p, o, "a", ajsb_string(p));
+  ajsb_prop(p, o, "b", ajsb_string(p));
+  ajson_t *b = ajsb_index_get_prop(ix, o, "b");
+  MACRO_ASSERT_TRUE(b != NULL);
+
+  ajsb_index_prop_required(ix, o, "a", ajsb_integer(p));
+  ajsb_index_prop_required(ix, o, "c", ajsb_string(p));
+  MACRO_ASSERT_STREQ(J(p, o),
+    "{\"type\":\"object\",\"properties\":{\"a\":{\"type\":\"integer\"},"
+    "\"b\":{\"type\":\"string\"},\"c\":{\"type\":\"string\"}},\"required\":[\"a\",\"c\"]}");
+
+  aml_pool_destroy(p);
+}
+
+/* ---------- Runner ---------- */
+int main(void) {
+  macro_test_case tests[16];
+  size_t test_count = 0;
+
+  MACRO_ADD(tests, ajsb_index_matches_plain_builder);
+  MACRO_ADD(tests, ajsb_index_replace_keeps_position);
+  MACRO_ADD(tests, ajsb_index_required_dedup);
+  MACRO_ADD(tests, ajsb_index_adopts_existing_members);
+
+  macro_run_all("a-json-schema-builder/ajsb_index", tests, test_count);
+  return 0;
+}
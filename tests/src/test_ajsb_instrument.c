@@ -0,0 +1,237 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#include "a-json-schema-builder-library/ajsb.h"
+#include "a-json-schema-builder-library/ajsb_instrument.h"
+#include "a-json-schema-builder-library/ajsb_validate.h"
+#include "a-json-library/ajson.h"
+#include "a-memory-library/aml_buffer.h"
+#include "a-memory-library/aml_pool.h"
+#include "the-macro-library/macro_test.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+
+static ajson_t *P(aml_pool_t *p, const char *s) { return ajson_parse_string(p, aml_pool_strdup(p, s)); }
+
+static ajson_t *dump_of(aml_pool_t *p, const ajsb_profile_t *pr) {
+  aml_buffer_t *bh = aml_buffer_init(1024);
+  ajson_t *j = ajsb_profile_dump(bh, pr) ? P(p, aml_buffer_data(bh)) : NULL;
+  aml_buffer_destroy(bh);
+  return j;
+}
+
+static ajson_t *row_at(ajson_t *dump, const char *path) {
+  for (ajsona_t *a = ajsona_first(ajsono_scan(dump, "nodes")); a; a = ajsona_next(a))
+    if (!strcmp(ajson_to_str(ajsono_scan(a->value, "path"), ""), path)) return a->value;
+  return NULL;
+}
+
+static double field(ajson_t *row, const char *k) {
+  return row ? ajson_to_double(ajsono_scan(row, k), -1) : -1;
+}
+
+/* ---------- 1) profile ---------- */
+MACRO_TEST(ajsb_instrument_profile) {
+  aml_pool_t *p = aml_pool_init(4096);
+  ajson_t *s = P(p,
+    "{\"type\":\"object\",\"required\":[\"sku\"],"
+    "\"properties\":{"
+      "\"sku\":{\"type\":\"string\",\"pattern\":\"^[A-Z]{3}-[0-9]+$\"},"
+      "\"a/b\":{\"enum\":[1,2,3]},"
+      "\"v\":{\"anyOf\":[{\"$ref\":\"#/$defs/n\"},{\"$ref\":\"#/$defs/s\"},{\"type\":\"null\"}]}},"
+    "\"$defs\":{\"n\":{\"type\":\"number\"},\"s\":{\"type\":\"string\"}}}");
+  const ajsb_program_t *prog = ajsb_compile(p, s);
+  ajsb_profile_t *pr = ajsb_profile_init(prog, s);
+
+  if (!ajsb_instrumented()) {
+    /* compiled out: the API is there and does nothing */
+    aml_buffer_t *bh = aml_buffer_init(16);
+    MACRO_ASSERT_TRUE(pr == NULL);
+    MACRO_ASSERT_TRUE(!ajsb_profile_dump(bh, pr) && aml_buffer_length(bh) == 0);
+    MACRO_ASSERT_TRUE(!ajsb_build_stats_dump(bh) && aml_buffer_length(bh) == 0);
+    ajsb_profile_reset(pr);
+    ajsb_profile_destroy(pr);
+    aml_buffer_destroy(bh);
+    aml_pool_destroy(p);
+    return;
+  }
+  MACRO_ASSERT_TRUE(pr != NULL);
+
+  static const char *const instances[] = {
+    "{\"sku\":\"ABC-1\",\"v\":null}",          /* anyOf: two branches rejected */
+    "{\"sku\":\"ABC-12\",\"v\":\"x\"}",        /* one rejected */
+    "{\"sku\":\"abc\"}",                       /* pattern fails */
+    "{\"sku\":\"XYZ-9\",\"a/b\":4}",           /* enum fails */
+  };
+  for (size_t i = 0; i < 4; i++) ajsb_validate(prog, P(p, instances[i]));
+
+  ajson_t *d = dump_of(p, pr);
+  MACRO_ASSERT_TRUE(d && field(d, "validations") == 4);
+  ajson_t *root = row_at(d, "#");
+  MACRO_ASSERT_TRUE(field(root, "hits") == 4 && field(root, "failures") == 2);
+  MACRO_ASSERT_TRUE(field(root, "ns") >= field(root, "self_ns"));
+  ajson_t *sku = row_at(d, "#/properties/sku");
+  MACRO_ASSERT_TRUE(field(sku, "hits") == 4 && field(sku, "failures") == 1);
+  MACRO_ASSERT_TRUE(field(row_at(d, "#/properties/a~1b"), "failures") == 1);
+  ajson_t *v = row_at(d, "#/properties/v");
+  MACRO_ASSERT_TRUE(field(v, "hits") == 2 && field(v, "failures") == 0 && field(v, "backtracks") == 3);
+  MACRO_ASSERT_TRUE(field(row_at(d, "#/$defs/n"), "failures") == 2);
+  MACRO_ASSERT_TRUE(field(row_at(d, "#/properties/v/anyOf/2"), "hits") == 1);
+
+  /* hottest first */
+  double last = 1e300;
+  for (ajsona_t *a = ajsona_first(ajsono_scan(d, "nodes")); a; a = ajsona_next(a)) {
+    MACRO_ASSERT_TRUE(field(a->value, "self_ns") <= last);
+    last = field(a->value, "self_ns");
+  }
+
+  ajsb_profile_reset(pr);
+  d = dump_of(p, pr);
+  MACRO_ASSERT_TRUE(field(d, "validations") == 0 && ajsona_count(ajsono_scan(d, "nodes")) == 0);
+
+  /* without a schema nodes are reported by id */
+  ajsb_profile_destroy(pr);
+  pr = ajsb_profile_init(prog, NULL);
+  ajsb_validate(prog, P(p, instances[0]));
+  d = dump_of(p, pr);
+  MACRO_ASSERT_TRUE(field(d, "validations") == 1);
+  MACRO_ASSERT_TRUE(!ajsono_scan(ajsona_first(ajsono_scan(d, "nodes"))->value, "path"));
+  ajsb_profile_destroy(pr);
+
+  /* a different schema, or none attached, counts nothing */
+  MACRO_ASSERT_TRUE(ajsb_profile_init(prog, P(p, "{\"type\":\"string\"}")) == NULL);
+  ajsb_profile_t *many[9];
+  size_t n = 0;
+  while (n < 9 && (many[n] = ajsb_profile_init(prog, NULL)) != NULL) n++;
+  MACRO_ASSERT_TRUE(n == 8);
+  while (n) ajsb_profile_destroy(many[--n]);
+  MACRO_ASSERT_TRUE(ajsb_validate(prog, P(p, instances[0])));
+
+  aml_pool_destroy(p);
+}
+
+/* ---------- 2) build_stats ---------- */
+static void *builder_main(void *arg) {
+  (void)arg;
+  aml_pool_t *p = aml_pool_init(1024);
+  for (int i = 0; i < 25; i++) ajsb_string(p);
+  aml_pool_destroy(p);
+  return NULL;
+}
+
+static ajson_t *stat_of(aml_pool_t *p, const char *fn) {
+  aml_buffer_t *bh = aml_buffer_init(1024);
+  ajsb_build_stats_dump(bh);
+  ajson_t *d = P(p, aml_buffer_data(bh));
+  aml_buffer_destroy(bh);
+  for (ajsona_t *a = ajsona_first(ajsono_scan(d, "calls")); a; a = ajsona_next(a))
+    if (!strcmp(ajson_to_str(ajsono_scan(a->value, "fn"), ""), fn)) return a->value;
+  return NULL;
+}
+
+MACRO_TEST(ajsb_instrument_build_stats) {
+  if (!ajsb_instrumented()) return;
+  aml_pool_t *p = aml_pool_init(4096);
+  ajsb_build_stats_reset();
+
+  ajson_t *s = ajsb_object(p);
+  for (int i = 0; i < 10; i++) {
+    char name[16];
+    snprintf(name, sizeof(name), "f%d", i);
+    ajsb_prop_required(p, s, name, ajsb_string(p));
+  }
+  static const char *const states[] = {"a", "b", "c"};
+  ajson_t *e = ajsb_string(p);
+  ajsb_string_enum(p, e, 3, states);
+
+  aml_buffer_t *bh = aml_buffer_init(1024);
+  MACRO_ASSERT_TRUE(ajsb_build_stats_dump(bh));
+  ajson_t *d = P(p, aml_buffer_data(bh));
+  MACRO_ASSERT_TRUE(field(d, "peak_pool") > 0);
+  ajson_t *req = NULL, *str = NULL, *en = NULL;
+  for (ajsona_t *a = ajsona_first(ajsono_scan(d, "calls")); a; a = ajsona_next(a)) {
+    const char *fn = ajson_to_str(ajsono_scan(a->value, "fn"), "");
+    if (!strcmp(fn, "ajsb_prop_required")) req = a->value;
+    if (!strcmp(fn, "ajsb_string"))        str = a->value;
+    if (!strcmp(fn, "ajsb_string_enum"))   en = a->value;
+    MACRO_ASSERT_TRUE(strcmp(fn, "ajsb_prop"));        /* nested: counted in the caller */
+  }
+  MACRO_ASSERT_TRUE(field(req, "calls") == 10 && field(req, "nodes") >= 11 && field(req, "bytes") > 0);
+  MACRO_ASSERT_TRUE(field(str, "calls") == 11 && field(str, "nodes") == 11);
+  MACRO_ASSERT_TRUE(field(en, "calls") == 1 && field(en, "nodes") == 4);
+
+  /* other threads count on their own; the dump adds them in, also once
+     those threads have exited and their tables were handed on */
+  for (int wave = 0; wave < 2; wave++) {
+    pthread_t t[4];
+    for (int i = 0; i < 4; i++) pthread_create(t + i, NULL, builder_main, NULL);
+    for (int i = 0; i < 4; i++) pthread_join(t[i], NULL);
+  }
+  MACRO_ASSERT_TRUE(field(stat_of(p, "ajsb_string"), "calls") == 11 + 200);
+
+  ajsb_build_stats_reset();
+  aml_buffer_clear(bh);
+  ajsb_build_stats_dump(bh);
+  MACRO_ASSERT_TRUE(!strcmp(aml_buffer_data(bh), "{\"peak_pool\":0,\"calls\":[]}"));
+
+  aml_buffer_destroy(bh);
+  aml_pool_destroy(p);
+}
+
+/* ---------- 3) union_backtracks ---------- */
+MACRO_TEST(ajsb_instrument_union_backtracks) {
+  if (!ajsb_instrumented()) return;
+  aml_pool_t *p = aml_pool_init(4096);
+
+  /* a discriminated union goes straight to its branch */
+  aml_buffer_t *bh = aml_buffer_init(1024);
+  aml_buffer_appends(bh, "{\"oneOf\":[");
+  for (int i = 0; i < 40; i++)
+    aml_buffer_appendf(bh, "%s{\"type\":\"object\",\"required\":[\"kind\"],"
+                           "\"properties\":{\"kind\":{\"const\":\"k%d\"}}}", i ? "," : "", i);
+  aml_buffer_appends(bh, "]}");
+  ajson_t *s = P(p, aml_buffer_data(bh));
+  const ajsb_program_t *prog = ajsb_compile(p, s);
+  ajsb_profile_t *pr = ajsb_profile_init(prog, s);
+  MACRO_ASSERT_TRUE(ajsb_validate(prog, P(p, "{\"kind\":\"k39\"}")));
+  MACRO_ASSERT_TRUE(!ajsb_validate(prog, P(p, "{\"kind\":\"k40\"}")));
+  ajson_t *root = row_at(dump_of(p, pr), "#");
+  MACRO_ASSERT_TRUE(field(root, "hits") == 2 && field(root, "backtracks") == 0);
+  MACRO_ASSERT_TRUE(field(row_at(dump_of(p, pr), "#/oneOf/39"), "hits") == 1);
+  ajsb_profile_destroy(pr);
+
+  /* otherwise anyOf learns which branch matches */
+  s = P(p, "{\"anyOf\":[{\"type\":\"string\"},{\"type\":\"null\"},{\"type\":\"array\"},"
+           "{\"type\":\"boolean\"},{\"type\":\"integer\"}]}");
+  prog = ajsb_compile(p, s);
+  pr = ajsb_profile_init(prog, s);
+  for (int i = 0; i < 200; i++) ajsb_validate(prog, P(p, "5"));
+  ajsb_profile_reset(pr);
+  for (int i = 0; i < 10; i++) MACRO_ASSERT_TRUE(ajsb_validate(prog, P(p, "5")));
+  MACRO_ASSERT_TRUE(field(row_at(dump_of(p, pr), "#"), "backtracks") == 0);
+  MACRO_ASSERT_TRUE(ajsb_validate(prog, P(p, "\"s\"")));
+  MACRO_ASSERT_TRUE(field(row_at(dump_of(p, pr), "#"), "backtracks") == 1);
+  ajsb_profile_destroy(pr);
+
+  aml_buffer_destroy(bh);
+  aml_pool_destroy(p);
+}
+
+/* ---------- Runner ---------- */
+int main(void) {
+  macro_test_case tests[16];
+  size_t test_count = 0;
+
+  MACRO_ADD(tests, ajsb_instrument_profile);
+  MACRO_ADD(tests, ajsb_instrument_build_stats);
+  MACRO_ADD(tests, ajsb_instrument_union_backtracks);
+
+  macro_run_all("a-json-schema-builder/ajsb_instrument", tests, test_count);
+  return 0;
+}
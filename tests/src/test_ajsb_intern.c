@@ -0,0 +1,201 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#include "a-json-schema-builder-library/ajsb.h"
+#include "a-json-schema-builder-library/ajsb_intern.h"
+#include "a-json-schema-builder-library/ajsb_link.h"
+#include "a-json-schema-builder-library/ajsb_validate.h"
+#include "a-json-library/ajson.h"
+#include "a-memory-library/aml_pool.h"
+#include "the-macro-library/macro_test.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+
+/* Small helpers */
+static const char *J(aml_pool_t *p, ajson_t *j) { return ajson_stringify(p, j); }
+
+static size_t occurrences(const char *hay, const char *needle) {
+  size_t n = 0;
+  for (const char *s = strstr(hay, needle); s; s = strstr(s + 1, needle)) n++;
+  return n;
+}
+
+static ajson_t *date(aml_pool_t *p) {
+  ajson_t *d = ajsb_string(p);
+  ajsb_string_format(p, d, "date");
+  return d;
+}
+
+static ajson_t *address(aml_pool_t *p) {
+  ajson_t *a = ajsb_object(p);
+  ajsb_prop_required(p, a, "street", ajsb_string(p));
+  ajsb_prop_required(p, a, "city",   ajsb_string(p));
+  ajsb_prop(p, a, "since", date(p));
+  ajsb_prop(p, a, "until", date(p));
+  ajsb_additional_properties(p, a, false);
+  return a;
+}
+
+static ajson_t *customer(aml_pool_t *p) {
+  ajson_t *root = ajsb_object(p);
+  ajsb_prop_required(p, root, "home", address(p));
+  ajsb_prop(p, root, "work", address(p));
+  ajson_t *list = ajsb_array(p, address(p));
+  ajsb_prop(p, root, "previous", list);
+  ajsb_prop(p, root, "born", date(p));
+  return root;
+}
+
+/* ---------- 1) structural_hash ---------- */
+MACRO_TEST(ajsb_intern_structural_hash) {
+  aml_pool_t *p = aml_pool_init(4096);
+
+  MACRO_ASSERT_TRUE(ajsb_schema_hash(address(p)) == ajsb_schema_hash(address(p)));
+  MACRO_ASSERT_TRUE(ajsb_schema_equal(address(p), address(p)));
+  MACRO_ASSERT_TRUE(ajsb_schema_equal(customer(p), customer(p)));
+
+  ajson_t *a = address(p), *b = address(p);
+  ajsb_description(p, b, "mailing");
+  MACRO_ASSERT_TRUE(ajsb_schema_hash(a) != ajsb_schema_hash(b));
+  MACRO_ASSERT_TRUE(!ajsb_schema_equal(a, b));
+  MACRO_ASSERT_TRUE(ajsb_schema_hash(ajsb_string(p)) != ajsb_schema_hash(ajsb_number(p)));
+
+  aml_pool_destroy(p);
+}
+
+/* ---------- 2) intern_shares_subtrees ---------- */
+MACRO_TEST(ajsb_intern_shares_subtrees) {
+  aml_pool_t *p = aml_pool_init(4096);
+  ajsb_intern_t *in = ajsb_intern_init();
+
+  ajson_t *root = customer(p);
+  const char *before = J(p, root);
+  MACRO_ASSERT_TRUE(ajsb_intern(in, root) == root);
+  MACRO_ASSERT_STREQ(J(p, root), before);
+
+  ajson_t *props = ajsono_scan(root, "properties");
+  ajson_t *home = ajsono_scan(props, "home");
+  MACRO_ASSERT_TRUE(home == ajsono_scan(props, "work"));
+  MACRO_ASSERT_TRUE(home == ajsono_scan(ajsono_scan(props, "previous"), "items"));
+  ajson_t *hp = ajsono_scan(home, "properties");
+  MACRO_ASSERT_TRUE(ajsono_scan(hp, "since") == ajsono_scan(props, "born"));
+  MACRO_ASSERT_TRUE(ajsb_intern_shared(in) > 0);
+  MACRO_ASSERT_TRUE(ajsono_scan(hp, "street") == ajsb_shared_string());   /* leaves collapse */
+
+  /* a second tree reuses the canonical nodes */
+  size_t distinct = ajsb_intern_count(in);
+  ajson_t *again = ajsb_intern(in, customer(p));
+  MACRO_ASSERT_TRUE(again == root);
+  MACRO_ASSERT_TRUE(ajsb_intern_count(in) == distinct);
+
+  /* shared nodes still compile and validate */
+  ajsb_program_t *prog = ajsb_compile(p, root);
+  const char *doc = "{\"home\":{\"street\":\"a\",\"city\":\"b\",\"since\":\"2020-01-01\"},"
+                    "\"previous\":[{\"street\":\"c\",\"city\":\"d\"}]}";
+  MACRO_ASSERT_TRUE(ajsb_validate(prog, ajson_parse_string(p, aml_pool_strdup(p, doc))));
+
+  ajsb_intern_destroy(in);
+  aml_pool_destroy(p);
+}
+
+/* ---------- 3) hoist_defs ---------- */
+MACRO_TEST(ajsb_intern_hoist_defs) {
+  aml_pool_t *p = aml_pool_init(4096);
+
+  ajson_t *root = customer(p);
+  size_t before = strlen(J(p, root));
+  MACRO_ASSERT_TRUE(ajsb_hoist_defs(p, root, 2) == 3);
+
+  const char *out = J(p, root);
+  MACRO_ASSERT_TRUE(strlen(out) < before);
+  MACRO_ASSERT_TRUE(occurrences(out, "{\"$ref\":\"#/$defs/home\"}") == 3);
+  MACRO_ASSERT_TRUE(occurrences(out, "\"street\"") == 2);          /* properties + required */
+  MACRO_ASSERT_TRUE(occurrences(out, "\"format\":\"date\"") == 3); /* too small to move */
+
+  ajsb_program_t *prog = ajsb_compile(p, root);
+  MACRO_ASSERT_TRUE(prog != NULL);
+  const char *ok  = "{\"home\":{\"street\":\"a\",\"city\":\"b\"},\"work\":{\"street\":\"c\",\"city\":\"d\"}}";
+  const char *bad = "{\"home\":{\"street\":\"a\",\"city\":\"b\"},\"work\":{\"street\":\"c\"}}";
+  MACRO_ASSERT_TRUE(ajsb_validate(prog, ajson_parse_string(p, aml_pool_strdup(p, ok))));
+  MACRO_ASSERT_TRUE(!ajsb_validate(prog, ajson_parse_string(p, aml_pool_strdup(p, bad))));
+
+  /* nothing left worth moving */
+  MACRO_ASSERT_TRUE(ajsb_hoist_defs(p, root, 2) == 0);
+
+  aml_pool_destroy(p);
+}
+
+/* ---------- 4) hoist_reuses_and_skips ---------- */
+MACRO_TEST(ajsb_intern_hoist_reuses_and_skips) {
+  aml_pool_t *p = aml_pool_init(4096);
+
+  /* an existing definition is referenced even for a single occurrence */
+  ajson_t *root = ajsb_object(p);
+  ajsb_defs_set(p, root, "addr", address(p));
+  ajsb_prop(p, root, "home", address(p));
+  MACRO_ASSERT_TRUE(ajsb_hoist_defs(p, root, 2) == 1);
+  MACRO_ASSERT_TRUE(strstr(J(p, root), "\"home\":{\"$ref\":\"#/$defs/addr\"}") != NULL);
+
+  /* anchored subschemas stay where they are */
+  ajson_t *anchored = ajsb_object(p);
+  for (int i = 0; i < 4; i++) {
+    char name[16];
+    sprintf(name, "n%d", i);
+    ajson_t *a = address(p);
+    ajsb_anchor(p, a, "Addr");
+    ajsb_prop(p, anchored, name, a);
+  }
+  ajsb_hoist_defs(p, anchored, 2);
+  MACRO_ASSERT_TRUE(occurrences(J(p, anchored), "\"$anchor\":\"Addr\"") == 4);
+
+  /* whole subschemas move; enum data inside them is never a candidate */
+  ajson_t *e = ajsb_object(p);
+  ajson_t *c1 = ajsb_string(p), *c2 = ajsb_string(p);
+  const char *vals[] = {"aaaaaaaaaaaaaaaaaaaa", "bbbbbbbbbbbbbbbbbbbbbbbb", "cccccccccccccccccccccc"};
+  ajsb_string_enum(p, c1, 3, vals);
+  ajsb_string_enum(p, c2, 3, vals);
+  ajsb_prop(p, e, "x", c1);
+  ajsb_prop(p, e, "y", c2);
+  MACRO_ASSERT_TRUE(ajsb_hoist_defs(p, e, 2) == 2);
+  MACRO_ASSERT_TRUE(occurrences(J(p, e), "\"enum\"") == 1);
+
+  /* what existing references point at, or into, stays where it is */
+  ajson_t *r = customer(p);
+  ajsb_prop(p, r, "same", ajsb_ref(p, "#/properties/home"));
+  ajsb_prop(p, r, "street", ajsb_ref(p, "#/properties/work/properties/street"));
+  ajsb_prop(p, r, "other", address(p));
+  MACRO_ASSERT_TRUE(ajsb_hoist_defs(p, r, 2) > 0);
+  const char *out = J(p, r);
+  MACRO_ASSERT_TRUE(strstr(out, "\"home\":{\"type\":\"object\"") && strstr(out, "\"work\":{\"type\":\"object\""));
+  MACRO_ASSERT_TRUE(strstr(out, "\"items\":{\"$ref\":\"#/$defs/") && strstr(out, "\"other\":{\"$ref\":\"#/$defs/"));
+  MACRO_ASSERT_TRUE(ajsb_link_ok(ajsb_link(p, r)));
+
+  /* existing names are escaped in the reference */
+  ajson_t *odd = ajsb_object(p);
+  ajsb_defs_set(p, odd, "a/b~c%", address(p));
+  ajsb_prop(p, odd, "home", address(p));
+  MACRO_ASSERT_TRUE(ajsb_hoist_defs(p, odd, 2) == 1);
+  MACRO_ASSERT_TRUE(strstr(J(p, odd), "\"home\":{\"$ref\":\"#/$defs/a~1b~0c%25\"}") != NULL);
+  MACRO_ASSERT_TRUE(ajsb_link_ok(ajsb_link(p, odd)));
+
+  aml_pool_destroy(p);
+}
+
+/* ---------- Runner ---------- */
+int main(void) {
+  macro_test_case tests[16];
+  size_t test_count = 0;
+
+  MACRO_ADD(tests, ajsb_intern_structural_hash);
+  MACRO_ADD(tests, ajsb_intern_shares_subtrees);
+  MACRO_ADD(tests, ajsb_intern_hoist_defs);
+  MACRO_ADD(tests, ajsb_intern_hoist_reuses_and_skips);
+
+  macro_run_all("a-json-schema-builder/ajsb_intern", tests, test_count);
+  return 0;
+}
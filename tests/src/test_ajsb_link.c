@@ -0,0 +1,202 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#include "a-json-schema-builder-library/ajsb.h"
+#include "a-json-schema-builder-library/ajsb_link.h"
+#include "a-json-schema-builder-library/ajsb_validate.h"
+#include "a-json-library/ajson.h"
+#include "a-memory-library/aml_pool.h"
+#include "the-macro-library/macro_test.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+
+/* Small helpers */
+static const char *J(aml_pool_t *p, ajson_t *j) { return ajson_stringify(p, j); }
+static ajson_t *P(aml_pool_t *p, const char *s) { return ajson_parse_string(p, aml_pool_strdup(p, s)); }
+
+/* ---------- 1) recursive_tree ---------- */
+MACRO_TEST(ajsb_link_recursive_tree) {
+  aml_pool_t *p = aml_pool_init(4096);
+
+  ajson_t *node = ajsb_object(p);
+  ajsb_prop_required(p, node, "label", ajsb_string(p));
+  ajson_t *child = ajsb_ref(p, "#/$defs/node");
+  ajsb_prop(p, node, "children", ajsb_array(p, child));
+  ajson_t *root = ajsb_object(p);
+  ajsb_defs_add(p, root, "node", node);
+  ajson_t *top = ajsb_ref(p, "#/$defs/node");
+  ajsb_prop(p, root, "root", top);
+  const char *before = J(p, root);
+
+  ajsb_link_t *l = ajsb_link(p, root);
+  MACRO_ASSERT_TRUE(ajsb_link_ok(l));
+  MACRO_ASSERT_TRUE(ajsb_link_ref(l, child) == node);
+  MACRO_ASSERT_TRUE(ajsb_link_ref(l, top) == node);
+  MACRO_ASSERT_TRUE(ajsb_link_ref(l, node) == NULL);
+  MACRO_ASSERT_TRUE(!ajsb_link_cyclic(l, child));     /* descends through items */
+  MACRO_ASSERT_STREQ(J(p, root), before);             /* text unchanged */
+
+  ajsb_program_t *prog = ajsb_compile(p, root);
+  MACRO_ASSERT_TRUE(prog != NULL);
+  MACRO_ASSERT_TRUE(ajsb_validate(prog, P(p, "{\"root\":{\"label\":\"a\",\"children\":[{\"label\":\"b\"}]}}")));
+  MACRO_ASSERT_TRUE(!ajsb_validate(prog, P(p, "{\"root\":{\"label\":\"a\",\"children\":[{}]}}")));
+
+  aml_pool_destroy(p);
+}
+
+/* ---------- 2) ids_and_anchors ---------- */
+MACRO_TEST(ajsb_link_ids_and_anchors) {
+  aml_pool_t *p = aml_pool_init(4096);
+
+  ajson_t *root = P(p,
+    "{\"$id\":\"https://example.com/schemas/order\","
+    " \"properties\":{"
+    "   \"ship\":{\"$ref\":\"address#/properties/zip\"},"
+    "   \"bill\":{\"$ref\":\"https://example.com/schemas/address\"},"
+    "   \"id\":{\"$ref\":\"#uuid\"},"
+    "   \"a/b\":{\"$ref\":\"#/properties/a~1b/$defs/x%25\"},"
+    "   \"up\":{\"$ref\":\"./sub/../address#street\"}},"
+    " \"$defs\":{"
+    "   \"uuid\":{\"$anchor\":\"uuid\",\"type\":\"string\"},"
+    "   \"address\":{\"$id\":\"address\","
+    "     \"properties\":{\"zip\":{\"type\":\"string\"},"
+    "                     \"street\":{\"$anchor\":\"street\",\"type\":\"string\"}},"
+    "     \"$defs\":{\"back\":{\"$ref\":\"order#uuid\"}}}}}");
+  ajson_t *props = ajsono_scan(root, "properties");
+  ajson_t *defs = ajsono_scan(root, "$defs");
+  ajson_t *address = ajsono_scan(defs, "address");
+  ajson_t *street = ajsono_scan(ajsono_scan(address, "properties"), "street");
+  ajsono_set(ajsono_scan(props, "a/b"), "$defs", P(p, "{\"x%\":{\"type\":\"null\"}}"), false);
+
+  ajsb_link_t *l = ajsb_link(p, root);
+  MACRO_ASSERT_TRUE(ajsb_link_ok(l));
+  MACRO_ASSERT_TRUE(ajsb_link_resource(l, "https://example.com/schemas/order") == root);
+  MACRO_ASSERT_TRUE(ajsb_link_resource(l, "https://example.com/schemas/address") == address);
+  MACRO_ASSERT_TRUE(ajsb_link_resource(l, "") == root);
+  MACRO_ASSERT_TRUE(ajsb_link_ref(l, ajsono_scan(props, "ship")) ==
+                    ajsono_scan(ajsono_scan(address, "properties"), "zip"));
+  MACRO_ASSERT_TRUE(ajsb_link_ref(l, ajsono_scan(props, "bill")) == address);
+  MACRO_ASSERT_TRUE(ajsb_link_ref(l, ajsono_scan(props, "id")) == ajsono_scan(defs, "uuid"));
+  MACRO_ASSERT_TRUE(ajsb_link_ref(l, ajsono_scan(props, "up")) == street);
+  MACRO_ASSERT_TRUE(ajsb_link_ref(l, ajsono_scan(ajsono_scan(address, "$defs"), "back")) ==
+                    ajsono_scan(defs, "uuid"));
+  ajson_t *ab = ajsono_scan(props, "a/b");
+  MACRO_ASSERT_TRUE(ajsb_link_ref(l, ab) == ajsono_scan(ajsono_scan(ab, "$defs"), "x%"));
+
+  /* anchors are scoped to their resource */
+  ajson_t *wrong = P(p, "{\"$defs\":{\"a\":{\"$id\":\"a.json\",\"$anchor\":\"in_a\"}},"
+                        " \"$ref\":\"#in_a\"}");
+  MACRO_ASSERT_TRUE(ajsb_link_ref(ajsb_link(p, wrong), wrong) == NULL);
+
+  aml_pool_destroy(p);
+}
+
+/* ---------- 3) dynamic_anchors ---------- */
+MACRO_TEST(ajsb_link_dynamic_anchors) {
+  aml_pool_t *p = aml_pool_init(4096);
+
+  /* a generic tree whose node type is extended by the outer resource */
+  ajson_t *root = P(p,
+    "{\"$id\":\"https://example.com/strict-tree\",\"$dynamicAnchor\":\"node\","
+    " \"$ref\":\"tree\",\"unevaluatedProperties\":false,"
+    " \"$defs\":{\"tree\":{\"$id\":\"tree\",\"$dynamicAnchor\":\"node\",\"type\":\"object\","
+    "   \"properties\":{\"data\":true,"
+    "     \"children\":{\"type\":\"array\",\"items\":{\"$dynamicRef\":\"#node\"}}}},"
+    "   \"plain\":{\"$id\":\"plain\",\"$anchor\":\"node\","
+    "     \"items\":{\"$dynamicRef\":\"#node\"}}}}");
+  ajson_t *defs = ajsono_scan(root, "$defs");
+  ajson_t *tree = ajsono_scan(defs, "tree");
+  ajson_t *plain = ajsono_scan(defs, "plain");
+  ajson_t *items = ajsono_scan(ajsono_scan(ajsono_scan(tree, "properties"), "children"), "items");
+
+  ajsb_link_t *l = ajsb_link(p, root);
+  MACRO_ASSERT_TRUE(ajsb_link_ok(l));
+  MACRO_ASSERT_TRUE(ajsb_link_ref(l, root) == tree);
+  MACRO_ASSERT_TRUE(ajsb_link_dynamic_ref(l, items) == root);      /* outermost in scope */
+  MACRO_ASSERT_TRUE(ajsb_link_ref(l, items) == NULL);
+
+  const ajson_t *only_tree[] = { tree };
+  const ajson_t *both[] = { root, tree };
+  MACRO_ASSERT_TRUE(ajsb_link_dynamic_scope(l, items, only_tree, 1) == tree);
+  MACRO_ASSERT_TRUE(ajsb_link_dynamic_scope(l, items, both, 2) == root);
+
+  /* a plain $anchor target makes $dynamicRef behave like $ref */
+  ajson_t *pitems = ajsono_scan(plain, "items");
+  MACRO_ASSERT_TRUE(ajsb_link_dynamic_ref(l, pitems) == plain);
+  MACRO_ASSERT_TRUE(ajsb_link_dynamic_scope(l, pitems, both, 2) == plain);
+
+  aml_pool_destroy(p);
+}
+
+/* ---------- 4) problems ---------- */
+MACRO_TEST(ajsb_link_problems) {
+  aml_pool_t *p = aml_pool_init(4096);
+  const ajsb_link_issue_t *is;
+
+  ajson_t *root = ajsb_object(p);
+  ajsb_prop(p, root, "a", ajsb_ref(p, "#/$defs/missing"));
+  ajsb_prop(p, root, "b", ajsb_ref(p, "https://elsewhere.example/x"));
+  ajsb_prop(p, root, "c", ajsb_ref(p, "#nowhere"));
+  ajsb_prop(p, root, "d", ajsb_ref(p, "#/properties/a"));
+  ajsb_link_t *l = ajsb_link(p, root);
+  MACRO_ASSERT_TRUE(!ajsb_link_ok(l));
+  MACRO_ASSERT_TRUE(ajsb_link_unresolved(l, &is) == 3);
+  MACRO_ASSERT_STREQ(is[0].path, "/properties/a");
+  MACRO_ASSERT_STREQ(is[0].ref, "#/$defs/missing");
+  MACRO_ASSERT_STREQ(is[2].ref, "#nowhere");
+  MACRO_ASSERT_TRUE(ajsb_link_cycles(l, &is) == 0);
+  MACRO_ASSERT_TRUE(ajsb_compile(p, root) == NULL);
+
+  /* loops that never descend */
+  ajson_t *self = P(p, "{\"$ref\":\"#\"}");
+  l = ajsb_link(p, self);
+  MACRO_ASSERT_TRUE(ajsb_link_cycles(l, &is) == 1);
+  MACRO_ASSERT_STREQ(is[0].path, "");
+  MACRO_ASSERT_TRUE(ajsb_compile(p, self) == NULL);
+
+  ajson_t *pair = P(p, "{\"$defs\":{\"a\":{\"$ref\":\"#/$defs/b\"},"
+                       "\"b\":{\"anyOf\":[{\"type\":\"null\"},{\"$ref\":\"#/$defs/a\"}]}},"
+                       " \"properties\":{\"x\":{\"$ref\":\"#/$defs/a\"}}}");
+  l = ajsb_link(p, pair);
+  MACRO_ASSERT_TRUE(ajsb_link_unresolved(l, NULL) == 0);
+  MACRO_ASSERT_TRUE(ajsb_link_cycles(l, &is) == 1);
+  MACRO_ASSERT_TRUE(!strncmp(is[0].path, "/$defs/", 7));
+  MACRO_ASSERT_TRUE(ajsb_compile(p, pair) == NULL);
+
+  /* the same shape through items is ordinary recursion */
+  ajson_t *list = P(p, "{\"$defs\":{\"a\":{\"$ref\":\"#/$defs/b\"},"
+                       "\"b\":{\"anyOf\":[{\"type\":\"null\"},{\"type\":\"array\",\"items\":{\"$ref\":\"#/$defs/a\"}}]}},"
+                       " \"properties\":{\"x\":{\"$ref\":\"#/$defs/a\"}}}");
+  l = ajsb_link(p, list);
+  MACRO_ASSERT_TRUE(ajsb_link_ok(l));
+  ajsb_program_t *prog = ajsb_compile(p, list);
+  MACRO_ASSERT_TRUE(prog != NULL);
+  MACRO_ASSERT_TRUE(ajsb_validate(prog, P(p, "{\"x\":[[null],[]]}")));
+  MACRO_ASSERT_TRUE(!ajsb_validate(prog, P(p, "{\"x\":[1]}")));
+
+  /* refs inside instance data are not references */
+  ajson_t *data = P(p, "{\"const\":{\"$ref\":\"#/nope\"},\"default\":{\"$id\":\"x\"}}");
+  MACRO_ASSERT_TRUE(ajsb_link_ok(ajsb_link(p, data)));
+  MACRO_ASSERT_TRUE(ajsb_link_resource(ajsb_link(p, data), "x") == NULL);
+
+  aml_pool_destroy(p);
+}
+
+/* ---------- Runner ---------- */
+int main(void) {
+  macro_test_case tests[16];
+  size_t test_count = 0;
+
+  MACRO_ADD(tests, ajsb_link_recursive_tree);
+  MACRO_ADD(tests, ajsb_link_ids_and_anchors);
+  MACRO_ADD(tests, ajsb_link_dynamic_anchors);
+  MACRO_ADD(tests, ajsb_link_problems);
+
+  macro_run_all("a-json-schema-builder/ajsb_link", tests, test_count);
+  return 0;
+}
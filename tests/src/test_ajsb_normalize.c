@@ -0,0 +1,153 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#include "a-json-schema-builder-library/ajsb_normalize.h"
+#include "a-json-schema-builder-library/ajsb_validate.h"
+#include "a-json-library/ajson.h"
+#include "a-memory-library/aml_pool.h"
+#include "the-macro-library/macro_test.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+
+static ajson_t *P(aml_pool_t *p, const char *s) { return ajson_parse_string(p, aml_pool_strdup(p, s)); }
+
+/* Both schemas accept exactly the same documents among docs. */
+static bool same_verdicts(aml_pool_t *p, ajson_t *a, ajson_t *b, const char *const *docs, size_t n) {
+  ajsb_program_t *pa = ajsb_compile(p, a), *pb = ajsb_compile(p, b);
+  if (!pa || !pb) return false;
+  bool ok = true;
+  for (size_t i = 0; i < n; i++) {
+    bool va = ajsb_validate(pa, P(p, docs[i])), vb = ajsb_validate(pb, P(p, docs[i]));
+    if (va != vb) {
+      fprintf(stderr, "%s: %d before, %d after\n", docs[i], va, vb);
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+/* ---------- 1) allof_merge ---------- */
+MACRO_TEST(ajsb_normalize_allof_merge) {
+  aml_pool_t *p = aml_pool_init(8192);
+  static const char *const text =
+    "{\"allOf\":[{\"allOf\":["
+      "{\"type\":\"object\",\"properties\":{\"a\":{\"type\":\"string\"}},\"required\":[\"a\"]},"
+      "{\"properties\":{\"b\":{\"type\":\"integer\"}},\"required\":[\"a\",\"b\"]}]},"
+    "true,{}]}";
+  ajson_t *s = P(p, text);
+  ajsb_normalize_stats_t st;
+  ajson_t *n = ajsb_normalize(p, s, &st);
+  const char *out = ajson_stringify(p, n);
+  MACRO_ASSERT_TRUE(!strcmp(out, "{\"type\":\"object\",\"properties\":{\"a\":{\"type\":\"string\"},"
+                                 "\"b\":{\"type\":\"integer\"}},\"required\":[\"a\",\"b\"]}"));
+  MACRO_ASSERT_TRUE(!strcmp(ajson_stringify(p, s), ajson_stringify(p, P(p, text))));   /* input untouched */
+  MACRO_ASSERT_TRUE(st.nodes_after < st.nodes_before && st.bytes_after < st.bytes_before);
+  MACRO_ASSERT_TRUE(st.bytes_after == strlen(out));
+
+  /* conflicting members stay in the allOf */
+  ajson_t *c = P(p, "{\"properties\":{\"y\":{}},\"allOf\":["
+                    "{\"properties\":{\"x\":{}},\"additionalProperties\":false},"
+                    "{\"type\":\"object\"},{\"type\":\"object\"},{\"$id\":\"urn:x\",\"minProperties\":1}]}");
+  n = ajsb_normalize(p, c, NULL);
+  MACRO_ASSERT_TRUE(!strcmp(ajson_stringify(p, n),
+                            "{\"properties\":{\"y\":{}},\"allOf\":[{\"properties\":{\"x\":{}},"
+                            "\"additionalProperties\":false},{\"$id\":\"urn:x\",\"minProperties\":1}],"
+                            "\"type\":\"object\"}"));
+  static const char *const docs[] = {"{}", "{\"x\":1}", "{\"y\":1}", "{\"x\":1,\"y\":2}", "[]", "3"};
+  MACRO_ASSERT_TRUE(same_verdicts(p, c, n, docs, sizeof(docs) / sizeof(docs[0])));
+
+  /* nothing to do: the schema itself comes back */
+  ajson_t *plain = P(p, "{\"type\":\"string\",\"minLength\":2}");
+  MACRO_ASSERT_TRUE(ajsb_normalize(p, plain, &st) == plain);
+  MACRO_ASSERT_TRUE(st.nodes_after == st.nodes_before && st.bytes_after == st.bytes_before);
+  aml_pool_destroy(p);
+}
+
+/* ---------- 2) branches_and_repeats ---------- */
+MACRO_TEST(ajsb_normalize_branches) {
+  aml_pool_t *p = aml_pool_init(8192);
+  ajson_t *s = P(p,
+    "{\"type\":\"object\",\"properties\":{"
+      "\"tag\":{\"anyOf\":[{\"type\":\"string\"},{\"type\":\"null\"},{\"type\":\"null\"}]},"
+      "\"n\":{\"oneOf\":[{\"type\":\"integer\",\"minimum\":0}]},"
+      "\"e\":{\"enum\":[1,1.0,\"a\",\"a\",null,{\"k\":1},{\"k\":1}]},"
+      "\"any\":{\"anyOf\":[{\"type\":\"string\"},true]},"
+      "\"nested\":{\"anyOf\":[{\"anyOf\":[{\"type\":\"string\"}]},{\"type\":\"null\"}]}},"
+    "\"required\":[\"tag\",\"n\",\"tag\"]}");
+  ajson_t *n = ajsb_normalize(p, s, NULL);
+  const char *out = ajson_stringify(p, n);
+  MACRO_ASSERT_TRUE(strstr(out, "\"tag\":{\"anyOf\":[{\"type\":\"string\"},{\"type\":\"null\"}]}") != NULL);
+  MACRO_ASSERT_TRUE(strstr(out, "\"n\":{\"type\":\"integer\",\"minimum\":0}") != NULL);
+  MACRO_ASSERT_TRUE(strstr(out, "\"e\":{\"enum\":[1,\"a\",null,{\"k\":1}]}") != NULL);
+  MACRO_ASSERT_TRUE(strstr(out, "\"any\":{}") != NULL);
+  MACRO_ASSERT_TRUE(strstr(out, "\"nested\":{\"anyOf\":[{\"type\":\"string\"},{\"type\":\"null\"}]}") != NULL);
+  MACRO_ASSERT_TRUE(strstr(out, "\"required\":[\"tag\",\"n\"]") != NULL);
+
+  static const char *const docs[] = {
+    "{\"tag\":\"x\",\"n\":1}",
+    "{\"tag\":null,\"n\":0}",
+    "{\"tag\":3,\"n\":0}",
+    "{\"tag\":\"x\",\"n\":-1}",
+    "{\"tag\":\"x\"}",
+    "{\"tag\":\"x\",\"n\":1,\"e\":1.0}",
+    "{\"tag\":\"x\",\"n\":1,\"e\":{\"k\":1}}",
+    "{\"tag\":\"x\",\"n\":1,\"e\":2}",
+    "{\"tag\":\"x\",\"n\":1,\"any\":[1]}",
+    "{\"tag\":\"x\",\"n\":1,\"nested\":false}",
+  };
+  MACRO_ASSERT_TRUE(same_verdicts(p, s, n, docs, sizeof(docs) / sizeof(docs[0])));
+  aml_pool_destroy(p);
+}
+
+/* ---------- 3) defs_tree_shaking ---------- */
+MACRO_TEST(ajsb_normalize_defs) {
+  aml_pool_t *p = aml_pool_init(8192);
+  ajson_t *s = P(p,
+    "{\"$defs\":{"
+      "\"used\":{\"type\":\"string\"},"
+      "\"chain\":{\"$ref\":\"#/$defs/used\"},"
+      "\"unused\":{\"type\":\"number\"},"
+      "\"self\":{\"$ref\":\"#/$defs/self\"},"
+      "\"ptr\":{\"allOf\":[{\"minLength\":1},{\"maxLength\":5}]}},"
+    "\"properties\":{\"a\":{\"$ref\":\"#/$defs/chain\"},\"b\":{\"$ref\":\"#/$defs/ptr/allOf/1\"}}}");
+  ajsb_normalize_stats_t st;
+  ajson_t *n = ajsb_normalize(p, s, &st);
+  const char *out = ajson_stringify(p, n);
+  MACRO_ASSERT_TRUE(strstr(out, "\"used\"") && strstr(out, "\"chain\"") && strstr(out, "\"ptr\""));
+  MACRO_ASSERT_TRUE(!strstr(out, "\"unused\"") && !strstr(out, "\"self\""));
+  /* a reference points into this allOf, so it keeps its shape */
+  MACRO_ASSERT_TRUE(strstr(out, "\"ptr\":{\"allOf\":[{\"minLength\":1},{\"maxLength\":5}]}") != NULL);
+  MACRO_ASSERT_TRUE(st.bytes_after < st.bytes_before);
+
+  static const char *const docs[] = {
+    "{\"a\":\"x\"}", "{\"a\":1}", "{\"b\":\"abcdef\"}", "{\"b\":\"\"}", "{\"b\":7}",
+  };
+  MACRO_ASSERT_TRUE(same_verdicts(p, s, n, docs, sizeof(docs) / sizeof(docs[0])));
+
+  /* nothing references them: $defs goes away */
+  n = ajsb_normalize(p, P(p, "{\"$defs\":{\"x\":{}},\"type\":\"integer\"}"), NULL);
+  MACRO_ASSERT_TRUE(!strcmp(ajson_stringify(p, n), "{\"type\":\"integer\"}"));
+
+  /* an unresolved reference keeps every entry */
+  n = ajsb_normalize(p, P(p, "{\"$defs\":{\"x\":{}},\"$ref\":\"other.json#/$defs/y\"}"), NULL);
+  MACRO_ASSERT_TRUE(strstr(ajson_stringify(p, n), "\"x\"") != NULL);
+  aml_pool_destroy(p);
+}
+
+/* ---------- Runner ---------- */
+int main(void) {
+  macro_test_case tests[16];
+  size_t test_count = 0;
+
+  MACRO_ADD(tests, ajsb_normalize_allof_merge);
+  MACRO_ADD(tests, ajsb_normalize_branches);
+  MACRO_ADD(tests, ajsb_normalize_defs);
+
+  macro_run_all("a-json-schema-builder/ajsb_normalize", tests, test_count);
+  return 0;
+}
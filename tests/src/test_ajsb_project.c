@@ -0,0 +1,227 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#include "a-json-schema-builder-library/ajsb.h"
+#include "a-json-schema-builder-library/ajsb_project.h"
+#include "a-json-schema-builder-library/ajsb_validate.h"
+#include "a-json-library/ajson.h"
+#include "a-memory-library/aml_buffer.h"
+#include "a-memory-library/aml_pool.h"
+#include "the-macro-library/macro_test.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+
+static ajsb_project_status_t V(const ajsb_projection_t *pr, aml_pool_t *p, const char *text) {
+  return ajsb_project_validate(pr, p, text, strlen(text), NULL);
+}
+#define OK(pr, p, text)     MACRO_ASSERT_TRUE(V((pr), (p), (text)) == AJSB_PROJECT_OK)
+#define BAD(pr, p, text)    MACRO_ASSERT_TRUE(V((pr), (p), (text)) == AJSB_PROJECT_INVALID)
+#define SYNTAX(pr, p, text) MACRO_ASSERT_TRUE(V((pr), (p), (text)) == AJSB_PROJECT_SYNTAX_ERROR)
+
+static ajson_t *order(aml_pool_t *p) {
+  ajson_t *customer = ajsb_object(p);
+  ajsb_prop_required(p, customer, "name", ajsb_string(p));
+  ajson_t *email = ajsb_string(p);
+  ajsb_string_format(p, email, "email");
+  ajsb_prop(p, customer, "email", email);
+
+  ajson_t *item = ajsb_object(p);
+  ajson_t *sku = ajsb_string(p);
+  ajsb_string_pattern(p, sku, "^[A-Z]{3}-[0-9]+$");
+  ajsb_prop_required(p, item, "sku", sku);
+  ajson_t *qty = ajsb_integer(p);
+  ajsb_number_min(p, qty, 1, false);
+  ajsb_prop_required(p, item, "qty", qty);
+  ajsb_additional_properties(p, item, false);
+  ajson_t *items = ajsb_array(p, item);
+  ajsb_array_min_items(p, items, 1);
+
+  ajson_t *root = ajsb_object(p);
+  ajsb_prop_required(p, root, "id", ajsb_integer(p));
+  ajsb_defs_add(p, root, "customer", customer);
+  ajsb_prop_required(p, root, "customer", ajsb_ref(p, "#/$defs/customer"));
+  ajsb_prop_required(p, root, "items", items);
+  ajsb_prop(p, root, "notes", ajsb_array(p, ajsb_string(p)));
+  ajsb_additional_properties(p, root, false);
+  return root;
+}
+
+/* ---------- 1) agrees ---------- */
+MACRO_TEST(ajsb_project_agrees) {
+  aml_pool_t *p = aml_pool_init(4096);
+  ajson_t *s = order(p);
+  ajsb_program_t *prog = ajsb_compile(p, s);
+  static const char *const all[] = {""};
+  ajsb_projection_t *whole = ajsb_projection_init(p, s, 1, all);
+  MACRO_ASSERT_TRUE(prog && whole);
+
+  /* the pointer "" is ajsb_validate */
+  static const char *const docs[] = {
+    "{\"id\":1,\"customer\":{\"name\":\"a\"},\"items\":[{\"sku\":\"ABC-1\",\"qty\":1}]}",
+    "{\"id\":1,\"customer\":{\"name\":\"a\",\"email\":\"a@b.co\"},\"items\":[{\"sku\":\"ABC-1\",\"qty\":2}],\"notes\":[\"x\"]}",
+    "{\"id\":1.5,\"customer\":{\"name\":\"a\"},\"items\":[{\"sku\":\"ABC-1\",\"qty\":1}]}",
+    "{\"id\":1,\"customer\":{\"name\":\"a\",\"email\":\"nope\"},\"items\":[{\"sku\":\"ABC-1\",\"qty\":1}]}",
+    "{\"id\":1,\"customer\":{},\"items\":[{\"sku\":\"ABC-1\",\"qty\":1}]}",
+    "{\"id\":1,\"customer\":{\"name\":\"a\"},\"items\":[]}",
+    "{\"id\":1,\"customer\":{\"name\":\"a\"},\"items\":[{\"sku\":\"abc\",\"qty\":1}]}",
+    "{\"id\":1,\"customer\":{\"name\":\"a\"},\"items\":[{\"sku\":\"ABC-1\",\"qty\":0}]}",
+    "{\"id\":1,\"customer\":{\"name\":\"a\"},\"items\":[{\"sku\":\"ABC-1\",\"qty\":1}],\"notes\":[1]}",
+    "{\"id\":1,\"customer\":{\"name\":\"a\"},\"items\":[{\"sku\":\"ABC-1\",\"qty\":1}],\"x\":1}",
+    "[1]",
+  };
+  for (size_t i = 0; i < sizeof(docs) / sizeof(docs[0]); i++) {
+    char *copy = aml_pool_strdup(p, docs[i]);
+    bool full = ajsb_validate(prog, ajson_parse_string(p, copy));
+    MACRO_ASSERT_TRUE(full == (V(whole, p, docs[i]) == AJSB_PROJECT_OK));
+  }
+
+  /* projected values are validated in full, the rest only on the way */
+  static const char *const reads[] = {"/id", "/customer/email", "/items/0/qty"};
+  ajsb_projection_t *pr = ajsb_projection_init(p, s, 3, reads);
+  OK(pr, p,  docs[0]);
+  OK(pr, p,  docs[1]);
+  BAD(pr, p, docs[2]);                  /* /id */
+  BAD(pr, p, docs[3]);                  /* /customer/email */
+  BAD(pr, p, docs[4]);                  /* /customer is on the path: name is required */
+  BAD(pr, p, docs[5]);                  /* /items is on the path: minItems */
+  OK(pr, p,  docs[6]);                  /* /items/0/sku is not read */
+  BAD(pr, p, docs[7]);                  /* /items/0/qty */
+  OK(pr, p,  docs[8]);                  /* /notes is not read */
+  BAD(pr, p, docs[9]);                  /* the root is on the path: additionalProperties */
+  BAD(pr, p, docs[10]);                 /* and must be an object */
+  OK(pr, p,  "{\"id\":1,\"customer\":{\"name\":\"a\"},"
+             "\"items\":[{\"sku\":\"ABC-1\",\"qty\":1},{\"sku\":7,\"qty\":-1,\"x\":{}}]}");
+
+  aml_pool_destroy(p);
+}
+
+/* ---------- 2) pointers ---------- */
+MACRO_TEST(ajsb_project_pointers) {
+  aml_pool_t *p = aml_pool_init(4096);
+  ajson_t *s = order(p);
+
+  /* "*" reads every item */
+  static const char *const skus[] = {"/items/*/sku"};
+  ajsb_projection_t *pr = ajsb_projection_init(p, s, 1, skus);
+  OK(pr, p,  "{\"id\":1,\"customer\":{},\"items\":[{\"sku\":\"ABC-1\",\"qty\":0},{\"sku\":\"XYZ-22\",\"qty\":\"?\"}]}");
+  BAD(pr, p, "{\"id\":1,\"customer\":{},\"items\":[{\"sku\":\"ABC-1\",\"qty\":0},{\"sku\":\"xyz\"}]}");
+  BAD(pr, p, "{\"id\":1,\"customer\":{},\"items\":[{\"sku\":\"ABC-1\",\"y\":0}]}");   /* unknown key */
+  BAD(pr, p, "{\"id\":1,\"customer\":{},\"items\":{\"sku\":\"ABC-1\"}}");             /* not an array */
+
+  /* a pointer inside another reads the outer value whole */
+  static const char *const nested[] = {"/items/1", "/items/1/sku", "/customer"};
+  pr = ajsb_projection_init(p, s, 3, nested);
+  OK(pr, p,  "{\"id\":\"x\",\"customer\":{\"name\":\"a\"},\"items\":[0,{\"sku\":\"ABC-1\",\"qty\":1}]}");
+  BAD(pr, p, "{\"id\":\"x\",\"customer\":{\"name\":\"a\"},\"items\":[0,{\"sku\":\"ABC-1\",\"qty\":0}]}");
+  BAD(pr, p, "{\"id\":\"x\",\"customer\":{\"name\":1},\"items\":[0,{\"sku\":\"ABC-1\",\"qty\":1}]}");
+  OK(pr, p,  "{\"id\":\"x\",\"customer\":{\"name\":\"a\"},\"items\":[0]}");            /* nothing at /items/1 */
+
+  /* ~1 and ~0 in pointers */
+  ajson_t *odd = ajsb_object(p);
+  ajsb_prop(p, odd, "a/b", ajsb_integer(p));
+  ajsb_prop(p, odd, "m~n", ajsb_string(p));
+  static const char *const escaped[] = {"/a~1b", "/m~0n"};
+  pr = ajsb_projection_init(p, odd, 2, escaped);
+  OK(pr, p,  "{\"a/b\":1,\"m~n\":\"x\",\"c\":[1 2 @]}");
+  BAD(pr, p, "{\"a/b\":\"1\"}");
+  BAD(pr, p, "{\"m~n\":1}");
+  BAD(pr, p, "{\"a\\/b\":\"1\"}");                               /* escaped in the text */
+  BAD(pr, p, "{\"m\\u007en\":1}");
+  SYNTAX(pr, p, "{\"a\\u00\":1}");
+
+  /* anyOf on the path: that value is validated whole */
+  ajson_t *alts[2] = { ajsb_object(p), ajsb_string(p) };
+  ajsb_prop_required(p, alts[0], "k", ajsb_integer(p));
+  ajsb_prop(p, alts[0], "skip", ajsb_integer(p));
+  ajson_t *u = ajsb_object(p);
+  ajsb_prop(p, u, "u", ajsb_anyOf(p, 2, alts));
+  static const char *const uk[] = {"/u/k"};
+  pr = ajsb_projection_init(p, u, 1, uk);
+  OK(pr, p,  "{\"u\":{\"k\":1,\"skip\":2},\"z\":[1,]}");
+  BAD(pr, p, "{\"u\":{\"k\":1,\"skip\":\"2\"}}");
+
+  /* bad pointers, bad schemas */
+  static const char *const bad1[] = {"items"}, *const bad2[] = {"/a~2"}, *const bad3[] = {NULL};
+  MACRO_ASSERT_TRUE(ajsb_projection_init(p, s, 1, bad1) == NULL);
+  MACRO_ASSERT_TRUE(ajsb_projection_init(p, s, 1, bad2) == NULL);
+  MACRO_ASSERT_TRUE(ajsb_projection_init(p, s, 1, bad3) == NULL);
+  MACRO_ASSERT_TRUE(ajsb_projection_init(p, ajsb_ref(p, "#/nope"), 1, skus) == NULL);
+
+  /* no pointers: only the root's own keywords */
+  pr = ajsb_projection_init(p, s, 0, NULL);
+  OK(pr, p,  "{\"id\":\"x\",\"customer\":1,\"items\":2}");
+  BAD(pr, p, "{\"id\":1,\"customer\":1}");
+
+  aml_pool_destroy(p);
+}
+
+/* ---------- 3) skipping ---------- */
+MACRO_TEST(ajsb_project_skipping) {
+  aml_pool_t *p = aml_pool_init(4096);
+  ajson_t *s = order(p);
+  static const char *const ids[] = {"/id"};
+  ajsb_projection_t *pr = ajsb_projection_init(p, s, 1, ids);
+
+  /* long unread text with quotes, escapes and brackets inside strings */
+  aml_buffer_t *bh = aml_buffer_init(1 << 16);
+  aml_buffer_appends(bh, "{\"customer\":{\"name\":\"a\",\"bio\":\"");
+  for (int i = 0; i < 500; i++) aml_buffer_appends(bh, "{[\\\"quoted\\\\\\\"]} ");
+  aml_buffer_appends(bh, "\"},\"notes\":[");
+  for (int i = 0; i < 2000; i++) aml_buffer_appendf(bh, "%s\"n%d \\\\\"", i ? "," : "", i);
+  aml_buffer_appends(bh, "],\"items\":[[[[{\"a\":[\"]\"]}]]]],\"id\":42}");
+  ajsb_project_error_t err;
+  MACRO_ASSERT_TRUE(ajsb_project_validate(pr, p, aml_buffer_data(bh), aml_buffer_length(bh), &err) ==
+                    AJSB_PROJECT_OK && err.why == NULL);
+
+  /* an invalid read reports where */
+  aml_buffer_shrink_by(bh, 3);
+  aml_buffer_appends(bh, "4.5}");
+  const char *doc = aml_buffer_data(bh);
+  MACRO_ASSERT_TRUE(ajsb_project_validate(pr, p, doc, aml_buffer_length(bh), &err) ==
+                    AJSB_PROJECT_INVALID);
+  MACRO_ASSERT_TRUE(!strcmp(doc + err.offset, "4.5}") && err.why);
+
+  /* skipped text still has to be well formed around the reads */
+  SYNTAX(pr, p, "{\"customer\":{\"name\":\"a},\"items\":[1],\"id\":1}");
+  SYNTAX(pr, p, "{\"customer\":{\"name\":\"a\"],\"items\":[1],\"id\":1}");
+  SYNTAX(pr, p, "{\"customer\":{\"name\":\"a\"},\"items\":[1],\"id\":1} x");
+  SYNTAX(pr, p, "{\"customer\":{\"name\":\"a\"},\"items\":[1],\"id\":1");
+  SYNTAX(pr, p, "{\"customer\":{\"name\":\"a\\\"},\"items\":[1],\"id\":1}");
+  SYNTAX(pr, p, "{\"id\":1,\"items\":[1],\"customer\":\"\\");
+  SYNTAX(pr, p, "{\"id\":1,\"items\":[1],\"customer\":,}");
+  SYNTAX(pr, p, "");
+  OK(pr, p,     "{\"customer\":[1 2 @],\"items\":[1],\"id\":1}");    /* but not parsed */
+
+  /* nesting */
+  for (int depth = 100; depth <= 300; depth += 200) {
+    aml_buffer_clear(bh);
+    aml_buffer_appends(bh, "{\"id\":1,\"customer\":{},\"items\":[");
+    for (int i = 0; i < depth; i++) aml_buffer_appendc(bh, '[');
+    for (int i = 0; i < depth; i++) aml_buffer_appendc(bh, ']');
+    aml_buffer_appends(bh, "]}");
+    MACRO_ASSERT_TRUE(V(pr, p, aml_buffer_data(bh)) ==
+                      (depth < AJSB_PROJECT_MAX_DEPTH ? AJSB_PROJECT_OK : AJSB_PROJECT_INVALID));
+  }
+  MACRO_ASSERT_TRUE(ajsb_project_validate(NULL, p, "1", 1, &err) == AJSB_PROJECT_INVALID);
+
+  aml_buffer_destroy(bh);
+  aml_pool_destroy(p);
+}
+
+/* ---------- Runner ---------- */
+int main(void) {
+  macro_test_case tests[16];
+  size_t test_count = 0;
+
+  MACRO_ADD(tests, ajsb_project_agrees);
+  MACRO_ADD(tests, ajsb_project_pointers);
+  MACRO_ADD(tests, ajsb_project_skipping);
+
+  macro_run_all("a-json-schema-builder/ajsb_project", tests, test_count);
+  return 0;
+}
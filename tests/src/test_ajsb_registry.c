@@ -0,0 +1,211 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#include "a-json-schema-builder-library/ajsb.h"
+#include "a-json-schema-builder-library/ajsb_registry.h"
+#include "a-json-schema-builder-library/ajsb_validate.h"
+#include "a-json-library/ajson.h"
+#include "a-memory-library/aml_pool.h"
+#include "the-macro-library/macro_test.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+
+static ajson_t *P(aml_pool_t *p, const char *s) { return ajson_parse_string(p, aml_pool_strdup(p, s)); }
+
+static bool valid(const ajsb_registry_entry_t *e, const char *doc) {
+  aml_pool_t *p = aml_pool_init(1024);
+  bool r = e && e->program && ajsb_validate(e->program, P(p, doc));
+  aml_pool_destroy(p);
+  return r;
+}
+
+/* ---------- 1) lookup_and_refs ---------- */
+MACRO_TEST(ajsb_registry_lookup_and_refs) {
+  ajsb_registry_gen_t *g = ajsb_registry_gen_init();
+  aml_pool_t *gp = ajsb_registry_gen_pool(g);
+
+  /* built with the builders, identified by $id */
+  ajson_t *addr = ajsb_object(gp);
+  ajsb_set_id(gp, addr, "https://example.com/schemas/address.json");
+  ajson_t *zip = ajsb_string(gp);
+  ajsb_string_pattern(gp, zip, "^[0-9]{5}$");
+  ajsb_anchor(gp, zip, "zip");
+  ajsb_prop_required(gp, addr, "zip", zip);
+  MACRO_ASSERT_TRUE(ajsb_registry_gen_add(g, NULL, addr));
+
+  /* absolute, relative and anchored references into it */
+  MACRO_ASSERT_TRUE(ajsb_registry_gen_add(g, "user", P(gp,
+    "{\"$id\":\"https://example.com/schemas/user.json\",\"type\":\"object\","
+    "\"properties\":{\"home\":{\"$ref\":\"https://example.com/schemas/address.json\"},"
+    "\"work\":{\"$ref\":\"address.json\"},"
+    "\"zip\":{\"$ref\":\"/schemas/address.json#zip\"}}}")));
+  MACRO_ASSERT_TRUE(ajsb_registry_gen_add(g, "dangling", P(gp, "{\"$ref\":\"https://example.com/none.json\"}")));
+  MACRO_ASSERT_TRUE(!ajsb_registry_gen_add(g, "user", ajsb_string(gp)));       /* name taken */
+  MACRO_ASSERT_TRUE(!ajsb_registry_gen_add(g, NULL, P(gp, "{\"type\":\"string\"}")));   /* no name */
+
+  ajsb_registry_t *r = ajsb_registry_init();
+  ajsb_registry_reader_t *rd = ajsb_registry_reader_init(r);
+  MACRO_ASSERT_TRUE(ajsb_registry_enter(rd) == NULL);
+  ajsb_registry_leave(rd);
+  MACRO_ASSERT_TRUE(ajsb_registry_publish(r, g));
+
+  const ajsb_registry_gen_t *s = ajsb_registry_enter(rd);
+  MACRO_ASSERT_TRUE(ajsb_registry_generation(s) == 1 && ajsb_registry_count(s) == 3);
+  const ajsb_registry_entry_t *user = ajsb_registry_get(s, "user");
+  MACRO_ASSERT_TRUE(user == ajsb_registry_get(s, "https://example.com/schemas/user.json"));
+  MACRO_ASSERT_TRUE(ajsb_registry_get(s, "https://example.com/schemas/address.json") ==
+                    ajsb_registry_at(s, 0));
+  MACRO_ASSERT_TRUE(ajsb_registry_get(s, "nobody") == NULL);
+
+  MACRO_ASSERT_TRUE(user->resolved && user->bundled != user->schema);
+  MACRO_ASSERT_TRUE(!ajsono_scan(user->schema, "$defs"));          /* not modified */
+  MACRO_ASSERT_TRUE(valid(user, "{\"home\":{\"zip\":\"12345\"},\"work\":{\"zip\":\"54321\"},\"zip\":\"00000\"}"));
+  MACRO_ASSERT_TRUE(!valid(user, "{\"home\":{\"zip\":\"1234\"}}"));
+  MACRO_ASSERT_TRUE(!valid(user, "{\"work\":{}}"));
+  MACRO_ASSERT_TRUE(!valid(user, "{\"zip\":\"abcde\"}"));
+
+  const ajsb_registry_entry_t *dangling = ajsb_registry_get(s, "dangling");
+  MACRO_ASSERT_TRUE(dangling && !dangling->resolved);
+
+  MACRO_ASSERT_TRUE(ajsb_registry_resolve(s, "https://example.com/schemas/address.json") == addr);
+  MACRO_ASSERT_TRUE(ajsb_registry_resolve(s, "https://example.com/schemas/address.json#zip") == zip);
+  MACRO_ASSERT_TRUE(ajsb_registry_resolve(s, "https://example.com/schemas/address.json#/properties/zip") == zip);
+  MACRO_ASSERT_TRUE(ajsb_registry_resolve(s, "https://example.com/schemas/address.json#/properties/no") == NULL);
+  MACRO_ASSERT_TRUE(ajsb_registry_resolve(s, "https://example.com/other.json") == NULL);
+  ajsb_registry_leave(rd);
+
+  ajsb_registry_destroy(r);
+}
+
+/* ---------- 2) hot_reload ---------- */
+static void write_file(const char *dir, const char *name, const char *text) {
+  char path[512];
+  snprintf(path, sizeof(path), "%s/%s", dir, name);
+  FILE *fp = fopen(path, "wb");
+  fputs(text, fp);
+  fclose(fp);
+}
+
+MACRO_TEST(ajsb_registry_hot_reload) {
+  char dir[] = "/tmp/ajsb_registry_XXXXXX";
+  MACRO_ASSERT_TRUE(mkdtemp(dir) != NULL);
+  write_file(dir, "order.json",
+             "{\"$id\":\"urn:app:order\",\"type\":\"object\",\"properties\":"
+             "{\"qty\":{\"$ref\":\"urn:app:qty\"}},\"required\":[\"qty\"]}");
+  write_file(dir, "qty.json", "{\"$id\":\"urn:app:qty\",\"type\":\"integer\",\"minimum\":1}");
+  write_file(dir, "notes.txt", "ignored");
+
+  ajsb_registry_t *r = ajsb_registry_init();
+  ajsb_registry_reader_t *rd = ajsb_registry_reader_init(r);
+  ajsb_registry_gen_t *g = ajsb_registry_gen_init();
+  MACRO_ASSERT_TRUE(ajsb_registry_gen_load_dir(g, dir) == 2);
+  ajsb_registry_publish(r, g);
+
+  const ajsb_registry_gen_t *old = ajsb_registry_enter(rd);
+  const ajsb_registry_entry_t *order = ajsb_registry_get(old, "order");
+  MACRO_ASSERT_TRUE(order && order->resolved && ajsb_registry_get(old, "urn:app:qty"));
+  MACRO_ASSERT_TRUE(valid(order, "{\"qty\":5}") && !valid(order, "{\"qty\":0}"));
+
+  /* the files change; the new generation goes live while this reader is inside the old one */
+  write_file(dir, "qty.json", "{\"$id\":\"urn:app:qty\",\"type\":\"integer\",\"minimum\":10}");
+  g = ajsb_registry_gen_init();
+  MACRO_ASSERT_TRUE(ajsb_registry_gen_load_dir(g, dir) == 2);
+  ajsb_registry_publish(r, g);
+  MACRO_ASSERT_TRUE(ajsb_registry_reclaim(r) == 1);
+  MACRO_ASSERT_TRUE(valid(order, "{\"qty\":5}"));                  /* still the old rules */
+  ajsb_registry_leave(rd);
+  MACRO_ASSERT_TRUE(ajsb_registry_reclaim(r) == 0);
+
+  const ajsb_registry_gen_t *now = ajsb_registry_enter(rd);
+  MACRO_ASSERT_TRUE(ajsb_registry_generation(now) == 2);
+  order = ajsb_registry_get(now, "order");
+  MACRO_ASSERT_TRUE(!valid(order, "{\"qty\":5}") && valid(order, "{\"qty\":10}"));
+  ajsb_registry_leave(rd);
+
+  g = ajsb_registry_gen_init();
+  MACRO_ASSERT_TRUE(ajsb_registry_gen_load_dir(g, "/nonexistent/dir") == (size_t)-1);
+  ajsb_registry_gen_destroy(g);
+  ajsb_registry_reader_destroy(rd);
+  ajsb_registry_destroy(r);
+
+  char path[512];
+  snprintf(path, sizeof(path), "%s/order.json", dir); unlink(path);
+  snprintf(path, sizeof(path), "%s/qty.json", dir); unlink(path);
+  snprintf(path, sizeof(path), "%s/notes.txt", dir); unlink(path);
+  rmdir(dir);
+}
+
+/* ---------- 3) concurrent_readers ---------- */
+#define READERS 4
+#define GENERATIONS 200
+
+typedef struct {
+  ajsb_registry_t *r;
+  bool             done;      /* atomic */
+  size_t           bad;       /* atomic */
+} shared_t;
+
+/* generation n holds "v" = {"const": n} */
+static ajsb_registry_gen_t *numbered(uint64_t n) {
+  ajsb_registry_gen_t *g = ajsb_registry_gen_init();
+  aml_pool_t *gp = ajsb_registry_gen_pool(g);
+  char text[64];
+  snprintf(text, sizeof(text), "{\"const\":%llu}", (unsigned long long)n);
+  ajsb_registry_gen_add(g, "v", P(gp, text));
+  return g;
+}
+
+static void *reader_main(void *arg) {
+  shared_t *sh = (shared_t *)arg;
+  ajsb_registry_reader_t *rd = ajsb_registry_reader_init(sh->r);
+  aml_pool_t *p = aml_pool_init(1024);
+  uint64_t last = 0;
+  while (!__atomic_load_n(&sh->done, __ATOMIC_ACQUIRE)) {
+    const ajsb_registry_gen_t *s = ajsb_registry_enter(rd);
+    uint64_t n = ajsb_registry_generation(s);
+    const ajsb_registry_entry_t *e = ajsb_registry_get(s, "v");
+    char doc[32];
+    snprintf(doc, sizeof(doc), "%llu", (unsigned long long)n);
+    if (n < last || !e || !ajsb_validate(e->program, P(p, doc))) __atomic_add_fetch(&sh->bad, 1, __ATOMIC_RELAXED);
+    last = n;
+    ajsb_registry_leave(rd);
+    aml_pool_clear(p);
+  }
+  aml_pool_destroy(p);
+  ajsb_registry_reader_destroy(rd);
+  return NULL;
+}
+
+MACRO_TEST(ajsb_registry_concurrent_readers) {
+  shared_t sh = {ajsb_registry_init(), false, 0};
+  ajsb_registry_publish(sh.r, numbered(1));
+  pthread_t t[READERS];
+  for (int i = 0; i < READERS; i++) pthread_create(t + i, NULL, reader_main, &sh);
+  for (uint64_t n = 2; n <= GENERATIONS; n++) ajsb_registry_publish(sh.r, numbered(n));
+  __atomic_store_n(&sh.done, true, __ATOMIC_RELEASE);
+  for (int i = 0; i < READERS; i++) pthread_join(t[i], NULL);
+  MACRO_ASSERT_TRUE(sh.bad == 0);
+  MACRO_ASSERT_TRUE(ajsb_registry_reclaim(sh.r) == 0);
+  ajsb_registry_destroy(sh.r);
+}
+
+/* ---------- Runner ---------- */
+int main(void) {
+  macro_test_case tests[16];
+  size_t test_count = 0;
+
+  MACRO_ADD(tests, ajsb_registry_lookup_and_refs);
+  MACRO_ADD(tests, ajsb_registry_hot_reload);
+  MACRO_ADD(tests, ajsb_registry_concurrent_readers);
+
+  macro_run_all("a-json-schema-builder/ajsb_registry", tests, test_count);
+  return 0;
+}
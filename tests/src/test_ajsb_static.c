@@ -0,0 +1,121 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#include "a-json-schema-builder-library/ajsb.h"
+#include "a-json-schema-builder-library/ajsb_static.h"
+#include "a-json-library/ajson.h"
+#include "a-memory-library/aml_pool.h"
+#include "the-macro-library/macro_test.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+
+#define USER_SCHEMA                                                              \
+  AJSB_S_OBJECT(                                                                 \
+    AJSB_S_SCHEMA("https://json-schema.org/draft/2020-12/schema"),               \
+    AJSB_S_PROPS(                                                                \
+      AJSB_S_PROP("email", AJSB_S_STRING(AJSB_S_FORMAT("email"))),               \
+      AJSB_S_PROP("age",   AJSB_S_INTEGER(AJSB_S_MIN(0), AJSB_S_EXCL_MAX(150.5))), \
+      AJSB_S_PROP("roles", AJSB_S_ARRAY(AJSB_S_STRING(AJSB_S_ENUM("admin", "staff", "user")), \
+                                        AJSB_S_MIN_ITEMS(1), AJSB_S_UNIQUE(true))), \
+      AJSB_S_PROP("id",    AJSB_S_ANY_OF(AJSB_S_REF("#/$defs/uuid"), AJSB_S_NULL()))), \
+    AJSB_S_REQUIRED("email", "age"),                                             \
+    AJSB_S_ADDITIONAL(false),                                                    \
+    AJSB_S_DEFS(                                                                 \
+      AJSB_S_DEF("uuid", AJSB_S_STRING(AJSB_S_PATTERN("^[0-9a-fA-F-]{36}$"),     \
+                                       AJSB_S_DESCRIPTION("say \"hi\"\n")))))
+
+static ajsb_static_t user_schema = AJSB_STATIC_INIT(USER_SCHEMA);
+
+static ajson_t *user_tree(aml_pool_t *p) {
+  ajson_t *user = ajsb_object(p);
+  ajsb_set_schema(p, user, "https://json-schema.org/draft/2020-12/schema");
+  ajson_t *email = ajsb_string(p);
+  ajsb_string_format(p, email, "email");
+  ajsb_prop(p, user, "email", email);
+  ajson_t *age = ajsb_integer(p);
+  ajsb_number_min(p, age, 0, false);
+  ajsb_number_max(p, age, 150.5, true);
+  ajsb_prop(p, user, "age", age);
+  const char *role_vals[] = {"admin", "staff", "user"};
+  ajson_t *role = ajsb_string(p);
+  ajsb_string_enum(p, role, 3, role_vals);
+  ajson_t *roles = ajsb_array(p, role);
+  ajsb_array_min_items(p, roles, 1);
+  ajsb_array_unique(p, roles, true);
+  ajsb_prop(p, user, "roles", roles);
+  ajson_t *alts[] = { ajsb_ref(p, "#/$defs/uuid"), ajsb_null(p) };
+  ajsb_prop(p, user, "id", ajsb_anyOf(p, 2, alts));
+  const char *req[] = {"email", "age"};
+  ajsb_required(p, user, 2, req);
+  ajsb_additional_properties(p, user, false);
+  ajson_t *uuid = ajsb_string(p);
+  ajsb_string_pattern(p, uuid, "^[0-9a-fA-F-]{36}$");
+  ajsb_description(p, uuid, "say \"hi\"\n");
+  ajsb_defs_add(p, user, "uuid", uuid);
+  return user;
+}
+
+/* ---------- 1) matches_runtime_builders ---------- */
+MACRO_TEST(ajsb_static_matches_runtime_builders) {
+  aml_pool_t *p = aml_pool_init(4096);
+
+  MACRO_ASSERT_STREQ(USER_SCHEMA, ajsb_stringify(p, user_tree(p)));
+  MACRO_ASSERT_TRUE(user_schema.len == strlen(USER_SCHEMA));
+
+  /* empty keyword lists and a bare object */
+  MACRO_ASSERT_STREQ(AJSB_S_OBJECT(), ajsb_stringify(p, ajsb_object(p)));
+  ajson_t *b = ajsb_boolean(p);
+  ajsb_title(p, b, "flag");
+  MACRO_ASSERT_STREQ(AJSB_S_BOOLEAN(AJSB_S_TITLE("flag")), ajsb_stringify(p, b));
+
+  /* pattern escapes */
+  ajson_t *d = ajsb_string(p);
+  ajsb_string_pattern(p, d, "^\\d+$");
+  MACRO_ASSERT_STREQ(AJSB_S_STRING(AJSB_S_PATTERN("^\\d+$")), ajsb_stringify(p, d));
+
+  /* the text parses back to the same tree */
+  MACRO_ASSERT_STREQ(ajsb_stringify(p, ajsb_static_parse(p, &user_schema)), USER_SCHEMA);
+
+  aml_pool_destroy(p);
+}
+
+/* ---------- 2) validates ---------- */
+MACRO_TEST(ajsb_static_validates) {
+  aml_pool_t *p = aml_pool_init(4096);
+
+  const ajsb_program_t *prog = ajsb_static_program(&user_schema);
+  MACRO_ASSERT_TRUE(prog != NULL);
+  MACRO_ASSERT_TRUE(ajsb_static_program(&user_schema) == prog);   /* compiled once */
+
+  const char *ok  = "{\"email\":\"a@b\",\"age\":30,\"roles\":[\"admin\"],\"id\":null}";
+  const char *bad = "{\"email\":\"a@b\",\"age\":30,\"roles\":[]}";
+  MACRO_ASSERT_TRUE(ajsb_static_validate(&user_schema, ajson_parse_string(p, aml_pool_strdup(p, ok))));
+  MACRO_ASSERT_TRUE(!ajsb_static_validate(&user_schema, ajson_parse_string(p, aml_pool_strdup(p, bad))));
+
+  /* a failure is remembered: the second call does not parse again */
+  static ajsb_static_t broken = AJSB_STATIC_INIT("{\"type\":");
+  MACRO_ASSERT_TRUE(ajsb_static_program(&broken) == NULL && broken.failed);
+  broken.json = USER_SCHEMA;
+  broken.len = sizeof(USER_SCHEMA) - 1;
+  MACRO_ASSERT_TRUE(ajsb_static_program(&broken) == NULL);
+  MACRO_ASSERT_TRUE(!ajsb_static_validate(&broken, ajson_parse_string(p, aml_pool_strdup(p, ok))));
+
+  aml_pool_destroy(p);
+}
+
+/* ---------- Runner ---------- */
+int main(void) {
+  macro_test_case tests[16];
+  size_t test_count = 0;
+
+  MACRO_ADD(tests, ajsb_static_matches_runtime_builders);
+  MACRO_ADD(tests, ajsb_static_validates);
+
+  macro_run_all("a-json-schema-builder/ajsb_static", tests, test_count);
+  return 0;
+}
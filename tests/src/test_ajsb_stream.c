@@ -0,0 +1,163 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#include "a-json-schema-builder-library/ajsb.h"
+#include "a-json-schema-builder-library/ajsb_stream.h"
+#include "a-json-schema-builder-library/ajsb_validate.h"
+#include "a-json-library/ajson.h"
+#include "a-memory-library/aml_pool.h"
+#include "the-macro-library/macro_test.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+
+/* Push text one byte at a time, the way tokens trickle out of a model. */
+static ajsb_stream_status_t feed(ajsb_stream_t *s, const char *text) {
+  ajsb_stream_reset(s);
+  ajsb_stream_status_t st = AJSB_STREAM_CONTINUE;
+  for (const char *c = text; *c && (st == AJSB_STREAM_CONTINUE || st == AJSB_STREAM_COMPLETE); c++)
+    st = ajsb_stream_push(s, c, 1);
+  if (st == AJSB_STREAM_CONTINUE || st == AJSB_STREAM_COMPLETE) st = ajsb_stream_finish(s);
+  return st;
+}
+
+static ajson_t *weather(aml_pool_t *p) {
+  ajson_t *root = ajsb_object(p);
+  ajsb_prop(p, root, "city",       ajsb_string(p));
+  ajsb_prop(p, root, "tempC",      ajsb_number(p));
+  ajsb_prop(p, root, "conditions", ajsb_string(p));
+  const char *req[] = {"city","tempC","conditions"};
+  ajsb_required(p, root, 3, req);
+  ajsb_additional_properties(p, root, false);
+  return root;
+}
+
+/* ---------- 1) weather_chunks ---------- */
+MACRO_TEST(ajsb_stream_weather_chunks) {
+  aml_pool_t *p = aml_pool_init(4096);
+  ajsb_stream_t *s = ajsb_stream_init(p, ajsb_compile(p, weather(p)));
+
+  const char *doc = "{ \"city\": \"Oslo\", \"tempC\": -3.5e0, \"conditions\": \"snow\" }\n";
+  MACRO_ASSERT_TRUE(feed(s, doc) == AJSB_STREAM_COMPLETE);
+
+  /* arbitrary chunk boundaries */
+  ajsb_stream_reset(s);
+  MACRO_ASSERT_TRUE(ajsb_stream_push(s, doc, 7) == AJSB_STREAM_CONTINUE);
+  MACRO_ASSERT_TRUE(ajsb_stream_push(s, doc + 7, 20) == AJSB_STREAM_CONTINUE);
+  MACRO_ASSERT_TRUE(ajsb_stream_push(s, doc + 27, strlen(doc) - 27) == AJSB_STREAM_COMPLETE);
+  MACRO_ASSERT_TRUE(ajsb_stream_finish(s) == AJSB_STREAM_COMPLETE);
+
+  aml_pool_destroy(p);
+}
+
+/* ---------- 2) early_rejection ---------- */
+MACRO_TEST(ajsb_stream_early_rejection) {
+  aml_pool_t *p = aml_pool_init(4096);
+  ajsb_stream_t *s = ajsb_stream_init(p, ajsb_compile(p, weather(p)));
+
+  /* unknown key: rejected on the first byte no property name starts with */
+  const char *unknown = "{\"city\":\"Oslo\",\"cx";
+  MACRO_ASSERT_TRUE(feed(s, unknown) == AJSB_STREAM_INVALID);
+  MACRO_ASSERT_STREQ(ajsb_stream_error(s), "unknown property");
+  MACRO_ASSERT_TRUE(ajsb_stream_offset(s) == strlen(unknown) - 1);
+
+  /* wrong type: rejected on the first byte of the value */
+  MACRO_ASSERT_TRUE(feed(s, "{\"city\":1") == AJSB_STREAM_INVALID);
+  MACRO_ASSERT_STREQ(ajsb_stream_error(s), "type mismatch");
+
+  /* missing required: rejected at the closing brace */
+  MACRO_ASSERT_TRUE(feed(s, "{\"city\":\"Oslo\",\"tempC\":1}") == AJSB_STREAM_INVALID);
+  MACRO_ASSERT_STREQ(ajsb_stream_error(s), "missing required property");
+
+  /* not JSON */
+  MACRO_ASSERT_TRUE(feed(s, "{\"city\" \"Oslo\"}") == AJSB_STREAM_SYNTAX_ERROR);
+  MACRO_ASSERT_TRUE(feed(s, "{\"city\":\"Oslo\"") == AJSB_STREAM_SYNTAX_ERROR);
+
+  aml_pool_destroy(p);
+}
+
+/* ---------- 3) enum_prefix ---------- */
+MACRO_TEST(ajsb_stream_enum_prefix) {
+  aml_pool_t *p = aml_pool_init(4096);
+
+  ajson_t *sort_enum = ajsb_string(p);
+  const char *vals[] = {"asc","desc"};
+  ajsb_string_enum(p, sort_enum, 2, vals);
+  ajson_t *alts[2] = { sort_enum, ajsb_null(p) };
+  ajson_t *root = ajsb_object(p);
+  ajsb_prop_required(p, root, "term", ajsb_string(p));
+  ajsb_prop_required(p, root, "sort", ajsb_anyOf(p, 2, alts));
+  ajsb_additional_properties(p, root, false);
+
+  ajson_t *strict = ajsb_object(p);
+  ajsb_prop_required(p, strict, "sort", sort_enum);
+  ajsb_stream_t *s = ajsb_stream_init(p, ajsb_compile(p, strict));
+  MACRO_ASSERT_TRUE(feed(s, "{\"sort\":\"desc\"}") == AJSB_STREAM_COMPLETE);
+  MACRO_ASSERT_TRUE(feed(s, "{\"sort\":\"dx") == AJSB_STREAM_INVALID);
+  MACRO_ASSERT_STREQ(ajsb_stream_error(s), "enum mismatch");
+  MACRO_ASSERT_TRUE(feed(s, "{\"sort\":\"as\"}") == AJSB_STREAM_INVALID);
+  MACRO_ASSERT_TRUE(feed(s, "{\"\\u0073ort\":\"d\\u0065sc\"}") == AJSB_STREAM_COMPLETE);
+  MACRO_ASSERT_TRUE(feed(s, "{\"sort\":\"d\\u0065sx\"}") == AJSB_STREAM_INVALID);
+
+  /* anyOf branches only narrow the type */
+  s = ajsb_stream_init(p, ajsb_compile(p, root));
+  MACRO_ASSERT_TRUE(feed(s, "{\"term\":\"x\",\"sort\":null}") == AJSB_STREAM_COMPLETE);
+  MACRO_ASSERT_TRUE(feed(s, "{\"term\":\"x\",\"sort\":\"desc\"}") == AJSB_STREAM_COMPLETE);
+  MACRO_ASSERT_TRUE(feed(s, "{\"term\":\"x\",\"sort\":5") == AJSB_STREAM_INVALID);
+
+  aml_pool_destroy(p);
+}
+
+/* ---------- 4) arrays_and_recursion ---------- */
+MACRO_TEST(ajsb_stream_arrays_and_recursion) {
+  aml_pool_t *p = aml_pool_init(8192);
+
+  ajson_t *item = ajsb_object(p);
+  ajsb_prop_required(p, item, "name",     ajsb_string(p));
+  ajsb_prop_required(p, item, "height_m", ajsb_integer(p));
+  ajsb_additional_properties(p, item, false);
+  ajson_t *arr = ajsb_array(p, item);
+  ajsb_array_min_items(p, arr, 1);
+  ajsb_array_max_items(p, arr, 2);
+
+  ajsb_stream_t *s = ajsb_stream_init(p, ajsb_compile(p, arr));
+  MACRO_ASSERT_TRUE(feed(s, "[{\"name\":\"a\",\"height_m\":828}]") == AJSB_STREAM_COMPLETE);
+  MACRO_ASSERT_TRUE(feed(s, "[{\"name\":\"a\",\"height_m\":8.5}]") == AJSB_STREAM_INVALID);
+  MACRO_ASSERT_TRUE(feed(s, "[]") == AJSB_STREAM_INVALID);
+  MACRO_ASSERT_TRUE(feed(s, "[{\"name\":\"a\",\"height_m\":1},{\"name\":\"b\",\"height_m\":2},{") == AJSB_STREAM_INVALID);
+  MACRO_ASSERT_STREQ(ajsb_stream_error(s), "too many items");
+
+  /* ui_tree shaped recursion through $defs */
+  ajson_t *node = ajsb_object(p);
+  ajsb_prop_required(p, node, "label", ajsb_string(p));
+  ajsb_prop_required(p, node, "children", ajsb_array(p, ajsb_ref(p, "#/$defs/node")));
+  ajsb_additional_properties(p, node, false);
+  ajson_t *root = ajsb_object(p);
+  ajsb_defs_add(p, root, "node", node);
+  ajsb_prop_required(p, root, "root", ajsb_ref(p, "#/$defs/node"));
+
+  s = ajsb_stream_init(p, ajsb_compile(p, root));
+  MACRO_ASSERT_TRUE(feed(s, "{\"root\":{\"label\":\"a\",\"children\":[{\"label\":\"b\",\"children\":[]}]}}")
+                    == AJSB_STREAM_COMPLETE);
+  MACRO_ASSERT_TRUE(feed(s, "{\"root\":{\"label\":\"a\",\"children\":[{\"label\":\"b\",\"kids\"") == AJSB_STREAM_INVALID);
+
+  aml_pool_destroy(p);
+}
+
+/* ---------- Runner ---------- */
+int main(void) {
+  macro_test_case tests[16];
+  size_t test_count = 0;
+
+  MACRO_ADD(tests, ajsb_stream_weather_chunks);
+  MACRO_ADD(tests, ajsb_stream_early_rejection);
+  MACRO_ADD(tests, ajsb_stream_enum_prefix);
+  MACRO_ADD(tests, ajsb_stream_arrays_and_recursion);
+
+  macro_run_all("a-json-schema-builder/ajsb_stream", tests, test_count);
+  return 0;
+}
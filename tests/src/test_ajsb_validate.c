@@ -0,0 +1,313 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#include "a-json-schema-builder-library/ajsb.h"
+#include "a-json-schema-builder-library/ajsb_validate.h"
+#include "a-json-library/ajson.h"
+#include "a-memory-library/aml_pool.h"
+#include "the-macro-library/macro_test.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+
+/* Small helpers */
+static ajson_t *P(aml_pool_t *p, const char *text) {
+  return ajson_parse_string(p, aml_pool_strdup(p, text));
+}
+#define OK(prog, p, text)  MACRO_ASSERT_TRUE(ajsb_validate((prog), P((p), (text))))
+#define BAD(prog, p, text) MACRO_ASSERT_TRUE(!ajsb_validate((prog), P((p), (text))))
+
+static ajson_t *weather(aml_pool_t *p) {
+  ajson_t *root = ajsb_object(p);
+  ajsb_prop(p, root, "city",       ajsb_string(p));
+  ajsb_prop(p, root, "tempC",      ajsb_number(p));
+  ajsb_prop(p, root, "conditions", ajsb_string(p));
+  const char *req[] = {"city","tempC","conditions"};
+  ajsb_required(p, root, 3, req);
+  ajsb_additional_properties(p, root, false);
+  return root;
+}
+
+/* ---------- 1) weather_object ---------- */
+MACRO_TEST(ajsb_validate_weather_object) {
+  aml_pool_t *p = aml_pool_init(1024);
+  ajsb_program_t *prog = ajsb_compile(p, weather(p));
+  MACRO_ASSERT_TRUE(prog != NULL);
+
+  OK(prog, p,  "{\"city\":\"Oslo\",\"tempC\":-3.5,\"conditions\":\"snow\"}");
+  BAD(prog, p, "{\"city\":\"Oslo\",\"tempC\":\"cold\",\"conditions\":\"snow\"}");  /* wrong type */
+  BAD(prog, p, "{\"city\":\"Oslo\",\"conditions\":\"snow\"}");                   /* missing tempC */
+  BAD(prog, p, "{\"city\":\"Oslo\",\"tempC\":1,\"conditions\":\"snow\",\"x\":1}"); /* additional */
+  BAD(prog, p, "[]");
+
+  aml_pool_destroy(p);
+}
+
+/* ---------- 2) bounds_and_items ---------- */
+MACRO_TEST(ajsb_validate_bounds_and_items) {
+  aml_pool_t *p = aml_pool_init(1024);
+
+  ajson_t *age = ajsb_integer(p);
+  ajsb_number_min(p, age, 0, false);
+  ajsb_number_max(p, age, 130, true);
+  ajson_t *ages = ajsb_array(p, age);
+  ajsb_array_min_items(p, ages, 1);
+  ajsb_array_max_items(p, ages, 3);
+  ajsb_array_unique(p, ages, true);
+
+  ajsb_program_t *prog = ajsb_compile(p, ages);
+  OK(prog, p,  "[0,42,129]");
+  OK(prog, p,  "[7.0]");
+  BAD(prog, p, "[]");
+  BAD(prog, p, "[1,2,3,4]");
+  BAD(prog, p, "[1,1]");
+  BAD(prog, p, "[-1]");
+  BAD(prog, p, "[130]");
+  BAD(prog, p, "[1.5]");
+
+  aml_pool_destroy(p);
+}
+
+/* ---------- 3) enum_and_anyof ---------- */
+MACRO_TEST(ajsb_validate_enum_and_anyof) {
+  aml_pool_t *p = aml_pool_init(1024);
+
+  ajson_t *sort_enum = ajsb_string(p);
+  const char *vals[] = {"asc","desc"};
+  ajsb_string_enum(p, sort_enum, 2, vals);
+  ajson_t *alts[2] = { sort_enum, ajsb_null(p) };
+  ajson_t *root = ajsb_object(p);
+  ajsb_prop_required(p, root, "sort", ajsb_anyOf(p, 2, alts));
+
+  ajsb_program_t *prog = ajsb_compile(p, root);
+  OK(prog, p,  "{\"sort\":\"asc\"}");
+  OK(prog, p,  "{\"sort\":null}");
+  BAD(prog, p, "{\"sort\":\"up\"}");
+  BAD(prog, p, "{\"sort\":1}");
+  BAD(prog, p, "{}");
+
+  ajson_t *one[2] = { ajsb_number(p), ajsb_integer(p) };
+  prog = ajsb_compile(p, ajsb_oneOf(p, 2, one));
+  OK(prog, p,  "1.5");
+  BAD(prog, p, "2");     /* matches both branches */
+
+  aml_pool_destroy(p);
+}
+
+/* ---------- 4) recursive_refs ---------- */
+MACRO_TEST(ajsb_validate_recursive_refs) {
+  aml_pool_t *p = aml_pool_init(4096);
+
+  ajson_t *node = ajsb_object(p);
+  ajsb_prop_required(p, node, "label", ajsb_string(p));
+  ajsb_prop(p, node, "children", ajsb_array(p, ajsb_ref(p, "#/$defs/node")));
+  ajsb_additional_properties(p, node, false);
+
+  ajson_t *root = ajsb_object(p);
+  ajsb_defs_add(p, root, "node", node);
+  ajsb_prop_required(p, root, "root", ajsb_ref(p, "#/$defs/node"));
+
+  ajsb_program_t *prog = ajsb_compile(p, root);
+  MACRO_ASSERT_TRUE(prog != NULL);
+  OK(prog, p,  "{\"root\":{\"label\":\"a\",\"children\":[{\"label\":\"b\",\"children\":[]}]}}");
+  BAD(prog, p, "{\"root\":{\"label\":\"a\",\"children\":[{\"children\":[]}]}}");
+
+  /* dynamic refs resolve to the matching $dynamicAnchor */
+  ajson_t *dyn = ajsb_object(p);
+  ajsb_dynamic_anchor(p, dyn, "Node");
+  ajsb_prop_required(p, dyn, "label", ajsb_string(p));
+  ajsb_prop(p, dyn, "children", ajsb_array(p, ajsb_dynamic_ref(p, "#Node")));
+  ajson_t *droot = ajsb_object(p);
+  ajsb_defs_set(p, droot, "node", dyn);
+  ajsb_prop(p, droot, "root", ajsb_ref(p, "#/$defs/node"));
+  prog = ajsb_compile(p, droot);
+  MACRO_ASSERT_TRUE(prog != NULL);
+  OK(prog, p,  "{\"root\":{\"label\":\"a\",\"children\":[{\"label\":\"b\"}]}}");
+  BAD(prog, p, "{\"root\":{\"label\":\"a\",\"children\":[{}]}}");
+
+  /* unresolvable references fail to compile */
+  MACRO_ASSERT_TRUE(ajsb_compile(p, ajsb_ref(p, "#/$defs/missing")) == NULL);
+
+  aml_pool_destroy(p);
+}
+
+/* ---------- 5) wide_object ---------- */
+MACRO_TEST(ajsb_validate_wide_object) {
+  aml_pool_t *p = aml_pool_init(1 << 16);
+
+  ajson_t *root = ajsb_object(p);
+  char name[32];
+  for (int i = 0; i < 300; i++) {
+    sprintf(name, "f%d", i);
+    ajsb_prop_required(p, root, name, ajsb_integer(p));
+  }
+  ajsb_additional_properties(p, root, false);
+  ajsb_program_t *prog = ajsb_compile(p, root);
+
+  char *doc = (char *)aml_pool_alloc(p, 300 * 16 + 8);
+  char *w = doc;
+  *w++ = '{';
+  for (int i = 0; i < 300; i++) w += sprintf(w, "%s\"f%d\":%d", i ? "," : "", i, i);
+  strcpy(w, "}");
+  OK(prog, p, doc);
+
+  strcpy(w, ",\"nope\":1}");                 /* unknown key */
+  BAD(prog, p, doc);
+  strcpy(doc + 1, "\"f1\":1}");                /* missing required */
+  BAD(prog, p, doc);
+
+  aml_pool_destroy(p);
+}
+
+/* ---------- 6) discriminated_unions ---------- */
+static ajson_t *variant(aml_pool_t *p, int i) {
+  char kind[16], field[16];
+  snprintf(kind, sizeof(kind), "k%d", i);
+  snprintf(field, sizeof(field), "v%d", i);
+  const char *one[] = {kind};
+  ajson_t *tag = ajsb_string(p);
+  ajsb_string_enum(p, tag, 1, one);
+  ajson_t *v = ajsb_object(p);
+  ajsb_prop_required(p, v, "kind", tag);
+  ajsb_prop_required(p, v, field, i % 2 ? ajsb_integer(p) : ajsb_string(p));
+  return v;
+}
+
+MACRO_TEST(ajsb_validate_discriminated_unions) {
+  aml_pool_t *p = aml_pool_init(1 << 16);
+
+  /* 60 variants, half of them behind $ref */
+  ajson_t *alts[60];
+  ajson_t *root = ajsb_object(p);
+  for (int i = 0; i < 60; i++) {
+    char name[16];
+    snprintf(name, sizeof(name), "d%d", i);
+    if (i % 2) {
+      ajsb_defs_add(p, root, name, variant(p, i));
+      char ref[32];
+      snprintf(ref, sizeof(ref), "#/$defs/%s", name);
+      alts[i] = ajsb_ref(p, ref);
+    }
+    else alts[i] = variant(p, i);
+  }
+  ajsb_prop_required(p, root, "any", ajsb_anyOf(p, 60, alts));
+  ajsb_prop(p, root, "one", ajsb_oneOf(p, 60, alts));
+  ajsb_program_t *prog = ajsb_compile(p, root);
+  MACRO_ASSERT_TRUE(prog != NULL);
+
+  char doc[128];
+  for (int i = 0; i < 60; i++) {
+    snprintf(doc, sizeof(doc), i % 2 ? "{\"any\":{\"kind\":\"k%d\",\"v%d\":%d},\"one\":{\"kind\":\"k%d\",\"v%d\":1}}"
+                                     : "{\"any\":{\"kind\":\"k%d\",\"v%d\":\"%d\"},\"one\":{\"kind\":\"k%d\",\"v%d\":\"x\"}}",
+             i, i, i, i, i);
+    OK(prog, p, doc);
+  }
+  BAD(prog, p, "{\"any\":{\"kind\":\"k3\",\"v3\":\"x\"}}");           /* the named branch fails */
+  BAD(prog, p, "{\"any\":{\"kind\":\"k3\",\"v2\":\"x\"}}");           /* fits another, wrong kind */
+  BAD(prog, p, "{\"any\":{\"kind\":\"k60\",\"v60\":1}}");              /* unknown kind */
+  BAD(prog, p, "{\"any\":{\"v0\":\"x\"}}");                            /* no kind */
+  BAD(prog, p, "{\"any\":{\"kind\":[\"k0\"],\"v0\":\"x\"}}");
+  BAD(prog, p, "{\"any\":{\"kind\":\"k0\",\"v0\":\"x\",\"kind\":\"k1\"}}");
+  BAD(prog, p, "{\"any\":7}");
+
+  /* discriminators of any scalar kind */
+  prog = ajsb_compile(p, P(p,
+    "{\"oneOf\":["
+      "{\"required\":[\"t\"],\"properties\":{\"t\":{\"const\":1}}},"
+      "{\"required\":[\"t\"],\"properties\":{\"t\":{\"const\":\"1\"}}},"
+      "{\"required\":[\"t\"],\"properties\":{\"t\":{\"enum\":[true,null]}}}]}"));
+  OK(prog, p,  "{\"t\":1.0}");
+  OK(prog, p,  "{\"t\":\"1\"}");
+  OK(prog, p,  "{\"t\":null}");
+  OK(prog, p,  "{\"t\":true}");
+  BAD(prog, p, "{\"t\":false}");
+  BAD(prog, p, "{\"t\":2}");
+  BAD(prog, p, "7");                     /* non-objects try every branch: all three match */
+
+  /* a value two branches allow is no discriminator */
+  prog = ajsb_compile(p, P(p,
+    "{\"oneOf\":["
+      "{\"required\":[\"t\"],\"properties\":{\"t\":{\"enum\":[\"a\",\"b\"]}}},"
+      "{\"required\":[\"t\"],\"properties\":{\"t\":{\"enum\":[\"b\",\"c\"]}}}]}"));
+  OK(prog, p,  "{\"t\":\"a\"}");
+  OK(prog, p,  "{\"t\":\"c\"}");
+  BAD(prog, p, "{\"t\":\"b\"}");
+
+  /* without one, anyOf keeps answering the same as its traffic shifts */
+  prog = ajsb_compile(p, P(p,
+    "{\"anyOf\":[{\"type\":\"string\"},{\"type\":\"integer\"},{\"type\":\"null\"},"
+    "{\"type\":\"array\"},{\"type\":\"boolean\"},{\"minimum\":1000}]}"));
+  static const char *const ok[] = {"\"s\"", "1", "null", "[]", "true", "1000.5"};
+  for (int i = 0; i < 3000; i++) {
+    OK(prog, p, ok[(i / 500 + (i % 7 == 0)) % 6]);
+    if (i % 11 == 0) BAD(prog, p, "2.5");
+  }
+
+  aml_pool_destroy(p);
+}
+
+/* ---------- 7) escapes and equality ---------- */
+MACRO_TEST(ajsb_validate_escapes_and_equality) {
+  aml_pool_t *p = aml_pool_init(4096);
+
+  /* strings and names compare decoded, however either side escapes them */
+  ajsb_program_t *prog = ajsb_compile(p, P(p, "{\"enum\":[\"a/b\",\"\\u00e9\",\"\\ud83d\\ude00\"]}"));
+  OK(prog, p,  "\"a\\/b\"");
+  OK(prog, p,  "\"\xc3\xa9\"");
+  OK(prog, p,  "\"\\u00E9\"");
+  OK(prog, p,  "\"\xf0\x9f\x98\x80\"");
+  BAD(prog, p, "\"a\\\\/b\"");
+
+  prog = ajsb_compile(p, P(p,
+    "{\"properties\":{\"a/b\":{\"type\":\"string\"},\"q\\\"\":{}},"
+    "\"required\":[\"a\\/b\",\"\\u0071\\\"\"],\"additionalProperties\":false}"));
+  OK(prog, p,  "{\"a\\/b\":\"x\",\"q\\u0022\":1}");
+  BAD(prog, p, "{\"a\\/b\":1,\"q\\\"\":1}");
+  BAD(prog, p, "{\"a/b\":\"x\"}");
+
+  prog = ajsb_compile(p, P(p, "{\"required\":[\"a\"]}"));
+  OK(prog, p,  "{\"\\u0061\":1}");
+
+  prog = ajsb_compile(p, P(p, "{\"uniqueItems\":true}"));
+  BAD(prog, p, "[\"a/b\",\"a\\/b\"]");
+  BAD(prog, p, "[{\"\\u0061\":1},{\"a\":1.0}]");
+
+  /* object and array members are equal by value, members in any order */
+  prog = ajsb_compile(p, P(p, "{\"enum\":[{\"a\":1,\"b\":2},[1,\"x\\/\"],{}]}"));
+  OK(prog, p,  "{\"b\":2,\"a\":1}");
+  OK(prog, p,  "{\"a\":1.0,\"\\u0062\":2e0}");
+  OK(prog, p,  "[1,\"x/\"]");
+  OK(prog, p,  "{}");
+  BAD(prog, p, "{\"a\":1,\"b\":2,\"c\":3}");
+  BAD(prog, p, "{\"a\":1}");
+  BAD(prog, p, "[1,\"x/\",2]");
+  BAD(prog, p, "[\"x/\",1]");
+  BAD(prog, p, "[]");
+
+  prog = ajsb_compile(p, P(p, "{\"const\":{\"a\":{\"b\":[true,null]}}}"));
+  OK(prog, p,  "{\"a\":{\"b\":[true,null]}}");
+  BAD(prog, p, "{\"a\":{\"b\":[false,null]}}");
+
+  aml_pool_destroy(p);
+}
+
+/* ---------- Runner ---------- */
+int main(void) {
+  macro_test_case tests[16];
+  size_t test_count = 0;
+
+  MACRO_ADD(tests, ajsb_validate_weather_object);
+  MACRO_ADD(tests, ajsb_validate_bounds_and_items);
+  MACRO_ADD(tests, ajsb_validate_enum_and_anyof);
+  MACRO_ADD(tests, ajsb_validate_recursive_refs);
+  MACRO_ADD(tests, ajsb_validate_wide_object);
+  MACRO_ADD(tests, ajsb_validate_discriminated_unions);
+  MACRO_ADD(tests, ajsb_validate_escapes_and_equality);
+
+  macro_run_all("a-json-schema-builder/ajsb_validate", tests, test_count);
+  return 0;
+}
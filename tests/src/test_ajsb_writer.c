@@ -0,0 +1,206 @@
+// SPDX-FileCopyrightText: 2024–2026 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai
+// SPDX-License-Identifier: Apache-2.0
+//
+// Maintainer: Andy Curtis <contactandyc@gmail.com>
+
+#include "a-json-schema-builder-library/ajsb.h"
+#include "a-json-schema-builder-library/ajsb_writer.h"
+#include "a-json-library/ajson.h"
+#include "a-memory-library/aml_buffer.h"
+#include "a-memory-library/aml_pool.h"
+#include "the-macro-library/macro_test.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+
+static const char *role_vals[] = {"admin", "staff", "user"};
+
+/* The same schema through the tree builder ... */
+static ajson_t *user_tree(aml_pool_t *p) {
+  ajson_t *user = ajsb_object(p);
+  ajsb_set_schema(p, user, "https://json-schema.org/draft/2020-12/schema");
+  ajson_t *email = ajsb_string(p);
+  ajsb_string_format(p, email, "email");
+  ajsb_prop_required(p, user, "email", email);
+  ajson_t *age = ajsb_integer(p);
+  ajsb_number_min(p, age, 0, false);
+  ajsb_number_max(p, age, 150.5, true);
+  ajsb_prop_required(p, user, "age", age);
+  ajson_t *role = ajsb_string(p);
+  ajsb_string_enum(p, role, 3, role_vals);
+  ajson_t *roles = ajsb_array(p, role);
+  ajsb_array_min_items(p, roles, 1);
+  ajsb_array_unique(p, roles, true);
+  ajsb_prop(p, user, "roles", roles);
+  ajson_t *alts[] = { ajsb_ref(p, "#/$defs/uuid"), ajsb_null(p) };
+  ajsb_prop(p, user, "id", ajsb_anyOf(p, 2, alts));
+  ajsb_additional_properties(p, user, false);
+  ajson_t *uuid = ajsb_string(p);
+  ajsb_string_pattern(p, uuid, "^[0-9a-fA-F-]{36}$");
+  ajsb_description(p, uuid, "say \"hi\"\n");
+  ajsb_defs_add(p, user, "uuid", uuid);
+  return user;
+}
+
+/* ... and through the writer. */
+static void user_writer(ajsb_writer_t *w) {
+  ajsb_writer_object(w);
+  ajsb_writer_set_schema(w, "https://json-schema.org/draft/2020-12/schema");
+  ajsb_writer_prop_required(w, "email");
+    ajsb_writer_string(w); ajsb_writer_string_format(w, "email"); ajsb_writer_end(w);
+  ajsb_writer_prop_required(w, "age");
+    ajsb_writer_integer(w);
+    ajsb_writer_number_min(w, 0, false);
+    ajsb_writer_number_max(w, 150.5, true);
+    ajsb_writer_end(w);
+  ajsb_writer_prop(w, "roles");
+    ajsb_writer_array(w);
+    ajsb_writer_items(w);
+      ajsb_writer_string(w); ajsb_writer_string_enum(w, 3, role_vals); ajsb_writer_end(w);
+    ajsb_writer_array_min_items(w, 1);
+    ajsb_writer_array_unique(w, true);
+    ajsb_writer_end(w);
+  ajsb_writer_prop(w, "id");
+    ajsb_writer_anyOf(w);
+      ajsb_writer_ref(w, "#/$defs/uuid"); ajsb_writer_end(w);
+      ajsb_writer_null(w); ajsb_writer_end(w);
+    ajsb_writer_end(w);
+  ajsb_writer_additional_properties(w, false);
+  ajsb_writer_def(w, "uuid");
+    ajsb_writer_string(w);
+    ajsb_writer_string_pattern(w, "^[0-9a-fA-F-]{36}$");
+    ajsb_writer_description(w, "say \"hi\"\n");
+    ajsb_writer_end(w);
+  ajsb_writer_end(w);
+}
+
+static size_t chunks = 0;
+static bool count_chunks(void *arg, const char *data, size_t len) {
+  chunks++;
+  aml_buffer_append((aml_buffer_t *)arg, data, len);
+  return true;
+}
+
+/* ---------- 1) matches_tree_builder ---------- */
+MACRO_TEST(ajsb_writer_matches_tree_builder) {
+  aml_pool_t *p = aml_pool_init(4096);
+  aml_buffer_t *bh = aml_buffer_init(256);
+
+  ajsb_writer_t *w = ajsb_writer_init(bh);
+  user_writer(w);
+  MACRO_ASSERT_TRUE(ajsb_writer_finish(w));
+  MACRO_ASSERT_TRUE(ajsb_writer_error(w) == NULL);
+  MACRO_ASSERT_STREQ(aml_buffer_data(bh), ajsb_stringify(p, user_tree(p)));
+
+  /* the text parses back */
+  ajson_t *back = ajson_parse_string(p, aml_pool_strdup(p, aml_buffer_data(bh)));
+  MACRO_ASSERT_TRUE(!ajson_is_error(back));
+
+  ajsb_writer_destroy(w);
+  aml_buffer_destroy(bh);
+  aml_pool_destroy(p);
+}
+
+/* ---------- 2) sinks ---------- */
+MACRO_TEST(ajsb_writer_sinks) {
+  aml_pool_t *p = aml_pool_init(1 << 16);
+  aml_buffer_t *got = aml_buffer_init(256);
+
+  ajson_t *tree = ajsb_object(p);
+  ajsb_writer_t *w = ajsb_writer_init_sink(count_chunks, got);
+  ajsb_writer_object(w);
+  for (int i = 0; i < 1000; i++) {
+    char name[24];
+    sprintf(name, "field_%d", i);
+    ajsb_prop_required(p, tree, name, ajsb_string(p));
+    ajsb_writer_prop_required(w, name);
+    ajsb_writer_string(w);
+    ajsb_writer_end(w);
+  }
+  ajsb_writer_end(w);
+  MACRO_ASSERT_TRUE(ajsb_writer_finish(w));
+  MACRO_ASSERT_TRUE(chunks > 1);
+  MACRO_ASSERT_STREQ(aml_buffer_data(got), ajsb_stringify(p, tree));
+  ajsb_writer_destroy(w);
+
+  /* file descriptor */
+  FILE *f = tmpfile();
+  w = ajsb_writer_init_fd(fileno(f));
+  user_writer(w);
+  MACRO_ASSERT_TRUE(ajsb_writer_finish(w));
+  ajsb_writer_destroy(w);
+  char text[1024] = {0};
+  rewind(f);
+  size_t n = fread(text, 1, sizeof(text) - 1, f);
+  text[n] = 0;
+  fclose(f);
+  MACRO_ASSERT_STREQ(text, ajsb_stringify(p, user_tree(p)));
+
+  aml_buffer_destroy(got);
+  aml_pool_destroy(p);
+}
+
+/* ---------- 3) nesting_errors ---------- */
+MACRO_TEST(ajsb_writer_nesting_errors) {
+  aml_buffer_t *bh = aml_buffer_init(256);
+  ajsb_writer_t *w = ajsb_writer_init(bh);
+
+  /* keyword where the property's schema belongs */
+  ajsb_writer_object(w);
+  ajsb_writer_prop(w, "a");
+  ajsb_writer_title(w, "oops");
+  MACRO_ASSERT_TRUE(ajsb_writer_error(w) != NULL);
+  MACRO_ASSERT_TRUE(!ajsb_writer_finish(w));
+
+  /* properties must be contiguous */
+  ajsb_writer_reset(w);
+  ajsb_writer_object(w);
+  ajsb_writer_prop(w, "a"); ajsb_writer_string(w); ajsb_writer_end(w);
+  ajsb_writer_title(w, "t");
+  ajsb_writer_prop(w, "b");
+  MACRO_ASSERT_TRUE(ajsb_writer_error(w) != NULL);
+
+  /* unbalanced */
+  ajsb_writer_reset(w);
+  ajsb_writer_object(w);
+  MACRO_ASSERT_TRUE(!ajsb_writer_finish(w));
+  ajsb_writer_reset(w);
+  ajsb_writer_string(w); ajsb_writer_end(w); ajsb_writer_end(w);
+  MACRO_ASSERT_TRUE(!ajsb_writer_finish(w));
+
+  /* a second root */
+  ajsb_writer_reset(w);
+  ajsb_writer_string(w); ajsb_writer_end(w);
+  ajsb_writer_string(w);
+  MACRO_ASSERT_TRUE(!ajsb_writer_finish(w));
+
+  /* too deep */
+  ajsb_writer_reset(w);
+  for (int i = 0; i <= AJSB_WRITER_MAX_DEPTH; i++) { ajsb_writer_array(w); ajsb_writer_items(w); }
+  MACRO_ASSERT_TRUE(ajsb_writer_error(w) != NULL);
+
+  /* recovers after reset */
+  ajsb_writer_reset(w);
+  aml_buffer_clear(bh);
+  ajsb_writer_boolean(w); ajsb_writer_end(w);
+  MACRO_ASSERT_TRUE(ajsb_writer_finish(w));
+  MACRO_ASSERT_STREQ(aml_buffer_data(bh), "{\"type\":\"boolean\"}");
+
+  ajsb_writer_destroy(w);
+  aml_buffer_destroy(bh);
+}
+
+/* ---------- Runner ---------- */
+int main(void) {
+  macro_test_case tests[16];
+  size_t test_count = 0;
+
+  MACRO_ADD(tests, ajsb_writer_matches_tree_builder);
+  MACRO_ADD(tests, ajsb_writer_sinks);
+  MACRO_ADD(tests, ajsb_writer_nesting_errors);
+
+  macro_run_all("a-json-schema-builder/ajsb_writer", tests, test_count);
+  return 0;
+}